@@ -0,0 +1,152 @@
+// The file system crawler on a generated local tree.
+//
+// A tree of `--values` / 4 files (16384 by default), 64 per directory below two levels of directories, is
+// created in the temporary directory, crawled with `EternalTimestampFsCrawl` on one and on all threads, and
+// removed again. The baseline is what `demo/main.cpp` shows: a serial `readdir()` + `fstatat()` walk converting `st_mtime` with
+// `EternalTimestamp::cvt_from_time_t()`, whole seconds only.
+//
+// The tree is freshly written, so its metadata sits in the kernel's caches: this measures the crawler and the
+// conversions, not the disk. Run it on a cold tree (drop the caches first) for the I/O bound picture.
+
+#include <eternal_timestamp/eternal_timestamp.h>
+#include <eternal_timestamp/eternal_timestamp_fscrawl.h>
+#include <eternal_timestamp/eternal_timestamp_parallel.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <dirent.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "bench_harness.h"
+#include "monolithic_examples.h"
+
+
+using namespace eternal_timestamp;
+
+#if !defined(_WIN32)
+
+namespace
+{
+	const size_t files_per_directory = 64;
+
+	// root/d0/d1/f: `files` files below two levels of directories.
+	bool make_tree(std::string &root, size_t files)
+	{
+		char tmpl[] = "/tmp/ets_bench_fscrawl_XXXXXX";
+		if (!mkdtemp(tmpl))
+			return false;
+		root = tmpl;
+		size_t made = 0;
+		for (size_t i = 0; made < files; i++) {
+			const std::string top = root + "/" + std::to_string(i);
+			if (mkdir(top.c_str(), 0755) != 0)
+				return false;
+			for (size_t j = 0; j < 16 && made < files; j++) {
+				const std::string dir = top + "/" + std::to_string(j);
+				if (mkdir(dir.c_str(), 0755) != 0)
+					return false;
+				for (size_t k = 0; k < files_per_directory && made < files; k++, made++) {
+					const int fd = open((dir + "/" + std::to_string(k)).c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+					if (fd < 0)
+						return false;
+					close(fd);
+				}
+			}
+		}
+		return true;
+	}
+
+	int remove_entry(const char *path, const struct stat *, int, struct FTW *)
+	{
+		return remove(path);
+	}
+
+	// The baseline: serial, second precision.
+	size_t walk_serial(const std::string &path, std::vector<eternal_timestamp_t> &mtimes)
+	{
+		DIR *dir = opendir(path.c_str());
+		if (!dir)
+			return 0;
+		size_t n = 0;
+		while (const struct dirent *de = readdir(dir)) {
+			if (!strcmp(de->d_name, ".") || !strcmp(de->d_name, ".."))
+				continue;
+			struct stat st;
+			if (fstatat(dirfd(dir), de->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0)
+				continue;
+			eternal_timestamp_t t;
+			EternalTimestamp::cvt_from_time_t(t, st.st_mtime);
+			mtimes.push_back(t);
+			n++;
+			if (S_ISDIR(st.st_mode))
+				n += walk_serial(path + "/" + de->d_name, mtimes);
+		}
+		closedir(dir);
+		return n;
+	}
+
+	int count_entries(void *context, const ets_fscrawl_entry_t *entries, size_t count)
+	{
+		bench::keep(entries[count - 1].mtime);
+		*static_cast<size_t *>(context) += count;
+		return 0;
+	}
+}
+
+#endif // !_WIN32
+
+
+#if defined(BUILD_MONOLITHIC)
+#define main(cnt, arr)      eternalty_bench_fscrawl_main(cnt, arr)
+#endif
+
+int main(int argc, const char **argv)
+{
+	bench::harness h(argc, argv, "libeternaltimestamp benchmark: the parallel file system crawler on a generated tree");
+#if defined(_WIN32)
+	fprintf(stderr, "the file system crawler is not available on this platform\n");
+	return h.finish();
+#else
+	std::string root;
+	if (!make_tree(root, h.values() / 4)) {
+		fprintf(stderr, "cannot create the tree in the temporary directory\n");
+		return EXIT_FAILURE;
+	}
+	size_t entries = 0;
+	ets_fscrawl_stats_t stats;
+	EternalTimestampFsCrawl::crawl(root.c_str(), 0, count_entries, &entries, &stats, 1);
+	h.set_context("entries", std::to_string(entries));
+	h.set_context("threads", std::to_string(EternalTimestampParallel::concurrency(ETS_PARALLELISM_ALL)));
+
+	std::vector<eternal_timestamp_t> mtimes;
+	mtimes.reserve(entries);
+	h.run("readdir + fstatat + cvt_from_time_t (serial)", "tree", entries, [&] {
+		mtimes.clear();
+		bench::keep(walk_serial(root, mtimes));
+	});
+	for (const unsigned int parallelism : { 1U, ETS_PARALLELISM_ALL }) {
+		const char *dist = (parallelism == 1 ? "1 thread" : "all threads");
+		h.run("EternalTimestampFsCrawl::crawl", dist, entries, [&] {
+			size_t n = 0;
+			EternalTimestampFsCrawl::crawl(root.c_str(), 0, count_entries, &n, nullptr, parallelism);
+			bench::keep(n);
+		});
+		h.run("EternalTimestampFsCrawl::collect", dist, entries, [&] {
+			EternalTimestampFsColumns cols;
+			EternalTimestampFsCrawl::collect(root.c_str(), 0, cols, nullptr, parallelism);
+			bench::keep(cols.size());
+		});
+	}
+
+	nftw(root.c_str(), remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+	return h.finish();
+#endif
+}
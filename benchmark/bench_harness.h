@@ -0,0 +1,222 @@
+#pragma once
+
+#ifndef __ETERNAL_TIMESTAMP_BENCH_HARNESS_H__
+#define __ETERNAL_TIMESTAMP_BENCH_HARNESS_H__
+
+// A small micro-benchmark harness, standard library only.
+//
+// Each benchmark is a body which processes a known number of items (values, pairs, strings) per call. The
+// harness first finds how many calls take `--min-time` milliseconds, then times `--rounds` such batches and
+// reports the median, fastest and slowest round in nanoseconds per item, so a single hiccup (an interrupt, a
+// frequency step) doesn't skew the result.
+//
+// Results go to stdout as an aligned table (`--format=text`, the default) or in a machine-readable format:
+// `--format=csv` (one row per benchmark) or `--format=json` (one document with the run's context, e.g. the
+// library version and compiler, and the results), ready to be diffed between library versions.
+//
+// Common options:
+//   --filter=TEXT    run only the benchmarks whose name or distribution contains TEXT
+//   --rounds=N       timed rounds per benchmark (default: 5)
+//   --min-time=MS    minimum duration of a round (default: 20)
+//   --values=N       size of the generated data sets (default: 65536)
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+
+namespace bench
+{
+	// Make the compiler believe `value` is used, so the computation producing it is not optimized away.
+	template <typename T>
+	inline void keep(const T &value)
+	{
+#if defined(__GNUC__) || defined(__clang__)
+		__asm__ __volatile__("" : : "g"(&value) : "memory");
+#else
+		static volatile const void *sink;
+		sink = &value;
+#endif
+	}
+
+	enum output_format
+	{
+		FORMAT_TEXT,
+		FORMAT_CSV,
+		FORMAT_JSON,
+	};
+
+	struct result
+	{
+		std::string name;
+		std::string distribution;
+		size_t items;                   // items per call
+		uint64_t calls;                 // calls per round
+		double median_ns;               // per item
+		double min_ns;
+		double max_ns;
+	};
+
+	class harness
+	{
+	public:
+		// `what` is a one-line description for `--help`. Exits on bad or `--help` arguments.
+		harness(int argc, const char **argv, const char *what)
+			: format_(FORMAT_TEXT), rounds_(5), min_time_ms_(20), values_(65536)
+		{
+			for (int i = 1; i < argc; i++) {
+				const char *arg = argv[i];
+				if (!strncmp(arg, "--format=", 9) && !strcmp(arg + 9, "text"))
+					format_ = FORMAT_TEXT;
+				else if (!strncmp(arg, "--format=", 9) && !strcmp(arg + 9, "csv"))
+					format_ = FORMAT_CSV;
+				else if (!strncmp(arg, "--format=", 9) && !strcmp(arg + 9, "json"))
+					format_ = FORMAT_JSON;
+				else if (!strncmp(arg, "--filter=", 9))
+					filter_ = arg + 9;
+				else if (!strncmp(arg, "--rounds=", 9) && atoi(arg + 9) > 0)
+					rounds_ = atoi(arg + 9);
+				else if (!strncmp(arg, "--min-time=", 11) && atof(arg + 11) > 0)
+					min_time_ms_ = atof(arg + 11);
+				else if (!strncmp(arg, "--values=", 9) && strtoull(arg + 9, nullptr, 10) > 0)
+					values_ = static_cast<size_t>(strtoull(arg + 9, nullptr, 10));
+				else {
+					fprintf(stderr, "%s\n\nusage: %s [--format=text|csv|json] [--filter=TEXT] [--rounds=N] [--min-time=MS] [--values=N]\n", what, argv[0]);
+					exit(strcmp(arg, "--help") ? EXIT_FAILURE : EXIT_SUCCESS);
+				}
+			}
+		}
+
+		size_t values() const
+		{
+			return values_;
+		}
+
+		// The results so far, e.g. for a derived summary such as a throughput.
+		const std::vector<result> &results() const
+		{
+			return results_;
+		}
+
+		// Context reported along with the results in JSON output, e.g. the library version.
+		void set_context(const char *key, const std::string &value)
+		{
+			context_.push_back(std::make_pair(std::string(key), value));
+		}
+
+		// Time `body()`, which processes `items` items per call.
+		template <typename F>
+		void run(const char *name, const char *distribution, size_t items, F &&body)
+		{
+			if (!filter_.empty() && !strstr(name, filter_.c_str()) && !strstr(distribution, filter_.c_str()))
+				return;
+			if (!header_done_)
+				header();
+
+			typedef std::chrono::steady_clock clock;
+			const double min_ns = min_time_ms_ * 1e6;
+
+			// calibrate, which doubles as the warm-up
+			uint64_t calls = 1;
+			for (;;) {
+				const auto start = clock::now();
+				for (uint64_t c = 0; c < calls; c++)
+					body();
+				const double ns = std::chrono::duration<double, std::nano>(clock::now() - start).count();
+				if (ns >= min_ns || calls >= (1ULL << 40))
+					break;
+				calls = (ns * 8 < min_ns ? calls * 8 : static_cast<uint64_t>(static_cast<double>(calls) * min_ns * 1.2 / ns) + 1);
+			}
+
+			std::vector<double> per_item(rounds_);
+			for (int r = 0; r < rounds_; r++) {
+				const auto start = clock::now();
+				for (uint64_t c = 0; c < calls; c++)
+					body();
+				const double ns = std::chrono::duration<double, std::nano>(clock::now() - start).count();
+				per_item[r] = ns / static_cast<double>(calls) / static_cast<double>(items ? items : 1);
+			}
+			std::sort(per_item.begin(), per_item.end());
+
+			result res;
+			res.name = name;
+			res.distribution = distribution;
+			res.items = items;
+			res.calls = calls;
+			res.median_ns = per_item[per_item.size() / 2];
+			res.min_ns = per_item.front();
+			res.max_ns = per_item.back();
+			results_.push_back(res);
+			row(res);
+		}
+
+		// Finish the output. Returns the process exit code.
+		int finish()
+		{
+			if (!header_done_)
+				header();
+			if (format_ == FORMAT_JSON) {
+				printf("{\n  \"context\": {");
+				for (size_t i = 0; i < context_.size(); i++)
+					printf("%s\n    \"%s\": \"%s\"", (i ? "," : ""), escape(context_[i].first).c_str(), escape(context_[i].second).c_str());
+				printf("\n  },\n  \"results\": [");
+				for (size_t i = 0; i < results_.size(); i++) {
+					const result &r = results_[i];
+					printf("%s\n    { \"name\": \"%s\", \"distribution\": \"%s\", \"items\": %zu, \"calls\": %llu, \"median_ns\": %.4f, \"min_ns\": %.4f, \"max_ns\": %.4f }",
+						(i ? "," : ""), escape(r.name).c_str(), escape(r.distribution).c_str(), r.items, static_cast<unsigned long long>(r.calls), r.median_ns, r.min_ns, r.max_ns);
+				}
+				printf("\n  ]\n}\n");
+			}
+			fflush(stdout);
+			return EXIT_SUCCESS;
+		}
+
+	private:
+		void header()
+		{
+			header_done_ = true;
+			if (format_ == FORMAT_TEXT) {
+				printf("%-56s %-12s %12s %12s %12s\n", "benchmark", "data", "median ns", "min ns", "max ns");
+			} else if (format_ == FORMAT_CSV) {
+				printf("name,distribution,items,calls,median_ns,min_ns,max_ns\n");
+			}
+		}
+
+		void row(const result &r)
+		{
+			if (format_ == FORMAT_TEXT) {
+				printf("%-56s %-12s %12.2f %12.2f %12.2f\n", r.name.c_str(), r.distribution.c_str(), r.median_ns, r.min_ns, r.max_ns);
+			} else if (format_ == FORMAT_CSV) {
+				printf("\"%s\",%s,%zu,%llu,%.4f,%.4f,%.4f\n", r.name.c_str(), r.distribution.c_str(), r.items, static_cast<unsigned long long>(r.calls), r.median_ns, r.min_ns, r.max_ns);
+			}
+			fflush(stdout);
+		}
+
+		static std::string escape(const std::string &s)
+		{
+			std::string out;
+			for (const char c : s) {
+				if (c == '"' || c == '\\')
+					out += '\\';
+				if (static_cast<unsigned char>(c) >= 0x20)
+					out += c;
+			}
+			return out;
+		}
+
+		output_format format_;
+		int rounds_;
+		double min_time_ms_;
+		size_t values_;
+		std::string filter_;
+		bool header_done_ = false;
+		std::vector<std::pair<std::string, std::string> > context_;
+		std::vector<result> results_;
+	};
+}
+
+#endif // __ETERNAL_TIMESTAMP_BENCH_HARNESS_H__
@@ -0,0 +1,139 @@
+
+// Hash set benchmark: deduplicating and probing timestamp columns with EternalTimestampHashSet vs. std::unordered_set.
+//
+// usage: bench_hash [distinct-keys [events-per-key]]
+
+#include <eternal_timestamp/eternal_timestamp.h>
+#include <eternal_timestamp/eternal_timestamp_batch.h>
+#include <eternal_timestamp/eternal_timestamp_hash.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <unordered_set>
+#include <vector>
+
+#include "eternal_timestamp_internal.h"
+#include "monolithic_examples.h"
+
+
+using namespace eternal_timestamp;
+
+// The best of a few runs, in nanoseconds per key.
+template <typename F>
+static double measure(size_t count, F &&run)
+{
+	double best = 1e30;
+	for (int round = 0; round < 3; round++) {
+		const auto start = std::chrono::steady_clock::now();
+		run();
+		const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+		if (elapsed.count() < best)
+			best = elapsed.count();
+	}
+	return best / static_cast<double>(count);
+}
+
+static size_t sink = 0;
+
+
+#if defined(BUILD_MONOLITHIC)
+#define main(cnt, arr)      eternalty_bench_hash_main(cnt, arr)
+#endif
+
+int main(int argc, const char **argv)
+{
+	const size_t distinct = (argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000);
+	const size_t per_key = (argc > 2 ? strtoull(argv[2], nullptr, 10) : 4);
+	const size_t count = distinct * per_key;
+
+	// An event stream: one record per second on average, with bursts, slightly out of order and with
+	// the sub-second fields left unspecified, the way most log sources deliver them.
+	std::mt19937_64 rng(42);
+	std::vector<int64_t> seconds(count);
+	for (size_t i = 0; i < count; i++)
+		seconds[i] = 1641000000 + static_cast<int64_t>(i / per_key) + static_cast<int64_t>(rng() % 3) - 1;
+	std::vector<eternal_timestamp_t> events(count);
+	EternalTimestampBatch::cvt_from_unix_seconds(events.data(), nullptr, seconds.data(), count);
+	for (auto &t : events) {
+		t = ets_modern_set_milliseconds(t, get_Invalid(ETMT_FIELDSIZE_MILLISECONDS));
+		t = ets_modern_set_microseconds(t, get_Invalid(ETMT_FIELDSIZE_MICROSECONDS));
+	}
+
+	// probes: half of them hit
+	std::vector<eternal_timestamp_t> probes(count);
+	for (size_t i = 0; i < count; i++) {
+		probes[i] = events[rng() % count];
+		if (i & 1)
+			probes[i] = ets_modern_set_day(probes[i], ets_modern_day(probes[i]) ^ 1);
+	}
+
+	printf("%zu events, %zu distinct timestamps; nanoseconds per event:\n\n", count, distinct);
+	printf("%-52s %10s %10s\n", "", "dedup", "probe");
+
+	{
+		double insert = measure(count, [&] {
+			std::unordered_set<uint64_t> set;
+			for (const auto &t : events)
+				set.insert(t.t);
+			sink += set.size();
+		});
+		std::unordered_set<uint64_t> set;
+		for (const auto &t : events)
+			set.insert(t.t);
+		double probe = measure(count, [&] {
+			for (const auto &t : probes)
+				sink += set.count(t.t);
+		});
+		printf("%-52s %10.1f %10.1f\n", "std::unordered_set<uint64_t>", insert, probe);
+	}
+
+	{
+		typedef std::unordered_set<eternal_timestamp_t, EternalTimestampHasher, EternalTimestampKeyEqual> set_type;
+		double insert = measure(count, [&] {
+			set_type set;
+			for (const auto &t : events)
+				set.insert(t);
+			sink += set.size();
+		});
+		set_type set(events.begin(), events.end());
+		double probe = measure(count, [&] {
+			for (const auto &t : probes)
+				sink += set.count(t);
+		});
+		printf("%-52s %10.1f %10.1f\n", "std::unordered_set<..., EternalTimestampHasher>", insert, probe);
+	}
+
+	{
+		double insert = measure(count, [&] {
+			EternalTimestampHashSet set;
+			for (const auto &t : events)
+				set.insert(t);
+			sink += set.size();
+		});
+		EternalTimestampHashSet set;
+		set.insert_batch(events.data(), count, nullptr);
+		double probe = measure(count, [&] {
+			for (const auto &t : probes)
+				sink += set.contains(t);
+		});
+		printf("%-52s %10.1f %10.1f\n", "EternalTimestampHashSet, one by one", insert, probe);
+	}
+
+	{
+		std::vector<uint8_t> bitmap((count + 7) / 8);
+		double insert = measure(count, [&] {
+			EternalTimestampHashSet set;
+			set.insert_batch(events.data(), count, bitmap.data());
+			sink += set.size();
+		});
+		EternalTimestampHashSet set;
+		set.insert_batch(events.data(), count, nullptr);
+		double probe = measure(count, [&] {
+			sink += set.contains_batch(bitmap.data(), probes.data(), count);
+		});
+		printf("%-52s %10.1f %10.1f\n", "EternalTimestampHashSet, batch (prefetching)", insert, probe);
+	}
+
+	return (sink ? EXIT_SUCCESS : EXIT_FAILURE);
+}
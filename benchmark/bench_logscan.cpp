@@ -0,0 +1,185 @@
+// The log line scanner on a local corpus, in GB/s.
+//
+// For each of the six log formats a corpus of `--values` lines (65536 by default, some 6 MB) is generated in
+// memory: advancing timestamps, with one in sixteen lines a stack trace line without a timestamp. Set the
+// `ETS_BENCH_LOGSCAN_CORPUS` environment variable to the path of a log file to scan that as well.
+//
+// Every body processes the whole corpus, counted in bytes: the reported figures are nanoseconds per byte, which
+// is the reciprocal of the throughput in GB/s; a GB/s summary follows on stderr. The baseline only splits the
+// buffer into lines with `memchr()`, i.e. the ceiling for any line-based scanner.
+
+#include <eternal_timestamp/eternal_timestamp.h>
+#include <eternal_timestamp/eternal_timestamp_logscan.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "bench_harness.h"
+#include "monolithic_examples.h"
+
+
+using namespace eternal_timestamp;
+
+namespace
+{
+	const size_t lines_per_call = 4096;
+
+	const char *const months[12] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+	const char *const weekdays[7] = { "Thu", "Fri", "Sat", "Sun", "Mon", "Tue", "Wed" };
+
+	struct corpus
+	{
+		const char *name;
+		ets_log_format_t format;
+		std::string text;
+	};
+
+	// `lines` lines in `format`, one second and a bit apart, starting 2022-01-13.
+	std::string make_corpus(ets_log_format_t format, size_t lines)
+	{
+		std::string text;
+		text.reserve(lines * 100);
+		char line[256];
+		for (size_t i = 0; i < lines; i++) {
+			if (i % 16 == 15) {
+				text += "\tat org.example.Service.handle(Service.java:123)\n";
+				continue;
+			}
+			const long long t = 1642077631LL + static_cast<long long>(i) * 13 / 10;
+			const long long days = t / 86400 + 719468;
+			const long long era = days / 146097;
+			const long long doe = days - era * 146097;
+			const long long yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+			const long long doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+			const long long mp = (5 * doy + 2) / 153;
+			const int d = static_cast<int>(doy - (153 * mp + 2) / 5 + 1);
+			const int m = static_cast<int>(mp < 10 ? mp + 3 : mp - 9);
+			const int y = static_cast<int>(yoe + era * 400 + (m <= 2));
+			const int hh = static_cast<int>(t % 86400 / 3600), mm = static_cast<int>(t % 3600 / 60), ss = static_cast<int>(t % 60);
+			const int us = static_cast<int>(i * 7919 % 1000000);
+			switch (format) {
+			case ETS_LOG_FORMAT_RFC3339:
+				snprintf(line, sizeof(line), "%04d-%02d-%02dT%02d:%02d:%02d.%06dZ INFO  [worker-%zu] request handled in %zu ms\n", y, m, d, hh, mm, ss, us, i % 8, i % 97);
+				break;
+			case ETS_LOG_FORMAT_SYSLOG_RFC5424:
+				snprintf(line, sizeof(line), "<34>1 %04d-%02d-%02dT%02d:%02d:%02d.%03dZ mymachine.example.com su - ID47 - 'su root' failed on /dev/pts/%zu\n", y, m, d, hh, mm, ss, us / 1000, i % 8);
+				break;
+			case ETS_LOG_FORMAT_SYSLOG_RFC3164:
+				snprintf(line, sizeof(line), "<13>%s %2d %02d:%02d:%02d mymachine sshd[%zu]: Accepted publickey for user from 10.0.0.%zu\n", months[m - 1], d, hh, mm, ss, 1000 + i % 5000, i % 256);
+				break;
+			case ETS_LOG_FORMAT_COMMON_LOG:
+				snprintf(line, sizeof(line), "10.0.0.%zu - - [%02d/%s/%04d:%02d:%02d:%02d +0000] \"GET /index.html HTTP/1.1\" 200 %zu\n", i % 256, d, months[m - 1], y, hh, mm, ss, 512 + i % 4096);
+				break;
+			case ETS_LOG_FORMAT_NGINX_ERROR:
+				snprintf(line, sizeof(line), "%04d/%02d/%02d %02d:%02d:%02d [error] %zu#0: *%zu open() \"/var/www/favicon.ico\" failed (2: No such file)\n", y, m, d, hh, mm, ss, 1000 + i % 8, i);
+				break;
+			case ETS_LOG_FORMAT_APACHE_ERROR:
+				snprintf(line, sizeof(line), "[%s %s %02d %02d:%02d:%02d.%06d %04d] [core:error] [pid %zu] AH00124: Request exceeded the limit\n", weekdays[(t / 86400) % 7], months[m - 1], d, hh, mm, ss, us, y, 1000 + i % 5000);
+				break;
+			default:
+				line[0] = 0;
+				break;
+			}
+			text += line;
+		}
+		return text;
+	}
+
+	bool read_file(const char *path, std::string &text)
+	{
+		FILE *f = fopen(path, "rb");
+		if (!f)
+			return false;
+		char buf[65536];
+		size_t n;
+		while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+			text.append(buf, n);
+		fclose(f);
+		return true;
+	}
+
+	size_t count_lines(const std::string &text)
+	{
+		size_t n = 0;
+		const char *p = text.data();
+		const char *const end = p + text.size();
+		while (p < end) {
+			const char *eol = static_cast<const char *>(memchr(p, '\n', end - p));
+			n++;
+			p = (eol ? eol + 1 : end);
+		}
+		return n;
+	}
+
+	// scan the whole corpus, `lines_per_call` lines at a time, as a log shipper would.
+	size_t scan_all(const corpus &c, eternal_timestamp_t *timestamps, size_t *offsets)
+	{
+		ets_logscan_state_t state;
+		EternalTimestampLogScan::init(state, c.format, 2022);
+		const char *p = c.text.data();
+		size_t left = c.text.size();
+		size_t n = 0;
+		while (left) {
+			size_t consumed = 0;
+			n += EternalTimestampLogScan::scan(timestamps, offsets, lines_per_call, state, p, left, true, consumed);
+			p += consumed;
+			left -= consumed;
+		}
+		bench::keep(timestamps[0]);
+		return n;
+	}
+}
+
+
+#if defined(BUILD_MONOLITHIC)
+#define main(cnt, arr)      eternalty_bench_logscan_main(cnt, arr)
+#endif
+
+int main(int argc, const char **argv)
+{
+	bench::harness h(argc, argv, "libeternaltimestamp benchmark: the log line scanner on a local corpus (ns per byte; GB/s on stderr)");
+
+	std::vector<corpus> corpora = {
+		{ "rfc3339", ETS_LOG_FORMAT_RFC3339, std::string() },
+		{ "rfc5424", ETS_LOG_FORMAT_SYSLOG_RFC5424, std::string() },
+		{ "rfc3164", ETS_LOG_FORMAT_SYSLOG_RFC3164, std::string() },
+		{ "clf", ETS_LOG_FORMAT_COMMON_LOG, std::string() },
+		{ "nginx", ETS_LOG_FORMAT_NGINX_ERROR, std::string() },
+		{ "apache", ETS_LOG_FORMAT_APACHE_ERROR, std::string() },
+	};
+	for (corpus &c : corpora) {
+		c.text = make_corpus(c.format, h.values());
+	}
+	const char *path = getenv("ETS_BENCH_LOGSCAN_CORPUS");
+	if (path && *path) {
+		corpus c = { "file", ETS_LOG_FORMAT_UNKNOWN, std::string() };
+		if (!read_file(path, c.text)) {
+			fprintf(stderr, "cannot read %s\n", path);
+			return EXIT_FAILURE;
+		}
+		h.set_context("corpus", path);
+		corpora.push_back(c);
+	}
+
+	std::vector<eternal_timestamp_t> timestamps(lines_per_call);
+	std::vector<size_t> offsets(lines_per_call);
+	for (const corpus &c : corpora) {
+		h.run("memchr line split (baseline)", c.name, c.text.size(), [&] {
+			bench::keep(count_lines(c.text));
+		});
+		h.run("EternalTimestampLogScan::scan", c.name, c.text.size(), [&] {
+			bench::keep(scan_all(c, timestamps.data(), offsets.data()));
+		});
+		h.run("EternalTimestampLogScan::scan, no line offsets", c.name, c.text.size(), [&] {
+			bench::keep(scan_all(c, timestamps.data(), nullptr));
+		});
+	}
+
+	// one byte per nanosecond is one GB/s.
+	for (const bench::result &r : h.results()) {
+		fprintf(stderr, "%-48s %-8s %8.3f GB/s\n", r.name.c_str(), r.distribution.c_str(), r.median_ns > 0 ? 1.0 / r.median_ns : 0.0);
+	}
+	return h.finish();
+}
@@ -0,0 +1,143 @@
+// Parallel scaling benchmark: the batch kernels on 1, 2, 4, ... threads.
+//
+// The cheap conversions are memory bound: expect them to level off once the threads saturate the memory
+// bandwidth (see the GB/s column, input plus output), while the text kernels keep scaling with the cores.
+//
+// usage: bench_parallel [values [max-threads]]
+
+#include <eternal_timestamp/eternal_timestamp.h>
+#include <eternal_timestamp/eternal_timestamp_batch.h>
+#include <eternal_timestamp/eternal_timestamp_format.h>
+#include <eternal_timestamp/eternal_timestamp_hash.h>
+#include <eternal_timestamp/eternal_timestamp_parallel.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "monolithic_examples.h"
+
+
+using namespace eternal_timestamp;
+
+// The best of a few runs, in nanoseconds per value.
+template <typename F>
+static double measure(size_t count, F &&run)
+{
+	double best = 1e30;
+	for (int round = 0; round < 3; round++) {
+		const auto start = std::chrono::steady_clock::now();
+		run();
+		const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+		if (elapsed.count() < best)
+			best = elapsed.count();
+	}
+	return best / static_cast<double>(count);
+}
+
+static size_t sink = 0;
+
+struct kernel
+{
+	const char *name;
+	size_t bytes_per_value;               // memory traffic: input plus output
+	std::function<void(unsigned int parallelism)> run;
+	double serial;                        // ns per value on one thread
+};
+
+
+#if defined(BUILD_MONOLITHIC)
+#define main(cnt, arr)      eternalty_bench_parallel_main(cnt, arr)
+#endif
+
+int main(int argc, const char **argv)
+{
+	const size_t count = (argc > 1 ? strtoull(argv[1], nullptr, 10) : 16000000);
+	const unsigned int hw = std::thread::hardware_concurrency();
+	const unsigned int max_threads = (argc > 2 ? static_cast<unsigned int>(strtoul(argv[2], nullptr, 10)) : (hw ? hw : 1));
+
+	// log-like input: ascending, one record per few milliseconds on average
+	std::mt19937_64 rng(42);
+	std::vector<int64_t> usecs(count);
+	int64_t t = 1641000000LL * 1000000;
+	for (size_t i = 0; i < count; i++) {
+		t += static_cast<int64_t>(rng() % 5000);
+		usecs[i] = t;
+	}
+	std::vector<eternal_timestamp_t> values(count);
+	EternalTimestampBatch::cvt_from_unix_usecs(values.data(), nullptr, usecs.data(), count, 1);
+
+	std::vector<int64_t> out64(count);
+	std::vector<uint8_t> validity((count + 7) / 8);
+	std::vector<eternal_timestamp_t> parsed(count);
+	std::vector<char> text(count * ETS_BATCH_RFC3339_MAX_LENGTH);
+	std::vector<int32_t> offsets(count + 1);
+	std::vector<char> formatted;
+	std::vector<int32_t> format_offsets(count + 1);
+	ets_format_pattern_t pattern;
+	EternalTimestampFormat::compile(pattern, "%d/%m/%Y %H:%M:%S.%f", nullptr);
+	formatted.resize(count * pattern.max_length);
+
+	offsets[0] = 0;
+	EternalTimestampBatch::cvt_to_rfc3339_column(text.data(), text.size(), offsets.data(), nullptr, values.data(), 0, count, 1);
+	EternalTimestampHashSet set;
+	set.insert_batch(values.data(), count / 2, nullptr);
+
+	kernel kernels[] = {
+		{ "EternalTimestampBatch::cvt_from_unix_usecs", 16, [&](unsigned int p) {
+			EternalTimestampBatch::cvt_from_unix_usecs(parsed.data(), nullptr, usecs.data(), count, p);
+		}, 0 },
+		{ "EternalTimestampBatch::cvt_to_unix_usecs", 16, [&](unsigned int p) {
+			sink += EternalTimestampBatch::cvt_to_unix_usecs(out64.data(), validity.data(), values.data(), count, p);
+		}, 0 },
+		{ "EternalTimestampBatch::calc_sort_keys", 16, [&](unsigned int p) {
+			EternalTimestampBatch::calc_sort_keys(out64.data(), values.data(), count, p);
+		}, 0 },
+		{ "EternalTimestampBatch::cvt_to_rfc3339_column", 8 + 30, [&](unsigned int p) {
+			sink += EternalTimestampBatch::cvt_to_rfc3339_column(text.data(), text.size(), offsets.data(), nullptr, values.data(), 0, count, p);
+		}, 0 },
+		{ "EternalTimestampBatch::cvt_from_iso8601_column", 30 + 8, [&](unsigned int p) {
+			sink += EternalTimestampBatch::cvt_from_iso8601_column(parsed.data(), nullptr, text.data(), offsets.data(), count, p);
+		}, 0 },
+		{ "EternalTimestampFormat::format_column", 8 + 30, [&](unsigned int p) {
+			format_offsets[0] = 0;
+			sink += EternalTimestampFormat::format_column(formatted.data(), formatted.size(), format_offsets.data(), pattern, values.data(), count, p);
+		}, 0 },
+		{ "EternalTimestampHashSet::contains_batch", 8, [&](unsigned int p) {
+			sink += set.contains_batch(validity.data(), values.data(), count, p);
+		}, 0 },
+	};
+
+	printf("%zu values, %u hardware thread(s); nanoseconds per value (speedup, GB/s):\n\n", count, hw);
+	printf("%-48s", "");
+	for (unsigned int threads = 1; threads <= max_threads; threads *= 2)
+		printf(" %24u", threads);
+	printf("\n");
+
+	for (auto &k : kernels) {
+		printf("%-48s", k.name);
+		for (unsigned int threads = 1; threads <= max_threads; threads *= 2) {
+			// a pool of exactly this size, so that every column of the table has its thread count
+			ets_thread_pool_t *pool = (threads > 1 ? EternalTimestampThreadPool::create(threads - 1) : nullptr);
+			if (pool) {
+				const ets_executor_t executor = EternalTimestampThreadPool::executor(pool);
+				EternalTimestampParallel::set_executor(&executor);
+			}
+			const double ns = measure(count, [&] { k.run(threads); });
+			if (threads == 1)
+				k.serial = ns;
+			printf(" %8.2f (%5.2fx, %5.1f)", ns, k.serial / ns, k.bytes_per_value / ns);
+			fflush(stdout);
+			if (pool) {
+				EternalTimestampParallel::set_executor(nullptr);
+				EternalTimestampThreadPool::destroy(pool);
+			}
+		}
+		printf("\n");
+	}
+
+	return (sink ? EXIT_SUCCESS : EXIT_FAILURE);
+}
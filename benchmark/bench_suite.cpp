@@ -0,0 +1,399 @@
+// The benchmark suite: every public entry point of the core API and the batch APIs, on generated data.
+//
+// Each entry point runs on three data sets, which bracket the mixes seen in production:
+//
+// - `modern`: complete timestamps of the last and next century at microsecond precision, a tenth of them
+//   (log records) at second or millisecond precision;
+// - `mixed`: mostly modern timestamps, with historic ones from 3000 BC on and a fifth prehistoric ones, as
+//   found in archive and natural history collections;
+// - `partial`: mostly partial timestamps, from a lone century or year down to the minute, as found in
+//   bibliographic and genealogical data.
+//
+// Run it against two builds of the library with `--format=json` (or `--format=csv`) and compare the
+// `median_ns` per benchmark. Build with `-DCMAKE_BUILD_TYPE=Release`: the JSON context records whether the
+// library's assertions were compiled in. See bench_harness.h for the options.
+
+#include <eternal_timestamp/eternal_timestamp.h>
+#include <eternal_timestamp/eternal_timestamp_batch.h>
+#include <eternal_timestamp/eternal_timestamp_compact.h>
+#include <eternal_timestamp/eternal_timestamp_endian.h>
+#include <eternal_timestamp/eternal_timestamp_format.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bench_harness.h"
+#include "monolithic_examples.h"
+
+
+using namespace eternal_timestamp;
+
+namespace
+{
+	// A data set, and every input form the entry points take, derived from it.
+	struct dataset
+	{
+		const char *name;
+
+		std::vector<std::string> texts;          // ISO 8601
+		std::vector<const char *> strings;
+		std::vector<size_t> lengths;
+		std::vector<char> column;                // the texts as an Arrow-style string column
+		std::vector<int32_t> offsets;
+
+		std::vector<eternal_timestamp_t> values;
+		std::vector<eternal_time_tm> timeinfos;
+		std::vector<struct tm> tms;
+		std::vector<time_t> time_ts;
+		std::vector<double> reals;
+		std::vector<int64_t> usecs;
+		std::vector<int64_t> msecs;
+		std::vector<int64_t> seconds;
+		std::vector<int32_t> days;
+	};
+
+	// "YYYY-MM-DDThh:mm:ss.ffffff" cut after `parts` components (1: the year only, 8: down to the microseconds).
+	std::string modern_text(std::mt19937_64 &rng, int first_year, int last_year, int parts)
+	{
+		const int year = first_year + static_cast<int>(rng() % static_cast<uint64_t>(last_year - first_year + 1));
+		char buf[64];
+		int n = snprintf(buf, sizeof(buf), (year < 0 ? "-%04d" : "%04d"), (year < 0 ? -year : year));
+		if (parts >= 2)
+			n += snprintf(buf + n, sizeof(buf) - n, "-%02d", 1 + static_cast<int>(rng() % 12));
+		if (parts >= 3)
+			n += snprintf(buf + n, sizeof(buf) - n, "-%02d", 1 + static_cast<int>(rng() % 28));
+		if (parts >= 4)
+			n += snprintf(buf + n, sizeof(buf) - n, "T%02d", static_cast<int>(rng() % 24));
+		if (parts >= 5)
+			n += snprintf(buf + n, sizeof(buf) - n, ":%02d", static_cast<int>(rng() % 60));
+		if (parts >= 6)
+			n += snprintf(buf + n, sizeof(buf) - n, ":%02d", static_cast<int>(rng() % 60));
+		if (parts == 7)
+			n += snprintf(buf + n, sizeof(buf) - n, ".%03d", static_cast<int>(rng() % 1000));
+		if (parts >= 8)
+			n += snprintf(buf + n, sizeof(buf) - n, ".%06d", static_cast<int>(rng() % 1000000));
+		return std::string(buf, n);
+	}
+
+	// Years before 9900 BC, up to the minute (`parts` as above, at most 5).
+	std::string prehistoric_text(std::mt19937_64 &rng, int parts)
+	{
+		const long long year = 10000 + static_cast<long long>(rng() % 100000000);
+		char buf[64];
+		int n = snprintf(buf, sizeof(buf), "-%lld", year);
+		if (parts >= 2)
+			n += snprintf(buf + n, sizeof(buf) - n, "-%02d", 1 + static_cast<int>(rng() % 12));
+		if (parts >= 3)
+			n += snprintf(buf + n, sizeof(buf) - n, "-%02d", 1 + static_cast<int>(rng() % 28));
+		if (parts >= 4)
+			n += snprintf(buf + n, sizeof(buf) - n, "T%02d", static_cast<int>(rng() % 24));
+		if (parts >= 5)
+			n += snprintf(buf + n, sizeof(buf) - n, ":%02d", static_cast<int>(rng() % 60));
+		return std::string(buf, n);
+	}
+
+	void make_dataset(dataset &d, const char *name, size_t count, uint64_t seed)
+	{
+		std::mt19937_64 rng(seed);
+		d.name = name;
+		d.texts.resize(count);
+		for (size_t i = 0; i < count; i++) {
+			const unsigned int pick = static_cast<unsigned int>(rng() % 100);
+			if (!strcmp(name, "modern"))
+				d.texts[i] = modern_text(rng, 1900, 2100, (pick < 90 ? 8 : pick < 95 ? 7 : 6));
+			else if (!strcmp(name, "mixed"))
+				d.texts[i] = (pick < 60 ? modern_text(rng, 1900, 2100, 8) : pick < 80 ? modern_text(rng, -3000, 1899, 1 + static_cast<int>(rng() % 6)) : prehistoric_text(rng, 1 + static_cast<int>(rng() % 5)));
+			else
+				d.texts[i] = (pick < 80 ? modern_text(rng, 1, 2100, 1 + static_cast<int>(rng() % 5)) : modern_text(rng, 1, 2100, 8));
+		}
+
+		d.strings.resize(count);
+		d.lengths.resize(count);
+		d.offsets.resize(count + 1);
+		d.offsets[0] = 0;
+		for (size_t i = 0; i < count; i++) {
+			d.column.insert(d.column.end(), d.texts[i].begin(), d.texts[i].end());
+			d.offsets[i + 1] = static_cast<int32_t>(d.column.size());
+		}
+		for (size_t i = 0; i < count; i++) {
+			d.strings[i] = d.texts[i].c_str();
+			d.lengths[i] = d.texts[i].size();
+		}
+
+		d.values.resize(count);
+		EternalTimestampBatch::cvt_from_iso8601(d.values.data(), nullptr, d.strings.data(), d.lengths.data(), count, 1);
+
+		d.timeinfos.resize(count);
+		d.tms.resize(count);
+		d.reals.resize(count);
+		for (size_t i = 0; i < count; i++) {
+			eternal_time_tm &ti = d.timeinfos[i];
+			memset(&ti, 0, sizeof(ti));
+			EternalTimestamp::cvt_to_timeinfo_struct(ti, d.values[i]);
+			struct tm &tm = d.tms[i];
+			memset(&tm, 0, sizeof(tm));
+			tm.tm_year = ti.year - 1900;
+			tm.tm_mon = static_cast<int>(ti.month) - 1;
+			tm.tm_mday = static_cast<int>(ti.day);
+			tm.tm_hour = static_cast<int>(ti.hour);
+			tm.tm_min = static_cast<int>(ti.minute);
+			tm.tm_sec = static_cast<int>(ti.seconds);
+			EternalTimestamp::cvt_to_etdb_real(d.reals[i], d.values[i]);
+		}
+
+		// the epoch based forms of the values which have them; zero(0) for the others
+		d.usecs.resize(count);
+		d.msecs.resize(count);
+		d.seconds.resize(count);
+		d.days.resize(count);
+		d.time_ts.resize(count);
+		EternalTimestampBatch::cvt_to_unix_usecs(d.usecs.data(), nullptr, d.values.data(), count, 1);
+		for (size_t i = 0; i < count; i++) {
+			d.msecs[i] = d.usecs[i] / 1000;
+			d.seconds[i] = d.usecs[i] / 1000000;
+			d.days[i] = static_cast<int32_t>(d.seconds[i] / 86400);
+			d.time_ts[i] = static_cast<time_t>(d.seconds[i]);
+		}
+	}
+
+	// Run `op(i)` over all values of the set.
+	template <typename F>
+	void each(bench::harness &h, const char *name, const dataset &d, F &&op)
+	{
+		const size_t count = d.values.size();
+		h.run(name, d.name, count, [&] {
+			for (size_t i = 0; i < count; i++)
+				op(i);
+		});
+	}
+
+	void single_value_benchmarks(bench::harness &h, const dataset &d)
+	{
+		const eternal_timestamp_t *const v = d.values.data();
+		const size_t count = d.values.size();
+
+		each(h, "EternalTimestamp::is_valid", d, [&](size_t i) { bench::keep(EternalTimestamp::is_valid(v[i])); });
+		each(h, "EternalTimestamp::validate", d, [&](size_t i) { bench::keep(EternalTimestamp::validate(v[i])); });
+		each(h, "EternalTimestamp::is_partial_timestamp", d, [&](size_t i) { bench::keep(EternalTimestamp::is_partial_timestamp(v[i])); });
+		each(h, "EternalTimestamp::normalize", d, [&](size_t i) { bench::keep(EternalTimestamp::normalize(v[i], v[count - 1 - i])); });
+
+#define ETS_BENCH_PREDICATE(name) \
+		each(h, "EternalTimestamp::" #name, d, [&](size_t i) { bench::keep(EternalTimestamp::name(v[i])); });
+		ETS_BENCH_PREDICATE(has_century)
+		ETS_BENCH_PREDICATE(has_year)
+		ETS_BENCH_PREDICATE(has_century_and_year)
+		ETS_BENCH_PREDICATE(has_age)
+		ETS_BENCH_PREDICATE(has_month)
+		ETS_BENCH_PREDICATE(has_day)
+		ETS_BENCH_PREDICATE(has_hour)
+		ETS_BENCH_PREDICATE(has_minute)
+		ETS_BENCH_PREDICATE(has_seconds)
+		ETS_BENCH_PREDICATE(has_milliseconds)
+		ETS_BENCH_PREDICATE(has_microseconds)
+		ETS_BENCH_PREDICATE(has_complete_date)
+		ETS_BENCH_PREDICATE(has_time)
+		ETS_BENCH_PREDICATE(has_hh_mm_ss)
+		ETS_BENCH_PREDICATE(is_modern_format)
+		ETS_BENCH_PREDICATE(is_prehistoric_format)
+#undef ETS_BENCH_PREDICATE
+
+		// the C predicates are calls into the library unless built header-only
+		each(h, "ets_has_complete_date", d, [&](size_t i) { bench::keep(ets_has_complete_date(v[i])); });
+
+		each(h, "EternalTimestamp::calc_sort_key", d, [&](size_t i) { bench::keep(EternalTimestamp::calc_sort_key(v[i])); });
+		each(h, "EternalTimestamp::calc_time_fast_delta", d, [&](size_t i) { bench::keep(EternalTimestamp::calc_time_fast_delta(v[i], v[count - 1 - i])); });
+		each(h, "EternalTimestamp::calc_time_approx_delta", d, [&](size_t i) { bench::keep(EternalTimestamp::calc_time_approx_delta(v[i], v[count - 1 - i])); });
+
+		each(h, "EternalTimestamp::cvt_to_timeinfo_struct", d, [&](size_t i) {
+			eternal_time_tm dst;
+			bench::keep(EternalTimestamp::cvt_to_timeinfo_struct(dst, v[i]));
+			bench::keep(dst);
+		});
+		each(h, "EternalTimestamp::cvt_to_time_t", d, [&](size_t i) {
+			time_t dst = 0;
+			bench::keep(EternalTimestamp::cvt_to_time_t(dst, v[i]));
+			bench::keep(dst);
+		});
+		each(h, "EternalTimestamp::cvt_to_etdb_real", d, [&](size_t i) {
+			double dst = 0;
+			bench::keep(EternalTimestamp::cvt_to_etdb_real(dst, v[i]));
+			bench::keep(dst);
+		});
+		each(h, "EternalTimestamp::cvt_to_proleptic_real", d, [&](size_t i) {
+			double dst = 0;
+			bench::keep(EternalTimestamp::cvt_to_proleptic_real(dst, v[i]));
+			bench::keep(dst);
+		});
+
+		each(h, "EternalTimestamp::cvt_from_timeinfo_struct", d, [&](size_t i) {
+			eternal_timestamp_t dst;
+			bench::keep(EternalTimestamp::cvt_from_timeinfo_struct(dst, d.timeinfos[i]));
+			bench::keep(dst);
+		});
+		each(h, "EternalTimestamp::cvt_from_time_t", d, [&](size_t i) {
+			eternal_timestamp_t dst;
+			bench::keep(EternalTimestamp::cvt_from_time_t(dst, d.time_ts[i]));
+			bench::keep(dst);
+		});
+		each(h, "EternalTimestamp::cvt_from_tm", d, [&](size_t i) {
+			eternal_timestamp_t dst;
+			bench::keep(EternalTimestamp::cvt_from_tm(dst, d.tms[i]));
+			bench::keep(dst);
+		});
+		each(h, "EternalTimestamp::cvt_from_etdb_real", d, [&](size_t i) {
+			eternal_timestamp_t dst;
+			bench::keep(EternalTimestamp::cvt_from_etdb_real(dst, d.reals[i]));
+			bench::keep(dst);
+		});
+		each(h, "EternalTimestamp::cvt_from_proleptic_real", d, [&](size_t i) {
+			eternal_timestamp_t dst;
+			bench::keep(EternalTimestamp::cvt_from_proleptic_real(dst, d.reals[i]));
+			bench::keep(dst);
+		});
+		each(h, "EternalTimestamp::cvt_from_iso8601", d, [&](size_t i) {
+			eternal_timestamp_t dst;
+			bench::keep(EternalTimestamp::cvt_from_iso8601(dst, d.strings[i], d.lengths[i]));
+			bench::keep(dst);
+		});
+		each(h, "EternalTimestamp::cvt_from_iso8601_scalar", d, [&](size_t i) {
+			eternal_timestamp_t dst;
+			bench::keep(EternalTimestamp::cvt_from_iso8601_scalar(dst, d.strings[i], d.lengths[i]));
+			bench::keep(dst);
+		});
+
+		each(h, "EternalTimestamp::ntoh", d, [&](size_t i) { bench::keep(EternalTimestamp::ntoh(v[i])); });
+		each(h, "EternalTimestamp::hton", d, [&](size_t i) { bench::keep(EternalTimestamp::hton(v[i])); });
+	}
+
+	// The batch APIs, on a single thread: `bench_parallel` covers the scaling.
+	void batch_benchmarks(bench::harness &h, const dataset &d)
+	{
+		const size_t count = d.values.size();
+		std::vector<eternal_timestamp_t> out(count);
+		std::vector<int64_t> out64(count);
+		std::vector<int32_t> out32(count);
+		std::vector<uint8_t> validity((count + 7) / 8);
+		std::vector<char> text(count * ETS_BATCH_RFC3339_MAX_LENGTH);
+		std::vector<int32_t> text_offsets(count + 1);
+		std::vector<ets_date32_t> date32(count);
+		std::vector<ets_datetime48_t> datetime48(count + 2);
+		std::vector<uint8_t> bytes(count * 8 + 1);
+		ets_format_pattern_t pattern;
+		EternalTimestampFormat::compile(pattern, "%d/%m/%Y %H:%M:%S.%f", nullptr);
+		std::vector<char> formatted(count * pattern.max_length);
+
+		h.run("EternalTimestampBatch::cvt_from_unix_usecs", d.name, count, [&] {
+			EternalTimestampBatch::cvt_from_unix_usecs(out.data(), nullptr, d.usecs.data(), count, 1);
+			bench::keep(out[0]);
+		});
+		h.run("EternalTimestampBatch::cvt_from_unix_msecs", d.name, count, [&] {
+			EternalTimestampBatch::cvt_from_unix_msecs(out.data(), nullptr, d.msecs.data(), count, 1);
+			bench::keep(out[0]);
+		});
+		h.run("EternalTimestampBatch::cvt_from_unix_seconds", d.name, count, [&] {
+			EternalTimestampBatch::cvt_from_unix_seconds(out.data(), nullptr, d.seconds.data(), count, 1);
+			bench::keep(out[0]);
+		});
+		h.run("EternalTimestampBatch::cvt_from_unix_days", d.name, count, [&] {
+			EternalTimestampBatch::cvt_from_unix_days(out.data(), nullptr, d.days.data(), count, 1);
+			bench::keep(out[0]);
+		});
+		h.run("EternalTimestampBatch::cvt_to_unix_usecs", d.name, count, [&] {
+			bench::keep(EternalTimestampBatch::cvt_to_unix_usecs(out64.data(), validity.data(), d.values.data(), count, 1));
+		});
+		h.run("EternalTimestampBatch::cvt_to_unix_msecs", d.name, count, [&] {
+			bench::keep(EternalTimestampBatch::cvt_to_unix_msecs(out64.data(), validity.data(), d.values.data(), count, 1));
+		});
+		h.run("EternalTimestampBatch::cvt_to_unix_seconds", d.name, count, [&] {
+			bench::keep(EternalTimestampBatch::cvt_to_unix_seconds(out64.data(), validity.data(), d.values.data(), count, 1));
+		});
+		h.run("EternalTimestampBatch::cvt_to_unix_days", d.name, count, [&] {
+			bench::keep(EternalTimestampBatch::cvt_to_unix_days(out32.data(), validity.data(), d.values.data(), count, 1));
+		});
+		h.run("EternalTimestampBatch::cvt_from_iso8601", d.name, count, [&] {
+			bench::keep(EternalTimestampBatch::cvt_from_iso8601(out.data(), validity.data(), d.strings.data(), d.lengths.data(), count, 1));
+		});
+		h.run("EternalTimestampBatch::cvt_from_iso8601_column", d.name, count, [&] {
+			bench::keep(EternalTimestampBatch::cvt_from_iso8601_column(out.data(), validity.data(), d.column.data(), d.offsets.data(), count, 1));
+		});
+		h.run("EternalTimestampBatch::cvt_to_rfc3339_column", d.name, count, [&] {
+			text_offsets[0] = 0;
+			bench::keep(EternalTimestampBatch::cvt_to_rfc3339_column(text.data(), text.size(), text_offsets.data(), validity.data(), d.values.data(), 0, count, 1));
+		});
+		h.run("EternalTimestampBatch::calc_sort_keys", d.name, count, [&] {
+			EternalTimestampBatch::calc_sort_keys(out64.data(), d.values.data(), count, 1);
+			bench::keep(out64[0]);
+		});
+
+		h.run("EternalTimestampFormat::format_column", d.name, count, [&] {
+			text_offsets[0] = 0;
+			bench::keep(EternalTimestampFormat::format_column(formatted.data(), formatted.size(), text_offsets.data(), pattern, d.values.data(), count, 1));
+		});
+
+		h.run("EternalTimestampCompact::narrow_date32_batch", d.name, count, [&] {
+			bench::keep(EternalTimestampCompact::narrow_date32_batch(date32.data(), validity.data(), d.values.data(), count, 1));
+		});
+		h.run("EternalTimestampCompact::widen_date32_batch", d.name, count, [&] {
+			bench::keep(EternalTimestampCompact::widen_date32_batch(out.data(), validity.data(), date32.data(), count, 1));
+		});
+		h.run("EternalTimestampCompact::narrow_datetime48_batch", d.name, count, [&] {
+			bench::keep(EternalTimestampCompact::narrow_datetime48_batch(datetime48.data(), validity.data(), d.values.data(), count, 1));
+		});
+		h.run("EternalTimestampCompact::widen_datetime48_batch", d.name, count, [&] {
+			bench::keep(EternalTimestampCompact::widen_datetime48_batch(out.data(), validity.data(), datetime48.data(), count, 1));
+		});
+
+		// misaligned by a byte, as in a packed record stream
+		h.run("EternalTimestampEndian::store (big-endian)", d.name, count, [&] {
+			EternalTimestampEndian::store(bytes.data() + 1, d.values.data(), count, ETS_BYTE_ORDER_BIG, 8, 1);
+			bench::keep(bytes[1]);
+		});
+		h.run("EternalTimestampEndian::load (big-endian)", d.name, count, [&] {
+			EternalTimestampEndian::load(out.data(), bytes.data() + 1, count, ETS_BYTE_ORDER_BIG, 8, 1);
+			bench::keep(out[0]);
+		});
+	}
+}
+
+
+#if defined(BUILD_MONOLITHIC)
+#define main(cnt, arr)      eternalty_bench_suite_main(cnt, arr)
+#endif
+
+int main(int argc, const char **argv)
+{
+	bench::harness h(argc, argv, "libeternaltimestamp benchmark suite: the public entry points on modern, mixed and partial data");
+
+#if defined(ETS_BENCH_LIBRARY_VERSION)
+	h.set_context("library_version", ETS_BENCH_LIBRARY_VERSION);
+#endif
+#if defined(__VERSION__)
+	h.set_context("compiler", __VERSION__);
+#endif
+#if defined(NDEBUG)
+	h.set_context("assertions", "off");
+#else
+	h.set_context("assertions", "on");
+#endif
+	h.set_context("values", std::to_string(h.values()));
+	h.set_context("started_unix_seconds", std::to_string(static_cast<long long>(time(nullptr))));
+
+	// the clock: a single value per call
+	h.run("EternalTimestamp::now", "-", 1, [] { bench::keep(EternalTimestamp::now()); });
+	h.run("EternalTimestamp::today", "-", 1, [] { bench::keep(EternalTimestamp::today()); });
+	h.run("EternalTimestamp::today_at", "-", 1, [] { bench::keep(EternalTimestamp::today_at(12, 30, 15)); });
+
+	static const char *const distributions[] = { "modern", "mixed", "partial" };
+	for (size_t k = 0; k < sizeof(distributions) / sizeof(distributions[0]); k++) {
+		dataset d;
+		make_dataset(d, distributions[k], h.values(), 46 + k);
+		single_value_benchmarks(h, d);
+		batch_benchmarks(h, d);
+	}
+
+	return h.finish();
+}
@@ -0,0 +1,174 @@
+// Timer benchmark: the timing wheel against a `std::priority_queue` of deadlines, the usual alternative.
+//
+// Both get the same timers (timeouts of a few milliseconds to a week), a third of which are cancelled again,
+// and then expire them all while the time moves forward, a millisecond at a time for the first minute (where most
+// timers are) and a second at a time after that. The priority queue cancels lazily, through a tombstone per timer,
+// as is customary.
+//
+// usage: bench_timer [timers]
+
+#include <eternal_timestamp/eternal_timestamp.h>
+#include <eternal_timestamp/eternal_timestamp_batch.h>
+#include <eternal_timestamp/eternal_timestamp_timer.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <queue>
+#include <random>
+#include <vector>
+
+#include "monolithic_examples.h"
+
+
+using namespace eternal_timestamp;
+
+// The best of a few runs, in nanoseconds per value.
+template <typename F>
+static double measure(size_t count, F &&run)
+{
+	double best = 1e30;
+	for (int round = 0; round < 3; round++) {
+		const auto start = std::chrono::steady_clock::now();
+		run();
+		const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+		if (elapsed.count() < best)
+			best = elapsed.count();
+	}
+	return best / static_cast<double>(count);
+}
+
+static size_t sink = 0;
+
+static const int64_t USECS_PER_MSEC = 1000;
+
+struct queued_timer
+{
+	int64_t deadline;                     // milliseconds
+	uint64_t id;
+
+	bool operator>(const queued_timer &other) const
+	{
+		return deadline > other.deadline;
+	}
+};
+
+
+#if defined(BUILD_MONOLITHIC)
+#define main(cnt, arr)      eternalty_bench_timer_main(cnt, arr)
+#endif
+
+int main(int argc, const char **argv)
+{
+	const size_t count = (argc > 1 ? strtoull(argv[1], nullptr, 10) : 4000000);
+
+	// mostly short timeouts, as with request deadlines and retries; the last one a week out
+	const int64_t start = 1767225600LL * 1000000;
+	std::mt19937_64 rng(42);
+	std::vector<int64_t> usecs(count);
+	for (size_t i = 0; i < count; i++) {
+		const uint64_t r = rng();
+		const int64_t msecs = (r % 8 ? static_cast<int64_t>(r >> 8) % 60000 : static_cast<int64_t>(r >> 8) % (7 * 86400000LL));
+		usecs[i] = start + msecs * USECS_PER_MSEC + static_cast<int64_t>(r % 1000);
+	}
+	std::vector<eternal_timestamp_t> deadlines(count);
+	EternalTimestampBatch::cvt_from_unix_usecs(deadlines.data(), nullptr, usecs.data(), count, 1);
+
+	eternal_timestamp_t begin;
+	EternalTimestampBatch::cvt_from_unix_usecs(&begin, nullptr, &start, 1, 1);
+	int64_t end_msecs = 0;
+	for (size_t i = 0; i < count; i++) {
+		if (usecs[i] / USECS_PER_MSEC > end_msecs)
+			end_msecs = usecs[i] / USECS_PER_MSEC;
+	}
+	// the time steps: one per millisecond up to a minute (where most timers are), then a second at a time
+	std::vector<eternal_timestamp_t> steps;
+	std::vector<int64_t> step_msecs;
+	for (int64_t ms = start / USECS_PER_MSEC + 1; ms <= end_msecs + 1000; ms += (ms - start / USECS_PER_MSEC < 60000 ? 1 : 1000)) {
+		const int64_t us = ms * USECS_PER_MSEC;
+		step_msecs.push_back(ms);
+		steps.emplace_back();
+		EternalTimestampBatch::cvt_from_unix_usecs(&steps.back(), nullptr, &us, 1, 1);
+	}
+
+	std::vector<ets_timer_handle_t> handles(count);
+	std::vector<ets_timer_t> expired(4096);
+	double insert_ns = 0, cancel_ns = 0, expire_ns = 0;
+	double pq_insert_ns = 0, pq_cancel_ns = 0, pq_expire_ns = 0;
+
+	for (int round = 0; round < 3; round++) {
+		// the wheel
+		ets_timer_wheel_t *wheel = nullptr;
+		EternalTimestampTimerWheel::create(wheel, begin);
+		auto t0 = std::chrono::steady_clock::now();
+		EternalTimestampTimerWheel::insert_batch(wheel, handles.data(), deadlines.data(), nullptr, count);
+		auto t1 = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < count; i += 3)
+			sink += EternalTimestampTimerWheel::cancel(wheel, handles[i]);
+		auto t2 = std::chrono::steady_clock::now();
+		for (const auto &now : steps)
+			sink += EternalTimestampTimerWheel::poll(wheel, now, expired.data(), expired.size());
+		auto t3 = std::chrono::steady_clock::now();
+		EternalTimestampTimerWheel::destroy(wheel);
+
+		const std::chrono::duration<double, std::nano> insert = t1 - t0, cancel = t2 - t1, expire = t3 - t2;
+		if (!round || insert.count() < insert_ns)
+			insert_ns = insert.count();
+		if (!round || cancel.count() < cancel_ns)
+			cancel_ns = cancel.count();
+		if (!round || expire.count() < expire_ns)
+			expire_ns = expire.count();
+
+		// the priority queue, with a tombstone per timer for cancelling
+		std::priority_queue<queued_timer, std::vector<queued_timer>, std::greater<queued_timer>> pq;
+		std::vector<uint8_t> cancelled(count, 0);
+		t0 = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < count; i++)
+			pq.push(queued_timer{ usecs[i] / USECS_PER_MSEC, i });
+		t1 = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < count; i += 3)
+			cancelled[i] = 1;
+		t2 = std::chrono::steady_clock::now();
+		for (const int64_t now : step_msecs) {
+			while (!pq.empty() && pq.top().deadline <= now) {
+				sink += !cancelled[pq.top().id];
+				pq.pop();
+			}
+		}
+		t3 = std::chrono::steady_clock::now();
+
+		const std::chrono::duration<double, std::nano> pq_insert = t1 - t0, pq_cancel = t2 - t1, pq_expire = t3 - t2;
+		if (!round || pq_insert.count() < pq_insert_ns)
+			pq_insert_ns = pq_insert.count();
+		if (!round || pq_cancel.count() < pq_cancel_ns)
+			pq_cancel_ns = pq_cancel.count();
+		if (!round || pq_expire.count() < pq_expire_ns)
+			pq_expire_ns = pq_expire.count();
+	}
+
+	const double n = static_cast<double>(count);
+	const double cancels = static_cast<double>((count + 2) / 3);
+	printf("%zu timers, %zu time steps; nanoseconds per timer:\n\n", count, steps.size());
+	printf("%-40s %10s %10s %10s %10s\n", "", "insert", "cancel", "expire", "total");
+	printf("%-40s %10.2f %10.2f %10.2f %10.2f\n", "EternalTimestampTimerWheel",
+		insert_ns / n, cancel_ns / cancels, expire_ns / n, (insert_ns + cancel_ns + expire_ns) / n);
+	printf("%-40s %10.2f %10.2f %10.2f %10.2f\n", "std::priority_queue (lazy cancel)",
+		pq_insert_ns / n, pq_cancel_ns / cancels, pq_expire_ns / n, (pq_insert_ns + pq_cancel_ns + pq_expire_ns) / n);
+
+	// next_expiry() is what an event loop asks before every sleep
+	{
+		ets_timer_wheel_t *wheel = nullptr;
+		EternalTimestampTimerWheel::create(wheel, begin);
+		EternalTimestampTimerWheel::insert_batch(wheel, nullptr, deadlines.data(), nullptr, count);
+		const size_t queries = 1000000;
+		const double ns = measure(queries, [&] {
+			eternal_timestamp_t next;
+			for (size_t i = 0; i < queries; i++)
+				sink += EternalTimestampTimerWheel::next_expiry(wheel, next);
+		});
+		printf("\n%-40s %10.2f\n", "EternalTimestampTimerWheel::next_expiry", ns);
+		EternalTimestampTimerWheel::destroy(wheel);
+	}
+
+	return (sink ? EXIT_SUCCESS : EXIT_FAILURE);
+}
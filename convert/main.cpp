@@ -0,0 +1,839 @@
+
+// eternal-convert: convert the timestamp columns of (large) CSV or NDJSON files to eternal timestamps.
+//
+// The input file is memory mapped and cut into line-aligned chunks by the reader (the main thread), which feeds
+// a work queue served by one parser/converter thread per core. A writer thread collects the converted chunks and
+// writes them, in their original order, to the output:
+//
+// - in text mode (default) the timestamp fields are rewritten in place, i.e. replaced by the decimal
+//   `eternal_timestamp_t` value, while the rest of the input is copied verbatim;
+// - in binary mode a column of 64-bit timestamps (see `EternalTimestamp::hton()`) is written instead: one value per
+//   selected column per row, where fields which are absent or cannot be parsed produce the 'unknown' timestamp.
+//
+// Accepted timestamp notations are ISO 8601 / RFC 3339 (reduced precision produces partial timestamps) and
+// numeric UNIX epoch values (see the `-u` option).
+//
+// Limitation: quoted CSV fields may contain delimiters and (doubled) quotes, but no line breaks.
+
+#include <eternal_timestamp/eternal_timestamp.h>
+#include <eternal_timestamp/eternal_timestamp_batch.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(BUILD_MONOLITHIC)
+#include "monolithic_examples.h"
+#endif
+
+
+using namespace eternal_timestamp;
+
+
+namespace
+{
+	const int64_t USECS_PER_SECOND = 1000000;
+
+	enum input_format
+	{
+		FORMAT_AUTO,
+		FORMAT_CSV,
+		FORMAT_NDJSON,
+	};
+
+	struct options
+	{
+		input_format format = FORMAT_AUTO;
+		std::vector<std::string> columns;
+		bool header = true;
+		char delimiter = ',';
+		bool binary = false;
+		int64_t epoch_scale = USECS_PER_SECOND;   // microseconds per unit for numeric (UNIX epoch) input
+		unsigned int threads = 0;
+		size_t chunk_size = 4 << 20;
+		bool verbose = false;
+		const char *input = nullptr;
+		const char *output = nullptr;
+	};
+
+	constexpr size_t MAX_REJECT_SAMPLES = 10;
+
+
+	//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// timestamp text parsing
+	//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	// UNIX epoch number: [+-]digits[.digits]
+	bool parse_epoch(const char *p, const char *end, int64_t scale, eternal_timestamp_t &dst)
+	{
+		bool negative = false;
+		if (p < end && (*p == '-' || *p == '+')) {
+			negative = (*p == '-');
+			p++;
+		}
+		if (p == end)
+			return false;
+
+		int64_t whole = 0;
+		int digits = 0;
+		while (p < end && *p >= '0' && *p <= '9') {
+			whole = whole * 10 + (*p++ - '0');
+			if (++digits > 15)
+				return false;
+		}
+		int64_t fraction = 0;
+		int64_t fraction_scale = 1;
+		if (p < end && *p == '.') {
+			p++;
+			while (p < end && *p >= '0' && *p <= '9') {
+				// we only keep microsecond precision: ignore any further digits
+				if (fraction_scale < USECS_PER_SECOND) {
+					fraction = fraction * 10 + (*p - '0');
+					fraction_scale *= 10;
+				}
+				p++;
+				digits++;
+			}
+		}
+		if (p != end || digits == 0 || whole > INT64_MAX / scale - 1)
+			return false;
+
+		int64_t usecs = whole * scale + fraction * scale / fraction_scale;
+		if (negative)
+			usecs = -usecs;
+		// values beyond the modern subformat's range (9901 BC .. 41199 AD) are rejected by the conversion.
+		return EternalTimestampBatch::cvt_from_unix_usecs(&dst, nullptr, &usecs, 1, 1) == 0;
+	}
+
+	bool parse_timestamp(const char *p, const char *end, int64_t epoch_scale, eternal_timestamp_t &dst)
+	{
+		while (p < end && (*p == ' ' || *p == '\t'))
+			p++;
+		while (end > p && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r'))
+			end--;
+		if (p == end)
+			return false;
+
+		// a plain number is a UNIX epoch value, except for a 4-digit year or an 8-digit ISO 8601 'basic' date (YYYYMMDD).
+		const char *q = p + (*p == '-' || *p == '+');
+		bool numeric = true;
+		for (const char *s = q; s < end; s++) {
+			if (!((*s >= '0' && *s <= '9') || *s == '.')) {
+				numeric = false;
+				break;
+			}
+		}
+		if (numeric && end - q != 4 && end - q != 8)
+			return parse_epoch(p, end, epoch_scale, dst);
+		return EternalTimestamp::cvt_from_iso8601(dst, p, end - p) == 0;
+	}
+
+
+	//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// input
+	//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	class input_file
+	{
+	public:
+		~input_file()
+		{
+#if defined(_WIN32)
+			free(buffer);
+#else
+			if (data && size)
+				munmap(const_cast<char *>(data), size);
+#endif
+		}
+
+		bool open(const char *path)
+		{
+#if defined(_WIN32)
+			FILE *f = fopen(path, "rb");
+			if (!f)
+				return false;
+			fseek(f, 0, SEEK_END);
+			size = static_cast<size_t>(ftell(f));
+			fseek(f, 0, SEEK_SET);
+			buffer = static_cast<char *>(malloc(size + 1));
+			const bool ok = buffer && fread(buffer, 1, size, f) == size;
+			fclose(f);
+			data = buffer;
+			return ok;
+#else
+			int fd = ::open(path, O_RDONLY);
+			if (fd < 0)
+				return false;
+			struct stat st;
+			if (fstat(fd, &st) < 0) {
+				close(fd);
+				return false;
+			}
+			size = static_cast<size_t>(st.st_size);
+			if (size) {
+				void *p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+				if (p == MAP_FAILED) {
+					close(fd);
+					return false;
+				}
+				madvise(p, size, MADV_SEQUENTIAL);
+				data = static_cast<const char *>(p);
+			}
+			close(fd);
+			return true;
+#endif
+		}
+
+		// hint the OS to start paging in the given range ahead of the parser threads.
+		void prefetch(const char *begin, size_t len) const
+		{
+#if !defined(_WIN32)
+			const uintptr_t page = 4096;
+			const uintptr_t start = reinterpret_cast<uintptr_t>(begin) & ~(page - 1);
+			madvise(reinterpret_cast<void *>(start), len + (reinterpret_cast<uintptr_t>(begin) - start), MADV_WILLNEED);
+#endif
+		}
+
+		const char *data = nullptr;
+		size_t size = 0;
+
+	private:
+#if defined(_WIN32)
+		char *buffer = nullptr;
+#endif
+	};
+
+
+	//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// chunk conversion
+	//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	struct work_item
+	{
+		size_t seq;
+		const char *begin;
+		const char *end;
+	};
+
+	struct chunk_result
+	{
+		std::string text;
+		std::vector<uint64_t> binary;
+		size_t bytes = 0;
+		size_t rows = 0;
+		size_t values = 0;
+		size_t rejects = 0;
+		std::vector<std::pair<size_t, std::string> > reject_samples;    // chunk-local row number + offending text
+	};
+
+	// which fields of a record are to be converted, and in which output slot their value goes in binary mode.
+	struct column_selection
+	{
+		// CSV: slot per field index, -1 when the field is not selected.
+		std::vector<int> csv_slots;
+		// NDJSON: the keys, in slot order.
+		std::vector<std::string> keys;
+		size_t slot_count = 0;
+	};
+
+	class converter
+	{
+	public:
+		converter(const options &opt, const column_selection &sel)
+			: opt(opt), sel(sel), unknown(EternalTimestamp::unknown())
+		{
+		}
+
+		void convert(const work_item &item, chunk_result &res) const
+		{
+			res.bytes = item.end - item.begin;
+			if (!opt.binary)
+				res.text.reserve(res.bytes + res.bytes / 8);
+
+			std::vector<uint64_t> row(sel.slot_count);
+			const char *line = item.begin;
+			while (line < item.end) {
+				const char *eol = static_cast<const char *>(memchr(line, '\n', item.end - line));
+				const char *next = (eol ? eol + 1 : item.end);
+				if (!eol)
+					eol = item.end;
+
+				std::fill(row.begin(), row.end(), hton(unknown));
+				const char *copied = line;
+				if (opt.format == FORMAT_NDJSON)
+					convert_ndjson_line(line, eol, row, copied, res);
+				else
+					convert_csv_line(line, eol, row, copied, res);
+
+				if (opt.binary)
+					res.binary.insert(res.binary.end(), row.begin(), row.end());
+				else
+					res.text.append(copied, next - copied);
+				res.rows++;
+				line = next;
+			}
+		}
+
+	private:
+		static uint64_t hton(const eternal_timestamp_t t)
+		{
+			return EternalTimestamp::hton(t).t;
+		}
+
+		// convert one field; in text mode, write everything up to and including the converted value to the output.
+		void convert_field(const char *field, const char *field_end, const char *value, const char *value_end, int slot, std::vector<uint64_t> &row, const char *&copied, chunk_result &res) const
+		{
+			eternal_timestamp_t t;
+			if (!parse_timestamp(value, value_end, opt.epoch_scale, t)) {
+				if (res.reject_samples.size() < MAX_REJECT_SAMPLES)
+					res.reject_samples.emplace_back(res.rows, std::string(field, field_end));
+				res.rejects++;
+				return;
+			}
+			res.values++;
+			if (opt.binary) {
+				row[slot] = hton(t);
+			}
+			else {
+				char num[24];
+				const int len = snprintf(num, sizeof(num), "%llu", static_cast<unsigned long long>(t.t));
+				res.text.append(copied, field - copied);
+				res.text.append(num, len);
+				copied = field_end;
+			}
+		}
+
+		void convert_csv_line(const char *p, const char *eol, std::vector<uint64_t> &row, const char *&copied, chunk_result &res) const
+		{
+			const char delim = opt.delimiter;
+			size_t index = 0;
+			const char *end = (eol > p && eol[-1] == '\r' ? eol - 1 : eol);
+			while (p <= end) {
+				const char *field = p;
+				const char *value;
+				const char *value_end;
+				if (p < end && *p == '"') {
+					// quoted field: a doubled quote is an escaped quote.
+					p++;
+					value = p;
+					while (p < end) {
+						if (*p == '"') {
+							if (p + 1 < end && p[1] == '"') {
+								p += 2;
+								continue;
+							}
+							break;
+						}
+						p++;
+					}
+					value_end = p;
+					if (p < end)
+						p++;
+					while (p < end && *p != delim)
+						p++;
+				}
+				else {
+					const char *d = static_cast<const char *>(memchr(p, delim, end - p));
+					p = (d ? d : end);
+					value = field;
+					value_end = p;
+				}
+
+				if (index < sel.csv_slots.size() && sel.csv_slots[index] >= 0)
+					convert_field(field, p, value, value_end, sel.csv_slots[index], row, copied, res);
+
+				index++;
+				p++;    // skip the delimiter
+			}
+		}
+
+		// scan the top-level members of a JSON object: `{"key": value, ...}`.
+		void convert_ndjson_line(const char *p, const char *eol, std::vector<uint64_t> &row, const char *&copied, chunk_result &res) const
+		{
+			int depth = 0;
+			while (p < eol) {
+				const char c = *p;
+				if (c == '"') {
+					const char *s = ++p;
+					while (p < eol && *p != '"') {
+						if (*p == '\\')
+							p++;
+						p++;
+					}
+					const char *s_end = p;
+					if (p < eol)
+						p++;
+					if (depth != 1)
+						continue;
+
+					// is this string a member key?
+					const char *q = p;
+					while (q < eol && (*q == ' ' || *q == '\t'))
+						q++;
+					if (q >= eol || *q != ':')
+						continue;
+					q++;
+					while (q < eol && (*q == ' ' || *q == '\t'))
+						q++;
+
+					int slot = -1;
+					for (size_t k = 0; k < sel.keys.size(); k++) {
+						if (sel.keys[k].size() == static_cast<size_t>(s_end - s) && !memcmp(sel.keys[k].data(), s, s_end - s)) {
+							slot = static_cast<int>(k);
+							break;
+						}
+					}
+					p = q;
+					if (slot < 0)
+						continue;
+
+					// the value: a string or a number
+					const char *field = q;
+					const char *value;
+					const char *value_end;
+					if (q < eol && *q == '"') {
+						value = ++q;
+						while (q < eol && *q != '"') {
+							if (*q == '\\')
+								q++;
+							q++;
+						}
+						value_end = q;
+						if (q < eol)
+							q++;
+					}
+					else {
+						value = q;
+						while (q < eol && *q != ',' && *q != '}' && *q != ' ' && *q != '\t' && *q != '\r')
+							q++;
+						value_end = q;
+					}
+					convert_field(field, q, value, value_end, slot, row, copied, res);
+					p = q;
+					continue;
+				}
+				if (c == '{' || c == '[')
+					depth++;
+				else if (c == '}' || c == ']')
+					depth--;
+				p++;
+			}
+		}
+
+		const options &opt;
+		const column_selection &sel;
+		const eternal_timestamp_t unknown;
+	};
+
+
+	//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// pipeline
+	//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	class work_queue
+	{
+	public:
+		void push(const work_item &item)
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				items.push_back(item);
+			}
+			cv.notify_one();
+		}
+
+		void close()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				closed = true;
+			}
+			cv.notify_all();
+		}
+
+		bool pop(work_item &item)
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			cv.wait(lock, [this] { return closed || !items.empty(); });
+			if (items.empty())
+				return false;
+			item = items.front();
+			items.pop_front();
+			return true;
+		}
+
+	private:
+		std::mutex mutex;
+		std::condition_variable cv;
+		std::deque<work_item> items;
+		bool closed = false;
+	};
+
+	// Collects the converted chunks and hands them to the writer in their original order.
+	class result_collector
+	{
+	public:
+		explicit result_collector(size_t max_in_flight)
+			: max_in_flight(max_in_flight)
+		{
+		}
+
+		// reader side: block while too many chunks are in flight, so we don't buffer the entire output in memory.
+		void wait_for_room(size_t seq)
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			room_cv.wait(lock, [&] { return seq < next_to_write + max_in_flight; });
+		}
+
+		void put(size_t seq, chunk_result &&res)
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				done.emplace(seq, std::move(res));
+			}
+			ready_cv.notify_one();
+		}
+
+		void finish(size_t total)
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				total_chunks = total;
+			}
+			ready_cv.notify_one();
+		}
+
+		// writer side: return false when all chunks have been written.
+		bool take(chunk_result &res)
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			ready_cv.wait(lock, [this] { return done.count(next_to_write) || next_to_write == total_chunks; });
+			if (next_to_write == total_chunks)
+				return false;
+			auto it = done.find(next_to_write);
+			res = std::move(it->second);
+			done.erase(it);
+			next_to_write++;
+			lock.unlock();
+			room_cv.notify_one();
+			return true;
+		}
+
+	private:
+		std::mutex mutex;
+		std::condition_variable ready_cv;
+		std::condition_variable room_cv;
+		std::map<size_t, chunk_result> done;
+		size_t next_to_write = 0;
+		size_t total_chunks = SIZE_MAX;
+		const size_t max_in_flight;
+	};
+
+	struct totals
+	{
+		size_t bytes = 0;
+		size_t rows = 0;
+		size_t values = 0;
+		size_t rejects = 0;
+		bool write_error = false;
+	};
+
+	void write_results(result_collector &collector, FILE *out, size_t first_row, bool verbose, totals &tot)
+	{
+		chunk_result res;
+		size_t row_base = first_row;
+		size_t samples = 0;
+		while (collector.take(res)) {
+			if (!res.text.empty() && fwrite(res.text.data(), 1, res.text.size(), out) != res.text.size())
+				tot.write_error = true;
+			if (!res.binary.empty() && fwrite(res.binary.data(), sizeof(res.binary[0]), res.binary.size(), out) != res.binary.size())
+				tot.write_error = true;
+			if (verbose) {
+				for (const auto &r : res.reject_samples) {
+					if (samples++ < MAX_REJECT_SAMPLES)
+						fprintf(stderr, "reject: line %zu: %s\n", row_base + r.first + 1, r.second.c_str());
+				}
+			}
+			tot.bytes += res.bytes;
+			tot.rows += res.rows;
+			tot.values += res.values;
+			tot.rejects += res.rejects;
+			row_base += res.rows;
+		}
+	}
+
+
+	//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// command line
+	//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	void usage()
+	{
+		fprintf(stderr,
+			"Usage: eternal-convert [options] -c column [-c column ...] input [output]\n"
+			"\n"
+			"Convert the timestamp columns of a CSV or NDJSON file to eternal timestamps.\n"
+			"\n"
+			"Options:\n"
+			"  -c column   column to convert: CSV header name or 1-based field number, NDJSON member key.\n"
+			"  -f format   input format: 'csv' or 'ndjson'; default: derived from the input file name.\n"
+			"  -d char     CSV field delimiter; default: ','.\n"
+			"  -n          the CSV input has no header line.\n"
+			"  -b          write a binary column of 64-bit timestamps instead of rewriting the text.\n"
+			"  -u unit     unit of numeric (UNIX epoch) input values: 's', 'ms' or 'us'; default: 's'.\n"
+			"  -j threads  number of converter threads; default: the number of cores.\n"
+			"  -v          report the first few rejected values.\n"
+			"\n"
+			"Output goes to stdout when no output file is given. Statistics are reported on stderr.\n");
+	}
+
+	bool parse_options(int argc, const char **argv, options &opt)
+	{
+		int i = 1;
+		for (; i < argc && argv[i][0] == '-' && argv[i][1]; i++) {
+			const char *a = argv[i];
+			// option values may be attached (`-j4`) or separate (`-j 4`)
+			const bool attached = (a[2] != 0);
+			const char *val = (attached ? a + 2 : i + 1 < argc ? argv[i + 1] : nullptr);
+			switch (a[1]) {
+			case 'c':
+				if (!val)
+					return false;
+				opt.columns.push_back(val);
+				i += !attached;
+				break;
+			case 'f':
+				if (!val)
+					return false;
+				if (!strcmp(val, "csv"))
+					opt.format = FORMAT_CSV;
+				else if (!strcmp(val, "ndjson") || !strcmp(val, "jsonl"))
+					opt.format = FORMAT_NDJSON;
+				else
+					return false;
+				i += !attached;
+				break;
+			case 'd':
+				if (!val || strlen(val) != 1)
+					return false;
+				opt.delimiter = val[0];
+				i += !attached;
+				break;
+			case 'n':
+				opt.header = false;
+				break;
+			case 'b':
+				opt.binary = true;
+				break;
+			case 'u':
+				if (!val)
+					return false;
+				if (!strcmp(val, "s"))
+					opt.epoch_scale = USECS_PER_SECOND;
+				else if (!strcmp(val, "ms"))
+					opt.epoch_scale = 1000;
+				else if (!strcmp(val, "us"))
+					opt.epoch_scale = 1;
+				else
+					return false;
+				i += !attached;
+				break;
+			case 'j':
+				if (!val)
+					return false;
+				opt.threads = static_cast<unsigned int>(atoi(val));
+				i += !attached;
+				break;
+			case 'v':
+				opt.verbose = true;
+				break;
+			default:
+				return false;
+			}
+		}
+		if (i >= argc || opt.columns.empty())
+			return false;
+		opt.input = argv[i++];
+		if (i < argc)
+			opt.output = argv[i++];
+		if (i != argc)
+			return false;
+
+		if (opt.format == FORMAT_AUTO) {
+			const char *ext = strrchr(opt.input, '.');
+			opt.format = (ext && (!strcmp(ext, ".ndjson") || !strcmp(ext, ".jsonl") || !strcmp(ext, ".json")) ? FORMAT_NDJSON : FORMAT_CSV);
+		}
+		if (!opt.threads)
+			opt.threads = std::max(1u, std::thread::hardware_concurrency());
+		return true;
+	}
+
+	// map the requested columns onto CSV field numbers, using the header line.
+	bool select_csv_columns(const options &opt, const char *header, const char *header_end, column_selection &sel)
+	{
+		std::vector<std::string> names;
+		if (header) {
+			const char *p = header;
+			const char *end = (header_end > header && header_end[-1] == '\r' ? header_end - 1 : header_end);
+			while (p <= end) {
+				const char *d = static_cast<const char *>(memchr(p, opt.delimiter, end - p));
+				const char *f_end = (d ? d : end);
+				std::string name(p, f_end);
+				if (name.size() >= 2 && name.front() == '"' && name.back() == '"')
+					name = name.substr(1, name.size() - 2);
+				names.push_back(name);
+				p = f_end + 1;
+			}
+		}
+
+		for (size_t slot = 0; slot < opt.columns.size(); slot++) {
+			const std::string &col = opt.columns[slot];
+			auto it = std::find(names.begin(), names.end(), col);
+			size_t index;
+			if (it != names.end()) {
+				index = it - names.begin();
+			}
+			else if (!col.empty() && strspn(col.c_str(), "0123456789") == col.size() && atoi(col.c_str()) > 0) {
+				index = atoi(col.c_str()) - 1;
+			}
+			else {
+				fprintf(stderr, "eternal-convert: unknown column '%s'\n", col.c_str());
+				return false;
+			}
+			if (sel.csv_slots.size() <= index)
+				sel.csv_slots.resize(index + 1, -1);
+			sel.csv_slots[index] = static_cast<int>(slot);
+		}
+		sel.slot_count = opt.columns.size();
+		return true;
+	}
+}
+
+
+#if defined(BUILD_MONOLITHIC)
+#define main(cnt, arr)      eternalty_convert_main(cnt, arr)
+#endif
+
+int main(int argc, const char **argv)
+{
+	options opt;
+	if (!parse_options(argc, argv, opt)) {
+		usage();
+		return EXIT_FAILURE;
+	}
+
+	input_file in;
+	if (!in.open(opt.input)) {
+		fprintf(stderr, "eternal-convert: cannot open '%s'\n", opt.input);
+		return EXIT_FAILURE;
+	}
+	FILE *out = (opt.output ? fopen(opt.output, opt.binary ? "wb" : "w") : stdout);
+	if (!out) {
+		fprintf(stderr, "eternal-convert: cannot create '%s'\n", opt.output);
+		return EXIT_FAILURE;
+	}
+
+	const auto started = std::chrono::steady_clock::now();
+
+	const char *data = in.data;
+	const char *data_end = in.data + in.size;
+
+	column_selection sel;
+	size_t first_row = 0;
+	if (opt.format == FORMAT_CSV) {
+		const char *header = nullptr;
+		const char *header_end = nullptr;
+		if (opt.header && data < data_end) {
+			header = data;
+			header_end = static_cast<const char *>(memchr(data, '\n', data_end - data));
+			if (!header_end)
+				header_end = data_end;
+			data = (header_end < data_end ? header_end + 1 : data_end);
+			// the header line is copied verbatim in text mode
+			if (!opt.binary)
+				fwrite(header, 1, data - header, out);
+			first_row = 1;
+		}
+		if (!select_csv_columns(opt, header, header_end, sel))
+			return EXIT_FAILURE;
+	}
+	else {
+		sel.keys = opt.columns;
+		sel.slot_count = opt.columns.size();
+	}
+
+	converter conv(opt, sel);
+	work_queue queue;
+	result_collector collector(4 * opt.threads);
+	totals tot;
+
+	std::vector<std::thread> workers;
+	for (unsigned int i = 0; i < opt.threads; i++) {
+		workers.emplace_back([&] {
+			work_item item;
+			while (queue.pop(item)) {
+				chunk_result res;
+				conv.convert(item, res);
+				collector.put(item.seq, std::move(res));
+			}
+		});
+	}
+	std::thread writer([&] {
+		write_results(collector, out, first_row, opt.verbose, tot);
+	});
+
+	// reader: cut the input into line-aligned chunks.
+	size_t seq = 0;
+	while (data < data_end) {
+		const char *end = data + std::min(opt.chunk_size, static_cast<size_t>(data_end - data));
+		if (end < data_end) {
+			const char *eol = static_cast<const char *>(memchr(end, '\n', data_end - end));
+			end = (eol ? eol + 1 : data_end);
+		}
+		collector.wait_for_room(seq);
+		in.prefetch(end, std::min(opt.chunk_size, static_cast<size_t>(data_end - end)));
+		queue.push(work_item{ seq++, data, end });
+		data = end;
+	}
+	queue.close();
+	collector.finish(seq);
+
+	for (auto &w : workers)
+		w.join();
+	writer.join();
+
+	if (out != stdout)
+		fclose(out);
+	else
+		fflush(out);
+
+	const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+	fprintf(stderr, "eternal-convert: %zu rows, %zu values converted, %zu rejected; %.1f MB in %.3f s: %.1f MB/s, %.0f rows/s (%u threads)\n",
+		tot.rows, tot.values, tot.rejects,
+		tot.bytes / 1.0E6, elapsed, (elapsed > 0 ? tot.bytes / 1.0E6 / elapsed : 0.0), (elapsed > 0 ? tot.rows / elapsed : 0.0),
+		opt.threads);
+
+	if (tot.write_error) {
+		fprintf(stderr, "eternal-convert: error writing the output\n");
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
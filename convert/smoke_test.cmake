@@ -0,0 +1,19 @@
+# Smoke test: convert INPUT with eternal-convert (CONVERT) into OUTPUT and compare that against EXPECTED.
+#
+#   cmake -DCONVERT=... -DINPUT=... -DOUTPUT=... -DEXPECTED=... -P smoke_test.cmake
+
+execute_process(
+	COMMAND ${CONVERT} -j 2 -c when ${INPUT} ${OUTPUT}
+	RESULT_VARIABLE rv
+)
+if(NOT rv EQUAL 0)
+	message(FATAL_ERROR "eternal-convert failed on ${INPUT}: ${rv}")
+endif()
+
+execute_process(
+	COMMAND ${CMAKE_COMMAND} -E compare_files ${OUTPUT} ${EXPECTED}
+	RESULT_VARIABLE rv
+)
+if(NOT rv EQUAL 0)
+	message(FATAL_ERROR "${OUTPUT} differs from ${EXPECTED}")
+endif()
@@ -1,14 +1,13 @@
 
 #include <eternal_timestamp/eternal_timestamp.h>
+#include <eternal_timestamp/eternal_timestamp_format.h>
 
 #if defined(_WIN32)
 #include <crtdbg.h>
 #endif
 #include <algorithm>
 #include <format>
-#include <iomanip>
 #include <iostream>
-#include <sstream>
 #include <string_view>
 
 #include "monolithic_examples.h"
@@ -44,21 +43,24 @@ struct std::formatter<eternal_timestamp_t, CharT>
 	template<class FmtContext>
 	FmtContext::iterator format(eternal_timestamp_t t, FmtContext& ctx) const
 	{
-		std::ostringstream rv;
-		eternal_time_tm tm;
-		if (!EternalTimestamp::cvt_to_timeinfo_struct(tm, t)) {
-			rv << (EternalTimestamp::is_modern_format(t) ? "(Modern)" : "(PreHistoric)") << "" << tm.year << "." << tm.month << "." << tm.day << "(T)" << std::format("{:02}", tm.hour) << ":" << std::format("{:02}", tm.minute) << ":" << std::format("{:02}", tm.seconds) << "." << std::format("{:03}", tm.milliseconds) << "." << std::format("{:03}", tm.microseconds);
-		}
-		else {
-			rv << "(Invalid EternalTimestamp; Cannot Parse " << std::format("{:#016x}", t.t) << ")";
-		}
-		std::ostringstream out;
-		if (quoted)
-			out << std::quoted(rv.str());
-		else
-			out << rv.str();
-
-		return std::ranges::copy(std::move(out).str(), ctx.out()).out;
+		// compiled once; rendering doesn't allocate.
+		static const ets_format_pattern_t pattern = [] {
+			ets_format_pattern_t p;
+			EternalTimestampFormat::compile(p, ETS_FORMAT_ISO8601);
+			return p;
+		}();
+
+		// leave room for the quotes around the text.
+		char buf[128];
+		size_t n = EternalTimestampFormat::format(buf + 1, sizeof(buf) - 2, pattern, t);
+		if (n > sizeof(buf) - 3)
+			n = sizeof(buf) - 3;
+		if (!quoted)
+			return std::ranges::copy(std::string_view(buf + 1, n), ctx.out()).out;
+
+		buf[0] = '"';
+		buf[n + 1] = '"';
+		return std::ranges::copy(std::string_view(buf, n + 2), ctx.out()).out;
 	}
 };
 
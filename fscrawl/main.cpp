@@ -0,0 +1,335 @@
+// eternal-fscrawl: list the file system metadata of (large) directory trees, with eternal timestamps.
+//
+// The trees are walked in parallel by `EternalTimestampFsCrawl`, which reads the access, modification, status
+// change and birth times at microsecond precision. Each entry becomes a CSV row or an NDJSON object with its
+// path, type, size and times; the times are rendered as ISO 8601 text (UTC) or, with `-n`, as the decimal
+// `eternal_timestamp_t` value. Birth times which the file system doesn't record are left empty (CSV) or null
+// (NDJSON).
+//
+// Entries are written in the order the crawler produces them, which is not sorted.
+
+#include <eternal_timestamp/eternal_timestamp.h>
+#include <eternal_timestamp/eternal_timestamp_format.h>
+#include <eternal_timestamp/eternal_timestamp_fscrawl.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <sys/stat.h>
+#endif
+
+#include "monolithic_examples.h"
+
+
+using namespace eternal_timestamp;
+
+
+namespace
+{
+	enum output_format
+	{
+		FORMAT_CSV,
+		FORMAT_NDJSON,
+	};
+
+	struct options
+	{
+		output_format format = FORMAT_CSV;
+		unsigned int flags = 0;
+		bool numeric = false;
+		bool header = true;
+		unsigned int parallelism = ETS_PARALLELISM_ALL;
+		bool verbose = false;
+		const char *output = nullptr;
+		std::vector<const char *> roots;
+	};
+
+	struct writer
+	{
+		const options *opt;
+		FILE *out;
+		ets_format_pattern_t pattern;
+		std::string buf;
+		bool failed = false;
+	};
+
+	const char *type_name(uint32_t mode)
+	{
+#if !defined(_WIN32)
+		switch (mode & S_IFMT) {
+		case S_IFREG: return "file";
+		case S_IFDIR: return "dir";
+		case S_IFLNK: return "link";
+		case S_IFIFO: return "fifo";
+		case S_IFSOCK: return "socket";
+		case S_IFCHR: return "char";
+		case S_IFBLK: return "block";
+		}
+#endif
+		(void)mode;
+		return "other";
+	}
+
+	void append_csv_text(std::string &buf, const char *s, size_t length)
+	{
+		if (strcspn(s, ",\"\r\n") >= length) {
+			buf.append(s, length);
+			return;
+		}
+		buf += '"';
+		for (size_t i = 0; i < length; i++) {
+			if (s[i] == '"')
+				buf += '"';
+			buf += s[i];
+		}
+		buf += '"';
+	}
+
+	void append_json_text(std::string &buf, const char *s, size_t length)
+	{
+		buf += '"';
+		for (size_t i = 0; i < length; i++) {
+			const unsigned char c = static_cast<unsigned char>(s[i]);
+			if (c == '"' || c == '\\') {
+				buf += '\\';
+				buf += static_cast<char>(c);
+			}
+			else if (c < 0x20) {
+				char esc[8];
+				snprintf(esc, sizeof(esc), "\\u%04x", c);
+				buf += esc;
+			}
+			else {
+				buf += static_cast<char>(c);
+			}
+		}
+		buf += '"';
+	}
+
+	void append_time(writer &w, const eternal_timestamp_t t)
+	{
+		const bool json = (w.opt->format == FORMAT_NDJSON);
+		if (t.t == ets_unknown().t) {
+			if (json)
+				w.buf += "null";
+			return;
+		}
+		char text[ETS_FORMAT_MAX_LITERALS + 64];
+		if (w.opt->numeric) {
+			snprintf(text, sizeof(text), "%" PRIu64, t.t);
+			w.buf += text;
+			return;
+		}
+		const size_t n = EternalTimestampFormat::format(text, sizeof(text), w.pattern, t);
+		if (json)
+			w.buf += '"';
+		w.buf.append(text, n < sizeof(text) ? n : sizeof(text) - 1);
+		if (json)
+			w.buf += '"';
+	}
+
+	int write_entries(void *context, const ets_fscrawl_entry_t *entries, size_t count)
+	{
+		writer &w = *static_cast<writer *>(context);
+		const bool json = (w.opt->format == FORMAT_NDJSON);
+		char num[32];
+		w.buf.clear();
+		for (size_t i = 0; i < count; i++) {
+			const ets_fscrawl_entry_t &e = entries[i];
+			snprintf(num, sizeof(num), "%" PRIu64, e.size);
+			if (json) {
+				w.buf += "{\"path\":";
+				append_json_text(w.buf, e.path, e.path_length);
+				w.buf += ",\"type\":\"";
+				w.buf += type_name(e.mode);
+				w.buf += "\",\"size\":";
+				w.buf += num;
+				w.buf += ",\"atime\":";
+				append_time(w, e.atime);
+				w.buf += ",\"mtime\":";
+				append_time(w, e.mtime);
+				w.buf += ",\"ctime\":";
+				append_time(w, e.ctime);
+				w.buf += ",\"btime\":";
+				append_time(w, e.btime);
+				w.buf += "}\n";
+			}
+			else {
+				append_csv_text(w.buf, e.path, e.path_length);
+				w.buf += ',';
+				w.buf += type_name(e.mode);
+				w.buf += ',';
+				w.buf += num;
+				w.buf += ',';
+				append_time(w, e.atime);
+				w.buf += ',';
+				append_time(w, e.mtime);
+				w.buf += ',';
+				append_time(w, e.ctime);
+				w.buf += ',';
+				append_time(w, e.btime);
+				w.buf += '\n';
+			}
+		}
+		if (fwrite(w.buf.data(), 1, w.buf.size(), w.out) != w.buf.size()) {
+			w.failed = true;
+			return 1;
+		}
+		return 0;
+	}
+
+
+	//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// command line
+	//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	void usage()
+	{
+		fprintf(stderr,
+			"Usage: eternal-fscrawl [options] root [root ...]\n"
+			"\n"
+			"List the entries of directory trees with their times as eternal timestamps.\n"
+			"\n"
+			"Options:\n"
+			"  -f format   output format: 'csv' or 'ndjson'; default: 'csv'.\n"
+			"  -o file     write to this file instead of stdout.\n"
+			"  -n          write the times as decimal eternal_timestamp_t values instead of ISO 8601 text.\n"
+			"  -N          no CSV header line.\n"
+			"  -L          follow symbolic links.\n"
+			"  -x          stay on the file system of each root.\n"
+			"  -s          skip hidden entries (names starting with '.') and what is below them.\n"
+			"  -j threads  number of crawler threads; default: the number of cores.\n"
+			"  -v          report the entry, directory and error counts.\n"
+			"\n"
+			"Statistics are reported on stderr.\n");
+	}
+
+	bool parse_options(int argc, const char **argv, options &opt)
+	{
+		int i = 1;
+		for (; i < argc && argv[i][0] == '-' && argv[i][1]; i++) {
+			const char *a = argv[i];
+			// option values may be attached (`-j4`) or separate (`-j 4`)
+			const bool attached = (a[2] != 0);
+			const char *val = (attached ? a + 2 : i + 1 < argc ? argv[i + 1] : nullptr);
+			switch (a[1]) {
+			case 'f':
+				if (!val)
+					return false;
+				if (!strcmp(val, "csv"))
+					opt.format = FORMAT_CSV;
+				else if (!strcmp(val, "ndjson") || !strcmp(val, "jsonl"))
+					opt.format = FORMAT_NDJSON;
+				else
+					return false;
+				i += !attached;
+				break;
+			case 'o':
+				if (!val)
+					return false;
+				opt.output = val;
+				i += !attached;
+				break;
+			case 'n':
+				opt.numeric = true;
+				break;
+			case 'N':
+				opt.header = false;
+				break;
+			case 'L':
+				opt.flags |= ETS_FSCRAWL_FOLLOW_SYMLINKS;
+				break;
+			case 'x':
+				opt.flags |= ETS_FSCRAWL_ONE_FILESYSTEM;
+				break;
+			case 's':
+				opt.flags |= ETS_FSCRAWL_SKIP_HIDDEN;
+				break;
+			case 'j':
+				if (!val || atoi(val) <= 0)
+					return false;
+				opt.parallelism = static_cast<unsigned int>(atoi(val));
+				i += !attached;
+				break;
+			case 'v':
+				opt.verbose = true;
+				break;
+			default:
+				return false;
+			}
+		}
+		for (; i < argc; i++)
+			opt.roots.push_back(argv[i]);
+		return !opt.roots.empty();
+	}
+}
+
+
+#if defined(BUILD_MONOLITHIC)
+#define main(cnt, arr)      eternalty_fscrawl_main(cnt, arr)
+#endif
+
+int main(int argc, const char **argv)
+{
+	options opt;
+	if (!parse_options(argc, argv, opt)) {
+		usage();
+		return EXIT_FAILURE;
+	}
+
+	writer w;
+	w.opt = &opt;
+	w.out = (opt.output ? fopen(opt.output, "w") : stdout);
+	if (!w.out) {
+		fprintf(stderr, "eternal-fscrawl: cannot create '%s'\n", opt.output);
+		return EXIT_FAILURE;
+	}
+	if (EternalTimestampFormat::compile(w.pattern, "%F[T%T[.%f]]Z") != 0) {
+		fprintf(stderr, "eternal-fscrawl: internal error: bad time format\n");
+		return EXIT_FAILURE;
+	}
+	if (opt.format == FORMAT_CSV && opt.header)
+		fputs("path,type,size,atime,mtime,ctime,btime\n", w.out);
+
+	const auto started = std::chrono::steady_clock::now();
+	ets_fscrawl_stats_t total = { 0, 0, 0 };
+	int rv = EXIT_SUCCESS;
+	for (const char *root : opt.roots) {
+		ets_fscrawl_stats_t stats;
+		if (EternalTimestampFsCrawl::crawl(root, opt.flags, write_entries, &w, &stats, opt.parallelism) != 0) {
+			if (w.failed) {
+				fprintf(stderr, "eternal-fscrawl: error writing the output\n");
+				return EXIT_FAILURE;
+			}
+			fprintf(stderr, "eternal-fscrawl: cannot read '%s': %s\n", root, strerror(errno));
+			rv = EXIT_FAILURE;
+		}
+		total.entries += stats.entries;
+		total.directories += stats.directories;
+		total.errors += stats.errors;
+	}
+
+	if (w.out != stdout) {
+		if (fclose(w.out) != 0) {
+			fprintf(stderr, "eternal-fscrawl: error writing the output\n");
+			return EXIT_FAILURE;
+		}
+	}
+	else {
+		fflush(w.out);
+	}
+
+	if (opt.verbose) {
+		const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+		fprintf(stderr, "eternal-fscrawl: %" PRIu64 " entries, %" PRIu64 " directories, %" PRIu64 " errors in %.3f s: %.0f entries/s\n",
+			total.entries, total.directories, total.errors, elapsed, (elapsed > 0 ? static_cast<double>(total.entries) / elapsed : 0.0));
+	}
+	return rv;
+}
@@ -4,6 +4,7 @@
 #ifndef __ETERNAL_TIMESTAMP_H__
 #define __ETERNAL_TIMESTAMP_H__
 
+#include <stddef.h>
 #include <stdint.h>
 
 #if defined(__cplusplus)
@@ -61,6 +62,230 @@ union eternal_timestamp_u
 };
 typedef union eternal_timestamp_u eternal_timestamp_t;
 
+// Where the fields live in `eternal_timestamp_t::t`: bit positions and widths.
+//
+// The bitfield structs above document the layout, but how bitfields are allocated is up to the compiler, e.g.
+// the `unsigned` fields of `eternal_prehistoric_timestamp` which follow its `uint64_t` one don't end up in the
+// same place everywhere. So the library reads and writes the fields through the accessors below, which go by
+// these numbers with shifts and masks on the raw value and fold into a single shift-and-mask each; prefer them
+// over the bitfields in your own code as well.
+enum eternal_timestamp_field_layout
+{
+	ETS_SIGN_SHIFT = 0,
+	ETS_SIGN_BITS = 1,
+	ETS_MODE_SHIFT = 1,
+	ETS_MODE_BITS = 1,
+
+	ETMT_CENTURY_SHIFT = 2,
+	ETMT_CENTURY_BITS = 9,
+	ETMT_YEAR_SHIFT = 11,
+	ETMT_YEAR_BITS = 7,
+	ETMT_MONTH_SHIFT = 18,
+	ETMT_MONTH_BITS = 4,
+	ETMT_DAY_SHIFT = 22,
+	ETMT_DAY_BITS = 5,
+	ETMT_HOUR_SHIFT = 27,
+	ETMT_HOUR_BITS = 5,
+	ETMT_MINUTE_SHIFT = 32,
+	ETMT_MINUTE_BITS = 6,
+	ETMT_SECONDS_SHIFT = 38,
+	ETMT_SECONDS_BITS = 6,
+	ETMT_MILLISECONDS_SHIFT = 44,
+	ETMT_MILLISECONDS_BITS = 10,
+	ETMT_MICROSECONDS_SHIFT = 54,
+	ETMT_MICROSECONDS_BITS = 10,
+
+	ETPHT_YEARS_SHIFT = 2,
+	ETPHT_YEARS_BITS = 38,
+	ETPHT_MONTH_SHIFT = 40,
+	ETPHT_MONTH_BITS = 4,
+	ETPHT_DAY_SHIFT = 44,
+	ETPHT_DAY_BITS = 5,
+	ETPHT_HOUR_SHIFT = 49,
+	ETPHT_HOUR_BITS = 5,
+	ETPHT_MINUTE_SHIFT = 54,
+	ETPHT_MINUTE_BITS = 6,
+	ETPHT_PRECISION_SHIFT = 60,
+	ETPHT_PRECISION_BITS = 4,
+};
+
+// The code which marks a field of `bits` bits as 'unspecified'.
+#if ETS_UNSPECIFIED_MARKER_SORTS_BEFORE_1ST_VALUE
+#define ETS_UNSPECIFIED_CODE(bits)      0ULL
+#else
+#define ETS_UNSPECIFIED_CODE(bits)      (~0ULL >> (64 - (bits)))
+#endif
+
+// `ETS_TIMESTAMP(raw)` produces the timestamp with the given raw 64-bit value as an expression, so that the
+// inline functions below can stay single `return` statements, as C++11 `constexpr` demands.
+#if defined(__cplusplus)
+#define ETS_CONSTEXPR                   constexpr
+#define ETS_TIMESTAMP(raw)              (eternal_timestamp_t{ (uint64_t)(raw) })
+#else
+#define ETS_CONSTEXPR
+#define ETS_TIMESTAMP(raw)              ((eternal_timestamp_t){ (uint64_t)(raw) })
+#endif
+
+// X(subformat, field, NAME): all fields, `NAME_SHIFT` and `NAME_BITS` giving their position and width.
+#define ETS_FIELDS(X) \
+	X(format, sign, ETS_SIGN) \
+	X(format, mode, ETS_MODE) \
+	X(modern, century, ETMT_CENTURY) \
+	X(modern, year, ETMT_YEAR) \
+	X(modern, month, ETMT_MONTH) \
+	X(modern, day, ETMT_DAY) \
+	X(modern, hour, ETMT_HOUR) \
+	X(modern, minute, ETMT_MINUTE) \
+	X(modern, seconds, ETMT_SECONDS) \
+	X(modern, milliseconds, ETMT_MILLISECONDS) \
+	X(modern, microseconds, ETMT_MICROSECONDS) \
+	X(prehistoric, years, ETPHT_YEARS) \
+	X(prehistoric, month, ETPHT_MONTH) \
+	X(prehistoric, day, ETPHT_DAY) \
+	X(prehistoric, hour, ETPHT_HOUR) \
+	X(prehistoric, minute, ETPHT_MINUTE) \
+	X(prehistoric, precision, ETPHT_PRECISION)
+
+// `ets_<subformat>_<field>(t)` produces the code stored in the field, e.g. `ets_modern_century(t)`;
+// `ets_<subformat>_set_<field>(t, code)` produces `t` with the field set to `code`.
+#define ETS_DEFINE_FIELD_ACCESSORS(subformat, field, NAME) \
+	static ETS_CONSTEXPR inline uint64_t ets_##subformat##_##field(const eternal_timestamp_t t) \
+	{ \
+		return (t.t >> NAME##_SHIFT) & (~0ULL >> (64 - NAME##_BITS)); \
+	} \
+	static ETS_CONSTEXPR inline eternal_timestamp_t ets_##subformat##_set_##field(const eternal_timestamp_t t, const uint64_t code) \
+	{ \
+		return ETS_TIMESTAMP((t.t & ~((~0ULL >> (64 - NAME##_BITS)) << NAME##_SHIFT)) | ((code & (~0ULL >> (64 - NAME##_BITS))) << NAME##_SHIFT)); \
+	}
+
+ETS_FIELDS(ETS_DEFINE_FIELD_ACCESSORS)
+
+#undef ETS_DEFINE_FIELD_ACCESSORS
+
+// The predicates behind `EternalTimestamp::has_century()` and friends, and their C counterparts.
+static ETS_CONSTEXPR inline int ets_inline_is_modern_format(const eternal_timestamp_t t)
+{
+	return !ets_format_mode(t);
+}
+
+static ETS_CONSTEXPR inline int ets_inline_is_prehistoric_format(const eternal_timestamp_t t)
+{
+	return !!ets_format_mode(t);
+}
+
+// Known to within a century for prehistoric timestamps, i.e. a precision of 10^2 or better: otherwise we'ld be
+// talking about *millennia* or *aeons*.
+static ETS_CONSTEXPR inline int ets_inline_has_century(const eternal_timestamp_t t)
+{
+	return ets_inline_is_modern_format(t)
+		? ets_modern_century(t) != ETS_UNSPECIFIED_CODE(ETMT_CENTURY_BITS)
+		: ets_prehistoric_years(t) != ETS_UNSPECIFIED_CODE(ETPHT_YEARS_BITS) && ets_prehistoric_precision(t) < 3;
+}
+
+// Known to the year for prehistoric timestamps, i.e. a precision of 10^1 or better.
+static ETS_CONSTEXPR inline int ets_inline_has_year(const eternal_timestamp_t t)
+{
+	return ets_inline_is_modern_format(t)
+		? ets_modern_year(t) != ETS_UNSPECIFIED_CODE(ETMT_YEAR_BITS)
+		: ets_prehistoric_years(t) != ETS_UNSPECIFIED_CODE(ETPHT_YEARS_BITS) && ets_prehistoric_precision(t) < 2;
+}
+
+static ETS_CONSTEXPR inline int ets_inline_has_century_and_year(const eternal_timestamp_t t)
+{
+	return ets_inline_has_century(t) && ets_inline_has_year(t);
+}
+
+// Known to *any* precision at all: the more appropriate question for prehistoric timestamps.
+static ETS_CONSTEXPR inline int ets_inline_has_age(const eternal_timestamp_t t)
+{
+	return ets_inline_is_modern_format(t)
+		? ets_inline_has_century_and_year(t)
+		: ets_prehistoric_years(t) != ETS_UNSPECIFIED_CODE(ETPHT_YEARS_BITS);
+}
+
+static ETS_CONSTEXPR inline int ets_inline_has_month(const eternal_timestamp_t t)
+{
+	return ets_inline_is_modern_format(t)
+		? ets_modern_month(t) != ETS_UNSPECIFIED_CODE(ETMT_MONTH_BITS)
+		: ets_prehistoric_month(t) != ETS_UNSPECIFIED_CODE(ETPHT_MONTH_BITS);
+}
+
+static ETS_CONSTEXPR inline int ets_inline_has_day(const eternal_timestamp_t t)
+{
+	return ets_inline_is_modern_format(t)
+		? ets_modern_day(t) != ETS_UNSPECIFIED_CODE(ETMT_DAY_BITS)
+		: ets_prehistoric_day(t) != ETS_UNSPECIFIED_CODE(ETPHT_DAY_BITS);
+}
+
+static ETS_CONSTEXPR inline int ets_inline_has_hour(const eternal_timestamp_t t)
+{
+	return ets_inline_is_modern_format(t)
+		? ets_modern_hour(t) != ETS_UNSPECIFIED_CODE(ETMT_HOUR_BITS)
+		: ets_prehistoric_hour(t) != ETS_UNSPECIFIED_CODE(ETPHT_HOUR_BITS);
+}
+
+static ETS_CONSTEXPR inline int ets_inline_has_minute(const eternal_timestamp_t t)
+{
+	return ets_inline_is_modern_format(t)
+		? ets_modern_minute(t) != ETS_UNSPECIFIED_CODE(ETMT_MINUTE_BITS)
+		: ets_prehistoric_minute(t) != ETS_UNSPECIFIED_CODE(ETPHT_MINUTE_BITS);
+}
+
+// Prehistoric timestamps don't carry seconds or anything more precise.
+static ETS_CONSTEXPR inline int ets_inline_has_seconds(const eternal_timestamp_t t)
+{
+	return ets_inline_is_modern_format(t) && ets_modern_seconds(t) != ETS_UNSPECIFIED_CODE(ETMT_SECONDS_BITS);
+}
+
+static ETS_CONSTEXPR inline int ets_inline_has_milliseconds(const eternal_timestamp_t t)
+{
+	return ets_inline_is_modern_format(t) && ets_modern_milliseconds(t) != ETS_UNSPECIFIED_CODE(ETMT_MILLISECONDS_BITS);
+}
+
+static ETS_CONSTEXPR inline int ets_inline_has_microseconds(const eternal_timestamp_t t)
+{
+	return ets_inline_is_modern_format(t) && ets_modern_microseconds(t) != ETS_UNSPECIFIED_CODE(ETMT_MICROSECONDS_BITS);
+}
+
+// A *technical* question: are all date fields there, so we can use them without fear of running into
+// 'unspecified' markers? Prehistoric timestamps must then be known to the year precise (precision 0).
+static ETS_CONSTEXPR inline int ets_inline_has_complete_date(const eternal_timestamp_t t)
+{
+	return (ets_inline_is_modern_format(t)
+			? ets_inline_has_century_and_year(t)
+			: ets_prehistoric_years(t) != ETS_UNSPECIFIED_CODE(ETPHT_YEARS_BITS) && ets_prehistoric_precision(t) == 0)
+		&& ets_inline_has_month(t) && ets_inline_has_day(t);
+}
+
+// Ditto for all time fields the subformat has.
+static ETS_CONSTEXPR inline int ets_inline_has_time(const eternal_timestamp_t t)
+{
+	return ets_inline_has_hour(t) && ets_inline_has_minute(t)
+		&& (ets_inline_is_prehistoric_format(t) || (ets_inline_has_seconds(t) && ets_inline_has_milliseconds(t) && ets_inline_has_microseconds(t)));
+}
+
+// We accept that prehistoric timestamps don't come with *seconds*...
+static ETS_CONSTEXPR inline int ets_inline_has_hh_mm_ss(const eternal_timestamp_t t)
+{
+	return ets_inline_has_hour(t) && ets_inline_has_minute(t) && (ets_inline_is_prehistoric_format(t) || ets_inline_has_seconds(t));
+}
+
+// A timestamp with all fields set to 'unspecified'.
+static ETS_CONSTEXPR inline eternal_timestamp_t ets_inline_unknown(void)
+{
+	return ETS_TIMESTAMP(
+		(ETS_UNSPECIFIED_CODE(ETMT_CENTURY_BITS) << ETMT_CENTURY_SHIFT)
+		| (ETS_UNSPECIFIED_CODE(ETMT_YEAR_BITS) << ETMT_YEAR_SHIFT)
+		| (ETS_UNSPECIFIED_CODE(ETMT_MONTH_BITS) << ETMT_MONTH_SHIFT)
+		| (ETS_UNSPECIFIED_CODE(ETMT_DAY_BITS) << ETMT_DAY_SHIFT)
+		| (ETS_UNSPECIFIED_CODE(ETMT_HOUR_BITS) << ETMT_HOUR_SHIFT)
+		| (ETS_UNSPECIFIED_CODE(ETMT_MINUTE_BITS) << ETMT_MINUTE_SHIFT)
+		| (ETS_UNSPECIFIED_CODE(ETMT_SECONDS_BITS) << ETMT_SECONDS_SHIFT)
+		| (ETS_UNSPECIFIED_CODE(ETMT_MILLISECONDS_BITS) << ETMT_MILLISECONDS_SHIFT)
+		| (ETS_UNSPECIFIED_CODE(ETMT_MICROSECONDS_BITS) << ETMT_MICROSECONDS_SHIFT)
+	);
+}
+
 
 // the timestamp as a bunch of integer fields for general easy access, akin to `struct tm`:
 struct eternal_time_tm
@@ -119,7 +344,10 @@ namespace eternal_timestamp
 		static eternal_timestamp_t today_at(int hour = 0, int minute = 0, int second = 0);
 
 		// produce a timestamp that has all fields set to 'not specified':
-		static constexpr inline eternal_timestamp_t unknown();
+		static constexpr inline eternal_timestamp_t unknown()
+		{
+			return ets_inline_unknown();
+		}
 
 		// return `true` when the given timestamp is *probably* legal/valid: this is a fast check
 		// which does not expend the additional effort to precisely check the validity of the year/month/day combo,
@@ -164,27 +392,81 @@ namespace eternal_timestamp
 		// convert a partial timestamp by rebasing it against the given base timestamp
 		static eternal_timestamp_t normalize(const eternal_timestamp_t t, const eternal_timestamp_t base);
 
-		static bool has_century(const eternal_timestamp_t t);
-		static bool has_year(const eternal_timestamp_t t);
-		static bool has_century_and_year(const eternal_timestamp_t t);
+		static constexpr inline bool has_century(const eternal_timestamp_t t)
+		{
+			return ets_inline_has_century(t);
+		}
+		static constexpr inline bool has_year(const eternal_timestamp_t t)
+		{
+			return ets_inline_has_year(t);
+		}
+		static constexpr inline bool has_century_and_year(const eternal_timestamp_t t)
+		{
+			return ets_inline_has_century_and_year(t);
+		}
 		// and probably more appropriate for *prehistoric* dates to ask: do we know the year to *any* precision at all?
-		static bool has_age(const eternal_timestamp_t t);
-		static bool has_month(const eternal_timestamp_t t);
-		static bool has_day(const eternal_timestamp_t t);
-		static bool has_hour(const eternal_timestamp_t t);
-		static bool has_minute(const eternal_timestamp_t t);
-		static bool has_seconds(const eternal_timestamp_t t);
-		static bool has_milliseconds(const eternal_timestamp_t t);
-		static bool has_microseconds(const eternal_timestamp_t t);
-		static bool has_complete_date(const eternal_timestamp_t t);
-		static bool has_time(const eternal_timestamp_t t);
-		static bool has_hh_mm_ss(const eternal_timestamp_t t);
-
-		static bool is_modern_format(const eternal_timestamp_t t);
-		static bool is_prehistoric_format(const eternal_timestamp_t t);
+		static constexpr inline bool has_age(const eternal_timestamp_t t)
+		{
+			return ets_inline_has_age(t);
+		}
+		static constexpr inline bool has_month(const eternal_timestamp_t t)
+		{
+			return ets_inline_has_month(t);
+		}
+		static constexpr inline bool has_day(const eternal_timestamp_t t)
+		{
+			return ets_inline_has_day(t);
+		}
+		static constexpr inline bool has_hour(const eternal_timestamp_t t)
+		{
+			return ets_inline_has_hour(t);
+		}
+		static constexpr inline bool has_minute(const eternal_timestamp_t t)
+		{
+			return ets_inline_has_minute(t);
+		}
+		static constexpr inline bool has_seconds(const eternal_timestamp_t t)
+		{
+			return ets_inline_has_seconds(t);
+		}
+		static constexpr inline bool has_milliseconds(const eternal_timestamp_t t)
+		{
+			return ets_inline_has_milliseconds(t);
+		}
+		static constexpr inline bool has_microseconds(const eternal_timestamp_t t)
+		{
+			return ets_inline_has_microseconds(t);
+		}
+		static constexpr inline bool has_complete_date(const eternal_timestamp_t t)
+		{
+			return ets_inline_has_complete_date(t);
+		}
+		static constexpr inline bool has_time(const eternal_timestamp_t t)
+		{
+			return ets_inline_has_time(t);
+		}
+		static constexpr inline bool has_hh_mm_ss(const eternal_timestamp_t t)
+		{
+			return ets_inline_has_hh_mm_ss(t);
+		}
+
+		static constexpr inline bool is_modern_format(const eternal_timestamp_t t)
+		{
+			return ets_inline_is_modern_format(t);
+		}
+		static constexpr inline bool is_prehistoric_format(const eternal_timestamp_t t)
+		{
+			return ets_inline_is_prehistoric_format(t);
+		}
 
 		static int64_t calc_time_fast_delta(const eternal_timestamp_t t1, const eternal_timestamp_t t2);
 
+		// produce a signed 64-bit key which orders all timestamps, modern and prehistoric alike, by time:
+		// older timestamps produce smaller keys. Prehistoric timestamps produce negative keys.
+		//
+		// This is a pure function of the timestamp value, so you can use it as an index expression in databases.
+		static int64_t calc_sort_key(const eternal_timestamp_t t);
+
 		// return a improved attempt at producing the number of days between two values as a floating point
 		// value.
 		//
@@ -229,12 +511,31 @@ namespace eternal_timestamp
 
 		static int cvt_from_proleptic_real(eternal_timestamp_t &dst, const double t);
 
+		// Parse an ISO 8601 / RFC 3339 date or date+time string of `length` characters (no terminating NUL required):
+		//
+		// - date: `YYYY`, `YYYY-MM`, `YYYY-MM-DD` or `YYYYMMDD`; the year may be written as an expanded year
+		//   `(+|-)YYYYY...` (4 to 12 digits) to reach deep into the past;
+		// - time: `T` (or a space) followed by `hh[:mm[:ss[.ffffff]]]` or `hh[mm[ss[.ffffff]]]`;
+		// - zone: `Z` or `(+|-)hh[[:]mm]`.
+		//
+		// Reduced precision input produces a partial timestamp: all fields which were not specified are marked
+		// 'unspecified', e.g. "2022-01" produces a timestamp carrying only century, year and month. Fractional
+		// seconds specify the milliseconds when 1..3 digits are given and the microseconds as well when more
+		// digits are given; any digits beyond the sixth are ignored. Times with a zone are converted to UTC.
+		// Years before 9900 BC produce prehistoric timestamps, which don't carry seconds or anything more precise.
+		//
+		// Returns 0 on success, -1 when the string is not a valid timestamp.
+		static int cvt_from_iso8601(eternal_timestamp_t &dst, const char *str, size_t length);
+		// The reference implementation of `cvt_from_iso8601()`: same results, without the SIMD fast path.
+		static int cvt_from_iso8601_scalar(eternal_timestamp_t &dst, const char *str, size_t length);
+
 		// return `true` when 'host' machine-native format is identical to the 'network' database format (Little Endian 64bit integer)
 		//
 		// when `false`, every timestamp loaded from external storage or transmitted through
 		// a network connection across machine boundaries must be converted to/from native
 		// layout by invoking the ntoh() and hton() methods before use. (This will be needed
-		// on Big Endian machines.)
+		// on Big Endian machines.) Buffers of timestamps, in either byte order and at any alignment, are best
+		// read and written through the views and bulk conversions of eternal_timestamp_endian.h.
 		static bool ntoh_is_an_empty_op(const eternal_timestamp_t t);
 		// convert timestamp as loaded from external storage or network message to native layout.
 		static eternal_timestamp_t ntoh(const eternal_timestamp_t t);
@@ -266,8 +567,31 @@ eternal_timestamp_t ets_now();
 eternal_timestamp_t ets_today();
 eternal_timestamp_t ets_today_at(int hour, int minute, int second);
 
+// The predicates and `ets_unknown()` are one shift-and-mask each on the raw value, see the `ets_inline_*()`
+// implementations above. Define `ETS_HEADER_ONLY` (or link against the `libs::libeternaltimestamp_headers` target)
+// to have them defined inline in this header, so they fold into your loops, rather than being calls into the library.
+#if defined(ETS_HEADER_ONLY)
+
+static ETS_CONSTEXPR inline eternal_timestamp_t ets_unknown(void)
+{
+	return ets_inline_unknown();
+}
+
+#define ETS_ACCESSOR(name) \
+	static ETS_CONSTEXPR inline BOOL ets_##name(const eternal_timestamp_t t) \
+	{ \
+		return ets_inline_##name(t); \
+	}
+
+#else
+
 eternal_timestamp_t ets_unknown();
 
+#define ETS_ACCESSOR(name) \
+	BOOL ets_##name(const eternal_timestamp_t t);
+
+#endif
+
 BOOL ets_is_valid(const eternal_timestamp_t t);
 int ets_validate(const eternal_timestamp_t t);
 int ets_validate_tm(const struct eternal_time_tm *ts);
@@ -275,26 +599,29 @@ BOOL ets_is_partial_timestamp(const eternal_timestamp_t t);
 
 eternal_timestamp_t ets_normalize(const eternal_timestamp_t t, const eternal_timestamp_t base);
 
-BOOL ets_has_century(const eternal_timestamp_t t);
-BOOL ets_has_year(const eternal_timestamp_t t);
-BOOL ets_has_century_and_year(const eternal_timestamp_t t);
-BOOL ets_has_age(const eternal_timestamp_t t);
-BOOL ets_has_month(const eternal_timestamp_t t);
-BOOL ets_has_day(const eternal_timestamp_t t);
-BOOL ets_has_hour(const eternal_timestamp_t t);
-BOOL ets_has_minute(const eternal_timestamp_t t);
-BOOL ets_has_seconds(const eternal_timestamp_t t);
-BOOL ets_has_milliseconds(const eternal_timestamp_t t);
-BOOL ets_has_microseconds(const eternal_timestamp_t t);
-BOOL ets_has_complete_date(const eternal_timestamp_t t);
-BOOL ets_has_time(const eternal_timestamp_t t);
-BOOL has_hh_mm_ss(const eternal_timestamp_t t);
-
-BOOL ets_is_modern_format(const eternal_timestamp_t t);
-BOOL ets_is_prehistoric_format(const eternal_timestamp_t t);
+ETS_ACCESSOR(has_century)
+ETS_ACCESSOR(has_year)
+ETS_ACCESSOR(has_century_and_year)
+ETS_ACCESSOR(has_age)
+ETS_ACCESSOR(has_month)
+ETS_ACCESSOR(has_day)
+ETS_ACCESSOR(has_hour)
+ETS_ACCESSOR(has_minute)
+ETS_ACCESSOR(has_seconds)
+ETS_ACCESSOR(has_milliseconds)
+ETS_ACCESSOR(has_microseconds)
+ETS_ACCESSOR(has_complete_date)
+ETS_ACCESSOR(has_time)
+ETS_ACCESSOR(has_hh_mm_ss)
+
+ETS_ACCESSOR(is_modern_format)
+ETS_ACCESSOR(is_prehistoric_format)
+
+#undef ETS_ACCESSOR
 
 int64_t ets_calc_time_fast_delta(const eternal_timestamp_t t1, const eternal_timestamp_t t2);
 double ets_calc_time_approx_delta(const eternal_timestamp_t t1, const eternal_timestamp_t t2);
+int64_t ets_calc_sort_key(const eternal_timestamp_t t);
 
 int ets_cvt_to_timeinfo_struct(struct eternal_time_tm *dst, const eternal_timestamp_t t);
 int ets_cvt_to_time_t(time_t *dst, const eternal_timestamp_t t);
@@ -319,6 +646,9 @@ int ets_cvt_from_etdb_real(eternal_timestamp_t *dst, const double t);
 
 int ets_cvt_from_proleptic_real(eternal_timestamp_t *dst, const double t);
 
+int ets_cvt_from_iso8601(eternal_timestamp_t *dst, const char *str, size_t length);
+int ets_cvt_from_iso8601_scalar(eternal_timestamp_t *dst, const char *str, size_t length);
+
 double ets_cvt_epoch_to_etdb_real_offset(const unsigned int year, const unsigned int month, const unsigned int day, const unsigned int hour, const unsigned int minute, const unsigned int second, const unsigned int subsecond);
 
 BOOL ets_ntoh_is_an_empty_op(const eternal_timestamp_t t);
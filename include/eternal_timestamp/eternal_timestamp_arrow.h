@@ -0,0 +1,155 @@
+
+#pragma once
+
+#ifndef __ETERNAL_TIMESTAMP_ARROW_H__
+#define __ETERNAL_TIMESTAMP_ARROW_H__
+
+// Apache Arrow C Data Interface import/export of timestamp columns.
+//
+// See https://arrow.apache.org/docs/format/CDataInterface.html: the interface is a pair of plain C structs,
+// hence no Arrow library is required to use this.
+//
+// Eternal timestamps are exported as the Arrow extension type `eternal.timestamp` with `int64` storage: the raw
+// `eternal_timestamp_t` bit patterns, shared with the consumer *without copying*. Consumers which don't know the
+// extension type will see a plain `int64` column.
+//
+// Next to that, we offer bulk conversions from/to the native Arrow `timestamp[us]`, `date32` and `date64` types.
+//
+// All functions return zero(0) on success and an `errno` value on failure, as is customary in the Arrow C interfaces:
+// `EINVAL` for unsupported types/layouts, `ENOMEM` when we cannot allocate the export buffers.
+
+#include "eternal_timestamp/eternal_timestamp.h"
+#include "eternal_timestamp/eternal_timestamp_parallel.h"
+
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+struct ArrowSchema {
+	// Array type description
+	const char* format;
+	const char* name;
+	const char* metadata;
+	int64_t flags;
+	int64_t n_children;
+	struct ArrowSchema** children;
+	struct ArrowSchema* dictionary;
+
+	// Release callback
+	void (*release)(struct ArrowSchema*);
+	// Opaque producer-specific data
+	void* private_data;
+};
+
+struct ArrowArray {
+	// Array data description
+	int64_t length;
+	int64_t null_count;
+	int64_t offset;
+	int64_t n_buffers;
+	int64_t n_children;
+	const void** buffers;
+	struct ArrowArray** children;
+	struct ArrowArray* dictionary;
+
+	// Release callback
+	void (*release)(struct ArrowArray*);
+	// Opaque producer-specific data
+	void* private_data;
+};
+
+#endif  // ARROW_C_DATA_INTERFACE
+
+#if defined(__cplusplus)
+}
+#endif
+
+// the name of our Arrow extension type, as stored in the `ARROW:extension:name` schema metadata.
+#define ETS_ARROW_EXTENSION_NAME            "eternal.timestamp"
+
+// Arrow format strings of the native Arrow types we convert from/to:
+#define ETS_ARROW_FORMAT_TIMESTAMP_US_UTC   "tsu:UTC"
+#define ETS_ARROW_FORMAT_DATE32             "tdD"
+#define ETS_ARROW_FORMAT_DATE64             "tdm"
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// C++ interface definitions
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if defined(__cplusplus)
+
+namespace eternal_timestamp
+{
+	class EternalTimestampArrow
+	{
+	public:
+		// Export `length` timestamps *without copying* as an `eternal.timestamp` extension array.
+		//
+		// `validity` is an optional (may be NULL) Arrow validity bitmap, which is shared as well.
+		// The `values` and `validity` buffers MUST remain valid until the consumer releases the array, at
+		// which time `release_owner(owner)` is invoked (when `release_owner` is not NULL) so you can free them.
+		//
+		// On success the caller owns both `schema` and `array` and must hand them to a consumer or release them.
+		static int export_array(struct ArrowSchema &schema, struct ArrowArray &array, const eternal_timestamp_t *values, const uint8_t *validity, int64_t length, void (*release_owner)(void *owner), void *owner);
+
+		// Produce a *zero-copy* view of an imported `eternal.timestamp` (or plain `int64`) array.
+		//
+		// `values` points at the first element, i.e. we've already applied the array `offset`.
+		// `validity` is NULL when the array has no validity bitmap; otherwise you must apply `validity_offset`
+		// (the array `offset`) when testing the bits.
+		//
+		// The view remains valid until you release the array.
+		static int import_array(const eternal_timestamp_t *&values, const uint8_t *&validity, int64_t &validity_offset, int64_t &length, const struct ArrowSchema &schema, const struct ArrowArray &array);
+
+		// Convert an Arrow `timestamp[us]` (any timezone: the stored values are UTC), `date32`, `date64`
+		// or `eternal.timestamp` array into `dst`, which must have room for `array.length` timestamps.
+		//
+		// `date32` values produce date-only timestamps: their time-of-day fields are marked 'unspecified'.
+		// Null entries, and values beyond the modern range (9901 BC up to 41199 AD), produce timestamps with all
+		// fields 'unspecified'.
+		//
+		// `parallelism`: see eternal_timestamp_parallel.h.
+		static int cvt_from_array(eternal_timestamp_t *dst, const struct ArrowSchema &schema, const struct ArrowArray &array, unsigned int parallelism = ETS_PARALLELISM_DEFAULT);
+
+		// Convert `length` timestamps to a newly allocated Arrow array of the given type `format`, which is
+		// one of `ETS_ARROW_FORMAT_TIMESTAMP_US_UTC`, `ETS_ARROW_FORMAT_DATE32` or `ETS_ARROW_FORMAT_DATE64`.
+		//
+		// Timestamps which cannot be represented in the target type (prehistoric ones, those lacking any of the
+		// century, year, month or day fields, or those with a field out of range, e.g. February 31st) become null
+		// entries; unspecified time-of-day fields are taken as zero(0).
+		// `parallelism`: see eternal_timestamp_parallel.h.
+		//
+		// On success the caller owns both `schema` and `array` and must hand them to a consumer or release them.
+		static int cvt_to_array(struct ArrowSchema &schema, struct ArrowArray &array, const char *format, const eternal_timestamp_t *src, int64_t length, unsigned int parallelism = ETS_PARALLELISM_DEFAULT);
+	};
+}
+
+#endif // __cplusplus
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// C interface definitions
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+int ets_arrow_export_array(struct ArrowSchema *schema, struct ArrowArray *array, const eternal_timestamp_t *values, const uint8_t *validity, int64_t length, void (*release_owner)(void *owner), void *owner);
+int ets_arrow_import_array(const eternal_timestamp_t **values, const uint8_t **validity, int64_t *validity_offset, int64_t *length, const struct ArrowSchema *schema, const struct ArrowArray *array);
+int ets_arrow_cvt_from_array(eternal_timestamp_t *dst, const struct ArrowSchema *schema, const struct ArrowArray *array);
+int ets_arrow_cvt_to_array(struct ArrowSchema *schema, struct ArrowArray *array, const char *format, const eternal_timestamp_t *src, int64_t length);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif // __ETERNAL_TIMESTAMP_ARROW_H__
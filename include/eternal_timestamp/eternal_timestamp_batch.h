@@ -0,0 +1,127 @@
+
+#pragma once
+
+#ifndef __ETERNAL_TIMESTAMP_BATCH_H__
+#define __ETERNAL_TIMESTAMP_BATCH_H__
+
+#include "eternal_timestamp/eternal_timestamp.h"
+#include "eternal_timestamp/eternal_timestamp_parallel.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+// the longest text produced by `cvt_to_rfc3339_column()`: "+41099-12-31T23:59:59.999999Z"
+#define ETS_BATCH_RFC3339_MAX_LENGTH    29
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// C++ interface definitions
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if defined(__cplusplus)
+
+namespace eternal_timestamp
+{
+	// Bulk conversions: each of these processes an entire column of values in one call.
+	//
+	// Input values are expected to be mostly sorted or at least clustered in time, e.g. log records, database
+	// columns: the kernels exploit that by caching the calendar calculus for the last seen day.
+	//
+	// `validity` bitmaps use the Apache Arrow layout: bit `i % 8` of byte `i / 8` is set when value `i` is valid.
+	// Any `validity` argument MAY be NULL when you're not interested.
+	//
+	// `parallelism` is the number of threads a call may use: see eternal_timestamp_parallel.h.
+	class EternalTimestampBatch
+	{
+	public:
+		// convert microseconds / milliseconds / seconds since 1970/jan/01 00:00:00 UTC to complete modern timestamps.
+		//
+		// Values beyond the modern range (9901 BC up to 41199 AD) produce a timestamp with all fields 'unspecified'
+		// and have their `validity` bit cleared; all others have their `validity` bit set.
+		//
+		// Return the number of values which could not be converted.
+		static size_t cvt_from_unix_usecs(eternal_timestamp_t *dst, uint8_t *validity, const int64_t *src, size_t count, unsigned int parallelism = ETS_PARALLELISM_DEFAULT);
+		static size_t cvt_from_unix_msecs(eternal_timestamp_t *dst, uint8_t *validity, const int64_t *src, size_t count, unsigned int parallelism = ETS_PARALLELISM_DEFAULT);
+		static size_t cvt_from_unix_seconds(eternal_timestamp_t *dst, uint8_t *validity, const int64_t *src, size_t count, unsigned int parallelism = ETS_PARALLELISM_DEFAULT);
+
+		// convert days since 1970/jan/01 to date-only timestamps: all time-of-day fields are marked 'unspecified'.
+		// Out-of-range values are treated as above.
+		static size_t cvt_from_unix_days(eternal_timestamp_t *dst, uint8_t *validity, const int32_t *src, size_t count, unsigned int parallelism = ETS_PARALLELISM_DEFAULT);
+
+		// The reverse conversions. Timestamps which cannot be represented (prehistoric ones, timestamps lacking any
+		// of century, year, month or day, timestamps with a field out of range, e.g. February 31st or hour 24)
+		// produce zero(0) and have their `validity` bit cleared; all others have their `validity` bit set.
+		// Unspecified time-of-day fields are taken as zero(0). The leap second 23:59:60 has no UNIX time either.
+		//
+		// Return the number of timestamps which could not be represented.
+		static size_t cvt_to_unix_usecs(int64_t *dst, uint8_t *validity, const eternal_timestamp_t *src, size_t count, unsigned int parallelism = ETS_PARALLELISM_DEFAULT);
+		static size_t cvt_to_unix_msecs(int64_t *dst, uint8_t *validity, const eternal_timestamp_t *src, size_t count, unsigned int parallelism = ETS_PARALLELISM_DEFAULT);
+		static size_t cvt_to_unix_seconds(int64_t *dst, uint8_t *validity, const eternal_timestamp_t *src, size_t count, unsigned int parallelism = ETS_PARALLELISM_DEFAULT);
+		static size_t cvt_to_unix_days(int32_t *dst, uint8_t *validity, const eternal_timestamp_t *src, size_t count, unsigned int parallelism = ETS_PARALLELISM_DEFAULT);
+
+		// Parse `count` ISO 8601 / RFC 3339 strings; see `EternalTimestamp::cvt_from_iso8601()`.
+		//
+		// `lengths` MAY be NULL when the strings are NUL-terminated. Strings which fail to parse (and NULL
+		// `strings[i]` pointers) produce a timestamp with all fields 'unspecified' and have their `validity` bit
+		// cleared; all others have their `validity` bit set.
+		//
+		// Return the number of strings which failed to parse.
+		static size_t cvt_from_iso8601(eternal_timestamp_t *dst, uint8_t *validity, const char *const *strings, const size_t *lengths, size_t count, unsigned int parallelism = ETS_PARALLELISM_DEFAULT);
+
+		// Same as above, for strings stored in the Apache Arrow `utf8` layout: string `i` spans
+		// `data[offsets[i]]` up to `data[offsets[i + 1]]`, hence `offsets` has `count + 1` entries.
+		static size_t cvt_from_iso8601_column(eternal_timestamp_t *dst, uint8_t *validity, const char *data, const int32_t *offsets, size_t count, unsigned int parallelism = ETS_PARALLELISM_DEFAULT);
+
+		// Render timestamps `start` up to `count` as RFC 3339 text into an Apache Arrow `utf8` column: value `i` is
+		// written at `data[offsets[i]]` up to `data[offsets[i + 1]]`. `offsets[start]` MUST be set by the caller
+		// (usually `offsets[0] = 0`): rendering starts at that offset into `data`, which can hold `capacity` bytes.
+		//
+		// All timestamps are UTC, hence carry the 'Z' suffix. Partially specified timestamps are rendered at the
+		// ISO 8601 reduced precision they were specified at, up to the first unspecified field: "2022", "2022-01",
+		// "2022-01-13", "2022-01-13T12Z", "2022-01-13T12:40:31.049Z". Years outside the 0000..9999 range use the
+		// ISO 8601 expanded form: "-0044-03-15", "+12345-06-07". Prehistoric timestamps and timestamps lacking a
+		// year produce an empty string and have their `validity` bit cleared; all others have it set.
+		//
+		// The output parses back into the same timestamp with `cvt_from_iso8601()`.
+		//
+		// Returns the index of the first timestamp which was not rendered: when that is less than `count`, `data`
+		// is full; make room and call again with `start` set to the returned value. `ETS_BATCH_RFC3339_MAX_LENGTH`
+		// bytes per value always suffice.
+		static size_t cvt_to_rfc3339_column(char *data, size_t capacity, int32_t *offsets, uint8_t *validity, const eternal_timestamp_t *src, size_t start, size_t count, unsigned int parallelism = ETS_PARALLELISM_DEFAULT);
+
+		// batch version of `EternalTimestamp::calc_sort_key()`.
+		static void calc_sort_keys(int64_t *dst, const eternal_timestamp_t *src, size_t count, unsigned int parallelism = ETS_PARALLELISM_DEFAULT);
+	};
+}
+
+#endif // __cplusplus
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// C interface definitions
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+size_t ets_batch_cvt_from_unix_usecs(eternal_timestamp_t *dst, uint8_t *validity, const int64_t *src, size_t count);
+size_t ets_batch_cvt_from_unix_msecs(eternal_timestamp_t *dst, uint8_t *validity, const int64_t *src, size_t count);
+size_t ets_batch_cvt_from_unix_seconds(eternal_timestamp_t *dst, uint8_t *validity, const int64_t *src, size_t count);
+size_t ets_batch_cvt_from_unix_days(eternal_timestamp_t *dst, uint8_t *validity, const int32_t *src, size_t count);
+
+size_t ets_batch_cvt_to_unix_usecs(int64_t *dst, uint8_t *validity, const eternal_timestamp_t *src, size_t count);
+size_t ets_batch_cvt_to_unix_msecs(int64_t *dst, uint8_t *validity, const eternal_timestamp_t *src, size_t count);
+size_t ets_batch_cvt_to_unix_seconds(int64_t *dst, uint8_t *validity, const eternal_timestamp_t *src, size_t count);
+size_t ets_batch_cvt_to_unix_days(int32_t *dst, uint8_t *validity, const eternal_timestamp_t *src, size_t count);
+
+size_t ets_batch_cvt_from_iso8601(eternal_timestamp_t *dst, uint8_t *validity, const char *const *strings, const size_t *lengths, size_t count);
+size_t ets_batch_cvt_from_iso8601_column(eternal_timestamp_t *dst, uint8_t *validity, const char *data, const int32_t *offsets, size_t count);
+
+size_t ets_batch_cvt_to_rfc3339_column(char *data, size_t capacity, int32_t *offsets, uint8_t *validity, const eternal_timestamp_t *src, size_t start, size_t count);
+
+void ets_batch_calc_sort_keys(int64_t *dst, const eternal_timestamp_t *src, size_t count);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif // __ETERNAL_TIMESTAMP_BATCH_H__
@@ -0,0 +1,108 @@
+
+#pragma once
+
+#ifndef __ETERNAL_TIMESTAMP_BIBDATE_H__
+#define __ETERNAL_TIMESTAMP_BIBDATE_H__
+
+// Bibliographic date parser.
+//
+// Publication metadata carries dates in every shape imaginable: "13 Jan. 1922", "Spring 1923", "circa 1850",
+// "1920s", "19th cent.", "3rd century BC", "ca. 40,000 BP", "2.5 million years ago", "c1922" (MARC copyright
+// date), "192-?" (MARC unknown digit), "1850/51", ... This parser maps those onto (partial) timestamps:
+// fields which were not given are marked 'unspecified', while prehistoric dates get their `precision` set
+// from the number of significant digits given.
+//
+// Month names, seasons and keywords (in English plus the common European languages) are recognized through a
+// perfect hash lookup; the parser does not allocate and does not use regular expressions.
+//
+// Each parse produces a *confidence* percentage (0..100) which reflects how certain the parser is about its
+// interpretation of the string: 0 means "this is not a date", 100 means "unambiguous". Ambiguous day/month
+// order, two-digit years, unrecognized words, etc. lower the confidence. The confidence does NOT reflect the
+// precision of the date itself: that is what the qualifier flags are for.
+
+#include "eternal_timestamp/eternal_timestamp.h"
+#include "eternal_timestamp/eternal_timestamp_parallel.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+// Qualifier flags which describe what the parsed date actually stood for.
+enum ets_bibdate_qualifier
+{
+	ETS_BIBDATE_CIRCA = 0x01,             // "circa", "ca.", "c.", "approx.", "about", "~"
+	ETS_BIBDATE_UNCERTAIN = 0x02,         // "1922?"
+	ETS_BIBDATE_SEASON = 0x04,            // "Spring 1923": the month is the first month of the (northern hemisphere) season
+	ETS_BIBDATE_DECADE = 0x08,            // "1920s", "192-": the year is the first year of the decade
+	ETS_BIBDATE_CENTURY = 0x10,           // "19th century", "1800s", "18--": only the century is specified
+	ETS_BIBDATE_MILLENNIUM = 0x20,        // "2nd millennium BC": the century is the first century of the millennium
+	ETS_BIBDATE_BEFORE_PRESENT = 0x40,    // "40,000 BP", "2.5 Ma", "10,000 years ago": counted back from 1950 AD
+	ETS_BIBDATE_RANGE = 0x80,             // "1850-1860", "Jan-Mar 1922": the start of the range was produced
+};
+
+typedef struct ets_bibdate_info
+{
+	uint8_t confidence;                   // 0..100; 0: not a date
+	uint8_t qualifiers;                   // bitwise OR of `enum ets_bibdate_qualifier` flags
+} ets_bibdate_info_t;
+
+#if defined(__cplusplus)
+}
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// C++ interface definitions
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if defined(__cplusplus)
+
+namespace eternal_timestamp
+{
+	class EternalTimestampBibDate
+	{
+	public:
+		// Parse the bibliographic date of `length` characters (no terminating NUL required).
+		//
+		// Strings which are valid ISO 8601 are taken as-is (see `EternalTimestamp::cvt_from_iso8601()`) with 100%
+		// confidence. Otherwise the string is interpreted as a (possibly vague) date as described above; ranges
+		// produce their start.
+		//
+		// Returns the confidence (0..100) and sets `info`. When the string is not recognized as a date, 0 is
+		// returned and `dst` is set to a timestamp with all fields 'unspecified'.
+		static int parse(eternal_timestamp_t &dst, ets_bibdate_info_t &info, const char *str, size_t length);
+
+		// Parse `count` strings. `lengths` MAY be NULL when the strings are NUL-terminated; NULL `strings[i]`
+		// pointers are treated as empty strings. `info` MAY be NULL when you're not interested. `parallelism`: see
+		// eternal_timestamp_parallel.h.
+		//
+		// Return the number of strings which were not recognized as a date.
+		static size_t parse(eternal_timestamp_t *dst, ets_bibdate_info_t *info, const char *const *strings, const size_t *lengths, size_t count, unsigned int parallelism = ETS_PARALLELISM_DEFAULT);
+
+		// Same as above, for strings stored in the Apache Arrow `utf8` layout: string `i` spans
+		// `data[offsets[i]]` up to `data[offsets[i + 1]]`, hence `offsets` has `count + 1` entries.
+		static size_t parse_column(eternal_timestamp_t *dst, ets_bibdate_info_t *info, const char *data, const int32_t *offsets, size_t count, unsigned int parallelism = ETS_PARALLELISM_DEFAULT);
+	};
+}
+
+#endif // __cplusplus
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// C interface definitions
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+int ets_bibdate_parse(eternal_timestamp_t *dst, ets_bibdate_info_t *info, const char *str, size_t length);
+size_t ets_bibdate_parse_batch(eternal_timestamp_t *dst, ets_bibdate_info_t *info, const char *const *strings, const size_t *lengths, size_t count);
+size_t ets_bibdate_parse_column(eternal_timestamp_t *dst, ets_bibdate_info_t *info, const char *data, const int32_t *offsets, size_t count);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif // __ETERNAL_TIMESTAMP_BIBDATE_H__
@@ -0,0 +1,98 @@
+#pragma once
+
+#ifndef __ETERNAL_TIMESTAMP_CALENDAR_H__
+#define __ETERNAL_TIMESTAMP_CALENDAR_H__
+
+// Derived calendar fields: the weekday, the day of the year, the ISO 8601 week and the quarter of a timestamp.
+//
+// These are computed from the century, year, month and day fields directly, without a detour through `time_t`
+// and `gmtime_r()`, so they work for every date of the modern subformat, not just for 1970..2038. The Gregorian
+// calendar repeats every 400 years, which is also a whole number of weeks, so a table of 400 entries (the
+// weekday of January 1st, whether the year is a leap year and whether it has 53 ISO weeks) plus the cumulative
+// month lengths cover the entire range: no day count is computed at all.
+//
+// The proleptic Gregorian calendar is used throughout, as everywhere else in this library.
+//
+// A field which cannot be derived because the timestamp is partial ("2020-09", "20??"), or prehistoric, comes
+// out as `ETS_CALENDAR_UNSPECIFIED`, also in the batch calls, which write one derived column each. Those use
+// SSE2 for the weekdays where available: the group-by-weekday histogram of `count_weekdays()` is meant for
+// scanning very large columns.
+
+#include "eternal_timestamp/eternal_timestamp.h"
+#include "eternal_timestamp/eternal_timestamp_parallel.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+// What the derived fields are when they cannot be derived: none of them is ever zero(0) otherwise.
+#define ETS_CALENDAR_UNSPECIFIED    0
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// C++ interface definitions
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if defined(__cplusplus)
+
+namespace eternal_timestamp
+{
+	// `parallelism` works as with `EternalTimestampBatch`.
+	class EternalTimestampCalendar
+	{
+	public:
+		// The ISO 8601 weekday: 1 (Monday) up to 7 (Sunday). Needs a modern timestamp with a complete date.
+		static int weekday(const eternal_timestamp_t t);
+
+		// The day of the year: 1 up to 366. Needs a modern timestamp with a complete date.
+		static int day_of_year(const eternal_timestamp_t t);
+
+		// The ISO 8601 week: 1 up to 53. Needs a modern timestamp with a complete date. The week-based year, which
+		// differs from the calendar year for the days around New Year which belong to a week of the neighbouring
+		// year (2021-01-01 is in week 53 of 2020), is stored in `iso_year` (which MAY be NULL); it is left
+		// untouched when the week cannot be derived.
+		static int iso_week(const eternal_timestamp_t t, int32_t *iso_year = nullptr);
+
+		// The quarter: 1 up to 4. Needs the month only, of a modern or prehistoric timestamp.
+		static int quarter(const eternal_timestamp_t t);
+
+		// Batch versions of the above: each writes one derived column. Return the number of values for which the
+		// field could not be derived.
+		static size_t calc_weekdays(uint8_t *dst, const eternal_timestamp_t *src, size_t count, unsigned int parallelism = ETS_PARALLELISM_DEFAULT);
+		static size_t calc_days_of_year(uint16_t *dst, const eternal_timestamp_t *src, size_t count, unsigned int parallelism = ETS_PARALLELISM_DEFAULT);
+		static size_t calc_quarters(uint8_t *dst, const eternal_timestamp_t *src, size_t count, unsigned int parallelism = ETS_PARALLELISM_DEFAULT);
+
+		// `iso_years` MAY be NULL; where the week cannot be derived it is set to zero(0), as is the week.
+		static size_t calc_iso_weeks(uint8_t *weeks, int32_t *iso_years, const eternal_timestamp_t *src, size_t count, unsigned int parallelism = ETS_PARALLELISM_DEFAULT);
+
+		// Count the values per weekday: `counts[1]` up to `counts[7]` receive the numbers of Mondays up to
+		// Sundays, `counts[0]` the number of values without a weekday. Same as a histogram of the column
+		// produced by `calc_weekdays()`, without producing that column.
+		static void count_weekdays(uint64_t counts[8], const eternal_timestamp_t *src, size_t count, unsigned int parallelism = ETS_PARALLELISM_DEFAULT);
+	};
+}
+
+#endif // __cplusplus
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// C interface definitions
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+int ets_calendar_weekday(const eternal_timestamp_t t);
+int ets_calendar_day_of_year(const eternal_timestamp_t t);
+int ets_calendar_iso_week(const eternal_timestamp_t t, int32_t *iso_year);
+int ets_calendar_quarter(const eternal_timestamp_t t);
+
+size_t ets_calendar_calc_weekdays(uint8_t *dst, const eternal_timestamp_t *src, size_t count);
+size_t ets_calendar_calc_days_of_year(uint16_t *dst, const eternal_timestamp_t *src, size_t count);
+size_t ets_calendar_calc_quarters(uint8_t *dst, const eternal_timestamp_t *src, size_t count);
+size_t ets_calendar_calc_iso_weeks(uint8_t *weeks, int32_t *iso_years, const eternal_timestamp_t *src, size_t count);
+void ets_calendar_count_weekdays(uint64_t counts[8], const eternal_timestamp_t *src, size_t count);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif // __ETERNAL_TIMESTAMP_CALENDAR_H__
@@ -0,0 +1,132 @@
+
+#pragma once
+
+#ifndef __ETERNAL_TIMESTAMP_COMPACT_H__
+#define __ETERNAL_TIMESTAMP_COMPACT_H__
+
+// Narrow companion encodings for columns which never use all of a timestamp's precision.
+//
+// A date-only column (publication dates, birthdays) leaves the time-of-day and sub-second fields of every value
+// unspecified, a second-precision column (file times, most log formats) the sub-second fields: 37 and 20 bits of
+// each 64-bit `eternal_timestamp_t` which always hold the same thing. These encodings drop those bits:
+//
+// - `ets_date32_t`, 32 bits: century, year, month and day.
+// - `ets_datetime48_t`, 48 bits: century, year, month, day, hour, minute and seconds (leap seconds included).
+//
+// Each field keeps its code from the full format, 'unspecified' markers included, so partial timestamps such
+// as "2020" or "2020-09-13T12" narrow and widen back losslessly. The fields which are dropped must either all be
+// 'unspecified' or all be zero(0), as with a date at midnight or a time to the whole second, which a flag bit
+// tells apart. Only modern timestamps narrow; the others are reported as such (see the batch calls).
+//
+// Both sort like the timestamps they encode (see `EternalTimestamp::calc_sort_key()`) when compared directly:
+// `ets_date32_t` as a plain unsigned integer, `ets_datetime48_t` as 6 bytes with `memcmp()` (they're stored
+// most significant byte first), which also makes them fit for binary keys in any store.
+//
+// The batch conversions use SSE2 where available.
+
+#include "eternal_timestamp/eternal_timestamp.h"
+#include "eternal_timestamp/eternal_timestamp_parallel.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+// Bits 31..26: zero; 25..17: century; 16..10: year; 9..6: month; 5..1: day; 0: the time-of-day flag, set when
+// the time of day is 00:00:00.000000 rather than 'unspecified' (the other way around in builds where
+// 'unspecified' sorts last).
+typedef uint32_t ets_date32_t;
+
+// Bits 47..43 of the big-endian value: zero; 42..34: century; 33..27: year; 26..23: month; 22..18: day;
+// 17..13: hour; 12..7: minute; 6..1: seconds; 0: the sub-seconds flag, set when the sub-seconds are .000000
+// rather than 'unspecified' (the other way around in builds where 'unspecified' sorts last).
+typedef struct ets_datetime48
+{
+	uint8_t bytes[6];
+} ets_datetime48_t;
+
+// The value of a `ets_datetime48_t`, which compares like the timestamp it encodes.
+static inline uint64_t ets_datetime48_value(const ets_datetime48_t v)
+{
+	uint64_t x = 0;
+	for (int i = 0; i < 6; i++)
+		x = (x << 8) | v.bytes[i];
+	return x;
+}
+
+// <0, 0 or >0, as a is earlier than, the same as, or later than b.
+static inline int ets_datetime48_compare(const ets_datetime48_t a, const ets_datetime48_t b)
+{
+	const uint64_t x = ets_datetime48_value(a);
+	const uint64_t y = ets_datetime48_value(b);
+	return (x > y) - (x < y);
+}
+
+#if defined(__cplusplus)
+}
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// C++ interface definitions
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if defined(__cplusplus)
+
+namespace eternal_timestamp
+{
+	// `validity` bitmaps and `parallelism` work as with `EternalTimestampBatch`.
+	class EternalTimestampCompact
+	{
+	public:
+		// Narrow `t` to the date-only form. Returns -1, having set `dst` to zero(0), when `t` is prehistoric or
+		// when its time of day is neither entirely 'unspecified' nor 00:00:00.000000.
+		static int narrow_date32(ets_date32_t &dst, const eternal_timestamp_t t);
+
+		// Widen `v` back to the full format. Returns -1, having set `dst` to a timestamp with all fields
+		// 'unspecified', when any of the zero bits of `v` is set.
+		static int widen_date32(eternal_timestamp_t &dst, const ets_date32_t v);
+
+		// Narrow `t` to the second-precision form. Returns -1, having set `dst` to zero(0), when `t` is prehistoric
+		// or when its sub-seconds are neither both 'unspecified' nor .000000.
+		static int narrow_datetime48(ets_datetime48_t &dst, const eternal_timestamp_t t);
+
+		// Widen `v` back to the full format. Returns -1, having set `dst` to a timestamp with all fields
+		// 'unspecified', when any of the zero bits of `v` is set.
+		static int widen_datetime48(eternal_timestamp_t &dst, const ets_datetime48_t v);
+
+		// Batch versions of the above: values which fail have their `validity` bit cleared, all others have it
+		// set. Return the number of values which failed.
+		static size_t narrow_date32_batch(ets_date32_t *dst, uint8_t *validity, const eternal_timestamp_t *src, size_t count, unsigned int parallelism = ETS_PARALLELISM_DEFAULT);
+		static size_t widen_date32_batch(eternal_timestamp_t *dst, uint8_t *validity, const ets_date32_t *src, size_t count, unsigned int parallelism = ETS_PARALLELISM_DEFAULT);
+		static size_t narrow_datetime48_batch(ets_datetime48_t *dst, uint8_t *validity, const eternal_timestamp_t *src, size_t count, unsigned int parallelism = ETS_PARALLELISM_DEFAULT);
+		static size_t widen_datetime48_batch(eternal_timestamp_t *dst, uint8_t *validity, const ets_datetime48_t *src, size_t count, unsigned int parallelism = ETS_PARALLELISM_DEFAULT);
+	};
+}
+
+#endif // __cplusplus
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// C interface definitions
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+int ets_compact_narrow_date32(ets_date32_t *dst, const eternal_timestamp_t t);
+int ets_compact_widen_date32(eternal_timestamp_t *dst, const ets_date32_t v);
+int ets_compact_narrow_datetime48(ets_datetime48_t *dst, const eternal_timestamp_t t);
+int ets_compact_widen_datetime48(eternal_timestamp_t *dst, const ets_datetime48_t v);
+
+size_t ets_compact_narrow_date32_batch(ets_date32_t *dst, uint8_t *validity, const eternal_timestamp_t *src, size_t count);
+size_t ets_compact_widen_date32_batch(eternal_timestamp_t *dst, uint8_t *validity, const ets_date32_t *src, size_t count);
+size_t ets_compact_narrow_datetime48_batch(ets_datetime48_t *dst, uint8_t *validity, const eternal_timestamp_t *src, size_t count);
+size_t ets_compact_widen_datetime48_batch(eternal_timestamp_t *dst, uint8_t *validity, const ets_datetime48_t *src, size_t count);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif // __ETERNAL_TIMESTAMP_COMPACT_H__
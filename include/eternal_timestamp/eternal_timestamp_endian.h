@@ -0,0 +1,359 @@
+#pragma once
+
+#ifndef __ETERNAL_TIMESTAMP_ENDIAN_H__
+#define __ETERNAL_TIMESTAMP_ENDIAN_H__
+
+// Timestamps in byte buffers: network frames, packed file records, memory mapped columns.
+//
+// Such buffers hold the 64-bit values in a given byte order, which needn't be the host's, at whatever alignment
+// the record layout dictates. The 'network' (database) format is little-endian, see `EternalTimestamp::ntoh()`,
+// but foreign formats may well be big-endian.
+//
+// - `ets_load_timestamp()` / `ets_store_timestamp()` read and write a single value at any address.
+// - `EternalTimestampBytesView` / `EternalTimestampMutableBytesView` are span-like views over a buffer: element `i`
+//   is the 8 bytes at `data + i * stride`, so a view can also pick the timestamp field out of an array of packed
+//   records. Nothing is copied: elements are converted as they are read or written.
+// - `EternalTimestampEndian::load()` / `store()` convert whole columns at once, and `byteswap()` reverses the
+//   bytes of a buffer of 64-bit values, with SIMD kernels (SSE2/SSSE3/AVX2 or NEON, as the build targets).
+//
+// All of these take any alignment.
+
+#include "eternal_timestamp/eternal_timestamp.h"
+#include "eternal_timestamp/eternal_timestamp_parallel.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <stdlib.h>
+#endif
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+typedef enum ets_byte_order
+{
+	ETS_BYTE_ORDER_LITTLE = 0,
+	ETS_BYTE_ORDER_BIG,
+} ets_byte_order_t;
+
+// The byte order of the host.
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define ETS_BYTE_ORDER_NATIVE       ETS_BYTE_ORDER_BIG
+#else
+#define ETS_BYTE_ORDER_NATIVE       ETS_BYTE_ORDER_LITTLE
+#endif
+
+static inline uint64_t ets_bswap64(const uint64_t x)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_bswap64(x);
+#elif defined(_MSC_VER)
+	return _byteswap_uint64(x);
+#else
+	return ((x & 0x00000000000000FFULL) << 56) | ((x & 0x000000000000FF00ULL) << 40)
+		| ((x & 0x0000000000FF0000ULL) << 24) | ((x & 0x00000000FF000000ULL) << 8)
+		| ((x & 0x000000FF00000000ULL) >> 8) | ((x & 0x0000FF0000000000ULL) >> 24)
+		| ((x & 0x00FF000000000000ULL) >> 40) | ((x & 0xFF00000000000000ULL) >> 56);
+#endif
+}
+
+// The timestamp stored at `src` (any alignment) in byte order `order`.
+static inline eternal_timestamp_t ets_load_timestamp(const void *src, const ets_byte_order_t order)
+{
+	eternal_timestamp_t t;
+	memcpy(&t.t, src, sizeof(t.t));
+	if (order != ETS_BYTE_ORDER_NATIVE)
+		t.t = ets_bswap64(t.t);
+	return t;
+}
+
+// Store `t` at `dst` (any alignment) in byte order `order`.
+static inline void ets_store_timestamp(void *dst, const eternal_timestamp_t t, const ets_byte_order_t order)
+{
+	const uint64_t v = (order != ETS_BYTE_ORDER_NATIVE ? ets_bswap64(t.t) : t.t);
+	memcpy(dst, &v, sizeof(v));
+}
+
+#if defined(__cplusplus)
+}
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// C++ interface definitions
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if defined(__cplusplus)
+
+#include <iterator>
+
+namespace eternal_timestamp
+{
+	class EternalTimestampEndian
+	{
+	public:
+		// Reverse the bytes of each of the `count` 64-bit values at `src`, writing them to `dst`. `dst` may be
+		// `src` (in-place), but the buffers MUST NOT overlap otherwise.
+		static void byteswap(void *dst, const void *src, size_t count, unsigned int parallelism = ETS_PARALLELISM_DEFAULT);
+
+		// Read `count` timestamps stored in byte order `order`, `stride` bytes apart, starting at `src`.
+		// `stride` MUST be at least 8; with 8 the buffer is a plain array of values.
+		static void load(eternal_timestamp_t *dst, const void *src, size_t count, ets_byte_order_t order, size_t stride = sizeof(eternal_timestamp_t), unsigned int parallelism = ETS_PARALLELISM_DEFAULT);
+
+		// Write `count` timestamps in byte order `order`, `stride` bytes apart, starting at `dst`. The bytes
+		// between the values are left alone.
+		static void store(void *dst, const eternal_timestamp_t *src, size_t count, ets_byte_order_t order, size_t stride = sizeof(eternal_timestamp_t), unsigned int parallelism = ETS_PARALLELISM_DEFAULT);
+	};
+
+	// A read-only view of `size()` timestamps stored in byte order `Order` at `data`, `data + stride`, ...
+	template <ets_byte_order_t Order>
+	class EternalTimestampBytesView
+	{
+	public:
+		static constexpr ets_byte_order_t byte_order = Order;
+
+		class const_iterator
+		{
+		public:
+			typedef std::input_iterator_tag iterator_category;
+			typedef eternal_timestamp_t value_type;
+			typedef ptrdiff_t difference_type;
+			typedef const eternal_timestamp_t *pointer;
+			typedef eternal_timestamp_t reference;
+
+			const_iterator(const uint8_t *p, size_t stride) noexcept
+				: p_(p), stride_(stride)
+			{
+			}
+
+			eternal_timestamp_t operator*() const noexcept
+			{
+				return ets_load_timestamp(p_, Order);
+			}
+
+			const_iterator &operator++() noexcept
+			{
+				p_ += stride_;
+				return *this;
+			}
+
+			const_iterator operator++(int) noexcept
+			{
+				const_iterator it = *this;
+				p_ += stride_;
+				return it;
+			}
+
+			bool operator==(const const_iterator &other) const noexcept
+			{
+				return p_ == other.p_;
+			}
+
+			bool operator!=(const const_iterator &other) const noexcept
+			{
+				return p_ != other.p_;
+			}
+
+		private:
+			const uint8_t *p_;
+			size_t stride_;
+		};
+
+		EternalTimestampBytesView() noexcept
+			: data_(nullptr), size_(0), stride_(sizeof(uint64_t))
+		{
+		}
+
+		EternalTimestampBytesView(const void *data, size_t count, size_t stride = sizeof(uint64_t)) noexcept
+			: data_(static_cast<const uint8_t *>(data)), size_(count), stride_(stride)
+		{
+		}
+
+		const uint8_t *data() const noexcept
+		{
+			return data_;
+		}
+
+		size_t size() const noexcept
+		{
+			return size_;
+		}
+
+		bool empty() const noexcept
+		{
+			return size_ == 0;
+		}
+
+		size_t stride() const noexcept
+		{
+			return stride_;
+		}
+
+		eternal_timestamp_t operator[](size_t i) const noexcept
+		{
+			return ets_load_timestamp(data_ + i * stride_, Order);
+		}
+
+		const_iterator begin() const noexcept
+		{
+			return const_iterator(data_, stride_);
+		}
+
+		const_iterator end() const noexcept
+		{
+			return const_iterator(data_ + size_ * stride_, stride_);
+		}
+
+		// Elements [offset, offset + count).
+		EternalTimestampBytesView subview(size_t offset, size_t count) const noexcept
+		{
+			return EternalTimestampBytesView(data_ + offset * stride_, count, stride_);
+		}
+
+		// All elements, converted in bulk: see `EternalTimestampEndian::load()`.
+		void copy_to(eternal_timestamp_t *dst, unsigned int parallelism = ETS_PARALLELISM_DEFAULT) const
+		{
+			EternalTimestampEndian::load(dst, data_, size_, Order, stride_, parallelism);
+		}
+
+	private:
+		const uint8_t *data_;
+		size_t size_;
+		size_t stride_;
+	};
+
+	// A writable view, as `EternalTimestampBytesView`.
+	template <ets_byte_order_t Order>
+	class EternalTimestampMutableBytesView
+	{
+	public:
+		static constexpr ets_byte_order_t byte_order = Order;
+
+		// What `operator[]` produces: reads and writes go to the buffer.
+		class reference
+		{
+		public:
+			explicit reference(uint8_t *p) noexcept
+				: p_(p)
+			{
+			}
+
+			operator eternal_timestamp_t() const noexcept
+			{
+				return ets_load_timestamp(p_, Order);
+			}
+
+			reference &operator=(const eternal_timestamp_t t) noexcept
+			{
+				ets_store_timestamp(p_, t, Order);
+				return *this;
+			}
+
+			reference &operator=(const reference &other) noexcept
+			{
+				return *this = static_cast<eternal_timestamp_t>(other);
+			}
+
+		private:
+			uint8_t *p_;
+		};
+
+		EternalTimestampMutableBytesView() noexcept
+			: data_(nullptr), size_(0), stride_(sizeof(uint64_t))
+		{
+		}
+
+		EternalTimestampMutableBytesView(void *data, size_t count, size_t stride = sizeof(uint64_t)) noexcept
+			: data_(static_cast<uint8_t *>(data)), size_(count), stride_(stride)
+		{
+		}
+
+		operator EternalTimestampBytesView<Order>() const noexcept
+		{
+			return EternalTimestampBytesView<Order>(data_, size_, stride_);
+		}
+
+		uint8_t *data() const noexcept
+		{
+			return data_;
+		}
+
+		size_t size() const noexcept
+		{
+			return size_;
+		}
+
+		bool empty() const noexcept
+		{
+			return size_ == 0;
+		}
+
+		size_t stride() const noexcept
+		{
+			return stride_;
+		}
+
+		reference operator[](size_t i) const noexcept
+		{
+			return reference(data_ + i * stride_);
+		}
+
+		eternal_timestamp_t get(size_t i) const noexcept
+		{
+			return ets_load_timestamp(data_ + i * stride_, Order);
+		}
+
+		void set(size_t i, const eternal_timestamp_t t) const noexcept
+		{
+			ets_store_timestamp(data_ + i * stride_, t, Order);
+		}
+
+		EternalTimestampMutableBytesView subview(size_t offset, size_t count) const noexcept
+		{
+			return EternalTimestampMutableBytesView(data_ + offset * stride_, count, stride_);
+		}
+
+		// All elements, converted in bulk: see `EternalTimestampEndian::load()` / `store()`.
+		void copy_to(eternal_timestamp_t *dst, unsigned int parallelism = ETS_PARALLELISM_DEFAULT) const
+		{
+			EternalTimestampEndian::load(dst, data_, size_, Order, stride_, parallelism);
+		}
+
+		void copy_from(const eternal_timestamp_t *src, unsigned int parallelism = ETS_PARALLELISM_DEFAULT) const
+		{
+			EternalTimestampEndian::store(data_, src, size_, Order, stride_, parallelism);
+		}
+
+	private:
+		uint8_t *data_;
+		size_t size_;
+		size_t stride_;
+	};
+
+	typedef EternalTimestampBytesView<ETS_BYTE_ORDER_LITTLE> EternalTimestampLEBytesView;
+	typedef EternalTimestampBytesView<ETS_BYTE_ORDER_BIG> EternalTimestampBEBytesView;
+	typedef EternalTimestampMutableBytesView<ETS_BYTE_ORDER_LITTLE> EternalTimestampMutableLEBytesView;
+	typedef EternalTimestampMutableBytesView<ETS_BYTE_ORDER_BIG> EternalTimestampMutableBEBytesView;
+}
+
+#endif // __cplusplus
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// C interface definitions
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+void ets_endian_byteswap(void *dst, const void *src, size_t count);
+void ets_endian_load(eternal_timestamp_t *dst, const void *src, size_t count, ets_byte_order_t order, size_t stride);
+void ets_endian_store(void *dst, const eternal_timestamp_t *src, size_t count, ets_byte_order_t order, size_t stride);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif // __ETERNAL_TIMESTAMP_ENDIAN_H__
@@ -0,0 +1,133 @@
+
+#pragma once
+
+#ifndef __ETERNAL_TIMESTAMP_FORMAT_H__
+#define __ETERNAL_TIMESTAMP_FORMAT_H__
+
+// Compiled format patterns.
+//
+// A strftime-like pattern is compiled once into a small instruction list, which is then applied to any number
+// of timestamps. Rendering never allocates: output goes to caller-provided buffers.
+//
+// Pattern directives:
+//
+//     %Y    year; ISO 8601 style: at least 4 digits, negative for B.C. (-0043 is 44 BC)
+//     %EY   year with era: 1922, 44 BC
+//     %C    century (the year divided by 100), %y  the year within the century (00..99)
+//     %m    month (01..12), %b  abbreviated month name (Jan), %B  full month name (January)
+//     %d    day of the month (01..31), %e  ditto, space padded
+//     %H    hour (00..23), %I  hour (01..12), %p  AM/PM
+//     %M    minute (00..59)
+//     %S    second (00..60)
+//     %f    fractional seconds at the precision specified: 3 digits for milliseconds, 6 when microseconds are known
+//     %3f   milliseconds (000..999), %6f  microseconds (000000..999999)
+//     %F    same as %Y-%m-%d, %T  same as %H:%M:%S
+//     %N    the age of a prehistoric timestamp in years, rounded to its precision: 40000
+//     %~    "approx. " when the age of a prehistoric timestamp is known to a limited precision only
+//     %%    a '%' character; %[, %] and %| produce '[', ']' and '|'
+//
+// Unspecified fields render as '?' characters, e.g. "2022-??-??" for a timestamp which only carries a year.
+// Optional sections `[...]` are only rendered when all the fields they reference are specified, which allows
+// rendering timestamps at the precision they were specified at:
+//
+//     %Y[-%m[-%d[T%H[:%M[:%S[.%f]]]]]]      -->  "2022", "2022-01", "2022-01-13T12:40", ...
+//
+// Modern and prehistoric timestamps usually call for very different renderings: a pattern MAY carry a second
+// alternative for prehistoric timestamps after a '|' separator. When it doesn't, prehistoric timestamps are
+// rendered using `ETS_FORMAT_PREHISTORIC_DEFAULT`.
+
+#include "eternal_timestamp/eternal_timestamp.h"
+#include "eternal_timestamp/eternal_timestamp_parallel.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#define ETS_FORMAT_MAX_OPS          64
+#define ETS_FORMAT_MAX_LITERALS     192
+
+// render timestamps at the precision they were specified at:
+#define ETS_FORMAT_ISO8601                  "%Y[-%m[-%d[T%H[:%M[:%S[.%f]]]]]]"
+#define ETS_FORMAT_PREHISTORIC_DEFAULT      "%~%N years ago"
+
+typedef struct ets_format_op
+{
+	uint8_t code;
+	uint8_t width;
+	uint16_t arg;           // literal: offset into `literals`; section: index of the first op beyond the section
+	uint16_t length;        // literal: length; section: the fields required (`enum eternal_unspecified_time_field_bit` mask)
+} ets_format_op_t;
+
+// A compiled pattern. This is a plain value type: copy it around as you like.
+typedef struct ets_format_pattern
+{
+	uint16_t modern_count;      // ops [0, modern_count) render modern timestamps,
+	uint16_t op_count;          // ops [modern_count, op_count) render prehistoric timestamps.
+	uint16_t max_length;        // the maximum length of the rendered text, excluding the terminating NUL.
+	uint16_t literal_length;
+	ets_format_op_t ops[ETS_FORMAT_MAX_OPS];
+	char literals[ETS_FORMAT_MAX_LITERALS];
+} ets_format_pattern_t;
+
+#if defined(__cplusplus)
+}
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// C++ interface definitions
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if defined(__cplusplus)
+
+namespace eternal_timestamp
+{
+	class EternalTimestampFormat
+	{
+	public:
+		// Compile the NUL-terminated `pattern`.
+		//
+		// Returns 0 on success, -1 when the pattern is invalid or too large, in which case `error_offset`, when
+		// not NULL, receives the offset of the offending character in `pattern`.
+		static int compile(ets_format_pattern_t &dst, const char *pattern, size_t *error_offset = nullptr);
+
+		// Render the timestamp into `buf`, which receives at most `bufsize - 1` characters plus a terminating NUL.
+		//
+		// Returns the length of the complete rendering, like `snprintf()`: a return value of `bufsize` or more
+		// signals that the output was truncated. `pattern.max_length + 1` bytes always suffice.
+		static size_t format(char *buf, size_t bufsize, const ets_format_pattern_t &pattern, const eternal_timestamp_t t);
+
+		// Render `count` timestamps into an Apache Arrow `utf8` column: value `i` is written at `data[offsets[i]]`
+		// up to `data[offsets[i + 1]]`. `offsets[0]` MUST be set by the caller: rendering starts at that offset
+		// into `data`, which can hold `capacity` bytes in total.
+		//
+		// Returns the number of timestamps rendered: when that is less than `count`, `data` is full; continue
+		// with `offsets + rv` and `src + rv` after making room.
+		//
+		// Columns with room for `pattern.max_length` bytes per value are rendered on up to `parallelism` threads:
+		// see eternal_timestamp_parallel.h.
+		static size_t format_column(char *data, size_t capacity, int32_t *offsets, const ets_format_pattern_t &pattern, const eternal_timestamp_t *src, size_t count, unsigned int parallelism = ETS_PARALLELISM_DEFAULT);
+	};
+}
+
+#endif // __cplusplus
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// C interface definitions
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+int ets_format_compile(ets_format_pattern_t *dst, const char *pattern, size_t *error_offset);
+size_t ets_format(char *buf, size_t bufsize, const ets_format_pattern_t *pattern, const eternal_timestamp_t t);
+size_t ets_format_column(char *data, size_t capacity, int32_t *offsets, const ets_format_pattern_t *pattern, const eternal_timestamp_t *src, size_t count);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif // __ETERNAL_TIMESTAMP_FORMAT_H__
@@ -0,0 +1,155 @@
+#pragma once
+
+#ifndef __ETERNAL_TIMESTAMP_FSCRAWL_H__
+#define __ETERNAL_TIMESTAMP_FSCRAWL_H__
+
+// File system metadata crawler.
+//
+// Walks a directory tree on multiple threads and produces the access, modification, status change and birth
+// times of every entry as eternal timestamps at microsecond precision, where `stat()` plus
+// `EternalTimestamp::cvt_from_time_t()` drops the sub-second part. On Linux the entries are read with `statx()`,
+// which also reports the birth time on file systems that record it; elsewhere with `fstatat()`.
+//
+// Each thread takes a directory off a shared queue, reads its entries relative to the directory's file
+// descriptor, queues the subdirectories it finds and converts the times of a batch of entries at once with
+// `EternalTimestampBatch::cvt_from_unix_usecs()`. The batches are handed to a callback, or collected into
+// columns. Entries come in no particular order: sort them by path when that matters.
+//
+// Only available on POSIX systems; elsewhere the crawl fails with `errno` set to `ENOSYS`.
+
+#include "eternal_timestamp/eternal_timestamp.h"
+#include "eternal_timestamp/eternal_timestamp_parallel.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+// The number of entries handed to the callback at once, at most.
+#define ETS_FSCRAWL_BATCH           1024
+
+typedef enum ets_fscrawl_flags
+{
+	ETS_FSCRAWL_FOLLOW_SYMLINKS = 1,     // report (and descend into) what symbolic links point to, rather than the links
+	ETS_FSCRAWL_ONE_FILESYSTEM = 2,      // don't descend into directories on other file systems (mount points)
+	ETS_FSCRAWL_SKIP_HIDDEN = 4,         // skip the entries whose name starts with a '.', and what is below them
+} ets_fscrawl_flags_t;
+
+typedef struct ets_fscrawl_entry
+{
+	const char *path;                    // the root's path plus the entry's path below it, NUL-terminated
+	size_t path_length;
+	uint64_t size;                       // in bytes
+	uint64_t inode;
+	uint32_t mode;                       // `st_mode`: the file type and permissions
+	uint32_t depth;                      // 0 for the root, 1 for the entries in it, ...
+
+	// Complete modern timestamps in UTC. The birth time is `ets_unknown()` when the file system doesn't record
+	// it, or the platform cannot tell.
+	eternal_timestamp_t atime;
+	eternal_timestamp_t mtime;
+	eternal_timestamp_t ctime;
+	eternal_timestamp_t btime;
+} ets_fscrawl_entry_t;
+
+typedef struct ets_fscrawl_stats
+{
+	uint64_t entries;                    // reported, the root included
+	uint64_t directories;                // read
+	uint64_t errors;                     // entries or directories which could not be read, and were skipped
+} ets_fscrawl_stats_t;
+
+// Receives `count` entries, valid during the call only. The calls are serialized, though not always made from
+// the same thread. Return non-zero to stop the crawl.
+typedef int (*ets_fscrawl_callback_t)(void *context, const ets_fscrawl_entry_t *entries, size_t count);
+
+#if defined(__cplusplus)
+}
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// C++ interface definitions
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if defined(__cplusplus)
+
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace eternal_timestamp
+{
+	// The result of `EternalTimestampFsCrawl::collect()`: entry `i` is row `i` of each column.
+	struct EternalTimestampFsColumns
+	{
+		std::string paths;                       // all paths back to back, without NUL terminators
+		std::vector<uint64_t> path_offsets;      // path `i` is [path_offsets[i], path_offsets[i + 1]) of `paths`
+		std::vector<uint64_t> sizes;
+		std::vector<uint64_t> inodes;
+		std::vector<uint32_t> modes;
+		std::vector<eternal_timestamp_t> atime;
+		std::vector<eternal_timestamp_t> mtime;
+		std::vector<eternal_timestamp_t> ctime;
+		std::vector<eternal_timestamp_t> btime;
+
+		size_t size() const
+		{
+			return sizes.size();
+		}
+
+		std::string path(size_t i) const
+		{
+			return paths.substr(path_offsets[i], path_offsets[i + 1] - path_offsets[i]);
+		}
+
+		void clear();
+	};
+
+	class EternalTimestampFsCrawl
+	{
+	public:
+		// Walk the tree at `root` (which may also be a single file, or a symbolic link to either: the root is
+		// always followed), on up to `parallelism` threads, handing the entries to `callback` in batches of up to
+		// `ETS_FSCRAWL_BATCH`. `flags` is a combination of `ets_fscrawl_flags_t`. Entries which cannot be read are
+		// skipped and counted in `stats` (which MAY be NULL).
+		//
+		// Returns -1, with `errno` set, when `root` cannot be read, or when the callback stopped the crawl
+		// (`ECANCELED`); 0 otherwise.
+		static int crawl(const char *root, unsigned int flags, ets_fscrawl_callback_t callback, void *context, ets_fscrawl_stats_t *stats = nullptr, unsigned int parallelism = ETS_PARALLELISM_DEFAULT);
+
+		// The same with a callable `callback(const ets_fscrawl_entry_t *entries, size_t count)`, returning
+		// `true` to go on.
+		template <typename F, typename = typename std::enable_if<!std::is_convertible<F, ets_fscrawl_callback_t>::value>::type>
+		static int crawl(const char *root, unsigned int flags, F &&callback, ets_fscrawl_stats_t *stats = nullptr, unsigned int parallelism = ETS_PARALLELISM_DEFAULT)
+		{
+			typedef typename std::remove_reference<F>::type callback_type;
+			return crawl(root, flags, [](void *ctx, const ets_fscrawl_entry_t *entries, size_t count) {
+				return (*static_cast<callback_type *>(ctx))(entries, count) ? 0 : 1;
+			}, const_cast<void *>(static_cast<const void *>(&callback)), stats, parallelism);
+		}
+
+		// Append all entries to `dst`.
+		static int collect(const char *root, unsigned int flags, EternalTimestampFsColumns &dst, ets_fscrawl_stats_t *stats = nullptr, unsigned int parallelism = ETS_PARALLELISM_DEFAULT);
+	};
+}
+
+#endif // __cplusplus
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// C interface definitions
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+// `parallelism` as with the bulk APIs: `ETS_PARALLELISM_DEFAULT`, `ETS_PARALLELISM_ALL` or a thread count.
+int ets_fscrawl(const char *root, unsigned int flags, ets_fscrawl_callback_t callback, void *context, ets_fscrawl_stats_t *stats, unsigned int parallelism);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif // __ETERNAL_TIMESTAMP_FSCRAWL_H__
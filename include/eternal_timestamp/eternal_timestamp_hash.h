@@ -0,0 +1,202 @@
+
+#pragma once
+
+#ifndef __ETERNAL_TIMESTAMP_HASH_H__
+#define __ETERNAL_TIMESTAMP_HASH_H__
+
+// Hashing eternal timestamps, plus flat hash sets/maps keyed on them, for deduplication and hash joins.
+//
+// Hashing the raw bit pattern as-is (`std::hash<uint64_t>` is the identity with most standard libraries) works
+// poorly for timestamps: the low bits hold the sub-second fields, which are frequently unspecified, hence all the
+// same, while the high bits (mode, century, year) hardly ever change. `ets_hash()` mixes all 64 bits into all
+// 64 bits, so any subset of the hash bits serves as a bucket index.
+//
+// The tables use open addressing with one control byte per slot, holding 7 bits of the hash, which are probed
+// in groups of 16 slots with SSE2 (8 with plain 64-bit arithmetic elsewhere): a lookup usually inspects one
+// group of control bytes and one key.
+
+#include "eternal_timestamp/eternal_timestamp.h"
+#include "eternal_timestamp/eternal_timestamp_parallel.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+// The `splitmix64` finalizer (Steele, Lea & Flood, "Fast splittable pseudorandom number generators", 2014):
+// a bijection with full avalanche, i.e. each input bit flips each output bit with a probability of about 50%.
+static inline uint64_t ets_hash(const eternal_timestamp_t t)
+{
+	uint64_t x = t.t;
+	x ^= x >> 30;
+	x *= 0xbf58476d1ce4e5b9ULL;
+	x ^= x >> 27;
+	x *= 0x94d049bb133111ebULL;
+	x ^= x >> 31;
+	return x;
+}
+
+// A flat hash map from timestamps to 64-bit values (e.g. row indexes). Opaque.
+typedef struct ets_hash_map ets_hash_map_t;
+
+#if defined(__cplusplus)
+}
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// C++ interface definitions
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if defined(__cplusplus)
+
+namespace eternal_timestamp
+{
+	// For use with the standard containers, e.g. `std::unordered_set<eternal_timestamp_t, EternalTimestampHasher, EternalTimestampKeyEqual>`
+	struct EternalTimestampHasher
+	{
+		size_t operator()(const eternal_timestamp_t t) const noexcept
+		{
+			return static_cast<size_t>(ets_hash(t));
+		}
+	};
+
+	// Bitwise equality, which is what hash tables need: timestamps with equal bit patterns are identical.
+	struct EternalTimestampKeyEqual
+	{
+		bool operator()(const eternal_timestamp_t a, const eternal_timestamp_t b) const noexcept
+		{
+			return a.t == b.t;
+		}
+	};
+
+	// A flat hash map from timestamps to 64-bit values.
+	//
+	// The bulk APIs work on columns and prefetch the table memory for the keys a few positions ahead, so the
+	// cache misses of consecutive lookups overlap: for tables which don't fit in the CPU caches this is several
+	// times faster than looking up the keys one by one.
+	//
+	// Functions which allocate return 0 on success and ENOMEM when out of memory; the table is unchanged then.
+	class EternalTimestampHashMap
+	{
+	public:
+		EternalTimestampHashMap() noexcept;
+		~EternalTimestampHashMap();
+		EternalTimestampHashMap(EternalTimestampHashMap &&other) noexcept;
+		EternalTimestampHashMap &operator=(EternalTimestampHashMap &&other) noexcept;
+		EternalTimestampHashMap(const EternalTimestampHashMap &) = delete;
+		EternalTimestampHashMap &operator=(const EternalTimestampHashMap &) = delete;
+
+		size_t size() const noexcept
+		{
+			return count_;
+		}
+
+		// Make room for `count` keys in total, so inserting those does not rehash.
+		int reserve(size_t count);
+
+		// Remove all keys; the memory is retained.
+		void clear() noexcept;
+
+		// Insert the key with its value, unless the key is present already: then its value is left as is.
+		// `inserted` MAY be NULL.
+		int insert(const eternal_timestamp_t key, uint64_t value, bool *inserted = nullptr);
+
+		// Insert or overwrite.
+		int assign(const eternal_timestamp_t key, uint64_t value);
+
+		// `value` MAY be NULL.
+		bool find(const eternal_timestamp_t key, uint64_t *value = nullptr) const noexcept;
+
+		bool contains(const eternal_timestamp_t key) const noexcept
+		{
+			return find(key, nullptr);
+		}
+
+		bool erase(const eternal_timestamp_t key) noexcept;
+
+		// Insert a column of keys with their values; `values` NULL uses the key's index in the column as its value.
+		//
+		// Keys already present, including those which occur earlier in the column, keep their value: the first
+		// occurrence wins. `inserted` (an Arrow validity-style bitmap, MAY be NULL) gets the bit set for the keys
+		// which were new, i.e. the result of deduplicating the column.
+		int insert_batch(const eternal_timestamp_t *keys, const uint64_t *values, size_t count, uint8_t *inserted);
+
+		// Look up a column of keys. Keys which are not present produce zero(0) and have their `found` bit cleared.
+		// `values` and `found` MAY be NULL. The map MUST NOT be modified meanwhile; `parallelism`: see
+		// eternal_timestamp_parallel.h.
+		//
+		// Return the number of keys found.
+		size_t find_batch(uint64_t *values, uint8_t *found, const eternal_timestamp_t *keys, size_t count, unsigned int parallelism = ETS_PARALLELISM_DEFAULT) const noexcept;
+
+	protected:
+		explicit EternalTimestampHashMap(bool with_values) noexcept;
+
+	private:
+		int rehash(size_t capacity);
+		int prepare_insert(size_t &slot, const eternal_timestamp_t key, uint64_t hash, bool &present);
+
+		uint8_t *ctrl_;
+		eternal_timestamp_t *keys_;
+		uint64_t *values_;
+		size_t capacity_;
+		size_t count_;
+		size_t growth_left_;
+		bool with_values_;
+	};
+
+	// The same without values, for deduplication and semi-joins.
+	class EternalTimestampHashSet : private EternalTimestampHashMap
+	{
+	public:
+		EternalTimestampHashSet() noexcept : EternalTimestampHashMap(false) {}
+
+		using EternalTimestampHashMap::size;
+		using EternalTimestampHashMap::reserve;
+		using EternalTimestampHashMap::clear;
+		using EternalTimestampHashMap::contains;
+		using EternalTimestampHashMap::erase;
+
+		int insert(const eternal_timestamp_t key, bool *inserted = nullptr)
+		{
+			return EternalTimestampHashMap::insert(key, 0, inserted);
+		}
+
+		int insert_batch(const eternal_timestamp_t *keys, size_t count, uint8_t *inserted)
+		{
+			return EternalTimestampHashMap::insert_batch(keys, nullptr, count, inserted);
+		}
+
+		size_t contains_batch(uint8_t *found, const eternal_timestamp_t *keys, size_t count, unsigned int parallelism = ETS_PARALLELISM_DEFAULT) const noexcept
+		{
+			return EternalTimestampHashMap::find_batch(nullptr, found, keys, count, parallelism);
+		}
+	};
+}
+
+#endif // __cplusplus
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// C interface definitions
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+// NULL when out of memory.
+ets_hash_map_t *ets_hash_map_create(size_t expected_count);
+void ets_hash_map_destroy(ets_hash_map_t *map);
+size_t ets_hash_map_size(const ets_hash_map_t *map);
+int ets_hash_map_insert(ets_hash_map_t *map, eternal_timestamp_t key, uint64_t value, int *inserted);
+int ets_hash_map_find(const ets_hash_map_t *map, eternal_timestamp_t key, uint64_t *value);
+int ets_hash_map_erase(ets_hash_map_t *map, eternal_timestamp_t key);
+int ets_hash_map_insert_batch(ets_hash_map_t *map, const eternal_timestamp_t *keys, const uint64_t *values, size_t count, uint8_t *inserted);
+size_t ets_hash_map_find_batch(const ets_hash_map_t *map, uint64_t *values, uint8_t *found, const eternal_timestamp_t *keys, size_t count);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif // __ETERNAL_TIMESTAMP_HASH_H__
@@ -0,0 +1,566 @@
+#pragma once
+
+#ifndef __ETERNAL_TIMESTAMP_LAYOUT_H__
+#define __ETERNAL_TIMESTAMP_LAYOUT_H__
+
+// Compile-time descriptions of the 64-bit timestamp layout.
+//
+// The library's own format is fixed by the field positions in `enum eternal_timestamp_field_layout` and by the
+// `ETS_UNSPECIFIED_MARKER_SORTS_BEFORE_1ST_VALUE` setting.
+// `EternalTimestampLayout` takes the position and width of every field, the position of the `mode` bit and
+// where the 'unspecified' marker sorts as template parameters, and generates the field accessors, the sort key
+// and the conversions for that format from them, including the conversions between any two layouts, so one
+// build of the library serves any number of formats:
+//
+// - `EternalTimestampLayout<>`, the default instantiation, is the library's own format: it works on the raw
+//   `eternal_timestamp_t::t` value.
+// - `EternalTimestampExtendedLayout` is the extended range variant from the design document: `mode` moves to
+//   bit 63, which buys a 10-bit century (up to 92300 AD) and 39-bit prehistoric years. Its fields are stored
+//   most significant first, so that modern timestamps compare like their sort keys as plain integers, while
+//   prehistoric timestamps are negative as `int64_t` and thus sort before all of them.
+//
+// Every field holds a code. For the century, the prehistoric years and the precision that is the value itself;
+// for the other fields it is the zero-based value (month 1 is 0, the year within the century 0..99) plus one
+// when 'unspecified' is code 0, i.e. sorts first, or plus zero when 'unspecified' is the all-ones code, i.e.
+// sorts last. The bits which are not part of a field or the `mode` bit MUST be zero(0).
+//
+// `EternalTimestampLayoutBatch` parses, renders and converts columns of timestamps in a layout from and to UNIX
+// time directly, within the full range of that layout. Timestamps in any other layout are converted to the
+// library's format to use the rest of the library with them: see `cvt_to_native()`.
+//
+// Databases written by builds with either `ETS_UNSPECIFIED_MARKER_SORTS_BEFORE_1ST_VALUE` setting hold the same
+// field positions with different codes, which `EternalTimestampUnspecifiedFirstLayout` and
+// `EternalTimestampUnspecifiedLastLayout` describe. `EternalTimestampMarkerTranscoder` picks the convention at
+// runtime and rewrites whole columns from one to the other in place, a few instructions per value.
+
+#include "eternal_timestamp/eternal_timestamp.h"
+#include "eternal_timestamp/eternal_timestamp_parallel.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+// Where the 'unspecified' marker of the fields sorts: before the first value (the code 0) or after the last
+// one (the all-ones code).
+typedef enum ets_unspecified_marker
+{
+	ETS_UNSPECIFIED_SORTS_FIRST = 0,
+	ETS_UNSPECIFIED_SORTS_LAST,
+} ets_unspecified_marker_t;
+
+// The convention of this build.
+#if ETS_UNSPECIFIED_MARKER_SORTS_BEFORE_1ST_VALUE
+#define ETS_UNSPECIFIED_NATIVE      ETS_UNSPECIFIED_SORTS_FIRST
+#else
+#define ETS_UNSPECIFIED_NATIVE      ETS_UNSPECIFIED_SORTS_LAST
+#endif
+
+#if defined(__cplusplus)
+}
+#endif
+
+#if defined(__cplusplus)
+
+#include <atomic>
+
+namespace eternal_timestamp
+{
+	// A `Width`-bit field at bit `Offset` of the 64-bit timestamp.
+	template <unsigned int Offset, unsigned int Width>
+	struct EternalTimestampField
+	{
+		static_assert(Width >= 1 && Width < 64 && Offset + Width <= 64, "a field must fit in the 64-bit timestamp");
+
+		static constexpr unsigned int offset = Offset;
+		static constexpr unsigned int width = Width;
+		static constexpr uint64_t max = ~0ULL >> (64 - Width);
+		static constexpr uint64_t mask = max << Offset;
+
+		static constexpr inline uint64_t get(const uint64_t t)
+		{
+			return (t >> Offset) & max;
+		}
+
+		static constexpr inline uint64_t set(const uint64_t t, const uint64_t code)
+		{
+			return (t & ~mask) | ((code & max) << Offset);
+		}
+	};
+
+	// The fields of the modern subformat; the defaults are those of `struct eternal_modern_timestamp`.
+	template <
+		class Century = EternalTimestampField<ETMT_CENTURY_SHIFT, ETMT_CENTURY_BITS>,
+		class Year = EternalTimestampField<ETMT_YEAR_SHIFT, ETMT_YEAR_BITS>,
+		class Month = EternalTimestampField<ETMT_MONTH_SHIFT, ETMT_MONTH_BITS>,
+		class Day = EternalTimestampField<ETMT_DAY_SHIFT, ETMT_DAY_BITS>,
+		class Hour = EternalTimestampField<ETMT_HOUR_SHIFT, ETMT_HOUR_BITS>,
+		class Minute = EternalTimestampField<ETMT_MINUTE_SHIFT, ETMT_MINUTE_BITS>,
+		class Seconds = EternalTimestampField<ETMT_SECONDS_SHIFT, ETMT_SECONDS_BITS>,
+		class Milliseconds = EternalTimestampField<ETMT_MILLISECONDS_SHIFT, ETMT_MILLISECONDS_BITS>,
+		class Microseconds = EternalTimestampField<ETMT_MICROSECONDS_SHIFT, ETMT_MICROSECONDS_BITS>
+	>
+	struct EternalTimestampModernFields
+	{
+		typedef Century century;
+		typedef Year year;
+		typedef Month month;
+		typedef Day day;
+		typedef Hour hour;
+		typedef Minute minute;
+		typedef Seconds seconds;
+		typedef Milliseconds milliseconds;
+		typedef Microseconds microseconds;
+
+		static constexpr uint64_t mask = Century::mask | Year::mask | Month::mask | Day::mask | Hour::mask | Minute::mask | Seconds::mask | Milliseconds::mask | Microseconds::mask;
+		static constexpr unsigned int width = Century::width + Year::width + Month::width + Day::width + Hour::width + Minute::width + Seconds::width + Milliseconds::width + Microseconds::width;
+
+		static_assert(Year::width >= 7 && Month::width >= 4 && Day::width >= 5 && Hour::width >= 5 && Minute::width >= 6 && Seconds::width >= 6 && Milliseconds::width >= 10 && Microseconds::width >= 10, "the fields must hold their values and 'unspecified'");
+		static_assert(width <= 63, "the fields must leave room for the mode bit");
+	};
+
+	// The fields of the prehistoric subformat; the defaults are those of `struct eternal_prehistoric_timestamp`.
+	template <
+		class Years = EternalTimestampField<ETPHT_YEARS_SHIFT, ETPHT_YEARS_BITS>,
+		class Month = EternalTimestampField<ETPHT_MONTH_SHIFT, ETPHT_MONTH_BITS>,
+		class Day = EternalTimestampField<ETPHT_DAY_SHIFT, ETPHT_DAY_BITS>,
+		class Hour = EternalTimestampField<ETPHT_HOUR_SHIFT, ETPHT_HOUR_BITS>,
+		class Minute = EternalTimestampField<ETPHT_MINUTE_SHIFT, ETPHT_MINUTE_BITS>,
+		class Precision = EternalTimestampField<ETPHT_PRECISION_SHIFT, ETPHT_PRECISION_BITS>
+	>
+	struct EternalTimestampPrehistoricFields
+	{
+		typedef Years years;
+		typedef Month month;
+		typedef Day day;
+		typedef Hour hour;
+		typedef Minute minute;
+		typedef Precision precision;
+
+		static constexpr uint64_t mask = Years::mask | Month::mask | Day::mask | Hour::mask | Minute::mask | Precision::mask;
+		static constexpr unsigned int width = Years::width + Month::width + Day::width + Hour::width + Minute::width + Precision::width;
+
+		static_assert(Years::width >= 14 && Month::width >= 4 && Day::width >= 5 && Hour::width >= 5 && Minute::width >= 6, "the fields must hold their values and 'unspecified'");
+		static_assert(width <= 63, "the fields must leave room for the mode bit");
+	};
+
+	// The number of bits set in `v`.
+	constexpr inline unsigned int ets_layout_popcount(const uint64_t v)
+	{
+		return v ? 1 + ets_layout_popcount(v & (v - 1)) : 0;
+	}
+
+	template <
+		unsigned int ModeBit = ETS_MODE_SHIFT,
+		bool UnspecifiedSortsFirst = (ETS_UNSPECIFIED_MARKER_SORTS_BEFORE_1ST_VALUE != 0),
+		class ModernFields = EternalTimestampModernFields<>,
+		class PrehistoricFields = EternalTimestampPrehistoricFields<>
+	>
+	class EternalTimestampLayout
+	{
+	public:
+		typedef ModernFields modern;
+		typedef PrehistoricFields prehistoric;
+
+		// The library's own format, which all other layouts convert to and from.
+		typedef EternalTimestampLayout<> native;
+
+		static constexpr unsigned int mode_bit = ModeBit;
+		static constexpr uint64_t mode_mask = 1ULL << ModeBit;
+		static constexpr bool unspecified_sorts_first = UnspecifiedSortsFirst;
+
+		// What the zero-based values of the fields (other than century, years and precision) are stored with.
+		static constexpr uint64_t value_offset = (UnspecifiedSortsFirst ? 1 : 0);
+
+		// The epochs are those of the library: modern centuries count from 10000 BC onwards, prehistoric years
+		// back from 0 AD.
+		static constexpr int modern_epoch = 10000;
+		static constexpr int prehistoric_epoch = 0;
+
+		static_assert(ModeBit < 64 && !(mode_mask & ModernFields::mask) && !(mode_mask & PrehistoricFields::mask), "the mode bit must be separate from the fields");
+		static_assert(ets_layout_popcount(ModernFields::mask) == ModernFields::width, "the modern fields must not overlap");
+		static_assert(ets_layout_popcount(PrehistoricFields::mask) == PrehistoricFields::width, "the prehistoric fields must not overlap");
+
+		// The code of 'unspecified' in a field of `width` bits.
+		static constexpr inline uint64_t unspecified(const unsigned int width)
+		{
+			return UnspecifiedSortsFirst ? 0 : ~0ULL >> (64 - width);
+		}
+
+		template <class F>
+		static constexpr inline bool is_unspecified(const uint64_t t)
+		{
+			return F::get(t) == unspecified(F::width);
+		}
+
+		static constexpr inline bool is_modern_format(const uint64_t t)
+		{
+			return !(t & mode_mask);
+		}
+
+		static constexpr inline bool is_prehistoric_format(const uint64_t t)
+		{
+			return !!(t & mode_mask);
+		}
+
+		// Whether all bits outside the fields of the subformat are zero(0).
+		static constexpr inline bool is_wellformed(const uint64_t t)
+		{
+			return !(t & ~(mode_mask | (is_modern_format(t) ? ModernFields::mask : PrehistoricFields::mask)));
+		}
+
+		// The modern timestamp with all fields 'unspecified'.
+		static constexpr inline uint64_t unknown()
+		{
+			return ModernFields::century::set(ModernFields::year::set(ModernFields::month::set(ModernFields::day::set(
+				ModernFields::hour::set(ModernFields::minute::set(ModernFields::seconds::set(ModernFields::milliseconds::set(
+				ModernFields::microseconds::set(0, unspecified(ModernFields::microseconds::width)),
+				unspecified(ModernFields::milliseconds::width)), unspecified(ModernFields::seconds::width)),
+				unspecified(ModernFields::minute::width)), unspecified(ModernFields::hour::width)),
+				unspecified(ModernFields::day::width)), unspecified(ModernFields::month::width)),
+				unspecified(ModernFields::year::width)), unspecified(ModernFields::century::width));
+		}
+
+		// A signed key which orders all timestamps of this layout by time, just like
+		// `EternalTimestamp::calc_sort_key()` does for the library's own format (and does produce the same keys
+		// for it). Prehistoric timestamps produce negative keys.
+		static int64_t calc_sort_key(const uint64_t t)
+		{
+			typedef PrehistoricFields P;
+			typedef ModernFields M;
+
+			uint64_t tn = t;
+			if (is_prehistoric_format(t)) {
+				const uint64_t years = P::years::get(t);
+				if (years == unspecified(P::years::width) || years + prehistoric_epoch > modern_epoch - 100) {
+					uint64_t k = P::month::get(t);
+					k = (k << P::day::width) | P::day::get(t);
+					k = (k << P::hour::width) | P::hour::get(t);
+					k = (k << P::minute::width) | P::minute::get(t);
+					k = (k << P::precision::width) | P::precision::get(t);
+
+					// the more years ago, the smaller the key (the arithmetic wraps around for the widest
+					// `years` fields, which is fine as the result is taken as two's complement):
+					const unsigned int shift = P::month::width + P::day::width + P::hour::width + P::minute::width + P::precision::width;
+					return static_cast<int64_t>(k - ((years + 1) << shift));
+				}
+
+				// non-normalized prehistoric timestamp: it shares its year with the modern subformat range.
+				const uint64_t y = static_cast<uint64_t>(modern_epoch - prehistoric_epoch) - years;
+				tn = M::century::set(0, y / 100);
+				tn = M::year::set(tn, value_offset + y % 100);
+				recode<EternalTimestampLayout, typename P::month, typename M::month, CODE_VALUE>(tn, t);
+				recode<EternalTimestampLayout, typename P::day, typename M::day, CODE_VALUE>(tn, t);
+				recode<EternalTimestampLayout, typename P::hour, typename M::hour, CODE_VALUE>(tn, t);
+				recode<EternalTimestampLayout, typename P::minute, typename M::minute, CODE_VALUE>(tn, t);
+				tn = M::seconds::set(tn, unspecified(M::seconds::width));
+				tn = M::milliseconds::set(tn, unspecified(M::milliseconds::width));
+				tn = M::microseconds::set(tn, unspecified(M::microseconds::width));
+			}
+
+			return calc_modern_sort_key(tn);
+		}
+
+		// `calc_sort_key()` for modern timestamps only: the fields, most significant first.
+		static constexpr inline int64_t calc_modern_sort_key(const uint64_t t)
+		{
+			typedef ModernFields M;
+
+			uint64_t k = M::century::get(t);
+			k = (k << M::year::width) | M::year::get(t);
+			k = (k << M::month::width) | M::month::get(t);
+			k = (k << M::day::width) | M::day::get(t);
+			k = (k << M::hour::width) | M::hour::get(t);
+			k = (k << M::minute::width) | M::minute::get(t);
+			k = (k << M::seconds::width) | M::seconds::get(t);
+			k = (k << M::milliseconds::width) | M::milliseconds::get(t);
+			k = (k << M::microseconds::width) | M::microseconds::get(t);
+			return static_cast<int64_t>(k);
+		}
+
+		// Convert `t` from layout `From` to this one. Every field keeps its value, 'unspecified' stays
+		// 'unspecified'. Returns -1, having set `dst` to `unknown()`, when `t` has bits set outside its fields or
+		// when a value does not fit this layout.
+		template <class From>
+		static int cvt_from_layout(uint64_t &dst, const uint64_t t)
+		{
+			typedef typename From::modern FM;
+			typedef typename From::prehistoric FP;
+			typedef ModernFields M;
+			typedef PrehistoricFields P;
+
+			uint64_t v = 0;
+			bool ok = From::is_wellformed(t);
+			if (From::is_modern_format(t)) {
+				ok = recode<From, typename FM::century, typename M::century, CODE_PLAIN>(v, t) && ok;
+				ok = recode<From, typename FM::year, typename M::year, CODE_VALUE>(v, t) && ok;
+				ok = recode<From, typename FM::month, typename M::month, CODE_VALUE>(v, t) && ok;
+				ok = recode<From, typename FM::day, typename M::day, CODE_VALUE>(v, t) && ok;
+				ok = recode<From, typename FM::hour, typename M::hour, CODE_VALUE>(v, t) && ok;
+				ok = recode<From, typename FM::minute, typename M::minute, CODE_VALUE>(v, t) && ok;
+				ok = recode<From, typename FM::seconds, typename M::seconds, CODE_VALUE>(v, t) && ok;
+				ok = recode<From, typename FM::milliseconds, typename M::milliseconds, CODE_VALUE>(v, t) && ok;
+				ok = recode<From, typename FM::microseconds, typename M::microseconds, CODE_VALUE>(v, t) && ok;
+			}
+			else {
+				v = mode_mask;
+				ok = recode<From, typename FP::years, typename P::years, CODE_PLAIN>(v, t) && ok;
+				ok = recode<From, typename FP::month, typename P::month, CODE_VALUE>(v, t) && ok;
+				ok = recode<From, typename FP::day, typename P::day, CODE_VALUE>(v, t) && ok;
+				ok = recode<From, typename FP::hour, typename P::hour, CODE_VALUE>(v, t) && ok;
+				ok = recode<From, typename FP::minute, typename P::minute, CODE_VALUE>(v, t) && ok;
+				ok = recode<From, typename FP::precision, typename P::precision, CODE_RAW>(v, t) && ok;
+			}
+			dst = (ok ? v : unknown());
+			return ok ? 0 : -1;
+		}
+
+		// Convert `t` from this layout to layout `To`: see `cvt_from_layout()`.
+		template <class To>
+		static int cvt_to_layout(uint64_t &dst, const uint64_t t)
+		{
+			return To::template cvt_from_layout<EternalTimestampLayout>(dst, t);
+		}
+
+		// Convert to and from the library's own format, as used by `EternalTimestamp` and the other modules.
+		static int cvt_to_native(eternal_timestamp_t &dst, const uint64_t t)
+		{
+			return native::template cvt_from_layout<EternalTimestampLayout>(dst.t, t);
+		}
+
+		static int cvt_from_native(uint64_t &dst, const eternal_timestamp_t t)
+		{
+			return cvt_from_layout<native>(dst, t.t);
+		}
+
+		// `EternalTimestamp::cvt_to_timeinfo_struct()` and `EternalTimestamp::cvt_from_timeinfo_struct()` for
+		// this layout.
+		static int cvt_to_timeinfo_struct(struct eternal_time_tm &dst, const uint64_t t)
+		{
+			eternal_timestamp_t n;
+			if (cvt_to_native(n, t))
+				return -1;
+			return EternalTimestamp::cvt_to_timeinfo_struct(dst, n);
+		}
+
+		static int cvt_from_timeinfo_struct(uint64_t &dst, const struct eternal_time_tm &t)
+		{
+			eternal_timestamp_t n;
+			if (EternalTimestamp::cvt_from_timeinfo_struct(n, t)) {
+				dst = unknown();
+				return -1;
+			}
+			return cvt_from_native(dst, n);
+		}
+
+		// Batch versions of the above. `validity` bitmaps and `parallelism` work as with `EternalTimestampBatch`:
+		// values which fail have their `validity` bit cleared, all others have it set. Return the number of
+		// values which failed.
+		template <class From>
+		static size_t cvt_from_layout_batch(uint64_t *dst, uint8_t *validity, const uint64_t *src, size_t count, unsigned int parallelism = ETS_PARALLELISM_DEFAULT)
+		{
+			return convert_batch(validity, count, parallelism, [dst, src](size_t i) {
+				return cvt_from_layout<From>(dst[i], src[i]) == 0;
+			});
+		}
+
+		static size_t cvt_to_native_batch(eternal_timestamp_t *dst, uint8_t *validity, const uint64_t *src, size_t count, unsigned int parallelism = ETS_PARALLELISM_DEFAULT)
+		{
+			return convert_batch(validity, count, parallelism, [dst, src](size_t i) {
+				return cvt_to_native(dst[i], src[i]) == 0;
+			});
+		}
+
+		static size_t cvt_from_native_batch(uint64_t *dst, uint8_t *validity, const eternal_timestamp_t *src, size_t count, unsigned int parallelism = ETS_PARALLELISM_DEFAULT)
+		{
+			return convert_batch(validity, count, parallelism, [dst, src](size_t i) {
+				return cvt_from_native(dst[i], src[i]) == 0;
+			});
+		}
+
+		static void calc_sort_key_batch(int64_t *dst, const uint64_t *src, size_t count, unsigned int parallelism = ETS_PARALLELISM_DEFAULT)
+		{
+			EternalTimestampParallel::parallel_for(count, ETS_PARALLEL_GRAIN, parallelism, [dst, src](size_t begin, size_t end) {
+				for (size_t i = begin; i < end; i++)
+					dst[i] = calc_sort_key(src[i]);
+			});
+		}
+
+	private:
+		enum code_kind
+		{
+			CODE_PLAIN,     // the value itself, 'unspecified' being a reserved code (century, years)
+			CODE_VALUE,     // the zero-based value plus `value_offset`
+			CODE_RAW,       // the value itself, without 'unspecified' (precision)
+		};
+
+		// Copy field `FromF` of `t`, in layout `From`, to field `ToF` of `dst`, in this layout. Returns `false`
+		// when the value does not fit.
+		template <class From, class FromF, class ToF, code_kind Kind>
+		static bool recode(uint64_t &dst, const uint64_t t)
+		{
+			const uint64_t c = FromF::get(t);
+			uint64_t code = c;
+			if (Kind != CODE_RAW) {
+				if (c == From::unspecified(FromF::width)) {
+					dst = ToF::set(dst, unspecified(ToF::width));
+					return true;
+				}
+				if (Kind == CODE_VALUE)
+					code = c - From::value_offset + value_offset;
+				if (code == unspecified(ToF::width))
+					return false;
+			}
+			if (code > ToF::max)
+				return false;
+			dst = ToF::set(dst, code);
+			return true;
+		}
+
+		// Run `convert(i)` for all values, on up to `parallelism` threads, and set the validity bits.
+		template <typename F>
+		static size_t convert_batch(uint8_t *validity, size_t count, unsigned int parallelism, F &&convert)
+		{
+			std::atomic<size_t> failures{ 0 };
+			EternalTimestampParallel::parallel_for(count, ETS_PARALLEL_GRAIN, parallelism, [&](size_t begin, size_t end) {
+				size_t failed = 0;
+				size_t i = begin;
+				// `begin` is a multiple of the grain, hence of 8: whole validity bytes, but for the last one.
+				for (; i + 8 <= end; i += 8) {
+					unsigned int bits = 0;
+					for (unsigned int j = 0; j < 8; j++)
+						bits |= (convert(i + j) ? 1U : 0U) << j;
+					failed += 8 - ets_layout_popcount(bits);
+					if (validity)
+						validity[i / 8] = static_cast<uint8_t>(bits);
+				}
+				for (; i < end; i++) {
+					const bool ok = convert(i);
+					failed += !ok;
+					if (validity) {
+						const uint8_t bit = static_cast<uint8_t>(1U << (i % 8));
+						validity[i / 8] = static_cast<uint8_t>(ok ? validity[i / 8] | bit : validity[i / 8] & ~bit);
+					}
+				}
+				if (failed)
+					failures.fetch_add(failed, std::memory_order_relaxed);
+			});
+			return failures.load(std::memory_order_relaxed);
+		}
+	};
+
+	// The extended range variant: `mode` at bit 63 and the fields most significant first.
+	typedef EternalTimestampLayout<
+		63,
+		(ETS_UNSPECIFIED_MARKER_SORTS_BEFORE_1ST_VALUE != 0),
+		EternalTimestampModernFields<
+			EternalTimestampField<53, 10>,
+			EternalTimestampField<46, 7>,
+			EternalTimestampField<42, 4>,
+			EternalTimestampField<37, 5>,
+			EternalTimestampField<32, 5>,
+			EternalTimestampField<26, 6>,
+			EternalTimestampField<20, 6>,
+			EternalTimestampField<10, 10>,
+			EternalTimestampField<0, 10>
+		>,
+		EternalTimestampPrehistoricFields<
+			EternalTimestampField<24, 39>,
+			EternalTimestampField<20, 4>,
+			EternalTimestampField<15, 5>,
+			EternalTimestampField<10, 5>,
+			EternalTimestampField<4, 6>,
+			EternalTimestampField<0, 4>
+		>
+	> EternalTimestampExtendedLayout;
+
+	// The library's format with either 'unspecified' convention; one of them is `EternalTimestampLayout<>`.
+	typedef EternalTimestampLayout<ETS_MODE_SHIFT, true> EternalTimestampUnspecifiedFirstLayout;
+	typedef EternalTimestampLayout<ETS_MODE_SHIFT, false> EternalTimestampUnspecifiedLastLayout;
+
+	// The conversions of `EternalTimestampBatch` for timestamps in layout `Layout`, passed as plain 64-bit
+	// integers: they encode and decode the fields of `Layout` directly, so they cover the whole range of the
+	// layout, e.g. up to 92399 AD with `EternalTimestampExtendedLayout`, where a round trip through the
+	// library's format would stop at 41199 AD. Everything else, including `validity`, `parallelism` and the
+	// return values, works as described there.
+	//
+	// Defined for `EternalTimestampUnspecifiedFirstLayout`, `EternalTimestampUnspecifiedLastLayout` (one of
+	// which is `EternalTimestampLayout<>`) and `EternalTimestampExtendedLayout`.
+	template <class Layout>
+	class EternalTimestampLayoutBatch
+	{
+	public:
+		static size_t cvt_from_unix_usecs(uint64_t *dst, uint8_t *validity, const int64_t *src, size_t count, unsigned int parallelism = ETS_PARALLELISM_DEFAULT);
+		static size_t cvt_from_unix_msecs(uint64_t *dst, uint8_t *validity, const int64_t *src, size_t count, unsigned int parallelism = ETS_PARALLELISM_DEFAULT);
+		static size_t cvt_from_unix_seconds(uint64_t *dst, uint8_t *validity, const int64_t *src, size_t count, unsigned int parallelism = ETS_PARALLELISM_DEFAULT);
+		static size_t cvt_from_unix_days(uint64_t *dst, uint8_t *validity, const int32_t *src, size_t count, unsigned int parallelism = ETS_PARALLELISM_DEFAULT);
+
+		static size_t cvt_to_unix_usecs(int64_t *dst, uint8_t *validity, const uint64_t *src, size_t count, unsigned int parallelism = ETS_PARALLELISM_DEFAULT);
+		static size_t cvt_to_unix_msecs(int64_t *dst, uint8_t *validity, const uint64_t *src, size_t count, unsigned int parallelism = ETS_PARALLELISM_DEFAULT);
+		static size_t cvt_to_unix_seconds(int64_t *dst, uint8_t *validity, const uint64_t *src, size_t count, unsigned int parallelism = ETS_PARALLELISM_DEFAULT);
+		static size_t cvt_to_unix_days(int32_t *dst, uint8_t *validity, const uint64_t *src, size_t count, unsigned int parallelism = ETS_PARALLELISM_DEFAULT);
+
+		static size_t cvt_from_iso8601_column(uint64_t *dst, uint8_t *validity, const char *data, const int32_t *offsets, size_t count, unsigned int parallelism = ETS_PARALLELISM_DEFAULT);
+		static size_t cvt_to_rfc3339_column(char *data, size_t capacity, int32_t *offsets, uint8_t *validity, const uint64_t *src, size_t start, size_t count, unsigned int parallelism = ETS_PARALLELISM_DEFAULT);
+	};
+
+	extern template class EternalTimestampLayoutBatch<EternalTimestampUnspecifiedFirstLayout>;
+	extern template class EternalTimestampLayoutBatch<EternalTimestampUnspecifiedLastLayout>;
+	extern template class EternalTimestampLayoutBatch<EternalTimestampExtendedLayout>;
+
+	// Rewrite timestamps in the library's format from one 'unspecified' convention to the other, with the
+	// conventions picked at runtime: what `EternalTimestampUnspecifiedLastLayout::cvt_from_layout<
+	// EternalTimestampUnspecifiedFirstLayout>()` and the reverse do. Every field keeps its value, 'unspecified'
+	// stays 'unspecified': the value fields shift their codes by one, the century and the prehistoric years swap
+	// their reserved codes.
+	//
+	// The values fail, i.e. become the target's `unknown()` and -1 is returned, when they are malformed (the sign
+	// bit is set) or when their century or prehistoric years is the target's 'unspecified' code, which that
+	// convention cannot represent. Transcoding to the same convention only checks the values.
+	class EternalTimestampMarkerTranscoder
+	{
+	public:
+		static int transcode(uint64_t &dst, const uint64_t t, ets_unspecified_marker_t from, ets_unspecified_marker_t to);
+
+		// The batch version, SWAR / SSE2 where the build targets it. `dst` may be `src` (in-place), e.g. a memory
+		// mapped column, but the buffers MUST NOT overlap otherwise. `validity` and `parallelism` work as with
+		// `EternalTimestampBatch`. Returns the number of values which failed.
+		static size_t transcode_batch(uint64_t *dst, uint8_t *validity, const uint64_t *src, size_t count, ets_unspecified_marker_t from, ets_unspecified_marker_t to, unsigned int parallelism = ETS_PARALLELISM_DEFAULT);
+	};
+}
+
+#endif // __cplusplus
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// C interface definitions
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+// Conversions between the library's format and the extended range layout (`EternalTimestampExtendedLayout`),
+// whose values are passed as plain 64-bit integers. These return -1, and the batch versions clear the `validity`
+// bit, when the value does not fit the other layout.
+int ets_layout_cvt_to_extended(uint64_t *dst, const eternal_timestamp_t t);
+int ets_layout_cvt_from_extended(eternal_timestamp_t *dst, const uint64_t t);
+int64_t ets_layout_extended_sort_key(const uint64_t t);
+
+size_t ets_layout_cvt_to_extended_batch(uint64_t *dst, uint8_t *validity, const eternal_timestamp_t *src, size_t count);
+size_t ets_layout_cvt_from_extended_batch(eternal_timestamp_t *dst, uint8_t *validity, const uint64_t *src, size_t count);
+
+// `EternalTimestampLayoutBatch<EternalTimestampExtendedLayout>::cvt_from_unix_usecs()` and `cvt_to_unix_usecs()`.
+size_t ets_layout_extended_cvt_from_unix_usecs(uint64_t *dst, uint8_t *validity, const int64_t *src, size_t count);
+size_t ets_layout_extended_cvt_to_unix_usecs(int64_t *dst, uint8_t *validity, const uint64_t *src, size_t count);
+
+// See `EternalTimestampMarkerTranscoder`.
+int ets_layout_transcode_markers(uint64_t *dst, const uint64_t t, ets_unspecified_marker_t from, ets_unspecified_marker_t to);
+size_t ets_layout_transcode_markers_batch(uint64_t *dst, uint8_t *validity, const uint64_t *src, size_t count, ets_unspecified_marker_t from, ets_unspecified_marker_t to);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif // __ETERNAL_TIMESTAMP_LAYOUT_H__
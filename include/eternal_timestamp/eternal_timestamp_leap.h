@@ -0,0 +1,129 @@
+
+#pragma once
+
+#ifndef __ETERNAL_TIMESTAMP_LEAP_H__
+#define __ETERNAL_TIMESTAMP_LEAP_H__
+
+// Leap seconds and the TAI and GPS time scales.
+//
+// UTC timestamps may carry a leap second: 23:59:60, which the 6-bit `seconds` field represents just fine. The
+// conversions here produce and consume those. TAI and GPS timestamps are the calendar reading of the respective
+// time scale, which has no leap seconds: GPS = TAI - 19s, TAI = UTC + (TAI - UTC), the latter from the leap
+// second table.
+//
+// The table is compiled in and can be replaced at run-time, e.g. from the IERS `leap-seconds.list` file which
+// most systems carry along with their zoneinfo database. UTC before 1972, when UTC seconds were not yet SI
+// seconds, is approximated using the 1972 offset of 10 seconds.
+//
+// GPS week/second counts convert to a GPS calendar reading with `EternalTimestampBatch::cvt_from_unix_usecs()`
+// after adding the GPS epoch, `ETS_GPS_EPOCH_UNIX_SECONDS`.
+
+#include "eternal_timestamp/eternal_timestamp.h"
+#include "eternal_timestamp/eternal_timestamp_parallel.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+// GPS time started at 1980/jan/06 00:00:00 UTC, when TAI - UTC was 19 seconds, i.e. GPS = TAI - 19s.
+#define ETS_GPS_EPOCH_UNIX_SECONDS    315964800
+#define ETS_TAI_MINUS_GPS             19
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+// A leap second table entry: from `utc_seconds` (seconds since 1970/jan/01 00:00:00 UTC, not counting leap
+// seconds, i.e. a POSIX `time_t`) onwards TAI - UTC is `tai_minus_utc` seconds.
+typedef struct ets_leap_second
+{
+	int64_t utc_seconds;
+	int32_t tai_minus_utc;
+} ets_leap_second_t;
+
+enum ets_time_scale
+{
+	ETS_SCALE_UTC = 0,
+	ETS_SCALE_TAI,
+	ETS_SCALE_GPS,
+};
+
+#if defined(__cplusplus)
+}
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// C++ interface definitions
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if defined(__cplusplus)
+
+namespace eternal_timestamp
+{
+	class EternalTimestampLeapSeconds
+	{
+	public:
+		// Replace the leap second table. Entries MUST be in ascending order and each step MUST be a single leap
+		// second (+1 or -1). `expires` is when the table may be outdated (same unit as `utc_seconds`; 0 if unknown).
+		// The table is copied. Thread-safe: conversions running concurrently use either the old or the new table.
+		//
+		// Returns 0 on success, an `errno` value otherwise: EINVAL, ENOMEM.
+		static int set_table(const ets_leap_second_t *entries, size_t count, int64_t expires);
+
+		// Load the table from an IERS / NTP `leap-seconds.list` file; NULL loads the system's copy in
+		// `$TZDIR` or `/usr/share/zoneinfo`.
+		//
+		// Returns 0 on success, an `errno` value otherwise: ENOENT, EINVAL, ENOMEM.
+		static int load_table(const char *path);
+
+		// Restore the compiled-in table.
+		static void reset_table();
+
+		// When the current table may be outdated: the IERS announces leap seconds about six months in advance.
+		static int64_t table_expiry();
+
+		// TAI - UTC in effect at the given moment (seconds since 1970/jan/01 00:00:00 UTC, not counting leap seconds).
+		static int32_t tai_minus_utc(int64_t utc_seconds);
+
+		// Convert timestamps between time scales. `dst` MAY be the same as `src`. `parallelism`: see
+		// eternal_timestamp_parallel.h.
+		//
+		// The timestamps must be complete down to the second; milliseconds and microseconds are copied as is,
+		// including their 'unspecified' marker. UTC input may carry a leap second (:60), but only where the table
+		// has one. All other timestamps (partial, prehistoric ones, ones with a field out of its range such as
+		// feb/30) are copied unchanged and have their `validity` bit cleared; the converted ones have it set.
+		//
+		// Return the number of timestamps which could not be converted.
+		static size_t cvt_time_scale(eternal_timestamp_t *dst, uint8_t *validity, const eternal_timestamp_t *src, size_t count, ets_time_scale from, ets_time_scale to, unsigned int parallelism = ETS_PARALLELISM_DEFAULT);
+
+		// The elapsed time `to[i] - from[i]` between UTC timestamps in microseconds, counting the leap seconds in
+		// between. Unspecified time-of-day fields are taken as zero(0); timestamps lacking any of century, year,
+		// month or day, or with a field out of its range, produce zero(0) and have their `validity` bit cleared.
+		//
+		// Return the number of deltas which could not be calculated.
+		static size_t calc_delta_usecs(int64_t *dst, uint8_t *validity, const eternal_timestamp_t *from, const eternal_timestamp_t *to, size_t count, unsigned int parallelism = ETS_PARALLELISM_DEFAULT);
+	};
+}
+
+#endif // __cplusplus
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// C interface definitions
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+int ets_leap_set_table(const ets_leap_second_t *entries, size_t count, int64_t expires);
+int ets_leap_load_table(const char *path);
+void ets_leap_reset_table(void);
+int64_t ets_leap_table_expiry(void);
+int32_t ets_leap_tai_minus_utc(int64_t utc_seconds);
+size_t ets_leap_cvt_time_scale(eternal_timestamp_t *dst, uint8_t *validity, const eternal_timestamp_t *src, size_t count, enum ets_time_scale from, enum ets_time_scale to);
+size_t ets_leap_calc_delta_usecs(int64_t *dst, uint8_t *validity, const eternal_timestamp_t *from, const eternal_timestamp_t *to, size_t count);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif // __ETERNAL_TIMESTAMP_LEAP_H__
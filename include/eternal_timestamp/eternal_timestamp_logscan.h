@@ -0,0 +1,116 @@
+
+#pragma once
+
+#ifndef __ETERNAL_TIMESTAMP_LOGSCAN_H__
+#define __ETERNAL_TIMESTAMP_LOGSCAN_H__
+
+// Log line timestamp scanner.
+//
+// Extracts the timestamp of every line in a (large) buffer of log text. The log format is detected once per
+// stream; after that a parser specialized for that format's fixed layout is run on every line.
+//
+// The scanner never allocates: all state lives in the caller-provided `ets_logscan_state_t`.
+
+#include "eternal_timestamp/eternal_timestamp.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+typedef enum ets_log_format
+{
+	ETS_LOG_FORMAT_UNKNOWN = 0,
+
+	ETS_LOG_FORMAT_RFC3339,          // 2022-01-13T12:40:31.049352Z ..., also '2022-01-13 12:40:31,049 ...' and '[2022-01-13T12:40:31+01:00] ...'
+	ETS_LOG_FORMAT_SYSLOG_RFC5424,   // <34>1 2022-01-13T12:40:31.049Z host app ...
+	ETS_LOG_FORMAT_SYSLOG_RFC3164,   // <34>Jan 13 12:40:31 host app: ...  (the <PRI> part is optional)
+	ETS_LOG_FORMAT_COMMON_LOG,       // nginx/Apache access log: 127.0.0.1 - - [13/Jan/2022:12:40:31 +0000] "GET / HTTP/1.1" ...
+	ETS_LOG_FORMAT_NGINX_ERROR,      // 2022/01/13 12:40:31 [error] 1234#0: ...
+	ETS_LOG_FORMAT_APACHE_ERROR,     // [Thu Jan 13 12:40:31.049352 2022] [core:error] ...
+} ets_log_format_t;
+
+// Scanner state. Initialize with `ets_logscan_init()`.
+typedef struct ets_logscan_state
+{
+	ets_log_format_t format;           // the detected (or preset) log format
+
+	// RFC 3164 syslog lines don't carry the year: this is the year we assume. It is advanced when the month
+	// jumps backwards by more than half a year, i.e. when the log crosses new year.
+	int year;
+	int last_month;
+
+	// cache of the last encoded date: most lines in a log share their date.
+	uint32_t cached_date_key;
+	eternal_timestamp_t cached_date;
+} ets_logscan_state_t;
+
+#if defined(__cplusplus)
+}
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// C++ interface definitions
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if defined(__cplusplus)
+
+namespace eternal_timestamp
+{
+	class EternalTimestampLogScan
+	{
+	public:
+		// Prepare `state` for scanning a new stream. Pass `ETS_LOG_FORMAT_UNKNOWN` to have the format detected
+		// from the first line which carries a recognizable timestamp. `year` is the year assumed for RFC 3164
+		// syslog lines; pass 0 to use the current (UTC) year.
+		static void init(ets_logscan_state_t &state, ets_log_format_t format = ETS_LOG_FORMAT_UNKNOWN, int year = 0);
+
+		// Detect the format of the given log line; returns `ETS_LOG_FORMAT_UNKNOWN` when none matches.
+		static ets_log_format_t detect_format(const char *line, size_t length);
+
+		// Parse the timestamp at the start of a single line (for the Common Log Format: the first bracketed field).
+		//
+		// Timestamps which carry a UTC offset are converted to UTC; all others are produced as-is, i.e. in the
+		// local time of the log writer. Timestamps without fractional seconds have their milliseconds and
+		// microseconds marked 'unspecified'.
+		//
+		// Returns `false` when the line doesn't start with a timestamp in the state's format; `dst` is then
+		// set to a timestamp with all fields 'unspecified'.
+		static bool parse_line(eternal_timestamp_t &dst, ets_logscan_state_t &state, const char *line, size_t length);
+
+		// Scan up to `capacity` lines of `buffer`, producing the timestamp of each line in `timestamps` and
+		// the offset of each line's first character in `line_offsets` (which MAY be NULL).
+		//
+		// Lines without a timestamp (e.g. stack traces) produce timestamps with all fields 'unspecified'.
+		//
+		// Only complete, i.e. newline-terminated lines are processed, unless `at_eof` is set, in which case the
+		// last line need not be terminated. `consumed` is set to the number of bytes processed: continue with
+		// the remainder of `buffer` (plus whatever follows it) in the next call.
+		//
+		// Returns the number of lines scanned.
+		static size_t scan(eternal_timestamp_t *timestamps, size_t *line_offsets, size_t capacity, ets_logscan_state_t &state, const char *buffer, size_t length, bool at_eof, size_t &consumed);
+	};
+}
+
+#endif // __cplusplus
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// C interface definitions
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+void ets_logscan_init(ets_logscan_state_t *state, ets_log_format_t format, int year);
+ets_log_format_t ets_logscan_detect_format(const char *line, size_t length);
+BOOL ets_logscan_parse_line(eternal_timestamp_t *dst, ets_logscan_state_t *state, const char *line, size_t length);
+size_t ets_logscan_scan(eternal_timestamp_t *timestamps, size_t *line_offsets, size_t capacity, ets_logscan_state_t *state, const char *buffer, size_t length, BOOL at_eof, size_t *consumed);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif // __ETERNAL_TIMESTAMP_LOGSCAN_H__
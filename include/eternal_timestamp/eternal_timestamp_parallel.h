@@ -0,0 +1,158 @@
+
+#pragma once
+
+#ifndef __ETERNAL_TIMESTAMP_PARALLEL_H__
+#define __ETERNAL_TIMESTAMP_PARALLEL_H__
+
+// Running the bulk APIs on multiple cores.
+//
+// All column-at-a-time APIs (`EternalTimestampBatch`, the Arrow import/export, the time scale and time zone
+// conversions, ...) take a trailing `parallelism` hint: the number of threads they may use. The column is cut
+// into chunks of `ETS_PARALLEL_GRAIN` values, which keeps each chunk's input and output well within the L2
+// cache, and the threads take chunks off each other's share when they run out of work (work stealing), so a
+// thread which gets descheduled or lands on a slow core does not hold up the rest.
+//
+// The threads come from an executor: by default a thread pool which the library starts on first use, with one
+// thread per hardware thread (the calling thread makes up one of them), which lives until the process exits.
+// Applications which have a thread pool of their own can hand the library an `ets_executor_t` instead.
+//
+// Hints:
+// - `ETS_PARALLELISM_DEFAULT` (the default argument) uses the process-wide default, which the C interface
+//   uses as well; it is 1 unless set with `EternalTimestampParallel::set_default_parallelism()`.
+// - 1 runs on the calling thread only, which is what the library did before, hence the initial default.
+// - `ETS_PARALLELISM_ALL` uses all the threads the executor offers; any other value caps the thread count.
+//
+// Columns which fit in a single chunk are always processed on the calling thread, as are the calls made from
+// within a parallel region, e.g. from a `parallel_for()` body.
+
+#include "eternal_timestamp/eternal_timestamp.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define ETS_PARALLELISM_DEFAULT     0U
+#define ETS_PARALLELISM_ALL         0xFFFFFFFFU
+
+// The number of values per chunk used by the bulk APIs. A multiple of 64, so that each chunk covers whole bytes
+// of a validity bitmap and whole cache lines of the value arrays.
+#define ETS_PARALLEL_GRAIN          4096
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+// An executor, for running the bulk APIs on threads provided by the application.
+//
+// `run()` MUST call `work(arg, i)` once for each `i` in [0, `workers`), on as many threads as it can spare
+// (the calling thread included), and return once all calls have returned. Any of these calls does all the
+// work when the others find nothing left, so running them one after the other is fine too, just slower.
+// `workers` never exceeds `concurrency`.
+typedef struct ets_executor
+{
+	void (*run)(void *context, void (*work)(void *arg, unsigned int worker), void *arg, unsigned int workers);
+	void *context;
+	unsigned int concurrency;
+} ets_executor_t;
+
+// A pool of worker threads. Opaque.
+typedef struct ets_thread_pool ets_thread_pool_t;
+
+#if defined(__cplusplus)
+}
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// C++ interface definitions
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if defined(__cplusplus)
+
+#include <type_traits>
+
+namespace eternal_timestamp
+{
+	class EternalTimestampThreadPool
+	{
+	public:
+		// Start a pool with `threads` worker threads; together with the thread which hands it work, that makes
+		// for a concurrency of `threads + 1`. Returns NULL when the threads cannot be started.
+		static ets_thread_pool_t *create(unsigned int threads);
+
+		// Stop and join the threads. The pool MUST NOT be in use, nor be the installed executor.
+		static void destroy(ets_thread_pool_t *pool);
+
+		// An executor which runs on `pool`: install it with `EternalTimestampParallel::set_executor()`.
+		static ets_executor_t executor(ets_thread_pool_t *pool);
+	};
+
+	class EternalTimestampParallel
+	{
+	public:
+		// Run the bulk APIs on `executor`; NULL reinstates the library's own thread pool. The executor is copied.
+		//
+		// Install it before handing the library work from multiple threads: calls already running keep using
+		// the executor they started with.
+		static void set_executor(const ets_executor_t *executor);
+
+		// The process-wide `parallelism` used when a call passes `ETS_PARALLELISM_DEFAULT`. Initially 1.
+		static void set_default_parallelism(unsigned int parallelism);
+		static unsigned int default_parallelism();
+
+		// The number of threads a call with the given hint would use at most.
+		static unsigned int concurrency(unsigned int parallelism = ETS_PARALLELISM_ALL);
+
+		// Call `body(begin, end)` for non-overlapping ranges which together cover [0, `count`), from up to
+		// `parallelism` threads, and return when all have been processed. The ranges consist of whole chunks of
+		// `grain` indexes (0: `ETS_PARALLEL_GRAIN`): `begin` is a multiple of `grain`, `end` is one too or equals
+		// `count`. Run on a single thread, this is a single call covering everything.
+		//
+		// `body` MUST NOT throw.
+		template <typename F>
+		static void parallel_for(size_t count, size_t grain, unsigned int parallelism, F &&body)
+		{
+			typedef typename std::remove_reference<F>::type body_type;
+			run(count, grain, parallelism, [](void *ctx, size_t begin, size_t end) {
+				(*static_cast<body_type *>(ctx))(begin, end);
+			}, const_cast<void *>(static_cast<const void *>(&body)));
+		}
+
+		// Call `body(span, length, offset)` for consecutive sub-spans of the column, `offset` being the index
+		// of `span[0]` in the column: the same as above in chunks of `ETS_PARALLEL_GRAIN` timestamps.
+		template <typename T, typename F>
+		static void parallel_for(T *values, size_t count, unsigned int parallelism, F &&body)
+		{
+			parallel_for(count, ETS_PARALLEL_GRAIN, parallelism, [&](size_t begin, size_t end) {
+				body(values + begin, end - begin, begin);
+			});
+		}
+
+		// The type-erased form of `parallel_for()`, which is also what the C interface offers.
+		static void run(size_t count, size_t grain, unsigned int parallelism, void (*body)(void *ctx, size_t begin, size_t end), void *ctx);
+	};
+}
+
+#endif // __cplusplus
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// C interface definitions
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+ets_thread_pool_t *ets_thread_pool_create(unsigned int threads);
+void ets_thread_pool_destroy(ets_thread_pool_t *pool);
+ets_executor_t ets_thread_pool_executor(ets_thread_pool_t *pool);
+
+void ets_parallel_set_executor(const ets_executor_t *executor);
+void ets_parallel_set_default_parallelism(unsigned int parallelism);
+unsigned int ets_parallel_default_parallelism(void);
+unsigned int ets_parallel_concurrency(unsigned int parallelism);
+void ets_parallel_for(size_t count, size_t grain, unsigned int parallelism, void (*body)(void *ctx, size_t begin, size_t end), void *ctx);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif // __ETERNAL_TIMESTAMP_PARALLEL_H__
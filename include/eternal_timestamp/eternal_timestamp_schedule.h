@@ -0,0 +1,173 @@
+#pragma once
+
+#ifndef __ETERNAL_TIMESTAMP_SCHEDULE_H__
+#define __ETERNAL_TIMESTAMP_SCHEDULE_H__
+
+// Recurrence rules: expand a schedule such as "every weekday at 09:00", "the last day of each month" or "hourly
+// within business hours" into its occurrences.
+//
+// A rule is a subset of the iCalendar RRULE (RFC 5545): a frequency, an interval, a COUNT or UNTIL limit and the
+// BYMONTH, BYMONTHDAY, BYDAY, BYHOUR, BYMINUTE and BYSECOND parts, without ordinals (BYDAY=-1FR), BYSETPOS,
+// BYYEARDAY or BYWEEKNO; weeks start on Monday. As in RFC 5545, a BYxxx part coarser than the frequency limits
+// the occurrences (FREQ=DAILY;BYDAY=MO,TU), a finer one expands them (FREQ=MONTHLY;BYMONTHDAY=1,15), and the
+// parts which are not given are taken from the base timestamp (DTSTART) where they are finer than the frequency.
+// Occurrences before the base are skipped.
+//
+// The generator works on bit sets rather than dates: the days of a month which match the rule are computed at
+// once, as a 31-bit mask built from the month length, the weekday of its first day and the rule's sets, after
+// which the hours, minutes and seconds of each day are the set bits of 64-bit masks. Every occurrence is then
+// produced by OR-ing the packed fields of its day and time; no calendar arithmetic is done per occurrence, and
+// no `struct tm` is used at all.
+//
+// Like the log scanner, the generator never allocates: all state lives in the caller-provided
+// `ets_schedule_t`, which can be drained in chunks of any size. Rules without COUNT or UNTIL run until the end
+// of the modern timestamp range, so take what you need.
+
+#include "eternal_timestamp/eternal_timestamp.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+typedef enum ets_schedule_frequency
+{
+	ETS_SCHEDULE_YEARLY = 0,
+	ETS_SCHEDULE_MONTHLY,
+	ETS_SCHEDULE_WEEKLY,
+	ETS_SCHEDULE_DAILY,
+	ETS_SCHEDULE_HOURLY,
+	ETS_SCHEDULE_MINUTELY,
+	ETS_SCHEDULE_SECONDLY,
+} ets_schedule_frequency_t;
+
+// The bits of `ets_schedule_rule_t::by_weekday`.
+#define ETS_SCHEDULE_MONDAY         0x01
+#define ETS_SCHEDULE_TUESDAY        0x02
+#define ETS_SCHEDULE_WEDNESDAY      0x04
+#define ETS_SCHEDULE_THURSDAY       0x08
+#define ETS_SCHEDULE_FRIDAY         0x10
+#define ETS_SCHEDULE_SATURDAY       0x20
+#define ETS_SCHEDULE_SUNDAY         0x40
+#define ETS_SCHEDULE_WORKDAYS       0x1F
+
+typedef struct ets_schedule_rule
+{
+	ets_schedule_frequency_t frequency;
+	uint32_t interval;                   // every `interval` years, months, ...; 0 is taken as 1
+	uint64_t count;                      // at most this many occurrences; 0: no limit
+	eternal_timestamp_t until;           // no occurrences after this (inclusive, to the second; a partial timestamp
+	                                     // such as 2030-06 includes all of June); `ets_unknown()`: no limit
+
+	// The BYxxx parts as bit sets; 0 where the part is not given.
+	uint16_t by_month;                   // bit m - 1: month m
+	uint8_t by_weekday;                  // ETS_SCHEDULE_MONDAY, ...
+	uint32_t by_month_day;               // bit d - 1: day d of the month
+	uint32_t by_month_day_from_end;      // bit d - 1: the d-th last day of the month (BYMONTHDAY=-d)
+	uint32_t by_hour;                    // bit h: hour h, 0..23
+	uint64_t by_minute;                  // bit m: minute m, 0..59
+	uint64_t by_second;                  // bit s: second s, 0..59
+} ets_schedule_rule_t;
+
+// Generator state. Initialize with `ets_schedule_init()`; treat the fields as private.
+typedef struct ets_schedule
+{
+	ets_schedule_rule_t rule;
+	eternal_timestamp_t base;
+	uint64_t emitted;                    // the number of occurrences produced so far
+	int done;
+
+	// the rule, digested
+	int64_t base_day;                    // days since 1970/jan/01
+	int64_t base_position;               // seconds since 1970/jan/01 00:00:00, unspecified time fields as 0
+	int64_t until_position;
+	int64_t base_month;                  // year * 12 + month - 1
+	uint64_t hours;                      // the time-of-day sets, with bit 63 standing for 'unspecified'
+	uint64_t minutes;
+	uint64_t seconds;
+	uint64_t subsecond_bits;             // the base's millisecond and microsecond fields, packed
+	uint64_t step_pattern;               // a bit every `interval` bits: the days or times the frequency steps to
+	uint32_t day_set;                    // by_month_day, or the base's day
+	uint8_t weekday_set;                 // by_weekday, or the base's weekday
+	uint8_t level;                       // the time field the frequency steps: 0 hour, 1 minute, 2 second, 3 none
+
+	// the cursor
+	int64_t month;                       // year * 12 + month - 1
+	int64_t month_first_day;
+	uint64_t month_bits;                 // the packed century, year and month fields
+	uint64_t idle_months;
+	uint32_t days_left;                  // the selected days of the month which are still to go
+	uint32_t day;
+	uint64_t day_bits;                   // `month_bits` plus the packed day field
+	uint64_t hours_left;
+	uint64_t minutes_left;
+	uint64_t seconds_left;
+	uint32_t hour;
+	uint32_t minute;
+} ets_schedule_t;
+
+#if defined(__cplusplus)
+}
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// C++ interface definitions
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if defined(__cplusplus)
+
+namespace eternal_timestamp
+{
+	class EternalTimestampSchedule
+	{
+	public:
+		// An empty rule of the given frequency: interval 1, no limits, no BYxxx parts.
+		static void init_rule(ets_schedule_rule_t &rule, ets_schedule_frequency_t frequency);
+
+		// Parse RRULE text, e.g. "FREQ=WEEKLY;INTERVAL=2;BYDAY=MO,FR;BYHOUR=9;COUNT=10", with or without the
+		// "RRULE:" prefix. UNTIL takes the basic (20301231T235959Z) or extended ISO 8601 form, which may be
+		// partial. Returns 0 on success, -1 on error (unknown or malformed parts, unsupported features).
+		static int parse_rule(ets_schedule_rule_t &dst, const char *text, size_t length);
+
+		// Prepare `schedule` for producing the occurrences of `rule`, starting at `base`, which must be a modern
+		// timestamp with a complete date, and with the time fields which the frequency steps, i.e. the hour for
+		// FREQ=HOURLY. The other time fields may be unspecified, and are then left unspecified in the
+		// occurrences (FREQ=MONTHLY;BYMONTHDAY=-1 on a date produces dates), unless the rule gives them. The
+		// milliseconds and microseconds of `base` are copied into every occurrence.
+		//
+		// Returns 0 on success, -1 when the rule or the base is invalid, e.g. when the rule gives the minutes
+		// but the hours are unspecified.
+		static int init(ets_schedule_t &schedule, const ets_schedule_rule_t &rule, const eternal_timestamp_t base);
+
+		// Produce the next occurrence in `dst`; returns `false` when the schedule is exhausted.
+		static bool next(ets_schedule_t &schedule, eternal_timestamp_t &dst);
+
+		// Produce up to `capacity` occurrences, in order, in `dst`; returns the number produced, which is less
+		// than `capacity` only when the schedule is exhausted. Call again for more.
+		static size_t generate(eternal_timestamp_t *dst, size_t capacity, ets_schedule_t &schedule);
+	};
+}
+
+#endif // __cplusplus
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// C interface definitions
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+void ets_schedule_init_rule(ets_schedule_rule_t *rule, ets_schedule_frequency_t frequency);
+int ets_schedule_parse_rule(ets_schedule_rule_t *dst, const char *text, size_t length);
+int ets_schedule_init(ets_schedule_t *schedule, const ets_schedule_rule_t *rule, eternal_timestamp_t base);
+BOOL ets_schedule_next(ets_schedule_t *schedule, eternal_timestamp_t *dst);
+size_t ets_schedule_generate(eternal_timestamp_t *dst, size_t capacity, ets_schedule_t *schedule);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif // __ETERNAL_TIMESTAMP_SCHEDULE_H__
@@ -0,0 +1,240 @@
+
+#pragma once
+
+#ifndef __ETERNAL_TIMESTAMP_STATS_H__
+#define __ETERNAL_TIMESTAMP_STATS_H__
+
+// Instrumentation: which code paths does the traffic take, and how much time is spent where?
+//
+// The library counts the calls of its public entry points, plus a few events of interest on the hot paths,
+// e.g. how often `now()` has to bump the clock reading to keep its timestamps unique. Optionally it also
+// accumulates the time spent in each entry point, in CPU timestamp counter ticks (x86) or nanoseconds.
+//
+// This is opt-in, at compile time: build the library with `ETS_ENABLE_INSTRUMENTATION` defined (CMake option
+// `ETERNAL_TIMESTAMP_INSTRUMENTATION`) to get the counters, with `ETS_ENABLE_INSTRUMENTATION_TIMERS` defined
+// as well (CMake option `ETERNAL_TIMESTAMP_INSTRUMENTATION_TIMERS`) to get the timers. Otherwise the
+// instrumentation is compiled out entirely and the functions below report zeroes.
+//
+// Each thread counts in its own cache-line aligned block, so counting costs a few unshared memory writes and
+// threads never contend; a snapshot adds up the blocks of all threads, including those which have exited.
+// Calls the library makes to its own entry points (e.g. the batch conversions calling the scalar one for
+// each row) are counted too.
+
+#include <stddef.h>
+#include <stdint.h>
+
+// X(id, name): the instrumented public entry points.
+#define ETS_STATS_ENTRY_POINTS(X) \
+	X(NOW,                           "EternalTimestamp::now") \
+	X(TODAY,                         "EternalTimestamp::today") \
+	X(TODAY_AT,                      "EternalTimestamp::today_at") \
+	X(NORMALIZE,                     "EternalTimestamp::normalize") \
+	X(CALC_TIME_FAST_DELTA,          "EternalTimestamp::calc_time_fast_delta") \
+	X(CALC_SORT_KEY,                 "EternalTimestamp::calc_sort_key") \
+	X(CALC_TIME_APPROX_DELTA,        "EternalTimestamp::calc_time_approx_delta") \
+	X(CVT_TO_TIMEINFO_STRUCT,        "EternalTimestamp::cvt_to_timeinfo_struct") \
+	X(CVT_TO_TIME_T,                 "EternalTimestamp::cvt_to_time_t") \
+	X(CVT_TO_WIN32FILETIME,          "EternalTimestamp::cvt_to_Win32FileTime") \
+	X(CVT_TO_ETDB_REAL,              "EternalTimestamp::cvt_to_etdb_real") \
+	X(CVT_TO_PROLEPTIC_REAL,         "EternalTimestamp::cvt_to_proleptic_real") \
+	X(CVT_FROM_TIMEINFO_STRUCT,      "EternalTimestamp::cvt_from_timeinfo_struct") \
+	X(CVT_FROM_TIME_T,               "EternalTimestamp::cvt_from_time_t") \
+	X(CVT_FROM_TM,                   "EternalTimestamp::cvt_from_tm") \
+	X(CVT_FROM_WIN32FILETIME,        "EternalTimestamp::cvt_from_Win32FileTime") \
+	X(CVT_FROM_ETDB_REAL,            "EternalTimestamp::cvt_from_etdb_real") \
+	X(CVT_FROM_PROLEPTIC_REAL,       "EternalTimestamp::cvt_from_proleptic_real") \
+	X(CVT_FROM_ISO8601,              "EternalTimestamp::cvt_from_iso8601") \
+	X(CVT_FROM_ISO8601_SCALAR,       "EternalTimestamp::cvt_from_iso8601_scalar") \
+	X(ARROW_EXPORT_ARRAY,            "EternalTimestampArrow::export_array") \
+	X(ARROW_IMPORT_ARRAY,            "EternalTimestampArrow::import_array") \
+	X(ARROW_CVT_FROM_ARRAY,          "EternalTimestampArrow::cvt_from_array") \
+	X(ARROW_CVT_TO_ARRAY,            "EternalTimestampArrow::cvt_to_array") \
+	X(BATCH_CVT_FROM_UNIX_USECS,     "EternalTimestampBatch::cvt_from_unix_usecs") \
+	X(BATCH_CVT_FROM_UNIX_MSECS,     "EternalTimestampBatch::cvt_from_unix_msecs") \
+	X(BATCH_CVT_FROM_UNIX_SECONDS,   "EternalTimestampBatch::cvt_from_unix_seconds") \
+	X(BATCH_CVT_FROM_UNIX_DAYS,      "EternalTimestampBatch::cvt_from_unix_days") \
+	X(BATCH_CVT_TO_UNIX_USECS,       "EternalTimestampBatch::cvt_to_unix_usecs") \
+	X(BATCH_CVT_TO_UNIX_MSECS,       "EternalTimestampBatch::cvt_to_unix_msecs") \
+	X(BATCH_CVT_TO_UNIX_SECONDS,     "EternalTimestampBatch::cvt_to_unix_seconds") \
+	X(BATCH_CVT_TO_UNIX_DAYS,        "EternalTimestampBatch::cvt_to_unix_days") \
+	X(BATCH_CVT_FROM_ISO8601,        "EternalTimestampBatch::cvt_from_iso8601") \
+	X(BATCH_CVT_FROM_ISO8601_COLUMN, "EternalTimestampBatch::cvt_from_iso8601_column") \
+	X(BATCH_CVT_TO_RFC3339_COLUMN,   "EternalTimestampBatch::cvt_to_rfc3339_column") \
+	X(BATCH_CALC_SORT_KEYS,          "EternalTimestampBatch::calc_sort_keys") \
+	X(BIBDATE_PARSE,                 "EternalTimestampBibDate::parse") \
+	X(BIBDATE_PARSE_BATCH,           "EternalTimestampBibDate::parse[]") \
+	X(BIBDATE_PARSE_COLUMN,          "EternalTimestampBibDate::parse_column") \
+	X(CALENDAR_CALC_WEEKDAYS,        "EternalTimestampCalendar::calc_weekdays") \
+	X(CALENDAR_CALC_DAYS_OF_YEAR,    "EternalTimestampCalendar::calc_days_of_year") \
+	X(CALENDAR_CALC_QUARTERS,        "EternalTimestampCalendar::calc_quarters") \
+	X(CALENDAR_CALC_ISO_WEEKS,       "EternalTimestampCalendar::calc_iso_weeks") \
+	X(CALENDAR_COUNT_WEEKDAYS,       "EternalTimestampCalendar::count_weekdays") \
+	X(CLOCK_TO_TIMESTAMP,            "eternal_clock::to_timestamp") \
+	X(CLOCK_FROM_TIMESTAMP,          "eternal_clock::from_timestamp") \
+	X(COMPACT_NARROW_DATE32,         "EternalTimestampCompact::narrow_date32_batch") \
+	X(COMPACT_WIDEN_DATE32,          "EternalTimestampCompact::widen_date32_batch") \
+	X(COMPACT_NARROW_DATETIME48,     "EternalTimestampCompact::narrow_datetime48_batch") \
+	X(COMPACT_WIDEN_DATETIME48,      "EternalTimestampCompact::widen_datetime48_batch") \
+	X(ENDIAN_BYTESWAP,               "EternalTimestampEndian::byteswap") \
+	X(ENDIAN_LOAD,                   "EternalTimestampEndian::load") \
+	X(ENDIAN_STORE,                  "EternalTimestampEndian::store") \
+	X(FORMAT_COMPILE,                "EternalTimestampFormat::compile") \
+	X(FORMAT_FORMAT,                 "EternalTimestampFormat::format") \
+	X(FORMAT_FORMAT_COLUMN,          "EternalTimestampFormat::format_column") \
+	X(FSCRAWL_CRAWL,                 "EternalTimestampFsCrawl::crawl") \
+	X(HASH_MAP_RESERVE,              "EternalTimestampHashMap::reserve") \
+	X(HASH_MAP_INSERT,               "EternalTimestampHashMap::insert") \
+	X(HASH_MAP_ASSIGN,               "EternalTimestampHashMap::assign") \
+	X(HASH_MAP_FIND,                 "EternalTimestampHashMap::find") \
+	X(HASH_MAP_ERASE,                "EternalTimestampHashMap::erase") \
+	X(HASH_MAP_INSERT_BATCH,         "EternalTimestampHashMap::insert_batch") \
+	X(HASH_MAP_FIND_BATCH,           "EternalTimestampHashMap::find_batch") \
+	X(LAYOUT_CVT_TO_EXTENDED,        "ets_layout_cvt_to_extended_batch") \
+	X(LAYOUT_CVT_FROM_EXTENDED,      "ets_layout_cvt_from_extended_batch") \
+	X(LAYOUT_BATCH_CVT_FROM_UNIX,    "EternalTimestampLayoutBatch::cvt_from_unix_*") \
+	X(LAYOUT_BATCH_CVT_TO_UNIX,      "EternalTimestampLayoutBatch::cvt_to_unix_*") \
+	X(LAYOUT_BATCH_FROM_ISO8601,     "EternalTimestampLayoutBatch::cvt_from_iso8601_column") \
+	X(LAYOUT_BATCH_TO_RFC3339,       "EternalTimestampLayoutBatch::cvt_to_rfc3339_column") \
+	X(LAYOUT_TRANSCODE_MARKERS,      "EternalTimestampMarkerTranscoder::transcode_batch") \
+	X(LEAP_SET_TABLE,                "EternalTimestampLeapSeconds::set_table") \
+	X(LEAP_LOAD_TABLE,               "EternalTimestampLeapSeconds::load_table") \
+	X(LEAP_TAI_MINUS_UTC,            "EternalTimestampLeapSeconds::tai_minus_utc") \
+	X(LEAP_CVT_TIME_SCALE,           "EternalTimestampLeapSeconds::cvt_time_scale") \
+	X(LEAP_CALC_DELTA_USECS,         "EternalTimestampLeapSeconds::calc_delta_usecs") \
+	X(LOGSCAN_DETECT_FORMAT,         "EternalTimestampLogScan::detect_format") \
+	X(LOGSCAN_PARSE_LINE,            "EternalTimestampLogScan::parse_line") \
+	X(LOGSCAN_SCAN,                  "EternalTimestampLogScan::scan") \
+	X(SCHEDULE_PARSE_RULE,           "EternalTimestampSchedule::parse_rule") \
+	X(SCHEDULE_INIT,                 "EternalTimestampSchedule::init") \
+	X(SCHEDULE_NEXT,                 "EternalTimestampSchedule::next") \
+	X(SCHEDULE_GENERATE,             "EternalTimestampSchedule::generate") \
+	X(TERMS_CALC_TERMS,              "EternalTimestampTerms::calc_terms") \
+	X(TERMS_CALC_TERMS_BATCH,        "EternalTimestampTerms::calc_terms_batch") \
+	X(TERMS_PLAN_RANGE,              "EternalTimestampTerms::plan_range") \
+	X(TERMS_PLAN_RANGES,             "EternalTimestampTerms::plan_ranges") \
+	X(TIMER_WHEEL_CREATE,            "EternalTimestampTimerWheel::create") \
+	X(TIMER_WHEEL_INSERT,            "EternalTimestampTimerWheel::insert") \
+	X(TIMER_WHEEL_INSERT_BATCH,      "EternalTimestampTimerWheel::insert_batch") \
+	X(TIMER_WHEEL_CANCEL,            "EternalTimestampTimerWheel::cancel") \
+	X(TIMER_WHEEL_ADVANCE,           "EternalTimestampTimerWheel::advance") \
+	X(TIMER_WHEEL_DRAIN,             "EternalTimestampTimerWheel::drain") \
+	X(TIMER_WHEEL_POST,              "EternalTimestampTimerWheel::post") \
+	X(TIMER_WHEEL_POST_CANCEL,       "EternalTimestampTimerWheel::post_cancel") \
+	X(TZ_LOAD,                       "EternalTimestampZone::load") \
+	X(TZ_COMPILE,                    "EternalTimestampZone::compile") \
+	X(TZ_UTC_OFFSET,                 "EternalTimestampZone::utc_offset") \
+	X(TZ_CVT_LOCAL_TO_UTC,           "EternalTimestampZone::cvt_local_to_utc") \
+	X(TZ_CVT_UTC_TO_LOCAL,           "EternalTimestampZone::cvt_utc_to_local")
+
+// X(id, name): the counted events.
+#define ETS_STATS_EVENTS(X) \
+	/* now() returned a reading bumped past the clock, as the clock had not advanced since the previous call */ \
+	X(NOW_BUMPED,                    "now_bumped") \
+	/* calc_time_fast_delta() compared a modern with a prehistoric timestamp... */ \
+	X(FAST_DELTA_CROSS_MODE,         "fast_delta_cross_mode") \
+	/* ... and had to normalize the prehistoric one, as both share the same year */ \
+	X(FAST_DELTA_NORMALIZED,         "fast_delta_normalized") \
+	/* a conversion produced a timestamp (or `eternal_time_tm`) with one or more unspecified fields */ \
+	X(CVT_UNSPECIFIED_FIELDS,        "cvt_unspecified_fields") \
+	/* cvt_from_iso8601(): the input did not match the fast path's YYYY-MM-DDThh:mm:ss layout */ \
+	X(ISO8601_SCALAR_FALLBACK,       "iso8601_scalar_fallback") \
+	/* EternalTimestampZone::cvt_local_to_utc(): local times which fell in a gap or an overlap */ \
+	X(TZ_LOCAL_TIME_GAP,             "tz_local_time_gap") \
+	X(TZ_LOCAL_TIME_OVERLAP,         "tz_local_time_overlap") \
+	/* a timer moved down from a timing wheel slot or the overflow heap to a finer slot or the expired list */ \
+	X(TIMER_WHEEL_CASCADE,           "timer_wheel_cascade") \
+	/* a hash table grew or dropped its tombstones */ \
+	X(HASH_MAP_REHASH,               "hash_map_rehash")
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+enum ets_stats_id
+{
+#define ETS_STATS_DECLARE_ID(id, name)      ETS_STATS_##id,
+	ETS_STATS_ENTRY_POINTS(ETS_STATS_DECLARE_ID)
+	ETS_STATS_ENTRY_POINT_COUNT,
+	// the events follow the entry points: the first event id equals ETS_STATS_ENTRY_POINT_COUNT
+	ETS_STATS_EVENT_BASE_ = ETS_STATS_ENTRY_POINT_COUNT - 1,
+	ETS_STATS_EVENTS(ETS_STATS_DECLARE_ID)
+	ETS_STATS_COUNT
+#undef ETS_STATS_DECLARE_ID
+};
+
+// A snapshot of the counters, summed over all threads.
+//
+// `count[]` holds the number of calls for each entry point and the number of occurrences for each event.
+// `ticks[]` holds the time spent in each entry point; it is all zeroes for events and when the timers are
+// not compiled in.
+typedef struct ets_stats
+{
+	uint64_t count[ETS_STATS_COUNT];
+	uint64_t ticks[ETS_STATS_COUNT];
+} ets_stats_t;
+
+#if defined(__cplusplus)
+}
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// C++ interface definitions
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if defined(__cplusplus)
+
+namespace eternal_timestamp
+{
+	class EternalTimestampStats
+	{
+	public:
+		// Whether the library was built with the counters and the timers, respectively.
+		static bool enabled();
+		static bool timers_enabled();
+
+		// The unit of `ets_stats_t::ticks[]`: "cycles" (the CPU timestamp counter, which runs at a constant
+		// rate on any recent x86 CPU) or "ns".
+		static const char *tick_unit();
+
+		// The name of a counter, as used in the dump. NULL for an invalid `id`.
+		static const char *name(int id);
+
+		// Sum the counters of all threads since the last reset().
+		static void snapshot(ets_stats_t &dst);
+
+		// Restart counting at zero. This does not touch the counters of other threads, which keep counting
+		// without synchronization: it records a baseline which snapshot() subtracts.
+		static void reset();
+
+		// Render a snapshot in the Prometheus text exposition format, one sample per line, leaving out the
+		// counters which are zero.
+		//
+		// Has `snprintf()` semantics: the output is NUL-terminated and truncated to `size`; returns the length
+		// of the full output, so a return value >= `size` signals truncation.
+		static size_t dump(char *buf, size_t size, const ets_stats_t &stats);
+	};
+}
+
+#endif // __cplusplus
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// C interface definitions
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+int ets_stats_enabled(void);
+int ets_stats_timers_enabled(void);
+const char *ets_stats_tick_unit(void);
+const char *ets_stats_name(int id);
+void ets_stats_snapshot(ets_stats_t *dst);
+void ets_stats_reset(void);
+size_t ets_stats_dump(char *buf, size_t size, const ets_stats_t *stats);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif // __ETERNAL_TIMESTAMP_STATS_H__
@@ -0,0 +1,143 @@
+
+#pragma once
+
+#ifndef __ETERNAL_TIMESTAMP_TERMS_H__
+#define __ETERNAL_TIMESTAMP_TERMS_H__
+
+// Prefix-coded range terms for full-text search engines (SOLR/Lucene, ManticoreSearch, ...), which answer range
+// queries over indexed terms much faster than by comparing each document's value.
+//
+// A timestamp is indexed as one term per precision level: its century, its year, its month, ... down to its
+// microsecond, each term being a prefix of its sort key (see `EternalTimestamp::calc_sort_key()`) cut at that
+// field's boundary. A range query then becomes an OR of a handful of terms: coarse ones for the bulk of the range
+// and ever finer ones towards its ends. E.g. [2019-12-28T09:30, 2021) is 2019-12-28T09:30..59 (30 minute terms),
+// 2019-12-28T10..23 (14 hour terms), 2019-12-29..31 (3 day terms) and 2020 (1 year term): 48 terms instead of
+// 32 million seconds.
+//
+// A term is a 64-bit value: the prefix, followed by a 1 bit, followed by zeroes, so the terms of all levels are
+// distinct and the level is the position of the lowest 1 bit. Index them as a multi-valued integer attribute,
+// or as keywords through `format_term()`.
+//
+// You pick the levels to index as a bitmask of `(1 << ETS_TERM_...)` values; the microsecond level is always
+// included, so that any range can be expressed. Fewer levels make for a smaller index and longer queries; the
+// query planner MUST be given the same levels as the indexer.
+//
+// Ranges are half-open, [lo, hi), in the order of `calc_sort_key()`. Partial timestamps sort before any complete
+// timestamp they might stand for, so a partial timestamp belongs to the first instant of its span: a bound on a
+// field boundary, e.g. 2020-09-01T00:00:00.000000, is taken as the partial timestamp of that boundary, here
+// 2020-09, which includes 2020-09 and 2020-09-01 in a range starting there (and excludes them from a range
+// ending there). See `calc_range_bound()`.
+
+#include "eternal_timestamp/eternal_timestamp.h"
+#include "eternal_timestamp/eternal_timestamp_parallel.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+// The length of a term in text form, as produced by `format_term()`: 16 hex digits, which sort like the terms.
+#define ETS_TERM_TEXT_LENGTH          16
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+typedef uint64_t ets_term_t;
+
+// The precision levels, coarsest first.
+enum ets_term_level
+{
+	ETS_TERM_CENTURY = 0,
+	ETS_TERM_YEAR,
+	ETS_TERM_MONTH,
+	ETS_TERM_DAY,
+	ETS_TERM_HOUR,
+	ETS_TERM_MINUTE,
+	ETS_TERM_SECONDS,
+	ETS_TERM_MILLISECONDS,
+	ETS_TERM_MICROSECONDS,
+
+	ETS_TERM_LEVEL_COUNT
+};
+
+#define ETS_TERM_LEVELS_ALL           ((1U << ETS_TERM_LEVEL_COUNT) - 1)
+
+#if defined(__cplusplus)
+}
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// C++ interface definitions
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if defined(__cplusplus)
+
+namespace eternal_timestamp
+{
+	class EternalTimestampTerms
+	{
+	public:
+		// The number of terms per timestamp for the given `levels`.
+		static size_t count_levels(unsigned int levels);
+
+		// Write the index terms of `t` to `dst`, coarsest first: `count_levels(levels)` of them, which is also what
+		// we return.
+		static size_t calc_terms(ets_term_t *dst, const eternal_timestamp_t t, unsigned int levels = ETS_TERM_LEVELS_ALL);
+
+		// The terms of `count` timestamps, `count_levels(levels)` per timestamp, one timestamp after the other.
+		static void calc_terms_batch(ets_term_t *dst, const eternal_timestamp_t *src, size_t count, unsigned int levels = ETS_TERM_LEVELS_ALL, unsigned int parallelism = ETS_PARALLELISM_DEFAULT);
+
+		// The bound which the range planner uses for `t`: `t` with the trailing fields which hold their first
+		// value (month 1, day 1, hour 0, ..., and year 00 of the century) made unspecified, e.g.
+		// 2020-09-01T00:00:00.000000 --> 2020-09.
+		static eternal_timestamp_t calc_range_bound(const eternal_timestamp_t t);
+
+		// The minimal set of terms which covers the range [lo, hi), in no particular order.
+		//
+		// Writes up to `capacity` terms and returns the number of terms in the set, so that a return value larger
+		// than `capacity` tells you how much room it takes. With all levels indexed, that is a few hundred at most
+		// for bounds given to the second and some 5000 for bounds to the microsecond, except for ranges which involve
+		// prehistoric timestamps. Leaving out levels quickly multiplies the number of terms of the next finer level.
+		//
+		// The set is exact for timestamps whose fields are within their legal ranges.
+		static size_t plan_range(ets_term_t *dst, size_t capacity, const eternal_timestamp_t lo, const eternal_timestamp_t hi, unsigned int levels = ETS_TERM_LEVELS_ALL);
+
+		// `plan_range()` for `count` ranges: range `i` goes to dst[offsets[i] .. offsets[i + 1]], where `offsets`
+		// has `count + 1` entries.
+		//
+		// Returns the total number of terms. When that exceeds `capacity`, only `offsets` is filled in, so that
+		// you can make room and call again.
+		static size_t plan_ranges(ets_term_t *dst, size_t capacity, size_t *offsets, const eternal_timestamp_t *lo, const eternal_timestamp_t *hi, size_t count, unsigned int levels = ETS_TERM_LEVELS_ALL, unsigned int parallelism = ETS_PARALLELISM_DEFAULT);
+
+		// The level of a term; -1 when `term` is not a term.
+		static int term_level(ets_term_t term);
+
+		// Write the text form of `term` plus a NUL sentinel to `dst`. Returns the length, `ETS_TERM_TEXT_LENGTH`, or
+		// 0 when `capacity` is too small.
+		static size_t format_term(char *dst, size_t capacity, ets_term_t term);
+	};
+}
+
+#endif // __cplusplus
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// C interface definitions
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+size_t ets_terms_count_levels(unsigned int levels);
+size_t ets_terms_calc_terms(ets_term_t *dst, const eternal_timestamp_t t, unsigned int levels);
+void ets_terms_calc_terms_batch(ets_term_t *dst, const eternal_timestamp_t *src, size_t count, unsigned int levels);
+eternal_timestamp_t ets_terms_calc_range_bound(const eternal_timestamp_t t);
+size_t ets_terms_plan_range(ets_term_t *dst, size_t capacity, const eternal_timestamp_t lo, const eternal_timestamp_t hi, unsigned int levels);
+size_t ets_terms_plan_ranges(ets_term_t *dst, size_t capacity, size_t *offsets, const eternal_timestamp_t *lo, const eternal_timestamp_t *hi, size_t count, unsigned int levels);
+int ets_terms_term_level(ets_term_t term);
+size_t ets_terms_format_term(char *dst, size_t capacity, ets_term_t term);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif // __ETERNAL_TIMESTAMP_TERMS_H__
@@ -0,0 +1,149 @@
+
+#pragma once
+
+#ifndef __ETERNAL_TIMESTAMP_TIMER_H__
+#define __ETERNAL_TIMESTAMP_TIMER_H__
+
+// A hierarchical timing wheel for large numbers of timers (expiries, retries, scheduled jobs) with eternal timestamp
+// deadlines.
+//
+// The wheel levels are the timestamp fields themselves: 1000 millisecond slots, 60 second slots, 60 minute slots,
+// 24 hour slots and 31 day slots, each indexed directly by the deadline's field value. A timer goes to the level of
+// the most significant field in which its deadline differs from the wheel's current time, which is always a slot
+// *ahead* of the current one in that level, so no slot ever holds timers from different rounds. When the time
+// reaches a slot, its timers move down to the levels below (or expire). Deadlines in a later month wait in an
+// overflow heap until their month comes around.
+//
+// Inserting and cancelling a timer are O(1), as is the amortized cost of expiring it (a timer moves down at most
+// five times), with timers far in the future paying O(log n) for the overflow heap. Expired timers are collected
+// in deadline order and handed out in batches by `drain()`.
+//
+// Threading: the wheel has one owner thread, which calls everything but `post()` and `post_cancel()`. Those two
+// MAY be called from any thread: their requests are queued and take effect when the owner calls `advance()`,
+// `poll()` or `cancel()`.
+//
+// The wheel has a resolution of one millisecond: microseconds are ignored. Deadlines MUST be modern timestamps
+// with a complete date; unspecified time-of-day fields are taken as zero(0), i.e. the start of the day, hour, ...
+
+#include "eternal_timestamp/eternal_timestamp.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+// Identifies a timer until it has been cancelled or drained. Zero(0) is never a valid handle.
+typedef uint64_t ets_timer_handle_t;
+
+// An expired timer.
+typedef struct ets_timer
+{
+	ets_timer_handle_t handle;
+	eternal_timestamp_t deadline;         // as passed to `insert()`
+	uint64_t payload;
+} ets_timer_t;
+
+// A timing wheel. Opaque.
+typedef struct ets_timer_wheel ets_timer_wheel_t;
+
+#if defined(__cplusplus)
+}
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// C++ interface definitions
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if defined(__cplusplus)
+
+namespace eternal_timestamp
+{
+	class EternalTimestampTimerWheel
+	{
+	public:
+		// Create a wheel whose current time is `now`.
+		//
+		// Returns 0 on success, `EINVAL` when `now` is not a modern timestamp with a complete date, `ENOMEM`.
+		static int create(ets_timer_wheel_t *&dst, const eternal_timestamp_t now);
+
+		// Destroy the wheel with all its timers. No other thread may be posting to it.
+		static void destroy(ets_timer_wheel_t *wheel);
+
+		// Add a timer; `handle` MAY be NULL when you won't cancel it. A timer whose deadline has passed already
+		// expires at once, i.e. joins the end of the expired timers.
+		//
+		// Returns 0 on success, `EINVAL` for an unusable deadline, `ENOMEM`.
+		static int insert(ets_timer_wheel_t *wheel, ets_timer_handle_t *handle, const eternal_timestamp_t deadline, uint64_t payload);
+
+		// Add `count` timers; `handles` and `payloads` MAY be NULL (payload: the timer's index in the column).
+		//
+		// Returns 0 on success; on failure the timers before the offending one have been added and `handles`
+		// holds zero(0) from there on.
+		static int insert_batch(ets_timer_wheel_t *wheel, ets_timer_handle_t *handles, const eternal_timestamp_t *deadlines, const uint64_t *payloads, size_t count);
+
+		// Remove a pending or expired-but-not-drained timer. Returns `false` when the handle is stale.
+		static bool cancel(ets_timer_wheel_t *wheel, ets_timer_handle_t handle);
+
+		// Move the current time forward to `now` and expire all timers whose deadline is at or before it.
+		// A `now` before the current time only takes in the posted requests.
+		//
+		// Returns 0 on success, `EINVAL` when `now` is not a modern timestamp with a complete date.
+		static int advance(ets_timer_wheel_t *wheel, const eternal_timestamp_t now);
+
+		// Hand out up to `capacity` expired timers in the order they expired, i.e. earliest deadline first (timers
+		// expiring in the same millisecond in no particular order), and forget about them. Returns the number
+		// written to `dst`.
+		static size_t drain(ets_timer_wheel_t *wheel, ets_timer_t *dst, size_t capacity);
+
+		// `advance()` followed by `drain()`: the usual event loop call.
+		static size_t poll(ets_timer_wheel_t *wheel, const eternal_timestamp_t now, ets_timer_t *dst, size_t capacity);
+
+		// The earliest deadline among the pending and expired timers, for deciding how long to sleep.
+		// Returns `false` when there are none. O(timers in the nearest occupied slot).
+		static bool next_expiry(const ets_timer_wheel_t *wheel, eternal_timestamp_t &dst);
+
+		// The number of pending and expired-but-not-drained timers, not counting those posted meanwhile.
+		static size_t size(const ets_timer_wheel_t *wheel);
+
+		// The wheel's current time, at millisecond resolution.
+		static eternal_timestamp_t now(const ets_timer_wheel_t *wheel);
+
+		// `insert()` and `cancel()` for threads other than the owner. The handle is valid at once, but the
+		// timer only joins the wheel at the owner's next `advance()`; `post_cancel()` of a stale handle is
+		// silently ignored.
+		static int post(ets_timer_wheel_t *wheel, ets_timer_handle_t *handle, const eternal_timestamp_t deadline, uint64_t payload);
+		static void post_cancel(ets_timer_wheel_t *wheel, ets_timer_handle_t handle);
+	};
+}
+
+#endif // __cplusplus
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// C interface definitions
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+int ets_timer_wheel_create(ets_timer_wheel_t **dst, const eternal_timestamp_t now);
+void ets_timer_wheel_destroy(ets_timer_wheel_t *wheel);
+int ets_timer_wheel_insert(ets_timer_wheel_t *wheel, ets_timer_handle_t *handle, const eternal_timestamp_t deadline, uint64_t payload);
+int ets_timer_wheel_insert_batch(ets_timer_wheel_t *wheel, ets_timer_handle_t *handles, const eternal_timestamp_t *deadlines, const uint64_t *payloads, size_t count);
+int ets_timer_wheel_cancel(ets_timer_wheel_t *wheel, ets_timer_handle_t handle);
+int ets_timer_wheel_advance(ets_timer_wheel_t *wheel, const eternal_timestamp_t now);
+size_t ets_timer_wheel_drain(ets_timer_wheel_t *wheel, ets_timer_t *dst, size_t capacity);
+size_t ets_timer_wheel_poll(ets_timer_wheel_t *wheel, const eternal_timestamp_t now, ets_timer_t *dst, size_t capacity);
+int ets_timer_wheel_next_expiry(const ets_timer_wheel_t *wheel, eternal_timestamp_t *dst);
+size_t ets_timer_wheel_size(const ets_timer_wheel_t *wheel);
+eternal_timestamp_t ets_timer_wheel_now(const ets_timer_wheel_t *wheel);
+int ets_timer_wheel_post(ets_timer_wheel_t *wheel, ets_timer_handle_t *handle, const eternal_timestamp_t deadline, uint64_t payload);
+void ets_timer_wheel_post_cancel(ets_timer_wheel_t *wheel, ets_timer_handle_t handle);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif // __ETERNAL_TIMESTAMP_TIMER_H__
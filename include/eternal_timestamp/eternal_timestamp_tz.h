@@ -0,0 +1,112 @@
+
+#pragma once
+
+#ifndef __ETERNAL_TIMESTAMP_TZ_H__
+#define __ETERNAL_TIMESTAMP_TZ_H__
+
+// Time zones: conversion between local wall-clock time and UTC.
+//
+// Eternal timestamps are UTC by design; this is for *ingesting* (and presenting) local times in a named zone.
+// Zones are compiled from the system's zoneinfo database (TZif files, RFC 8536) into compact, immutable
+// transition tables which are shared by all threads: conversions never call `localtime_r()` & friends nor touch
+// the process-wide `TZ` state, hence do not contend for the C library's global time zone lock.
+//
+// Times beyond the last transition listed in the file are handled through the POSIX TZ rule in the file's
+// footer, so 'slim' zoneinfo files work as well as 'fat' ones.
+
+#include "eternal_timestamp/eternal_timestamp.h"
+#include "eternal_timestamp/eternal_timestamp_parallel.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+// A compiled zone. Opaque; immutable once loaded.
+typedef struct ets_tz_zone ets_tz_zone_t;
+
+// How to map local times which are ambiguous (they occur twice when the clocks are turned back) or which do not
+// exist (they are skipped when the clocks are turned forward).
+enum ets_tz_disambiguation
+{
+	ETS_TZ_COMPATIBLE = 0,    // ambiguous: the earlier instant; skipped: the later one, i.e. shifted forward by the gap length
+	ETS_TZ_EARLIER,           // always pick the earlier instant
+	ETS_TZ_LATER,             // always pick the later instant
+	ETS_TZ_REJECT,            // treat these as invalid
+};
+
+#if defined(__cplusplus)
+}
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// C++ interface definitions
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if defined(__cplusplus)
+
+namespace eternal_timestamp
+{
+	class EternalTimestampZone
+	{
+	public:
+		// Load the named zone, e.g. "Europe/Amsterdam", from the zoneinfo directory: `$TZDIR` when set, otherwise
+		// `/usr/share/zoneinfo`. Loaded zones are cached and shared for the lifetime of the process, so asking for
+		// the same zone again is a cheap lookup. Thread-safe.
+		//
+		// Returns 0 on success, an `errno` value otherwise: ENOENT for unknown zones, EINVAL for invalid names
+		// and files which are not valid TZif files, ENOMEM.
+		static int load(const ets_tz_zone_t *&dst, const char *name);
+
+		// Compile an in-memory TZif image. The zone is NOT cached: free it with `release()`.
+		//
+		// Returns 0 on success, an `errno` value otherwise: EINVAL, ENOMEM.
+		static int compile(ets_tz_zone_t *&dst, const void *data, size_t size);
+		static void release(ets_tz_zone_t *zone);
+
+		// The offset from UTC, in seconds east of Greenwich, in effect at the given moment (seconds since
+		// 1970/jan/01 00:00:00 UTC).
+		static int32_t utc_offset(const ets_tz_zone_t *zone, int64_t utc_seconds);
+
+		// Convert local wall-clock timestamps to UTC. `dst` MAY be the same as `src`. `parallelism`: see
+		// eternal_timestamp_parallel.h.
+		//
+		// Timestamps which cannot be placed on the time line (prehistoric ones, timestamps lacking any of century,
+		// year, month, day or hour, timestamps with a field out of its range such as feb/31 or second 60) are
+		// copied unchanged and have their `validity` bit cleared; ditto for local times rejected by `how`. All
+		// others have their `validity` bit set. Unspecified fields below the hour remain unspecified, which means
+		// an offset which is not a whole number of hours is only partially applied to them, just like
+		// `cvt_from_iso8601()` does for zone designators.
+		//
+		// Return the number of timestamps which could not be converted.
+		static size_t cvt_local_to_utc(eternal_timestamp_t *dst, uint8_t *validity, const eternal_timestamp_t *src, size_t count, const ets_tz_zone_t *zone, ets_tz_disambiguation how = ETS_TZ_COMPATIBLE, unsigned int parallelism = ETS_PARALLELISM_DEFAULT);
+
+		// The reverse: convert UTC timestamps to local wall-clock time in `zone`.
+		static size_t cvt_utc_to_local(eternal_timestamp_t *dst, uint8_t *validity, const eternal_timestamp_t *src, size_t count, const ets_tz_zone_t *zone, unsigned int parallelism = ETS_PARALLELISM_DEFAULT);
+	};
+}
+
+#endif // __cplusplus
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// C interface definitions
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+int ets_tz_load(const ets_tz_zone_t **dst, const char *name);
+int ets_tz_compile(ets_tz_zone_t **dst, const void *data, size_t size);
+void ets_tz_release(ets_tz_zone_t *zone);
+int32_t ets_tz_utc_offset(const ets_tz_zone_t *zone, int64_t utc_seconds);
+size_t ets_tz_cvt_local_to_utc(eternal_timestamp_t *dst, uint8_t *validity, const eternal_timestamp_t *src, size_t count, const ets_tz_zone_t *zone, enum ets_tz_disambiguation how);
+size_t ets_tz_cvt_utc_to_local(eternal_timestamp_t *dst, uint8_t *validity, const eternal_timestamp_t *src, size_t count, const ets_tz_zone_t *zone);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif // __ETERNAL_TIMESTAMP_TZ_H__
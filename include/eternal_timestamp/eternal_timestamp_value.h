@@ -0,0 +1,272 @@
+#pragma once
+
+#ifndef __ETERNAL_TIMESTAMP_VALUE_H__
+#define __ETERNAL_TIMESTAMP_VALUE_H__
+
+// A C++ value type for eternal timestamps, plus a `std::chrono` clock which speaks them.
+//
+// `EternalTimestampValue` wraps a single `eternal_timestamp_t` and nothing else: it is trivially copyable, has
+// the size of a `uint64_t` and converts implicitly from the bare union, so it drops into existing code.
+//
+// Everything it does is inline. Equality compares the 64-bit values, i.e. it is a single integer comparison.
+// The raw values don't order by time (the microseconds occupy the top bits), so the ordering operators compare
+// the sort keys of `EternalTimestamp::calc_sort_key()` instead: for modern timestamps these are computed in
+// place, a handful of shifts and masks per operand, without a call into the library. The field getters decode
+// just the field asked for. With `operator<` (and `operator<=>` in C++20) and `std::hash` defined, it serves as
+// the key of `std::set`, `std::map`, `std::unordered_map` and the sorting algorithms as is.
+//
+// `eternal_clock` meets the standard Clock requirements: its time points count microseconds since
+// 1970/jan/01 00:00:00 UTC, i.e. it is `std::chrono::system_clock` at the resolution of the modern subformat,
+// and `to_timestamp()` / `from_timestamp()` convert between its time points and (modern) timestamps, without
+// going through `time_t`.
+
+#include "eternal_timestamp/eternal_timestamp.h"
+#include "eternal_timestamp/eternal_timestamp_hash.h"
+#include "eternal_timestamp/eternal_timestamp_layout.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__cplusplus)
+
+#include <chrono>
+#include <functional>
+#include <limits>
+#include <ratio>
+
+#if defined(__cpp_impl_three_way_comparison) && __cpp_impl_three_way_comparison >= 201907L && defined(__has_include)
+#if __has_include(<compare>)
+#include <compare>
+#define ETS_HAVE_THREE_WAY_COMPARISON   1
+#endif
+#endif
+
+namespace eternal_timestamp
+{
+	class EternalTimestampValue
+	{
+	public:
+		typedef EternalTimestampLayout<> native;
+
+		// What `year()` produces when the year is not known.
+		static constexpr int64_t unspecified_year = std::numeric_limits<int64_t>::min();
+
+		// All fields 'unspecified', like `EternalTimestamp::unknown()`.
+		constexpr EternalTimestampValue() noexcept
+			: ts_(ets_inline_unknown())
+		{
+		}
+
+		constexpr EternalTimestampValue(const eternal_timestamp_t t) noexcept
+			: ts_(t)
+		{
+		}
+
+		static EternalTimestampValue now()
+		{
+			return EternalTimestamp::now();
+		}
+
+		constexpr eternal_timestamp_t value() const noexcept
+		{
+			return ts_;
+		}
+
+		// `EternalTimestamp::calc_sort_key()`, inline for modern timestamps.
+		int64_t sort_key() const noexcept
+		{
+			return is_modern_format() ? native::calc_modern_sort_key(ts_.t) : native::calc_sort_key(ts_.t);
+		}
+
+		constexpr bool is_modern_format() const noexcept
+		{
+			return ets_inline_is_modern_format(ts_);
+		}
+
+		constexpr bool is_prehistoric_format() const noexcept
+		{
+			return ets_inline_is_prehistoric_format(ts_);
+		}
+
+		// The field getters produce the 'natural' values, as `struct eternal_time_tm` does: month 1..12,
+		// day 1..31, hour 0..23, etc., and -1 for fields which are 'unspecified' or which the subformat
+		// doesn't carry (prehistoric timestamps have no seconds or anything more precise).
+
+		// The astronomical year: 0 is 1 B.C., negative values are B.C. For prehistoric timestamps it is only
+		// known to 10^`precision()` years.
+		constexpr int64_t year() const noexcept
+		{
+			return is_modern_format()
+				? (ets_inline_has_century_and_year(ts_)
+					? static_cast<int64_t>(ets_modern_century(ts_)) * 100 + static_cast<int64_t>(ets_modern_year(ts_) - native::value_offset) - native::modern_epoch
+					: unspecified_year)
+				: (ets_inline_has_age(ts_)
+					? native::prehistoric_epoch - static_cast<int64_t>(ets_prehistoric_years(ts_))
+					: unspecified_year);
+		}
+
+		// The power of 10 the prehistoric years are known to; zero(0) for modern timestamps.
+		constexpr int precision() const noexcept
+		{
+			return is_modern_format() ? 0 : static_cast<int>(ets_prehistoric_precision(ts_));
+		}
+
+		constexpr int month() const noexcept
+		{
+			return ets_inline_has_month(ts_) ? decode(is_modern_format() ? ets_modern_month(ts_) : ets_prehistoric_month(ts_)) + 1 : -1;
+		}
+
+		constexpr int day() const noexcept
+		{
+			return ets_inline_has_day(ts_) ? decode(is_modern_format() ? ets_modern_day(ts_) : ets_prehistoric_day(ts_)) + 1 : -1;
+		}
+
+		constexpr int hour() const noexcept
+		{
+			return ets_inline_has_hour(ts_) ? decode(is_modern_format() ? ets_modern_hour(ts_) : ets_prehistoric_hour(ts_)) : -1;
+		}
+
+		constexpr int minute() const noexcept
+		{
+			return ets_inline_has_minute(ts_) ? decode(is_modern_format() ? ets_modern_minute(ts_) : ets_prehistoric_minute(ts_)) : -1;
+		}
+
+		// 0..60: leap seconds included.
+		constexpr int second() const noexcept
+		{
+			return ets_inline_has_seconds(ts_) ? decode(ets_modern_seconds(ts_)) : -1;
+		}
+
+		constexpr int millisecond() const noexcept
+		{
+			return ets_inline_has_milliseconds(ts_) ? decode(ets_modern_milliseconds(ts_)) : -1;
+		}
+
+		constexpr int microsecond() const noexcept
+		{
+			return ets_inline_has_microseconds(ts_) ? decode(ets_modern_microseconds(ts_)) : -1;
+		}
+
+		// Order by time, as `EternalTimestamp::calc_sort_key()` does. Timestamps which denote the same moment
+		// in different encodings (a prehistoric timestamp which could have been a modern one) are ordered by
+		// their bits, so the order agrees with the equality operator, which compares bits.
+		//
+		// Returns <0, 0 or >0, as a is earlier than, identical to, or later than b.
+		static int compare(const EternalTimestampValue a, const EternalTimestampValue b) noexcept
+		{
+			const int64_t ka = a.sort_key();
+			const int64_t kb = b.sort_key();
+			if (ka != kb)
+				return ka < kb ? -1 : 1;
+			return (a.ts_.t > b.ts_.t) - (a.ts_.t < b.ts_.t);
+		}
+
+		friend constexpr bool operator==(const EternalTimestampValue a, const EternalTimestampValue b) noexcept
+		{
+			return a.ts_.t == b.ts_.t;
+		}
+
+		friend constexpr bool operator!=(const EternalTimestampValue a, const EternalTimestampValue b) noexcept
+		{
+			return a.ts_.t != b.ts_.t;
+		}
+
+		friend bool operator<(const EternalTimestampValue a, const EternalTimestampValue b) noexcept
+		{
+			const int64_t ka = a.sort_key();
+			const int64_t kb = b.sort_key();
+			return ka < kb || (ka == kb && a.ts_.t < b.ts_.t);
+		}
+
+		friend bool operator>(const EternalTimestampValue a, const EternalTimestampValue b) noexcept
+		{
+			return b < a;
+		}
+
+		friend bool operator<=(const EternalTimestampValue a, const EternalTimestampValue b) noexcept
+		{
+			return !(b < a);
+		}
+
+		friend bool operator>=(const EternalTimestampValue a, const EternalTimestampValue b) noexcept
+		{
+			return !(a < b);
+		}
+
+#if defined(ETS_HAVE_THREE_WAY_COMPARISON)
+		friend std::strong_ordering operator<=>(const EternalTimestampValue a, const EternalTimestampValue b) noexcept
+		{
+			const int64_t ka = a.sort_key();
+			const int64_t kb = b.sort_key();
+			if (ka != kb)
+				return ka <=> kb;
+			return a.ts_.t <=> b.ts_.t;
+		}
+#endif
+
+	private:
+		// the zero-based value of a field which is not 'unspecified'.
+		static constexpr int decode(const uint64_t code) noexcept
+		{
+			return static_cast<int>(code - native::value_offset);
+		}
+
+		eternal_timestamp_t ts_;
+	};
+
+	// A Clock (see the C++ standard's [time.clock.req]) ticking in microseconds since 1970/jan/01 00:00:00 UTC.
+	struct eternal_clock
+	{
+		typedef int64_t rep;
+		typedef std::micro period;
+		typedef std::chrono::duration<rep, period> duration;
+		typedef std::chrono::time_point<eternal_clock> time_point;
+
+		static constexpr bool is_steady = false;
+
+		// NOTE: unlike `EternalTimestamp::now()` this doesn't bump the reading to keep it unique: consecutive
+		// calls may well produce the same time point, as they may with any other Clock.
+		static time_point now() noexcept
+		{
+			return time_point(std::chrono::duration_cast<duration>(std::chrono::system_clock::now().time_since_epoch()));
+		}
+
+		// The complete modern timestamp for `tp`. Time points beyond the modern range produce a timestamp with
+		// all fields 'unspecified'.
+		static EternalTimestampValue to_timestamp(const time_point &tp) noexcept;
+
+		// Unspecified month/day fields are taken as 1, unspecified time-of-day fields as zero(0). Returns -1,
+		// having set `dst` to the epoch, when `t` is prehistoric or lacks its century or year.
+		static int from_timestamp(time_point &dst, const EternalTimestampValue t) noexcept;
+
+		// These make `std::chrono::clock_cast` work for `eternal_clock` (C++20), which shares its epoch with
+		// `std::chrono::system_clock`.
+		template <class Duration>
+		static std::chrono::time_point<std::chrono::system_clock, Duration> to_sys(const std::chrono::time_point<eternal_clock, Duration> &tp)
+		{
+			return std::chrono::time_point<std::chrono::system_clock, Duration>(tp.time_since_epoch());
+		}
+
+		template <class Duration>
+		static std::chrono::time_point<eternal_clock, Duration> from_sys(const std::chrono::time_point<std::chrono::system_clock, Duration> &tp)
+		{
+			return std::chrono::time_point<eternal_clock, Duration>(tp.time_since_epoch());
+		}
+	};
+}
+
+namespace std
+{
+	template <>
+	struct hash<eternal_timestamp::EternalTimestampValue>
+	{
+		size_t operator()(const eternal_timestamp::EternalTimestampValue t) const noexcept
+		{
+			return static_cast<size_t>(ets_hash(t.value()));
+		}
+	};
+}
+
+#endif // __cplusplus
+
+#endif // __ETERNAL_TIMESTAMP_VALUE_H__
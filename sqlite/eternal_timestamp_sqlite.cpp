@@ -0,0 +1,819 @@
+
+// SQLite loadable extension for eternal timestamps.
+//
+// Load it in the sqlite3 shell with `.load ./eternaltimestamp` or via `sqlite3_load_extension()`.
+//
+// Timestamps are stored as plain SQLite INTEGER values (the raw 64-bit `eternal_timestamp_t`).
+//
+// Scalar functions:
+//
+// - ets_now()                      the current time.
+// - ets_from_unix(secs [, usecs])  convert UNIX epoch seconds (INTEGER or REAL) plus optional microseconds; an error outside
+//                                  the modern range (9901 BC .. 41199 AD).
+// - ets_to_unix(ts)                convert a modern timestamp to (REAL) UNIX epoch seconds; unspecified fields count as their first value.
+// - ets_format(ts [, pattern])     render as ISO 8601 text at the precision the timestamp was specified at (`ETS_FORMAT_ISO8601`),
+//                                  or using a `EternalTimestampFormat` pattern, e.g. '%d %B %Y[ %H:%M]|%~%N years ago'.
+// - ets_delta(ts1, ts2)            `calc_time_fast_delta()`: the sign orders the two timestamps.
+// - ets_trunc(ts, unit)            mark all fields below `unit` as 'unspecified'; `unit` is one of
+//                                  'century', 'year', 'month', 'day', 'hour', 'minute', 'second' or 'millisecond'.
+// - ets_sortkey(ts)                `calc_sort_key()`: an INTEGER which orders modern and prehistoric timestamps alike.
+// - ets_cmp(ts1, ts2)              -1/0/+1 comparison, consistent with `ets_sortkey()`.
+//
+// `ets_sortkey()` is DETERMINISTIC, hence you can create an index on it and have range queries use that index:
+//
+//     CREATE INDEX ev_ts ON events(ets_sortkey(ts));
+//     SELECT * FROM events WHERE ets_sortkey(ts) BETWEEN ets_sortkey(?1) AND ets_sortkey(?2);
+//
+// Table-valued function:
+//
+//     SELECT value FROM ets_series(start, stop [, step]);
+//     SELECT value FROM ets_series WHERE value >= ?1 AND value < ?2 AND step = 'hour';
+//
+// enumerates the (modern) timestamps from `start` up to and including `stop`. `step` is either an INTEGER number of
+// microseconds or one of 'second', 'minute', 'hour', 'day', 'week', 'month' or 'year'; it defaults to 'day'.
+// Range constraints on `value` are pushed down into the generator (`xBestIndex`), so a range query only
+// produces the rows it asks for instead of enumerating the series and filtering each row afterwards.
+
+#include <eternal_timestamp/eternal_timestamp.h>
+#include <eternal_timestamp/eternal_timestamp_format.h>
+
+#include <sqlite3ext.h>
+SQLITE_EXTENSION_INIT1
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "eternal_timestamp_internal.h"
+
+
+using namespace eternal_timestamp;
+
+
+static eternal_timestamp_t value_to_timestamp(sqlite3_value *v)
+{
+	eternal_timestamp_t t;
+	t.t = static_cast<uint64_t>(sqlite3_value_int64(v));
+	return t;
+}
+
+static void result_timestamp(sqlite3_context *ctx, const eternal_timestamp_t t)
+{
+	sqlite3_result_int64(ctx, static_cast<sqlite3_int64>(t.t));
+}
+
+static bool any_null(int argc, sqlite3_value **argv)
+{
+	for (int i = 0; i < argc; i++) {
+		if (sqlite3_value_type(argv[i]) == SQLITE_NULL)
+			return true;
+	}
+	return false;
+}
+
+
+// What `ets_format(ts)` renders: ISO 8601 at the precision the timestamp was specified at; prehistoric timestamps
+// by their age, e.g. "48000 BC" or "approx. 40000 BC".
+#define ETS_SQLITE_DEFAULT_FORMAT       ETS_FORMAT_ISO8601 "|%~%N BC[ -%m[-%d[T%H[:%M]]]]"
+
+static const ets_format_pattern_t &default_pattern()
+{
+	struct compiled
+	{
+		ets_format_pattern_t pattern;
+
+		compiled()
+		{
+			const int rv = EternalTimestampFormat::compile(pattern, ETS_SQLITE_DEFAULT_FORMAT);
+			ETS_ASSERT(rv == 0);
+			(void)rv;
+		}
+	};
+	static const compiled c;
+	return c.pattern;
+}
+
+static void result_formatted(sqlite3_context *ctx, const ets_format_pattern_t &pattern, const eternal_timestamp_t t)
+{
+	char buf[256];
+	const size_t n = EternalTimestampFormat::format(buf, sizeof(buf), pattern, t);
+	if (n < sizeof(buf)) {
+		sqlite3_result_text(ctx, buf, static_cast<int>(n), SQLITE_TRANSIENT);
+		return;
+	}
+	char *text = static_cast<char *>(sqlite3_malloc(static_cast<int>(n + 1)));
+	if (!text) {
+		sqlite3_result_error_nomem(ctx);
+		return;
+	}
+	EternalTimestampFormat::format(text, n + 1, pattern, t);
+	sqlite3_result_text(ctx, text, static_cast<int>(n), sqlite3_free);
+}
+
+
+enum truncation_unit
+{
+	ETS_TRUNC_INVALID = -1,
+	ETS_TRUNC_CENTURY = 0,
+	ETS_TRUNC_YEAR,
+	ETS_TRUNC_MONTH,
+	ETS_TRUNC_DAY,
+	ETS_TRUNC_HOUR,
+	ETS_TRUNC_MINUTE,
+	ETS_TRUNC_SECOND,
+	ETS_TRUNC_MILLISECOND,
+};
+
+static truncation_unit parse_truncation_unit(const char *unit)
+{
+	static const char *const names[] = { "century", "year", "month", "day", "hour", "minute", "second", "millisecond" };
+	if (!unit)
+		return ETS_TRUNC_INVALID;
+	for (int i = 0; i < static_cast<int>(sizeof(names) / sizeof(names[0])); i++) {
+		if (!sqlite3_stricmp(unit, names[i]))
+			return static_cast<truncation_unit>(i);
+	}
+	return ETS_TRUNC_INVALID;
+}
+
+// Mark every field below `unit` as 'unspecified'.
+static eternal_timestamp_t truncate_timestamp(eternal_timestamp_t t, truncation_unit unit)
+{
+	if (EternalTimestamp::is_modern_format(t)) {
+		switch (unit) {
+		case ETS_TRUNC_CENTURY:
+			t = ets_modern_set_year(t, get_Invalid(ETMT_FIELDSIZE_YEAR));
+			// fall through
+		case ETS_TRUNC_YEAR:
+			t = ets_modern_set_month(t, get_Invalid(ETMT_FIELDSIZE_MONTH));
+			// fall through
+		case ETS_TRUNC_MONTH:
+			t = ets_modern_set_day(t, get_Invalid(ETMT_FIELDSIZE_DAY));
+			// fall through
+		case ETS_TRUNC_DAY:
+			t = ets_modern_set_hour(t, get_Invalid(ETMT_FIELDSIZE_HOUR));
+			// fall through
+		case ETS_TRUNC_HOUR:
+			t = ets_modern_set_minute(t, get_Invalid(ETMT_FIELDSIZE_MINUTE));
+			// fall through
+		case ETS_TRUNC_MINUTE:
+			t = ets_modern_set_seconds(t, get_Invalid(ETMT_FIELDSIZE_SECONDS));
+			// fall through
+		case ETS_TRUNC_SECOND:
+			t = ets_modern_set_milliseconds(t, get_Invalid(ETMT_FIELDSIZE_MILLISECONDS));
+			// fall through
+		case ETS_TRUNC_MILLISECOND:
+			t = ets_modern_set_microseconds(t, get_Invalid(ETMT_FIELDSIZE_MICROSECONDS));
+			// fall through
+		default:
+			break;
+		}
+	}
+	else {
+		// prehistoric timestamps don't carry (milli/micro)seconds; the century & year are expressed through the `precision`.
+		switch (unit) {
+		case ETS_TRUNC_CENTURY:
+			if (ets_prehistoric_precision(t) < 2)
+				t = ets_prehistoric_set_precision(t, 2);
+			// fall through
+		case ETS_TRUNC_YEAR:
+			t = ets_prehistoric_set_month(t, get_Invalid(ETPHT_FIELDSIZE_MONTH));
+			// fall through
+		case ETS_TRUNC_MONTH:
+			t = ets_prehistoric_set_day(t, get_Invalid(ETPHT_FIELDSIZE_DAY));
+			// fall through
+		case ETS_TRUNC_DAY:
+			t = ets_prehistoric_set_hour(t, get_Invalid(ETPHT_FIELDSIZE_HOUR));
+			// fall through
+		case ETS_TRUNC_HOUR:
+			t = ets_prehistoric_set_minute(t, get_Invalid(ETPHT_FIELDSIZE_MINUTE));
+			// fall through
+		default:
+			break;
+		}
+	}
+	return t;
+}
+
+
+static void ets_now_func(sqlite3_context *ctx, int argc, sqlite3_value **argv)
+{
+	result_timestamp(ctx, EternalTimestamp::now());
+}
+
+static void ets_from_unix_func(sqlite3_context *ctx, int argc, sqlite3_value **argv)
+{
+	if (any_null(argc, argv))
+		return;
+
+	// only what a complete modern timestamp can carry: 9901 BC .. 41199 AD
+	int64_t usecs;
+	if (sqlite3_value_numeric_type(argv[0]) == SQLITE_FLOAT) {
+		const double us = floor(sqlite3_value_double(argv[0]) * 1.0E6 + 0.5);
+		if (!(us >= static_cast<double>(ETS_MODERN_MIN_UNIX_USECS) && us <= static_cast<double>(ETS_MODERN_MAX_UNIX_USECS))) {
+			sqlite3_result_error(ctx, "ets_from_unix: value out of range", -1);
+			return;
+		}
+		usecs = static_cast<int64_t>(us);
+	}
+	else {
+		const sqlite3_int64 secs = sqlite3_value_int64(argv[0]);
+		if (secs < ETS_MODERN_MIN_UNIX_USECS / USECS_PER_SECOND || secs > ETS_MODERN_MAX_UNIX_USECS / USECS_PER_SECOND) {
+			sqlite3_result_error(ctx, "ets_from_unix: value out of range", -1);
+			return;
+		}
+		usecs = secs * USECS_PER_SECOND;
+	}
+	if (argc > 1) {
+		// `usecs` is well within range by now, so this cannot overflow unless `extra` is way out of range itself.
+		const sqlite3_int64 extra = sqlite3_value_int64(argv[1]);
+		if (extra > 0 ? usecs > INT64_MAX - extra : usecs < INT64_MIN - extra) {
+			sqlite3_result_error(ctx, "ets_from_unix: value out of range", -1);
+			return;
+		}
+		usecs += extra;
+	}
+	if (usecs < ETS_MODERN_MIN_UNIX_USECS || usecs > ETS_MODERN_MAX_UNIX_USECS) {
+		sqlite3_result_error(ctx, "ets_from_unix: value out of range", -1);
+		return;
+	}
+
+	result_timestamp(ctx, ets_encode_modern_from_unix_usecs(usecs));
+}
+
+static void ets_to_unix_func(sqlite3_context *ctx, int argc, sqlite3_value **argv)
+{
+	if (any_null(argc, argv))
+		return;
+
+	int64_t usecs;
+	if (ets_decode_modern_to_unix_usecs(usecs, value_to_timestamp(argv[0])))
+		return;   // NULL: prehistoric or lacking a year
+	sqlite3_result_double(ctx, usecs / 1.0E6);
+}
+
+static void ets_format_func(sqlite3_context *ctx, int argc, sqlite3_value **argv)
+{
+	if (any_null(argc, argv))
+		return;
+
+	if (argc == 2) {
+		// the compiled pattern is cached for as long as the pattern argument stays the same, e.g. a constant.
+		ets_format_pattern_t *pattern = static_cast<ets_format_pattern_t *>(sqlite3_get_auxdata(ctx, 1));
+		const bool compiled = !pattern;
+		if (compiled) {
+			pattern = static_cast<ets_format_pattern_t *>(sqlite3_malloc(sizeof(ets_format_pattern_t)));
+			if (!pattern) {
+				sqlite3_result_error_nomem(ctx);
+				return;
+			}
+			if (EternalTimestampFormat::compile(*pattern, reinterpret_cast<const char *>(sqlite3_value_text(argv[1])))) {
+				sqlite3_free(pattern);
+				sqlite3_result_error(ctx, "ets_format: invalid pattern", -1);
+				return;
+			}
+		}
+
+		result_formatted(ctx, *pattern, value_to_timestamp(argv[0]));
+
+		// Hand a freshly compiled pattern over to SQLite, which owns the cached one: it may discard it right
+		// away, so this must come last.
+		if (compiled)
+			sqlite3_set_auxdata(ctx, 1, pattern, sqlite3_free);
+		return;
+	}
+
+	result_formatted(ctx, default_pattern(), value_to_timestamp(argv[0]));
+}
+
+static void ets_delta_func(sqlite3_context *ctx, int argc, sqlite3_value **argv)
+{
+	if (any_null(argc, argv))
+		return;
+
+	sqlite3_result_int64(ctx, EternalTimestamp::calc_time_fast_delta(value_to_timestamp(argv[0]), value_to_timestamp(argv[1])));
+}
+
+static void ets_trunc_func(sqlite3_context *ctx, int argc, sqlite3_value **argv)
+{
+	if (any_null(argc, argv))
+		return;
+
+	const truncation_unit unit = parse_truncation_unit(reinterpret_cast<const char *>(sqlite3_value_text(argv[1])));
+	if (unit == ETS_TRUNC_INVALID) {
+		sqlite3_result_error(ctx, "ets_trunc: unknown unit", -1);
+		return;
+	}
+	result_timestamp(ctx, truncate_timestamp(value_to_timestamp(argv[0]), unit));
+}
+
+static void ets_sortkey_func(sqlite3_context *ctx, int argc, sqlite3_value **argv)
+{
+	if (any_null(argc, argv))
+		return;
+
+	sqlite3_result_int64(ctx, EternalTimestamp::calc_sort_key(value_to_timestamp(argv[0])));
+}
+
+static void ets_cmp_func(sqlite3_context *ctx, int argc, sqlite3_value **argv)
+{
+	if (any_null(argc, argv))
+		return;
+
+	const int64_t a = EternalTimestamp::calc_sort_key(value_to_timestamp(argv[0]));
+	const int64_t b = EternalTimestamp::calc_sort_key(value_to_timestamp(argv[1]));
+	sqlite3_result_int(ctx, (a > b) - (a < b));
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ets_series virtual table
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+enum series_column
+{
+	SERIES_COLUMN_VALUE = 0,
+	SERIES_COLUMN_START,
+	SERIES_COLUMN_STOP,
+	SERIES_COLUMN_STEP,
+};
+
+// `idxNum` bits produced by `xBestIndex`; the `argv[]` passed to `xFilter` follow this bit order.
+enum series_plan
+{
+	SERIES_HAS_START = 0x01,
+	SERIES_HAS_STOP = 0x02,
+	SERIES_HAS_STEP = 0x04,
+	SERIES_HAS_LOWER = 0x08,
+	SERIES_HAS_UPPER = 0x10,
+	SERIES_LOWER_EXCLUSIVE = 0x20,
+	SERIES_UPPER_EXCLUSIVE = 0x40,
+	SERIES_VALUE_EQ = 0x80,        // a single `value = ?` argument serves as both lower and upper bound
+};
+
+struct series_cursor
+{
+	sqlite3_vtab_cursor base;
+
+	int64_t start_usecs;        // the series' origin: all values are `start + n * step`
+	int64_t step_usecs;         // fixed-size step; 0 when stepping through months
+	int64_t step_months;        // calendar step in months; 0 when `step_usecs` is used
+	int64_t n;                  // current row index, i.e. `rowid`
+	int64_t last_n;             // last row index to produce
+
+	sqlite3_value *start_value; // for the HIDDEN column values
+	sqlite3_value *stop_value;
+	sqlite3_value *step_value;
+};
+
+static int64_t series_usecs_at(const series_cursor *cur, int64_t n)
+{
+	if (!cur->step_months)
+		return cur->start_usecs + n * cur->step_usecs;
+
+	// calendar stepping: add n*step months to the start date while keeping the time of day;
+	// clip the day to the end of the target month, e.g. jan/31 + 1 month --> feb/28 or feb/29.
+	int64_t days = cur->start_usecs / USECS_PER_DAY;
+	int64_t tod = cur->start_usecs % USECS_PER_DAY;
+	if (tod < 0) {
+		tod += USECS_PER_DAY;
+		days--;
+	}
+	int64_t y;
+	unsigned int m, d;
+	ets_civil_from_days(days, y, m, d);
+
+	int64_t months = y * 12 + (m - 1) + n * cur->step_months;
+	y = (months >= 0 ? months : months - 11) / 12;
+	m = static_cast<unsigned int>(months - y * 12) + 1;
+
+	const int64_t next_month_start = (m == 12 ? ets_days_from_civil(y + 1, 1, 1) : ets_days_from_civil(y, m + 1, 1));
+	const unsigned int month_length = static_cast<unsigned int>(next_month_start - ets_days_from_civil(y, m, 1));
+	if (d > month_length)
+		d = month_length;
+
+	return ets_days_from_civil(y, m, d) * USECS_PER_DAY + tod;
+}
+
+// Return the smallest row index `n` for which `series_usecs_at(n) >= usecs`.
+static int64_t series_index_at_or_after(const series_cursor *cur, int64_t usecs)
+{
+	if (usecs <= cur->start_usecs)
+		return 0;
+
+	int64_t n;
+	if (!cur->step_months) {
+		n = (usecs - cur->start_usecs + cur->step_usecs - 1) / cur->step_usecs;
+	}
+	else {
+		// estimate using the shortest possible month, then walk back/forward to the exact index
+		n = (usecs - cur->start_usecs) / (28 * USECS_PER_DAY * cur->step_months);
+		while (n > 0 && series_usecs_at(cur, n - 1) >= usecs)
+			n--;
+		while (series_usecs_at(cur, n) < usecs)
+			n++;
+	}
+	return n;
+}
+
+// Return the largest row index `n` for which `series_usecs_at(n) <= usecs`, or -1 when there is none.
+static int64_t series_index_at_or_before(const series_cursor *cur, int64_t usecs)
+{
+	if (usecs < cur->start_usecs)
+		return -1;
+
+	const int64_t n = series_index_at_or_after(cur, usecs);
+	if (series_usecs_at(cur, n) == usecs)
+		return n;
+	return n - 1;
+}
+
+static int parse_series_step(series_cursor *cur, sqlite3_value *v)
+{
+	cur->step_usecs = 0;
+	cur->step_months = 0;
+
+	if (!v) {
+		cur->step_usecs = USECS_PER_DAY;
+		return SQLITE_OK;
+	}
+	if (sqlite3_value_type(v) == SQLITE_INTEGER) {
+		cur->step_usecs = sqlite3_value_int64(v);
+		return (cur->step_usecs > 0 ? SQLITE_OK : SQLITE_ERROR);
+	}
+
+	const char *unit = reinterpret_cast<const char *>(sqlite3_value_text(v));
+	if (!unit)
+		return SQLITE_ERROR;
+
+	static const struct
+	{
+		const char *name;
+		int64_t usecs;
+		int64_t months;
+	} units[] = {
+		{ "second", USECS_PER_SECOND, 0 },
+		{ "minute", 60 * USECS_PER_SECOND, 0 },
+		{ "hour", 3600 * USECS_PER_SECOND, 0 },
+		{ "day", USECS_PER_DAY, 0 },
+		{ "week", 7 * USECS_PER_DAY, 0 },
+		{ "month", 0, 1 },
+		{ "year", 0, 12 },
+	};
+	for (const auto &u : units) {
+		if (!sqlite3_stricmp(unit, u.name)) {
+			cur->step_usecs = u.usecs;
+			cur->step_months = u.months;
+			return SQLITE_OK;
+		}
+	}
+	return SQLITE_ERROR;
+}
+
+static int series_connect(sqlite3 *db, void *aux, int argc, const char *const *argv, sqlite3_vtab **ppVtab, char **pzErr)
+{
+	int rc = sqlite3_declare_vtab(db, "CREATE TABLE x(value INTEGER, start HIDDEN, stop HIDDEN, step HIDDEN)");
+	if (rc != SQLITE_OK)
+		return rc;
+
+	sqlite3_vtab *vtab = static_cast<sqlite3_vtab *>(sqlite3_malloc(sizeof(sqlite3_vtab)));
+	if (!vtab)
+		return SQLITE_NOMEM;
+	memset(vtab, 0, sizeof(*vtab));
+	sqlite3_vtab_config(db, SQLITE_VTAB_INNOCUOUS);
+	*ppVtab = vtab;
+	return SQLITE_OK;
+}
+
+static int series_disconnect(sqlite3_vtab *vtab)
+{
+	sqlite3_free(vtab);
+	return SQLITE_OK;
+}
+
+static int series_open(sqlite3_vtab *vtab, sqlite3_vtab_cursor **ppCursor)
+{
+	series_cursor *cur = static_cast<series_cursor *>(sqlite3_malloc(sizeof(series_cursor)));
+	if (!cur)
+		return SQLITE_NOMEM;
+	memset(cur, 0, sizeof(*cur));
+	*ppCursor = &cur->base;
+	return SQLITE_OK;
+}
+
+static void series_reset(series_cursor *cur)
+{
+	sqlite3_value_free(cur->start_value);
+	sqlite3_value_free(cur->stop_value);
+	sqlite3_value_free(cur->step_value);
+	cur->start_value = nullptr;
+	cur->stop_value = nullptr;
+	cur->step_value = nullptr;
+}
+
+static int series_close(sqlite3_vtab_cursor *base)
+{
+	series_cursor *cur = reinterpret_cast<series_cursor *>(base);
+	series_reset(cur);
+	sqlite3_free(cur);
+	return SQLITE_OK;
+}
+
+static int series_next(sqlite3_vtab_cursor *base)
+{
+	series_cursor *cur = reinterpret_cast<series_cursor *>(base);
+	cur->n++;
+	return SQLITE_OK;
+}
+
+static int series_eof(sqlite3_vtab_cursor *base)
+{
+	const series_cursor *cur = reinterpret_cast<const series_cursor *>(base);
+	return cur->n > cur->last_n;
+}
+
+static int series_column(sqlite3_vtab_cursor *base, sqlite3_context *ctx, int column)
+{
+	const series_cursor *cur = reinterpret_cast<const series_cursor *>(base);
+	switch (column) {
+	case SERIES_COLUMN_VALUE:
+		result_timestamp(ctx, ets_encode_modern_from_unix_usecs(series_usecs_at(cur, cur->n)));
+		break;
+	case SERIES_COLUMN_START:
+		if (cur->start_value)
+			sqlite3_result_value(ctx, cur->start_value);
+		break;
+	case SERIES_COLUMN_STOP:
+		if (cur->stop_value)
+			sqlite3_result_value(ctx, cur->stop_value);
+		break;
+	case SERIES_COLUMN_STEP:
+		if (cur->step_value)
+			sqlite3_result_value(ctx, cur->step_value);
+		break;
+	}
+	return SQLITE_OK;
+}
+
+static int series_rowid(sqlite3_vtab_cursor *base, sqlite_int64 *pRowid)
+{
+	const series_cursor *cur = reinterpret_cast<const series_cursor *>(base);
+	*pRowid = cur->n + 1;
+	return SQLITE_OK;
+}
+
+// Convert a bound to microseconds since the UNIX epoch. Prehistoric bounds are clipped to the start of the modern range.
+static int64_t series_bound_usecs(sqlite3_value *v)
+{
+	const eternal_timestamp_t t = value_to_timestamp(v);
+	int64_t usecs;
+	if (ets_decode_modern_to_unix_usecs(usecs, t)) {
+		if (EternalTimestamp::is_prehistoric_format(t))
+			return INT64_MIN / 2;
+		return INT64_MAX / 2;    // modern, yet no known year: sorts *before* any dated value with the marker-sorts-first config, but we cannot enumerate those.
+	}
+	return usecs;
+}
+
+static int series_filter(sqlite3_vtab_cursor *base, int idxNum, const char *idxStr, int argc, sqlite3_value **argv)
+{
+	series_cursor *cur = reinterpret_cast<series_cursor *>(base);
+	sqlite3_vtab *vtab = base->pVtab;
+	series_reset(cur);
+
+	int i = 0;
+	sqlite3_value *start = (idxNum & SERIES_HAS_START ? argv[i++] : nullptr);
+	sqlite3_value *stop = (idxNum & SERIES_HAS_STOP ? argv[i++] : nullptr);
+	sqlite3_value *step = (idxNum & SERIES_HAS_STEP ? argv[i++] : nullptr);
+	sqlite3_value *lower = (idxNum & SERIES_HAS_LOWER ? argv[i++] : nullptr);
+	sqlite3_value *upper = (idxNum & SERIES_VALUE_EQ ? lower : idxNum & SERIES_HAS_UPPER ? argv[i++] : nullptr);
+
+	// an empty series when any of the parameters or bounds is NULL:
+	cur->n = 0;
+	cur->last_n = -1;
+	for (int j = 0; j < argc; j++) {
+		if (sqlite3_value_type(argv[j]) == SQLITE_NULL)
+			return SQLITE_OK;
+	}
+
+	if (parse_series_step(cur, step) != SQLITE_OK) {
+		sqlite3_free(vtab->zErrMsg);
+		vtab->zErrMsg = sqlite3_mprintf("ets_series: invalid step");
+		return SQLITE_ERROR;
+	}
+	if (!start && !lower) {
+		sqlite3_free(vtab->zErrMsg);
+		vtab->zErrMsg = sqlite3_mprintf("ets_series: a start value or a lower bound on 'value' is required");
+		return SQLITE_ERROR;
+	}
+	if (!stop && !upper) {
+		sqlite3_free(vtab->zErrMsg);
+		vtab->zErrMsg = sqlite3_mprintf("ets_series: a stop value or an upper bound on 'value' is required");
+		return SQLITE_ERROR;
+	}
+
+	if (start) {
+		cur->start_value = sqlite3_value_dup(start);
+		if (EternalTimestamp::is_prehistoric_format(value_to_timestamp(start))) {
+			sqlite3_free(vtab->zErrMsg);
+			vtab->zErrMsg = sqlite3_mprintf("ets_series: prehistoric timestamps cannot be enumerated");
+			return SQLITE_ERROR;
+		}
+		cur->start_usecs = series_bound_usecs(start);
+	}
+	else {
+		cur->start_usecs = series_bound_usecs(lower);
+	}
+	if (stop)
+		cur->stop_value = sqlite3_value_dup(stop);
+	if (step)
+		cur->step_value = sqlite3_value_dup(step);
+
+	const int64_t stop_usecs = series_bound_usecs(stop ? stop : upper);
+	if (stop_usecs < cur->start_usecs)
+		return SQLITE_OK;
+	if (stop_usecs - cur->start_usecs >= INT64_MAX / 4) {
+		sqlite3_free(vtab->zErrMsg);
+		vtab->zErrMsg = sqlite3_mprintf("ets_series: range cannot be enumerated");
+		return SQLITE_ERROR;
+	}
+	cur->last_n = series_index_at_or_before(cur, stop_usecs);
+
+	// push the 'value' range constraints into the generator: clip the [n, last_n] row index range.
+	//
+	// We compare using `calc_sort_key()`, so the timestamp order semantics apply, irrespective of the raw bit pattern.
+	if (lower) {
+		const int64_t key = EternalTimestamp::calc_sort_key(value_to_timestamp(lower));
+		int64_t n = series_index_at_or_after(cur, series_bound_usecs(lower));
+		if (n > 0)
+			n--;
+		while (n <= cur->last_n) {
+			const int64_t k = EternalTimestamp::calc_sort_key(ets_encode_modern_from_unix_usecs(series_usecs_at(cur, n)));
+			if (k > key || (k == key && !(idxNum & SERIES_LOWER_EXCLUSIVE)))
+				break;
+			n++;
+		}
+		cur->n = n;
+	}
+	if (upper) {
+		const int64_t key = EternalTimestamp::calc_sort_key(value_to_timestamp(upper));
+		int64_t n = series_index_at_or_before(cur, series_bound_usecs(upper)) + 1;
+		if (n > cur->last_n)
+			n = cur->last_n;
+		while (n >= cur->n) {
+			const int64_t k = EternalTimestamp::calc_sort_key(ets_encode_modern_from_unix_usecs(series_usecs_at(cur, n)));
+			if (k < key || (k == key && !(idxNum & SERIES_UPPER_EXCLUSIVE)))
+				break;
+			n--;
+		}
+		cur->last_n = n;
+	}
+	return SQLITE_OK;
+}
+
+static int series_best_index(sqlite3_vtab *vtab, sqlite3_index_info *info)
+{
+	int arg_index[5] = { -1, -1, -1, -1, -1 };   // start, stop, step, lower, upper
+	int plan = 0;
+
+	for (int i = 0; i < info->nConstraint; i++) {
+		const auto &c = info->aConstraint[i];
+		if (c.iColumn == SERIES_COLUMN_VALUE) {
+			if (!c.usable || (plan & SERIES_VALUE_EQ))
+				continue;
+			switch (c.op) {
+			case SQLITE_INDEX_CONSTRAINT_GT:
+			case SQLITE_INDEX_CONSTRAINT_GE:
+				if (arg_index[3] < 0) {
+					arg_index[3] = i;
+					plan |= SERIES_HAS_LOWER | (c.op == SQLITE_INDEX_CONSTRAINT_GT ? SERIES_LOWER_EXCLUSIVE : 0);
+				}
+				break;
+			case SQLITE_INDEX_CONSTRAINT_LT:
+			case SQLITE_INDEX_CONSTRAINT_LE:
+				if (arg_index[4] < 0) {
+					arg_index[4] = i;
+					plan |= SERIES_HAS_UPPER | (c.op == SQLITE_INDEX_CONSTRAINT_LT ? SERIES_UPPER_EXCLUSIVE : 0);
+				}
+				break;
+			case SQLITE_INDEX_CONSTRAINT_EQ:
+				// an equality constraint serves as both the lower and the upper bound; it replaces any bounds seen so far.
+				arg_index[3] = i;
+				arg_index[4] = -1;
+				plan &= ~(SERIES_LOWER_EXCLUSIVE | SERIES_UPPER_EXCLUSIVE);
+				plan |= SERIES_HAS_LOWER | SERIES_HAS_UPPER | SERIES_VALUE_EQ;
+				break;
+			}
+			continue;
+		}
+		if (c.iColumn < SERIES_COLUMN_START || c.op != SQLITE_INDEX_CONSTRAINT_EQ)
+			continue;
+		// A table-valued function argument which cannot be used (yet) means this plan is no good: ask for another one.
+		if (!c.usable)
+			return SQLITE_CONSTRAINT;
+		const int slot = c.iColumn - SERIES_COLUMN_START;
+		if (arg_index[slot] < 0) {
+			arg_index[slot] = i;
+			plan |= (SERIES_HAS_START << slot);
+		}
+	}
+
+	int argv_index = 0;
+	for (int slot = 0; slot < 5; slot++) {
+		const int i = arg_index[slot];
+		if (i < 0)
+			continue;
+		info->aConstraintUsage[i].argvIndex = ++argv_index;
+		// the generator applies the bounds exactly, using the timestamp order, so SQLite need not double-check them:
+		info->aConstraintUsage[i].omit = 1;
+	}
+
+	const bool has_lower_end = (plan & (SERIES_HAS_START | SERIES_HAS_LOWER));
+	const bool has_upper_end = (plan & (SERIES_HAS_STOP | SERIES_HAS_UPPER));
+	if (has_lower_end && has_upper_end) {
+		const bool narrowed = (plan & (SERIES_HAS_LOWER | SERIES_HAS_UPPER));
+		info->estimatedCost = (narrowed ? 10.0 : 1000.0);
+		info->estimatedRows = (narrowed ? 10 : 1000);
+	}
+	else {
+		// unbounded: xFilter reports an error when this plan gets picked anyway.
+		info->estimatedCost = 2147483647.0;
+		info->estimatedRows = 2147483647;
+	}
+	info->idxNum = plan;
+	return SQLITE_OK;
+}
+
+static sqlite3_module series_module = {
+	0,                    // iVersion
+	nullptr,              // xCreate: eponymous-only virtual table
+	series_connect,       // xConnect
+	series_best_index,    // xBestIndex
+	series_disconnect,    // xDisconnect
+	nullptr,              // xDestroy
+	series_open,          // xOpen
+	series_close,         // xClose
+	series_filter,        // xFilter
+	series_next,          // xNext
+	series_eof,           // xEof
+	series_column,        // xColumn
+	series_rowid,         // xRowid
+	nullptr,              // xUpdate
+	nullptr,              // xBegin
+	nullptr,              // xSync
+	nullptr,              // xCommit
+	nullptr,              // xRollback
+	nullptr,              // xFindMethod
+	nullptr,              // xRename
+	nullptr,              // xSavepoint
+	nullptr,              // xRelease
+	nullptr,              // xRollbackTo
+	nullptr,              // xShadowName
+};
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// extension entry point
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if defined(_WIN32)
+#define ETS_SQLITE_EXPORT		__declspec(dllexport)
+#else
+#define ETS_SQLITE_EXPORT		__attribute__((visibility("default")))
+#endif
+
+extern "C" ETS_SQLITE_EXPORT int sqlite3_eternaltimestamp_init(sqlite3 *db, char **pzErrMsg, const sqlite3_api_routines *pApi)
+{
+	SQLITE_EXTENSION_INIT2(pApi);
+
+	static const int pure = SQLITE_UTF8 | SQLITE_DETERMINISTIC | SQLITE_INNOCUOUS;
+
+	static const struct
+	{
+		const char *name;
+		int argc;
+		int flags;
+		void (*func)(sqlite3_context *, int, sqlite3_value **);
+	} functions[] = {
+		{ "ets_now", 0, SQLITE_UTF8 | SQLITE_INNOCUOUS, ets_now_func },
+		{ "ets_from_unix", 1, pure, ets_from_unix_func },
+		{ "ets_from_unix", 2, pure, ets_from_unix_func },
+		{ "ets_to_unix", 1, pure, ets_to_unix_func },
+		{ "ets_format", 1, pure, ets_format_func },
+		{ "ets_format", 2, pure, ets_format_func },
+		{ "ets_delta", 2, pure, ets_delta_func },
+		{ "ets_trunc", 2, pure, ets_trunc_func },
+		{ "ets_sortkey", 1, pure, ets_sortkey_func },
+		{ "ets_cmp", 2, pure, ets_cmp_func },
+	};
+
+	int rc = SQLITE_OK;
+	for (const auto &f : functions) {
+		rc = sqlite3_create_function(db, f.name, f.argc, f.flags, nullptr, f.func, nullptr, nullptr);
+		if (rc != SQLITE_OK)
+			return rc;
+	}
+
+	rc = sqlite3_create_module(db, "ets_series", &series_module, nullptr);
+	return rc;
+}
@@ -2,151 +2,33 @@
 #ifndef __ETERNAL_TIMESTAMP_HPP__
 #include "eternal_timestamp/eternal_timestamp.h"
 #endif
+#include "eternal_timestamp/eternal_timestamp_endian.h"
 
+#include <atomic>
 #include <chrono>
+#include <climits>
 #include <ctime>
 
-#ifndef NDEBUG
-#include <stdio.h>
-#include <stdlib.h>
-
-#define ETS_ASSERT(t)			((t) ? (void)0 : (void)fprintf(stderr, "ETTM assertion %s failed at %s:%d\n", #t, __FILE__, __LINE__))
-#else
-#define ETS_ASSERT(t)			(void)0
-#endif
+#include "eternal_timestamp_instrumentation.h"
+#include "eternal_timestamp_internal.h"
 
 
 using namespace eternal_timestamp;
 
 
-enum fieldsize : unsigned int
-{
-	ETMT_FIELDSIZE_CENTURY = 9,
-	ETMT_FIELDSIZE_YEAR = 7,
-	ETMT_FIELDSIZE_MONTH = 4,
-	ETMT_FIELDSIZE_DAY = 5,
-	ETMT_FIELDSIZE_HOUR = 5,
-	ETMT_FIELDSIZE_MINUTE = 6,
-	ETMT_FIELDSIZE_SECONDS = 6,
-	ETMT_FIELDSIZE_MILLISECONDS = 10,
-	ETMT_FIELDSIZE_MICROSECONDS = 10,
-
-	ETPHT_FIELDSIZE_YEARS = 38,
-	ETPHT_FIELDSIZE_MONTH = 4,
-	ETPHT_FIELDSIZE_DAY = 5,
-	ETPHT_FIELDSIZE_HOUR = 5,
-	ETPHT_FIELDSIZE_MINUTE = 6,
-	ETPHT_FIELDSIZE_PRECISION = 4,
-};
-
-// Produce the "this-is-invalid-or-unknown" value for this field, being the maximum value available.
-constexpr inline unsigned int get_MaxInvalid(unsigned int field_size_in_bits)
-{
-	const unsigned int invalid = (1 << field_size_in_bits) - 1;
-	return invalid;
-}
-
-// Produce the "this-is-invalid-or-unknown" value for this field, being the minimum value available.
-constexpr inline unsigned int get_MinInvalid(unsigned int field_size_in_bits)
-{
-	const unsigned int invalid = 0;
-	return invalid;
-}
-
-
-#if ETS_UNSPECIFIED_MARKER_SORTS_BEFORE_1ST_VALUE
-
-// Produce the "this-is-invalid-or-unknown" value for this field.
-constexpr inline unsigned int get_Invalid(unsigned int field_size_in_bits)
-{
-	return get_MinInvalid(field_size_in_bits);
-}
-
-// Clip the field value to its legal range or signal it as 'invalid'.
-//
-// - `v` is the field value to clip.
-// - `field_size_in_bits` is the field's size in bits.
-// - `value_range` is the legal range for this field's value. For example, for the hour field this would be 24.
-//
-// As the eternal_timestamp library is compiled as using 0 for the field's invalid value,
-// the actual legal value range is $[1,\text{value_range}]$, which f.e. for the hour field would then
-// be the range $[1,24]$.
-constexpr inline unsigned int clip_Invalid(int v, unsigned int field_size_in_bits, int value_range)
-{
-	const unsigned int invalid = get_Invalid(field_size_in_bits);
-	v++;
-	// clip to value range [1..value_range]
-	if (v <= 0)
-		return invalid;
-	if (v > value_range)
-		return invalid;
-	return v;
-}
-
-static constexpr int FIELD_VAL_OFFSET = 1;
-
-#else
-
-// Produce the "this-is-invalid-or-unknown" value for this field.
-constexpr inline unsigned int get_Invalid(unsigned int field_size_in_bits)
-{
-	return get_MaxInvalid(field_size_in_bits);
-}
-
-// Clip the field value to its legal range or signal it as 'invalid'.
-//
-// - `v` is the field value to clip.
-// - `field_size_in_bits` is the field's size in bits.
-// - `value_range` is the legal range for this field's value. For example, for the hour field this would be 24.
-//
-// As the eternal_timestamp library is compiled as using the maximum field value for the field's invalid value,
-// the actual legal value range is $[0,\text{value_range}-1]$, which f.e. for the hour field would then
-// be the range $[0,23]$.
-constexpr inline unsigned int clip_Invalid(int v, unsigned int field_size_in_bits, int value_range)
-{
-	const unsigned int invalid = get_MaxInvalid(field_size_in_bits);
-	// clip
-	if (v < 0)
-		return invalid;
-	if (v >= value_range)
-		return invalid;
-	return v;
-}
-
-static constexpr int FIELD_VAL_OFFSET = 0;
-
-#endif // ETS_UNSPECIFIED_MARKER_SORTS_BEFORE_1ST_VALUE
-
-
-static constexpr const int MODERN_EPOCH = 10000;    // 10000 B.C.
-static constexpr const int PREHISTORIC_EPOCH = 0;   // 0 A.D.
-
-
 // Return the current time/date (timestamp) as an eternal_timestamp value.
 //
 // Notes:
 // - extra feature: we never produce the same timestamp for 'now' by artificially "bumping" it a microsecond or more if needed.
 eternal_timestamp_t EternalTimestamp::now()
 {
+	ETS_STATS_ENTRY(NOW);
 #if defined(_WIN32)
 	SYSTEMTIME st;
 	FILETIME ft;
-	eternal_modern_timestamp t{0};
-
 	GetSystemTime(&st);
 	GetSystemTimePreciseAsFileTime(&ft);  // Contains a 64-bit value representing the number of 100-nanosecond intervals since January 1, 1601 (UTC).
 
-	int y = st.wYear;
-	y += MODERN_EPOCH;
-	t.century = y / 100;
-	t.year = FIELD_VAL_OFFSET + y % 100;
-	t.month = FIELD_VAL_OFFSET - 1 + st.wMonth;
-	t.day = FIELD_VAL_OFFSET - 1 + st.wDay;
-	t.hour = FIELD_VAL_OFFSET + st.wHour;
-	t.minute = FIELD_VAL_OFFSET + st.wMinute;
-	t.seconds = FIELD_VAL_OFFSET + st.wSecond;
-	t.milliseconds = FIELD_VAL_OFFSET + st.wMilliseconds;
-
 	uint64_t tt = ft.dwHighDateTime;
 	tt <<= 32;
 	tt += ft.dwLowDateTime;
@@ -156,6 +38,7 @@ eternal_timestamp_t EternalTimestamp::now()
 	static uint64_t last_tt{0};
 	uint32_t offset = 0;
 	if (tt == last_real_tt) {
+		ETS_STATS_EVENT(NOW_BUMPED);
 		tt = ++last_tt;
 		offset = tt - last_real_tt;
 		ft.dwLowDateTime += offset;
@@ -175,84 +58,73 @@ eternal_timestamp_t EternalTimestamp::now()
 	ETS_ASSERT(us < 1000);
 	ETS_ASSERT(ms >= 0);
 	ETS_ASSERT(ms < 1000);
-	t.microseconds = FIELD_VAL_OFFSET + us;
-	t.milliseconds = FIELD_VAL_OFFSET + ms;
 
-	if (FileTimeToSystemTime(&ft, &st)) {
-		y = st.wYear;
-		y += MODERN_EPOCH;
-		t.century = y / 100;
-		t.year = FIELD_VAL_OFFSET + y % 100;
-		t.month = FIELD_VAL_OFFSET - 1 + st.wMonth;
-		t.day = FIELD_VAL_OFFSET - 1 + st.wDay;
-		t.hour = FIELD_VAL_OFFSET + st.wHour;
-		t.minute = FIELD_VAL_OFFSET + st.wMinute;
-		t.seconds = FIELD_VAL_OFFSET + st.wSecond;
-		t.milliseconds = FIELD_VAL_OFFSET + st.wMilliseconds;
-	}
-	else {
+	if (!FileTimeToSystemTime(&ft, &st)) {
 		ETS_ASSERT(!"Should not get here!");
 	}
 
-	// t value is now a positive offset value from 10000 BC.
-	eternal_timestamp_t rv;
-	rv.modern = t;
-	return rv;
+	// t value is a positive offset value from 10000 BC.
+	return ets_encode_modern(st.wYear, st.wMonth, st.wDay, st.wHour, st.wMinute, st.wSecond, st.wMilliseconds, us);
 #else
-	return {0};
+	struct timespec ts;
+	clock_gettime(CLOCK_REALTIME, &ts);
+
+	int64_t usecs = static_cast<int64_t>(ts.tv_sec) * USECS_PER_SECOND + ts.tv_nsec / 1000;
+
+	// little extra feature: we never produce the same timestamp for 'now' by artificially "bumping" it a microsecond or more if needed.
+	static std::atomic<int64_t> last_usecs{0};
+	int64_t last = last_usecs.load(std::memory_order_relaxed);
+	int64_t next;
+	do {
+		next = (usecs > last ? usecs : last + 1);
+	} while (!last_usecs.compare_exchange_weak(last, next, std::memory_order_relaxed));
+	ETS_STATS_EVENT_IF(NOW_BUMPED, next != usecs);
+
+	return ets_encode_modern_from_unix_usecs(next);
 #endif
 }
 
 eternal_timestamp_t EternalTimestamp::today()
 {
+	ETS_STATS_ENTRY(TODAY);
 #if defined(_WIN32)
 	SYSTEMTIME st;
-	eternal_modern_timestamp t{0};
 
 	GetSystemTime(&st);
 
-	int y = st.wYear;
-	y += MODERN_EPOCH;
-	t.century = y / 100;
-	t.year = FIELD_VAL_OFFSET + y % 100;
-	t.month = FIELD_VAL_OFFSET - 1 + st.wMonth;
-	t.day = FIELD_VAL_OFFSET - 1 + st.wDay;
-
-	// t value is now a positive offset value from 10000 BC.
-	eternal_timestamp_t rv;
-	rv.modern = t;
-	return rv;
+	// a positive offset value from 10000 BC; the time of day is 'unspecified'.
+	return ETS_TIMESTAMP(ets_layout_encode_modern_date<ets_native_layout>(st.wYear, st.wMonth, st.wDay));
 #else
-	return {0};
+	struct timespec ts;
+	clock_gettime(CLOCK_REALTIME, &ts);
+
+	eternal_timestamp_t rv = ets_encode_modern_from_unix_usecs(static_cast<int64_t>(ts.tv_sec) * USECS_PER_SECOND);
+	rv = ets_modern_set_hour(rv, get_Invalid(ETMT_FIELDSIZE_HOUR));
+	rv = ets_modern_set_minute(rv, get_Invalid(ETMT_FIELDSIZE_MINUTE));
+	rv = ets_modern_set_seconds(rv, get_Invalid(ETMT_FIELDSIZE_SECONDS));
+	rv = ets_modern_set_milliseconds(rv, get_Invalid(ETMT_FIELDSIZE_MILLISECONDS));
+	rv = ets_modern_set_microseconds(rv, get_Invalid(ETMT_FIELDSIZE_MICROSECONDS));
+	return rv;
 #endif
 }
 
 eternal_timestamp_t EternalTimestamp::today_at(int hour, int minute, int second)
 {
+	ETS_STATS_ENTRY(TODAY_AT);
 	eternal_timestamp_t t = today();
 
 	ETS_ASSERT(is_modern_format(t));
 	ETS_ASSERT(!is_partial_timestamp(t));
 
-	t.modern.hour = clip_Invalid(hour, ETMT_FIELDSIZE_HOUR, 24);
-	t.modern.minute = clip_Invalid(minute, ETMT_FIELDSIZE_MINUTE, 60);
-	t.modern.seconds = clip_Invalid(second, ETMT_FIELDSIZE_SECONDS, 60);
-	t.modern.milliseconds = 0;
-	t.modern.microseconds = 0;
+	t = ets_modern_set_hour(t, clip_Invalid(hour, ETMT_FIELDSIZE_HOUR, 24));
+	t = ets_modern_set_minute(t, clip_Invalid(minute, ETMT_FIELDSIZE_MINUTE, 60));
+	t = ets_modern_set_seconds(t, clip_Invalid(second, ETMT_FIELDSIZE_SECONDS, 60));
+	t = ets_modern_set_milliseconds(t, 0);
+	t = ets_modern_set_microseconds(t, 0);
 
 	return t;
 }
 
-// produce a timestamp that has all fields set to 'not specified':
-constexpr inline eternal_timestamp_t EternalTimestamp::unknown()
-{
-#if ETS_UNSPECIFIED_MARKER_SORTS_BEFORE_1ST_VALUE
-	return {0};
-#else
-	return {0x3FFFFFFFFFFFFFFFULL};
-#endif
-}
-
 bool EternalTimestamp::is_valid(const eternal_timestamp_t t)
 {
 	return 0;
@@ -276,209 +148,11 @@ bool EternalTimestamp::is_partial_timestamp(const eternal_timestamp_t t)
 // convert a partial timestamp by rebasing it against the given base timestamp
 eternal_timestamp_t EternalTimestamp::normalize(const eternal_timestamp_t t, const eternal_timestamp_t base)
 {
+	ETS_STATS_ENTRY(NORMALIZE);
 	return {0};
 }
 
 
-bool EternalTimestamp::has_century(const eternal_timestamp_t t)
-{
-	if (is_modern_format(t))
-	{
-		return t.modern.century != get_Invalid(ETMT_FIELDSIZE_CENTURY);
-	}
-	else
-	{
-		// Okay, this is a bit arbitrary, but we define 'has_century' here as 'known to within a century precise',
-		// hence this is equivalent to a 'precison' = 2, i.e. a precision of 10^2 == 100.
-		// Otherwise we'ld be talking about *milennia* or *aeons*.
-		return t.prehistoric.years != get_Invalid(ETPHT_FIELDSIZE_YEARS) 
-			&& t.prehistoric.precision < 3;   // we need precision=2 (i.e. 10^2 ==> 100) or *better* as precision indicator or we won't know the year within the millenium.
-	}
-}
-
-bool EternalTimestamp::has_year(const eternal_timestamp_t t)
-{
-	if (is_modern_format(t))
-	{
-		return t.modern.year != get_Invalid(ETMT_FIELDSIZE_YEAR);
-	}
-	else
-	{
-		return t.prehistoric.years != get_Invalid(ETPHT_FIELDSIZE_YEARS) 
-			&& t.prehistoric.precision < 2;   // we need precision=0 (i.e. 10^0 ==> 1) or precision=1 (i.e. 10^1==>10) as precision indicator or we won't know the year within the century.
-	}
-}
-
-bool EternalTimestamp::has_century_and_year(const eternal_timestamp_t t)
-{
-	if (is_modern_format(t))
-	{
-		return has_century(t) && has_year(t);
-	}
-	else
-	{
-		return t.prehistoric.years != get_Invalid(ETPHT_FIELDSIZE_YEARS)
-			&& t.prehistoric.precision < 2;   // we need precision=0 (i.e. 10^0 ==> 1) or precision=1 (i.e. 10^1==>10) as precision indicator or we won't know the year within the century.
-	}
-}
-
-// and probably more appropriate for *prehistoric* dates to ask: do we know the year to *any* precision at all?
-bool EternalTimestamp::has_age(const eternal_timestamp_t t)
-{
-	if (is_modern_format(t))
-	{
-		return has_century(t) && has_year(t);
-	}
-	else
-	{
-		return t.prehistoric.years != get_Invalid(ETPHT_FIELDSIZE_YEARS);
-	}
-}
-
-bool EternalTimestamp::has_month(const eternal_timestamp_t t)
-{
-	if (is_modern_format(t))
-	{
-		return t.modern.month != get_Invalid(ETMT_FIELDSIZE_MONTH);
-	}
-	else
-	{
-		return t.prehistoric.month != get_Invalid(ETPHT_FIELDSIZE_MONTH);
-	}
-}
-
-bool EternalTimestamp::has_day(const eternal_timestamp_t t)
-{
-	if (is_modern_format(t))
-	{
-		return t.modern.day != get_Invalid(ETMT_FIELDSIZE_DAY);
-	}
-	else
-	{
-		return t.prehistoric.day != get_Invalid(ETPHT_FIELDSIZE_DAY);
-	}
-}
-
-bool EternalTimestamp::has_hour(const eternal_timestamp_t t)
-{
-	if (is_modern_format(t))
-	{
-		return t.modern.hour != get_Invalid(ETMT_FIELDSIZE_HOUR);
-	}
-	else
-	{
-		return t.prehistoric.hour != get_Invalid(ETPHT_FIELDSIZE_HOUR);
-	}
-}
-
-bool EternalTimestamp::has_minute(const eternal_timestamp_t t)
-{
-	if (is_modern_format(t))
-	{
-		return t.modern.minute != get_Invalid(ETMT_FIELDSIZE_MINUTE);
-	}
-	else
-	{
-		return t.prehistoric.minute != get_Invalid(ETPHT_FIELDSIZE_MINUTE);
-	}
-}
-
-bool EternalTimestamp::has_seconds(const eternal_timestamp_t t)
-{
-	if (is_modern_format(t))
-	{
-		return t.modern.seconds != get_Invalid(ETMT_FIELDSIZE_SECONDS);
-	}
-	else
-	{
-		return false;
-	}
-}
-
-bool EternalTimestamp::has_milliseconds(const eternal_timestamp_t t)
-{
-	if (is_modern_format(t))
-	{
-		return t.modern.milliseconds != get_Invalid(10);
-	}
-	else
-	{
-		return false;
-	}
-}
-
-bool EternalTimestamp::has_microseconds(const eternal_timestamp_t t)
-{
-	if (is_modern_format(t))
-	{
-		return t.modern.microseconds != get_Invalid(10);
-	}
-	else
-	{
-		return false;
-	}
-}
-
-bool EternalTimestamp::has_complete_date(const eternal_timestamp_t t)
-{
-	if (is_modern_format(t))
-	{
-		return has_century(t) && has_year(t) && has_month(t) && has_day(t);
-	}
-	else
-	{
-		// Well... in *prehistory* we would accept *anything* really, 
-		// but THIS is a *technical* question: do we have all the date elements
-		// so we can use them without fear of using invalid values for *any* part?
-		//
-		// As such, this question is more geared towards MODERN tinmestamps,
-		// where we may expect the date to be known to the day precise...
-		return t.prehistoric.years != get_Invalid(ETPHT_FIELDSIZE_YEARS)
-			&& t.prehistoric.precision == 0
-			&& has_month(t) && has_day(t);
-	}
-}
-
-bool EternalTimestamp::has_time(const eternal_timestamp_t t)
-{
-	// Again, this is another one of those *technical* questions: do we have ALL time fields
-	// so we don't have to fear one or more of them has an invalid value or 'unspecified' marker
-	// that may throw a spanner in the works when we start doing our processing/calculations
-	// on this timestamp?
-	if (is_modern_format(t))
-	{
-		return has_hour(t) && has_minute(t) && has_seconds(t) && has_milliseconds(t) && has_microseconds(t);
-	}
-	else
-	{
-		return has_hour(t) && has_minute(t);
-	}
-}
-
-bool EternalTimestamp::has_hh_mm_ss(const eternal_timestamp_t t)
-{
-	if (is_modern_format(t))
-	{
-		return has_hour(t) && has_minute(t) && has_seconds(t);
-	}
-	else
-	{
-		// We accept that prehistoric timestamps don't come with *seconds*...
-		return has_hour(t) && has_minute(t);
-	}
-}
-
-bool EternalTimestamp::is_modern_format(const eternal_timestamp_t t)
-{
-	return !t.modern.mode;
-}
-
-bool EternalTimestamp::is_prehistoric_format(const eternal_timestamp_t t)
-{
-	return !!t.modern.mode;
-}
-
-
 // NOTE: this performs a FAST time diff calculation, which will satisfy any LT/LE/EQ/GE/GT check on the calculated delta
 // but DOES NOT produce a time-accurate *distance* per se. You should use Proleptic REAL calcualus for that on, or if that
 // doesn't suit your needs, apply different rules to the conversion of these timestamps to produce 'time since' values that you want.
@@ -489,8 +163,10 @@ bool EternalTimestamp::is_prehistoric_format(const eternal_timestamp_t t)
 // Returns equivalent of (t2 - t1)
 int64_t EternalTimestamp::calc_time_fast_delta(const eternal_timestamp_t t1, const eternal_timestamp_t t2)
 {
+	ETS_STATS_ENTRY(CALC_TIME_FAST_DELTA);
+
 	// Notes:
-	// - t.modern.mode is at the same bit location as t.prehistoric.mode
+	// - the mode bit is at the same bit location in both subformats
 	// - we can run a simple integer comparison when both timestamps are of the same 'mode' , i.e. the same subformat.
 	//   + NOT REALLY: modern subformat increases into the future while prehistoric subformat increases into history,
 	//     hence we MUST handle this subtly different for both formats
@@ -503,11 +179,13 @@ int64_t EternalTimestamp::calc_time_fast_delta(const eternal_timestamp_t t1, con
 			int64_t b = static_cast<int64_t>(t2.t);
 			return b - a;
 		} else {
+			ETS_STATS_EVENT(FAST_DELTA_CROSS_MODE);
+
 			// t1 is increasing towards the future; t2 is increasing towards history.
 			//
 			// check if they're somewhat normalized, i.e. whether the prehistoric one is pointing at an earlier century/year than modern t2:
-			int64_t sa = t1.modern.century * 100 + t1.modern.year + MODERN_EPOCH;
-			int64_t sb = t2.prehistoric.years + PREHISTORIC_EPOCH;
+			int64_t sa = ets_modern_century(t1) * 100 + ets_modern_year(t1) + MODERN_EPOCH;
+			int64_t sb = ets_prehistoric_years(t2) + PREHISTORIC_EPOCH;
 			int64_t d = sb - sa;
 			if (d) {
 				return d;
@@ -515,14 +193,15 @@ int64_t EternalTimestamp::calc_time_fast_delta(const eternal_timestamp_t t1, con
 
 			// Whoa! Non-Normalized prehistoric timestamp 't2' as it shares the same year with modern 't1'.
 			// hence we can 'normalize' t2 to a modern timestamp.
+			ETS_STATS_EVENT(FAST_DELTA_NORMALIZED);
 			eternal_timestamp_t tn{0};
-			int y = t2.prehistoric.years - MODERN_EPOCH;
-			tn.modern.century = y / 100;
-			tn.modern.year = y % 100;
-			tn.modern.month = t2.prehistoric.month;
-			tn.modern.day = t2.prehistoric.day;
-			tn.modern.hour = t2.prehistoric.hour;
-			tn.modern.minute = t2.prehistoric.minute;
+			int y = ets_prehistoric_years(t2) - MODERN_EPOCH;
+			tn = ets_modern_set_century(tn, y / 100);
+			tn = ets_modern_set_year(tn, y % 100);
+			tn = ets_modern_set_month(tn, ets_prehistoric_month(t2));
+			tn = ets_modern_set_day(tn, ets_prehistoric_day(t2));
+			tn = ets_modern_set_hour(tn, ets_prehistoric_hour(t2));
+			tn = ets_modern_set_minute(tn, ets_prehistoric_minute(t2));
 
 			int64_t a = static_cast<int64_t>(t1.t);
 			int64_t b = static_cast<int64_t>(tn.t);
@@ -538,11 +217,13 @@ int64_t EternalTimestamp::calc_time_fast_delta(const eternal_timestamp_t t1, con
 			int64_t b = static_cast<int64_t>(t2.t);
 			return a - b;  // to keep the comparison result in line with the modern vs. modern comparison, we MUST reverse the delta here.
 		} else {
+			ETS_STATS_EVENT(FAST_DELTA_CROSS_MODE);
+
 			// t2 is increasing towards the future; t1 is increasing towards history.
 			//
 			// check if they're somewhat normalized, i.e. whether the prehistoric one is pointing at an earlier century/year than modern t2:
-			int64_t sb = t2.modern.century * 100 + t2.modern.year + MODERN_EPOCH;
-			int64_t sa = t1.prehistoric.years + PREHISTORIC_EPOCH;
+			int64_t sb = ets_modern_century(t2) * 100 + ets_modern_year(t2) + MODERN_EPOCH;
+			int64_t sa = ets_prehistoric_years(t1) + PREHISTORIC_EPOCH;
 			int64_t d = sb - sa;
 			if (d) {
 				return d;
@@ -550,14 +231,15 @@ int64_t EternalTimestamp::calc_time_fast_delta(const eternal_timestamp_t t1, con
 
 			// Whoa! Non-Normalized prehistoric timestamp 't1' as it shares the same year with modern 't2'.
 			// hence we can 'normalize' t1 to a modern timestamp.
+			ETS_STATS_EVENT(FAST_DELTA_NORMALIZED);
 			eternal_timestamp_t tn{0};
-			int y = t1.prehistoric.years - MODERN_EPOCH;
-			tn.modern.century = y / 100;
-			tn.modern.year = y % 100;
-			tn.modern.month = t1.prehistoric.month;
-			tn.modern.day = t1.prehistoric.day;
-			tn.modern.hour = t1.prehistoric.hour;
-			tn.modern.minute = t1.prehistoric.minute;
+			int y = ets_prehistoric_years(t1) - MODERN_EPOCH;
+			tn = ets_modern_set_century(tn, y / 100);
+			tn = ets_modern_set_year(tn, y % 100);
+			tn = ets_modern_set_month(tn, ets_prehistoric_month(t1));
+			tn = ets_modern_set_day(tn, ets_prehistoric_day(t1));
+			tn = ets_modern_set_hour(tn, ets_prehistoric_hour(t1));
+			tn = ets_modern_set_minute(tn, ets_prehistoric_minute(t1));
 
 			int64_t a = static_cast<int64_t>(tn.t);
 			int64_t b = static_cast<int64_t>(t2.t);
@@ -567,6 +249,60 @@ int64_t EternalTimestamp::calc_time_fast_delta(const eternal_timestamp_t t1, con
 	}
 }
 
+// Produce a signed 64-bit key which orders all timestamps, both modern and prehistoric, by time.
+//
+// Modern timestamps produce non-negative keys, prehistoric timestamps produce negative keys (older is more negative),
+// except for non-normalized prehistoric timestamps which could have been encoded in the modern subformat: those
+// are normalized first, just like `calc_time_fast_delta()` does, so every moment in time maps onto a single key.
+//
+// Use this one as the expression in a database index or as the ordering criterion in any sort; it is a pure function
+// of the timestamp, hence fit for use in 'deterministic' database functions & indexes.
+int64_t EternalTimestamp::calc_sort_key(const eternal_timestamp_t t)
+{
+	ETS_STATS_ENTRY(CALC_SORT_KEY);
+	eternal_timestamp_t tn = t;
+
+	if (is_prehistoric_format(t)) {
+		const uint64_t years = ets_prehistoric_years(t);
+
+		if (years == get_Invalid(ETPHT_FIELDSIZE_YEARS) || years + PREHISTORIC_EPOCH > MODERN_EPOCH - 100) {
+			uint64_t k = ets_prehistoric_month(t);
+			k = (k << ETPHT_FIELDSIZE_DAY) | ets_prehistoric_day(t);
+			k = (k << ETPHT_FIELDSIZE_HOUR) | ets_prehistoric_hour(t);
+			k = (k << ETPHT_FIELDSIZE_MINUTE) | ets_prehistoric_minute(t);
+			k = (k << ETPHT_FIELDSIZE_PRECISION) | ets_prehistoric_precision(t);
+
+			// the more years ago, the smaller the key:
+			const int shift = ETPHT_FIELDSIZE_MONTH + ETPHT_FIELDSIZE_DAY + ETPHT_FIELDSIZE_HOUR + ETPHT_FIELDSIZE_MINUTE + ETPHT_FIELDSIZE_PRECISION;
+			return static_cast<int64_t>(k) - static_cast<int64_t>((years + 1) << shift);
+		}
+
+		// Non-normalized prehistoric timestamp: it shares its year with the modern subformat range.
+		int y = MODERN_EPOCH - static_cast<int>(years + PREHISTORIC_EPOCH);
+		tn.t = 0;
+		tn = ets_modern_set_century(tn, y / 100);
+		tn = ets_modern_set_year(tn, FIELD_VAL_OFFSET + y % 100);
+		tn = ets_modern_set_month(tn, ets_prehistoric_month(t));
+		tn = ets_modern_set_day(tn, ets_prehistoric_day(t));
+		tn = ets_modern_set_hour(tn, ets_prehistoric_hour(t));
+		tn = ets_modern_set_minute(tn, ets_prehistoric_minute(t));
+		tn = ets_modern_set_seconds(tn, get_Invalid(ETMT_FIELDSIZE_SECONDS));
+		tn = ets_modern_set_milliseconds(tn, get_Invalid(ETMT_FIELDSIZE_MILLISECONDS));
+		tn = ets_modern_set_microseconds(tn, get_Invalid(ETMT_FIELDSIZE_MICROSECONDS));
+	}
+
+	uint64_t k = ets_modern_century(tn);
+	k = (k << ETMT_FIELDSIZE_YEAR) | ets_modern_year(tn);
+	k = (k << ETMT_FIELDSIZE_MONTH) | ets_modern_month(tn);
+	k = (k << ETMT_FIELDSIZE_DAY) | ets_modern_day(tn);
+	k = (k << ETMT_FIELDSIZE_HOUR) | ets_modern_hour(tn);
+	k = (k << ETMT_FIELDSIZE_MINUTE) | ets_modern_minute(tn);
+	k = (k << ETMT_FIELDSIZE_SECONDS) | ets_modern_seconds(tn);
+	k = (k << ETMT_FIELDSIZE_MILLISECONDS) | ets_modern_milliseconds(tn);
+	k = (k << ETMT_FIELDSIZE_MICROSECONDS) | ets_modern_microseconds(tn);
+	return static_cast<int64_t>(k);
+}
+
 // return a improved attempt at producing the number of days between two values as a floating point
 // value.
 //
@@ -580,6 +316,7 @@ int64_t EternalTimestamp::calc_time_fast_delta(const eternal_timestamp_t t1, con
 //   bankers and actuarians when they calculate with 400-day years for (some of) their financial modeling. ;-)
 double EternalTimestamp::calc_time_approx_delta(const eternal_timestamp_t t1, const eternal_timestamp_t t2)
 {
+	ETS_STATS_ENTRY(CALC_TIME_APPROX_DELTA);
 	struct eternal_time_tm d1, d2;
 	cvt_to_timeinfo_struct(d1, t1);
 	cvt_to_timeinfo_struct(d2, t2);
@@ -602,17 +339,17 @@ double EternalTimestamp::calc_time_approx_delta(const eternal_timestamp_t t1, co
 
 int EternalTimestamp::cvt_to_timeinfo_struct(struct eternal_time_tm &dst, const eternal_timestamp_t t)
 {
+	ETS_STATS_ENTRY(CVT_TO_TIMEINFO_STRUCT);
 	if (is_modern_format(t))
 	{
-		auto ts = t.modern;
 		dst.unspecified = 0;
 		int y = 0;
 		if (has_century(t))
-			y = ts.century * 100;
+			y = ets_modern_century(t) * 100;
 		else
 			dst.unspecified |= 1 << ETTS_UNSPECIFIED_EPOCHS;
 		if (has_year(t))
-			y += ts.year - FIELD_VAL_OFFSET;
+			y += ets_modern_year(t) - FIELD_VAL_OFFSET;
 		else
 			dst.unspecified |= 1 << ETTS_UNSPECIFIED_YEARS;
 		ETS_ASSERT(y - MODERN_EPOCH > INT_MIN);
@@ -621,66 +358,66 @@ int EternalTimestamp::cvt_to_timeinfo_struct(struct eternal_time_tm &dst, const
 
 		int v = 0;
 		if (has_month(t))
-			v = ts.month;
+			v = ets_modern_month(t) + 1 - FIELD_VAL_OFFSET;
 		else
 			dst.unspecified |= 1 << ETTS_UNSPECIFIED_MONTHS;
 		dst.month = v;
 
 		v = 0;
 		if (has_day(t))
-			v = ts.day;
+			v = ets_modern_day(t) + 1 - FIELD_VAL_OFFSET;
 		else
 			dst.unspecified |= 1 << ETTS_UNSPECIFIED_DAYS;
 		dst.day = v;
 
 		v = 0;
 		if (has_hour(t))
-			v = ts.hour - FIELD_VAL_OFFSET;
+			v = ets_modern_hour(t) - FIELD_VAL_OFFSET;
 		else
 			dst.unspecified |= 1 << ETTS_UNSPECIFIED_HOURS;
 		dst.hour = v;
 
 		v = 0;
 		if (has_minute(t))
-			v = ts.minute - FIELD_VAL_OFFSET;
+			v = ets_modern_minute(t) - FIELD_VAL_OFFSET;
 		else
 			dst.unspecified |= 1 << ETTS_UNSPECIFIED_MINUTES;
 		dst.minute = v;
 
 		v = 0;
 		if (has_seconds(t))
-			v = ts.seconds;
+			v = ets_modern_seconds(t) - FIELD_VAL_OFFSET;
 		else
 			dst.unspecified |= 1 << ETTS_UNSPECIFIED_SECONDS;
 		dst.seconds = v;
 
 		v = 0;
 		if (has_milliseconds(t))
-			v = ts.milliseconds - FIELD_VAL_OFFSET;
+			v = ets_modern_milliseconds(t) - FIELD_VAL_OFFSET;
 		else
 			dst.unspecified |= 1 << ETTS_UNSPECIFIED_MILLISECONDS;
 		dst.milliseconds = v;
 
 		v = 0;
 		if (has_microseconds(t))
-			v = ts.microseconds;
+			v = ets_modern_microseconds(t) - FIELD_VAL_OFFSET;
 		else
 			dst.unspecified |= 1 << ETTS_UNSPECIFIED_MICROSECONDS;
 		dst.microseconds = v;
 
+		ETS_STATS_EVENT_IF(CVT_UNSPECIFIED_FIELDS, dst.unspecified != 0);
 		return validate(dst);
 	}
 	else
 	{
-		auto ts = t.prehistoric;
 		dst.unspecified = 0;
 		int64_t y = 0;
 		if (has_age(t))
-			y = -1 * ts.years;   // the years aare to be negative to signal they're dates B.C.
+			y = -1 * ets_prehistoric_years(t);   // the years aare to be negative to signal they're dates B.C.
 		else
 			dst.unspecified |= 1 << ETTS_UNSPECIFIED_EPOCHS;
-		int prec = ts.precision;
-		if (ts.precision < 2) {   // we need precision=0 (i.e. 10^0 ==> 1) or precision=1 (i.e. 10^1==>10) as precision indicator or we won't know the year within the century.
+		int prec = ets_prehistoric_precision(t);
+		if (prec >= 2) {   // we need precision=0 (i.e. 10^0 ==> 1) or precision=1 (i.e. 10^1==>10) as precision indicator or we won't know the year within the century.
 			dst.unspecified |= 1 << ETTS_UNSPECIFIED_YEARS;
 		}
 		dst.large_year = y;
@@ -688,28 +425,28 @@ int EternalTimestamp::cvt_to_timeinfo_struct(struct eternal_time_tm &dst, const
 
 		int v = 0;
 		if (has_month(t))
-			v = ts.month;
+			v = ets_prehistoric_month(t) + 1 - FIELD_VAL_OFFSET;
 		else
 			dst.unspecified |= 1 << ETTS_UNSPECIFIED_MONTHS;
 		dst.month = v;
 
 		v = 0;
 		if (has_day(t))
-			v = ts.day;
+			v = ets_prehistoric_day(t) + 1 - FIELD_VAL_OFFSET;
 		else
 			dst.unspecified |= 1 << ETTS_UNSPECIFIED_DAYS;
 		dst.day = v;
 
 		v = 0;
 		if (has_hour(t))
-			v = ts.hour - FIELD_VAL_OFFSET;
+			v = ets_prehistoric_hour(t) - FIELD_VAL_OFFSET;
 		else
 			dst.unspecified |= 1 << ETTS_UNSPECIFIED_HOURS;
 		dst.hour = v;
 
 		v = 0;
 		if (has_minute(t))
-			v = ts.minute - FIELD_VAL_OFFSET;
+			v = ets_prehistoric_minute(t) - FIELD_VAL_OFFSET;
 		else
 			dst.unspecified |= 1 << ETTS_UNSPECIFIED_MINUTES;
 		dst.minute = v;
@@ -723,12 +460,14 @@ int EternalTimestamp::cvt_to_timeinfo_struct(struct eternal_time_tm &dst, const
 		dst.unspecified |= 1 << ETTS_UNSPECIFIED_MICROSECONDS;
 		dst.microseconds = 0;
 
+		ETS_STATS_EVENT_IF(CVT_UNSPECIFIED_FIELDS, dst.unspecified != 0);
 		return validate(dst);
 	}
 }
 
 int EternalTimestamp::cvt_to_time_t(time_t &dst, const eternal_timestamp_t t)
 {
+	ETS_STATS_ENTRY(CVT_TO_TIME_T);
 	return 0;
 }
 
@@ -736,6 +475,7 @@ int EternalTimestamp::cvt_to_time_t(time_t &dst, const eternal_timestamp_t t)
 #if defined(_WIN32) || defined(_WIN64)
 int EternalTimestamp::cvt_to_Win32FileTime(FILETIME &dst, const eternal_timestamp_t t)
 {
+	ETS_STATS_ENTRY(CVT_TO_WIN32FILETIME);
 	return 0;
 }
 
@@ -768,22 +508,27 @@ int EternalTimestamp::cvt_to_Win32FileTime(FILETIME &dst, const eternal_timestam
 // lower significant digits of the mantissa; all of which I consider a boon!
 int EternalTimestamp::cvt_to_etdb_real(double &dst, const eternal_timestamp_t t)
 {
+	ETS_STATS_ENTRY(CVT_TO_ETDB_REAL);
 	return 0;
 }
 
 int EternalTimestamp::cvt_to_proleptic_real(double &dst, const eternal_timestamp_t t)
 {
+	ETS_STATS_ENTRY(CVT_TO_PROLEPTIC_REAL);
 	return 0;
 }
 
 
 int EternalTimestamp::cvt_from_timeinfo_struct(eternal_timestamp_t &dst, const struct eternal_time_tm &ts)
 {
+	ETS_STATS_ENTRY(CVT_FROM_TIMEINFO_STRUCT);
+	ETS_STATS_EVENT_IF(CVT_UNSPECIFIED_FIELDS, ts.unspecified != 0);
+
 	int64_t y = ts.large_year;
 	if (y == 0)
 		y = ts.year;
 
-	bool is_modern = (y <= -MODERN_EPOCH);
+	bool is_modern = (y > -MODERN_EPOCH);
 	bool has_epoch = true;
 	if (ts.unspecified & (1 << ETTS_UNSPECIFIED_EPOCHS)) {
 		is_modern = true;
@@ -791,75 +536,75 @@ int EternalTimestamp::cvt_from_timeinfo_struct(eternal_timestamp_t &dst, const s
 	}
 
 	if (is_modern) {
-		eternal_modern_timestamp t{0};
+		eternal_timestamp_t t{0};
 
 		y += MODERN_EPOCH;
 		ETS_ASSERT(y > 0);
 
 		if (!has_epoch) {
-			t.century = get_Invalid(ETMT_FIELDSIZE_CENTURY);
+			t = ets_modern_set_century(t, get_Invalid(ETMT_FIELDSIZE_CENTURY));
 		}
 		else {
-			t.century = y / 100;
+			t = ets_modern_set_century(t, y / 100);
 		}
 		y %= 100;
 
 		if (ts.unspecified & (1 << ETTS_UNSPECIFIED_YEARS)) {
-			t.year = get_Invalid(ETMT_FIELDSIZE_YEAR);
+			t = ets_modern_set_year(t, get_Invalid(ETMT_FIELDSIZE_YEAR));
 		}
 		else {
-			t.year = FIELD_VAL_OFFSET + y;
+			t = ets_modern_set_year(t, FIELD_VAL_OFFSET + y);
 		}
 
 		if (ts.unspecified & (1 << ETTS_UNSPECIFIED_MONTHS)) {
-			t.month = get_Invalid(ETMT_FIELDSIZE_MONTH);
+			t = ets_modern_set_month(t, get_Invalid(ETMT_FIELDSIZE_MONTH));
 		} else {
-			t.month = FIELD_VAL_OFFSET - 1 + ts.month;
+			t = ets_modern_set_month(t, FIELD_VAL_OFFSET - 1 + ts.month);
 		}
 
 		if (ts.unspecified & (1 << ETTS_UNSPECIFIED_DAYS)) {
-			t.day = get_Invalid(ETMT_FIELDSIZE_DAY);
+			t = ets_modern_set_day(t, get_Invalid(ETMT_FIELDSIZE_DAY));
 		} else {
-			t.day = FIELD_VAL_OFFSET - 1 + ts.day;
+			t = ets_modern_set_day(t, FIELD_VAL_OFFSET - 1 + ts.day);
 		}
 
 		if (ts.unspecified & (1 << ETTS_UNSPECIFIED_HOURS)) {
-			t.hour = get_Invalid(ETMT_FIELDSIZE_HOUR);
+			t = ets_modern_set_hour(t, get_Invalid(ETMT_FIELDSIZE_HOUR));
 		} else {
-			t.hour = FIELD_VAL_OFFSET + ts.hour;
+			t = ets_modern_set_hour(t, FIELD_VAL_OFFSET + ts.hour);
 		}
 
 		if (ts.unspecified & (1 << ETTS_UNSPECIFIED_MINUTES)) {
-			t.minute = get_Invalid(ETMT_FIELDSIZE_MINUTE);
+			t = ets_modern_set_minute(t, get_Invalid(ETMT_FIELDSIZE_MINUTE));
 		} else {
-			t.minute = FIELD_VAL_OFFSET + ts.minute;
+			t = ets_modern_set_minute(t, FIELD_VAL_OFFSET + ts.minute);
 		}
 
 		if (ts.unspecified & (1 << ETTS_UNSPECIFIED_SECONDS)) {
-			t.seconds = get_Invalid(ETMT_FIELDSIZE_SECONDS);
+			t = ets_modern_set_seconds(t, get_Invalid(ETMT_FIELDSIZE_SECONDS));
 		} else {
-			t.seconds = FIELD_VAL_OFFSET + ts.seconds;
+			t = ets_modern_set_seconds(t, FIELD_VAL_OFFSET + ts.seconds);
 		}
 
 		if (ts.unspecified & (1 << ETTS_UNSPECIFIED_MILLISECONDS)) {
-			t.milliseconds = get_Invalid(ETMT_FIELDSIZE_MILLISECONDS);
+			t = ets_modern_set_milliseconds(t, get_Invalid(ETMT_FIELDSIZE_MILLISECONDS));
 		} else {
-			t.milliseconds = FIELD_VAL_OFFSET + ts.milliseconds;
+			t = ets_modern_set_milliseconds(t, FIELD_VAL_OFFSET + ts.milliseconds);
 		}
 
 		if (ts.unspecified & (1 << ETTS_UNSPECIFIED_MICROSECONDS)) {
-			t.microseconds = get_Invalid(ETMT_FIELDSIZE_MICROSECONDS);
+			t = ets_modern_set_microseconds(t, get_Invalid(ETMT_FIELDSIZE_MICROSECONDS));
 		} else {
-			t.microseconds = FIELD_VAL_OFFSET + ts.microseconds;
+			t = ets_modern_set_microseconds(t, FIELD_VAL_OFFSET + ts.microseconds);
 		}
 
 		// t value is now a positive offset value from 10000 BC.
-		dst.modern = t;
+		dst = t;
 		return 0;
 	} else {
-		eternal_prehistoric_timestamp t{0};
+		eternal_timestamp_t t{0};
 
-		t.mode = 1;
+		t = ets_format_set_mode(t, 1);
 
 		y = PREHISTORIC_EPOCH - y;
 		ETS_ASSERT(y > 0);
@@ -867,44 +612,46 @@ int EternalTimestamp::cvt_from_timeinfo_struct(eternal_timestamp_t &dst, const s
 		ETS_ASSERT(has_epoch);
 
 		if (ts.unspecified & (1 << ETTS_UNSPECIFIED_YEARS)) {
-			t.precision = 2;
+			t = ets_prehistoric_set_precision(t, 2);
 		} else {
-			t.precision = 0;
+			t = ets_prehistoric_set_precision(t, 0);
 		}
-		t.years = y;
+		t = ets_prehistoric_set_years(t, y);
 
 		if (ts.unspecified & (1 << ETTS_UNSPECIFIED_MONTHS)) {
-			t.month = get_Invalid(ETMT_FIELDSIZE_MONTH);
+			t = ets_prehistoric_set_month(t, get_Invalid(ETMT_FIELDSIZE_MONTH));
 		} else {
-			t.month = FIELD_VAL_OFFSET - 1 + ts.month;
+			t = ets_prehistoric_set_month(t, FIELD_VAL_OFFSET - 1 + ts.month);
 		}
 
 		if (ts.unspecified & (1 << ETTS_UNSPECIFIED_DAYS)) {
-			t.day = get_Invalid(ETMT_FIELDSIZE_DAY);
+			t = ets_prehistoric_set_day(t, get_Invalid(ETMT_FIELDSIZE_DAY));
 		} else {
-			t.day = FIELD_VAL_OFFSET - 1 + ts.day;
+			t = ets_prehistoric_set_day(t, FIELD_VAL_OFFSET - 1 + ts.day);
 		}
 
 		if (ts.unspecified & (1 << ETTS_UNSPECIFIED_HOURS)) {
-			t.hour = get_Invalid(ETMT_FIELDSIZE_HOUR);
+			t = ets_prehistoric_set_hour(t, get_Invalid(ETMT_FIELDSIZE_HOUR));
 		} else {
-			t.hour = FIELD_VAL_OFFSET + ts.hour;
+			t = ets_prehistoric_set_hour(t, FIELD_VAL_OFFSET + ts.hour);
 		}
 
 		if (ts.unspecified & (1 << ETTS_UNSPECIFIED_MINUTES)) {
-			t.minute = get_Invalid(ETMT_FIELDSIZE_MINUTE);
+			t = ets_prehistoric_set_minute(t, get_Invalid(ETMT_FIELDSIZE_MINUTE));
 		} else {
-			t.minute = FIELD_VAL_OFFSET + ts.minute;
+			t = ets_prehistoric_set_minute(t, FIELD_VAL_OFFSET + ts.minute);
 		}
 
 		// t value is now a positive offset value from 0 AD back into history.
-		dst.prehistoric = t;
+		dst = t;
 		return 0;
 	}
 }
 
 int EternalTimestamp::cvt_from_time_t(eternal_timestamp_t &dst, const time_t t)
 {
+	ETS_STATS_ENTRY(CVT_FROM_TIME_T);
+
 	// as per https://stackoverflow.com/questions/68548288/convert-utc-time-t-to-utc-tm
 	using namespace std::chrono;
 
@@ -929,6 +676,7 @@ int EternalTimestamp::cvt_from_time_t(eternal_timestamp_t &dst, const time_t t)
 
 int EternalTimestamp::cvt_from_tm(eternal_timestamp_t &dst, const struct tm &t)
 {
+	ETS_STATS_ENTRY(CVT_FROM_TM);
 	struct eternal_time_tm ts{0};
 
 	ts.large_year = ts.year = t.tm_year + 1900;
@@ -944,8 +692,8 @@ int EternalTimestamp::cvt_from_tm(eternal_timestamp_t &dst, const struct tm &t)
 #if defined(_WIN32) || defined(_WIN64)
 int EternalTimestamp::cvt_from_Win32FileTime(eternal_timestamp_t &dst, const FILETIME &ft)
 {
+	ETS_STATS_ENTRY(CVT_FROM_WIN32FILETIME);
 	SYSTEMTIME st;
-	eternal_modern_timestamp t{0};
 
 	uint64_t tt = ft.dwHighDateTime;
 	tt <<= 32;
@@ -961,26 +709,14 @@ int EternalTimestamp::cvt_from_Win32FileTime(eternal_timestamp_t &dst, const FIL
 	ETS_ASSERT(us < 1000);
 	ETS_ASSERT(ms >= 0);
 	ETS_ASSERT(ms < 1000);
-	t.microseconds = FIELD_VAL_OFFSET + us;
-	t.milliseconds = FIELD_VAL_OFFSET + ms;
 
-	if (FileTimeToSystemTime(&ft, &st)) {
-		int y = st.wYear;
-		y += MODERN_EPOCH;
-		t.century = y / 100;
-		t.year = FIELD_VAL_OFFSET + y % 100;
-		t.month = FIELD_VAL_OFFSET - 1 + st.wMonth;
-		t.day = FIELD_VAL_OFFSET - 1 + st.wDay;
-		t.hour = FIELD_VAL_OFFSET + st.wHour;
-		t.minute = FIELD_VAL_OFFSET + st.wMinute;
-		t.seconds = FIELD_VAL_OFFSET + st.wSecond;
-		t.milliseconds = FIELD_VAL_OFFSET + st.wMilliseconds;
-	} else {
+	if (!FileTimeToSystemTime(&ft, &st)) {
 		ETS_ASSERT(!"Should not get here!");
+		return -1;
 	}
 
-	// t value is now a positive offset value from 10000 BC.
-	dst.modern = t;
+	// t value is a positive offset value from 10000 BC.
+	dst = ets_encode_modern(st.wYear, st.wMonth, st.wDay, st.wHour, st.wMinute, st.wSecond, st.wMilliseconds, us);
 
 	return 0;
 }
@@ -991,27 +727,91 @@ int EternalTimestamp::cvt_from_Win32FileTime(eternal_timestamp_t &dst, const FIL
 // you perform calculations with/on these.
 int EternalTimestamp::cvt_from_etdb_real(eternal_timestamp_t &dst, const double t)
 {
+	ETS_STATS_ENTRY(CVT_FROM_ETDB_REAL);
 	return 0;
 }
 
 int EternalTimestamp::cvt_from_proleptic_real(eternal_timestamp_t &dst, const double t)
 {
+	ETS_STATS_ENTRY(CVT_FROM_PROLEPTIC_REAL);
 	return 0;
 }
 
 
 bool EternalTimestamp::ntoh_is_an_empty_op(const eternal_timestamp_t t)
 {
-	return true;
+	(void)t;
+	return ETS_BYTE_ORDER_NATIVE == ETS_BYTE_ORDER_LITTLE;
 }
 
 // convert timestamp as loaded from external storage or network message to native layout.
 eternal_timestamp_t EternalTimestamp::ntoh(const eternal_timestamp_t t)
 {
-	return t;
+	return ets_load_timestamp(&t.t, ETS_BYTE_ORDER_LITTLE);
 }
 // convert timestamp in native layout to a layout suitable for external storage or network message travelling abroad.
 eternal_timestamp_t EternalTimestamp::hton(const eternal_timestamp_t t)
 {
-	return t;
+	eternal_timestamp_t dst;
+	ets_store_timestamp(&dst.t, t, ETS_BYTE_ORDER_LITTLE);
+	return dst;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// C interface
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+extern "C" int64_t ets_calc_sort_key(const eternal_timestamp_t t)
+{
+	return EternalTimestamp::calc_sort_key(t);
+}
+
+extern "C" BOOL ets_ntoh_is_an_empty_op(const eternal_timestamp_t t)
+{
+	return EternalTimestamp::ntoh_is_an_empty_op(t);
+}
+
+extern "C" eternal_timestamp_t ets_ntoh(const eternal_timestamp_t t)
+{
+	return EternalTimestamp::ntoh(t);
+}
+
+extern "C" eternal_timestamp_t ets_hton(const eternal_timestamp_t t)
+{
+	return EternalTimestamp::hton(t);
+}
+
+#if !defined(ETS_HEADER_ONLY)
+
+extern "C" eternal_timestamp_t ets_unknown()
+{
+	return ets_inline_unknown();
 }
+
+#define ETS_DEFINE_ACCESSOR(name) \
+	extern "C" BOOL ets_##name(const eternal_timestamp_t t) \
+	{ \
+		return ets_inline_##name(t); \
+	}
+
+ETS_DEFINE_ACCESSOR(has_century)
+ETS_DEFINE_ACCESSOR(has_year)
+ETS_DEFINE_ACCESSOR(has_century_and_year)
+ETS_DEFINE_ACCESSOR(has_age)
+ETS_DEFINE_ACCESSOR(has_month)
+ETS_DEFINE_ACCESSOR(has_day)
+ETS_DEFINE_ACCESSOR(has_hour)
+ETS_DEFINE_ACCESSOR(has_minute)
+ETS_DEFINE_ACCESSOR(has_seconds)
+ETS_DEFINE_ACCESSOR(has_milliseconds)
+ETS_DEFINE_ACCESSOR(has_microseconds)
+ETS_DEFINE_ACCESSOR(has_complete_date)
+ETS_DEFINE_ACCESSOR(has_time)
+ETS_DEFINE_ACCESSOR(has_hh_mm_ss)
+ETS_DEFINE_ACCESSOR(is_modern_format)
+ETS_DEFINE_ACCESSOR(is_prehistoric_format)
+
+#undef ETS_DEFINE_ACCESSOR
+
+#endif
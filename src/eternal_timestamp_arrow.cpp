@@ -0,0 +1,386 @@
+
+#include "eternal_timestamp/eternal_timestamp_arrow.h"
+#include "eternal_timestamp/eternal_timestamp_batch.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "eternal_timestamp_instrumentation.h"
+#include "eternal_timestamp_internal.h"
+
+
+using namespace eternal_timestamp;
+
+
+namespace
+{
+	// scratch chunk size for the conversions which need an intermediate buffer.
+	constexpr size_t CHUNK_SIZE = 1024;
+
+	struct array_private
+	{
+		const void *buffers[2];
+		void *owned[2];                     // buffers we allocated ourselves: freed on release
+		void (*release_owner)(void *owner); // zero-copy export: notify the producer
+		void *owner;
+	};
+
+	struct schema_private
+	{
+		char metadata[128];
+	};
+
+	void release_array(struct ArrowArray *array)
+	{
+		array_private *priv = static_cast<array_private *>(array->private_data);
+		if (priv) {
+			free(priv->owned[0]);
+			free(priv->owned[1]);
+			if (priv->release_owner)
+				priv->release_owner(priv->owner);
+			free(priv);
+		}
+		array->private_data = nullptr;
+		array->release = nullptr;
+	}
+
+	void release_schema(struct ArrowSchema *schema)
+	{
+		free(schema->private_data);
+		schema->private_data = nullptr;
+		schema->release = nullptr;
+	}
+
+	// Arrow schema metadata: int32 pair count, then per pair: int32 key length, key bytes, int32 value length, value bytes.
+	size_t append_metadata_string(char *dst, const char *s)
+	{
+		const int32_t len = static_cast<int32_t>(strlen(s));
+		memcpy(dst, &len, sizeof(len));
+		memcpy(dst + sizeof(len), s, len);
+		return sizeof(len) + len;
+	}
+
+	int init_schema(struct ArrowSchema &schema, const char *format, bool extension)
+	{
+		memset(&schema, 0, sizeof(schema));
+		schema.format = format;
+		schema.flags = ARROW_FLAG_NULLABLE;
+		schema.release = release_schema;
+
+		if (extension) {
+			schema_private *priv = static_cast<schema_private *>(calloc(1, sizeof(schema_private)));
+			if (!priv)
+				return ENOMEM;
+			char *p = priv->metadata;
+			const int32_t pairs = 2;
+			memcpy(p, &pairs, sizeof(pairs));
+			p += sizeof(pairs);
+			p += append_metadata_string(p, "ARROW:extension:name");
+			p += append_metadata_string(p, ETS_ARROW_EXTENSION_NAME);
+			p += append_metadata_string(p, "ARROW:extension:metadata");
+			p += append_metadata_string(p, "");
+			ETS_ASSERT(p <= priv->metadata + sizeof(priv->metadata));
+			schema.metadata = priv->metadata;
+			schema.private_data = priv;
+		}
+		return 0;
+	}
+
+	int init_array(struct ArrowArray &array, array_private *&priv, int64_t length)
+	{
+		memset(&array, 0, sizeof(array));
+		priv = static_cast<array_private *>(calloc(1, sizeof(array_private)));
+		if (!priv)
+			return ENOMEM;
+		array.length = length;
+		array.n_buffers = 2;
+		array.buffers = priv->buffers;
+		array.release = release_array;
+		array.private_data = priv;
+		return 0;
+	}
+
+	// Return the value stored for `key` in the Arrow schema metadata, or NULL when the key is absent.
+	const char *find_metadata(const char *metadata, const char *key, int32_t &value_len)
+	{
+		if (!metadata)
+			return nullptr;
+		const size_t key_len = strlen(key);
+		int32_t pairs;
+		memcpy(&pairs, metadata, sizeof(pairs));
+		const char *p = metadata + sizeof(pairs);
+		for (int32_t i = 0; i < pairs; i++) {
+			int32_t klen, vlen;
+			memcpy(&klen, p, sizeof(klen));
+			p += sizeof(klen);
+			const char *k = p;
+			p += klen;
+			memcpy(&vlen, p, sizeof(vlen));
+			p += sizeof(vlen);
+			if (static_cast<size_t>(klen) == key_len && !memcmp(k, key, key_len)) {
+				value_len = vlen;
+				return p;
+			}
+			p += vlen;
+		}
+		return nullptr;
+	}
+
+	bool is_eternal_timestamp_schema(const struct ArrowSchema &schema)
+	{
+		if (strcmp(schema.format, "l"))
+			return false;
+		int32_t len = 0;
+		const char *name = find_metadata(schema.metadata, "ARROW:extension:name", len);
+		// a plain `int64` column is accepted as well: that's what consumers produce who don't know our extension type.
+		if (!name)
+			return true;
+		return static_cast<size_t>(len) == strlen(ETS_ARROW_EXTENSION_NAME) && !memcmp(name, ETS_ARROW_EXTENSION_NAME, len);
+	}
+
+	inline bool bit_is_set(const uint8_t *bitmap, int64_t i)
+	{
+		return (bitmap[i / 8] >> (i % 8)) & 1;
+	}
+
+	// replace every null entry by the 'all fields unspecified' timestamp.
+	void apply_nulls(eternal_timestamp_t *dst, const struct ArrowArray &array, unsigned int parallelism)
+	{
+		const uint8_t *validity = static_cast<const uint8_t *>(array.buffers[0]);
+		if (!validity || array.null_count == 0)
+			return;
+		const eternal_timestamp_t unknown = ets_make_unknown();
+		const int64_t offset = array.offset;
+		EternalTimestampParallel::parallel_for(static_cast<size_t>(array.length), ETS_PARALLEL_GRAIN, parallelism, [=](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++) {
+				if (!bit_is_set(validity, offset + static_cast<int64_t>(i)))
+					dst[i] = unknown;
+			}
+		});
+	}
+
+	int64_t count_nulls(const uint8_t *validity, int64_t length)
+	{
+		int64_t nulls = 0;
+		for (int64_t i = 0; i < length; i++) {
+			nulls += !bit_is_set(validity, i);
+		}
+		return nulls;
+	}
+}
+
+
+int EternalTimestampArrow::export_array(struct ArrowSchema &schema, struct ArrowArray &array, const eternal_timestamp_t *values, const uint8_t *validity, int64_t length, void (*release_owner)(void *owner), void *owner)
+{
+	ETS_STATS_ENTRY(ARROW_EXPORT_ARRAY);
+	if (length < 0 || (!values && length > 0))
+		return EINVAL;
+
+	int rv = init_schema(schema, "l", true);
+	if (rv)
+		return rv;
+
+	array_private *priv;
+	rv = init_array(array, priv, length);
+	if (rv) {
+		schema.release(&schema);
+		return rv;
+	}
+	priv->buffers[0] = validity;
+	priv->buffers[1] = values;
+	priv->release_owner = release_owner;
+	priv->owner = owner;
+	array.null_count = (validity ? count_nulls(validity, length) : 0);
+	return 0;
+}
+
+int EternalTimestampArrow::import_array(const eternal_timestamp_t *&values, const uint8_t *&validity, int64_t &validity_offset, int64_t &length, const struct ArrowSchema &schema, const struct ArrowArray &array)
+{
+	ETS_STATS_ENTRY(ARROW_IMPORT_ARRAY);
+	if (!array.release || !schema.release || array.n_buffers != 2 || !is_eternal_timestamp_schema(schema))
+		return EINVAL;
+
+	values = static_cast<const eternal_timestamp_t *>(array.buffers[1]) + array.offset;
+	validity = (array.null_count != 0 ? static_cast<const uint8_t *>(array.buffers[0]) : nullptr);
+	validity_offset = array.offset;
+	length = array.length;
+	return 0;
+}
+
+int EternalTimestampArrow::cvt_from_array(eternal_timestamp_t *dst, const struct ArrowSchema &schema, const struct ArrowArray &array, unsigned int parallelism)
+{
+	ETS_STATS_ENTRY(ARROW_CVT_FROM_ARRAY);
+	if (!array.release || !schema.release || array.n_buffers != 2 || array.length < 0)
+		return EINVAL;
+
+	const char *format = schema.format;
+	const size_t count = static_cast<size_t>(array.length);
+
+	if (!strncmp(format, "ts", 2) && format[2] && format[3] == ':') {
+		const int64_t *src = static_cast<const int64_t *>(array.buffers[1]) + array.offset;
+		switch (format[2]) {
+		case 's':
+			EternalTimestampBatch::cvt_from_unix_seconds(dst, nullptr, src, count, parallelism);
+			break;
+		case 'm':
+			EternalTimestampBatch::cvt_from_unix_msecs(dst, nullptr, src, count, parallelism);
+			break;
+		case 'u':
+			EternalTimestampBatch::cvt_from_unix_usecs(dst, nullptr, src, count, parallelism);
+			break;
+		case 'n':
+			// we don't do nanoseconds: truncate to whole microseconds (rounding down, also for negative values)
+			EternalTimestampParallel::parallel_for(count, ETS_PARALLEL_GRAIN, parallelism, [=](size_t begin, size_t end) {
+				for (size_t i = begin; i < end; i += CHUNK_SIZE) {
+					int64_t usecs[CHUNK_SIZE];
+					const size_t n = (end - i < CHUNK_SIZE ? end - i : CHUNK_SIZE);
+					for (size_t j = 0; j < n; j++) {
+						const int64_t ns = src[i + j];
+						usecs[j] = ns / 1000 - (ns % 1000 < 0);
+					}
+					EternalTimestampBatch::cvt_from_unix_usecs(dst + i, nullptr, usecs, n, 1);
+				}
+			});
+			break;
+		default:
+			return EINVAL;
+		}
+	}
+	else if (!strcmp(format, ETS_ARROW_FORMAT_DATE32)) {
+		const int32_t *src = static_cast<const int32_t *>(array.buffers[1]) + array.offset;
+		EternalTimestampBatch::cvt_from_unix_days(dst, nullptr, src, count, parallelism);
+	}
+	else if (!strcmp(format, ETS_ARROW_FORMAT_DATE64)) {
+		// `date64` is milliseconds since the UNIX epoch, which SHOULD be whole days: produce date-only timestamps.
+		const int64_t *src = static_cast<const int64_t *>(array.buffers[1]) + array.offset;
+		const int64_t msecs_per_day = USECS_PER_DAY / 1000;
+		EternalTimestampParallel::parallel_for(count, ETS_PARALLEL_GRAIN, parallelism, [=](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i += CHUNK_SIZE) {
+				int32_t days[CHUNK_SIZE];
+				const size_t n = (end - i < CHUNK_SIZE ? end - i : CHUNK_SIZE);
+				for (size_t j = 0; j < n; j++) {
+					const int64_t ms = src[i + j];
+					const int64_t d = ms / msecs_per_day - (ms % msecs_per_day < 0);
+					// INT32_MIN lies far beyond the modern range, hence is rejected like any other out-of-range day.
+					days[j] = (d >= INT32_MIN && d <= INT32_MAX ? static_cast<int32_t>(d) : INT32_MIN);
+				}
+				EternalTimestampBatch::cvt_from_unix_days(dst + i, nullptr, days, n, 1);
+			}
+		});
+	}
+	else if (is_eternal_timestamp_schema(schema)) {
+		const eternal_timestamp_t *src = static_cast<const eternal_timestamp_t *>(array.buffers[1]) + array.offset;
+		EternalTimestampParallel::parallel_for(count, ETS_PARALLEL_GRAIN, parallelism, [=](size_t begin, size_t end) {
+			memcpy(dst + begin, src + begin, (end - begin) * sizeof(dst[0]));
+		});
+	}
+	else {
+		return EINVAL;
+	}
+
+	apply_nulls(dst, array, parallelism);
+	return 0;
+}
+
+int EternalTimestampArrow::cvt_to_array(struct ArrowSchema &schema, struct ArrowArray &array, const char *format, const eternal_timestamp_t *src, int64_t length, unsigned int parallelism)
+{
+	ETS_STATS_ENTRY(ARROW_CVT_TO_ARRAY);
+	if (!format || length < 0 || (!src && length > 0))
+		return EINVAL;
+
+	const bool is_ts = !strcmp(format, ETS_ARROW_FORMAT_TIMESTAMP_US_UTC);
+	const bool is_date32 = !strcmp(format, ETS_ARROW_FORMAT_DATE32);
+	const bool is_date64 = !strcmp(format, ETS_ARROW_FORMAT_DATE64);
+	if (!is_ts && !is_date32 && !is_date64)
+		return EINVAL;
+
+	// keep the format string alive for as long as the schema: use our own string constants.
+	const char *fmt = (is_ts ? ETS_ARROW_FORMAT_TIMESTAMP_US_UTC : is_date32 ? ETS_ARROW_FORMAT_DATE32 : ETS_ARROW_FORMAT_DATE64);
+	int rv = init_schema(schema, fmt, false);
+	if (rv)
+		return rv;
+
+	array_private *priv;
+	rv = init_array(array, priv, length);
+	if (rv) {
+		schema.release(&schema);
+		return rv;
+	}
+
+	const size_t count = static_cast<size_t>(length);
+	const size_t bitmap_size = (count + 7) / 8;
+	const size_t value_size = (is_date32 ? sizeof(int32_t) : sizeof(int64_t));
+	// pad the allocations so that empty arrays get valid (non-NULL) buffers as well.
+	priv->owned[0] = calloc(bitmap_size + 64, 1);
+	priv->owned[1] = malloc(count * value_size + 64);
+	if (!priv->owned[0] || !priv->owned[1]) {
+		array.release(&array);
+		schema.release(&schema);
+		return ENOMEM;
+	}
+	uint8_t *validity = static_cast<uint8_t *>(priv->owned[0]);
+
+	size_t nulls;
+	if (is_ts) {
+		nulls = EternalTimestampBatch::cvt_to_unix_usecs(static_cast<int64_t *>(priv->owned[1]), validity, src, count, parallelism);
+	}
+	else if (is_date32) {
+		nulls = EternalTimestampBatch::cvt_to_unix_days(static_cast<int32_t *>(priv->owned[1]), validity, src, count, parallelism);
+	}
+	else {
+		int64_t *dst = static_cast<int64_t *>(priv->owned[1]);
+		const int64_t msecs_per_day = USECS_PER_DAY / 1000;
+		nulls = ets_parallel_sum(count, parallelism, [=](size_t begin, size_t end) {
+			size_t failures = 0;
+			for (size_t i = begin; i < end; i += CHUNK_SIZE) {
+				int32_t days[CHUNK_SIZE];
+				const size_t n = (end - i < CHUNK_SIZE ? end - i : CHUNK_SIZE);
+				// the chunk starts at a multiple of 8, so we can pass the validity bitmap at the matching byte offset.
+				failures += EternalTimestampBatch::cvt_to_unix_days(days, validity + i / 8, src + i, n, 1);
+				for (size_t j = 0; j < n; j++) {
+					dst[i + j] = days[j] * msecs_per_day;
+				}
+			}
+			return failures;
+		});
+	}
+
+	priv->buffers[0] = (nulls ? validity : nullptr);
+	priv->buffers[1] = priv->owned[1];
+	array.null_count = static_cast<int64_t>(nulls);
+	return 0;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// C interface
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+extern "C" int ets_arrow_export_array(struct ArrowSchema *schema, struct ArrowArray *array, const eternal_timestamp_t *values, const uint8_t *validity, int64_t length, void (*release_owner)(void *owner), void *owner)
+{
+	if (!schema || !array)
+		return EINVAL;
+	return EternalTimestampArrow::export_array(*schema, *array, values, validity, length, release_owner, owner);
+}
+
+extern "C" int ets_arrow_import_array(const eternal_timestamp_t **values, const uint8_t **validity, int64_t *validity_offset, int64_t *length, const struct ArrowSchema *schema, const struct ArrowArray *array)
+{
+	if (!values || !validity || !validity_offset || !length || !schema || !array)
+		return EINVAL;
+	return EternalTimestampArrow::import_array(*values, *validity, *validity_offset, *length, *schema, *array);
+}
+
+extern "C" int ets_arrow_cvt_from_array(eternal_timestamp_t *dst, const struct ArrowSchema *schema, const struct ArrowArray *array)
+{
+	if (!schema || !array)
+		return EINVAL;
+	return EternalTimestampArrow::cvt_from_array(dst, *schema, *array);
+}
+
+extern "C" int ets_arrow_cvt_to_array(struct ArrowSchema *schema, struct ArrowArray *array, const char *format, const eternal_timestamp_t *src, int64_t length)
+{
+	if (!schema || !array)
+		return EINVAL;
+	return EternalTimestampArrow::cvt_to_array(*schema, *array, format, src, length);
+}
@@ -0,0 +1,598 @@
+
+#include "eternal_timestamp/eternal_timestamp_batch.h"
+
+#include "eternal_timestamp_instrumentation.h"
+#include "eternal_timestamp_internal.h"
+
+
+using namespace eternal_timestamp;
+
+
+namespace
+{
+	// The kernels below work on timestamps in any `EternalTimestampLayout` `L`: the library's own
+	// `eternal_timestamp_t` values or the plain 64-bit values of `EternalTimestampLayoutBatch`.
+	inline uint64_t raw(const eternal_timestamp_t t)
+	{
+		return t.t;
+	}
+
+	inline uint64_t raw(const uint64_t t)
+	{
+		return t;
+	}
+
+	inline void store(eternal_timestamp_t &dst, const uint64_t t)
+	{
+		dst.t = t;
+	}
+
+	inline void store(uint64_t &dst, const uint64_t t)
+	{
+		dst = t;
+	}
+
+	// Caches the calendar calculus for the last day seen: columns are usually sorted or clustered in time,
+	// so most rows hit the cache and skip the civil-from-days/days-from-civil arithmetic entirely.
+	template <class L>
+	struct day_cache
+	{
+		int64_t days = INT64_MIN;
+		uint64_t date = 0;          // the encoded date for `days`; time-of-day fields 'unspecified'
+
+		uint64_t lookup(int64_t d)
+		{
+			if (d != days) {
+				int64_t y;
+				unsigned int m, dd;
+				ets_civil_from_days(d, y, m, dd);
+				date = ets_layout_encode_modern_date<L>(static_cast<int>(y), m, dd);
+				days = d;
+			}
+			return date;
+		}
+	};
+
+	template <class L>
+	struct date_cache
+	{
+		typedef typename L::modern M;
+
+		uint64_t key = UINT64_MAX;
+		int64_t days = 0;
+
+		// `t` MUST be a modern timestamp with a complete date.
+		int64_t lookup(const uint64_t t)
+		{
+			const uint64_t k = t & (M::century::mask | M::year::mask | M::month::mask | M::day::mask);
+			if (k != key) {
+				days = ets_days_from_civil(ets_layout_modern_year<L>(t), ets_layout_value<L, typename M::month>(t) + 1, ets_layout_value<L, typename M::day>(t) + 1);
+				key = k;
+			}
+			return days;
+		}
+	};
+
+	// Caches the rendered date prefix ("2022-01-13") for the last date seen: like `date_cache` above, keyed on the
+	// raw century/year/month/day bits, so runs of values on the same day only render their time of day.
+	template <class L>
+	struct rfc3339_prefix_cache
+	{
+		typedef typename L::modern M;
+
+		// the bits which make up the date: everything but the time of day, so the mode and any stray bits
+		// are part of the key as well.
+		static constexpr uint64_t date_mask = ~(M::hour::mask | M::minute::mask | M::seconds::mask | M::milliseconds::mask | M::microseconds::mask);
+
+		uint64_t key = UINT64_MAX;
+		char text[16];
+		uint8_t length = 0;
+		bool valid = false;         // the timestamp carries a year
+		bool complete = false;      // ... and a month and a day: the time of day may follow
+
+		void lookup(const uint64_t t)
+		{
+			const uint64_t k = t & date_mask;
+			if (k == key)
+				return;
+			key = k;
+
+			valid = L::is_modern_format(t) && !L::template is_unspecified<typename M::century>(t) && !L::template is_unspecified<typename M::year>(t);
+			complete = false;
+			length = 0;
+			if (!valid)
+				return;
+
+			int64_t y = ets_layout_modern_year<L>(t);
+			char *p = text;
+			if (y < 0) {
+				*p++ = '-';
+				y = -y;
+			}
+			else if (y > 9999) {
+				*p++ = '+';
+			}
+			if (y > 9999) {
+				*p++ = static_cast<char>('0' + y / 10000);
+				y %= 10000;
+			}
+			p = ets_put2(p, static_cast<unsigned int>(y / 100));
+			p = ets_put2(p, static_cast<unsigned int>(y % 100));
+			if (!L::template is_unspecified<typename M::month>(t)) {
+				*p++ = '-';
+				p = ets_put2(p, ets_layout_value<L, typename M::month>(t) + 1);
+				if (!L::template is_unspecified<typename M::day>(t)) {
+					*p++ = '-';
+					p = ets_put2(p, ets_layout_value<L, typename M::day>(t) + 1);
+					complete = true;
+				}
+			}
+			length = static_cast<uint8_t>(p - text);
+		}
+	};
+
+	static_assert(sizeof(rfc3339_prefix_cache<ets_native_layout>::text) <= ETS_BATCH_RFC3339_MAX_LENGTH, "the prefix copy must not overrun the value");
+	static_assert(ets_layout_max_year<EternalTimestampExtendedLayout>() < 100000, "the prefix renders years of up to five digits");
+
+	// Render the timestamp; `p` must have room for `ETS_BATCH_RFC3339_MAX_LENGTH` characters.
+	template <class L>
+	inline char *render_rfc3339(char *p, rfc3339_prefix_cache<L> &cache, const uint64_t t)
+	{
+		typedef typename L::modern M;
+
+		cache.lookup(t);
+		// copying the entire (fixed size) prefix buffer is cheaper than a variable length copy; the surplus is
+		// either overwritten by the time of day or lies beyond the end of the value, but within `ETS_BATCH_RFC3339_MAX_LENGTH`.
+		memcpy(p, cache.text, sizeof(cache.text));
+		p += cache.length;
+
+		if (!cache.complete || L::template is_unspecified<typename M::hour>(t))
+			return p;
+		*p++ = 'T';
+		p = ets_put2(p, ets_layout_value<L, typename M::hour>(t));
+		if (!L::template is_unspecified<typename M::minute>(t)) {
+			*p++ = ':';
+			p = ets_put2(p, ets_layout_value<L, typename M::minute>(t));
+			if (!L::template is_unspecified<typename M::seconds>(t)) {
+				*p++ = ':';
+				p = ets_put2(p, ets_layout_value<L, typename M::seconds>(t));
+				if (!L::template is_unspecified<typename M::milliseconds>(t)) {
+					*p++ = '.';
+					p = ets_put3(p, ets_layout_value<L, typename M::milliseconds>(t));
+					if (!L::template is_unspecified<typename M::microseconds>(t))
+						p = ets_put3(p, ets_layout_value<L, typename M::microseconds>(t));
+				}
+			}
+		}
+		*p++ = 'Z';
+		return p;
+	}
+
+	inline void floor_divmod(int64_t v, int64_t divisor, int64_t &quot, int64_t &rem)
+	{
+		quot = v / divisor;
+		rem = v % divisor;
+		if (rem < 0) {
+			rem += divisor;
+			quot--;
+		}
+	}
+
+	inline void set_validity(uint8_t *validity, size_t i, bool valid)
+	{
+		if (!validity)
+			return;
+		const uint8_t bit = static_cast<uint8_t>(1u << (i % 8));
+		if (valid)
+			validity[i / 8] |= bit;
+		else
+			validity[i / 8] &= static_cast<uint8_t>(~bit);
+	}
+
+	// shared implementation of all `cvt_from_unix_*()` kernels: `scale` is the number of microseconds per unit.
+	template <class L, int64_t scale, typename T>
+	size_t cvt_from_unix(T *dst, uint8_t *validity, const int64_t *src, size_t count)
+	{
+		// both bounds are whole days, hence exact multiples of `scale`.
+		constexpr int64_t lo = ets_layout_min_unix_usecs<L>() / scale;
+		constexpr int64_t hi = ets_layout_max_unix_usecs<L>() / scale;
+
+		day_cache<L> cache;
+		size_t failures = 0;
+		for (size_t i = 0; i < count; i++) {
+			if (src[i] < lo || src[i] > hi) {
+				store(dst[i], L::unknown());
+				set_validity(validity, i, false);
+				failures++;
+				continue;
+			}
+			int64_t days, rest;
+			floor_divmod(src[i], USECS_PER_DAY / scale, days, rest);
+			store(dst[i], ets_layout_set_time_of_day<L>(cache.lookup(days), rest * scale));
+			set_validity(validity, i, true);
+		}
+		return failures;
+	}
+
+	template <class L, int64_t scale, typename T>
+	size_t cvt_to_unix(int64_t *dst, uint8_t *validity, const T *src, size_t count)
+	{
+		date_cache<L> cache;
+		size_t failures = 0;
+		for (size_t i = 0; i < count; i++) {
+			const uint64_t t = raw(src[i]);
+			if (!ets_layout_has_complete_modern_date<L>(t) || !ets_layout_has_valid_modern_fields<L>(t)) {
+				dst[i] = 0;
+				set_validity(validity, i, false);
+				failures++;
+				continue;
+			}
+			const int64_t usecs = cache.lookup(t) * USECS_PER_DAY + ets_layout_modern_time_of_day_usecs<L>(t);
+			int64_t q, r;
+			floor_divmod(usecs, scale, q, r);
+			dst[i] = q;
+			set_validity(validity, i, true);
+		}
+		return failures;
+	}
+
+	template <class L, typename T>
+	size_t cvt_from_unix_days_kernel(T *dst, uint8_t *validity, const int32_t *src, size_t count)
+	{
+		constexpr int64_t lo = ets_layout_min_unix_usecs<L>() / USECS_PER_DAY;
+		constexpr int64_t hi = ets_layout_max_unix_usecs<L>() / USECS_PER_DAY;
+
+		day_cache<L> cache;
+		size_t failures = 0;
+		for (size_t i = 0; i < count; i++) {
+			if (src[i] < lo || src[i] > hi) {
+				store(dst[i], L::unknown());
+				set_validity(validity, i, false);
+				failures++;
+				continue;
+			}
+			store(dst[i], cache.lookup(src[i]));
+			set_validity(validity, i, true);
+		}
+		return failures;
+	}
+
+	template <class L, typename T>
+	size_t cvt_to_unix_days_kernel(int32_t *dst, uint8_t *validity, const T *src, size_t count)
+	{
+		date_cache<L> cache;
+		size_t failures = 0;
+		for (size_t i = 0; i < count; i++) {
+			const uint64_t t = raw(src[i]);
+			if (!ets_layout_has_complete_modern_date<L>(t) || !ets_layout_has_valid_modern_fields<L>(t)) {
+				dst[i] = 0;
+				set_validity(validity, i, false);
+				failures++;
+				continue;
+			}
+			dst[i] = static_cast<int32_t>(cache.lookup(t));
+			set_validity(validity, i, true);
+		}
+		return failures;
+	}
+
+	template <class L, typename T>
+	size_t cvt_to_rfc3339_column(char *data, size_t capacity, int32_t *offsets, uint8_t *validity, const T *src, size_t start, size_t count, unsigned int parallelism)
+	{
+		const bool rendered = ets_parallel_text_column(data, capacity, offsets, start, count, ETS_BATCH_RFC3339_MAX_LENGTH, parallelism, [=](size_t pos, size_t begin, size_t end) {
+			rfc3339_prefix_cache<L> cache;
+			for (size_t i = begin; i < end; i++) {
+				pos = render_rfc3339(data + pos, cache, raw(src[i])) - data;
+				set_validity(validity, i, cache.valid);
+				offsets[i + 1] = static_cast<int32_t>(pos);
+			}
+		});
+		if (rendered)
+			return count;
+
+		rfc3339_prefix_cache<L> cache;
+		for (size_t i = start; i < count; i++) {
+			const size_t pos = static_cast<size_t>(offsets[i]);
+			size_t n;
+			if (capacity >= pos && capacity - pos >= ETS_BATCH_RFC3339_MAX_LENGTH) {
+				n = render_rfc3339(data + pos, cache, raw(src[i])) - (data + pos);
+			}
+			else {
+				char tmp[ETS_BATCH_RFC3339_MAX_LENGTH];
+				n = render_rfc3339(tmp, cache, raw(src[i])) - tmp;
+				if (capacity < pos || capacity - pos < n)
+					return i;
+				memcpy(data + pos, tmp, n);
+			}
+			set_validity(validity, i, cache.valid);
+			offsets[i + 1] = static_cast<int32_t>(pos + n);
+		}
+		return count;
+	}
+}
+
+
+size_t EternalTimestampBatch::cvt_from_unix_usecs(eternal_timestamp_t *dst, uint8_t *validity, const int64_t *src, size_t count, unsigned int parallelism)
+{
+	ETS_STATS_ENTRY(BATCH_CVT_FROM_UNIX_USECS);
+	return ets_parallel_sum(count, parallelism, [=](size_t begin, size_t end) {
+		return cvt_from_unix<ets_native_layout, 1>(dst + begin, ets_bitmap_at(validity, begin), src + begin, end - begin);
+	});
+}
+
+size_t EternalTimestampBatch::cvt_from_unix_msecs(eternal_timestamp_t *dst, uint8_t *validity, const int64_t *src, size_t count, unsigned int parallelism)
+{
+	ETS_STATS_ENTRY(BATCH_CVT_FROM_UNIX_MSECS);
+	return ets_parallel_sum(count, parallelism, [=](size_t begin, size_t end) {
+		return cvt_from_unix<ets_native_layout, 1000>(dst + begin, ets_bitmap_at(validity, begin), src + begin, end - begin);
+	});
+}
+
+size_t EternalTimestampBatch::cvt_from_unix_seconds(eternal_timestamp_t *dst, uint8_t *validity, const int64_t *src, size_t count, unsigned int parallelism)
+{
+	ETS_STATS_ENTRY(BATCH_CVT_FROM_UNIX_SECONDS);
+	return ets_parallel_sum(count, parallelism, [=](size_t begin, size_t end) {
+		return cvt_from_unix<ets_native_layout, USECS_PER_SECOND>(dst + begin, ets_bitmap_at(validity, begin), src + begin, end - begin);
+	});
+}
+
+size_t EternalTimestampBatch::cvt_from_unix_days(eternal_timestamp_t *dst, uint8_t *validity, const int32_t *src, size_t count, unsigned int parallelism)
+{
+	ETS_STATS_ENTRY(BATCH_CVT_FROM_UNIX_DAYS);
+	return ets_parallel_sum(count, parallelism, [=](size_t begin, size_t end) {
+		return cvt_from_unix_days_kernel<ets_native_layout>(dst + begin, ets_bitmap_at(validity, begin), src + begin, end - begin);
+	});
+}
+
+size_t EternalTimestampBatch::cvt_to_unix_usecs(int64_t *dst, uint8_t *validity, const eternal_timestamp_t *src, size_t count, unsigned int parallelism)
+{
+	ETS_STATS_ENTRY(BATCH_CVT_TO_UNIX_USECS);
+	return ets_parallel_sum(count, parallelism, [=](size_t begin, size_t end) {
+		return cvt_to_unix<ets_native_layout, 1>(dst + begin, ets_bitmap_at(validity, begin), src + begin, end - begin);
+	});
+}
+
+size_t EternalTimestampBatch::cvt_to_unix_msecs(int64_t *dst, uint8_t *validity, const eternal_timestamp_t *src, size_t count, unsigned int parallelism)
+{
+	ETS_STATS_ENTRY(BATCH_CVT_TO_UNIX_MSECS);
+	return ets_parallel_sum(count, parallelism, [=](size_t begin, size_t end) {
+		return cvt_to_unix<ets_native_layout, 1000>(dst + begin, ets_bitmap_at(validity, begin), src + begin, end - begin);
+	});
+}
+
+size_t EternalTimestampBatch::cvt_to_unix_seconds(int64_t *dst, uint8_t *validity, const eternal_timestamp_t *src, size_t count, unsigned int parallelism)
+{
+	ETS_STATS_ENTRY(BATCH_CVT_TO_UNIX_SECONDS);
+	return ets_parallel_sum(count, parallelism, [=](size_t begin, size_t end) {
+		return cvt_to_unix<ets_native_layout, USECS_PER_SECOND>(dst + begin, ets_bitmap_at(validity, begin), src + begin, end - begin);
+	});
+}
+
+size_t EternalTimestampBatch::cvt_to_unix_days(int32_t *dst, uint8_t *validity, const eternal_timestamp_t *src, size_t count, unsigned int parallelism)
+{
+	ETS_STATS_ENTRY(BATCH_CVT_TO_UNIX_DAYS);
+	return ets_parallel_sum(count, parallelism, [=](size_t begin, size_t end) {
+		return cvt_to_unix_days_kernel<ets_native_layout>(dst + begin, ets_bitmap_at(validity, begin), src + begin, end - begin);
+	});
+}
+
+size_t EternalTimestampBatch::cvt_from_iso8601(eternal_timestamp_t *dst, uint8_t *validity, const char *const *strings, const size_t *lengths, size_t count, unsigned int parallelism)
+{
+	ETS_STATS_ENTRY(BATCH_CVT_FROM_ISO8601);
+	return ets_parallel_sum(count, parallelism, [=](size_t begin, size_t end) {
+		size_t failures = 0;
+		for (size_t i = begin; i < end; i++) {
+			const char *s = strings[i];
+			const bool ok = s && !EternalTimestamp::cvt_from_iso8601(dst[i], s, (lengths ? lengths[i] : strlen(s)));
+			if (!ok) {
+				dst[i] = ets_make_unknown();
+				failures++;
+			}
+			set_validity(validity, i, ok);
+		}
+		return failures;
+	});
+}
+
+size_t EternalTimestampBatch::cvt_from_iso8601_column(eternal_timestamp_t *dst, uint8_t *validity, const char *data, const int32_t *offsets, size_t count, unsigned int parallelism)
+{
+	ETS_STATS_ENTRY(BATCH_CVT_FROM_ISO8601_COLUMN);
+	return ets_parallel_sum(count, parallelism, [=](size_t begin, size_t end) {
+		size_t failures = 0;
+		for (size_t i = begin; i < end; i++) {
+			const bool ok = !EternalTimestamp::cvt_from_iso8601(dst[i], data + offsets[i], offsets[i + 1] - offsets[i]);
+			if (!ok) {
+				dst[i] = ets_make_unknown();
+				failures++;
+			}
+			set_validity(validity, i, ok);
+		}
+		return failures;
+	});
+}
+
+size_t EternalTimestampBatch::cvt_to_rfc3339_column(char *data, size_t capacity, int32_t *offsets, uint8_t *validity, const eternal_timestamp_t *src, size_t start, size_t count, unsigned int parallelism)
+{
+	ETS_STATS_ENTRY(BATCH_CVT_TO_RFC3339_COLUMN);
+	return ::cvt_to_rfc3339_column<ets_native_layout>(data, capacity, offsets, validity, src, start, count, parallelism);
+}
+
+void EternalTimestampBatch::calc_sort_keys(int64_t *dst, const eternal_timestamp_t *src, size_t count, unsigned int parallelism)
+{
+	ETS_STATS_ENTRY(BATCH_CALC_SORT_KEYS);
+	EternalTimestampParallel::parallel_for(count, ETS_PARALLEL_GRAIN, parallelism, [=](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			dst[i] = EternalTimestamp::calc_sort_key(src[i]);
+		}
+	});
+}
+
+
+template <class Layout>
+size_t EternalTimestampLayoutBatch<Layout>::cvt_from_unix_usecs(uint64_t *dst, uint8_t *validity, const int64_t *src, size_t count, unsigned int parallelism)
+{
+	ETS_STATS_ENTRY(LAYOUT_BATCH_CVT_FROM_UNIX);
+	return ets_parallel_sum(count, parallelism, [=](size_t begin, size_t end) {
+		return cvt_from_unix<Layout, 1>(dst + begin, ets_bitmap_at(validity, begin), src + begin, end - begin);
+	});
+}
+
+template <class Layout>
+size_t EternalTimestampLayoutBatch<Layout>::cvt_from_unix_msecs(uint64_t *dst, uint8_t *validity, const int64_t *src, size_t count, unsigned int parallelism)
+{
+	ETS_STATS_ENTRY(LAYOUT_BATCH_CVT_FROM_UNIX);
+	return ets_parallel_sum(count, parallelism, [=](size_t begin, size_t end) {
+		return cvt_from_unix<Layout, 1000>(dst + begin, ets_bitmap_at(validity, begin), src + begin, end - begin);
+	});
+}
+
+template <class Layout>
+size_t EternalTimestampLayoutBatch<Layout>::cvt_from_unix_seconds(uint64_t *dst, uint8_t *validity, const int64_t *src, size_t count, unsigned int parallelism)
+{
+	ETS_STATS_ENTRY(LAYOUT_BATCH_CVT_FROM_UNIX);
+	return ets_parallel_sum(count, parallelism, [=](size_t begin, size_t end) {
+		return cvt_from_unix<Layout, USECS_PER_SECOND>(dst + begin, ets_bitmap_at(validity, begin), src + begin, end - begin);
+	});
+}
+
+template <class Layout>
+size_t EternalTimestampLayoutBatch<Layout>::cvt_from_unix_days(uint64_t *dst, uint8_t *validity, const int32_t *src, size_t count, unsigned int parallelism)
+{
+	ETS_STATS_ENTRY(LAYOUT_BATCH_CVT_FROM_UNIX);
+	return ets_parallel_sum(count, parallelism, [=](size_t begin, size_t end) {
+		return cvt_from_unix_days_kernel<Layout>(dst + begin, ets_bitmap_at(validity, begin), src + begin, end - begin);
+	});
+}
+
+template <class Layout>
+size_t EternalTimestampLayoutBatch<Layout>::cvt_to_unix_usecs(int64_t *dst, uint8_t *validity, const uint64_t *src, size_t count, unsigned int parallelism)
+{
+	ETS_STATS_ENTRY(LAYOUT_BATCH_CVT_TO_UNIX);
+	return ets_parallel_sum(count, parallelism, [=](size_t begin, size_t end) {
+		return cvt_to_unix<Layout, 1>(dst + begin, ets_bitmap_at(validity, begin), src + begin, end - begin);
+	});
+}
+
+template <class Layout>
+size_t EternalTimestampLayoutBatch<Layout>::cvt_to_unix_msecs(int64_t *dst, uint8_t *validity, const uint64_t *src, size_t count, unsigned int parallelism)
+{
+	ETS_STATS_ENTRY(LAYOUT_BATCH_CVT_TO_UNIX);
+	return ets_parallel_sum(count, parallelism, [=](size_t begin, size_t end) {
+		return cvt_to_unix<Layout, 1000>(dst + begin, ets_bitmap_at(validity, begin), src + begin, end - begin);
+	});
+}
+
+template <class Layout>
+size_t EternalTimestampLayoutBatch<Layout>::cvt_to_unix_seconds(int64_t *dst, uint8_t *validity, const uint64_t *src, size_t count, unsigned int parallelism)
+{
+	ETS_STATS_ENTRY(LAYOUT_BATCH_CVT_TO_UNIX);
+	return ets_parallel_sum(count, parallelism, [=](size_t begin, size_t end) {
+		return cvt_to_unix<Layout, USECS_PER_SECOND>(dst + begin, ets_bitmap_at(validity, begin), src + begin, end - begin);
+	});
+}
+
+template <class Layout>
+size_t EternalTimestampLayoutBatch<Layout>::cvt_to_unix_days(int32_t *dst, uint8_t *validity, const uint64_t *src, size_t count, unsigned int parallelism)
+{
+	ETS_STATS_ENTRY(LAYOUT_BATCH_CVT_TO_UNIX);
+	return ets_parallel_sum(count, parallelism, [=](size_t begin, size_t end) {
+		return cvt_to_unix_days_kernel<Layout>(dst + begin, ets_bitmap_at(validity, begin), src + begin, end - begin);
+	});
+}
+
+template <class Layout>
+size_t EternalTimestampLayoutBatch<Layout>::cvt_from_iso8601_column(uint64_t *dst, uint8_t *validity, const char *data, const int32_t *offsets, size_t count, unsigned int parallelism)
+{
+	ETS_STATS_ENTRY(LAYOUT_BATCH_FROM_ISO8601);
+	return ets_parallel_sum(count, parallelism, [=](size_t begin, size_t end) {
+		size_t failures = 0;
+		for (size_t i = begin; i < end; i++) {
+			const bool ok = !ets_layout_cvt_from_iso8601<Layout>(dst[i], data + offsets[i], offsets[i + 1] - offsets[i]);
+			if (!ok) {
+				dst[i] = Layout::unknown();
+				failures++;
+			}
+			set_validity(validity, i, ok);
+		}
+		return failures;
+	});
+}
+
+template <class Layout>
+size_t EternalTimestampLayoutBatch<Layout>::cvt_to_rfc3339_column(char *data, size_t capacity, int32_t *offsets, uint8_t *validity, const uint64_t *src, size_t start, size_t count, unsigned int parallelism)
+{
+	ETS_STATS_ENTRY(LAYOUT_BATCH_TO_RFC3339);
+	return ::cvt_to_rfc3339_column<Layout>(data, capacity, offsets, validity, src, start, count, parallelism);
+}
+
+namespace eternal_timestamp
+{
+	template class EternalTimestampLayoutBatch<EternalTimestampUnspecifiedFirstLayout>;
+	template class EternalTimestampLayoutBatch<EternalTimestampUnspecifiedLastLayout>;
+	template class EternalTimestampLayoutBatch<EternalTimestampExtendedLayout>;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// C interface
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+extern "C" size_t ets_batch_cvt_from_unix_usecs(eternal_timestamp_t *dst, uint8_t *validity, const int64_t *src, size_t count)
+{
+	return EternalTimestampBatch::cvt_from_unix_usecs(dst, validity, src, count);
+}
+
+extern "C" size_t ets_batch_cvt_from_unix_msecs(eternal_timestamp_t *dst, uint8_t *validity, const int64_t *src, size_t count)
+{
+	return EternalTimestampBatch::cvt_from_unix_msecs(dst, validity, src, count);
+}
+
+extern "C" size_t ets_batch_cvt_from_unix_seconds(eternal_timestamp_t *dst, uint8_t *validity, const int64_t *src, size_t count)
+{
+	return EternalTimestampBatch::cvt_from_unix_seconds(dst, validity, src, count);
+}
+
+extern "C" size_t ets_batch_cvt_from_unix_days(eternal_timestamp_t *dst, uint8_t *validity, const int32_t *src, size_t count)
+{
+	return EternalTimestampBatch::cvt_from_unix_days(dst, validity, src, count);
+}
+
+extern "C" size_t ets_batch_cvt_to_unix_usecs(int64_t *dst, uint8_t *validity, const eternal_timestamp_t *src, size_t count)
+{
+	return EternalTimestampBatch::cvt_to_unix_usecs(dst, validity, src, count);
+}
+
+extern "C" size_t ets_batch_cvt_to_unix_msecs(int64_t *dst, uint8_t *validity, const eternal_timestamp_t *src, size_t count)
+{
+	return EternalTimestampBatch::cvt_to_unix_msecs(dst, validity, src, count);
+}
+
+extern "C" size_t ets_batch_cvt_to_unix_seconds(int64_t *dst, uint8_t *validity, const eternal_timestamp_t *src, size_t count)
+{
+	return EternalTimestampBatch::cvt_to_unix_seconds(dst, validity, src, count);
+}
+
+extern "C" size_t ets_batch_cvt_to_unix_days(int32_t *dst, uint8_t *validity, const eternal_timestamp_t *src, size_t count)
+{
+	return EternalTimestampBatch::cvt_to_unix_days(dst, validity, src, count);
+}
+
+extern "C" size_t ets_batch_cvt_from_iso8601(eternal_timestamp_t *dst, uint8_t *validity, const char *const *strings, const size_t *lengths, size_t count)
+{
+	return EternalTimestampBatch::cvt_from_iso8601(dst, validity, strings, lengths, count);
+}
+
+extern "C" size_t ets_batch_cvt_from_iso8601_column(eternal_timestamp_t *dst, uint8_t *validity, const char *data, const int32_t *offsets, size_t count)
+{
+	return EternalTimestampBatch::cvt_from_iso8601_column(dst, validity, data, offsets, count);
+}
+
+extern "C" size_t ets_batch_cvt_to_rfc3339_column(char *data, size_t capacity, int32_t *offsets, uint8_t *validity, const eternal_timestamp_t *src, size_t start, size_t count)
+{
+	return EternalTimestampBatch::cvt_to_rfc3339_column(data, capacity, offsets, validity, src, start, count);
+}
+
+extern "C" void ets_batch_calc_sort_keys(int64_t *dst, const eternal_timestamp_t *src, size_t count)
+{
+	EternalTimestampBatch::calc_sort_keys(dst, src, count);
+}
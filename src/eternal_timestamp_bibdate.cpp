@@ -0,0 +1,1126 @@
+
+#include "eternal_timestamp/eternal_timestamp_bibdate.h"
+
+#include "eternal_timestamp_instrumentation.h"
+#include "eternal_timestamp_internal.h"
+
+
+using namespace eternal_timestamp;
+
+
+namespace
+{
+	enum keyword_kind : uint8_t
+	{
+		KW_UNKNOWN = 0,
+		KW_MONTH,              // value: month number
+		KW_SEASON,             // value: the first month of the season
+		KW_CIRCA,              // value 1 for the bare 'c', which is also used for 'century' and copyright years
+		KW_BC,
+		KW_AD,
+		KW_BP,
+		KW_CENTURY,
+		KW_MILLENNIUM,
+		KW_MAGNITUDE,          // value: power of 10
+		KW_YEARS,
+		KW_MODIFIER,           // early/mid/late: accepted, but they make the date vaguer than we can express
+		KW_RANGE,
+		KW_NODATE,
+		KW_WEEKDAY,
+		KW_COPYRIGHT,
+		KW_ZONE,
+	};
+
+	struct keyword
+	{
+		const char *word;      // lowercase UTF-8
+		keyword_kind kind;
+		uint8_t value;
+	};
+
+	constexpr keyword keywords[] = {
+		// English
+		{ "january", KW_MONTH, 1 }, { "jan", KW_MONTH, 1 },
+		{ "february", KW_MONTH, 2 }, { "feb", KW_MONTH, 2 },
+		{ "march", KW_MONTH, 3 }, { "mar", KW_MONTH, 3 },
+		{ "april", KW_MONTH, 4 }, { "apr", KW_MONTH, 4 },
+		{ "may", KW_MONTH, 5 },
+		{ "june", KW_MONTH, 6 }, { "jun", KW_MONTH, 6 },
+		{ "july", KW_MONTH, 7 }, { "jul", KW_MONTH, 7 },
+		{ "august", KW_MONTH, 8 }, { "aug", KW_MONTH, 8 },
+		{ "september", KW_MONTH, 9 }, { "sep", KW_MONTH, 9 }, { "sept", KW_MONTH, 9 },
+		{ "october", KW_MONTH, 10 }, { "oct", KW_MONTH, 10 },
+		{ "november", KW_MONTH, 11 }, { "nov", KW_MONTH, 11 },
+		{ "december", KW_MONTH, 12 }, { "dec", KW_MONTH, 12 },
+		// German
+		{ "januar", KW_MONTH, 1 }, { "februar", KW_MONTH, 2 }, { "m\xc3\xa4rz", KW_MONTH, 3 }, { "mai", KW_MONTH, 5 },
+		{ "juni", KW_MONTH, 6 }, { "juli", KW_MONTH, 7 }, { "oktober", KW_MONTH, 10 }, { "dezember", KW_MONTH, 12 },
+		// French
+		{ "janvier", KW_MONTH, 1 }, { "f\xc3\xa9vrier", KW_MONTH, 2 }, { "fevrier", KW_MONTH, 2 }, { "mars", KW_MONTH, 3 },
+		{ "avril", KW_MONTH, 4 }, { "juin", KW_MONTH, 6 }, { "juillet", KW_MONTH, 7 }, { "ao\xc3\xbbt", KW_MONTH, 8 },
+		{ "aout", KW_MONTH, 8 }, { "septembre", KW_MONTH, 9 }, { "octobre", KW_MONTH, 10 }, { "novembre", KW_MONTH, 11 },
+		{ "d\xc3\xa9" "cembre", KW_MONTH, 12 }, { "decembre", KW_MONTH, 12 },
+		// Dutch
+		{ "januari", KW_MONTH, 1 }, { "februari", KW_MONTH, 2 }, { "maart", KW_MONTH, 3 }, { "mei", KW_MONTH, 5 },
+		{ "augustus", KW_MONTH, 8 },
+		// Spanish
+		{ "enero", KW_MONTH, 1 }, { "febrero", KW_MONTH, 2 }, { "marzo", KW_MONTH, 3 }, { "abril", KW_MONTH, 4 },
+		{ "mayo", KW_MONTH, 5 }, { "junio", KW_MONTH, 6 }, { "julio", KW_MONTH, 7 }, { "agosto", KW_MONTH, 8 },
+		{ "septiembre", KW_MONTH, 9 }, { "setiembre", KW_MONTH, 9 }, { "octubre", KW_MONTH, 10 }, { "noviembre", KW_MONTH, 11 },
+		{ "diciembre", KW_MONTH, 12 },
+
+		// journal issue seasons
+		{ "spring", KW_SEASON, 3 }, { "spr", KW_SEASON, 3 },
+		{ "summer", KW_SEASON, 6 }, { "sum", KW_SEASON, 6 },
+		{ "autumn", KW_SEASON, 9 }, { "fall", KW_SEASON, 9 }, { "aut", KW_SEASON, 9 },
+		{ "winter", KW_SEASON, 12 }, { "win", KW_SEASON, 12 },
+
+		{ "circa", KW_CIRCA, 0 }, { "ca", KW_CIRCA, 0 }, { "c", KW_CIRCA, 1 }, { "approx", KW_CIRCA, 0 },
+		{ "approximately", KW_CIRCA, 0 }, { "about", KW_CIRCA, 0 }, { "around", KW_CIRCA, 0 }, { "abt", KW_CIRCA, 0 },
+
+		{ "bc", KW_BC, 0 }, { "bce", KW_BC, 0 },
+		{ "ad", KW_AD, 0 }, { "ce", KW_AD, 0 },
+		{ "bp", KW_BP, 0 }, { "ago", KW_BP, 0 },
+
+		{ "century", KW_CENTURY, 0 }, { "centuries", KW_CENTURY, 0 }, { "cent", KW_CENTURY, 0 },
+		{ "jahrhundert", KW_CENTURY, 0 }, { "si\xc3\xa8" "cle", KW_CENTURY, 0 }, { "siecle", KW_CENTURY, 0 },
+		{ "eeuw", KW_CENTURY, 0 }, { "siglo", KW_CENTURY, 0 }, { "secolo", KW_CENTURY, 0 },
+		{ "millennium", KW_MILLENNIUM, 0 }, { "millenium", KW_MILLENNIUM, 0 }, { "millennia", KW_MILLENNIUM, 0 },
+
+		{ "thousand", KW_MAGNITUDE, 3 }, { "ka", KW_MAGNITUDE, 3 }, { "kya", KW_MAGNITUDE, 3 }, { "kyr", KW_MAGNITUDE, 3 },
+		{ "million", KW_MAGNITUDE, 6 }, { "ma", KW_MAGNITUDE, 6 }, { "mya", KW_MAGNITUDE, 6 }, { "myr", KW_MAGNITUDE, 6 },
+		{ "billion", KW_MAGNITUDE, 9 }, { "ga", KW_MAGNITUDE, 9 }, { "bya", KW_MAGNITUDE, 9 }, { "gyr", KW_MAGNITUDE, 9 },
+
+		{ "year", KW_YEARS, 0 }, { "years", KW_YEARS, 0 }, { "yr", KW_YEARS, 0 }, { "yrs", KW_YEARS, 0 },
+
+		{ "early", KW_MODIFIER, 0 }, { "mid", KW_MODIFIER, 0 }, { "middle", KW_MODIFIER, 0 }, { "late", KW_MODIFIER, 0 },
+
+		{ "to", KW_RANGE, 0 }, { "till", KW_RANGE, 0 }, { "until", KW_RANGE, 0 },
+
+		{ "nd", KW_NODATE, 0 }, { "undated", KW_NODATE, 0 }, { "sd", KW_NODATE, 0 },
+
+		{ "monday", KW_WEEKDAY, 0 }, { "tuesday", KW_WEEKDAY, 0 }, { "wednesday", KW_WEEKDAY, 0 }, { "thursday", KW_WEEKDAY, 0 },
+		{ "friday", KW_WEEKDAY, 0 }, { "saturday", KW_WEEKDAY, 0 }, { "sunday", KW_WEEKDAY, 0 },
+		{ "mon", KW_WEEKDAY, 0 }, { "tue", KW_WEEKDAY, 0 }, { "tues", KW_WEEKDAY, 0 }, { "wed", KW_WEEKDAY, 0 },
+		{ "thu", KW_WEEKDAY, 0 }, { "thur", KW_WEEKDAY, 0 }, { "thurs", KW_WEEKDAY, 0 }, { "fri", KW_WEEKDAY, 0 },
+		{ "sat", KW_WEEKDAY, 0 }, { "sun", KW_WEEKDAY, 0 },
+
+		{ "copyright", KW_COPYRIGHT, 0 }, { "cop", KW_COPYRIGHT, 0 },
+
+		{ "gmt", KW_ZONE, 0 }, { "utc", KW_ZONE, 0 }, { "ut", KW_ZONE, 0 },
+	};
+
+	constexpr size_t KEYWORD_COUNT = sizeof(keywords) / sizeof(keywords[0]);
+	constexpr size_t MAX_KEYWORD_LENGTH = 16;
+
+	// Perfect hash: a multiplicative hash of the word's first and last 8 bytes and its length. The multiplier
+	// has been picked (by brute force search) to map every keyword to its own slot; `keyword_lookup` below
+	// verifies this at compile time.
+	constexpr int KEYWORD_HASH_BITS = 10;
+	constexpr uint64_t KEYWORD_HASH_MULTIPLIER = 0xed6ed70976a3a1a5ull;
+
+	constexpr uint64_t keyword_key(const char *w, size_t n)
+	{
+		uint64_t lo = 0;
+		uint64_t hi = 0;
+		for (size_t i = 0; i < n && i < 8; i++)
+			lo |= static_cast<uint64_t>(static_cast<uint8_t>(w[i])) << (8 * i);
+		if (n > 8) {
+			for (size_t i = 0; i < 8; i++)
+				hi |= static_cast<uint64_t>(static_cast<uint8_t>(w[n - 8 + i])) << (8 * i);
+		}
+		return lo ^ ((hi << 7) | (hi >> 57)) ^ n;
+	}
+
+	constexpr unsigned int keyword_slot(uint64_t key)
+	{
+		return static_cast<unsigned int>((key * KEYWORD_HASH_MULTIPLIER) >> (64 - KEYWORD_HASH_BITS));
+	}
+
+	constexpr size_t keyword_length(const char *w)
+	{
+		size_t n = 0;
+		while (w[n])
+			n++;
+		return n;
+	}
+
+	struct keyword_table
+	{
+		uint8_t slot[1 << KEYWORD_HASH_BITS];    // 1 + index into `keywords[]`; 0: empty slot
+		bool perfect;
+	};
+
+	constexpr keyword_table build_keyword_table()
+	{
+		keyword_table t{};
+		t.perfect = true;
+		for (size_t i = 0; i < KEYWORD_COUNT; i++) {
+			const unsigned int s = keyword_slot(keyword_key(keywords[i].word, keyword_length(keywords[i].word)));
+			if (t.slot[s] || keyword_length(keywords[i].word) > MAX_KEYWORD_LENGTH)
+				t.perfect = false;
+			t.slot[s] = static_cast<uint8_t>(i + 1);
+		}
+		return t;
+	}
+
+	static_assert(KEYWORD_COUNT < 256, "the keyword slot table stores 8-bit indexes");
+	constexpr keyword_table keyword_lookup = build_keyword_table();
+	static_assert(keyword_lookup.perfect, "keyword hash collision: pick another KEYWORD_HASH_MULTIPLIER");
+
+	// `w` is the lowercased word.
+	const keyword *find_keyword(const char *w, size_t n)
+	{
+		const unsigned int idx = keyword_lookup.slot[keyword_slot(keyword_key(w, n))];
+		if (!idx)
+			return nullptr;
+		const keyword &kw = keywords[idx - 1];
+		if (strncmp(kw.word, w, n) != 0 || kw.word[n] != 0)
+			return nullptr;
+		return &kw;
+	}
+
+
+	enum token_type : uint8_t
+	{
+		TOK_NUMBER,
+		TOK_WORD,
+		TOK_PUNCT,
+	};
+
+	enum number_suffix : uint8_t
+	{
+		SUFFIX_NONE,
+		SUFFIX_ORDINAL,              // 19th, 3rd, 19e, 19de
+		SUFFIX_PLURAL,               // 1920s, 1920's
+		SUFFIX_DECADE_WILDCARD,      // MARC: 192-, 192u, 192x
+		SUFFIX_CENTURY_WILDCARD,     // MARC: 19--, 19uu, 19xx
+	};
+
+	struct token
+	{
+		token_type type;
+		bool glued;                  // not separated from the previous token by whitespace
+		char punct;                  // TOK_PUNCT
+		keyword_kind kind;           // TOK_WORD; KW_UNKNOWN for unrecognized words
+		uint8_t value;               // TOK_WORD
+		number_suffix suffix;        // TOK_NUMBER
+		int digits;                  // TOK_NUMBER
+		uint64_t number;             // TOK_NUMBER; for unrecognized words: their value as a Roman numeral, if any
+	};
+
+	constexpr int MAX_TOKENS = 24;
+
+	struct token_list
+	{
+		token tok[MAX_TOKENS];
+		int count;
+		bool truncated;
+	};
+
+	inline bool is_digit(char c)
+	{
+		return static_cast<unsigned char>(c - '0') <= 9;
+	}
+
+	// ASCII letters, plus any UTF-8 multibyte sequence byte, so words like "Février" remain a single word.
+	inline bool is_letter(char c)
+	{
+		const unsigned char u = static_cast<unsigned char>(c);
+		return static_cast<unsigned char>((u | 0x20) - 'a') < 26 || u >= 0x80;
+	}
+
+	inline char to_lower(char c)
+	{
+		return static_cast<unsigned char>(c - 'A') < 26 ? static_cast<char>(c | 0x20) : c;
+	}
+
+	// U+2013 EN DASH, U+2014 EM DASH
+	inline bool is_utf8_dash(const char *p, const char *end)
+	{
+		return end - p >= 3 && static_cast<unsigned char>(p[0]) == 0xE2 && static_cast<unsigned char>(p[1]) == 0x80
+			&& (static_cast<unsigned char>(p[2]) == 0x93 || static_cast<unsigned char>(p[2]) == 0x94);
+	}
+
+	// U+2019 RIGHT SINGLE QUOTATION MARK, as in "1920’s"
+	inline bool is_utf8_apostrophe(const char *p, const char *end)
+	{
+		return end - p >= 3 && static_cast<unsigned char>(p[0]) == 0xE2 && static_cast<unsigned char>(p[1]) == 0x80
+			&& static_cast<unsigned char>(p[2]) == 0x99;
+	}
+
+	// U+00A0 NO-BREAK SPACE
+	inline bool is_utf8_nbsp(const char *p, const char *end)
+	{
+		return end - p >= 2 && static_cast<unsigned char>(p[0]) == 0xC2 && static_cast<unsigned char>(p[1]) == 0xA0;
+	}
+
+	bool is_ordinal_suffix(const char *w, size_t n)
+	{
+		switch (n) {
+		case 1:
+			return w[0] == 'e';
+		case 2:
+			return (w[0] == 's' && w[1] == 't') || (w[0] == 'n' && w[1] == 'd') || (w[0] == 'r' && w[1] == 'd')
+				|| (w[0] == 't' && w[1] == 'h') || (w[0] == 'e' && w[1] == 'r') || (w[0] == 'd' && w[1] == 'e')
+				|| (w[0] == 't' && w[1] == 'e');
+		case 3:
+			return memcmp(w, "ste", 3) == 0 || memcmp(w, "eme", 3) == 0;
+		case 4:
+			return memcmp(w, "\xc3\xa8me", 4) == 0;    // ème
+		default:
+			return false;
+		}
+	}
+
+	const char *lex_number(token &t, const char *p, const char *end)
+	{
+		uint64_t v = 0;
+		int n = 0;
+		while (p < end && is_digit(*p)) {
+			if (n < 19)
+				v = v * 10 + static_cast<unsigned int>(*p - '0');
+			n++;
+			p++;
+		}
+		t.type = TOK_NUMBER;
+		t.number = v;
+		t.digits = n;
+		t.suffix = SUFFIX_NONE;
+
+		// MARC unknown digits: 192-, 19--, 192u, 19uu, 192x, 19xx
+		if (n == 2 || n == 3) {
+			const char *q = p;
+			int w = 0;
+			while (q < end && w < 4 - n && (*q == '-' || (*q | 0x20) == 'u' || (*q | 0x20) == 'x')) {
+				q++;
+				w++;
+			}
+			if (n + w == 4 && (q == end || !(is_digit(*q) || is_letter(*q)))) {
+				t.number = v * (w == 1 ? 10 : 100);
+				t.digits = 4;
+				t.suffix = (w == 1 ? SUFFIX_DECADE_WILDCARD : SUFFIX_CENTURY_WILDCARD);
+				return q;
+			}
+		}
+
+		// glued ordinal or plural suffix; anything else glued is lexed as a separate word.
+		if (p < end && is_letter(*p)) {
+			char w[5];
+			size_t len = 0;
+			const char *q = p;
+			while (q < end && is_letter(*q)) {
+				if (len < sizeof(w))
+					w[len] = to_lower(*q);
+				len++;
+				q++;
+			}
+			if (len <= sizeof(w) && is_ordinal_suffix(w, len)) {
+				t.suffix = SUFFIX_ORDINAL;
+				return q;
+			}
+			if (len == 1 && w[0] == 's') {
+				t.suffix = SUFFIX_PLURAL;
+				return q;
+			}
+		} else if (p < end && (*p == '\'' || is_utf8_apostrophe(p, end))) {
+			const char *q = p + (*p == '\'' ? 1 : 3);
+			if (q < end && (*q | 0x20) == 's' && (q + 1 == end || !is_letter(q[1]))) {
+				t.suffix = SUFFIX_PLURAL;
+				return q + 1;
+			}
+		}
+		return p;
+	}
+
+	// 'XIX', 'XIXe', 'xixth' --> 19; 0 when the word isn't a (canonical) Roman numeral, optionally with an ordinal suffix.
+	unsigned int parse_roman_ordinal(const char *w, size_t n)
+	{
+		static const struct { const char *digits; unsigned int value; } numerals[] = {
+			{ "c", 100 }, { "xc", 90 }, { "l", 50 }, { "xl", 40 }, { "x", 10 }, { "ix", 9 }, { "v", 5 }, { "iv", 4 }, { "i", 1 },
+		};
+		for (size_t len = n; len > 0; len--) {
+			if (len < n && !is_ordinal_suffix(w + len, n - len))
+				continue;
+			// greedy canonical decoding: 'IIII' or 'VX' don't decode completely.
+			unsigned int value = 0;
+			size_t i = 0;
+			for (const auto &numeral : numerals) {
+				const size_t k = strlen(numeral.digits);
+				int repeat = 0;
+				while (i + k <= len && memcmp(w + i, numeral.digits, k) == 0 && repeat < (k == 1 && numeral.digits[0] != 'v' && numeral.digits[0] != 'l' ? 3 : 1)) {
+					value += numeral.value;
+					i += k;
+					repeat++;
+				}
+			}
+			if (i == len)
+				return value;
+		}
+		return 0;
+	}
+
+	const char *lex_word(token &t, const char *p, const char *end)
+	{
+		char w[MAX_KEYWORD_LENGTH];
+		size_t n = 0;
+		for (;;) {
+			const char *q = p;
+			while (q < end && is_letter(*q)) {
+				if (n < MAX_KEYWORD_LENGTH)
+					w[n] = to_lower(*q);
+				n++;
+				q++;
+			}
+			// dotted abbreviations made of single letters are joined: B.C., A.D., B.C.E., n.d.
+			const bool single = (q - p == 1);
+			p = q;
+			if (single && end - p >= 2 && *p == '.' && is_letter(p[1]) && (end - p == 2 || !is_letter(p[2]))) {
+				p++;
+				continue;
+			}
+			break;
+		}
+		t.type = TOK_WORD;
+		t.kind = KW_UNKNOWN;
+		t.value = 0;
+		if (n <= MAX_KEYWORD_LENGTH) {
+			const keyword *kw = find_keyword(w, n);
+			if (kw) {
+				t.kind = kw->kind;
+				t.value = kw->value;
+			} else {
+				t.number = parse_roman_ordinal(w, n);
+			}
+		}
+		return p;
+	}
+
+	void tokenize(token_list &tl, const char *p, const char *end)
+	{
+		tl.count = 0;
+		tl.truncated = false;
+		bool glued = false;
+		while (p < end) {
+			const char c = *p;
+			if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+				p++;
+				glued = false;
+				continue;
+			}
+			if (is_utf8_nbsp(p, end)) {
+				p += 2;
+				glued = false;
+				continue;
+			}
+			if (tl.count == MAX_TOKENS) {
+				tl.truncated = true;
+				return;
+			}
+
+			token &t = tl.tok[tl.count++];
+			t = token{};
+			t.glued = glued;
+			glued = true;
+
+			if (is_digit(c)) {
+				p = lex_number(t, p, end);
+			} else if (is_utf8_dash(p, end)) {
+				t.type = TOK_PUNCT;
+				t.punct = '-';
+				p += 3;
+			} else if (is_letter(c)) {
+				p = lex_word(t, p, end);
+			} else {
+				t.type = TOK_PUNCT;
+				t.punct = c;
+				p++;
+			}
+		}
+	}
+
+
+	// a number which is a candidate for the year or day of the date.
+	struct number_item
+	{
+		uint64_t value;
+		int digits;
+		number_suffix suffix;
+		int64_t period;          // 100: followed by 'century'; 1000: followed by 'millennium'; 0 otherwise
+		bool magnitude;          // scaled by 'thousand', 'Ma', etc.
+		bool after_range;        // part of the end of a range
+	};
+
+	struct bib_date
+	{
+		number_item items[8];
+		int item_count;
+
+		// set by a numeric date such as 13/01/1922; -1: not specified
+		int64_t year;
+		int year_digits;
+		int month;
+		int day;
+
+		int base_confidence;
+		int penalty;
+		unsigned int qualifiers;
+		keyword_kind era;
+	};
+
+	inline bool is_punct(const token_list &tl, int i, char c)
+	{
+		return i < tl.count && tl.tok[i].type == TOK_PUNCT && tl.tok[i].punct == c;
+	}
+
+	inline bool is_word(const token_list &tl, int i, keyword_kind kind)
+	{
+		return i < tl.count && tl.tok[i].type == TOK_WORD && tl.tok[i].kind == kind;
+	}
+
+	int trailing_zeros(uint64_t v)
+	{
+		int n = 0;
+		while (v && v % 10 == 0) {
+			v /= 10;
+			n++;
+		}
+		return n;
+	}
+
+	bool is_leap_year(int64_t y)
+	{
+		return y % 4 == 0 && (y % 100 != 0 || y % 400 == 0);
+	}
+
+	// when the year is not known (exactly), Feb 29 is accepted.
+	bool is_valid_day(int64_t y, bool year_known, int m, int d)
+	{
+		static const unsigned char days[12] = { 31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+		if (m < 1 || m > 12 || d < 1 || d > days[m - 1])
+			return false;
+		return d != 29 || m != 2 || !year_known || is_leap_year(y);
+	}
+
+	// Read the number at `tl.tok[i]`, merging thousands separators ("40,000"). Returns the index of the next token.
+	int read_number(const token_list &tl, int i, uint64_t &value, int &digits)
+	{
+		value = tl.tok[i].number;
+		digits = tl.tok[i].digits;
+		int j = i + 1;
+		if (digits > 3)
+			return j;
+		while (digits <= 12 && tl.tok[j - 1].suffix == SUFFIX_NONE && is_punct(tl, j, ',') && tl.tok[j].glued
+			&& j + 1 < tl.count && tl.tok[j + 1].type == TOK_NUMBER && tl.tok[j + 1].glued && tl.tok[j + 1].digits == 3) {
+			value = value * 1000 + tl.tok[j + 1].number;
+			digits += 3;
+			j += 2;
+		}
+		return j;
+	}
+
+	void add_item(bib_date &bd, const number_item &item)
+	{
+		if (bd.item_count < static_cast<int>(sizeof(bd.items) / sizeof(bd.items[0])))
+			bd.items[bd.item_count++] = item;
+		else
+			bd.penalty += 20;
+	}
+
+	// Interpret a group of 2 or 3 numbers separated by '-', '/' or '.': a numeric date, or a range.
+	// Returns `false` when the group cannot be a valid date.
+	bool numeric_date(bib_date &bd, const uint64_t *v, const int *d, const char *sep, int n, bool &range)
+	{
+		range = false;
+		if (n == 2) {
+			if (d[0] >= 3 && d[0] <= 5) {
+				// 1922/05 or a range: 1850-1860, 1850/51
+				if (d[1] == 2 && v[1] >= 1 && v[1] <= 12 && sep[0] != '.') {
+					bd.year = static_cast<int64_t>(v[0]);
+					bd.year_digits = d[0];
+					bd.month = static_cast<int>(v[1]);
+					bd.base_confidence = 85;
+					return true;
+				}
+				range = true;
+				return true;
+			}
+			if (d[0] <= 2 && d[1] >= 3 && d[1] <= 5 && v[0] >= 1 && v[0] <= 12) {
+				// 01/1922
+				bd.year = static_cast<int64_t>(v[1]);
+				bd.year_digits = d[1];
+				bd.month = static_cast<int>(v[0]);
+				bd.base_confidence = 80;
+				return true;
+			}
+			if (d[0] <= 2 && d[1] <= 2 && v[0] <= 31 && v[1] <= 31) {
+				// a day range: 13-15 January 1922
+				range = true;
+				return true;
+			}
+			return false;
+		}
+
+		// n == 3
+		if (d[0] >= 3 && d[0] <= 5 && d[1] <= 2 && d[2] <= 2) {
+			// 1922/01/13, 1922.01.13
+			bd.year = static_cast<int64_t>(v[0]);
+			bd.year_digits = d[0];
+			bd.month = static_cast<int>(v[1]);
+			bd.day = static_cast<int>(v[2]);
+			bd.base_confidence = 95;
+		} else if (d[0] <= 2 && d[1] <= 2 && (d[2] == 2 || (d[2] >= 3 && d[2] <= 5))) {
+			int64_t y = static_cast<int64_t>(v[2]);
+			bd.base_confidence = 95;
+			if (d[2] == 2) {
+				// two-digit year: pivot at 50
+				y += (y < 50 ? 2000 : 1900);
+				bd.base_confidence -= 30;
+			}
+			bd.year = y;
+			bd.year_digits = (d[2] == 2 ? 4 : d[2]);
+			if (v[0] > 12 && v[1] <= 12) {
+				// 13/01/1922
+				bd.day = static_cast<int>(v[0]);
+				bd.month = static_cast<int>(v[1]);
+			} else if (v[1] > 12 && v[0] <= 12) {
+				// 01/13/1922
+				bd.month = static_cast<int>(v[0]);
+				bd.day = static_cast<int>(v[1]);
+			} else if (sep[0] == '.') {
+				// 13.01.1922 is the European notation
+				bd.day = static_cast<int>(v[0]);
+				bd.month = static_cast<int>(v[1]);
+				bd.base_confidence -= 10;
+			} else {
+				// ambiguous: we follow the US convention used by most publisher metadata.
+				bd.month = static_cast<int>(v[0]);
+				bd.day = static_cast<int>(v[1]);
+				bd.base_confidence -= 35;
+			}
+		} else {
+			return false;
+		}
+		return is_valid_day(bd.year, true, bd.month, bd.day);
+	}
+
+	// Walk the tokens and collect the date components. Returns `false` when the string is definitely not a date.
+	bool collect(bib_date &bd, const token_list &tl)
+	{
+		bool in_range = false;
+		bool have_number = false;
+
+		for (int i = 0; i < tl.count; ) {
+			const token &t = tl.tok[i];
+
+			if (t.type == TOK_PUNCT) {
+				switch (t.punct) {
+				case '?':
+					bd.qualifiers |= ETS_BIBDATE_UNCERTAIN;
+					break;
+
+				case '~':
+					bd.qualifiers |= ETS_BIBDATE_CIRCA;
+					break;
+
+				case '-':
+				case '/':
+					if (have_number) {
+						in_range = true;
+						bd.qualifiers |= ETS_BIBDATE_RANGE;
+					}
+					break;
+
+				default:
+					// brackets, commas, periods, ...: noise
+					break;
+				}
+				i++;
+				continue;
+			}
+
+			if (t.type == TOK_WORD) {
+				switch (t.kind) {
+				case KW_MONTH:
+				case KW_SEASON:
+					if (in_range)
+						break;
+					if (bd.month < 0) {
+						bd.month = t.value;
+						if (t.kind == KW_SEASON)
+							bd.qualifiers |= ETS_BIBDATE_SEASON;
+					} else if (is_punct(tl, i - 1, '-') || is_punct(tl, i - 1, '/') || is_word(tl, i - 1, KW_RANGE)) {
+						// Jan-Mar 1922
+						bd.qualifiers |= ETS_BIBDATE_RANGE;
+					} else {
+						bd.penalty += 15;
+					}
+					break;
+
+				case KW_CIRCA:
+					// a 'c' glued to a year marks a copyright year (MARC: c1922)
+					if (t.value == 1 && i + 1 < tl.count && tl.tok[i + 1].type == TOK_NUMBER && tl.tok[i + 1].glued)
+						break;
+					bd.qualifiers |= ETS_BIBDATE_CIRCA;
+					break;
+
+				case KW_BC:
+				case KW_AD:
+				case KW_BP:
+					if (bd.era == KW_UNKNOWN)
+						bd.era = t.kind;
+					else if (bd.era != t.kind)
+						bd.penalty += 30;
+					break;
+
+				case KW_YEARS:
+				case KW_WEEKDAY:
+				case KW_COPYRIGHT:
+				case KW_ZONE:
+					break;
+
+				case KW_MODIFIER:
+					bd.penalty += 5;
+					break;
+
+				case KW_RANGE:
+					if (have_number) {
+						in_range = true;
+						bd.qualifiers |= ETS_BIBDATE_RANGE;
+					} else {
+						bd.penalty += 15;
+					}
+					break;
+
+				case KW_NODATE:
+					return false;
+
+				default:
+					// 'XIXe siècle', 'XIX. Jahrhundert'
+					if (t.number && !in_range) {
+						int k = i + 1;
+						if (is_punct(tl, k, '.') && tl.tok[k].glued)
+							k++;
+						if (is_word(tl, k, KW_CENTURY) || is_word(tl, k, KW_MILLENNIUM)) {
+							number_item item{};
+							item.value = t.number;
+							item.digits = 2;
+							item.suffix = SUFFIX_ORDINAL;
+							item.period = (tl.tok[k].kind == KW_MILLENNIUM ? 1000 : 100);
+							add_item(bd, item);
+							have_number = true;
+							i = k + 1;
+							continue;
+						}
+					}
+					// unknown words, and 'century' & friends which don't follow a number
+					bd.penalty += 15;
+					break;
+				}
+				i++;
+				continue;
+			}
+
+			// a time of day (12:40:31) is of no interest for a bibliographic date: skip it.
+			if (is_punct(tl, i + 1, ':') && tl.tok[i + 1].glued) {
+				int j = i + 1;
+				while (is_punct(tl, j, ':') && tl.tok[j].glued && j + 1 < tl.count && tl.tok[j + 1].type == TOK_NUMBER && tl.tok[j + 1].glued)
+					j += 2;
+				i = j;
+				continue;
+			}
+
+			// a number, or a group of numbers joined by '-', '/' or '.': 1922-01-13, 13/01/1922, 2.5
+			uint64_t v[3];
+			int d[3];
+			char sep[2];
+			int n = 1;
+			int j = read_number(tl, i, v[0], d[0]);
+			while (n < 3 && j + 1 < tl.count && tl.tok[j].type == TOK_PUNCT && tl.tok[j].glued
+				&& (tl.tok[j].punct == '-' || tl.tok[j].punct == '/' || tl.tok[j].punct == '.')
+				&& (n == 1 || tl.tok[j].punct == sep[0])
+				&& tl.tok[j + 1].type == TOK_NUMBER && tl.tok[j + 1].glued && tl.tok[j - 1].suffix == SUFFIX_NONE) {
+				sep[n - 1] = tl.tok[j].punct;
+				j = read_number(tl, j + 1, v[n], d[n]);
+				n++;
+			}
+			const token &last = tl.tok[j - 1];
+
+			number_item item{};
+			item.value = v[0];
+			item.digits = d[0];
+			item.suffix = (n == 1 ? last.suffix : SUFFIX_NONE);
+			item.after_range = in_range;
+
+			// 2.5 million, 13.8 Gyr
+			const bool decimal = (n == 2 && sep[0] == '.' && is_word(tl, j, KW_MAGNITUDE));
+
+			if (n == 1 || decimal) {
+				// '19th century', '19. Jahrhundert', '19th-century', '19th c.', '3rd millennium'
+				int k = j;
+				bool ordinal = (last.suffix == SUFFIX_ORDINAL);
+				if (is_punct(tl, k, '.') && tl.tok[k].glued) {
+					ordinal = true;
+					k++;
+				} else if (ordinal && is_punct(tl, k, '-') && tl.tok[k].glued) {
+					k++;
+				}
+				if (n == 1 && ordinal && k < tl.count && tl.tok[k].type == TOK_WORD
+					&& (tl.tok[k].kind == KW_CENTURY || tl.tok[k].kind == KW_MILLENNIUM
+						|| (tl.tok[k].kind == KW_CIRCA && tl.tok[k].value == 1))) {
+					item.period = (tl.tok[k].kind == KW_MILLENNIUM ? 1000 : 100);
+					j = k + 1;
+				} else if (is_word(tl, j, KW_MAGNITUDE)) {
+					const int power = tl.tok[j].value;
+					uint64_t scale = 1;
+					for (int p = 0; p < power; p++)
+						scale *= 10;
+					uint64_t value = v[0] * scale;
+					if (decimal) {
+						if (d[1] > power)
+							return false;
+						uint64_t frac_scale = 1;
+						for (int p = d[1]; p < power; p++)
+							frac_scale *= 10;
+						value += v[1] * frac_scale;
+					}
+					if (v[0] > (uint64_t(1) << ETPHT_FIELDSIZE_YEARS) / scale)
+						return false;
+					item.value = value;
+					item.digits = d[0] + power;
+					item.magnitude = true;
+					j++;
+				} else if (decimal) {
+					return false;
+				}
+				add_item(bd, item);
+			} else if (in_range) {
+				// the end of a range: only its year may be of use, e.g. 'Jan 13 - Feb 2, 1922'
+				item.value = v[n - 1];
+				item.digits = d[n - 1];
+				add_item(bd, item);
+			} else if (bd.year >= 0) {
+				// a second numeric date: probably the end of a range we didn't recognize as such.
+				bd.penalty += 20;
+			} else {
+				bool range = false;
+				if (!numeric_date(bd, v, d, sep, n, range))
+					return false;
+				if (range) {
+					// the start of the range is a candidate like any other lone number.
+					add_item(bd, item);
+					bd.qualifiers |= ETS_BIBDATE_RANGE;
+					// a year range ends it all; a day range ('13-15 January 1922') is followed by the month and year.
+					in_range = (d[0] >= 3);
+				}
+			}
+
+			have_number = true;
+			i = j;
+		}
+
+		if (tl.truncated)
+			bd.penalty += 10;
+		return true;
+	}
+
+	// Turn the collected components into a timestamp. Returns the confidence; 0 when this is not a date.
+	int resolve(eternal_timestamp_t &dst, bib_date &bd)
+	{
+		// find the item which carries the year, unless a numeric date provided it already.
+		const number_item *year = nullptr;
+		int64_t span = 1;
+		int confidence = bd.base_confidence;
+
+		if (bd.year < 0) {
+			// explicit periods win: 1920s, 19th century, 40 ka
+			for (int i = 0; i < bd.item_count && !year; i++) {
+				const number_item &it = bd.items[i];
+				if (!it.after_range && (it.period || it.magnitude || it.suffix == SUFFIX_PLURAL
+					|| it.suffix == SUFFIX_DECADE_WILDCARD || it.suffix == SUFFIX_CENTURY_WILDCARD))
+					year = &it;
+			}
+
+			if (!year) {
+				if (bd.month >= 0) {
+					// a textual date: the year is the number which cannot be a day.
+					for (int i = 0; i < bd.item_count && !year; i++) {
+						if (!bd.items[i].after_range && (bd.items[i].digits >= 3 || bd.items[i].value > 31))
+							year = &bd.items[i];
+					}
+					for (int i = 0; i < bd.item_count; i++) {
+						const number_item &it = bd.items[i];
+						if (&it == year || it.after_range)
+							continue;
+						if (bd.day < 0 && it.digits <= 2 && it.value >= 1 && it.value <= 31) {
+							bd.day = static_cast<int>(it.value);
+						} else if (!year && it.digits == 2) {
+							// 'Jan 13, 22': a two-digit year
+							year = &it;
+							confidence -= 30;
+						} else {
+							confidence -= 20;
+						}
+					}
+				} else {
+					for (int i = 0; i < bd.item_count; i++) {
+						if (bd.items[i].after_range)
+							continue;
+						if (!year)
+							year = &bd.items[i];
+						else
+							confidence -= 20;
+					}
+				}
+			}
+
+			// 'Jan 13 - Feb 2, 1922': the year is shared by both ends of the range.
+			for (int i = 0; i < bd.item_count && !year; i++) {
+				if (bd.items[i].after_range && bd.items[i].digits >= 3)
+					year = &bd.items[i];
+			}
+
+			if (year) {
+				bd.year = static_cast<int64_t>(year->value);
+				bd.year_digits = year->digits;
+
+				if (year->period) {
+					// the N-th century spans (N-1)*100+1 .. N*100
+					if (year->value < 1)
+						return 0;
+					span = year->period;
+					bd.year = static_cast<int64_t>(year->value - 1) * span + 1;
+					bd.qualifiers |= (span == 100 ? ETS_BIBDATE_CENTURY : ETS_BIBDATE_MILLENNIUM);
+					confidence = 85;
+				} else if (year->suffix == SUFFIX_PLURAL) {
+					if (year->value % 100 == 0 && year->value) {
+						// '1800s': most probably the century, but it might be the first decade of it.
+						span = 100;
+						bd.qualifiers |= ETS_BIBDATE_CENTURY;
+						confidence = 70;
+					} else if (year->value % 10 == 0) {
+						span = 10;
+						bd.qualifiers |= ETS_BIBDATE_DECADE;
+						confidence = 85;
+					} else {
+						confidence -= 20;
+					}
+				} else if (year->suffix == SUFFIX_DECADE_WILDCARD) {
+					span = 10;
+					bd.qualifiers |= ETS_BIBDATE_DECADE;
+					confidence = 85;
+				} else if (year->suffix == SUFFIX_CENTURY_WILDCARD) {
+					span = 100;
+					bd.qualifiers |= ETS_BIBDATE_CENTURY;
+					confidence = 85;
+				} else if (year->magnitude) {
+					if (bd.era == KW_UNKNOWN)
+						bd.era = KW_BP;
+					confidence = 85;
+				} else if (bd.month >= 0) {
+					confidence = (bd.day >= 0 ? 95 : 90);
+				} else {
+					confidence = 90;
+				}
+			}
+		}
+
+		if (bd.year < 0) {
+			// no year at all: '13 January' is an anomalous, yet valid, partial date; 'Spring' alone is a stretch.
+			if (bd.month < 0)
+				return 0;
+			if (bd.day >= 0 && !is_valid_day(0, false, bd.month, bd.day))
+				return 0;
+			confidence = (bd.day >= 0 ? 70 : (bd.qualifiers & ETS_BIBDATE_SEASON) ? 40 : 50);
+		} else {
+			// plausibility of the year number itself
+			if (bd.era == KW_UNKNOWN && span == 1 && !(bd.qualifiers & (ETS_BIBDATE_DECADE | ETS_BIBDATE_CENTURY))) {
+				if (bd.year_digits <= 2 || bd.year > 2999)
+					confidence -= 50;
+			}
+			if (bd.day >= 0 && !is_valid_day(bd.year, bd.era != KW_BC && bd.era != KW_BP, bd.month, bd.day)) {
+				bd.day = -1;
+				confidence -= 30;
+			}
+		}
+		if (bd.year_digits > 12)
+			return 0;
+
+		confidence -= bd.penalty;
+		if (confidence < 1)
+			confidence = 1;
+		if (confidence > 100)
+			confidence = 100;
+
+		// convert the stated year to the astronomical year number of the start of the period.
+		int64_t astro = 0;
+		int precision = 0;
+		if (bd.year >= 0) {
+			switch (bd.era) {
+			case KW_BC:
+				if (bd.year < 1)
+					return 0;
+				astro = 1 - (bd.year + span - 1);
+				break;
+
+			case KW_BP:
+				astro = 1950 - bd.year;
+				bd.qualifiers |= ETS_BIBDATE_BEFORE_PRESENT;
+				break;
+
+			default:
+				if (bd.year < 1)
+					return 0;
+				astro = bd.year;
+				break;
+			}
+
+			precision = trailing_zeros(static_cast<uint64_t>(bd.year));
+			const int span_precision = (span == 1000 ? 3 : span == 100 ? 2 : span == 10 ? 1 : 0);
+			if (precision < span_precision || span > 1)
+				precision = span_precision;
+			if (precision > 15)
+				precision = 15;
+		}
+
+		const int64_t y = astro + MODERN_EPOCH;
+		const int64_t century = (y >= 0 ? y / 100 : -1);
+		if (bd.year < 0 || (century >= 0 && century <= get_MaxInvalid(ETMT_FIELDSIZE_CENTURY) && century != get_Invalid(ETMT_FIELDSIZE_CENTURY))) {
+			eternal_timestamp_t t{0};
+			if (bd.year >= 0) {
+				t = ets_modern_set_century(t, static_cast<uint64_t>(century));
+				t = ets_modern_set_year(t, span < 100 ? FIELD_VAL_OFFSET + static_cast<uint64_t>(y % 100) : get_Invalid(ETMT_FIELDSIZE_YEAR));
+			} else {
+				t = ets_modern_set_century(t, get_Invalid(ETMT_FIELDSIZE_CENTURY));
+				t = ets_modern_set_year(t, get_Invalid(ETMT_FIELDSIZE_YEAR));
+			}
+			t = ets_modern_set_month(t, bd.month >= 0 && span < 100 ? FIELD_VAL_OFFSET - 1 + bd.month : get_Invalid(ETMT_FIELDSIZE_MONTH));
+			t = ets_modern_set_day(t, bd.day >= 0 && span < 100 ? FIELD_VAL_OFFSET - 1 + bd.day : get_Invalid(ETMT_FIELDSIZE_DAY));
+			t = ets_modern_set_hour(t, get_Invalid(ETMT_FIELDSIZE_HOUR));
+			t = ets_modern_set_minute(t, get_Invalid(ETMT_FIELDSIZE_MINUTE));
+			t = ets_modern_set_seconds(t, get_Invalid(ETMT_FIELDSIZE_SECONDS));
+			t = ets_modern_set_milliseconds(t, get_Invalid(ETMT_FIELDSIZE_MILLISECONDS));
+			t = ets_modern_set_microseconds(t, get_Invalid(ETMT_FIELDSIZE_MICROSECONDS));
+			dst = t;
+			return confidence;
+		}
+		if (century > 0) {
+			// beyond the far end of the modern range.
+			return 0;
+		}
+
+		const uint64_t years = static_cast<uint64_t>(PREHISTORIC_EPOCH - astro);
+		if (years >= (uint64_t(1) << ETPHT_FIELDSIZE_YEARS) - 1)
+			return 0;
+		eternal_timestamp_t t{0};
+		t = ets_format_set_mode(t, 1);
+		t = ets_prehistoric_set_years(t, years);
+		t = ets_prehistoric_set_precision(t, precision);
+		// month and day only make sense when we know the year exactly.
+		t = ets_prehistoric_set_month(t, bd.month >= 0 && !precision ? FIELD_VAL_OFFSET - 1 + bd.month : get_Invalid(ETPHT_FIELDSIZE_MONTH));
+		t = ets_prehistoric_set_day(t, bd.day >= 0 && !precision ? FIELD_VAL_OFFSET - 1 + bd.day : get_Invalid(ETPHT_FIELDSIZE_DAY));
+		t = ets_prehistoric_set_hour(t, get_Invalid(ETPHT_FIELDSIZE_HOUR));
+		t = ets_prehistoric_set_minute(t, get_Invalid(ETPHT_FIELDSIZE_MINUTE));
+		dst = t;
+		return confidence;
+	}
+}
+
+
+int EternalTimestampBibDate::parse(eternal_timestamp_t &dst, ets_bibdate_info_t &info, const char *str, size_t length)
+{
+	ETS_STATS_ENTRY(BIBDATE_PARSE);
+
+	// trim surrounding whitespace, so padded ISO dates take the fast path too.
+	const char *p = str;
+	const char *end = str + length;
+	while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'))
+		p++;
+	while (end > p && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r' || end[-1] == '\n'))
+		end--;
+
+	info.qualifiers = 0;
+	if (p < end && !EternalTimestamp::cvt_from_iso8601(dst, p, end - p)) {
+		info.confidence = 100;
+		return 100;
+	}
+
+	token_list tl;
+	tokenize(tl, p, end);
+
+	bib_date bd;
+	bd.item_count = 0;
+	bd.year = -1;
+	bd.year_digits = 0;
+	bd.month = -1;
+	bd.day = -1;
+	bd.base_confidence = 0;
+	bd.penalty = 0;
+	bd.qualifiers = 0;
+	bd.era = KW_UNKNOWN;
+
+	int confidence = 0;
+	if (collect(bd, tl))
+		confidence = resolve(dst, bd);
+	if (!confidence) {
+		dst = ets_make_unknown();
+		info.confidence = 0;
+		return 0;
+	}
+	info.confidence = static_cast<uint8_t>(confidence);
+	info.qualifiers = static_cast<uint8_t>(bd.qualifiers);
+	ETS_STATS_EVENT_IF(CVT_UNSPECIFIED_FIELDS, ets_has_unspecified_fields(dst));
+	return confidence;
+}
+
+size_t EternalTimestampBibDate::parse(eternal_timestamp_t *dst, ets_bibdate_info_t *info, const char *const *strings, const size_t *lengths, size_t count, unsigned int parallelism)
+{
+	ETS_STATS_ENTRY(BIBDATE_PARSE_BATCH);
+	return ets_parallel_sum(count, parallelism, [=](size_t begin, size_t end) {
+		size_t failures = 0;
+		ets_bibdate_info_t scratch;
+		for (size_t i = begin; i < end; i++) {
+			const char *s = strings[i];
+			if (!s)
+				s = "";
+			if (!parse(dst[i], (info ? info[i] : scratch), s, (lengths ? lengths[i] : strlen(s))))
+				failures++;
+		}
+		return failures;
+	});
+}
+
+size_t EternalTimestampBibDate::parse_column(eternal_timestamp_t *dst, ets_bibdate_info_t *info, const char *data, const int32_t *offsets, size_t count, unsigned int parallelism)
+{
+	ETS_STATS_ENTRY(BIBDATE_PARSE_COLUMN);
+	return ets_parallel_sum(count, parallelism, [=](size_t begin, size_t end) {
+		size_t failures = 0;
+		ets_bibdate_info_t scratch;
+		for (size_t i = begin; i < end; i++) {
+			if (!parse(dst[i], (info ? info[i] : scratch), data + offsets[i], offsets[i + 1] - offsets[i]))
+				failures++;
+		}
+		return failures;
+	});
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// C interface
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+extern "C" int ets_bibdate_parse(eternal_timestamp_t *dst, ets_bibdate_info_t *info, const char *str, size_t length)
+{
+	ets_bibdate_info_t scratch;
+	return EternalTimestampBibDate::parse(*dst, (info ? *info : scratch), str, length);
+}
+
+extern "C" size_t ets_bibdate_parse_batch(eternal_timestamp_t *dst, ets_bibdate_info_t *info, const char *const *strings, const size_t *lengths, size_t count)
+{
+	return EternalTimestampBibDate::parse(dst, info, strings, lengths, count);
+}
+
+extern "C" size_t ets_bibdate_parse_column(eternal_timestamp_t *dst, ets_bibdate_info_t *info, const char *data, const int32_t *offsets, size_t count)
+{
+	return EternalTimestampBibDate::parse_column(dst, info, data, offsets, count);
+}
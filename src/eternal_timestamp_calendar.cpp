@@ -0,0 +1,455 @@
+#include "eternal_timestamp/eternal_timestamp_calendar.h"
+
+#include "eternal_timestamp_instrumentation.h"
+#include "eternal_timestamp_internal.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ETS_HAVE_SSE2   1
+#endif
+
+
+using namespace eternal_timestamp;
+
+
+namespace
+{
+	// The 400-year cycle: an entry per year, counted from a year divisible by 400. The modern epoch (10000 B.C.)
+	// is one of those, so the year within the cycle is `(century % 4) * 100 + year`, the fields as they are.
+	enum year_flags : uint8_t
+	{
+		YEAR_JAN1_WEEKDAY = 0x07,      // the weekday of January 1st: Monday is 0
+		YEAR_LEAP = 0x08,
+		YEAR_LONG = 0x10,              // the year has 53 ISO weeks
+	};
+
+	static_assert(MODERN_EPOCH % 400 == 0, "the modern epoch must start a 400-year cycle");
+
+	struct year_table
+	{
+		uint8_t y[400];
+	};
+
+	constexpr year_table make_year_table()
+	{
+		year_table t{};
+		unsigned int wd = 5;           // 2000/jan/01 was a Saturday
+		for (unsigned int y = 0; y < 400; y++) {
+			const bool leap = (y % 4 == 0 && (y % 100 != 0 || y == 0));
+			// a year has 53 ISO weeks when it starts on a Thursday, or on a Wednesday in leap years
+			const bool long_year = (wd == 3 || (leap && wd == 2));
+			t.y[y] = static_cast<uint8_t>(wd | (leap ? YEAR_LEAP : 0) | (long_year ? YEAR_LONG : 0));
+			wd = (wd + (leap ? 366 : 365)) % 7;
+		}
+		return t;
+	}
+
+	constexpr year_table YEARS = make_year_table();
+
+	static_assert((YEARS.y[4] & YEAR_LONG) && (YEARS.y[20] & YEAR_LONG) && !(YEARS.y[21] & YEAR_LONG), "2004 and 2020 have 53 ISO weeks, 2021 has 52");
+
+	// The days before the 1st of each month, [leap][month], month 1..12.
+	constexpr uint16_t DAYS_BEFORE[2][13] = {
+		{ 0, 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334 },
+		{ 0, 0, 31, 60, 91, 121, 152, 182, 213, 244, 274, 305, 335 },
+	};
+
+	// The date fields of a timestamp, as values.
+	struct date_fields
+	{
+		unsigned int cycle_year;       // within the 400-year cycle
+		unsigned int month;            // 1..12
+		unsigned int day;              // 1..31
+	};
+
+	// Returns `false` when `t` has no complete modern date. Dates are taken as given: the library's own
+	// constructors won't produce a February 30th, which counts as March 1st or 2nd here.
+	inline bool decode(date_fields &f, const eternal_timestamp_t t)
+	{
+		if (!ets_has_complete_modern_date(t))
+			return false;
+		const unsigned int year = static_cast<unsigned int>(ets_modern_year(t)) - FIELD_VAL_OFFSET;
+		f.month = static_cast<unsigned int>(ets_modern_month(t)) + 1 - FIELD_VAL_OFFSET;
+		f.day = static_cast<unsigned int>(ets_modern_day(t)) + 1 - FIELD_VAL_OFFSET;
+		f.cycle_year = static_cast<unsigned int>(ets_modern_century(t) % 4) * 100 + year;
+		return year < 100 && f.month <= 12;
+	}
+
+	// The astronomical year of a timestamp which passed `decode()`.
+	inline int32_t full_year(const eternal_timestamp_t t)
+	{
+		return static_cast<int32_t>(ets_modern_century(t) * 100 + ets_modern_year(t)) - FIELD_VAL_OFFSET - MODERN_EPOCH;
+	}
+
+	inline unsigned int day_of_year_of(const date_fields &f)
+	{
+		return DAYS_BEFORE[(YEARS.y[f.cycle_year] & YEAR_LEAP) != 0][f.month] + f.day;
+	}
+
+	// Monday is 0.
+	inline unsigned int weekday_of(const date_fields &f, unsigned int doy)
+	{
+		return ((YEARS.y[f.cycle_year] & YEAR_JAN1_WEEKDAY) + doy - 1) % 7;
+	}
+
+	// The ISO week; `year_shift` is -1, 0 or 1, as the week belongs to the previous, this or the next year.
+	inline unsigned int iso_week_of(const date_fields &f, int &year_shift)
+	{
+		const unsigned int doy = day_of_year_of(f);
+		const unsigned int week = (doy - weekday_of(f, doy) + 9) / 7;
+		year_shift = 0;
+		if (week == 0) {
+			year_shift = -1;
+			return (YEARS.y[(f.cycle_year + 399) % 400] & YEAR_LONG ? 53 : 52);
+		}
+		if (week == 53 && !(YEARS.y[f.cycle_year] & YEAR_LONG)) {
+			year_shift = 1;
+			return 1;
+		}
+		return week;
+	}
+
+	inline unsigned int quarter_of(const eternal_timestamp_t t)
+	{
+		const unsigned int code = static_cast<unsigned int>(ets_format_mode(t) ? ets_prehistoric_month(t) : ets_modern_month(t));
+		const unsigned int month = code + 1 - FIELD_VAL_OFFSET;
+		if (code == get_Invalid(ETMT_FIELDSIZE_MONTH) || month > 12)
+			return ETS_CALENDAR_UNSPECIFIED;
+		return (month + 2) / 3;
+	}
+
+	static_assert(ETMT_FIELDSIZE_MONTH == ETPHT_FIELDSIZE_MONTH, "both subformats must mark an unspecified month alike");
+
+	inline unsigned int count_bits(unsigned int x)
+	{
+		unsigned int n = 0;
+		for (; x; x &= x - 1)
+			n++;
+		return n;
+	}
+
+	size_t weekdays_scalar(uint8_t *dst, const eternal_timestamp_t *src, size_t begin, size_t end)
+	{
+		size_t failed = 0;
+		for (size_t i = begin; i < end; i++) {
+			date_fields f;
+			if (decode(f, src[i])) {
+				dst[i] = static_cast<uint8_t>(weekday_of(f, day_of_year_of(f)) + 1);
+			}
+			else {
+				dst[i] = ETS_CALENDAR_UNSPECIFIED;
+				failed++;
+			}
+		}
+		return failed;
+	}
+
+	void count_weekdays_scalar(uint64_t counts[8], const eternal_timestamp_t *src, size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++) {
+			date_fields f;
+			counts[decode(f, src[i]) ? weekday_of(f, day_of_year_of(f)) + 1 : ETS_CALENDAR_UNSPECIFIED]++;
+		}
+	}
+
+#if defined(ETS_HAVE_SSE2)
+
+	// The SSE2 kernels do 8 values per round, without the tables: all date fields sit in the low 32 bits of the
+	// timestamps, which are taken apart in 32-bit lanes and then packed into 16-bit lanes, where the weekday is
+	// computed the way `ets_days_from_civil()` counts days, modulo 7. The divisions by constants are
+	// multiplications, exact for the ranges at hand (the tests go through all dates of the 400-year cycle).
+	static_assert(ETMT_DAY_SHIFT + ETMT_DAY_BITS <= 32, "the date fields must sit in the low 32 bits");
+
+	// The low halves of 4 timestamps.
+	inline __m128i low_halves(const eternal_timestamp_t *src)
+	{
+		const __m128 a = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src)));
+		const __m128 b = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 2)));
+		return _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+	}
+
+	// A field of 8 timestamps, in 16-bit lanes.
+	template <unsigned int SHIFT, unsigned int BITS>
+	inline __m128i field_epi16(__m128i lo0, __m128i lo1)
+	{
+		const __m128i mask = _mm_set1_epi32((1 << BITS) - 1);
+		return _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(lo0, SHIFT), mask), _mm_and_si128(_mm_srli_epi32(lo1, SHIFT), mask));
+	}
+
+	inline __m128i set1_16(int x)
+	{
+		return _mm_set1_epi16(static_cast<short>(x));
+	}
+
+	// The ISO weekdays of 8 timestamps in 16-bit lanes, `ETS_CALENDAR_UNSPECIFIED` where there is none.
+	inline __m128i weekdays_x8(const eternal_timestamp_t *src)
+	{
+		const __m128i lo0 = low_halves(src);
+		const __m128i lo1 = low_halves(src + 4);
+		const __m128i mode = field_epi16<ETS_MODE_SHIFT, ETS_MODE_BITS>(lo0, lo1);
+		const __m128i c = field_epi16<ETMT_CENTURY_SHIFT, ETMT_CENTURY_BITS>(lo0, lo1);
+		const __m128i y = field_epi16<ETMT_YEAR_SHIFT, ETMT_YEAR_BITS>(lo0, lo1);
+		const __m128i m = field_epi16<ETMT_MONTH_SHIFT, ETMT_MONTH_BITS>(lo0, lo1);
+		const __m128i d = field_epi16<ETMT_DAY_SHIFT, ETMT_DAY_BITS>(lo0, lo1);
+
+		// the values: year 0..99, month 1..12, day 1..31
+		const __m128i year = _mm_sub_epi16(y, set1_16(FIELD_VAL_OFFSET));
+		const __m128i month = _mm_add_epi16(m, set1_16(1 - FIELD_VAL_OFFSET));
+		const __m128i day = _mm_add_epi16(d, set1_16(1 - FIELD_VAL_OFFSET));
+
+		__m128i bad = _mm_or_si128(_mm_cmpeq_epi16(mode, set1_16(1)), _mm_cmpeq_epi16(c, set1_16(get_Invalid(ETMT_FIELDSIZE_CENTURY))));
+		bad = _mm_or_si128(bad, _mm_or_si128(_mm_cmpeq_epi16(y, set1_16(get_Invalid(ETMT_FIELDSIZE_YEAR))), _mm_cmpgt_epi16(year, set1_16(99))));
+		bad = _mm_or_si128(bad, _mm_or_si128(_mm_cmpeq_epi16(m, set1_16(get_Invalid(ETMT_FIELDSIZE_MONTH))), _mm_cmpgt_epi16(month, set1_16(12))));
+		bad = _mm_or_si128(bad, _mm_cmpeq_epi16(d, set1_16(get_Invalid(ETMT_FIELDSIZE_DAY))));
+
+		// years start in March, so February 29th is the last day of the year; 400 years on, so y' is positive:
+		// y' = year in the cycle + 400 - (month <= 2), 399..799; mp = months since March, 0..11
+		const __m128i early = _mm_cmplt_epi16(month, set1_16(3));
+		const __m128i cycle_year = _mm_add_epi16(_mm_mullo_epi16(_mm_and_si128(c, set1_16(3)), set1_16(100)), year);
+		const __m128i yp = _mm_add_epi16(_mm_add_epi16(cycle_year, set1_16(400)), early);
+		const __m128i mp = _mm_add_epi16(_mm_sub_epi16(month, set1_16(3)), _mm_and_si128(early, set1_16(12)));
+
+		// 365 = 1 (mod 7): s = y' + y'/4 - y'/100 + y'/400 + (153 * mp + 2)/5 + day + 1, where the 1 makes
+		// Mondays come out as 0. y'/100 = (y' * 656) >> 16, x/5 = (x * 13108) >> 16 within these ranges.
+		__m128i s = _mm_add_epi16(yp, _mm_srli_epi16(yp, 2));
+		s = _mm_sub_epi16(s, _mm_mulhi_epu16(yp, set1_16(656)));
+		s = _mm_sub_epi16(s, _mm_cmpgt_epi16(yp, set1_16(399)));
+		s = _mm_add_epi16(s, _mm_mulhi_epu16(_mm_add_epi16(_mm_mullo_epi16(mp, set1_16(153)), set1_16(2)), set1_16(13108)));
+		s = _mm_add_epi16(s, _mm_add_epi16(day, set1_16(1)));
+
+		// s % 7, with s / 7 = (s * 9363) >> 16 for s < 2000
+		const __m128i q = _mm_mulhi_epu16(s, set1_16(9363));
+		const __m128i wd = _mm_sub_epi16(s, _mm_sub_epi16(_mm_slli_epi16(q, 3), q));
+		return _mm_andnot_si128(bad, _mm_add_epi16(wd, set1_16(1)));
+	}
+
+	size_t weekdays_sse2(uint8_t *dst, const eternal_timestamp_t *src, size_t count)
+	{
+		size_t failed = 0;
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8) {
+			const __m128i wd = weekdays_x8(src + i);
+			const __m128i none = _mm_cmpeq_epi16(wd, _mm_setzero_si128());
+			failed += count_bits(static_cast<unsigned int>(_mm_movemask_epi8(_mm_packs_epi16(none, none))) & 0xFF);
+			_mm_storel_epi64(reinterpret_cast<__m128i *>(dst + i), _mm_packus_epi16(wd, wd));
+		}
+		return failed + weekdays_scalar(dst, src, i, count);
+	}
+
+	// The histogram keeps a 16-bit counter per weekday and lane, so it moves those to `counts` every so many rounds.
+	const size_t COUNT_ROUNDS = 4096;
+
+	inline uint64_t sum_epi16(__m128i x)
+	{
+		x = _mm_madd_epi16(x, _mm_set1_epi16(1));
+		x = _mm_add_epi32(x, _mm_shuffle_epi32(x, _MM_SHUFFLE(1, 0, 3, 2)));
+		x = _mm_add_epi32(x, _mm_shuffle_epi32(x, _MM_SHUFFLE(2, 3, 0, 1)));
+		return static_cast<uint32_t>(_mm_cvtsi128_si32(x));
+	}
+
+	void count_weekdays_sse2(uint64_t counts[8], const eternal_timestamp_t *src, size_t count)
+	{
+		size_t i = 0;
+		while (i + 8 <= count) {
+			__m128i a0 = _mm_setzero_si128(), a1 = a0, a2 = a0, a3 = a0, a4 = a0, a5 = a0, a6 = a0, a7 = a0;
+			for (size_t rounds = 0; rounds < COUNT_ROUNDS && i + 8 <= count; rounds++, i += 8) {
+				const __m128i wd = weekdays_x8(src + i);
+				a0 = _mm_sub_epi16(a0, _mm_cmpeq_epi16(wd, set1_16(0)));
+				a1 = _mm_sub_epi16(a1, _mm_cmpeq_epi16(wd, set1_16(1)));
+				a2 = _mm_sub_epi16(a2, _mm_cmpeq_epi16(wd, set1_16(2)));
+				a3 = _mm_sub_epi16(a3, _mm_cmpeq_epi16(wd, set1_16(3)));
+				a4 = _mm_sub_epi16(a4, _mm_cmpeq_epi16(wd, set1_16(4)));
+				a5 = _mm_sub_epi16(a5, _mm_cmpeq_epi16(wd, set1_16(5)));
+				a6 = _mm_sub_epi16(a6, _mm_cmpeq_epi16(wd, set1_16(6)));
+				a7 = _mm_sub_epi16(a7, _mm_cmpeq_epi16(wd, set1_16(7)));
+			}
+			counts[0] += sum_epi16(a0);
+			counts[1] += sum_epi16(a1);
+			counts[2] += sum_epi16(a2);
+			counts[3] += sum_epi16(a3);
+			counts[4] += sum_epi16(a4);
+			counts[5] += sum_epi16(a5);
+			counts[6] += sum_epi16(a6);
+			counts[7] += sum_epi16(a7);
+		}
+		count_weekdays_scalar(counts, src, i, count);
+	}
+
+#endif // ETS_HAVE_SSE2
+
+	size_t weekdays_kernel(uint8_t *dst, const eternal_timestamp_t *src, size_t count)
+	{
+#if defined(ETS_HAVE_SSE2)
+		return weekdays_sse2(dst, src, count);
+#else
+		return weekdays_scalar(dst, src, 0, count);
+#endif
+	}
+
+	void count_weekdays_kernel(uint64_t counts[8], const eternal_timestamp_t *src, size_t count)
+	{
+#if defined(ETS_HAVE_SSE2)
+		count_weekdays_sse2(counts, src, count);
+#else
+		count_weekdays_scalar(counts, src, 0, count);
+#endif
+	}
+}
+
+
+int EternalTimestampCalendar::weekday(const eternal_timestamp_t t)
+{
+	date_fields f;
+	if (!decode(f, t))
+		return ETS_CALENDAR_UNSPECIFIED;
+	return static_cast<int>(weekday_of(f, day_of_year_of(f)) + 1);
+}
+
+int EternalTimestampCalendar::day_of_year(const eternal_timestamp_t t)
+{
+	date_fields f;
+	if (!decode(f, t))
+		return ETS_CALENDAR_UNSPECIFIED;
+	return static_cast<int>(day_of_year_of(f));
+}
+
+int EternalTimestampCalendar::iso_week(const eternal_timestamp_t t, int32_t *iso_year)
+{
+	date_fields f;
+	if (!decode(f, t))
+		return ETS_CALENDAR_UNSPECIFIED;
+	int shift;
+	const unsigned int week = iso_week_of(f, shift);
+	if (iso_year)
+		*iso_year = full_year(t) + shift;
+	return static_cast<int>(week);
+}
+
+int EternalTimestampCalendar::quarter(const eternal_timestamp_t t)
+{
+	return static_cast<int>(quarter_of(t));
+}
+
+size_t EternalTimestampCalendar::calc_weekdays(uint8_t *dst, const eternal_timestamp_t *src, size_t count, unsigned int parallelism)
+{
+	ETS_STATS_ENTRY(CALENDAR_CALC_WEEKDAYS);
+	return ets_parallel_sum(count, parallelism, [=](size_t begin, size_t end) {
+		return weekdays_kernel(dst + begin, src + begin, end - begin);
+	});
+}
+
+size_t EternalTimestampCalendar::calc_days_of_year(uint16_t *dst, const eternal_timestamp_t *src, size_t count, unsigned int parallelism)
+{
+	ETS_STATS_ENTRY(CALENDAR_CALC_DAYS_OF_YEAR);
+	return ets_parallel_sum(count, parallelism, [=](size_t begin, size_t end) {
+		size_t failed = 0;
+		for (size_t i = begin; i < end; i++) {
+			date_fields f;
+			const bool ok = decode(f, src[i]);
+			dst[i] = static_cast<uint16_t>(ok ? day_of_year_of(f) : ETS_CALENDAR_UNSPECIFIED);
+			failed += !ok;
+		}
+		return failed;
+	});
+}
+
+size_t EternalTimestampCalendar::calc_quarters(uint8_t *dst, const eternal_timestamp_t *src, size_t count, unsigned int parallelism)
+{
+	ETS_STATS_ENTRY(CALENDAR_CALC_QUARTERS);
+	return ets_parallel_sum(count, parallelism, [=](size_t begin, size_t end) {
+		size_t failed = 0;
+		for (size_t i = begin; i < end; i++) {
+			dst[i] = static_cast<uint8_t>(quarter_of(src[i]));
+			failed += (dst[i] == ETS_CALENDAR_UNSPECIFIED);
+		}
+		return failed;
+	});
+}
+
+size_t EternalTimestampCalendar::calc_iso_weeks(uint8_t *weeks, int32_t *iso_years, const eternal_timestamp_t *src, size_t count, unsigned int parallelism)
+{
+	ETS_STATS_ENTRY(CALENDAR_CALC_ISO_WEEKS);
+	return ets_parallel_sum(count, parallelism, [=](size_t begin, size_t end) {
+		size_t failed = 0;
+		for (size_t i = begin; i < end; i++) {
+			date_fields f;
+			int shift = 0;
+			const bool ok = decode(f, src[i]);
+			weeks[i] = static_cast<uint8_t>(ok ? iso_week_of(f, shift) : ETS_CALENDAR_UNSPECIFIED);
+			if (iso_years)
+				iso_years[i] = (ok ? full_year(src[i]) + shift : 0);
+			failed += !ok;
+		}
+		return failed;
+	});
+}
+
+void EternalTimestampCalendar::count_weekdays(uint64_t counts[8], const eternal_timestamp_t *src, size_t count, unsigned int parallelism)
+{
+	ETS_STATS_ENTRY(CALENDAR_COUNT_WEEKDAYS);
+	std::atomic<uint64_t> sums[8];
+	for (auto &sum : sums)
+		sum.store(0, std::memory_order_relaxed);
+
+	EternalTimestampParallel::parallel_for(count, ETS_PARALLEL_GRAIN, parallelism, [&](size_t begin, size_t end) {
+		uint64_t local[8] = { 0 };
+		count_weekdays_kernel(local, src + begin, end - begin);
+		for (unsigned int k = 0; k < 8; k++) {
+			if (local[k])
+				sums[k].fetch_add(local[k], std::memory_order_relaxed);
+		}
+	});
+
+	for (unsigned int k = 0; k < 8; k++)
+		counts[k] = sums[k].load(std::memory_order_relaxed);
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// C interface
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+extern "C" int ets_calendar_weekday(const eternal_timestamp_t t)
+{
+	return EternalTimestampCalendar::weekday(t);
+}
+
+extern "C" int ets_calendar_day_of_year(const eternal_timestamp_t t)
+{
+	return EternalTimestampCalendar::day_of_year(t);
+}
+
+extern "C" int ets_calendar_iso_week(const eternal_timestamp_t t, int32_t *iso_year)
+{
+	return EternalTimestampCalendar::iso_week(t, iso_year);
+}
+
+extern "C" int ets_calendar_quarter(const eternal_timestamp_t t)
+{
+	return EternalTimestampCalendar::quarter(t);
+}
+
+extern "C" size_t ets_calendar_calc_weekdays(uint8_t *dst, const eternal_timestamp_t *src, size_t count)
+{
+	return EternalTimestampCalendar::calc_weekdays(dst, src, count);
+}
+
+extern "C" size_t ets_calendar_calc_days_of_year(uint16_t *dst, const eternal_timestamp_t *src, size_t count)
+{
+	return EternalTimestampCalendar::calc_days_of_year(dst, src, count);
+}
+
+extern "C" size_t ets_calendar_calc_quarters(uint8_t *dst, const eternal_timestamp_t *src, size_t count)
+{
+	return EternalTimestampCalendar::calc_quarters(dst, src, count);
+}
+
+extern "C" size_t ets_calendar_calc_iso_weeks(uint8_t *weeks, int32_t *iso_years, const eternal_timestamp_t *src, size_t count)
+{
+	return EternalTimestampCalendar::calc_iso_weeks(weeks, iso_years, src, count);
+}
+
+extern "C" void ets_calendar_count_weekdays(uint64_t counts[8], const eternal_timestamp_t *src, size_t count)
+{
+	EternalTimestampCalendar::count_weekdays(counts, src, count);
+}
@@ -0,0 +1,607 @@
+
+#include "eternal_timestamp/eternal_timestamp_compact.h"
+
+#include "eternal_timestamp_instrumentation.h"
+#include "eternal_timestamp_internal.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ETS_HAVE_SSE2   1
+#endif
+
+
+using namespace eternal_timestamp;
+
+
+namespace
+{
+	// The batch kernels work on the raw 64-bit pattern of the modern subformat, as described by the native layout;
+	// the field accessors use the same shifts and masks.
+	typedef ets_native_layout::modern native;
+
+	constexpr unsigned int POS_CENTURY = native::century::offset;
+	constexpr unsigned int POS_YEAR = native::year::offset;
+	constexpr unsigned int POS_MONTH = native::month::offset;
+	constexpr unsigned int POS_DAY = native::day::offset;
+	constexpr unsigned int POS_HOUR = native::hour::offset;
+	constexpr unsigned int POS_MINUTE = native::minute::offset;
+	constexpr unsigned int POS_SECONDS = native::seconds::offset;
+	constexpr unsigned int POS_MILLISECONDS = native::milliseconds::offset;
+	constexpr unsigned int POS_MICROSECONDS = native::microseconds::offset;
+
+	static_assert(POS_YEAR == POS_CENTURY + ETMT_FIELDSIZE_CENTURY && POS_MONTH == POS_YEAR + ETMT_FIELDSIZE_YEAR && POS_DAY == POS_MONTH + ETMT_FIELDSIZE_MONTH
+		&& POS_HOUR == POS_DAY + ETMT_FIELDSIZE_DAY && POS_MINUTE == POS_HOUR + ETMT_FIELDSIZE_HOUR && POS_SECONDS == POS_MINUTE + ETMT_FIELDSIZE_MINUTE
+		&& POS_MILLISECONDS == POS_SECONDS + ETMT_FIELDSIZE_SECONDS && POS_MICROSECONDS == POS_MILLISECONDS + ETMT_FIELDSIZE_MILLISECONDS
+		&& POS_MICROSECONDS + ETMT_FIELDSIZE_MICROSECONDS == 64, "the kernels expect the fields in ascending order, microseconds at the top");
+
+	// The field positions in the narrow forms; bit 0 is the flag.
+	constexpr unsigned int D32_DAY = 1;
+	constexpr unsigned int D32_MONTH = D32_DAY + ETMT_FIELDSIZE_DAY;
+	constexpr unsigned int D32_YEAR = D32_MONTH + ETMT_FIELDSIZE_MONTH;
+	constexpr unsigned int D32_CENTURY = D32_YEAR + ETMT_FIELDSIZE_YEAR;
+	constexpr unsigned int D32_BITS = D32_CENTURY + ETMT_FIELDSIZE_CENTURY;
+
+	constexpr unsigned int D48_SECONDS = 1;
+	constexpr unsigned int D48_MINUTE = D48_SECONDS + ETMT_FIELDSIZE_SECONDS;
+	constexpr unsigned int D48_HOUR = D48_MINUTE + ETMT_FIELDSIZE_MINUTE;
+	constexpr unsigned int D48_DAY = D48_HOUR + ETMT_FIELDSIZE_HOUR;
+	constexpr unsigned int D48_MONTH = D48_DAY + ETMT_FIELDSIZE_DAY;
+	constexpr unsigned int D48_YEAR = D48_MONTH + ETMT_FIELDSIZE_MONTH;
+	constexpr unsigned int D48_CENTURY = D48_YEAR + ETMT_FIELDSIZE_YEAR;
+	constexpr unsigned int D48_BITS = D48_CENTURY + ETMT_FIELDSIZE_CENTURY;
+
+	static_assert(D32_BITS <= 32 && D48_BITS <= 48, "the narrow forms must fit");
+	static_assert(POS_HOUR <= 32, "the date fields must sit in the low 32 bits");
+
+	constexpr uint64_t FORMAT_BITS = ~native::mask;                   // sign, mode
+	constexpr uint64_t TIME_BITS = ~0ULL << POS_HOUR;
+	constexpr uint64_t SUBSECOND_BITS = ~0ULL << POS_MILLISECONDS;
+
+	constexpr uint64_t unspecified(unsigned int width, unsigned int pos)
+	{
+		return static_cast<uint64_t>(get_Invalid(width)) << pos;
+	}
+
+	constexpr uint64_t zero(unsigned int pos)
+	{
+		return static_cast<uint64_t>(FIELD_VAL_OFFSET) << pos;
+	}
+
+	constexpr uint64_t SUBSECOND_UNSPECIFIED = unspecified(ETMT_FIELDSIZE_MILLISECONDS, POS_MILLISECONDS) | unspecified(ETMT_FIELDSIZE_MICROSECONDS, POS_MICROSECONDS);
+	constexpr uint64_t TIME_UNSPECIFIED = unspecified(ETMT_FIELDSIZE_HOUR, POS_HOUR) | unspecified(ETMT_FIELDSIZE_MINUTE, POS_MINUTE) | unspecified(ETMT_FIELDSIZE_SECONDS, POS_SECONDS) | SUBSECOND_UNSPECIFIED;
+	constexpr uint64_t SUBSECOND_ZERO = zero(POS_MILLISECONDS) | zero(POS_MICROSECONDS);
+	constexpr uint64_t TIME_ZERO = zero(POS_HOUR) | zero(POS_MINUTE) | zero(POS_SECONDS) | SUBSECOND_ZERO;
+
+	// The timestamp with all fields 'unspecified', produced by failing widenings.
+	constexpr uint64_t UNKNOWN = unspecified(ETMT_FIELDSIZE_CENTURY, POS_CENTURY) | unspecified(ETMT_FIELDSIZE_YEAR, POS_YEAR) | unspecified(ETMT_FIELDSIZE_MONTH, POS_MONTH) | unspecified(ETMT_FIELDSIZE_DAY, POS_DAY) | TIME_UNSPECIFIED;
+
+	// What the dropped fields hold with the flag clear and set: whichever sorts first goes with the clear flag.
+	constexpr bool UNSPECIFIED_FIRST = (get_Invalid(ETMT_FIELDSIZE_HOUR) == 0);
+	constexpr uint64_t D32_DROPPED[2] = { UNSPECIFIED_FIRST ? TIME_UNSPECIFIED : TIME_ZERO, UNSPECIFIED_FIRST ? TIME_ZERO : TIME_UNSPECIFIED };
+	constexpr uint64_t D48_DROPPED[2] = { UNSPECIFIED_FIRST ? SUBSECOND_UNSPECIFIED : SUBSECOND_ZERO, UNSPECIFIED_FIRST ? SUBSECOND_ZERO : SUBSECOND_UNSPECIFIED };
+	constexpr unsigned int FLAG_FOR_ZERO = (UNSPECIFIED_FIRST ? 1 : 0);
+
+	// Move the `WIDTH`-bit field at bit `FROM` to bit `TO`.
+	template <unsigned int FROM, unsigned int WIDTH, unsigned int TO>
+	constexpr uint64_t move_field(uint64_t x)
+	{
+		return ((x >> FROM) & ((1ULL << WIDTH) - 1)) << TO;
+	}
+
+	// The fields only: the flag and the validity checks are up to the callers.
+	inline uint64_t raw_narrow_date32(uint64_t t)
+	{
+		return move_field<POS_DAY, ETMT_FIELDSIZE_DAY, D32_DAY>(t)
+			| move_field<POS_MONTH, ETMT_FIELDSIZE_MONTH, D32_MONTH>(t)
+			| move_field<POS_YEAR, ETMT_FIELDSIZE_YEAR, D32_YEAR>(t)
+			| move_field<POS_CENTURY, ETMT_FIELDSIZE_CENTURY, D32_CENTURY>(t);
+	}
+
+	inline uint64_t raw_widen_date32(uint64_t v)
+	{
+		return move_field<D32_DAY, ETMT_FIELDSIZE_DAY, POS_DAY>(v)
+			| move_field<D32_MONTH, ETMT_FIELDSIZE_MONTH, POS_MONTH>(v)
+			| move_field<D32_YEAR, ETMT_FIELDSIZE_YEAR, POS_YEAR>(v)
+			| move_field<D32_CENTURY, ETMT_FIELDSIZE_CENTURY, POS_CENTURY>(v);
+	}
+
+	inline uint64_t raw_narrow_datetime48(uint64_t t)
+	{
+		return move_field<POS_SECONDS, ETMT_FIELDSIZE_SECONDS, D48_SECONDS>(t)
+			| move_field<POS_MINUTE, ETMT_FIELDSIZE_MINUTE, D48_MINUTE>(t)
+			| move_field<POS_HOUR, ETMT_FIELDSIZE_HOUR, D48_HOUR>(t)
+			| move_field<POS_DAY, ETMT_FIELDSIZE_DAY, D48_DAY>(t)
+			| move_field<POS_MONTH, ETMT_FIELDSIZE_MONTH, D48_MONTH>(t)
+			| move_field<POS_YEAR, ETMT_FIELDSIZE_YEAR, D48_YEAR>(t)
+			| move_field<POS_CENTURY, ETMT_FIELDSIZE_CENTURY, D48_CENTURY>(t);
+	}
+
+	inline uint64_t raw_widen_datetime48(uint64_t v)
+	{
+		return move_field<D48_SECONDS, ETMT_FIELDSIZE_SECONDS, POS_SECONDS>(v)
+			| move_field<D48_MINUTE, ETMT_FIELDSIZE_MINUTE, POS_MINUTE>(v)
+			| move_field<D48_HOUR, ETMT_FIELDSIZE_HOUR, POS_HOUR>(v)
+			| move_field<D48_DAY, ETMT_FIELDSIZE_DAY, POS_DAY>(v)
+			| move_field<D48_MONTH, ETMT_FIELDSIZE_MONTH, POS_MONTH>(v)
+			| move_field<D48_YEAR, ETMT_FIELDSIZE_YEAR, POS_YEAR>(v)
+			| move_field<D48_CENTURY, ETMT_FIELDSIZE_CENTURY, POS_CENTURY>(v);
+	}
+
+	inline void store_datetime48(ets_datetime48_t &dst, uint64_t v)
+	{
+		for (int i = 5; i >= 0; i--) {
+			dst.bytes[i] = static_cast<uint8_t>(v);
+			v >>= 8;
+		}
+	}
+
+	inline void set_validity(uint8_t *validity, size_t i, bool valid)
+	{
+		if (!validity)
+			return;
+		const uint8_t bit = static_cast<uint8_t>(1u << (i % 8));
+		if (valid)
+			validity[i / 8] |= bit;
+		else
+			validity[i / 8] &= static_cast<uint8_t>(~bit);
+	}
+
+	inline unsigned int count_bits(unsigned int x)
+	{
+		unsigned int n = 0;
+		for (; x; x &= x - 1)
+			n++;
+		return n;
+	}
+
+	// The one-value-at-a-time kernels: the tails of the vector kernels, and everything without SSE2.
+	size_t narrow_date32_scalar(ets_date32_t *dst, uint8_t *validity, const eternal_timestamp_t *src, size_t begin, size_t end)
+	{
+		size_t failed = 0;
+		for (size_t i = begin; i < end; i++) {
+			const uint64_t dropped = src[i].t & (TIME_BITS | FORMAT_BITS);
+			const bool flag = (dropped == D32_DROPPED[1]);
+			const bool ok = (flag || dropped == D32_DROPPED[0]);
+			dst[i] = (ok ? static_cast<ets_date32_t>(raw_narrow_date32(src[i].t) | flag) : 0);
+			failed += !ok;
+			set_validity(validity, i, ok);
+		}
+		return failed;
+	}
+
+	size_t widen_date32_scalar(eternal_timestamp_t *dst, uint8_t *validity, const ets_date32_t *src, size_t begin, size_t end)
+	{
+		size_t failed = 0;
+		for (size_t i = begin; i < end; i++) {
+			const bool ok = !(src[i] >> D32_BITS);
+			dst[i].t = (ok ? raw_widen_date32(src[i]) | D32_DROPPED[src[i] & 1] : UNKNOWN);
+			failed += !ok;
+			set_validity(validity, i, ok);
+		}
+		return failed;
+	}
+
+	size_t narrow_datetime48_scalar(ets_datetime48_t *dst, uint8_t *validity, const eternal_timestamp_t *src, size_t begin, size_t end)
+	{
+		size_t failed = 0;
+		for (size_t i = begin; i < end; i++) {
+			const uint64_t dropped = src[i].t & (SUBSECOND_BITS | FORMAT_BITS);
+			const bool flag = (dropped == D48_DROPPED[1]);
+			const bool ok = (flag || dropped == D48_DROPPED[0]);
+			store_datetime48(dst[i], ok ? raw_narrow_datetime48(src[i].t) | flag : 0);
+			failed += !ok;
+			set_validity(validity, i, ok);
+		}
+		return failed;
+	}
+
+	size_t widen_datetime48_scalar(eternal_timestamp_t *dst, uint8_t *validity, const ets_datetime48_t *src, size_t begin, size_t end)
+	{
+		size_t failed = 0;
+		for (size_t i = begin; i < end; i++) {
+			const uint64_t v = ets_datetime48_value(src[i]);
+			const bool ok = !(v >> D48_BITS);
+			dst[i].t = (ok ? raw_widen_datetime48(v) | D48_DROPPED[v & 1] : UNKNOWN);
+			failed += !ok;
+			set_validity(validity, i, ok);
+		}
+		return failed;
+	}
+
+#if defined(ETS_HAVE_SSE2)
+
+	// The SSE2 kernels do 8 values per round, so each round fills one validity byte.
+
+	template <unsigned int FROM, unsigned int WIDTH, unsigned int TO>
+	inline __m128i move_field_epi32(__m128i x)
+	{
+		const __m128i mask = _mm_set1_epi32(static_cast<int>(((1U << WIDTH) - 1) << TO));
+		if (FROM >= TO)
+			return _mm_and_si128(_mm_srli_epi32(x, static_cast<int>(FROM - TO)), mask);
+		return _mm_and_si128(_mm_slli_epi32(x, static_cast<int>(TO - FROM)), mask);
+	}
+
+	template <unsigned int FROM, unsigned int WIDTH, unsigned int TO>
+	inline __m128i move_field_epi64(__m128i x)
+	{
+		const __m128i mask = _mm_set1_epi64x(static_cast<long long>(((1ULL << WIDTH) - 1) << TO));
+		if (FROM >= TO)
+			return _mm_and_si128(_mm_srli_epi64(x, static_cast<int>(FROM - TO)), mask);
+		return _mm_and_si128(_mm_slli_epi64(x, static_cast<int>(TO - FROM)), mask);
+	}
+
+	inline __m128i set1_64(uint64_t x)
+	{
+		return _mm_set1_epi64x(static_cast<long long>(x));
+	}
+
+	inline __m128i set1_lo32(uint64_t x)
+	{
+		return _mm_set1_epi32(static_cast<int>(static_cast<uint32_t>(x)));
+	}
+
+	inline __m128i set1_hi32(uint64_t x)
+	{
+		return _mm_set1_epi32(static_cast<int>(static_cast<uint32_t>(x >> 32)));
+	}
+
+	// Lanes of 32-bit all-ones/all-zeroes which tell equality, widened to the 64-bit lanes.
+	inline __m128i all_of_epi64(__m128i eq32)
+	{
+		return _mm_and_si128(eq32, _mm_shuffle_epi32(eq32, _MM_SHUFFLE(2, 3, 0, 1)));
+	}
+
+	// `a` where `mask` is all-ones, `b` where it's zero.
+	inline __m128i select(__m128i mask, __m128i a, __m128i b)
+	{
+		return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+	}
+
+	// Reverse the bytes of each 64-bit lane.
+	inline __m128i byteswap_epi64(__m128i x)
+	{
+		x = _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+		x = _mm_shufflelo_epi16(x, _MM_SHUFFLE(0, 1, 2, 3));
+		return _mm_shufflehi_epi16(x, _MM_SHUFFLE(0, 1, 2, 3));
+	}
+
+	// 4 timestamps: their date fields, all in the low halves, narrowed side by side.
+	inline __m128i narrow_date32_x4(const eternal_timestamp_t *src, unsigned int &valid)
+	{
+		const __m128 a = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src)));
+		const __m128 b = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 2)));
+		const __m128i lo = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+		const __m128i hi = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+		const __m128i dropped_lo = _mm_and_si128(lo, set1_lo32(TIME_BITS | FORMAT_BITS));
+		const __m128i dropped_hi = _mm_and_si128(hi, set1_hi32(TIME_BITS | FORMAT_BITS));
+		const __m128i clear = _mm_and_si128(_mm_cmpeq_epi32(dropped_lo, set1_lo32(D32_DROPPED[0])), _mm_cmpeq_epi32(dropped_hi, set1_hi32(D32_DROPPED[0])));
+		const __m128i flag = _mm_and_si128(_mm_cmpeq_epi32(dropped_lo, set1_lo32(D32_DROPPED[1])), _mm_cmpeq_epi32(dropped_hi, set1_hi32(D32_DROPPED[1])));
+		const __m128i ok = _mm_or_si128(clear, flag);
+		const __m128i v = _mm_or_si128(
+			_mm_or_si128(move_field_epi32<POS_DAY, ETMT_FIELDSIZE_DAY, D32_DAY>(lo), move_field_epi32<POS_MONTH, ETMT_FIELDSIZE_MONTH, D32_MONTH>(lo)),
+			_mm_or_si128(move_field_epi32<POS_YEAR, ETMT_FIELDSIZE_YEAR, D32_YEAR>(lo), move_field_epi32<POS_CENTURY, ETMT_FIELDSIZE_CENTURY, D32_CENTURY>(lo)));
+		valid = static_cast<unsigned int>(_mm_movemask_ps(_mm_castsi128_ps(ok)));
+		return _mm_and_si128(_mm_or_si128(v, _mm_and_si128(flag, _mm_set1_epi32(1))), ok);
+	}
+
+	size_t narrow_date32_sse2(ets_date32_t *dst, uint8_t *validity, const eternal_timestamp_t *src, size_t count)
+	{
+		size_t failed = 0;
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8) {
+			unsigned int valid_lo, valid_hi;
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), narrow_date32_x4(src + i, valid_lo));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i + 4), narrow_date32_x4(src + i + 4, valid_hi));
+			const unsigned int valid = valid_lo | (valid_hi << 4);
+			failed += 8 - count_bits(valid);
+			if (validity)
+				validity[i / 8] = static_cast<uint8_t>(valid);
+		}
+		return failed + narrow_date32_scalar(dst, validity, src, i, count);
+	}
+
+	inline void widen_date32_x4(eternal_timestamp_t *dst, const ets_date32_t *src, unsigned int &valid)
+	{
+		const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+		const __m128i ok = _mm_cmpeq_epi32(_mm_srli_epi32(v, D32_BITS), _mm_setzero_si128());
+		const __m128i date = _mm_or_si128(
+			_mm_or_si128(move_field_epi32<D32_DAY, ETMT_FIELDSIZE_DAY, POS_DAY>(v), move_field_epi32<D32_MONTH, ETMT_FIELDSIZE_MONTH, POS_MONTH>(v)),
+			_mm_or_si128(move_field_epi32<D32_YEAR, ETMT_FIELDSIZE_YEAR, POS_YEAR>(v), move_field_epi32<D32_CENTURY, ETMT_FIELDSIZE_CENTURY, POS_CENTURY>(v)));
+		const __m128i flag = _mm_cmpeq_epi32(_mm_and_si128(v, _mm_set1_epi32(1)), _mm_set1_epi32(1));
+		const __m128i dropped_lo = select(flag, set1_lo32(D32_DROPPED[1]), set1_lo32(D32_DROPPED[0]));
+		const __m128i dropped_hi = select(flag, set1_hi32(D32_DROPPED[1]), set1_hi32(D32_DROPPED[0]));
+		const __m128i lo = select(ok, _mm_or_si128(date, dropped_lo), set1_lo32(UNKNOWN));
+		const __m128i hi = select(ok, dropped_hi, set1_hi32(UNKNOWN));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst), _mm_unpacklo_epi32(lo, hi));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 2), _mm_unpackhi_epi32(lo, hi));
+		valid = static_cast<unsigned int>(_mm_movemask_ps(_mm_castsi128_ps(ok)));
+	}
+
+	size_t widen_date32_sse2(eternal_timestamp_t *dst, uint8_t *validity, const ets_date32_t *src, size_t count)
+	{
+		size_t failed = 0;
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8) {
+			unsigned int valid_lo, valid_hi;
+			widen_date32_x4(dst + i, src + i, valid_lo);
+			widen_date32_x4(dst + i + 4, src + i + 4, valid_hi);
+			const unsigned int valid = valid_lo | (valid_hi << 4);
+			failed += 8 - count_bits(valid);
+			if (validity)
+				validity[i / 8] = static_cast<uint8_t>(valid);
+		}
+		return failed + widen_date32_scalar(dst, validity, src, i, count);
+	}
+
+	// 2 timestamps to 2 x 6 bytes. Each value is written as 8 bytes, the last two of which the next value
+	// overwrites: the caller MUST leave room for that.
+	inline void narrow_datetime48_x2(ets_datetime48_t *dst, const eternal_timestamp_t *src, unsigned int &valid)
+	{
+		const __m128i t = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+		const __m128i dropped = _mm_and_si128(t, set1_64(SUBSECOND_BITS | FORMAT_BITS));
+		const __m128i flag = all_of_epi64(_mm_cmpeq_epi32(dropped, set1_64(D48_DROPPED[1])));
+		const __m128i ok = _mm_or_si128(flag, all_of_epi64(_mm_cmpeq_epi32(dropped, set1_64(D48_DROPPED[0]))));
+		__m128i v = _mm_or_si128(
+			_mm_or_si128(move_field_epi64<POS_SECONDS, ETMT_FIELDSIZE_SECONDS, D48_SECONDS>(t), move_field_epi64<POS_MINUTE, ETMT_FIELDSIZE_MINUTE, D48_MINUTE>(t)),
+			_mm_or_si128(move_field_epi64<POS_HOUR, ETMT_FIELDSIZE_HOUR, D48_HOUR>(t), move_field_epi64<POS_DAY, ETMT_FIELDSIZE_DAY, D48_DAY>(t)));
+		v = _mm_or_si128(v, _mm_or_si128(
+			_mm_or_si128(move_field_epi64<POS_MONTH, ETMT_FIELDSIZE_MONTH, D48_MONTH>(t), move_field_epi64<POS_YEAR, ETMT_FIELDSIZE_YEAR, D48_YEAR>(t)),
+			_mm_or_si128(move_field_epi64<POS_CENTURY, ETMT_FIELDSIZE_CENTURY, D48_CENTURY>(t), _mm_and_si128(flag, set1_64(1)))));
+		// most significant byte first: the 48 bits move to the top before the byte swap
+		const __m128i be = byteswap_epi64(_mm_slli_epi64(_mm_and_si128(v, ok), 16));
+		_mm_storel_epi64(reinterpret_cast<__m128i *>(dst), be);
+		_mm_storel_epi64(reinterpret_cast<__m128i *>(dst + 1), _mm_unpackhi_epi64(be, be));
+		valid = static_cast<unsigned int>(_mm_movemask_pd(_mm_castsi128_pd(ok)));
+	}
+
+	size_t narrow_datetime48_sse2(ets_datetime48_t *dst, uint8_t *validity, const eternal_timestamp_t *src, size_t count)
+	{
+		size_t failed = 0;
+		size_t i = 0;
+		// the last 8-byte store of a round ends 2 bytes into value i + 8
+		for (; i + 9 <= count; i += 8) {
+			unsigned int valid = 0;
+			for (unsigned int j = 0; j < 8; j += 2) {
+				unsigned int v;
+				narrow_datetime48_x2(dst + i + j, src + i + j, v);
+				valid |= v << j;
+			}
+			failed += 8 - count_bits(valid);
+			if (validity)
+				validity[i / 8] = static_cast<uint8_t>(valid);
+		}
+		return failed + narrow_datetime48_scalar(dst, validity, src, i, count);
+	}
+
+	// 2 x 6 bytes to 2 timestamps. Reads 8 bytes per value: the caller MUST make sure that's there.
+	inline void widen_datetime48_x2(eternal_timestamp_t *dst, const ets_datetime48_t *src, unsigned int &valid)
+	{
+		const __m128i be = _mm_unpacklo_epi64(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(src)), _mm_loadl_epi64(reinterpret_cast<const __m128i *>(src + 1)));
+		// the byte swap puts our 6 bytes at the top and the 2 which follow them at the bottom
+		const __m128i v = _mm_srli_epi64(byteswap_epi64(be), 16);
+		const __m128i ok = all_of_epi64(_mm_cmpeq_epi32(_mm_srli_epi64(v, D48_BITS), _mm_setzero_si128()));
+		__m128i t = _mm_or_si128(
+			_mm_or_si128(move_field_epi64<D48_SECONDS, ETMT_FIELDSIZE_SECONDS, POS_SECONDS>(v), move_field_epi64<D48_MINUTE, ETMT_FIELDSIZE_MINUTE, POS_MINUTE>(v)),
+			_mm_or_si128(move_field_epi64<D48_HOUR, ETMT_FIELDSIZE_HOUR, POS_HOUR>(v), move_field_epi64<D48_DAY, ETMT_FIELDSIZE_DAY, POS_DAY>(v)));
+		t = _mm_or_si128(t, _mm_or_si128(
+			_mm_or_si128(move_field_epi64<D48_MONTH, ETMT_FIELDSIZE_MONTH, POS_MONTH>(v), move_field_epi64<D48_YEAR, ETMT_FIELDSIZE_YEAR, POS_YEAR>(v)),
+			move_field_epi64<D48_CENTURY, ETMT_FIELDSIZE_CENTURY, POS_CENTURY>(v)));
+		const __m128i flag = all_of_epi64(_mm_cmpeq_epi32(_mm_and_si128(v, set1_64(1)), set1_64(1)));
+		t = _mm_or_si128(t, select(flag, set1_64(D48_DROPPED[1]), set1_64(D48_DROPPED[0])));
+		t = select(ok, t, set1_64(UNKNOWN));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst), t);
+		valid = static_cast<unsigned int>(_mm_movemask_pd(_mm_castsi128_pd(ok)));
+	}
+
+	size_t widen_datetime48_sse2(eternal_timestamp_t *dst, uint8_t *validity, const ets_datetime48_t *src, size_t count)
+	{
+		size_t failed = 0;
+		size_t i = 0;
+		// the last 8-byte load of a round ends 2 bytes into value i + 8
+		for (; i + 9 <= count; i += 8) {
+			unsigned int valid = 0;
+			for (unsigned int j = 0; j < 8; j += 2) {
+				unsigned int v;
+				widen_datetime48_x2(dst + i + j, src + i + j, v);
+				valid |= v << j;
+			}
+			failed += 8 - count_bits(valid);
+			if (validity)
+				validity[i / 8] = static_cast<uint8_t>(valid);
+		}
+		return failed + widen_datetime48_scalar(dst, validity, src, i, count);
+	}
+
+#endif // ETS_HAVE_SSE2
+
+	size_t narrow_date32_kernel(ets_date32_t *dst, uint8_t *validity, const eternal_timestamp_t *src, size_t count)
+	{
+#if defined(ETS_HAVE_SSE2)
+		return narrow_date32_sse2(dst, validity, src, count);
+#endif
+		return narrow_date32_scalar(dst, validity, src, 0, count);
+	}
+
+	size_t widen_date32_kernel(eternal_timestamp_t *dst, uint8_t *validity, const ets_date32_t *src, size_t count)
+	{
+#if defined(ETS_HAVE_SSE2)
+		return widen_date32_sse2(dst, validity, src, count);
+#endif
+		return widen_date32_scalar(dst, validity, src, 0, count);
+	}
+
+	size_t narrow_datetime48_kernel(ets_datetime48_t *dst, uint8_t *validity, const eternal_timestamp_t *src, size_t count)
+	{
+#if defined(ETS_HAVE_SSE2)
+		return narrow_datetime48_sse2(dst, validity, src, count);
+#endif
+		return narrow_datetime48_scalar(dst, validity, src, 0, count);
+	}
+
+	size_t widen_datetime48_kernel(eternal_timestamp_t *dst, uint8_t *validity, const ets_datetime48_t *src, size_t count)
+	{
+#if defined(ETS_HAVE_SSE2)
+		return widen_datetime48_sse2(dst, validity, src, count);
+#endif
+		return widen_datetime48_scalar(dst, validity, src, 0, count);
+	}
+}
+
+
+int EternalTimestampCompact::narrow_date32(ets_date32_t &dst, const eternal_timestamp_t t)
+{
+	dst = 0;
+	if (ets_format_sign(t) || ets_format_mode(t))
+		return -1;
+	const bool unspecified = (ets_modern_hour(t) == get_Invalid(ETMT_FIELDSIZE_HOUR)
+		&& ets_modern_minute(t) == get_Invalid(ETMT_FIELDSIZE_MINUTE)
+		&& ets_modern_seconds(t) == get_Invalid(ETMT_FIELDSIZE_SECONDS)
+		&& ets_modern_milliseconds(t) == get_Invalid(ETMT_FIELDSIZE_MILLISECONDS)
+		&& ets_modern_microseconds(t) == get_Invalid(ETMT_FIELDSIZE_MICROSECONDS));
+	const bool zero = (ets_modern_hour(t) == FIELD_VAL_OFFSET && ets_modern_minute(t) == FIELD_VAL_OFFSET && ets_modern_seconds(t) == FIELD_VAL_OFFSET
+		&& ets_modern_milliseconds(t) == FIELD_VAL_OFFSET && ets_modern_microseconds(t) == FIELD_VAL_OFFSET);
+	if (!unspecified && !zero)
+		return -1;
+	dst = (static_cast<ets_date32_t>(ets_modern_century(t)) << D32_CENTURY)
+		| (static_cast<ets_date32_t>(ets_modern_year(t)) << D32_YEAR)
+		| (static_cast<ets_date32_t>(ets_modern_month(t)) << D32_MONTH)
+		| (static_cast<ets_date32_t>(ets_modern_day(t)) << D32_DAY)
+		| (zero ? FLAG_FOR_ZERO : 1 - FLAG_FOR_ZERO);
+	return 0;
+}
+
+int EternalTimestampCompact::widen_date32(eternal_timestamp_t &dst, const ets_date32_t v)
+{
+	dst = ets_make_unknown();
+	if (v >> D32_BITS)
+		return -1;
+	dst = ets_modern_set_century(dst, (v >> D32_CENTURY) & ((1U << ETMT_FIELDSIZE_CENTURY) - 1));
+	dst = ets_modern_set_year(dst, (v >> D32_YEAR) & ((1U << ETMT_FIELDSIZE_YEAR) - 1));
+	dst = ets_modern_set_month(dst, (v >> D32_MONTH) & ((1U << ETMT_FIELDSIZE_MONTH) - 1));
+	dst = ets_modern_set_day(dst, (v >> D32_DAY) & ((1U << ETMT_FIELDSIZE_DAY) - 1));
+	if ((v & 1) == FLAG_FOR_ZERO) {
+		dst = ets_modern_set_hour(dst, FIELD_VAL_OFFSET);
+		dst = ets_modern_set_minute(dst, FIELD_VAL_OFFSET);
+		dst = ets_modern_set_seconds(dst, FIELD_VAL_OFFSET);
+		dst = ets_modern_set_milliseconds(dst, FIELD_VAL_OFFSET);
+		dst = ets_modern_set_microseconds(dst, FIELD_VAL_OFFSET);
+	}
+	return 0;
+}
+
+int EternalTimestampCompact::narrow_datetime48(ets_datetime48_t &dst, const eternal_timestamp_t t)
+{
+	store_datetime48(dst, 0);
+	if (ets_format_sign(t) || ets_format_mode(t))
+		return -1;
+	const bool unspecified = (ets_modern_milliseconds(t) == get_Invalid(ETMT_FIELDSIZE_MILLISECONDS) && ets_modern_microseconds(t) == get_Invalid(ETMT_FIELDSIZE_MICROSECONDS));
+	const bool zero = (ets_modern_milliseconds(t) == FIELD_VAL_OFFSET && ets_modern_microseconds(t) == FIELD_VAL_OFFSET);
+	if (!unspecified && !zero)
+		return -1;
+	store_datetime48(dst, (static_cast<uint64_t>(ets_modern_century(t)) << D48_CENTURY)
+		| (static_cast<uint64_t>(ets_modern_year(t)) << D48_YEAR)
+		| (static_cast<uint64_t>(ets_modern_month(t)) << D48_MONTH)
+		| (static_cast<uint64_t>(ets_modern_day(t)) << D48_DAY)
+		| (static_cast<uint64_t>(ets_modern_hour(t)) << D48_HOUR)
+		| (static_cast<uint64_t>(ets_modern_minute(t)) << D48_MINUTE)
+		| (static_cast<uint64_t>(ets_modern_seconds(t)) << D48_SECONDS)
+		| (zero ? FLAG_FOR_ZERO : 1 - FLAG_FOR_ZERO));
+	return 0;
+}
+
+int EternalTimestampCompact::widen_datetime48(eternal_timestamp_t &dst, const ets_datetime48_t v)
+{
+	dst = ets_make_unknown();
+	const uint64_t x = ets_datetime48_value(v);
+	if (x >> D48_BITS)
+		return -1;
+	dst = ets_modern_set_century(dst, (x >> D48_CENTURY) & ((1U << ETMT_FIELDSIZE_CENTURY) - 1));
+	dst = ets_modern_set_year(dst, (x >> D48_YEAR) & ((1U << ETMT_FIELDSIZE_YEAR) - 1));
+	dst = ets_modern_set_month(dst, (x >> D48_MONTH) & ((1U << ETMT_FIELDSIZE_MONTH) - 1));
+	dst = ets_modern_set_day(dst, (x >> D48_DAY) & ((1U << ETMT_FIELDSIZE_DAY) - 1));
+	dst = ets_modern_set_hour(dst, (x >> D48_HOUR) & ((1U << ETMT_FIELDSIZE_HOUR) - 1));
+	dst = ets_modern_set_minute(dst, (x >> D48_MINUTE) & ((1U << ETMT_FIELDSIZE_MINUTE) - 1));
+	dst = ets_modern_set_seconds(dst, (x >> D48_SECONDS) & ((1U << ETMT_FIELDSIZE_SECONDS) - 1));
+	if ((x & 1) == FLAG_FOR_ZERO) {
+		dst = ets_modern_set_milliseconds(dst, FIELD_VAL_OFFSET);
+		dst = ets_modern_set_microseconds(dst, FIELD_VAL_OFFSET);
+	}
+	return 0;
+}
+
+size_t EternalTimestampCompact::narrow_date32_batch(ets_date32_t *dst, uint8_t *validity, const eternal_timestamp_t *src, size_t count, unsigned int parallelism)
+{
+	ETS_STATS_ENTRY(COMPACT_NARROW_DATE32);
+	return ets_parallel_sum(count, parallelism, [=](size_t begin, size_t end) {
+		return narrow_date32_kernel(dst + begin, ets_bitmap_at(validity, begin), src + begin, end - begin);
+	});
+}
+
+size_t EternalTimestampCompact::widen_date32_batch(eternal_timestamp_t *dst, uint8_t *validity, const ets_date32_t *src, size_t count, unsigned int parallelism)
+{
+	ETS_STATS_ENTRY(COMPACT_WIDEN_DATE32);
+	return ets_parallel_sum(count, parallelism, [=](size_t begin, size_t end) {
+		return widen_date32_kernel(dst + begin, ets_bitmap_at(validity, begin), src + begin, end - begin);
+	});
+}
+
+size_t EternalTimestampCompact::narrow_datetime48_batch(ets_datetime48_t *dst, uint8_t *validity, const eternal_timestamp_t *src, size_t count, unsigned int parallelism)
+{
+	ETS_STATS_ENTRY(COMPACT_NARROW_DATETIME48);
+	return ets_parallel_sum(count, parallelism, [=](size_t begin, size_t end) {
+		return narrow_datetime48_kernel(dst + begin, ets_bitmap_at(validity, begin), src + begin, end - begin);
+	});
+}
+
+size_t EternalTimestampCompact::widen_datetime48_batch(eternal_timestamp_t *dst, uint8_t *validity, const ets_datetime48_t *src, size_t count, unsigned int parallelism)
+{
+	ETS_STATS_ENTRY(COMPACT_WIDEN_DATETIME48);
+	return ets_parallel_sum(count, parallelism, [=](size_t begin, size_t end) {
+		return widen_datetime48_kernel(dst + begin, ets_bitmap_at(validity, begin), src + begin, end - begin);
+	});
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// C interface
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+extern "C" int ets_compact_narrow_date32(ets_date32_t *dst, const eternal_timestamp_t t)
+{
+	return EternalTimestampCompact::narrow_date32(*dst, t);
+}
+
+extern "C" int ets_compact_widen_date32(eternal_timestamp_t *dst, const ets_date32_t v)
+{
+	return EternalTimestampCompact::widen_date32(*dst, v);
+}
+
+extern "C" int ets_compact_narrow_datetime48(ets_datetime48_t *dst, const eternal_timestamp_t t)
+{
+	return EternalTimestampCompact::narrow_datetime48(*dst, t);
+}
+
+extern "C" int ets_compact_widen_datetime48(eternal_timestamp_t *dst, const ets_datetime48_t v)
+{
+	return EternalTimestampCompact::widen_datetime48(*dst, v);
+}
+
+extern "C" size_t ets_compact_narrow_date32_batch(ets_date32_t *dst, uint8_t *validity, const eternal_timestamp_t *src, size_t count)
+{
+	return EternalTimestampCompact::narrow_date32_batch(dst, validity, src, count);
+}
+
+extern "C" size_t ets_compact_widen_date32_batch(eternal_timestamp_t *dst, uint8_t *validity, const ets_date32_t *src, size_t count)
+{
+	return EternalTimestampCompact::widen_date32_batch(dst, validity, src, count);
+}
+
+extern "C" size_t ets_compact_narrow_datetime48_batch(ets_datetime48_t *dst, uint8_t *validity, const eternal_timestamp_t *src, size_t count)
+{
+	return EternalTimestampCompact::narrow_datetime48_batch(dst, validity, src, count);
+}
+
+extern "C" size_t ets_compact_widen_datetime48_batch(eternal_timestamp_t *dst, uint8_t *validity, const ets_datetime48_t *src, size_t count)
+{
+	return EternalTimestampCompact::widen_datetime48_batch(dst, validity, src, count);
+}
@@ -0,0 +1,133 @@
+#include "eternal_timestamp/eternal_timestamp_endian.h"
+
+#include "eternal_timestamp_instrumentation.h"
+#include "eternal_timestamp_internal.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define ETS_HAVE_AVX2   1
+#endif
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#define ETS_HAVE_SSSE3  1
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ETS_HAVE_SSE2   1
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define ETS_HAVE_NEON   1
+#endif
+
+
+using namespace eternal_timestamp;
+
+
+namespace
+{
+	// Reverse the bytes of 64-bit values [begin, end), all loads and stores unaligned. In-place is fine: each
+	// vector is loaded before it is stored.
+	void byteswap_kernel(uint8_t *dst, const uint8_t *src, size_t begin, size_t end)
+	{
+		size_t i = begin;
+#if defined(ETS_HAVE_AVX2)
+		const __m256i reverse256 = _mm256_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+			7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+		for (; i + 4 <= end; i += 4) {
+			const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i * 8));
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i * 8), _mm256_shuffle_epi8(v, reverse256));
+		}
+#endif
+#if defined(ETS_HAVE_SSSE3)
+		const __m128i reverse128 = _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+		for (; i + 2 <= end; i += 2) {
+			const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 8));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * 8), _mm_shuffle_epi8(v, reverse128));
+		}
+#elif defined(ETS_HAVE_SSE2)
+		for (; i + 2 <= end; i += 2) {
+			__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 8));
+			// swap the bytes of each 16-bit word, then reverse the words of each 64-bit lane
+			v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+			v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+			v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * 8), v);
+		}
+#elif defined(ETS_HAVE_NEON)
+		for (; i + 2 <= end; i += 2)
+			vst1q_u8(dst + i * 8, vrev64q_u8(vld1q_u8(src + i * 8)));
+#endif
+		for (; i < end; i++) {
+			uint64_t v;
+			memcpy(&v, src + i * 8, sizeof(v));
+			v = ets_bswap64(v);
+			memcpy(dst + i * 8, &v, sizeof(v));
+		}
+	}
+}
+
+
+void EternalTimestampEndian::byteswap(void *dst, const void *src, size_t count, unsigned int parallelism)
+{
+	ETS_STATS_ENTRY(ENDIAN_BYTESWAP);
+	uint8_t *const d = static_cast<uint8_t *>(dst);
+	const uint8_t *const s = static_cast<const uint8_t *>(src);
+	EternalTimestampParallel::parallel_for(count, ETS_PARALLEL_GRAIN, parallelism, [=](size_t begin, size_t end) {
+		byteswap_kernel(d, s, begin, end);
+	});
+}
+
+void EternalTimestampEndian::load(eternal_timestamp_t *dst, const void *src, size_t count, ets_byte_order_t order, size_t stride, unsigned int parallelism)
+{
+	ETS_STATS_ENTRY(ENDIAN_LOAD);
+	ETS_ASSERT(stride >= sizeof(uint64_t));
+	const uint8_t *const s = static_cast<const uint8_t *>(src);
+	EternalTimestampParallel::parallel_for(count, ETS_PARALLEL_GRAIN, parallelism, [=](size_t begin, size_t end) {
+		if (stride != sizeof(uint64_t)) {
+			for (size_t i = begin; i < end; i++)
+				dst[i] = ets_load_timestamp(s + i * stride, order);
+		} else if (order == ETS_BYTE_ORDER_NATIVE) {
+			memcpy(dst + begin, s + begin * 8, (end - begin) * 8);
+		} else {
+			byteswap_kernel(reinterpret_cast<uint8_t *>(dst), s, begin, end);
+		}
+	});
+}
+
+void EternalTimestampEndian::store(void *dst, const eternal_timestamp_t *src, size_t count, ets_byte_order_t order, size_t stride, unsigned int parallelism)
+{
+	ETS_STATS_ENTRY(ENDIAN_STORE);
+	ETS_ASSERT(stride >= sizeof(uint64_t));
+	uint8_t *const d = static_cast<uint8_t *>(dst);
+	EternalTimestampParallel::parallel_for(count, ETS_PARALLEL_GRAIN, parallelism, [=](size_t begin, size_t end) {
+		if (stride != sizeof(uint64_t)) {
+			for (size_t i = begin; i < end; i++)
+				ets_store_timestamp(d + i * stride, src[i], order);
+		} else if (order == ETS_BYTE_ORDER_NATIVE) {
+			memcpy(d + begin * 8, src + begin, (end - begin) * 8);
+		} else {
+			byteswap_kernel(d, reinterpret_cast<const uint8_t *>(src), begin, end);
+		}
+	});
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// C interface
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+extern "C" void ets_endian_byteswap(void *dst, const void *src, size_t count)
+{
+	EternalTimestampEndian::byteswap(dst, src, count);
+}
+
+extern "C" void ets_endian_load(eternal_timestamp_t *dst, const void *src, size_t count, ets_byte_order_t order, size_t stride)
+{
+	EternalTimestampEndian::load(dst, src, count, order, stride);
+}
+
+extern "C" void ets_endian_store(void *dst, const eternal_timestamp_t *src, size_t count, ets_byte_order_t order, size_t stride)
+{
+	EternalTimestampEndian::store(dst, src, count, order, stride);
+}
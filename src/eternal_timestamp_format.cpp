@@ -0,0 +1,667 @@
+
+#include "eternal_timestamp/eternal_timestamp_format.h"
+
+#include "eternal_timestamp_instrumentation.h"
+#include "eternal_timestamp_internal.h"
+
+#include <string.h>
+
+
+using namespace eternal_timestamp;
+
+
+namespace
+{
+	enum format_opcode : uint8_t
+	{
+		OP_LITERAL = 0,
+		OP_SECTION,            // [...]: skip to op `arg` unless all fields in the `length` mask are specified
+		OP_YEAR,               // %Y
+		OP_YEAR_ERA,           // %EY
+		OP_CENTURY,            // %C
+		OP_YEAR2,              // %y
+		OP_MONTH,              // %m
+		OP_MONTH_ABBR,         // %b
+		OP_MONTH_NAME,         // %B
+		OP_DAY,                // %d
+		OP_DAY_SPACE,          // %e
+		OP_HOUR,               // %H
+		OP_HOUR12,             // %I
+		OP_AMPM,               // %p
+		OP_MINUTE,             // %M
+		OP_SECOND,             // %S
+		OP_FRACTION,           // %f
+		OP_MILLISECONDS,       // %3f
+		OP_MICROSECONDS,       // %6f
+		OP_AGE,                // %N
+		OP_APPROX,             // %~
+
+		OP_COUNT
+	};
+
+	constexpr uint32_t bit(eternal_unspecified_time_field_bit b)
+	{
+		return uint32_t(1) << b;
+	}
+
+	struct opcode_info
+	{
+		uint8_t max_width;     // the maximum number of characters produced
+		uint8_t fill_width;    // the number of '?' characters produced when the field is unspecified
+		uint16_t required;     // the fields which must be specified for the value to be rendered
+	};
+
+	// indexed by `format_opcode`
+	constexpr opcode_info opcodes[OP_COUNT] = {
+		{ 0, 0, 0 },                                                                             // OP_LITERAL
+		{ 0, 0, 0 },                                                                             // OP_SECTION
+		{ 20, 4, bit(ETTS_UNSPECIFIED_EPOCHS) | bit(ETTS_UNSPECIFIED_YEARS) },                  // OP_YEAR
+		{ 23, 4, bit(ETTS_UNSPECIFIED_EPOCHS) | bit(ETTS_UNSPECIFIED_YEARS) },                  // OP_YEAR_ERA
+		{ 20, 2, bit(ETTS_UNSPECIFIED_EPOCHS) },                                                 // OP_CENTURY
+		{ 2, 2, bit(ETTS_UNSPECIFIED_YEARS) },                                                   // OP_YEAR2
+		{ 2, 2, bit(ETTS_UNSPECIFIED_MONTHS) },                                                  // OP_MONTH
+		{ 3, 3, bit(ETTS_UNSPECIFIED_MONTHS) },                                                  // OP_MONTH_ABBR
+		{ 9, 3, bit(ETTS_UNSPECIFIED_MONTHS) },                                                  // OP_MONTH_NAME
+		{ 2, 2, bit(ETTS_UNSPECIFIED_DAYS) },                                                    // OP_DAY
+		{ 2, 2, bit(ETTS_UNSPECIFIED_DAYS) },                                                    // OP_DAY_SPACE
+		{ 2, 2, bit(ETTS_UNSPECIFIED_HOURS) },                                                   // OP_HOUR
+		{ 2, 2, bit(ETTS_UNSPECIFIED_HOURS) },                                                   // OP_HOUR12
+		{ 2, 2, bit(ETTS_UNSPECIFIED_HOURS) },                                                   // OP_AMPM
+		{ 2, 2, bit(ETTS_UNSPECIFIED_MINUTES) },                                                 // OP_MINUTE
+		{ 2, 2, bit(ETTS_UNSPECIFIED_SECONDS) },                                                 // OP_SECOND
+		{ 6, 3, bit(ETTS_UNSPECIFIED_MILLISECONDS) },                                            // OP_FRACTION
+		{ 3, 3, bit(ETTS_UNSPECIFIED_MILLISECONDS) },                                            // OP_MILLISECONDS
+		{ 6, 6, bit(ETTS_UNSPECIFIED_MILLISECONDS) | bit(ETTS_UNSPECIFIED_MICROSECONDS) },     // OP_MICROSECONDS
+		{ 20, 1, bit(ETTS_UNSPECIFIED_EPOCHS) },                                                 // OP_AGE
+		{ 8, 0, 0 },                                                                             // OP_APPROX
+	};
+
+	constexpr const char *month_names[12] = {
+		"January", "February", "March", "April", "May", "June",
+		"July", "August", "September", "October", "November", "December",
+	};
+
+	constexpr uint8_t month_name_lengths[12] = { 7, 8, 5, 5, 3, 4, 4, 6, 9, 7, 8, 8 };
+
+	constexpr const char approx_text[] = "approx. ";
+
+	constexpr size_t MAX_RENDER_LENGTH = ETS_FORMAT_MAX_OPS * 23 + ETS_FORMAT_MAX_LITERALS;
+
+	// The timestamp, decoded once for all ops.
+	struct decoded_fields
+	{
+		int64_t year;              // astronomical year; the first year of the century when only the century is known
+		uint64_t age;              // prehistoric: the age, rounded to `precision`
+		unsigned precision;
+		unsigned month;
+		unsigned day;
+		unsigned hour;
+		unsigned minute;
+		unsigned second;
+		unsigned milliseconds;
+		unsigned microseconds;
+		uint32_t unspecified;      // `enum eternal_unspecified_time_field_bit` bits
+		bool prehistoric;
+	};
+
+	inline void decode(decoded_fields &f, const eternal_timestamp_t t)
+	{
+		uint32_t u = 0;
+		f.prehistoric = ets_format_mode(t);
+		if (!f.prehistoric) {
+			if (ets_modern_century(t) == get_Invalid(ETMT_FIELDSIZE_CENTURY))
+				u |= bit(ETTS_UNSPECIFIED_EPOCHS) | bit(ETTS_UNSPECIFIED_YEARS);
+			else if (ets_modern_year(t) == get_Invalid(ETMT_FIELDSIZE_YEAR))
+				u |= bit(ETTS_UNSPECIFIED_YEARS);
+			f.year = static_cast<int64_t>(ets_modern_century(t)) * 100 - MODERN_EPOCH;
+			if (!(u & bit(ETTS_UNSPECIFIED_YEARS)))
+				f.year += static_cast<int64_t>(ets_modern_year(t)) - FIELD_VAL_OFFSET;
+			f.age = 0;
+			f.precision = 0;
+
+			if (ets_modern_month(t) == get_Invalid(ETMT_FIELDSIZE_MONTH))
+				u |= bit(ETTS_UNSPECIFIED_MONTHS);
+			f.month = ets_modern_month(t) + 1 - FIELD_VAL_OFFSET;
+			if (ets_modern_day(t) == get_Invalid(ETMT_FIELDSIZE_DAY))
+				u |= bit(ETTS_UNSPECIFIED_DAYS);
+			f.day = ets_modern_day(t) + 1 - FIELD_VAL_OFFSET;
+			if (ets_modern_hour(t) == get_Invalid(ETMT_FIELDSIZE_HOUR))
+				u |= bit(ETTS_UNSPECIFIED_HOURS);
+			f.hour = ets_modern_hour(t) - FIELD_VAL_OFFSET;
+			if (ets_modern_minute(t) == get_Invalid(ETMT_FIELDSIZE_MINUTE))
+				u |= bit(ETTS_UNSPECIFIED_MINUTES);
+			f.minute = ets_modern_minute(t) - FIELD_VAL_OFFSET;
+			if (ets_modern_seconds(t) == get_Invalid(ETMT_FIELDSIZE_SECONDS))
+				u |= bit(ETTS_UNSPECIFIED_SECONDS);
+			f.second = ets_modern_seconds(t) - FIELD_VAL_OFFSET;
+			if (ets_modern_milliseconds(t) == get_Invalid(ETMT_FIELDSIZE_MILLISECONDS))
+				u |= bit(ETTS_UNSPECIFIED_MILLISECONDS);
+			f.milliseconds = ets_modern_milliseconds(t) - FIELD_VAL_OFFSET;
+			if (ets_modern_microseconds(t) == get_Invalid(ETMT_FIELDSIZE_MICROSECONDS))
+				u |= bit(ETTS_UNSPECIFIED_MICROSECONDS);
+			f.microseconds = ets_modern_microseconds(t) - FIELD_VAL_OFFSET;
+		}
+		else {
+			// the years field counts back from the epoch; as a 38-bit field `get_Invalid()` doesn't apply.
+			if (FIELD_VAL_OFFSET ? ets_prehistoric_years(t) == 0 : ets_prehistoric_years(t) == (uint64_t(1) << ETPHT_FIELDSIZE_YEARS) - 1)
+				u |= bit(ETTS_UNSPECIFIED_EPOCHS) | bit(ETTS_UNSPECIFIED_YEARS);
+			else if (ets_prehistoric_precision(t) >= 2)
+				u |= bit(ETTS_UNSPECIFIED_YEARS);
+			f.year = PREHISTORIC_EPOCH - static_cast<int64_t>(ets_prehistoric_years(t));
+			f.precision = ets_prehistoric_precision(t);
+			f.age = ets_prehistoric_years(t);
+			if (ets_prehistoric_precision(t) > 0) {
+				uint64_t unit = 1;
+				for (unsigned i = 0; i < ets_prehistoric_precision(t); i++)
+					unit *= 10;
+				f.age = (f.age + unit / 2) / unit * unit;
+			}
+
+			if (ets_prehistoric_month(t) == get_Invalid(ETPHT_FIELDSIZE_MONTH))
+				u |= bit(ETTS_UNSPECIFIED_MONTHS);
+			f.month = ets_prehistoric_month(t) + 1 - FIELD_VAL_OFFSET;
+			if (ets_prehistoric_day(t) == get_Invalid(ETPHT_FIELDSIZE_DAY))
+				u |= bit(ETTS_UNSPECIFIED_DAYS);
+			f.day = ets_prehistoric_day(t) + 1 - FIELD_VAL_OFFSET;
+			if (ets_prehistoric_hour(t) == get_Invalid(ETPHT_FIELDSIZE_HOUR))
+				u |= bit(ETTS_UNSPECIFIED_HOURS);
+			f.hour = ets_prehistoric_hour(t) - FIELD_VAL_OFFSET;
+			if (ets_prehistoric_minute(t) == get_Invalid(ETPHT_FIELDSIZE_MINUTE))
+				u |= bit(ETTS_UNSPECIFIED_MINUTES);
+			f.minute = ets_prehistoric_minute(t) - FIELD_VAL_OFFSET;
+			u |= bit(ETTS_UNSPECIFIED_SECONDS) | bit(ETTS_UNSPECIFIED_MILLISECONDS) | bit(ETTS_UNSPECIFIED_MICROSECONDS);
+			f.second = f.milliseconds = f.microseconds = 0;
+		}
+		f.unspecified = u;
+	}
+
+	// write `v` using at least `min_width` digits.
+	char *put_uint(char *p, uint64_t v, unsigned min_width)
+	{
+		unsigned n = 1;
+		for (uint64_t w = v; w >= 10; w /= 10)
+			n++;
+		for (; min_width > n; min_width--)
+			*p++ = '0';
+		char *q = p + n;
+		while (v >= 100) {
+			q -= 2;
+			memcpy(q, ets_digit_pair_table.d + 2 * (v % 100), 2);
+			v /= 100;
+		}
+		if (v >= 10)
+			memcpy(q - 2, ets_digit_pair_table.d + 2 * v, 2);
+		else
+			q[-1] = static_cast<char>('0' + v);
+		return p + n;
+	}
+
+	char *put_year(char *p, const decoded_fields &f)
+	{
+		char *start = p;
+		if (f.year < 0) {
+			*p++ = '-';
+			start = p;
+			p = put_uint(p, static_cast<uint64_t>(-f.year), 4);
+		}
+		else {
+			p = put_uint(p, static_cast<uint64_t>(f.year), 4);
+		}
+		// only the century is known: "18??". This does not make sense for B.C. centuries, which count down.
+		if (f.unspecified & bit(ETTS_UNSPECIFIED_YEARS)) {
+			if (f.year < 0) {
+				memcpy(start - 1, "????", 4);
+				return start + 3;
+			}
+			p[-2] = p[-1] = '?';
+		}
+		return p;
+	}
+
+	char *put_year_era(char *p, const decoded_fields &f)
+	{
+		if (f.year > 0)
+			return put_year(p, f);
+		if (f.unspecified & bit(ETTS_UNSPECIFIED_YEARS)) {
+			memcpy(p, "????", 4);
+			return p + 4;
+		}
+		// there is no year 0: 1 B.C. is followed by 1 A.D.
+		p = put_uint(p, static_cast<uint64_t>(1 - f.year), 1);
+		memcpy(p, " BC", 3);
+		return p + 3;
+	}
+
+	inline int64_t floor_div100(int64_t v)
+	{
+		return (v >= 0 ? v / 100 : -((-v + 99) / 100));
+	}
+
+	// Execute the ops for the modern or prehistoric alternative; the caller guarantees the output buffer can hold `max_length` characters.
+	size_t render(char *out, const ets_format_pattern_t &pattern, const decoded_fields &f)
+	{
+		unsigned i = (f.prehistoric ? pattern.modern_count : 0);
+		const unsigned end = (f.prehistoric ? pattern.op_count : pattern.modern_count);
+		char *p = out;
+
+		while (i < end) {
+			const ets_format_op_t &op = pattern.ops[i++];
+			if (op.code == OP_LITERAL) {
+				// most literals are single separator characters: don't bother calling memcpy() for those.
+				if (op.length == 1)
+					*p = pattern.literals[op.arg];
+				else
+					memcpy(p, pattern.literals + op.arg, op.length);
+				p += op.length;
+				continue;
+			}
+			if (op.code == OP_SECTION) {
+				if (f.unspecified & op.length)
+					i = op.arg;
+				continue;
+			}
+			const opcode_info &info = opcodes[op.code];
+			// the century-only case is handled by the year renderers themselves.
+			const uint32_t required = (op.code == OP_YEAR || op.code == OP_YEAR_ERA ? bit(ETTS_UNSPECIFIED_EPOCHS) : info.required);
+			if (f.unspecified & required) {
+				memset(p, '?', info.fill_width);
+				p += info.fill_width;
+				continue;
+			}
+
+			switch (op.code) {
+			case OP_YEAR:
+				p = put_year(p, f);
+				break;
+
+			case OP_YEAR_ERA:
+				p = put_year_era(p, f);
+				break;
+
+			case OP_CENTURY: {
+				const int64_t c = floor_div100(f.year);
+				if (c < 0) {
+					*p++ = '-';
+					p = put_uint(p, static_cast<uint64_t>(-c), 2);
+				}
+				else {
+					p = put_uint(p, static_cast<uint64_t>(c), 2);
+				}
+				break;
+			}
+
+			case OP_YEAR2:
+				p = ets_put2(p, static_cast<unsigned>(f.year - floor_div100(f.year) * 100));
+				break;
+
+			case OP_MONTH:
+				p = ets_put2(p, f.month);
+				break;
+
+			case OP_MONTH_ABBR:
+				memcpy(p, month_names[f.month - 1], 3);
+				p += 3;
+				break;
+
+			case OP_MONTH_NAME:
+				memcpy(p, month_names[f.month - 1], month_name_lengths[f.month - 1]);
+				p += month_name_lengths[f.month - 1];
+				break;
+
+			case OP_DAY:
+				p = ets_put2(p, f.day);
+				break;
+
+			case OP_DAY_SPACE:
+				p = ets_put2(p, f.day);
+				if (p[-2] == '0')
+					p[-2] = ' ';
+				break;
+
+			case OP_HOUR:
+				p = ets_put2(p, f.hour);
+				break;
+
+			case OP_HOUR12:
+				p = ets_put2(p, (f.hour % 12 ? f.hour % 12 : 12));
+				break;
+
+			case OP_AMPM:
+				memcpy(p, (f.hour < 12 ? "AM" : "PM"), 2);
+				p += 2;
+				break;
+
+			case OP_MINUTE:
+				p = ets_put2(p, f.minute);
+				break;
+
+			case OP_SECOND:
+				p = ets_put2(p, f.second);
+				break;
+
+			case OP_FRACTION:
+				p = ets_put3(p, f.milliseconds);
+				if (!(f.unspecified & bit(ETTS_UNSPECIFIED_MICROSECONDS)))
+					p = ets_put3(p, f.microseconds);
+				break;
+
+			case OP_MILLISECONDS:
+				p = ets_put3(p, f.milliseconds);
+				break;
+
+			case OP_MICROSECONDS:
+				p = ets_put3(p, f.milliseconds);
+				p = ets_put3(p, f.microseconds);
+				break;
+
+			case OP_AGE:
+				p = put_uint(p, f.age, 1);
+				break;
+
+			case OP_APPROX:
+				if (f.precision > 0) {
+					memcpy(p, approx_text, sizeof(approx_text) - 1);
+					p += sizeof(approx_text) - 1;
+				}
+				break;
+			}
+		}
+		return p - out;
+	}
+
+	class pattern_compiler
+	{
+	public:
+		explicit pattern_compiler(ets_format_pattern_t &dst) : dst(dst) {}
+
+		// Compile one alternative, up to the top level '|' or the end of the pattern.
+		// Returns a pointer to where compilation stopped, or NULL on error with `error` pointing at the offending spot.
+		const char *compile_alternative(const char *pattern, const char *&error)
+		{
+			uint16_t stack[ETS_FORMAT_MAX_OPS];
+			unsigned depth = 0;
+			unsigned length = 0;
+			const unsigned first_op = dst.op_count;
+			alternative_start = first_op;
+
+			const char *s = pattern;
+			for (; *s; s++) {
+				error = s;
+				if (*s == '[') {
+					if (!emit(OP_SECTION, 0))
+						return nullptr;
+					stack[depth++] = dst.op_count - 1;
+					continue;
+				}
+				if (*s == ']') {
+					if (!depth)
+						return nullptr;
+					dst.ops[stack[--depth]].arg = dst.op_count;
+					continue;
+				}
+				if (*s == '|') {
+					if (depth)
+						return nullptr;
+					break;
+				}
+				if (*s != '%') {
+					if (!literal(*s))
+						return nullptr;
+					continue;
+				}
+
+				switch (*++s) {
+				case '%':
+				case '[':
+				case ']':
+				case '|':
+					if (!literal(*s))
+						return nullptr;
+					continue;
+
+				case 'F':
+					if (!emit(OP_YEAR, depth) || !literal('-') || !emit(OP_MONTH, depth) || !literal('-') || !emit(OP_DAY, depth))
+						return nullptr;
+					continue;
+
+				case 'T':
+					if (!emit(OP_HOUR, depth) || !literal(':') || !emit(OP_MINUTE, depth) || !literal(':') || !emit(OP_SECOND, depth))
+						return nullptr;
+					continue;
+
+				case 'E':
+					if (s[1] != 'Y')
+						return nullptr;
+					s++;
+					if (!emit(OP_YEAR_ERA, depth))
+						return nullptr;
+					continue;
+
+				case '3':
+				case '6':
+					if (s[1] != 'f')
+						return nullptr;
+					s++;
+					if (!emit(s[-1] == '3' ? OP_MILLISECONDS : OP_MICROSECONDS, depth))
+						return nullptr;
+					continue;
+				}
+
+				format_opcode code;
+				switch (*s) {
+				case 'Y': code = OP_YEAR; break;
+				case 'C': code = OP_CENTURY; break;
+				case 'y': code = OP_YEAR2; break;
+				case 'm': code = OP_MONTH; break;
+				case 'b': code = OP_MONTH_ABBR; break;
+				case 'B': code = OP_MONTH_NAME; break;
+				case 'd': code = OP_DAY; break;
+				case 'e': code = OP_DAY_SPACE; break;
+				case 'H': code = OP_HOUR; break;
+				case 'I': code = OP_HOUR12; break;
+				case 'p': code = OP_AMPM; break;
+				case 'M': code = OP_MINUTE; break;
+				case 'S': code = OP_SECOND; break;
+				case 'f': code = OP_FRACTION; break;
+				case 'N': code = OP_AGE; break;
+				case '~': code = OP_APPROX; break;
+				default:
+					// also catches the '%' at the end of the pattern
+					return nullptr;
+				}
+				if (!emit(code, depth))
+					return nullptr;
+			}
+			if (depth) {
+				error = s;
+				return nullptr;
+			}
+
+			// sections only add to the length when rendered, but we want the worst case anyway.
+			for (unsigned i = first_op; i < dst.op_count; i++) {
+				const ets_format_op_t &op = dst.ops[i];
+				length += (op.code == OP_LITERAL ? op.length : opcodes[op.code].max_width);
+			}
+			if (length > dst.max_length)
+				dst.max_length = static_cast<uint16_t>(length);
+			return s;
+		}
+
+	private:
+		bool emit(format_opcode code, unsigned depth)
+		{
+			if (dst.op_count >= ETS_FORMAT_MAX_OPS)
+				return false;
+			ets_format_op_t &op = dst.ops[dst.op_count++];
+			op.code = code;
+			op.width = opcodes[code].max_width;
+			op.arg = 0;
+			op.length = 0;
+
+			// a section only cares about the fields it references directly; nested sections decide for themselves.
+			if (depth && code != OP_SECTION) {
+				for (int i = dst.op_count - 2; i >= 0; i--) {
+					ets_format_op_t &section = dst.ops[i];
+					if (section.code == OP_SECTION && section.arg == 0) {
+						section.length |= opcodes[code].required;
+						break;
+					}
+				}
+			}
+			return true;
+		}
+
+		bool literal(char c)
+		{
+			if (dst.literal_length >= ETS_FORMAT_MAX_LITERALS)
+				return false;
+			// extend the previous literal when it's the last one in the buffer.
+			if (dst.op_count > alternative_start) {
+				ets_format_op_t &prev = dst.ops[dst.op_count - 1];
+				if (prev.code == OP_LITERAL && prev.arg + prev.length == dst.literal_length && !open_section_ends_here()) {
+					dst.literals[dst.literal_length++] = c;
+					prev.length++;
+					prev.width = static_cast<uint8_t>(prev.length < 255 ? prev.length : 255);
+					return true;
+				}
+			}
+			if (!emit(OP_LITERAL, 0))
+				return false;
+			ets_format_op_t &op = dst.ops[dst.op_count - 1];
+			op.arg = dst.literal_length;
+			op.length = 1;
+			op.width = 1;
+			dst.literals[dst.literal_length++] = c;
+			return true;
+		}
+
+		// A literal directly following a closed section must not be merged into a literal inside that section.
+		bool open_section_ends_here() const
+		{
+			for (unsigned i = alternative_start; i < dst.op_count; i++) {
+				if (dst.ops[i].code == OP_SECTION && dst.ops[i].arg == dst.op_count)
+					return true;
+			}
+			return false;
+		}
+
+		ets_format_pattern_t &dst;
+		unsigned alternative_start = 0;
+	};
+}
+
+
+int EternalTimestampFormat::compile(ets_format_pattern_t &dst, const char *pattern, size_t *error_offset)
+{
+	ETS_STATS_ENTRY(FORMAT_COMPILE);
+	dst.modern_count = 0;
+	dst.op_count = 0;
+	dst.max_length = 0;
+	dst.literal_length = 0;
+
+	pattern_compiler compiler(dst);
+	const char *error = pattern;
+	const char *s = compiler.compile_alternative(pattern, error);
+	if (s) {
+		dst.modern_count = dst.op_count;
+		if (*s == '|') {
+			const char *e = compiler.compile_alternative(s + 1, error);
+			// only one '|' alternative allowed
+			if (e && *e)
+				error = e;
+			s = (e && !*e ? e : nullptr);
+		}
+		else {
+			const char *dummy;
+			error = s;
+			s = compiler.compile_alternative(ETS_FORMAT_PREHISTORIC_DEFAULT, dummy);
+		}
+	}
+	if (!s) {
+		if (error_offset)
+			*error_offset = error - pattern;
+		dst.modern_count = 0;
+		dst.op_count = 0;
+		dst.max_length = 0;
+		dst.literal_length = 0;
+		return -1;
+	}
+	return 0;
+}
+
+size_t EternalTimestampFormat::format(char *buf, size_t bufsize, const ets_format_pattern_t &pattern, const eternal_timestamp_t t)
+{
+	ETS_STATS_ENTRY(FORMAT_FORMAT);
+	decoded_fields f;
+	decode(f, t);
+
+	if (bufsize > pattern.max_length) {
+		const size_t n = render(buf, pattern, f);
+		buf[n] = 0;
+		return n;
+	}
+
+	char tmp[MAX_RENDER_LENGTH];
+	const size_t n = render(tmp, pattern, f);
+	if (bufsize > 0) {
+		const size_t len = (n < bufsize ? n : bufsize - 1);
+		memcpy(buf, tmp, len);
+		buf[len] = 0;
+	}
+	return n;
+}
+
+size_t EternalTimestampFormat::format_column(char *data, size_t capacity, int32_t *offsets, const ets_format_pattern_t &pattern, const eternal_timestamp_t *src, size_t count, unsigned int parallelism)
+{
+	ETS_STATS_ENTRY(FORMAT_FORMAT_COLUMN);
+	const bool rendered = ets_parallel_text_column(data, capacity, offsets, 0, count, pattern.max_length, parallelism, [&](size_t pos, size_t begin, size_t end) {
+		decoded_fields f;
+		for (size_t i = begin; i < end; i++) {
+			decode(f, src[i]);
+			pos += render(data + pos, pattern, f);
+			offsets[i + 1] = static_cast<int32_t>(pos);
+		}
+	});
+	if (rendered)
+		return count;
+
+	decoded_fields f;
+	for (size_t i = 0; i < count; i++) {
+		const size_t pos = static_cast<size_t>(offsets[i]);
+		decode(f, src[i]);
+
+		size_t n;
+		if (capacity >= pos && capacity - pos >= pattern.max_length) {
+			n = render(data + pos, pattern, f);
+		}
+		else {
+			char tmp[MAX_RENDER_LENGTH];
+			n = render(tmp, pattern, f);
+			if (capacity < pos || capacity - pos < n)
+				return i;
+			memcpy(data + pos, tmp, n);
+		}
+		offsets[i + 1] = static_cast<int32_t>(pos + n);
+	}
+	return count;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// C interface
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+extern "C" int ets_format_compile(ets_format_pattern_t *dst, const char *pattern, size_t *error_offset)
+{
+	return EternalTimestampFormat::compile(*dst, pattern, error_offset);
+}
+
+extern "C" size_t ets_format(char *buf, size_t bufsize, const ets_format_pattern_t *pattern, const eternal_timestamp_t t)
+{
+	return EternalTimestampFormat::format(buf, bufsize, *pattern, t);
+}
+
+extern "C" size_t ets_format_column(char *data, size_t capacity, int32_t *offsets, const ets_format_pattern_t *pattern, const eternal_timestamp_t *src, size_t count)
+{
+	return EternalTimestampFormat::format_column(data, capacity, offsets, *pattern, src, count);
+}
@@ -0,0 +1,417 @@
+#include "eternal_timestamp/eternal_timestamp_fscrawl.h"
+#include "eternal_timestamp/eternal_timestamp_batch.h"
+
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <set>
+#include <utility>
+
+#if !defined(_WIN32)
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#if defined(__linux__) && defined(STATX_BASIC_STATS) && defined(STATX_BTIME)
+#define ETS_HAVE_STATX  1
+#endif
+#endif
+
+#include "eternal_timestamp_instrumentation.h"
+#include "eternal_timestamp_internal.h"
+
+
+using namespace eternal_timestamp;
+
+
+void EternalTimestampFsColumns::clear()
+{
+	paths.clear();
+	path_offsets.clear();
+	sizes.clear();
+	inodes.clear();
+	modes.clear();
+	atime.clear();
+	mtime.clear();
+	ctime.clear();
+	btime.clear();
+}
+
+
+#if !defined(_WIN32)
+
+namespace
+{
+	enum time_index
+	{
+		ATIME,
+		MTIME,
+		CTIME,
+		BTIME,
+		TIME_COUNT,
+	};
+
+	// What the crawl needs of `struct stat` / `struct statx`, the times in microseconds since the UNIX epoch.
+	struct entry_info
+	{
+		uint64_t size;
+		uint64_t inode;
+		uint64_t device;
+		uint32_t mode;
+		bool has_btime;
+		int64_t usecs[TIME_COUNT];
+	};
+
+	inline int64_t usecs_of(int64_t seconds, long nanoseconds)
+	{
+		// `nanoseconds` is never negative, so this rounds down for times before 1970 as well.
+		return seconds * USECS_PER_SECOND + nanoseconds / 1000;
+	}
+
+	// Stat `name` in the directory `dirfd` (`AT_FDCWD` for paths). Returns -1, with `errno` set, on failure.
+	int stat_at(int dirfd, const char *name, bool follow, entry_info &info)
+	{
+#if defined(ETS_HAVE_STATX)
+		static std::atomic<bool> no_statx{ false };
+		if (!no_statx.load(std::memory_order_relaxed)) {
+			struct statx stx;
+			const int flags = (follow ? 0 : AT_SYMLINK_NOFOLLOW) | AT_STATX_DONT_SYNC;
+			if (statx(dirfd, name, flags, STATX_BASIC_STATS | STATX_BTIME, &stx) == 0) {
+				info.size = stx.stx_size;
+				info.inode = stx.stx_ino;
+				info.device = (static_cast<uint64_t>(stx.stx_dev_major) << 32) | stx.stx_dev_minor;
+				info.mode = stx.stx_mode;
+				info.has_btime = !!(stx.stx_mask & STATX_BTIME);
+				info.usecs[ATIME] = usecs_of(stx.stx_atime.tv_sec, stx.stx_atime.tv_nsec);
+				info.usecs[MTIME] = usecs_of(stx.stx_mtime.tv_sec, stx.stx_mtime.tv_nsec);
+				info.usecs[CTIME] = usecs_of(stx.stx_ctime.tv_sec, stx.stx_ctime.tv_nsec);
+				info.usecs[BTIME] = (info.has_btime ? usecs_of(stx.stx_btime.tv_sec, stx.stx_btime.tv_nsec) : 0);
+				return 0;
+			}
+			if (errno != ENOSYS)
+				return -1;
+			// a kernel before 4.11
+			no_statx.store(true, std::memory_order_relaxed);
+		}
+#endif
+		struct stat st;
+		if (fstatat(dirfd, name, &st, follow ? 0 : AT_SYMLINK_NOFOLLOW) != 0)
+			return -1;
+		info.size = static_cast<uint64_t>(st.st_size);
+		info.inode = static_cast<uint64_t>(st.st_ino);
+		info.device = static_cast<uint64_t>(st.st_dev);
+		info.mode = static_cast<uint32_t>(st.st_mode);
+#if defined(__APPLE__)
+		info.has_btime = true;
+		info.usecs[ATIME] = usecs_of(st.st_atimespec.tv_sec, st.st_atimespec.tv_nsec);
+		info.usecs[MTIME] = usecs_of(st.st_mtimespec.tv_sec, st.st_mtimespec.tv_nsec);
+		info.usecs[CTIME] = usecs_of(st.st_ctimespec.tv_sec, st.st_ctimespec.tv_nsec);
+		info.usecs[BTIME] = usecs_of(st.st_birthtimespec.tv_sec, st.st_birthtimespec.tv_nsec);
+#else
+		info.has_btime = false;
+		info.usecs[ATIME] = usecs_of(st.st_atim.tv_sec, st.st_atim.tv_nsec);
+		info.usecs[MTIME] = usecs_of(st.st_mtim.tv_sec, st.st_mtim.tv_nsec);
+		info.usecs[CTIME] = usecs_of(st.st_ctim.tv_sec, st.st_ctim.tv_nsec);
+		info.usecs[BTIME] = 0;
+#endif
+		return 0;
+	}
+
+	struct directory
+	{
+		std::string path;
+		uint32_t depth;
+	};
+
+	struct crawler;
+
+	// The entries a worker has found but not yet handed to the callback.
+	class batch
+	{
+	public:
+		explicit batch(crawler &c)
+			: c_(c)
+		{
+			entries_.reserve(ETS_FSCRAWL_BATCH);
+			for (auto &u : usecs_)
+				u.reserve(ETS_FSCRAWL_BATCH);
+			has_btime_.reserve(ETS_FSCRAWL_BATCH);
+			path_offsets_.reserve(ETS_FSCRAWL_BATCH);
+		}
+
+		void add(const std::string &path, uint32_t depth, const entry_info &info);
+		void flush();
+
+	private:
+		crawler &c_;
+		std::vector<ets_fscrawl_entry_t> entries_;
+		std::vector<int64_t> usecs_[TIME_COUNT];
+		std::vector<eternal_timestamp_t> times_;
+		std::vector<uint8_t> has_btime_;
+		std::vector<size_t> path_offsets_;
+		std::string paths_;
+	};
+
+	struct crawler
+	{
+		unsigned int flags;
+		ets_fscrawl_callback_t callback;
+		void *context;
+		uint64_t root_device;
+
+		// the directories waiting to be read, taken last in first out: that keeps the queue short.
+		std::mutex mutex;
+		std::condition_variable wakeup;
+		std::vector<directory> queue;
+		unsigned int busy = 0;                                   // workers reading a directory
+		std::set<std::pair<uint64_t, uint64_t> > visited;      // (device, inode) of the directories queued, when following links
+
+		std::mutex callback_mutex;
+		std::atomic<bool> stopped{ false };
+
+		std::atomic<uint64_t> entries{ 0 };
+		std::atomic<uint64_t> directories{ 0 };
+		std::atomic<uint64_t> errors{ 0 };
+
+		// Queue `path` when it is a directory to be read.
+		void push(std::string &&path, uint32_t depth, const entry_info &info)
+		{
+			if (!S_ISDIR(info.mode))
+				return;
+			if ((flags & ETS_FSCRAWL_ONE_FILESYSTEM) && info.device != root_device)
+				return;
+			std::lock_guard<std::mutex> lock(mutex);
+			// following links, a link to a parent would make for a cycle
+			if ((flags & ETS_FSCRAWL_FOLLOW_SYMLINKS) && !visited.insert(std::make_pair(info.device, info.inode)).second)
+				return;
+			queue.push_back(directory{ std::move(path), depth });
+			wakeup.notify_one();
+		}
+
+		void read_directory(const directory &d, batch &b)
+		{
+			const int fd = open(d.path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+			DIR *dir = (fd >= 0 ? fdopendir(fd) : nullptr);
+			if (!dir) {
+				if (fd >= 0)
+					close(fd);
+				errors.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+			directories.fetch_add(1, std::memory_order_relaxed);
+
+			const bool follow = !!(flags & ETS_FSCRAWL_FOLLOW_SYMLINKS);
+			std::string path = d.path;
+			if (path.empty() || path.back() != '/')
+				path += '/';
+			const size_t prefix = path.size();
+			while (!stopped.load(std::memory_order_relaxed)) {
+				errno = 0;
+				const struct dirent *de = readdir(dir);
+				if (!de) {
+					if (errno)
+						errors.fetch_add(1, std::memory_order_relaxed);
+					break;
+				}
+				const char *name = de->d_name;
+				if (name[0] == '.' && (name[1] == 0 || (name[1] == '.' && name[2] == 0)))
+					continue;
+				if (name[0] == '.' && (flags & ETS_FSCRAWL_SKIP_HIDDEN))
+					continue;
+
+				entry_info info;
+				if (stat_at(dirfd(dir), name, follow, info) != 0) {
+					errors.fetch_add(1, std::memory_order_relaxed);
+					continue;
+				}
+				path.resize(prefix);
+				path += name;
+				b.add(path, d.depth + 1, info);
+				push(std::string(path), d.depth + 1, info);
+			}
+			closedir(dir);
+		}
+
+		void work()
+		{
+			batch b(*this);
+			for (;;) {
+				directory d;
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					wakeup.wait(lock, [this] { return !queue.empty() || busy == 0 || stopped.load(std::memory_order_relaxed); });
+					if (queue.empty() || stopped.load(std::memory_order_relaxed))
+						break;
+					d = std::move(queue.back());
+					queue.pop_back();
+					busy++;
+				}
+				read_directory(d, b);
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					busy--;
+					if (busy == 0 && queue.empty())
+						wakeup.notify_all();
+				}
+			}
+			b.flush();
+		}
+
+		// Hand `count` entries to the callback, unless the crawl was stopped.
+		void deliver(const ets_fscrawl_entry_t *list, size_t count)
+		{
+			std::lock_guard<std::mutex> lock(callback_mutex);
+			if (stopped.load(std::memory_order_relaxed))
+				return;
+			entries.fetch_add(count, std::memory_order_relaxed);
+			if (callback(context, list, count) != 0) {
+				stopped.store(true, std::memory_order_relaxed);
+				std::lock_guard<std::mutex> queue_lock(mutex);
+				wakeup.notify_all();
+			}
+		}
+	};
+
+	void batch::add(const std::string &path, uint32_t depth, const entry_info &info)
+	{
+		ets_fscrawl_entry_t e;
+		e.path = nullptr;
+		e.path_length = path.size();
+		e.size = info.size;
+		e.inode = info.inode;
+		e.mode = info.mode;
+		e.depth = depth;
+		entries_.push_back(e);
+		for (int k = 0; k < TIME_COUNT; k++)
+			usecs_[k].push_back(info.usecs[k]);
+		has_btime_.push_back(info.has_btime);
+		path_offsets_.push_back(paths_.size());
+		paths_.append(path.c_str(), path.size() + 1);
+		if (entries_.size() == ETS_FSCRAWL_BATCH)
+			flush();
+	}
+
+	void batch::flush()
+	{
+		const size_t n = entries_.size();
+		if (!n)
+			return;
+
+		// the whole batch at once: its entries mostly share their day, which the kernel caches
+		times_.resize(n);
+		eternal_timestamp_t ets_fscrawl_entry_t::*const fields[TIME_COUNT] = { &ets_fscrawl_entry_t::atime, &ets_fscrawl_entry_t::mtime, &ets_fscrawl_entry_t::ctime, &ets_fscrawl_entry_t::btime };
+		for (int k = 0; k < TIME_COUNT; k++) {
+			EternalTimestampBatch::cvt_from_unix_usecs(times_.data(), nullptr, usecs_[k].data(), n, 1);
+			for (size_t i = 0; i < n; i++)
+				entries_[i].*fields[k] = times_[i];
+		}
+		for (size_t i = 0; i < n; i++) {
+			if (!has_btime_[i])
+				entries_[i].btime = ets_unknown();
+			entries_[i].path = paths_.data() + path_offsets_[i];
+		}
+
+		c_.deliver(entries_.data(), n);
+
+		entries_.clear();
+		for (auto &u : usecs_)
+			u.clear();
+		has_btime_.clear();
+		path_offsets_.clear();
+		paths_.clear();
+	}
+}
+
+#endif // !_WIN32
+
+
+int EternalTimestampFsCrawl::crawl(const char *root, unsigned int flags, ets_fscrawl_callback_t callback, void *context, ets_fscrawl_stats_t *stats, unsigned int parallelism)
+{
+	ETS_STATS_ENTRY(FSCRAWL_CRAWL);
+	if (stats)
+		memset(stats, 0, sizeof(*stats));
+#if defined(_WIN32)
+	(void)root;
+	(void)flags;
+	(void)callback;
+	(void)context;
+	(void)parallelism;
+	errno = ENOSYS;
+	return -1;
+#else
+	ETS_ASSERT(root && callback);
+
+	// the root itself is always followed, so a link to the tree crawls the tree
+	entry_info info;
+	if (stat_at(AT_FDCWD, root, true, info) != 0)
+		return -1;
+
+	std::string path = root;
+	while (path.size() > 1 && path.back() == '/')
+		path.pop_back();
+
+	crawler c;
+	c.flags = flags;
+	c.callback = callback;
+	c.context = context;
+	c.root_device = info.device;
+	{
+		batch b(c);
+		b.add(path, 0, info);
+		b.flush();
+	}
+	c.push(std::move(path), 0, info);
+
+	// one worker per thread: each takes directories off the queue until all have been read
+	const unsigned int workers = EternalTimestampParallel::concurrency(parallelism);
+	EternalTimestampParallel::parallel_for(workers, 1, parallelism, [&c](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++)
+			c.work();
+	});
+
+	if (stats) {
+		stats->entries = c.entries.load();
+		stats->directories = c.directories.load();
+		stats->errors = c.errors.load();
+	}
+	if (c.stopped.load()) {
+		errno = ECANCELED;
+		return -1;
+	}
+	return 0;
+#endif
+}
+
+int EternalTimestampFsCrawl::collect(const char *root, unsigned int flags, EternalTimestampFsColumns &dst, ets_fscrawl_stats_t *stats, unsigned int parallelism)
+{
+	if (dst.path_offsets.empty())
+		dst.path_offsets.push_back(dst.paths.size());
+	return crawl(root, flags, [&dst](const ets_fscrawl_entry_t *entries, size_t count) {
+		for (size_t i = 0; i < count; i++) {
+			const ets_fscrawl_entry_t &e = entries[i];
+			dst.paths.append(e.path, e.path_length);
+			dst.path_offsets.push_back(dst.paths.size());
+			dst.sizes.push_back(e.size);
+			dst.inodes.push_back(e.inode);
+			dst.modes.push_back(e.mode);
+			dst.atime.push_back(e.atime);
+			dst.mtime.push_back(e.mtime);
+			dst.ctime.push_back(e.ctime);
+			dst.btime.push_back(e.btime);
+		}
+		return true;
+	}, stats, parallelism);
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// C interface
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+extern "C" int ets_fscrawl(const char *root, unsigned int flags, ets_fscrawl_callback_t callback, void *context, ets_fscrawl_stats_t *stats, unsigned int parallelism)
+{
+	return EternalTimestampFsCrawl::crawl(root, flags, callback, context, stats, parallelism);
+}
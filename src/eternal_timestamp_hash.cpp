@@ -0,0 +1,531 @@
+
+#include "eternal_timestamp/eternal_timestamp_hash.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <new>
+
+#include "eternal_timestamp_instrumentation.h"
+#include "eternal_timestamp_internal.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ETS_HAVE_SSE2   1
+#endif
+
+
+using namespace eternal_timestamp;
+
+
+namespace
+{
+	// control bytes: a full slot holds the low 7 bits of its key's hash.
+	constexpr uint8_t CTRL_EMPTY = 0x80;
+	constexpr uint8_t CTRL_DELETED = 0xFE;
+
+	// how far ahead the bulk APIs prefetch
+	constexpr size_t PREFETCH_DISTANCE = 12;
+
+	inline void prefetch(const void *p)
+	{
+#if defined(__GNUC__)
+		__builtin_prefetch(p);
+#elif defined(ETS_HAVE_SSE2)
+		_mm_prefetch(static_cast<const char *>(p), _MM_HINT_T0);
+#else
+		(void)p;
+#endif
+	}
+
+	inline unsigned int lowest_bit(uint64_t mask)
+	{
+#if defined(__GNUC__)
+		return static_cast<unsigned int>(__builtin_ctzll(mask));
+#else
+		unsigned int n = 0;
+		while (!(mask & 1)) {
+			mask >>= 1;
+			n++;
+		}
+		return n;
+#endif
+	}
+
+#if defined(ETS_HAVE_SSE2)
+
+	// A group of control bytes; the match masks have bit `i` set for slot `i` of the group.
+	struct ctrl_group
+	{
+		static constexpr size_t WIDTH = 16;
+		static constexpr unsigned int SHIFT = 0;
+
+		__m128i ctrl;
+
+		explicit ctrl_group(const uint8_t *p) : ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p))) {}
+
+		uint64_t match(uint8_t h2) const
+		{
+			return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(static_cast<char>(h2)))));
+		}
+
+		uint64_t match_empty() const
+		{
+			return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(static_cast<char>(CTRL_EMPTY)))));
+		}
+
+		uint64_t match_empty_or_deleted() const
+		{
+			return static_cast<uint32_t>(_mm_movemask_epi8(ctrl));
+		}
+	};
+
+#else
+
+	// The same with 64-bit arithmetic: the match masks have bit `8 * i + 7` set for slot `i` of the group.
+	struct ctrl_group
+	{
+		static constexpr size_t WIDTH = 8;
+		static constexpr unsigned int SHIFT = 3;
+		static constexpr uint64_t LSBS = 0x0101010101010101ULL;
+		static constexpr uint64_t MSBS = 0x8080808080808080ULL;
+
+		uint64_t ctrl;
+
+		explicit ctrl_group(const uint8_t *p)
+		{
+			uint64_t v;
+			memcpy(&v, p, sizeof(v));
+			// make byte `i` the slot `i` on big-endian hosts too
+			const uint16_t probe = 1;
+			if (*reinterpret_cast<const uint8_t *>(&probe) == 0) {
+				uint64_t r = 0;
+				for (int i = 0; i < 8; i++)
+					r |= ((v >> (8 * i)) & 0xFF) << (8 * (7 - i));
+				v = r;
+			}
+			ctrl = v;
+		}
+
+		// may report false positives (slots whose key doesn't match), never false negatives
+		uint64_t match(uint8_t h2) const
+		{
+			const uint64_t x = ctrl ^ (LSBS * h2);
+			return (x - LSBS) & ~x & MSBS;
+		}
+
+		uint64_t match_empty() const
+		{
+			return ctrl & ~(ctrl << 6) & MSBS;
+		}
+
+		uint64_t match_empty_or_deleted() const
+		{
+			return ctrl & MSBS;
+		}
+	};
+
+#endif
+
+	inline size_t slot_in_group(uint64_t mask)
+	{
+		return lowest_bit(mask) >> ctrl_group::SHIFT;
+	}
+
+	inline size_t h1(uint64_t hash)
+	{
+		return static_cast<size_t>(hash >> 7);
+	}
+
+	inline uint8_t h2(uint64_t hash)
+	{
+		return static_cast<uint8_t>(hash & 0x7F);
+	}
+
+	// The probe sequence visits groups at triangular offsets from the home position: with a power of 2
+	// number of groups that visits every group.
+	struct probe_sequence
+	{
+		size_t mask;
+		size_t offset;
+		size_t index = 0;
+
+		probe_sequence(uint64_t hash, size_t mask) : mask(mask), offset(h1(hash) & mask) {}
+
+		void next()
+		{
+			index += ctrl_group::WIDTH;
+			offset = (offset + index) & mask;
+		}
+	};
+
+	// tables are at most 7/8 full
+	inline size_t max_load(size_t capacity)
+	{
+		return capacity - capacity / 8;
+	}
+
+	size_t capacity_for(size_t count)
+	{
+		size_t capacity = 2 * ctrl_group::WIDTH;
+		while (max_load(capacity) < count)
+			capacity *= 2;
+		return capacity;
+	}
+
+	// The control bytes are followed by a copy of the first group, so a group can be loaded at any position
+	// without wrapping around.
+	inline void set_ctrl(uint8_t *ctrl, size_t capacity, size_t slot, uint8_t v)
+	{
+		ctrl[slot] = v;
+		if (slot < ctrl_group::WIDTH)
+			ctrl[capacity + slot] = v;
+	}
+
+	inline void set_bit(uint8_t *bitmap, size_t i, bool v)
+	{
+		if (!bitmap)
+			return;
+		const uint8_t bit = static_cast<uint8_t>(1u << (i % 8));
+		if (v)
+			bitmap[i / 8] |= bit;
+		else
+			bitmap[i / 8] &= static_cast<uint8_t>(~bit);
+	}
+}
+
+
+EternalTimestampHashMap::EternalTimestampHashMap() noexcept
+	: EternalTimestampHashMap(true)
+{
+}
+
+EternalTimestampHashMap::EternalTimestampHashMap(bool with_values) noexcept
+	: ctrl_(nullptr), keys_(nullptr), values_(nullptr), capacity_(0), count_(0), growth_left_(0), with_values_(with_values)
+{
+}
+
+EternalTimestampHashMap::~EternalTimestampHashMap()
+{
+	free(ctrl_);
+}
+
+EternalTimestampHashMap::EternalTimestampHashMap(EternalTimestampHashMap &&other) noexcept
+	: ctrl_(other.ctrl_), keys_(other.keys_), values_(other.values_), capacity_(other.capacity_), count_(other.count_), growth_left_(other.growth_left_), with_values_(other.with_values_)
+{
+	other.ctrl_ = nullptr;
+	other.keys_ = nullptr;
+	other.values_ = nullptr;
+	other.capacity_ = other.count_ = other.growth_left_ = 0;
+}
+
+EternalTimestampHashMap &EternalTimestampHashMap::operator=(EternalTimestampHashMap &&other) noexcept
+{
+	if (this != &other) {
+		free(ctrl_);
+		ctrl_ = other.ctrl_;
+		keys_ = other.keys_;
+		values_ = other.values_;
+		capacity_ = other.capacity_;
+		count_ = other.count_;
+		growth_left_ = other.growth_left_;
+		with_values_ = other.with_values_;
+		other.ctrl_ = nullptr;
+		other.keys_ = nullptr;
+		other.values_ = nullptr;
+		other.capacity_ = other.count_ = other.growth_left_ = 0;
+	}
+	return *this;
+}
+
+int EternalTimestampHashMap::rehash(size_t capacity)
+{
+	// control bytes, padded to 8 bytes, then the keys, then the values
+	const size_t ctrl_size = (capacity + ctrl_group::WIDTH + 7) & ~size_t(7);
+	const size_t size = ctrl_size + capacity * sizeof(eternal_timestamp_t) + (with_values_ ? capacity * sizeof(uint64_t) : 0);
+	if (capacity > (SIZE_MAX - ctrl_size) / 32)
+		return ENOMEM;
+	uint8_t *ctrl = static_cast<uint8_t *>(malloc(size));
+	if (!ctrl)
+		return ENOMEM;
+	ETS_STATS_EVENT(HASH_MAP_REHASH);
+	memset(ctrl, CTRL_EMPTY, capacity + ctrl_group::WIDTH);
+	eternal_timestamp_t *keys = reinterpret_cast<eternal_timestamp_t *>(ctrl + ctrl_size);
+	uint64_t *values = (with_values_ ? reinterpret_cast<uint64_t *>(keys + capacity) : nullptr);
+
+	// all keys are distinct: just drop them in the first free slot
+	for (size_t i = 0; i < capacity_; i++) {
+		if (ctrl_[i] & 0x80)
+			continue;
+		const uint64_t hash = ets_hash(keys_[i]);
+		probe_sequence seq(hash, capacity - 1);
+		for (;;) {
+			const uint64_t free_slots = ctrl_group(ctrl + seq.offset).match_empty_or_deleted();
+			if (free_slots) {
+				const size_t slot = (seq.offset + slot_in_group(free_slots)) & (capacity - 1);
+				set_ctrl(ctrl, capacity, slot, h2(hash));
+				keys[slot] = keys_[i];
+				if (values)
+					values[slot] = values_[i];
+				break;
+			}
+			seq.next();
+		}
+	}
+
+	free(ctrl_);
+	ctrl_ = ctrl;
+	keys_ = keys;
+	values_ = values;
+	capacity_ = capacity;
+	growth_left_ = max_load(capacity) - count_;
+	return 0;
+}
+
+int EternalTimestampHashMap::reserve(size_t count)
+{
+	ETS_STATS_ENTRY(HASH_MAP_RESERVE);
+	if (count <= count_ + growth_left_)
+		return 0;
+	return rehash(capacity_for(count));
+}
+
+void EternalTimestampHashMap::clear() noexcept
+{
+	if (capacity_)
+		memset(ctrl_, CTRL_EMPTY, capacity_ + ctrl_group::WIDTH);
+	count_ = 0;
+	growth_left_ = (capacity_ ? max_load(capacity_) : 0);
+}
+
+// Find the key's slot, or the slot to insert it into.
+int EternalTimestampHashMap::prepare_insert(size_t &slot, const eternal_timestamp_t key, uint64_t hash, bool &present)
+{
+	if (capacity_) {
+		probe_sequence seq(hash, capacity_ - 1);
+		for (;;) {
+			const ctrl_group g(ctrl_ + seq.offset);
+			for (uint64_t m = g.match(h2(hash)); m; m &= m - 1) {
+				const size_t i = (seq.offset + slot_in_group(m)) & (capacity_ - 1);
+				if (keys_[i].t == key.t) {
+					slot = i;
+					present = true;
+					return 0;
+				}
+			}
+			if (g.match_empty())
+				break;
+			seq.next();
+		}
+	}
+	present = false;
+
+	// not present: take the first free slot along the probe sequence, after making room when that is an empty
+	// one and we're out of them.
+	for (;;) {
+		if (capacity_) {
+			probe_sequence seq(hash, capacity_ - 1);
+			uint64_t free_slots;
+			while (!(free_slots = ctrl_group(ctrl_ + seq.offset).match_empty_or_deleted()))
+				seq.next();
+			slot = (seq.offset + slot_in_group(free_slots)) & (capacity_ - 1);
+			if (ctrl_[slot] == CTRL_DELETED || growth_left_ > 0)
+				break;
+		}
+		// rehash in place when the table is mostly tombstones, otherwise grow
+		const size_t capacity = (capacity_ && count_ < max_load(capacity_) / 2 ? capacity_ : capacity_for(count_ + 1 > 2 * count_ ? count_ + 1 : 2 * count_));
+		if (rehash(capacity))
+			return ENOMEM;
+	}
+
+	if (ctrl_[slot] == CTRL_EMPTY)
+		growth_left_--;
+	set_ctrl(ctrl_, capacity_, slot, h2(hash));
+	keys_[slot] = key;
+	count_++;
+	return 0;
+}
+
+int EternalTimestampHashMap::insert(const eternal_timestamp_t key, uint64_t value, bool *inserted)
+{
+	ETS_STATS_ENTRY(HASH_MAP_INSERT);
+	size_t slot;
+	bool present;
+	const int rv = prepare_insert(slot, key, ets_hash(key), present);
+	if (rv)
+		return rv;
+	if (!present && values_)
+		values_[slot] = value;
+	if (inserted)
+		*inserted = !present;
+	return 0;
+}
+
+int EternalTimestampHashMap::assign(const eternal_timestamp_t key, uint64_t value)
+{
+	ETS_STATS_ENTRY(HASH_MAP_ASSIGN);
+	size_t slot;
+	bool present;
+	const int rv = prepare_insert(slot, key, ets_hash(key), present);
+	if (rv)
+		return rv;
+	if (values_)
+		values_[slot] = value;
+	return 0;
+}
+
+bool EternalTimestampHashMap::find(const eternal_timestamp_t key, uint64_t *value) const noexcept
+{
+	ETS_STATS_ENTRY(HASH_MAP_FIND);
+	if (!count_)
+		return false;
+	const uint64_t hash = ets_hash(key);
+	probe_sequence seq(hash, capacity_ - 1);
+	for (;;) {
+		const ctrl_group g(ctrl_ + seq.offset);
+		for (uint64_t m = g.match(h2(hash)); m; m &= m - 1) {
+			const size_t i = (seq.offset + slot_in_group(m)) & (capacity_ - 1);
+			if (keys_[i].t == key.t) {
+				if (value)
+					*value = (values_ ? values_[i] : 0);
+				return true;
+			}
+		}
+		if (g.match_empty())
+			return false;
+		seq.next();
+	}
+}
+
+bool EternalTimestampHashMap::erase(const eternal_timestamp_t key) noexcept
+{
+	ETS_STATS_ENTRY(HASH_MAP_ERASE);
+	if (!count_)
+		return false;
+	const uint64_t hash = ets_hash(key);
+	probe_sequence seq(hash, capacity_ - 1);
+	for (;;) {
+		const ctrl_group g(ctrl_ + seq.offset);
+		for (uint64_t m = g.match(h2(hash)); m; m &= m - 1) {
+			const size_t i = (seq.offset + slot_in_group(m)) & (capacity_ - 1);
+			if (keys_[i].t == key.t) {
+				set_ctrl(ctrl_, capacity_, i, CTRL_DELETED);
+				count_--;
+				return true;
+			}
+		}
+		if (g.match_empty())
+			return false;
+		seq.next();
+	}
+}
+
+int EternalTimestampHashMap::insert_batch(const eternal_timestamp_t *keys, const uint64_t *values, size_t count, uint8_t *inserted)
+{
+	ETS_STATS_ENTRY(HASH_MAP_INSERT_BATCH);
+	for (size_t i = 0; i < count; i++) {
+		if (i + PREFETCH_DISTANCE < count && capacity_) {
+			const uint64_t ahead = ets_hash(keys[i + PREFETCH_DISTANCE]);
+			const size_t home = h1(ahead) & (capacity_ - 1);
+			prefetch(ctrl_ + home);
+			prefetch(keys_ + home);
+		}
+
+		size_t slot;
+		bool present;
+		const int rv = prepare_insert(slot, keys[i], ets_hash(keys[i]), present);
+		if (rv)
+			return rv;
+		if (!present && values_)
+			values_[slot] = (values ? values[i] : i);
+		set_bit(inserted, i, !present);
+	}
+	return 0;
+}
+
+size_t EternalTimestampHashMap::find_batch(uint64_t *values, uint8_t *found, const eternal_timestamp_t *keys, size_t count, unsigned int parallelism) const noexcept
+{
+	ETS_STATS_ENTRY(HASH_MAP_FIND_BATCH);
+	// lookups only read the table: the chunks can go to any thread.
+	return ets_parallel_sum(count, parallelism, [this, values, found, keys](size_t begin, size_t end) {
+		size_t hits = 0;
+		for (size_t i = begin; i < end; i++) {
+			if (i + PREFETCH_DISTANCE < end && capacity_) {
+				const uint64_t ahead = ets_hash(keys[i + PREFETCH_DISTANCE]);
+				const size_t home = h1(ahead) & (capacity_ - 1);
+				prefetch(ctrl_ + home);
+				prefetch(keys_ + home);
+				if (values_ && values)
+					prefetch(values_ + home);
+			}
+
+			uint64_t v = 0;
+			const bool hit = find(keys[i], &v);
+			if (values)
+				values[i] = v;
+			set_bit(found, i, hit);
+			hits += hit;
+		}
+		return hits;
+	});
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// C interface
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct ets_hash_map
+{
+	EternalTimestampHashMap map;
+};
+
+extern "C" ets_hash_map_t *ets_hash_map_create(size_t expected_count)
+{
+	ets_hash_map_t *map = new (std::nothrow) ets_hash_map_t;
+	if (map && map->map.reserve(expected_count)) {
+		delete map;
+		map = nullptr;
+	}
+	return map;
+}
+
+extern "C" void ets_hash_map_destroy(ets_hash_map_t *map)
+{
+	delete map;
+}
+
+extern "C" size_t ets_hash_map_size(const ets_hash_map_t *map)
+{
+	return map->map.size();
+}
+
+extern "C" int ets_hash_map_insert(ets_hash_map_t *map, eternal_timestamp_t key, uint64_t value, int *inserted)
+{
+	bool b = false;
+	const int rv = map->map.insert(key, value, &b);
+	if (inserted)
+		*inserted = b;
+	return rv;
+}
+
+extern "C" int ets_hash_map_find(const ets_hash_map_t *map, eternal_timestamp_t key, uint64_t *value)
+{
+	return map->map.find(key, value);
+}
+
+extern "C" int ets_hash_map_erase(ets_hash_map_t *map, eternal_timestamp_t key)
+{
+	return map->map.erase(key);
+}
+
+extern "C" int ets_hash_map_insert_batch(ets_hash_map_t *map, const eternal_timestamp_t *keys, const uint64_t *values, size_t count, uint8_t *inserted)
+{
+	return map->map.insert_batch(keys, values, count, inserted);
+}
+
+extern "C" size_t ets_hash_map_find_batch(const ets_hash_map_t *map, uint64_t *values, uint8_t *found, const eternal_timestamp_t *keys, size_t count)
+{
+	return map->map.find_batch(values, found, keys, count);
+}
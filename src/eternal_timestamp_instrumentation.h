@@ -0,0 +1,120 @@
+
+#pragma once
+
+#ifndef __ETERNAL_TIMESTAMP_INSTRUMENTATION_H__
+#define __ETERNAL_TIMESTAMP_INSTRUMENTATION_H__
+
+// The counting end of `eternal_timestamp_stats.h`.
+//
+// - `ETS_STATS_ENTRY(id)` goes at the top of a public entry point: it counts the call and, with the timers
+//   compiled in, times the remainder of the enclosing scope.
+// - `ETS_STATS_EVENT(id)` counts an event; `ETS_STATS_EVENT_IF(id, cond)` counts it when `cond` holds.
+//
+// Unless `ETS_ENABLE_INSTRUMENTATION` is defined these expand to nothing at all; `cond` is not evaluated either,
+// so it may be as expensive as it needs to be.
+//
+// This header is NOT part of the public interface: it is not installed and may change at any time.
+
+#include "eternal_timestamp/eternal_timestamp_stats.h"
+
+#if defined(ETS_ENABLE_INSTRUMENTATION)
+
+#include <atomic>
+#include <stdint.h>
+
+#if defined(ETS_ENABLE_INSTRUMENTATION_TIMERS)
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define ETS_STATS_HAVE_TSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define ETS_STATS_HAVE_TSC 1
+#else
+#include <chrono>
+#endif
+#endif
+
+// The counters of one thread. Only the owning thread writes them, hence the plain load + store instead of an
+// atomic read-modify-write; the atomics merely make the reads from snapshot() well-defined.
+//
+// Blocks are never freed: when a thread exits its block goes to the next thread which starts counting, which
+// keeps the sums right without having to fold anything anywhere.
+struct alignas(64) ets_stats_block
+{
+	std::atomic<uint64_t> count[ETS_STATS_COUNT];
+	std::atomic<uint64_t> ticks[ETS_STATS_COUNT];
+	ets_stats_block *next;
+	bool in_use;
+};
+
+extern thread_local ets_stats_block *ets_stats_current_block;
+
+// Attach a block to the calling thread. NULL when the thread is exiting and has let go of its block already.
+ets_stats_block *ets_stats_attach_thread();
+
+static inline void ets_stats_bump(std::atomic<uint64_t> &c, uint64_t n)
+{
+	c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+static inline void ets_stats_add(int id, uint64_t n)
+{
+	ets_stats_block *b = ets_stats_current_block;
+	if (!b && !(b = ets_stats_attach_thread()))
+		return;
+	ets_stats_bump(b->count[id], n);
+}
+
+#if defined(ETS_ENABLE_INSTRUMENTATION_TIMERS)
+
+static inline uint64_t ets_stats_ticks()
+{
+#if defined(ETS_STATS_HAVE_TSC)
+	return __rdtsc();
+#else
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+class ets_stats_timed_scope
+{
+public:
+	explicit ets_stats_timed_scope(int id) : id_(id), start_(ets_stats_ticks())
+	{
+	}
+
+	~ets_stats_timed_scope()
+	{
+		const uint64_t elapsed = ets_stats_ticks() - start_;
+		ets_stats_block *b = ets_stats_current_block;
+		if (!b && !(b = ets_stats_attach_thread()))
+			return;
+		ets_stats_bump(b->count[id_], 1);
+		ets_stats_bump(b->ticks[id_], elapsed);
+	}
+
+	ets_stats_timed_scope(const ets_stats_timed_scope &) = delete;
+	ets_stats_timed_scope &operator=(const ets_stats_timed_scope &) = delete;
+
+private:
+	int id_;
+	uint64_t start_;
+};
+
+#define ETS_STATS_ENTRY(id)               ets_stats_timed_scope ets_stats_scope_(ETS_STATS_##id)
+#else
+#define ETS_STATS_ENTRY(id)               ets_stats_add(ETS_STATS_##id, 1)
+#endif
+
+#define ETS_STATS_EVENT(id)               ets_stats_add(ETS_STATS_##id, 1)
+#define ETS_STATS_EVENT_IF(id, cond)      ((cond) ? ets_stats_add(ETS_STATS_##id, 1) : (void)0)
+
+#else
+
+#define ETS_STATS_ENTRY(id)               (void)0
+#define ETS_STATS_EVENT(id)               (void)0
+#define ETS_STATS_EVENT_IF(id, cond)      (void)0
+
+#endif // ETS_ENABLE_INSTRUMENTATION
+
+#endif // __ETERNAL_TIMESTAMP_INSTRUMENTATION_H__
@@ -0,0 +1,642 @@
+
+#pragma once
+
+#ifndef __ETERNAL_TIMESTAMP_INTERNAL_H__
+#define __ETERNAL_TIMESTAMP_INTERNAL_H__
+
+// Internal helpers shared by the libeternaltimestamp translation units.
+//
+// This header is NOT part of the public interface: it is not installed and may change at any time.
+
+#include "eternal_timestamp/eternal_timestamp.h"
+#include "eternal_timestamp/eternal_timestamp_layout.h"
+#include "eternal_timestamp/eternal_timestamp_parallel.h"
+
+#include <atomic>
+#include <stdint.h>
+#include <limits.h>
+#include <string.h>
+
+#ifndef NDEBUG
+#include <stdio.h>
+#include <stdlib.h>
+
+#define ETS_ASSERT(t)			((t) ? (void)0 : (void)fprintf(stderr, "ETTM assertion %s failed at %s:%d\n", #t, __FILE__, __LINE__))
+#else
+#define ETS_ASSERT(t)			(void)0
+#endif
+
+
+// The library's own format, as described by `enum eternal_timestamp_field_layout` in eternal_timestamp.h.
+typedef eternal_timestamp::EternalTimestampLayout<> ets_native_layout;
+
+enum fieldsize : unsigned int
+{
+	ETMT_FIELDSIZE_CENTURY = ets_native_layout::modern::century::width,
+	ETMT_FIELDSIZE_YEAR = ets_native_layout::modern::year::width,
+	ETMT_FIELDSIZE_MONTH = ets_native_layout::modern::month::width,
+	ETMT_FIELDSIZE_DAY = ets_native_layout::modern::day::width,
+	ETMT_FIELDSIZE_HOUR = ets_native_layout::modern::hour::width,
+	ETMT_FIELDSIZE_MINUTE = ets_native_layout::modern::minute::width,
+	ETMT_FIELDSIZE_SECONDS = ets_native_layout::modern::seconds::width,
+	ETMT_FIELDSIZE_MILLISECONDS = ets_native_layout::modern::milliseconds::width,
+	ETMT_FIELDSIZE_MICROSECONDS = ets_native_layout::modern::microseconds::width,
+
+	ETPHT_FIELDSIZE_YEARS = ets_native_layout::prehistoric::years::width,
+	ETPHT_FIELDSIZE_MONTH = ets_native_layout::prehistoric::month::width,
+	ETPHT_FIELDSIZE_DAY = ets_native_layout::prehistoric::day::width,
+	ETPHT_FIELDSIZE_HOUR = ets_native_layout::prehistoric::hour::width,
+	ETPHT_FIELDSIZE_MINUTE = ets_native_layout::prehistoric::minute::width,
+	ETPHT_FIELDSIZE_PRECISION = ets_native_layout::prehistoric::precision::width,
+};
+
+// Produce the "this-is-invalid-or-unknown" value for this field, being the maximum value available.
+constexpr inline unsigned int get_MaxInvalid(unsigned int field_size_in_bits)
+{
+	const unsigned int invalid = (1 << field_size_in_bits) - 1;
+	return invalid;
+}
+
+// Produce the "this-is-invalid-or-unknown" value for this field, being the minimum value available.
+constexpr inline unsigned int get_MinInvalid(unsigned int field_size_in_bits)
+{
+	const unsigned int invalid = 0;
+	return invalid;
+}
+
+
+#if ETS_UNSPECIFIED_MARKER_SORTS_BEFORE_1ST_VALUE
+
+// Produce the "this-is-invalid-or-unknown" value for this field.
+constexpr inline unsigned int get_Invalid(unsigned int field_size_in_bits)
+{
+	return get_MinInvalid(field_size_in_bits);
+}
+
+// Clip the field value to its legal range or signal it as 'invalid'.
+//
+// - `v` is the field value to clip.
+// - `field_size_in_bits` is the field's size in bits.
+// - `value_range` is the legal range for this field's value. For example, for the hour field this would be 24.
+//
+// As the eternal_timestamp library is compiled as using 0 for the field's invalid value,
+// the actual legal value range is $[1,\text{value_range}]$, which f.e. for the hour field would then
+// be the range $[1,24]$.
+constexpr inline unsigned int clip_Invalid(int v, unsigned int field_size_in_bits, int value_range)
+{
+	const unsigned int invalid = get_Invalid(field_size_in_bits);
+	v++;
+	// clip to value range [1..value_range]
+	if (v <= 0)
+		return invalid;
+	if (v > value_range)
+		return invalid;
+	return v;
+}
+
+static constexpr int FIELD_VAL_OFFSET = 1;
+
+#else
+
+// Produce the "this-is-invalid-or-unknown" value for this field.
+constexpr inline unsigned int get_Invalid(unsigned int field_size_in_bits)
+{
+	return get_MaxInvalid(field_size_in_bits);
+}
+
+// Clip the field value to its legal range or signal it as 'invalid'.
+//
+// - `v` is the field value to clip.
+// - `field_size_in_bits` is the field's size in bits.
+// - `value_range` is the legal range for this field's value. For example, for the hour field this would be 24.
+//
+// As the eternal_timestamp library is compiled as using the maximum field value for the field's invalid value,
+// the actual legal value range is $[0,\text{value_range}-1]$, which f.e. for the hour field would then
+// be the range $[0,23]$.
+constexpr inline unsigned int clip_Invalid(int v, unsigned int field_size_in_bits, int value_range)
+{
+	const unsigned int invalid = get_MaxInvalid(field_size_in_bits);
+	// clip
+	if (v < 0)
+		return invalid;
+	if (v >= value_range)
+		return invalid;
+	return v;
+}
+
+static constexpr int FIELD_VAL_OFFSET = 0;
+
+#endif // ETS_UNSPECIFIED_MARKER_SORTS_BEFORE_1ST_VALUE
+
+static_assert(ets_native_layout::value_offset == FIELD_VAL_OFFSET && ets_native_layout::unspecified(ETMT_FIELDSIZE_HOUR) == get_Invalid(ETMT_FIELDSIZE_HOUR), "the native layout must use the configured 'unspecified' marker");
+
+
+static constexpr const int MODERN_EPOCH = 10000;    // 10000 B.C.
+static constexpr const int PREHISTORIC_EPOCH = 0;   // 0 A.D.
+
+static constexpr const int64_t USECS_PER_SECOND = 1000000;
+static constexpr const int64_t USECS_PER_DAY = 86400 * USECS_PER_SECOND;
+
+
+// Proleptic Gregorian calendar: number of days since 1970/jan/01 for the given civil date.
+//
+// See Howard Hinnant's "chrono-Compatible Low-Level Date Algorithms" (http://howardhinnant.github.io/date_algorithms.html);
+// this works for the entire `int` year range, hence it covers the entire *modern* timestamp range.
+static constexpr inline int64_t ets_days_from_civil(int64_t y, unsigned int m, unsigned int d)
+{
+	y -= m <= 2;
+	const int64_t era = (y >= 0 ? y : y - 399) / 400;
+	const unsigned int yoe = static_cast<unsigned int>(y - era * 400);               // [0, 399]
+	const unsigned int doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;        // [0, 365]
+	const unsigned int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;                  // [0, 146096]
+	return era * 146097 + static_cast<int64_t>(doe) - 719468;
+}
+
+// The inverse of `ets_days_from_civil()`.
+static inline void ets_civil_from_days(int64_t z, int64_t &y, unsigned int &m, unsigned int &d)
+{
+	z += 719468;
+	const int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+	const unsigned int doe = static_cast<unsigned int>(z - era * 146097);            // [0, 146096]
+	const unsigned int yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;  // [0, 399]
+	const unsigned int doy = doe - (365 * yoe + yoe / 4 - yoe / 100);                // [0, 365]
+	const unsigned int mp = (5 * doy + 2) / 153;                                     // [0, 11]
+	d = doy - (153 * mp + 2) / 5 + 1;                                                // [1, 31]
+	m = mp < 10 ? mp + 3 : mp - 9;                                                   // [1, 12]
+	y = static_cast<int64_t>(yoe) + era * 400 + (m <= 2);
+}
+
+static inline bool ets_is_leap_year(int64_t y)
+{
+	return y % 4 == 0 && (y % 100 != 0 || y % 400 == 0);
+}
+
+// The number of days in month `m` (1..12) of year `y`.
+static inline unsigned int ets_month_length(int64_t y, unsigned int m)
+{
+	static const unsigned char days[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+	return days[m - 1] + (m == 2 && ets_is_leap_year(y) ? 1 : 0);
+}
+
+// The core conversions between civil dates/times, UNIX time and the modern subformat, for any
+// `EternalTimestampLayout` `L`: they work on raw 64-bit values. The `eternal_timestamp_t` versions further below
+// are their instantiations for the library's own format, `ets_native_layout`.
+
+// The years a complete modern timestamp can carry: from the first specified century (9901 B.C.) up to the end
+// of the highest century code which does not signal 'unspecified'.
+template <class L>
+constexpr inline int ets_layout_min_year()
+{
+	return 100 - L::modern_epoch;
+}
+
+template <class L>
+constexpr inline int ets_layout_max_year()
+{
+	return static_cast<int>(L::modern::century::max - (L::unspecified_sorts_first ? 0 : 1)) * 100 + 99 - L::modern_epoch;
+}
+
+// The same range as microseconds since 1970/jan/01 00:00:00 UTC: what `ets_layout_encode_modern_from_unix_usecs()` accepts.
+template <class L>
+constexpr inline int64_t ets_layout_min_unix_usecs()
+{
+	return ets_days_from_civil(ets_layout_min_year<L>(), 1, 1) * USECS_PER_DAY;
+}
+
+template <class L>
+constexpr inline int64_t ets_layout_max_unix_usecs()
+{
+	return ets_days_from_civil(ets_layout_max_year<L>() + 1, 1, 1) * USECS_PER_DAY - 1;
+}
+
+// Field `F` of layout `L` holding the zero-based `value`, resp. the zero-based value held by field `F`, which
+// MUST NOT be 'unspecified'.
+template <class L, class F>
+constexpr inline uint64_t ets_layout_put(const uint64_t t, const unsigned int value)
+{
+	return F::set(t, L::value_offset + value);
+}
+
+template <class L, class F>
+constexpr inline unsigned int ets_layout_value(const uint64_t t)
+{
+	return static_cast<unsigned int>(F::get(t) - L::value_offset);
+}
+
+// Encode a complete, valid, civil date as a *modern* timestamp whose time-of-day fields are all 'unspecified'.
+//
+// `year` is the astronomical year number (0 is 1 B.C., negative values are B.C.), `month` and `day` use their
+// 'natural' range: month 1..12, day 1..31.
+template <class L>
+inline uint64_t ets_layout_encode_modern_date(int year, unsigned int month, unsigned int day)
+{
+	typedef typename L::modern M;
+
+	const int y = year + L::modern_epoch;
+	ETS_ASSERT(y >= 100);
+	uint64_t t = L::unknown();
+	t = M::century::set(t, static_cast<unsigned int>(y / 100));
+	t = ets_layout_put<L, typename M::year>(t, static_cast<unsigned int>(y % 100));
+	t = ets_layout_put<L, typename M::month>(t, month - 1);
+	t = ets_layout_put<L, typename M::day>(t, day - 1);
+	return t;
+}
+
+// Set the time-of-day fields of `date`, a modern timestamp, to the given number of microseconds since midnight.
+template <class L>
+inline uint64_t ets_layout_set_time_of_day(uint64_t date, int64_t usecs)
+{
+	typedef typename L::modern M;
+
+	date = ets_layout_put<L, typename M::microseconds>(date, static_cast<unsigned int>(usecs % 1000));
+	usecs /= 1000;
+	date = ets_layout_put<L, typename M::milliseconds>(date, static_cast<unsigned int>(usecs % 1000));
+	usecs /= 1000;
+	date = ets_layout_put<L, typename M::seconds>(date, static_cast<unsigned int>(usecs % 60));
+	usecs /= 60;
+	date = ets_layout_put<L, typename M::minute>(date, static_cast<unsigned int>(usecs % 60));
+	return ets_layout_put<L, typename M::hour>(date, static_cast<unsigned int>(usecs / 60));
+}
+
+// Encode a complete, valid, civil date/time as a *modern* timestamp: see `ets_layout_encode_modern_date()`. The
+// time-of-day fields use their 'natural' range as well: hour 0..23, etc.
+template <class L>
+inline uint64_t ets_layout_encode_modern(int year, unsigned int month, unsigned int day, unsigned int hour, unsigned int minute, unsigned int second, unsigned int millisecond, unsigned int microsecond)
+{
+	typedef typename L::modern M;
+
+	uint64_t t = ets_layout_encode_modern_date<L>(year, month, day);
+	t = ets_layout_put<L, typename M::hour>(t, hour);
+	t = ets_layout_put<L, typename M::minute>(t, minute);
+	t = ets_layout_put<L, typename M::seconds>(t, second);
+	t = ets_layout_put<L, typename M::milliseconds>(t, millisecond);
+	return ets_layout_put<L, typename M::microseconds>(t, microsecond);
+}
+
+// Encode the given number of microseconds since 1970/jan/01 00:00:00 UTC as a complete *modern* timestamp.
+//
+// `usecs` MUST be within [ets_layout_min_unix_usecs(), ets_layout_max_unix_usecs()].
+template <class L>
+inline uint64_t ets_layout_encode_modern_from_unix_usecs(int64_t usecs)
+{
+	int64_t days = usecs / USECS_PER_DAY;
+	int64_t rest = usecs % USECS_PER_DAY;
+	if (rest < 0) {
+		rest += USECS_PER_DAY;
+		days--;
+	}
+	int64_t y;
+	unsigned int m, d;
+	ets_civil_from_days(days, y, m, d);
+	return ets_layout_set_time_of_day<L>(ets_layout_encode_modern_date<L>(static_cast<int>(y), m, d), rest);
+}
+
+// Return `true` when the timestamp is a modern one with a complete date, i.e. century, year, month and day are all specified.
+template <class L>
+inline bool ets_layout_has_complete_modern_date(const uint64_t t)
+{
+	typedef typename L::modern M;
+
+	return L::is_modern_format(t)
+		&& !L::template is_unspecified<typename M::century>(t)
+		&& !L::template is_unspecified<typename M::year>(t)
+		&& !L::template is_unspecified<typename M::month>(t)
+		&& !L::template is_unspecified<typename M::day>(t);
+}
+
+// The astronomical year of a modern timestamp which carries a century and a year.
+template <class L>
+inline int64_t ets_layout_modern_year(const uint64_t t)
+{
+	typedef typename L::modern M;
+
+	return static_cast<int64_t>(M::century::get(t)) * 100 + ets_layout_value<L, typename M::year>(t) - L::modern_epoch;
+}
+
+// Return `true` when all specified fields of a modern timestamp hold a value within their natural range: year
+// 0..99 within the century, month 1..12, day within the month (leap years included), hour 0..23, minute and
+// second 0..59, milliseconds and microseconds 0..999. Any bits pattern fits the fields, hence the check.
+template <class L>
+inline bool ets_layout_has_valid_modern_fields(const uint64_t t)
+{
+	typedef typename L::modern M;
+
+	const bool has_year = !L::template is_unspecified<typename M::century>(t) && !L::template is_unspecified<typename M::year>(t);
+	if (!L::template is_unspecified<typename M::year>(t) && ets_layout_value<L, typename M::year>(t) > 99)
+		return false;
+	unsigned int length = 31;
+	if (!L::template is_unspecified<typename M::month>(t)) {
+		const unsigned int m = ets_layout_value<L, typename M::month>(t) + 1;
+		if (m > 12)
+			return false;
+		// without a year February may be a leap one.
+		length = (has_year ? ets_month_length(ets_layout_modern_year<L>(t), m) : ets_month_length(2000, m));
+	}
+	return (L::template is_unspecified<typename M::day>(t) || ets_layout_value<L, typename M::day>(t) < length)
+		&& (L::template is_unspecified<typename M::hour>(t) || ets_layout_value<L, typename M::hour>(t) < 24)
+		&& (L::template is_unspecified<typename M::minute>(t) || ets_layout_value<L, typename M::minute>(t) < 60)
+		&& (L::template is_unspecified<typename M::seconds>(t) || ets_layout_value<L, typename M::seconds>(t) < 60)
+		&& (L::template is_unspecified<typename M::milliseconds>(t) || ets_layout_value<L, typename M::milliseconds>(t) < 1000)
+		&& (L::template is_unspecified<typename M::microseconds>(t) || ets_layout_value<L, typename M::microseconds>(t) < 1000);
+}
+
+// The time of day of a modern timestamp in microseconds since midnight: unspecified fields are taken as zero(0).
+template <class L>
+inline int64_t ets_layout_modern_time_of_day_usecs(const uint64_t t)
+{
+	typedef typename L::modern M;
+
+	const int64_t hh = (L::template is_unspecified<typename M::hour>(t) ? 0 : ets_layout_value<L, typename M::hour>(t));
+	const int64_t mm = (L::template is_unspecified<typename M::minute>(t) ? 0 : ets_layout_value<L, typename M::minute>(t));
+	const int64_t ss = (L::template is_unspecified<typename M::seconds>(t) ? 0 : ets_layout_value<L, typename M::seconds>(t));
+	const int64_t ms = (L::template is_unspecified<typename M::milliseconds>(t) ? 0 : ets_layout_value<L, typename M::milliseconds>(t));
+	const int64_t us = (L::template is_unspecified<typename M::microseconds>(t) ? 0 : ets_layout_value<L, typename M::microseconds>(t));
+	return ((hh * 60 + mm) * 60 + ss) * USECS_PER_SECOND + ms * 1000 + us;
+}
+
+// Decode a *modern* timestamp into the number of microseconds since 1970/jan/01 00:00:00 UTC.
+//
+// Unspecified time-of-day fields are taken as zero(0); unspecified month/day fields are taken as 1.
+// Returns 0 on success, -1 when the timestamp is not modern, lacks a century+year or has a field out of range.
+template <class L>
+inline int ets_layout_decode_modern_to_unix_usecs(int64_t &dst, const uint64_t t)
+{
+	typedef typename L::modern M;
+
+	if (!L::is_modern_format(t) || L::template is_unspecified<typename M::century>(t) || L::template is_unspecified<typename M::year>(t) || !ets_layout_has_valid_modern_fields<L>(t))
+		return -1;
+
+	const unsigned int m = (L::template is_unspecified<typename M::month>(t) ? 1 : ets_layout_value<L, typename M::month>(t) + 1);
+	const unsigned int d = (L::template is_unspecified<typename M::day>(t) ? 1 : ets_layout_value<L, typename M::day>(t) + 1);
+	dst = ets_days_from_civil(ets_layout_modern_year<L>(t), m, d) * USECS_PER_DAY + ets_layout_modern_time_of_day_usecs<L>(t);
+	return 0;
+}
+
+// Parse an ISO 8601 date/time like `EternalTimestamp::cvt_from_iso8601()` does, into a timestamp in layout `L`.
+// Defined for `EternalTimestampUnspecifiedFirstLayout`, `EternalTimestampUnspecifiedLastLayout` and
+// `EternalTimestampExtendedLayout`.
+template <class L>
+int ets_layout_cvt_from_iso8601(uint64_t &dst, const char *str, size_t length);
+
+
+// The above, for the library's own format.
+static constexpr const int ETS_MODERN_MIN_YEAR = ets_layout_min_year<ets_native_layout>();
+static constexpr const int ETS_MODERN_MAX_YEAR = ets_layout_max_year<ets_native_layout>();
+
+static constexpr const int64_t ETS_MODERN_MIN_UNIX_USECS = ets_layout_min_unix_usecs<ets_native_layout>();
+static constexpr const int64_t ETS_MODERN_MAX_UNIX_USECS = ets_layout_max_unix_usecs<ets_native_layout>();
+
+static inline eternal_timestamp_t ets_encode_modern(int year, unsigned int month, unsigned int day, unsigned int hour, unsigned int minute, unsigned int second, unsigned int millisecond, unsigned int microsecond)
+{
+	return ETS_TIMESTAMP(ets_layout_encode_modern<ets_native_layout>(year, month, day, hour, minute, second, millisecond, microsecond));
+}
+
+// Produce a modern timestamp which has all fields set to 'not specified'.
+static inline eternal_timestamp_t ets_make_unknown()
+{
+	return ETS_TIMESTAMP(ets_native_layout::unknown());
+}
+
+static inline bool ets_has_complete_modern_date(const eternal_timestamp_t t)
+{
+	return ets_layout_has_complete_modern_date<ets_native_layout>(t.t);
+}
+
+static inline bool ets_has_valid_modern_fields(const eternal_timestamp_t t)
+{
+	return ets_layout_has_valid_modern_fields<ets_native_layout>(t.t);
+}
+
+// Whether any of the fields is unspecified; the seconds and sub-seconds which the prehistoric subformat lacks
+// don't count as such.
+static inline bool ets_has_unspecified_fields(const eternal_timestamp_t t)
+{
+	if (!ets_format_mode(t)) {
+		return ets_modern_century(t) == get_Invalid(ETMT_FIELDSIZE_CENTURY)
+			|| ets_modern_year(t) == get_Invalid(ETMT_FIELDSIZE_YEAR)
+			|| ets_modern_month(t) == get_Invalid(ETMT_FIELDSIZE_MONTH)
+			|| ets_modern_day(t) == get_Invalid(ETMT_FIELDSIZE_DAY)
+			|| ets_modern_hour(t) == get_Invalid(ETMT_FIELDSIZE_HOUR)
+			|| ets_modern_minute(t) == get_Invalid(ETMT_FIELDSIZE_MINUTE)
+			|| ets_modern_seconds(t) == get_Invalid(ETMT_FIELDSIZE_SECONDS)
+			|| ets_modern_milliseconds(t) == get_Invalid(ETMT_FIELDSIZE_MILLISECONDS)
+			|| ets_modern_microseconds(t) == get_Invalid(ETMT_FIELDSIZE_MICROSECONDS);
+	}
+	return ets_prehistoric_years(t) == get_Invalid(ETPHT_FIELDSIZE_YEARS)
+		|| ets_prehistoric_month(t) == get_Invalid(ETPHT_FIELDSIZE_MONTH)
+		|| ets_prehistoric_day(t) == get_Invalid(ETPHT_FIELDSIZE_DAY)
+		|| ets_prehistoric_hour(t) == get_Invalid(ETPHT_FIELDSIZE_HOUR)
+		|| ets_prehistoric_minute(t) == get_Invalid(ETPHT_FIELDSIZE_MINUTE);
+}
+
+static inline eternal_timestamp_t ets_encode_modern_from_unix_usecs(int64_t usecs)
+{
+	return ETS_TIMESTAMP(ets_layout_encode_modern_from_unix_usecs<ets_native_layout>(usecs));
+}
+
+static inline int ets_decode_modern_to_unix_usecs(int64_t &dst, const eternal_timestamp_t t)
+{
+	return ets_layout_decode_modern_to_unix_usecs<ets_native_layout>(dst, t.t);
+}
+
+
+// SWAR ("SIMD within a register") digit validation and conversion for fixed-layout text, e.g. "2022-01-13".
+//
+// A layout pattern describes 8 bytes of text: 'd' denotes a decimal digit, '*' any character, while all other
+// characters must match literally.
+struct ets_word_pattern
+{
+	uint64_t digits;      // 0xFF in the lanes (bytes) which must hold a digit
+	uint64_t wildcards;   // 0xFF in the lanes which may hold anything
+	uint64_t literal;     // the expected bytes in the remaining lanes; zero elsewhere
+};
+
+constexpr inline uint64_t ets_pattern_lanes(const char *pattern, char c, int i = 0)
+{
+	return i == 8 ? 0 : (uint64_t(pattern[i] == c ? 0xFF : 0) << (8 * i)) | ets_pattern_lanes(pattern, c, i + 1);
+}
+
+constexpr inline uint64_t ets_pattern_literal(const char *pattern, int i = 0)
+{
+	return i == 8 ? 0 : (uint64_t(pattern[i] == 'd' || pattern[i] == '*' ? 0 : static_cast<unsigned char>(pattern[i])) << (8 * i)) | ets_pattern_literal(pattern, i + 1);
+}
+
+constexpr inline ets_word_pattern ets_make_word_pattern(const char *pattern)
+{
+	return ets_word_pattern{ ets_pattern_lanes(pattern, 'd'), ets_pattern_lanes(pattern, '*'), ets_pattern_literal(pattern) };
+}
+
+// Load 8 bytes of text as a little-endian word: the first character lands in the lowest byte.
+static inline uint64_t ets_load_le64(const char *p)
+{
+	uint64_t w;
+	memcpy(&w, p, sizeof(w));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	w = __builtin_bswap64(w);
+#endif
+	return w;
+}
+
+// Match the word against the pattern. On success, produce the 2-digit numbers starting at each lane:
+// byte `i` of `pairs` is `10 * digit[i] + digit[i + 1]`, so e.g. a 4-digit year at lane 0 is
+// `pair(0) * 100 + pair(2)`. (The value in the last digit lane of the word is just that digit times ten.)
+static inline bool ets_match_word(uint64_t w, const ets_word_pattern &pattern, uint64_t &pairs)
+{
+	if ((w & ~(pattern.digits | pattern.wildcards)) != pattern.literal)
+		return false;
+	const uint64_t digits = (w & pattern.digits) | (0x3030303030303030ull & ~pattern.digits);
+	if (((digits & 0xF0F0F0F0F0F0F0F0ull) | (((digits + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) >> 4)) != 0x3333333333333333ull)
+		return false;
+	const uint64_t d = digits - 0x3030303030303030ull;
+	pairs = d * 10 + (d >> 8);
+	return true;
+}
+
+static inline unsigned int ets_word_pair(uint64_t pairs, int lane)
+{
+	return static_cast<unsigned int>(pairs >> (8 * lane)) & 0xFF;
+}
+
+// The reverse: text output two digits at a time through a "00".."99" lookup table.
+struct ets_digit_pairs
+{
+	char d[200];
+
+	constexpr ets_digit_pairs() : d()
+	{
+		for (int i = 0; i < 100; i++) {
+			d[2 * i] = static_cast<char>('0' + i / 10);
+			d[2 * i + 1] = static_cast<char>('0' + i % 10);
+		}
+	}
+};
+
+static constexpr ets_digit_pairs ets_digit_pair_table;
+
+// write `v` (0..99) as two digits.
+static inline char *ets_put2(char *p, unsigned int v)
+{
+	memcpy(p, ets_digit_pair_table.d + 2 * v, 2);
+	return p + 2;
+}
+
+// write `v` (0..999) as three digits.
+static inline char *ets_put3(char *p, unsigned int v)
+{
+	*p++ = static_cast<char>('0' + v / 100);
+	return ets_put2(p, v % 100);
+}
+
+// Return the number of leading (i.e. lowest lanes) decimal digits in the word: 0..8.
+static inline int ets_count_digits(uint64_t w)
+{
+	// the top bit of each lane is set when the lane does NOT hold a digit.
+	const uint64_t non_digit = ((w & 0xF0F0F0F0F0F0F0F0ull) ^ 0x3030303030303030ull) | (((w + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) ^ 0x3030303030303030ull);
+	const uint64_t mask = ((non_digit | (non_digit << 1) | (non_digit << 2) | (non_digit << 3)) & 0x8080808080808080ull);
+	if (!mask)
+		return 8;
+#if defined(__GNUC__)
+	return __builtin_ctzll(mask) / 8;
+#else
+	int n = 0;
+	for (uint64_t m = mask; !(m & 0x80); m >>= 8)
+		n++;
+	return n;
+#endif
+}
+
+// Convert the first `n` (1..8) digits of the word to their numeric value.
+static inline uint32_t ets_parse_digits(uint64_t w, int n)
+{
+	// move the digits to the top lanes, so the lanes below read as leading zeroes:
+	uint64_t d = (w - 0x3030303030303030ull) << (8 * (8 - n));
+	d = d * 10 + (d >> 8);
+	d = (((d & 0x000000FF000000FFull) * (100 + (1000000ull << 32))) + (((d >> 16) & 0x000000FF000000FFull) * (1 + (10000ull << 32)))) >> 32;
+	return static_cast<uint32_t>(d);
+}
+
+// Run `kernel(begin, end)` over the column in chunks of `ETS_PARALLEL_GRAIN` values, on up to `parallelism`
+// threads, and return the sum of what it returns: the failure counts of the bulk conversions.
+//
+// The chunks start at multiples of 64, hence at whole bytes of the validity bitmaps: see `ets_bitmap_at()`.
+template <typename F>
+static inline size_t ets_parallel_sum(size_t count, unsigned int parallelism, F &&kernel)
+{
+	std::atomic<size_t> sum{ 0 };
+	eternal_timestamp::EternalTimestampParallel::parallel_for(count, ETS_PARALLEL_GRAIN, parallelism, [&](size_t begin, size_t end) {
+		const size_t n = kernel(begin, end);
+		if (n)
+			sum.fetch_add(n, std::memory_order_relaxed);
+	});
+	return sum.load(std::memory_order_relaxed);
+}
+
+// The validity bitmap (which MAY be NULL) of a chunk starting at `begin`, a multiple of 8.
+static inline uint8_t *ets_bitmap_at(uint8_t *validity, size_t begin)
+{
+	ETS_ASSERT(begin % 8 == 0);
+	return (validity ? validity + begin / 8 : nullptr);
+}
+
+// The number of chunks `ets_parallel_text_column()` renders per round; their shifts are kept on the stack.
+#define ETS_PARALLEL_TEXT_CHUNKS    256
+
+// Render values `start` up to `count` of an Apache Arrow `utf8` column on up to `parallelism` threads.
+//
+// `render(pos, begin, end)` renders values [begin, end) from `data[pos]` onwards, setting `offsets[i + 1]`, and
+// may assume room for `max_length` bytes per value. The column goes in rounds of up to `ETS_PARALLEL_TEXT_CHUNKS`
+// chunks: each chunk is rendered at the position it would have if all values before it in the round took
+// `max_length` bytes; then the chunks are moved together and their offsets adjusted. Nothing is allocated.
+//
+// Returns `false`, having done nothing, when the column is better rendered serially: when it is short, when the
+// worst case does not fit in `data` or when `start` is not a multiple of 8 (validity bitmap bytes).
+template <typename F>
+static inline bool ets_parallel_text_column(char *data, size_t capacity, int32_t *offsets, size_t start, size_t count, size_t max_length, unsigned int parallelism, F &&render)
+{
+	using eternal_timestamp::EternalTimestampParallel;
+
+	const size_t grain = ETS_PARALLEL_GRAIN;
+	const size_t n = (count > start ? count - start : 0);
+	if (n <= grain || start % 8 != 0 || max_length == 0 || EternalTimestampParallel::concurrency(parallelism) <= 1)
+		return false;
+	const size_t pos0 = static_cast<size_t>(offsets[start]);
+	if (capacity < pos0 || (capacity - pos0) / max_length < n || n > (static_cast<size_t>(INT32_MAX) - pos0) / max_length)
+		return false;
+
+	// each round starts where the previous one ended, which is never beyond the worst case checked above.
+	size_t shift[ETS_PARALLEL_TEXT_CHUNKS];
+	size_t pos = pos0;
+	for (size_t round = 0; round < n; round += ETS_PARALLEL_TEXT_CHUNKS * grain) {
+		const size_t first = start + round;
+		const size_t m = (n - round > ETS_PARALLEL_TEXT_CHUNKS * grain ? ETS_PARALLEL_TEXT_CHUNKS * grain : n - round);
+		const size_t base = pos;
+
+		// a range handed to the body may span multiple chunks: each of them goes to its own spot.
+		EternalTimestampParallel::parallel_for(m, grain, parallelism, [&](size_t begin, size_t end) {
+			for (size_t b = begin; b < end; b += grain) {
+				const size_t e = (end - b > grain ? b + grain : end);
+				render(base + b * max_length, first + b, first + e);
+			}
+		});
+
+		const size_t chunks = (m - 1) / grain + 1;
+		for (size_t k = 0; k < chunks; k++) {
+			const size_t b = k * grain;
+			const size_t e = (m - b > grain ? b + grain : m);
+			const size_t from = base + b * max_length;
+			const size_t length = static_cast<size_t>(offsets[first + e]) - from;
+			if (from != pos)
+				memmove(data + pos, data + from, length);
+			shift[k] = from - pos;
+			pos += length;
+		}
+
+		EternalTimestampParallel::parallel_for(m, grain, parallelism, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++)
+				offsets[first + i + 1] -= static_cast<int32_t>(shift[i / grain]);
+		});
+	}
+	return true;
+}
+
+#endif // __ETERNAL_TIMESTAMP_INTERNAL_H__
@@ -0,0 +1,392 @@
+
+#include "eternal_timestamp/eternal_timestamp.h"
+
+#include "eternal_timestamp_instrumentation.h"
+#include "eternal_timestamp_internal.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ETS_HAVE_SSE2   1
+#endif
+
+
+using namespace eternal_timestamp;
+
+
+namespace
+{
+	// the parsed ISO 8601 fields in their natural ranges; -1 signals 'not specified'.
+	struct iso_fields
+	{
+		int64_t year;
+		int month;
+		int day;
+		int hour;
+		int minute;
+		int second;
+		unsigned int usec;
+		int fraction_digits;       // 0: no fractional seconds; 1..3: milliseconds only; 4+: microseconds
+		int offset_minutes;
+		bool has_offset;
+	};
+
+	inline bool is_digit(char c)
+	{
+		return static_cast<unsigned char>(c - '0') <= 9;
+	}
+
+	bool parse_digits(const char *&p, const char *end, int n, int &v)
+	{
+		if (end - p < n)
+			return false;
+		int r = 0;
+		for (int i = 0; i < n; i++) {
+			if (!is_digit(p[i]))
+				return false;
+			r = r * 10 + (p[i] - '0');
+		}
+		v = r;
+		p += n;
+		return true;
+	}
+
+	bool is_leap_year(int64_t y)
+	{
+		return y % 4 == 0 && (y % 100 != 0 || y % 400 == 0);
+	}
+
+	bool is_valid_day(int64_t y, int m, int d)
+	{
+		static const unsigned char days[12] = { 31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+		// only Feb 29 needs the (costly: 64-bit divisions) leap year check.
+		return d >= 1 && d <= days[m - 1] && (d != 29 || m != 2 || is_leap_year(y));
+	}
+
+	// [.,]digits: we keep up to microsecond precision and ignore any further digits.
+	bool parse_fraction(const char *&p, const char *end, iso_fields &f)
+	{
+		f.usec = 0;
+		f.fraction_digits = 0;
+		if (p >= end || (*p != '.' && *p != ','))
+			return true;
+		const char *q = p + 1;
+		if (end - q >= 8) {
+			static const unsigned int scale[7] = { 1000000, 100000, 10000, 1000, 100, 10, 1 };
+			const uint64_t w = ets_load_le64(q);
+			const int n = ets_count_digits(w);
+			if (!n)
+				return false;
+			f.fraction_digits = (n < 6 ? n : 6);
+			f.usec = ets_parse_digits(w, f.fraction_digits) * scale[f.fraction_digits];
+			q += n;
+		}
+		else {
+			while (q < end && is_digit(*q) && f.fraction_digits < 6) {
+				f.usec = f.usec * 10 + (*q++ - '0');
+				f.fraction_digits++;
+			}
+			if (!f.fraction_digits)
+				return false;
+			for (int i = f.fraction_digits; i < 6; i++)
+				f.usec *= 10;
+		}
+		while (q < end && is_digit(*q))
+			q++;
+		p = q;
+		return true;
+	}
+
+	// Z | (+|-)hh[[:]mm]
+	bool parse_zone(const char *&p, const char *end, iso_fields &f)
+	{
+		f.offset_minutes = 0;
+		f.has_offset = false;
+		if (p >= end)
+			return true;
+		if (*p == 'Z' || *p == 'z') {
+			f.has_offset = true;
+			p++;
+			return true;
+		}
+		if (*p != '+' && *p != '-')
+			return false;
+		const int sign = (*p == '-' ? -1 : 1);
+		const char *q = p + 1;
+		int hh, mm = 0;
+		if (!parse_digits(q, end, 2, hh) || hh > 23)
+			return false;
+		if (q < end) {
+			if (*q == ':')
+				q++;
+			if (!parse_digits(q, end, 2, mm) || mm > 59)
+				return false;
+		}
+		f.offset_minutes = sign * (hh * 60 + mm);
+		f.has_offset = true;
+		p = q;
+		return true;
+	}
+
+	// what follows the seconds: [fraction][zone]<end>
+	bool parse_tail(const char *p, const char *end, iso_fields &f)
+	{
+		return parse_fraction(p, end, f) && parse_zone(p, end, f) && p == end;
+	}
+
+	// The reference implementation, which accepts all supported notations:
+	//
+	//   date:  YYYY | YYYY-MM | YYYY-MM-DD | YYYYMMDD, where the year may also be written as (+|-)Y{4,12}
+	//   time:  (T|t|' ') followed by hh[:mm[:ss[.f]]] or hh[mm[ss[.f]]]
+	//   zone:  Z | (+|-)hh[[:]mm]
+	bool parse_scalar(const char *p, const char *end, iso_fields &f)
+	{
+		f.month = f.day = f.hour = f.minute = f.second = -1;
+		f.usec = 0;
+		f.fraction_digits = 0;
+		f.offset_minutes = 0;
+		f.has_offset = false;
+		if (p >= end)
+			return false;
+
+		if (*p == '+' || *p == '-') {
+			const bool negative = (*p++ == '-');
+			int64_t y = 0;
+			int n = 0;
+			while (p < end && is_digit(*p) && n < 12) {
+				y = y * 10 + (*p++ - '0');
+				n++;
+			}
+			if (n < 4 || (p < end && is_digit(*p)))
+				return false;
+			f.year = (negative ? -y : y);
+		}
+		else {
+			int y;
+			if (!parse_digits(p, end, 4, y))
+				return false;
+			f.year = y;
+		}
+		if (p == end)
+			return true;
+
+		bool extended = (*p == '-');
+		if (extended) {
+			p++;
+			if (!parse_digits(p, end, 2, f.month))
+				return false;
+			if (p == end)
+				return true;
+			if (*p++ != '-' || !parse_digits(p, end, 2, f.day))
+				return false;
+		}
+		else if (!parse_digits(p, end, 2, f.month) || !parse_digits(p, end, 2, f.day)) {
+			return false;
+		}
+		if (p == end)
+			return true;
+
+		if (*p != 'T' && *p != 't' && *p != ' ')
+			return false;
+		p++;
+		if (!parse_digits(p, end, 2, f.hour))
+			return false;
+		extended = (p < end && *p == ':');
+		if (p < end && (extended || is_digit(*p))) {
+			p += extended;
+			if (!parse_digits(p, end, 2, f.minute))
+				return false;
+			if (p < end && (extended ? *p == ':' : is_digit(*p))) {
+				p += extended;
+				if (!parse_digits(p, end, 2, f.second))
+					return false;
+				return parse_tail(p, end, f);
+			}
+		}
+		return parse_zone(p, end, f) && p == end;
+	}
+
+	// The fast path for the most common layout: YYYY-MM-DD(T|t|' ')hh:mm:ss, followed by optional fractional
+	// seconds and zone. Returns `false` when the input doesn't match this layout.
+	bool parse_fast(const char *p, const char *end, iso_fields &f)
+	{
+		if (end - p < 19)
+			return false;
+		unsigned int year, month, day, hour, minute;
+
+#if ETS_HAVE_SSE2
+		// validate and convert the first 16 characters, 'YYYY-MM-DDThh:mm', in one go:
+		const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+		const __m128i digit_lanes = _mm_setr_epi8(-1, -1, -1, -1, 0, -1, -1, 0, -1, -1, 0, -1, -1, 0, -1, -1);
+		const __m128i separator_lanes = _mm_setr_epi8(0, 0, 0, 0, -1, 0, 0, -1, 0, 0, 0, 0, 0, -1, 0, 0);
+		const __m128i separators = _mm_setr_epi8(0, 0, 0, 0, '-', 0, 0, '-', 0, 0, 0, 0, 0, ':', 0, 0);
+		const __m128i d = _mm_and_si128(_mm_sub_epi8(v, _mm_set1_epi8('0')), digit_lanes);
+		// a digit lane holds 0..9 after subtracting '0': saturating subtraction of 9 leaves zero for those.
+		const __m128i bad = _mm_or_si128(_mm_subs_epu8(d, _mm_set1_epi8(9)), _mm_xor_si128(_mm_and_si128(v, separator_lanes), separators));
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(bad, _mm_setzero_si128())) != 0xFFFF)
+			return false;
+
+		// combine digit pairs as 10 * d[i] + d[i + 1]: at even character positions from `d` itself, at odd
+		// positions from `d` shifted by one character.
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i weights = _mm_setr_epi16(10, 1, 10, 1, 10, 1, 10, 1);
+		const __m128i odd = _mm_srli_si128(d, 1);
+		alignas(16) int32_t even_lo[4], even_hi[4], odd_lo[4], odd_hi[4];
+		_mm_store_si128(reinterpret_cast<__m128i *>(even_lo), _mm_madd_epi16(_mm_unpacklo_epi8(d, zero), weights));       // 0-1, 2-3, 4-5, 6-7
+		_mm_store_si128(reinterpret_cast<__m128i *>(even_hi), _mm_madd_epi16(_mm_unpackhi_epi8(d, zero), weights));       // 8-9, 10-11, 12-13, 14-15
+		_mm_store_si128(reinterpret_cast<__m128i *>(odd_lo), _mm_madd_epi16(_mm_unpacklo_epi8(odd, zero), weights));      // 1-2, 3-4, 5-6, 7-8
+		_mm_store_si128(reinterpret_cast<__m128i *>(odd_hi), _mm_madd_epi16(_mm_unpackhi_epi8(odd, zero), weights));      // 9-10, 11-12, 13-14, 15-
+		year = even_lo[0] * 100 + even_lo[1];
+		month = odd_lo[2];
+		day = even_hi[0];
+		hour = odd_hi[1];
+		minute = even_hi[3];
+#else
+		static constexpr ets_word_pattern date_pattern = ets_make_word_pattern("dddd-dd-");
+		static constexpr ets_word_pattern time_pattern = ets_make_word_pattern("dd*dd:dd");
+		uint64_t w0, w1;
+		if (!ets_match_word(ets_load_le64(p), date_pattern, w0) || !ets_match_word(ets_load_le64(p + 8), time_pattern, w1))
+			return false;
+		year = ets_word_pair(w0, 0) * 100 + ets_word_pair(w0, 2);
+		month = ets_word_pair(w0, 5);
+		day = ets_word_pair(w1, 0);
+		hour = ets_word_pair(w1, 3);
+		minute = ets_word_pair(w1, 6);
+#endif
+
+		if ((p[10] != 'T' && p[10] != 't' && p[10] != ' ') || p[16] != ':' || !is_digit(p[17]) || !is_digit(p[18]))
+			return false;
+		f.year = year;
+		f.month = month;
+		f.day = day;
+		f.hour = hour;
+		f.minute = minute;
+		f.second = (p[17] - '0') * 10 + (p[18] - '0');
+		return parse_tail(p + 19, end, f);
+	}
+
+	bool check_ranges(const iso_fields &f)
+	{
+		if (f.month >= 0 && (f.month < 1 || f.month > 12))
+			return false;
+		if (f.day >= 0 && !is_valid_day(f.year, f.month, f.day))
+			return false;
+		if (f.hour > 23 || f.minute > 59 || f.second > 60)
+			return false;
+		// a zone only makes sense with a time of day.
+		return !f.has_offset || f.hour >= 0;
+	}
+
+	// Encode the fields as a timestamp in layout `L`; returns -1 when the year lies beyond the reach of `L`.
+	template <class L>
+	int encode(uint64_t &dst, iso_fields &f)
+	{
+		typedef typename L::modern M;
+		typedef typename L::prehistoric P;
+
+		// convert to UTC; the unspecified fields remain unspecified.
+		if (f.offset_minutes) {
+			const int64_t minutes = ets_days_from_civil(f.year, f.month, f.day) * 1440 + f.hour * 60 + (f.minute >= 0 ? f.minute : 0) - f.offset_minutes;
+			const int64_t days = (minutes >= 0 ? minutes : minutes - 1439) / 1440;
+			const int64_t rest = minutes - days * 1440;
+			unsigned int m, d;
+			ets_civil_from_days(days, f.year, m, d);
+			f.month = m;
+			f.day = d;
+			f.hour = static_cast<int>(rest / 60);
+			if (f.minute >= 0)
+				f.minute = static_cast<int>(rest % 60);
+		}
+
+		const int64_t y = f.year + L::modern_epoch;
+		const int64_t century = (y >= 0 ? y / 100 : -1);
+		if (century >= 0 && static_cast<uint64_t>(century) <= M::century::max && static_cast<uint64_t>(century) != L::unspecified(M::century::width)) {
+			uint64_t t = M::century::set(0, static_cast<uint64_t>(century));
+			t = M::year::set(t, L::value_offset + static_cast<uint64_t>(y % 100));
+			t = M::month::set(t, f.month >= 0 ? L::value_offset - 1 + f.month : L::unspecified(M::month::width));
+			t = M::day::set(t, f.day >= 0 ? L::value_offset - 1 + f.day : L::unspecified(M::day::width));
+			t = M::hour::set(t, f.hour >= 0 ? L::value_offset + f.hour : L::unspecified(M::hour::width));
+			t = M::minute::set(t, f.minute >= 0 ? L::value_offset + f.minute : L::unspecified(M::minute::width));
+			t = M::seconds::set(t, f.second >= 0 ? L::value_offset + f.second : L::unspecified(M::seconds::width));
+			t = M::milliseconds::set(t, f.fraction_digits ? L::value_offset + f.usec / 1000 : L::unspecified(M::milliseconds::width));
+			t = M::microseconds::set(t, f.fraction_digits > 3 ? L::value_offset + f.usec % 1000 : L::unspecified(M::microseconds::width));
+			dst = t;
+			return 0;
+		}
+		if (century > 0) {
+			// beyond the far end of the modern range.
+			return -1;
+		}
+
+		// deep past: the prehistoric subformat doesn't carry seconds or anything more precise.
+		const uint64_t years = static_cast<uint64_t>(L::prehistoric_epoch - f.year);
+		if (years > P::years::max || years == L::unspecified(P::years::width))
+			return -1;
+		uint64_t t = L::mode_mask;
+		t = P::years::set(t, years);
+		t = P::month::set(t, f.month >= 0 ? L::value_offset - 1 + f.month : L::unspecified(P::month::width));
+		t = P::day::set(t, f.day >= 0 ? L::value_offset - 1 + f.day : L::unspecified(P::day::width));
+		t = P::hour::set(t, f.hour >= 0 ? L::value_offset + f.hour : L::unspecified(P::hour::width));
+		t = P::minute::set(t, f.minute >= 0 ? L::value_offset + f.minute : L::unspecified(P::minute::width));
+		dst = t;
+		return 0;
+	}
+}
+
+
+int EternalTimestamp::cvt_from_iso8601(eternal_timestamp_t &dst, const char *str, size_t length)
+{
+	ETS_STATS_ENTRY(CVT_FROM_ISO8601);
+	iso_fields f;
+	if (!parse_fast(str, str + length, f)) {
+		ETS_STATS_EVENT(ISO8601_SCALAR_FALLBACK);
+		if (!parse_scalar(str, str + length, f))
+			return -1;
+	}
+	if (!check_ranges(f))
+		return -1;
+	const int rv = encode<ets_native_layout>(dst.t, f);
+	ETS_STATS_EVENT_IF(CVT_UNSPECIFIED_FIELDS, rv == 0 && ets_has_unspecified_fields(dst));
+	return rv;
+}
+
+int EternalTimestamp::cvt_from_iso8601_scalar(eternal_timestamp_t &dst, const char *str, size_t length)
+{
+	ETS_STATS_ENTRY(CVT_FROM_ISO8601_SCALAR);
+	iso_fields f;
+	if (!parse_scalar(str, str + length, f) || !check_ranges(f))
+		return -1;
+	const int rv = encode<ets_native_layout>(dst.t, f);
+	ETS_STATS_EVENT_IF(CVT_UNSPECIFIED_FIELDS, rv == 0 && ets_has_unspecified_fields(dst));
+	return rv;
+}
+
+
+template <class L>
+int ets_layout_cvt_from_iso8601(uint64_t &dst, const char *str, size_t length)
+{
+	iso_fields f;
+	if (!parse_fast(str, str + length, f) && !parse_scalar(str, str + length, f))
+		return -1;
+	if (!check_ranges(f))
+		return -1;
+	return encode<L>(dst, f);
+}
+
+template int ets_layout_cvt_from_iso8601<EternalTimestampUnspecifiedFirstLayout>(uint64_t &dst, const char *str, size_t length);
+template int ets_layout_cvt_from_iso8601<EternalTimestampUnspecifiedLastLayout>(uint64_t &dst, const char *str, size_t length);
+template int ets_layout_cvt_from_iso8601<EternalTimestampExtendedLayout>(uint64_t &dst, const char *str, size_t length);
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// C interface
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+extern "C" int ets_cvt_from_iso8601(eternal_timestamp_t *dst, const char *str, size_t length)
+{
+	return EternalTimestamp::cvt_from_iso8601(*dst, str, length);
+}
+
+extern "C" int ets_cvt_from_iso8601_scalar(eternal_timestamp_t *dst, const char *str, size_t length)
+{
+	return EternalTimestamp::cvt_from_iso8601_scalar(*dst, str, length);
+}
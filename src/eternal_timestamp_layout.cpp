@@ -0,0 +1,290 @@
+#include "eternal_timestamp/eternal_timestamp_layout.h"
+
+#include "eternal_timestamp_instrumentation.h"
+#include "eternal_timestamp_internal.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ETS_HAVE_SSE2   1
+#endif
+
+
+using namespace eternal_timestamp;
+
+
+namespace
+{
+	// The 'unspecified' transcoder works on all fields of a subformat at once (SWAR): each value field holds
+	// value + 1 with 'unspecified' at 0, or the value with 'unspecified' at all-ones, so going from the former to
+	// the latter is a decrement modulo the field width and the other way round an increment. The plain fields
+	// (century, prehistoric years) swap 0 and all-ones, and the precision is copied.
+
+	constexpr uint64_t field(unsigned int shift, unsigned int bits)
+	{
+		return (~0ULL >> (64 - bits)) << shift;
+	}
+
+	constexpr uint64_t low(unsigned int shift, unsigned int)
+	{
+		return 1ULL << shift;
+	}
+
+	constexpr uint64_t high(unsigned int shift, unsigned int bits)
+	{
+		return 1ULL << (shift + bits - 1);
+	}
+
+#define ETS_MODERN_VALUE_FIELDS(f) \
+	(f(ETMT_YEAR_SHIFT, ETMT_YEAR_BITS) | f(ETMT_MONTH_SHIFT, ETMT_MONTH_BITS) | f(ETMT_DAY_SHIFT, ETMT_DAY_BITS) \
+	| f(ETMT_HOUR_SHIFT, ETMT_HOUR_BITS) | f(ETMT_MINUTE_SHIFT, ETMT_MINUTE_BITS) | f(ETMT_SECONDS_SHIFT, ETMT_SECONDS_BITS) \
+	| f(ETMT_MILLISECONDS_SHIFT, ETMT_MILLISECONDS_BITS) | f(ETMT_MICROSECONDS_SHIFT, ETMT_MICROSECONDS_BITS))
+#define ETS_PREHISTORIC_VALUE_FIELDS(f) \
+	(f(ETPHT_MONTH_SHIFT, ETPHT_MONTH_BITS) | f(ETPHT_DAY_SHIFT, ETPHT_DAY_BITS) | f(ETPHT_HOUR_SHIFT, ETPHT_HOUR_BITS) \
+	| f(ETPHT_MINUTE_SHIFT, ETPHT_MINUTE_BITS))
+
+	// The masks of a subformat: [0] modern, [1] prehistoric.
+	constexpr uint64_t VALUES[2] = { ETS_MODERN_VALUE_FIELDS(field), ETS_PREHISTORIC_VALUE_FIELDS(field) };
+	constexpr uint64_t LOW[2] = { ETS_MODERN_VALUE_FIELDS(low), ETS_PREHISTORIC_VALUE_FIELDS(low) };
+	constexpr uint64_t HIGH[2] = { ETS_MODERN_VALUE_FIELDS(high), ETS_PREHISTORIC_VALUE_FIELDS(high) };
+	constexpr uint64_t PLAIN[2] = { field(ETMT_CENTURY_SHIFT, ETMT_CENTURY_BITS), field(ETPHT_YEARS_SHIFT, ETPHT_YEARS_BITS) };
+	constexpr uint64_t KEPT[2] = { 0, (1ULL << ETS_MODE_SHIFT) | field(ETPHT_PRECISION_SHIFT, ETPHT_PRECISION_BITS) };
+	constexpr uint64_t SIGN = 1;
+
+#undef ETS_MODERN_VALUE_FIELDS
+#undef ETS_PREHISTORIC_VALUE_FIELDS
+
+	static_assert((VALUES[0] | PLAIN[0] | SIGN | (1ULL << ETS_MODE_SHIFT)) == ~0ULL && (VALUES[1] | PLAIN[1] | KEPT[1] | SIGN) == ~0ULL, "the fields must cover all bits");
+
+	enum direction
+	{
+		KEEP_FIRST,     // same convention: check only
+		KEEP_LAST,
+		TO_LAST,        // 'unspecified' 0 -> all-ones
+		TO_FIRST,       // 'unspecified' all-ones -> 0
+	};
+
+	inline direction direction_of(ets_unspecified_marker_t from, ets_unspecified_marker_t to)
+	{
+		if (from == to)
+			return (to == ETS_UNSPECIFIED_SORTS_LAST ? KEEP_LAST : KEEP_FIRST);
+		return (to == ETS_UNSPECIFIED_SORTS_LAST ? TO_LAST : TO_FIRST);
+	}
+
+	constexpr uint64_t UNKNOWN_FIRST = EternalTimestampUnspecifiedFirstLayout::unknown();
+	constexpr uint64_t UNKNOWN_LAST = EternalTimestampUnspecifiedLastLayout::unknown();
+
+	template <direction Dir>
+	inline bool transcode_value(uint64_t &dst, const uint64_t x)
+	{
+		const unsigned int pre = static_cast<unsigned int>(x >> ETS_MODE_SHIFT) & 1;
+		const uint64_t v = x & VALUES[pre];
+		const uint64_t p = x & PLAIN[pre];
+		uint64_t values = v;
+		uint64_t plain = p;
+		bool ok = !(x & SIGN);
+		if (Dir == TO_LAST) {
+			values = (((v | HIGH[pre]) - LOW[pre]) ^ (~v & HIGH[pre])) & VALUES[pre];
+			plain = (p ? p : PLAIN[pre]);
+			ok = ok && p != PLAIN[pre];
+		} else if (Dir == TO_FIRST) {
+			values = ((v & ~HIGH[pre]) + LOW[pre]) ^ (v & HIGH[pre]);
+			plain = (p != PLAIN[pre] ? p : 0);
+			ok = ok && p != 0;
+		}
+		dst = (ok ? (x & KEPT[pre]) | values | plain : (Dir == TO_LAST || Dir == KEEP_LAST ? UNKNOWN_LAST : UNKNOWN_FIRST));
+		return ok;
+	}
+
+	template <direction Dir>
+	size_t transcode_scalar(uint64_t *dst, uint8_t *validity, const uint64_t *src, size_t begin, size_t end)
+	{
+		size_t failed = 0;
+		for (size_t i = begin; i < end; i++) {
+			const bool ok = transcode_value<Dir>(dst[i], src[i]);
+			failed += !ok;
+			if (validity) {
+				const uint8_t bit = static_cast<uint8_t>(1U << (i % 8));
+				validity[i / 8] = static_cast<uint8_t>(ok ? validity[i / 8] | bit : validity[i / 8] & ~bit);
+			}
+		}
+		return failed;
+	}
+
+#if defined(ETS_HAVE_SSE2)
+
+	inline __m128i set1_64(uint64_t x)
+	{
+		return _mm_set1_epi64x(static_cast<long long>(x));
+	}
+
+	// `a` where `mask` is all-ones, `b` where it's zero.
+	inline __m128i select(__m128i mask, __m128i a, __m128i b)
+	{
+		return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+	}
+
+	// Lanes of 32-bit all-ones/all-zeroes which tell equality, widened to the 64-bit lanes.
+	inline __m128i all_of_epi64(__m128i eq32)
+	{
+		return _mm_and_si128(eq32, _mm_shuffle_epi32(eq32, _MM_SHUFFLE(2, 3, 0, 1)));
+	}
+
+	// `transcode_value()` for 2 timestamps; the masks are picked per lane by the mode bit.
+	template <direction Dir>
+	inline __m128i transcode_x2(const __m128i x, unsigned int &valid)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i pre = _mm_sub_epi64(zero, _mm_and_si128(_mm_srli_epi64(x, ETS_MODE_SHIFT), set1_64(1)));
+		const __m128i values_mask = select(pre, set1_64(VALUES[1]), set1_64(VALUES[0]));
+		const __m128i plain_mask = select(pre, set1_64(PLAIN[1]), set1_64(PLAIN[0]));
+		const __m128i v = _mm_and_si128(x, values_mask);
+		const __m128i p = _mm_and_si128(x, plain_mask);
+		__m128i values = v;
+		__m128i plain = p;
+		__m128i bad = _mm_sub_epi64(zero, _mm_and_si128(x, set1_64(SIGN)));
+		if (Dir == TO_LAST || Dir == TO_FIRST) {
+			const __m128i high = select(pre, set1_64(HIGH[1]), set1_64(HIGH[0]));
+			const __m128i low = select(pre, set1_64(LOW[1]), set1_64(LOW[0]));
+			if (Dir == TO_LAST) {
+				const __m128i unspecified = all_of_epi64(_mm_cmpeq_epi32(p, zero));
+				values = _mm_and_si128(_mm_xor_si128(_mm_sub_epi64(_mm_or_si128(v, high), low), _mm_andnot_si128(v, high)), values_mask);
+				plain = _mm_or_si128(p, _mm_and_si128(unspecified, plain_mask));
+				bad = _mm_or_si128(bad, all_of_epi64(_mm_cmpeq_epi32(p, plain_mask)));
+			} else {
+				const __m128i unspecified = all_of_epi64(_mm_cmpeq_epi32(p, plain_mask));
+				values = _mm_xor_si128(_mm_add_epi64(_mm_andnot_si128(high, v), low), _mm_and_si128(v, high));
+				plain = _mm_andnot_si128(unspecified, p);
+				bad = _mm_or_si128(bad, all_of_epi64(_mm_cmpeq_epi32(p, zero)));
+			}
+		}
+		const __m128i kept = _mm_and_si128(x, select(pre, set1_64(KEPT[1]), set1_64(KEPT[0])));
+		valid = ~static_cast<unsigned int>(_mm_movemask_pd(_mm_castsi128_pd(bad))) & 3;
+		return select(bad, set1_64(Dir == TO_LAST || Dir == KEEP_LAST ? UNKNOWN_LAST : UNKNOWN_FIRST), _mm_or_si128(_mm_or_si128(kept, values), plain));
+	}
+
+	// 8 values per round, so each round fills one validity byte. Every pair is loaded before it is stored, which
+	// makes in-place fine.
+	template <direction Dir>
+	size_t transcode_sse2(uint64_t *dst, uint8_t *validity, const uint64_t *src, size_t begin, size_t end)
+	{
+		size_t failed = 0;
+		size_t i = begin;
+		for (; i + 8 <= end; i += 8) {
+			unsigned int valid = 0;
+			for (unsigned int j = 0; j < 8; j += 2) {
+				unsigned int v;
+				const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i + j));
+				_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i + j), transcode_x2<Dir>(x, v));
+				valid |= v << j;
+			}
+			failed += 8 - ets_layout_popcount(valid);
+			if (validity)
+				validity[i / 8] = static_cast<uint8_t>(valid);
+		}
+		return failed + transcode_scalar<Dir>(dst, validity, src, i, end);
+	}
+
+#endif // ETS_HAVE_SSE2
+
+	template <direction Dir>
+	size_t transcode_kernel(uint64_t *dst, uint8_t *validity, const uint64_t *src, size_t count, unsigned int parallelism)
+	{
+		// the chunks start at multiples of the grain, hence at whole validity bytes
+		return ets_parallel_sum(count, parallelism, [=](size_t begin, size_t end) {
+#if defined(ETS_HAVE_SSE2)
+			return transcode_sse2<Dir>(dst, validity, src, begin, end);
+#else
+			return transcode_scalar<Dir>(dst, validity, src, begin, end);
+#endif
+		});
+	}
+}
+
+
+int EternalTimestampMarkerTranscoder::transcode(uint64_t &dst, const uint64_t t, ets_unspecified_marker_t from, ets_unspecified_marker_t to)
+{
+	bool ok;
+	switch (direction_of(from, to)) {
+	case TO_LAST:
+		ok = transcode_value<TO_LAST>(dst, t);
+		break;
+	case TO_FIRST:
+		ok = transcode_value<TO_FIRST>(dst, t);
+		break;
+	case KEEP_LAST:
+		ok = transcode_value<KEEP_LAST>(dst, t);
+		break;
+	default:
+		ok = transcode_value<KEEP_FIRST>(dst, t);
+		break;
+	}
+	return ok ? 0 : -1;
+}
+
+size_t EternalTimestampMarkerTranscoder::transcode_batch(uint64_t *dst, uint8_t *validity, const uint64_t *src, size_t count, ets_unspecified_marker_t from, ets_unspecified_marker_t to, unsigned int parallelism)
+{
+	ETS_STATS_ENTRY(LAYOUT_TRANSCODE_MARKERS);
+	switch (direction_of(from, to)) {
+	case TO_LAST:
+		return transcode_kernel<TO_LAST>(dst, validity, src, count, parallelism);
+	case TO_FIRST:
+		return transcode_kernel<TO_FIRST>(dst, validity, src, count, parallelism);
+	case KEEP_LAST:
+		return transcode_kernel<KEEP_LAST>(dst, validity, src, count, parallelism);
+	default:
+		return transcode_kernel<KEEP_FIRST>(dst, validity, src, count, parallelism);
+	}
+}
+
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// C interface
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+extern "C" int ets_layout_cvt_to_extended(uint64_t *dst, const eternal_timestamp_t t)
+{
+	return EternalTimestampExtendedLayout::cvt_from_native(*dst, t);
+}
+
+extern "C" int ets_layout_cvt_from_extended(eternal_timestamp_t *dst, const uint64_t t)
+{
+	return EternalTimestampExtendedLayout::cvt_to_native(*dst, t);
+}
+
+extern "C" int64_t ets_layout_extended_sort_key(const uint64_t t)
+{
+	return EternalTimestampExtendedLayout::calc_sort_key(t);
+}
+
+extern "C" size_t ets_layout_cvt_to_extended_batch(uint64_t *dst, uint8_t *validity, const eternal_timestamp_t *src, size_t count)
+{
+	ETS_STATS_ENTRY(LAYOUT_CVT_TO_EXTENDED);
+	return EternalTimestampExtendedLayout::cvt_from_native_batch(dst, validity, src, count);
+}
+
+extern "C" size_t ets_layout_cvt_from_extended_batch(eternal_timestamp_t *dst, uint8_t *validity, const uint64_t *src, size_t count)
+{
+	ETS_STATS_ENTRY(LAYOUT_CVT_FROM_EXTENDED);
+	return EternalTimestampExtendedLayout::cvt_to_native_batch(dst, validity, src, count);
+}
+
+extern "C" size_t ets_layout_extended_cvt_from_unix_usecs(uint64_t *dst, uint8_t *validity, const int64_t *src, size_t count)
+{
+	return EternalTimestampLayoutBatch<EternalTimestampExtendedLayout>::cvt_from_unix_usecs(dst, validity, src, count);
+}
+
+extern "C" size_t ets_layout_extended_cvt_to_unix_usecs(int64_t *dst, uint8_t *validity, const uint64_t *src, size_t count)
+{
+	return EternalTimestampLayoutBatch<EternalTimestampExtendedLayout>::cvt_to_unix_usecs(dst, validity, src, count);
+}
+
+extern "C" int ets_layout_transcode_markers(uint64_t *dst, const uint64_t t, ets_unspecified_marker_t from, ets_unspecified_marker_t to)
+{
+	return EternalTimestampMarkerTranscoder::transcode(*dst, t, from, to);
+}
+
+extern "C" size_t ets_layout_transcode_markers_batch(uint64_t *dst, uint8_t *validity, const uint64_t *src, size_t count, ets_unspecified_marker_t from, ets_unspecified_marker_t to)
+{
+	return EternalTimestampMarkerTranscoder::transcode_batch(dst, validity, src, count, from, to);
+}
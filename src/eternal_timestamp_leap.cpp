@@ -0,0 +1,477 @@
+
+#include "eternal_timestamp/eternal_timestamp_leap.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <atomic>
+#include <mutex>
+
+#include "eternal_timestamp_instrumentation.h"
+#include "eternal_timestamp_internal.h"
+
+
+using namespace eternal_timestamp;
+
+
+namespace
+{
+	constexpr int64_t SECONDS_PER_DAY = 86400;
+
+	// seconds between the NTP epoch (1900/jan/01) and the POSIX epoch (1970/jan/01)
+	constexpr int64_t NTP_TO_UNIX_SECONDS = 2208988800LL;
+
+	// IERS Bulletin C; the NTP `leap-seconds.list` edition of that expires 2026/jun/28.
+	const ets_leap_second_t builtin_entries[] = {
+		{ 63072000, 10 },      // 1972/jan/01
+		{ 78796800, 11 },      // 1972/jul/01
+		{ 94694400, 12 },      // 1973/jan/01
+		{ 126230400, 13 },     // 1974/jan/01
+		{ 157766400, 14 },     // 1975/jan/01
+		{ 189302400, 15 },     // 1976/jan/01
+		{ 220924800, 16 },     // 1977/jan/01
+		{ 252460800, 17 },     // 1978/jan/01
+		{ 283996800, 18 },     // 1979/jan/01
+		{ 315532800, 19 },     // 1980/jan/01
+		{ 362793600, 20 },     // 1981/jul/01
+		{ 394329600, 21 },     // 1982/jul/01
+		{ 425865600, 22 },     // 1983/jul/01
+		{ 489024000, 23 },     // 1985/jul/01
+		{ 567993600, 24 },     // 1988/jan/01
+		{ 631152000, 25 },     // 1990/jan/01
+		{ 662688000, 26 },     // 1991/jan/01
+		{ 709948800, 27 },     // 1992/jul/01
+		{ 741484800, 28 },     // 1993/jul/01
+		{ 773020800, 29 },     // 1994/jul/01
+		{ 820454400, 30 },     // 1996/jan/01
+		{ 867715200, 31 },     // 1997/jul/01
+		{ 915148800, 32 },     // 1999/jan/01
+		{ 1136073600, 33 },    // 2006/jan/01
+		{ 1230768000, 34 },    // 2009/jan/01
+		{ 1341100800, 35 },    // 2012/jul/01
+		{ 1435708800, 36 },    // 2015/jul/01
+		{ 1483228800, 37 },    // 2017/jan/01
+	};
+	constexpr int64_t builtin_expiry = 3991593600LL - NTP_TO_UNIX_SECONDS;
+
+	// A compiled table: `offsets[i]` is TAI - UTC from `utc_starts[i]` onwards, which is `tai_starts[i]` in TAI.
+	struct leap_table
+	{
+		const leap_table *next;    // the `all_tables` chain
+		uint32_t count;
+		int64_t expires;
+		const int64_t *utc_starts;
+		const int64_t *tai_starts;
+		const int32_t *offsets;
+	};
+
+	const leap_table *make_table(const ets_leap_second_t *entries, size_t count, int64_t expires, int &error)
+	{
+		error = EINVAL;
+		if (!entries || count == 0 || count > 10000)
+			return nullptr;
+		for (size_t i = 1; i < count; i++) {
+			const int32_t step = entries[i].tai_minus_utc - entries[i - 1].tai_minus_utc;
+			if (entries[i].utc_seconds <= entries[i - 1].utc_seconds || (step != 1 && step != -1))
+				return nullptr;
+		}
+
+		error = ENOMEM;
+		leap_table *table = static_cast<leap_table *>(malloc(sizeof(leap_table) + count * (2 * sizeof(int64_t) + sizeof(int32_t))));
+		if (!table)
+			return nullptr;
+		int64_t *utc_starts = reinterpret_cast<int64_t *>(table + 1);
+		int64_t *tai_starts = utc_starts + count;
+		int32_t *offsets = reinterpret_cast<int32_t *>(tai_starts + count);
+		for (size_t i = 0; i < count; i++) {
+			utc_starts[i] = entries[i].utc_seconds;
+			tai_starts[i] = entries[i].utc_seconds + entries[i].tai_minus_utc;
+			offsets[i] = entries[i].tai_minus_utc;
+		}
+		table->next = nullptr;
+		table->count = static_cast<uint32_t>(count);
+		table->expires = expires;
+		table->utc_starts = utc_starts;
+		table->tai_starts = tai_starts;
+		table->offsets = offsets;
+		error = 0;
+		return table;
+	}
+
+	// NULL: the builtin table is current.
+	//
+	// Replaced tables are never freed as concurrent conversions may still be using them; they're a few hundred
+	// bytes and replaced rarely, if ever. They are kept in the `all_tables` chain.
+	std::atomic<const leap_table *> current_table{ nullptr };
+	std::mutex all_tables_lock;
+	const leap_table *all_tables = nullptr;
+
+	const leap_table *get_table()
+	{
+		const leap_table *table = current_table.load(std::memory_order_acquire);
+		if (table)
+			return table;
+		static const leap_table *builtin = [] {
+			int error;
+			return make_table(builtin_entries, sizeof(builtin_entries) / sizeof(builtin_entries[0]), builtin_expiry, error);
+		}();
+		return builtin;
+	}
+
+	// The index of the last element <= `v` in the ascending array, -1 when there is none.
+	inline int64_t last_at_or_before(const int64_t *a, uint32_t count, int64_t v)
+	{
+		uint32_t lo = 0, n = count;
+		while (n > 0) {
+			const uint32_t half = n / 2;
+			if (a[lo + half] <= v) {
+				lo += half + 1;
+				n -= half + 1;
+			}
+			else {
+				n = half;
+			}
+		}
+		return static_cast<int64_t>(lo) - 1;
+	}
+
+	// The interval [lo, hi) of input seconds for which the last lookup's offset holds.
+	struct offset_cache
+	{
+		int64_t lo = 1;
+		int64_t hi = 0;
+		int32_t offset = 0;
+
+		bool hit(int64_t s) const
+		{
+			return s >= lo && s < hi;
+		}
+	};
+
+	// TAI for UTC `utc`; `leap` when the UTC reading is :60, in which case `utc` is the :59 reading.
+	// Return `false` when there is no such leap second.
+	bool utc_to_tai(const leap_table *table, int64_t utc, bool leap, int64_t &tai, offset_cache &cache)
+	{
+		if (!leap && cache.hit(utc)) {
+			tai = utc + cache.offset;
+			return true;
+		}
+		const int64_t k = last_at_or_before(table->utc_starts, table->count, utc);
+		const int32_t offset = table->offsets[k < 0 ? 0 : k];
+		const bool has_next = (k + 1 < table->count);
+		if (leap) {
+			// the next entry must start right after this second and add one
+			if (!has_next || table->utc_starts[k + 1] != utc + 1 || table->offsets[k + 1] != offset + 1)
+				return false;
+			tai = utc + offset + 1;
+			return true;
+		}
+		cache.lo = (k < 0 ? INT64_MIN : table->utc_starts[k]);
+		cache.hi = (has_next ? table->utc_starts[k + 1] : INT64_MAX);
+		cache.offset = offset;
+		tai = utc + offset;
+		return true;
+	}
+
+	// The reverse; produces the :59 reading and sets `leap` for the inserted leap seconds.
+	void tai_to_utc(const leap_table *table, int64_t tai, int64_t &utc, bool &leap, offset_cache &cache)
+	{
+		leap = false;
+		if (cache.hit(tai)) {
+			utc = tai - cache.offset;
+			return;
+		}
+		const int64_t k = last_at_or_before(table->tai_starts, table->count, tai);
+		const int32_t offset = table->offsets[k < 0 ? 0 : k];
+		utc = tai - offset;
+		cache.lo = (k < 0 ? INT64_MIN : table->tai_starts[k]);
+		cache.hi = INT64_MAX;
+		cache.offset = offset;
+		if (k + 1 < table->count) {
+			cache.hi = table->tai_starts[k + 1];
+			// the TAI second before an inserted leap second takes effect *is* the leap second
+			if (table->offsets[k + 1] == offset + 1) {
+				cache.hi--;
+				if (tai == cache.hi) {
+					utc--;
+					leap = true;
+				}
+			}
+		}
+	}
+
+	// The timestamp's reading as seconds since 1970/jan/01; `leap` when the seconds field reads 60, in which case
+	// the :59 reading is produced. With `complete`, all fields down to the seconds must be specified, otherwise
+	// unspecified time-of-day fields are taken as zero. Fields out of their range, e.g. feb/30, fail.
+	bool decode(const eternal_timestamp_t t, bool complete, int64_t &dst, bool &leap)
+	{
+		if (!ets_has_complete_modern_date(t))
+			return false;
+		const bool has_hour = ets_modern_hour(t) != get_Invalid(ETMT_FIELDSIZE_HOUR);
+		const bool has_minute = ets_modern_minute(t) != get_Invalid(ETMT_FIELDSIZE_MINUTE);
+		const bool has_seconds = ets_modern_seconds(t) != get_Invalid(ETMT_FIELDSIZE_SECONDS);
+		if (complete && !(has_hour && has_minute && has_seconds))
+			return false;
+		const unsigned int hh = (has_hour ? static_cast<unsigned int>(ets_modern_hour(t)) - FIELD_VAL_OFFSET : 0);
+		const unsigned int mm = (has_minute ? static_cast<unsigned int>(ets_modern_minute(t)) - FIELD_VAL_OFFSET : 0);
+		unsigned int ss = (has_seconds ? static_cast<unsigned int>(ets_modern_seconds(t)) - FIELD_VAL_OFFSET : 0);
+		if (hh > 23 || mm > 59 || ss > 60)
+			return false;
+		leap = (ss == 60);
+		if (leap)
+			ss = 59;
+
+		const int64_t y = static_cast<int64_t>(ets_modern_century(t)) * 100 + (static_cast<int64_t>(ets_modern_year(t)) - FIELD_VAL_OFFSET) - MODERN_EPOCH;
+		const unsigned int m = static_cast<unsigned int>(ets_modern_month(t)) + 1 - FIELD_VAL_OFFSET;
+		const unsigned int d = static_cast<unsigned int>(ets_modern_day(t)) + 1 - FIELD_VAL_OFFSET;
+		if (ets_modern_year(t) - FIELD_VAL_OFFSET > 99 || m < 1 || m > 12 || d < 1 || d > ets_month_length(y, m))
+			return false;
+		dst = ets_days_from_civil(y, m, d) * SECONDS_PER_DAY + (hh * 60 + mm) * 60 + ss;
+		return true;
+	}
+
+	// Set the date and time fields down to the seconds; the sub-second fields are left as is.
+	bool encode(eternal_timestamp_t &t, int64_t seconds, bool leap)
+	{
+		const int64_t days = (seconds >= 0 ? seconds : seconds - (SECONDS_PER_DAY - 1)) / SECONDS_PER_DAY;
+		const int64_t rest = seconds - days * SECONDS_PER_DAY;
+		int64_t y;
+		unsigned int m, d;
+		ets_civil_from_days(days, y, m, d);
+		const int64_t century = (y + MODERN_EPOCH) / 100;
+		if (y + MODERN_EPOCH < 0 || century > get_MaxInvalid(ETMT_FIELDSIZE_CENTURY) || century == get_Invalid(ETMT_FIELDSIZE_CENTURY))
+			return false;
+
+		t = ets_modern_set_century(t, static_cast<uint64_t>(century));
+		t = ets_modern_set_year(t, FIELD_VAL_OFFSET + static_cast<uint64_t>((y + MODERN_EPOCH) % 100));
+		t = ets_modern_set_month(t, FIELD_VAL_OFFSET - 1 + m);
+		t = ets_modern_set_day(t, FIELD_VAL_OFFSET - 1 + d);
+		t = ets_modern_set_hour(t, FIELD_VAL_OFFSET + static_cast<uint64_t>(rest / 3600));
+		t = ets_modern_set_minute(t, FIELD_VAL_OFFSET + static_cast<uint64_t>(rest / 60 % 60));
+		t = ets_modern_set_seconds(t, FIELD_VAL_OFFSET + static_cast<uint64_t>(leap ? 60 : rest % 60));
+		return true;
+	}
+
+	inline void set_validity(uint8_t *validity, size_t i, bool valid)
+	{
+		if (!validity)
+			return;
+		const uint8_t bit = static_cast<uint8_t>(1u << (i % 8));
+		if (valid)
+			validity[i / 8] |= bit;
+		else
+			validity[i / 8] &= static_cast<uint8_t>(~bit);
+	}
+}
+
+
+int EternalTimestampLeapSeconds::set_table(const ets_leap_second_t *entries, size_t count, int64_t expires)
+{
+	ETS_STATS_ENTRY(LEAP_SET_TABLE);
+	int error;
+	const leap_table *table = make_table(entries, count, expires, error);
+	if (!table)
+		return error;
+	{
+		std::lock_guard<std::mutex> guard(all_tables_lock);
+		const_cast<leap_table *>(table)->next = all_tables;
+		all_tables = table;
+	}
+	current_table.store(table, std::memory_order_release);
+	return 0;
+}
+
+int EternalTimestampLeapSeconds::load_table(const char *path)
+{
+	ETS_STATS_ENTRY(LEAP_LOAD_TABLE);
+	char buf[1024];
+	if (!path) {
+		const char *dir = getenv("TZDIR");
+		if (!dir || !*dir)
+			dir = "/usr/share/zoneinfo";
+		if (snprintf(buf, sizeof(buf), "%s/leap-seconds.list", dir) >= static_cast<int>(sizeof(buf)))
+			return EINVAL;
+		path = buf;
+	}
+	FILE *f = fopen(path, "r");
+	if (!f)
+		return (errno ? errno : ENOENT);
+
+	// "<NTP seconds> <TAI - UTC> [# comment]" lines; the "#@ <NTP seconds>" line holds the expiry date.
+	ets_leap_second_t entries[512];
+	size_t count = 0;
+	int64_t expires = 0;
+	bool ok = true;
+	char line[256];
+	while (ok && fgets(line, sizeof(line), f)) {
+		char *p = line;
+		if (p[0] == '#') {
+			if (p[1] == '@')
+				expires = strtoll(p + 2, nullptr, 10) - NTP_TO_UNIX_SECONDS;
+			continue;
+		}
+		while (*p == ' ' || *p == '\t')
+			p++;
+		if (*p == '\n' || *p == '\r' || *p == 0)
+			continue;
+		char *end;
+		const long long ntp = strtoll(p, &end, 10);
+		const long offset = (end != p ? strtol(end, &p, 10) : 0);
+		if (end == p || ntp <= 0 || offset < 0 || offset > 1000 || count == sizeof(entries) / sizeof(entries[0])) {
+			ok = false;
+			break;
+		}
+		entries[count].utc_seconds = ntp - NTP_TO_UNIX_SECONDS;
+		entries[count].tai_minus_utc = static_cast<int32_t>(offset);
+		count++;
+	}
+	fclose(f);
+	if (!ok)
+		return EINVAL;
+	return set_table(entries, count, expires);
+}
+
+void EternalTimestampLeapSeconds::reset_table()
+{
+	current_table.store(nullptr, std::memory_order_release);
+}
+
+int64_t EternalTimestampLeapSeconds::table_expiry()
+{
+	const leap_table *table = get_table();
+	return (table ? table->expires : 0);
+}
+
+int32_t EternalTimestampLeapSeconds::tai_minus_utc(int64_t utc_seconds)
+{
+	ETS_STATS_ENTRY(LEAP_TAI_MINUS_UTC);
+	const leap_table *table = get_table();
+	if (!table)
+		return builtin_entries[0].tai_minus_utc;
+	const int64_t k = last_at_or_before(table->utc_starts, table->count, utc_seconds);
+	return table->offsets[k < 0 ? 0 : k];
+}
+
+size_t EternalTimestampLeapSeconds::cvt_time_scale(eternal_timestamp_t *dst, uint8_t *validity, const eternal_timestamp_t *src, size_t count, ets_time_scale from, ets_time_scale to, unsigned int parallelism)
+{
+	ETS_STATS_ENTRY(LEAP_CVT_TIME_SCALE);
+	const leap_table *table = get_table();
+	return ets_parallel_sum(count, parallelism, [=](size_t begin, size_t end) {
+		offset_cache from_cache, to_cache;
+		size_t failures = 0;
+		for (size_t i = begin; i < end; i++) {
+			eternal_timestamp_t t = src[i];
+			int64_t seconds;
+			bool leap;
+			bool ok = table && decode(t, true, seconds, leap);
+			if (ok) {
+				// everything goes through TAI
+				int64_t tai = seconds;
+				switch (from) {
+				case ETS_SCALE_UTC:
+					ok = utc_to_tai(table, seconds, leap, tai, from_cache);
+					break;
+
+				case ETS_SCALE_GPS:
+					tai += ETS_TAI_MINUS_GPS;
+					// fall through
+				default:
+					// there are no leap seconds in TAI or GPS time
+					ok = !leap;
+					break;
+				}
+
+				leap = false;
+				if (to == ETS_SCALE_UTC)
+					tai_to_utc(table, tai, seconds, leap, to_cache);
+				else if (to == ETS_SCALE_GPS)
+					seconds = tai - ETS_TAI_MINUS_GPS;
+				else
+					seconds = tai;
+				ok = ok && encode(t, seconds, leap);
+			}
+			if (!ok) {
+				t = src[i];
+				failures++;
+			}
+			dst[i] = t;
+			set_validity(validity, i, ok);
+		}
+		return failures;
+	});
+}
+
+size_t EternalTimestampLeapSeconds::calc_delta_usecs(int64_t *dst, uint8_t *validity, const eternal_timestamp_t *from, const eternal_timestamp_t *to, size_t count, unsigned int parallelism)
+{
+	ETS_STATS_ENTRY(LEAP_CALC_DELTA_USECS);
+	const leap_table *table = get_table();
+	auto tai_usecs = [table](const eternal_timestamp_t t, offset_cache &cache, int64_t &usecs) {
+		int64_t seconds, tai;
+		bool leap;
+		if (!decode(t, false, seconds, leap) || !utc_to_tai(table, seconds, leap, tai, cache))
+			return false;
+		const uint64_t ms_code = ets_modern_milliseconds(t);
+		const uint64_t us_code = ets_modern_microseconds(t);
+		const int64_t ms = (ms_code == get_Invalid(ETMT_FIELDSIZE_MILLISECONDS) ? 0 : static_cast<int64_t>(ms_code) - FIELD_VAL_OFFSET);
+		const int64_t us = (us_code == get_Invalid(ETMT_FIELDSIZE_MICROSECONDS) ? 0 : static_cast<int64_t>(us_code) - FIELD_VAL_OFFSET);
+		if (ms > 999 || us > 999)
+			return false;
+		usecs = tai * USECS_PER_SECOND + ms * 1000 + us;
+		return true;
+	};
+
+	return ets_parallel_sum(count, parallelism, [=](size_t begin, size_t end) {
+		offset_cache from_cache, to_cache;
+		size_t failures = 0;
+		for (size_t i = begin; i < end; i++) {
+			int64_t a, b;
+			const bool ok = table && tai_usecs(from[i], from_cache, a) && tai_usecs(to[i], to_cache, b);
+			dst[i] = (ok ? b - a : 0);
+			failures += !ok;
+			set_validity(validity, i, ok);
+		}
+		return failures;
+	});
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// C interface
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+extern "C" int ets_leap_set_table(const ets_leap_second_t *entries, size_t count, int64_t expires)
+{
+	return EternalTimestampLeapSeconds::set_table(entries, count, expires);
+}
+
+extern "C" int ets_leap_load_table(const char *path)
+{
+	return EternalTimestampLeapSeconds::load_table(path);
+}
+
+extern "C" void ets_leap_reset_table(void)
+{
+	EternalTimestampLeapSeconds::reset_table();
+}
+
+extern "C" int64_t ets_leap_table_expiry(void)
+{
+	return EternalTimestampLeapSeconds::table_expiry();
+}
+
+extern "C" int32_t ets_leap_tai_minus_utc(int64_t utc_seconds)
+{
+	return EternalTimestampLeapSeconds::tai_minus_utc(utc_seconds);
+}
+
+extern "C" size_t ets_leap_cvt_time_scale(eternal_timestamp_t *dst, uint8_t *validity, const eternal_timestamp_t *src, size_t count, enum ets_time_scale from, enum ets_time_scale to)
+{
+	return EternalTimestampLeapSeconds::cvt_time_scale(dst, validity, src, count, from, to);
+}
+
+extern "C" size_t ets_leap_calc_delta_usecs(int64_t *dst, uint8_t *validity, const eternal_timestamp_t *from, const eternal_timestamp_t *to, size_t count)
+{
+	return EternalTimestampLeapSeconds::calc_delta_usecs(dst, validity, from, to, count);
+}
@@ -0,0 +1,436 @@
+
+#include "eternal_timestamp/eternal_timestamp_logscan.h"
+
+#include <ctime>
+
+#include "eternal_timestamp_instrumentation.h"
+#include "eternal_timestamp_internal.h"
+
+
+using namespace eternal_timestamp;
+
+
+namespace
+{
+	// the parsed fields of a log timestamp, in their natural ranges.
+	struct log_time
+	{
+		int year;
+		unsigned int month;
+		unsigned int day;
+		unsigned int hour;
+		unsigned int minute;
+		unsigned int second;
+		unsigned int usec;
+		int fraction_digits;       // 0: no fractional seconds; 1..3: milliseconds only; 4+: microseconds
+		int offset_minutes;        // UTC offset, when known
+	};
+
+	// Each parser checks the line length up front, after which its fixed-position 8-byte word loads stay within the line.
+	constexpr ets_word_pattern rfc3339_date = ets_make_word_pattern("dddd-dd-");
+	constexpr ets_word_pattern nginx_date = ets_make_word_pattern("dddd/dd/");
+	constexpr ets_word_pattern day_time = ets_make_word_pattern("dd*dd:dd");
+	constexpr ets_word_pattern hms = ets_make_word_pattern("dd:dd:dd");
+	constexpr ets_word_pattern clf_day = ets_make_word_pattern("dd/***/d");
+	constexpr ets_word_pattern clf_year_hour = ets_make_word_pattern("dddd:dd:");
+	constexpr ets_word_pattern clf_minute_second = ets_make_word_pattern("dd:dd **");
+
+	inline bool is_digit(char c)
+	{
+		return static_cast<unsigned char>(c - '0') <= 9;
+	}
+
+	// Jan..Dec (case insensitive) --> 1..12; 0 when not a month name.
+	unsigned int parse_month_name(const char *p)
+	{
+		const uint32_t key = (static_cast<uint32_t>(static_cast<unsigned char>(p[0]) | 0x20) << 16)
+			| (static_cast<uint32_t>(static_cast<unsigned char>(p[1]) | 0x20) << 8)
+			| static_cast<uint32_t>(static_cast<unsigned char>(p[2]) | 0x20);
+		switch (key) {
+		case 0x6a616e: return 1;     // jan
+		case 0x666562: return 2;     // feb
+		case 0x6d6172: return 3;     // mar
+		case 0x617072: return 4;     // apr
+		case 0x6d6179: return 5;     // may
+		case 0x6a756e: return 6;     // jun
+		case 0x6a756c: return 7;     // jul
+		case 0x617567: return 8;     // aug
+		case 0x736570: return 9;     // sep
+		case 0x6f6374: return 10;    // oct
+		case 0x6e6f76: return 11;    // nov
+		case 0x646563: return 12;    // dec
+		default: return 0;
+		}
+	}
+
+	// [.,]digits --> microseconds; digits beyond the sixth are ignored.
+	const char *parse_fraction(const char *p, const char *end, log_time &lt)
+	{
+		lt.usec = 0;
+		lt.fraction_digits = 0;
+		if (p >= end || (*p != '.' && *p != ','))
+			return p;
+		const char *q = p + 1;
+		if (end - q >= 8) {
+			static const unsigned int scale[7] = { 1000000, 100000, 10000, 1000, 100, 10, 1 };
+			const uint64_t w = ets_load_le64(q);
+			const int n = ets_count_digits(w);
+			if (!n)
+				return p;
+			lt.fraction_digits = (n < 6 ? n : 6);
+			lt.usec = ets_parse_digits(w, lt.fraction_digits) * scale[lt.fraction_digits];
+			q += n;
+			while (q < end && is_digit(*q))
+				q++;
+			return q;
+		}
+		while (q < end && is_digit(*q)) {
+			if (lt.fraction_digits < 6) {
+				lt.usec = lt.usec * 10 + (*q - '0');
+				lt.fraction_digits++;
+			}
+			q++;
+		}
+		if (!lt.fraction_digits)
+			return p;
+		for (int i = lt.fraction_digits; i < 6; i++)
+			lt.usec *= 10;
+		return q;
+	}
+
+	// Z | (+|-)hh[:]mm
+	const char *parse_offset(const char *p, const char *end, log_time &lt)
+	{
+		if (p < end && (*p == 'Z' || *p == 'z')) {
+			lt.offset_minutes = 0;
+			return p + 1;
+		}
+		if (end - p >= 5 && (*p == '+' || *p == '-') && is_digit(p[1]) && is_digit(p[2])) {
+			const char *q = p + 3;
+			if (*q == ':')
+				q++;
+			if (end - q >= 2 && is_digit(q[0]) && is_digit(q[1])) {
+				const int minutes = ((p[1] - '0') * 10 + (p[2] - '0')) * 60 + (q[0] - '0') * 10 + (q[1] - '0');
+				lt.offset_minutes = (*p == '-' ? -minutes : minutes);
+				return q + 2;
+			}
+		}
+		return p;
+	}
+
+	bool is_leap_year(int64_t y)
+	{
+		return y % 4 == 0 && (y % 100 != 0 || y % 400 == 0);
+	}
+
+	// RFC 3164 lines carry no year: they are checked with year 0, a leap year, until `assign_syslog_year()` supplies it.
+	bool valid_ranges(const log_time &lt)
+	{
+		static const unsigned char days[12] = { 31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+		if (lt.month - 1 >= 12 || lt.day - 1 >= days[lt.month - 1] || lt.hour >= 24 || lt.minute >= 60 || lt.second > 60)
+			return false;
+		// only Feb 29 needs the leap year check.
+		return lt.day != 29 || lt.month != 2 || is_leap_year(lt.year);
+	}
+
+	// YYYY-MM-DD(T| )hh:mm:ss  or  YYYY/MM/DD hh:mm:ss: two 8-byte words cover all but the seconds.
+	bool parse_ymd_hms(const char *p, const ets_word_pattern &date, log_time &lt)
+	{
+		uint64_t w0, w1;
+		if (!ets_match_word(ets_load_le64(p), date, w0) || !ets_match_word(ets_load_le64(p + 8), day_time, w1))
+			return false;
+		if (p[16] != ':' || !is_digit(p[17]) || !is_digit(p[18]))
+			return false;
+		const char sep = p[10];
+		if (sep != 'T' && sep != ' ' && sep != 't')
+			return false;
+		lt.year = static_cast<int>(ets_word_pair(w0, 0) * 100 + ets_word_pair(w0, 2));
+		lt.month = ets_word_pair(w0, 5);
+		lt.day = ets_word_pair(w1, 0);
+		lt.hour = ets_word_pair(w1, 3);
+		lt.minute = ets_word_pair(w1, 6);
+		lt.second = (p[17] - '0') * 10 + (p[18] - '0');
+		return valid_ranges(lt);
+	}
+
+	bool parse_rfc3339(const char *p, const char *end, log_time &lt)
+	{
+		if (p < end && *p == '[')
+			p++;
+		if (end - p < 19 || !parse_ymd_hms(p, rfc3339_date, lt))
+			return false;
+		p = parse_fraction(p + 19, end, lt);
+		parse_offset(p, end, lt);
+		return true;
+	}
+
+	// <PRI>
+	const char *skip_syslog_priority(const char *p, const char *end)
+	{
+		if (p < end && *p == '<') {
+			const char *q = p + 1;
+			while (q < end && q - p <= 4 && is_digit(*q))
+				q++;
+			if (q < end && *q == '>' && q > p + 1)
+				return q + 1;
+		}
+		return p;
+	}
+
+	bool parse_syslog_rfc5424(const char *p, const char *end, log_time &lt)
+	{
+		const char *q = skip_syslog_priority(p, end);
+		if (q == p || end - q < 2 || q[0] != '1' || q[1] != ' ')
+			return false;
+		return parse_rfc3339(q + 2, end, lt);
+	}
+
+	// Mmm dd hh:mm:ss  (dd is space padded)
+	bool parse_syslog_rfc3164(const char *p, const char *end, log_time &lt)
+	{
+		p = skip_syslog_priority(p, end);
+		if (end - p < 15 || p[3] != ' ' || p[6] != ' ')
+			return false;
+		lt.month = parse_month_name(p);
+		if (!lt.month || !is_digit(p[5]) || (p[4] != ' ' && !is_digit(p[4])))
+			return false;
+		lt.day = (p[4] == ' ' ? 0 : (p[4] - '0') * 10) + (p[5] - '0');
+		uint64_t w;
+		if (!ets_match_word(ets_load_le64(p + 7), hms, w))
+			return false;
+		lt.hour = ets_word_pair(w, 0);
+		lt.minute = ets_word_pair(w, 3);
+		lt.second = ets_word_pair(w, 6);
+		lt.year = 0;
+		return valid_ranges(lt);
+	}
+
+	// ... [dd/Mmm/yyyy:hh:mm:ss +zzzz] ...
+	bool parse_common_log(const char *p, const char *end, log_time &lt)
+	{
+		// host, ident and user fields precede the timestamp.
+		const char *q = static_cast<const char *>(memchr(p, '[', (end - p < 256 ? end - p : 256)));
+		if (!q || end - q < 28)
+			return false;
+		q++;
+		uint64_t w0, w1, w2;
+		if (!ets_match_word(ets_load_le64(q), clf_day, w0)
+				|| !ets_match_word(ets_load_le64(q + 7), clf_year_hour, w1)
+				|| !ets_match_word(ets_load_le64(q + 15), clf_minute_second, w2))
+			return false;
+		lt.month = parse_month_name(q + 3);
+		lt.day = ets_word_pair(w0, 0);
+		lt.year = static_cast<int>(ets_word_pair(w1, 0) * 100 + ets_word_pair(w1, 2));
+		lt.hour = ets_word_pair(w1, 5);
+		lt.minute = ets_word_pair(w2, 0);
+		lt.second = ets_word_pair(w2, 3);
+		parse_offset(q + 21, end, lt);
+		return lt.month && valid_ranges(lt);
+	}
+
+	bool parse_nginx_error(const char *p, const char *end, log_time &lt)
+	{
+		return end - p >= 19 && parse_ymd_hms(p, nginx_date, lt) && p[10] == ' ';
+	}
+
+	// [Www Mmm dd hh:mm:ss[.uuuuuu] yyyy]
+	bool parse_apache_error(const char *p, const char *end, log_time &lt)
+	{
+		if (end - p < 26 || p[0] != '[' || p[4] != ' ' || p[8] != ' ' || p[11] != ' ')
+			return false;
+		lt.month = parse_month_name(p + 5);
+		if (!lt.month || !is_digit(p[10]) || (p[9] != ' ' && !is_digit(p[9])))
+			return false;
+		lt.day = (p[9] == ' ' ? 0 : (p[9] - '0') * 10) + (p[10] - '0');
+		uint64_t w;
+		if (!ets_match_word(ets_load_le64(p + 12), hms, w))
+			return false;
+		lt.hour = ets_word_pair(w, 0);
+		lt.minute = ets_word_pair(w, 3);
+		lt.second = ets_word_pair(w, 6);
+		const char *q = parse_fraction(p + 20, end, lt);
+		if (end - q < 6 || *q != ' ' || !is_digit(q[1]) || !is_digit(q[2]) || !is_digit(q[3]) || !is_digit(q[4]))
+			return false;
+		lt.year = (q[1] - '0') * 1000 + (q[2] - '0') * 100 + (q[3] - '0') * 10 + (q[4] - '0');
+		return valid_ranges(lt);
+	}
+
+	bool parse_format(ets_log_format_t format, const char *p, const char *end, log_time &lt)
+	{
+		lt.usec = 0;
+		lt.fraction_digits = 0;
+		lt.offset_minutes = 0;
+		switch (format) {
+		case ETS_LOG_FORMAT_RFC3339:
+			return parse_rfc3339(p, end, lt);
+		case ETS_LOG_FORMAT_SYSLOG_RFC5424:
+			return parse_syslog_rfc5424(p, end, lt);
+		case ETS_LOG_FORMAT_SYSLOG_RFC3164:
+			return parse_syslog_rfc3164(p, end, lt);
+		case ETS_LOG_FORMAT_COMMON_LOG:
+			return parse_common_log(p, end, lt);
+		case ETS_LOG_FORMAT_NGINX_ERROR:
+			return parse_nginx_error(p, end, lt);
+		case ETS_LOG_FORMAT_APACHE_ERROR:
+			return parse_apache_error(p, end, lt);
+		default:
+			return false;
+		}
+	}
+
+	ets_log_format_t detect(const char *p, const char *end)
+	{
+		static const ets_log_format_t candidates[] = {
+			ETS_LOG_FORMAT_RFC3339,
+			ETS_LOG_FORMAT_SYSLOG_RFC5424,
+			ETS_LOG_FORMAT_SYSLOG_RFC3164,
+			ETS_LOG_FORMAT_NGINX_ERROR,
+			ETS_LOG_FORMAT_APACHE_ERROR,
+			ETS_LOG_FORMAT_COMMON_LOG,
+		};
+		log_time lt;
+		for (ets_log_format_t f : candidates) {
+			if (parse_format(f, p, end, lt))
+				return f;
+		}
+		return ETS_LOG_FORMAT_UNKNOWN;
+	}
+
+	// RFC 3164 syslog: take the year from the state, advancing it when the log crosses new year. Returns false
+	// for Feb 29 in a year which turns out not to be a leap year.
+	bool assign_syslog_year(ets_logscan_state_t &state, log_time &lt)
+	{
+		if (state.last_month && static_cast<int>(lt.month) + 6 < state.last_month)
+			state.year++;
+		state.last_month = lt.month;
+		lt.year = state.year;
+		return valid_ranges(lt);
+	}
+
+	eternal_timestamp_t encode(ets_logscan_state_t &state, log_time &lt)
+	{
+		if (lt.offset_minutes) {
+			const int64_t minutes = ets_days_from_civil(lt.year, lt.month, lt.day) * 1440 + lt.hour * 60 + lt.minute - lt.offset_minutes;
+			const int64_t days = (minutes >= 0 ? minutes : minutes - 1439) / 1440;
+			const int64_t rest = minutes - days * 1440;
+			int64_t y;
+			ets_civil_from_days(days, y, lt.month, lt.day);
+			lt.year = static_cast<int>(y);
+			lt.hour = static_cast<unsigned int>(rest / 60);
+			lt.minute = static_cast<unsigned int>(rest % 60);
+		}
+
+		const uint32_t key = (static_cast<uint32_t>(lt.year + MODERN_EPOCH) << 9) | (lt.month << 5) | lt.day;
+		if (key != state.cached_date_key) {
+			state.cached_date = ets_encode_modern(lt.year, lt.month, lt.day, 0, 0, 0, 0, 0);
+			state.cached_date_key = key;
+		}
+
+		eternal_timestamp_t t = state.cached_date;
+		t = ets_modern_set_hour(t, FIELD_VAL_OFFSET + lt.hour);
+		t = ets_modern_set_minute(t, FIELD_VAL_OFFSET + lt.minute);
+		t = ets_modern_set_seconds(t, FIELD_VAL_OFFSET + lt.second);
+		if (!lt.fraction_digits) {
+			t = ets_modern_set_milliseconds(t, get_Invalid(ETMT_FIELDSIZE_MILLISECONDS));
+			t = ets_modern_set_microseconds(t, get_Invalid(ETMT_FIELDSIZE_MICROSECONDS));
+		}
+		else {
+			t = ets_modern_set_milliseconds(t, FIELD_VAL_OFFSET + lt.usec / 1000);
+			t = ets_modern_set_microseconds(t, lt.fraction_digits <= 3 ? get_Invalid(ETMT_FIELDSIZE_MICROSECONDS) : FIELD_VAL_OFFSET + lt.usec % 1000);
+		}
+		return t;
+	}
+
+	bool parse_one_line(eternal_timestamp_t &dst, ets_logscan_state_t &state, const char *p, const char *end)
+	{
+		if (state.format == ETS_LOG_FORMAT_UNKNOWN)
+			state.format = detect(p, end);
+
+		log_time lt;
+		if (state.format == ETS_LOG_FORMAT_UNKNOWN || !parse_format(state.format, p, end, lt)
+				|| (state.format == ETS_LOG_FORMAT_SYSLOG_RFC3164 && !assign_syslog_year(state, lt))) {
+			dst = ets_make_unknown();
+			return false;
+		}
+		dst = encode(state, lt);
+		return true;
+	}
+}
+
+
+void EternalTimestampLogScan::init(ets_logscan_state_t &state, ets_log_format_t format, int year)
+{
+	if (!year) {
+		const time_t now = time(nullptr);
+		struct tm tm;
+#if defined(_WIN32)
+		gmtime_s(&tm, &now);
+#else
+		gmtime_r(&now, &tm);
+#endif
+		year = tm.tm_year + 1900;
+	}
+	state.format = format;
+	state.year = year;
+	state.last_month = 0;
+	state.cached_date_key = UINT32_MAX;
+	state.cached_date = ets_make_unknown();
+}
+
+ets_log_format_t EternalTimestampLogScan::detect_format(const char *line, size_t length)
+{
+	ETS_STATS_ENTRY(LOGSCAN_DETECT_FORMAT);
+	return detect(line, line + length);
+}
+
+bool EternalTimestampLogScan::parse_line(eternal_timestamp_t &dst, ets_logscan_state_t &state, const char *line, size_t length)
+{
+	ETS_STATS_ENTRY(LOGSCAN_PARSE_LINE);
+	return parse_one_line(dst, state, line, line + length);
+}
+
+size_t EternalTimestampLogScan::scan(eternal_timestamp_t *timestamps, size_t *line_offsets, size_t capacity, ets_logscan_state_t &state, const char *buffer, size_t length, bool at_eof, size_t &consumed)
+{
+	ETS_STATS_ENTRY(LOGSCAN_SCAN);
+	const char *p = buffer;
+	const char *const end = buffer + length;
+	size_t n = 0;
+	while (n < capacity && p < end) {
+		const char *eol = static_cast<const char *>(memchr(p, '\n', end - p));
+		if (!eol && !at_eof)
+			break;
+		const char *line_end = (eol ? eol : end);
+		if (line_offsets)
+			line_offsets[n] = p - buffer;
+		parse_one_line(timestamps[n], state, p, line_end);
+		n++;
+		p = (eol ? eol + 1 : end);
+	}
+	consumed = p - buffer;
+	return n;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// C interface
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+extern "C" void ets_logscan_init(ets_logscan_state_t *state, ets_log_format_t format, int year)
+{
+	EternalTimestampLogScan::init(*state, format, year);
+}
+
+extern "C" ets_log_format_t ets_logscan_detect_format(const char *line, size_t length)
+{
+	return EternalTimestampLogScan::detect_format(line, length);
+}
+
+extern "C" BOOL ets_logscan_parse_line(eternal_timestamp_t *dst, ets_logscan_state_t *state, const char *line, size_t length)
+{
+	return EternalTimestampLogScan::parse_line(*dst, *state, line, length);
+}
+
+extern "C" size_t ets_logscan_scan(eternal_timestamp_t *timestamps, size_t *line_offsets, size_t capacity, ets_logscan_state_t *state, const char *buffer, size_t length, BOOL at_eof, size_t *consumed)
+{
+	return EternalTimestampLogScan::scan(timestamps, line_offsets, capacity, *state, buffer, length, !!at_eof, *consumed);
+}
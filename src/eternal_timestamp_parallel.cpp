@@ -0,0 +1,372 @@
+
+#include "eternal_timestamp/eternal_timestamp_parallel.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include "eternal_timestamp_internal.h"
+
+
+using namespace eternal_timestamp;
+
+
+// A fork-join pool: one job at a time, which each thread joins with its own worker index. The load balancing
+// is done by the job itself (see `job_work()`), so the pool merely has to start all threads at once.
+struct ets_thread_pool
+{
+	std::vector<std::thread> threads;
+
+	std::mutex run_lock;                  // held by the thread which has a job running on the pool
+
+	std::mutex lock;                      // guards the fields below
+	std::condition_variable wake;
+	std::condition_variable done;
+	uint64_t generation = 0;              // bumped for each job
+	bool stopping = false;
+	void (*work)(void *arg, unsigned int worker) = nullptr;
+	void *arg = nullptr;
+	unsigned int workers = 0;             // of the current job, the thread which started it included
+	unsigned int busy = 0;                // pool threads still working on the current job
+};
+
+
+namespace
+{
+	// Set on the pool threads and on any thread while it runs a `parallel_for()` body: nested bulk calls run
+	// on the calling thread, which is already as parallel as it gets and cannot deadlock on a busy pool.
+	thread_local bool in_parallel_region = false;
+
+	void worker_main(ets_thread_pool *pool, unsigned int index)
+	{
+		in_parallel_region = true;
+		uint64_t seen = 0;
+		std::unique_lock<std::mutex> guard(pool->lock);
+		for (;;) {
+			pool->wake.wait(guard, [&] { return pool->stopping || pool->generation != seen; });
+			if (pool->stopping)
+				return;
+			seen = pool->generation;
+			if (index >= pool->workers)
+				continue;
+			void (*work)(void *, unsigned int) = pool->work;
+			void *arg = pool->arg;
+			guard.unlock();
+			work(arg, index);
+			guard.lock();
+			if (--pool->busy == 0)
+				pool->done.notify_one();
+		}
+	}
+
+	void run_serially(void *, void (*work)(void *arg, unsigned int worker), void *arg, unsigned int workers)
+	{
+		for (unsigned int i = 0; i < workers; i++)
+			work(arg, i);
+	}
+
+	void run_on_pool(void *context, void (*work)(void *arg, unsigned int worker), void *arg, unsigned int workers)
+	{
+		ets_thread_pool *pool = static_cast<ets_thread_pool *>(context);
+
+		// another thread's job is running: rather than queue up, do the work ourselves.
+		std::unique_lock<std::mutex> exclusive(pool->run_lock, std::try_to_lock);
+		if (!exclusive.owns_lock() || workers <= 1) {
+			run_serially(nullptr, work, arg, workers);
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> guard(pool->lock);
+			pool->work = work;
+			pool->arg = arg;
+			pool->workers = workers;
+			pool->busy = workers - 1;
+			pool->generation++;
+		}
+		pool->wake.notify_all();
+
+		work(arg, 0);
+
+		std::unique_lock<std::mutex> guard(pool->lock);
+		pool->done.wait(guard, [&] { return pool->busy == 0; });
+	}
+
+	// The executors ever installed; never freed, as calls which are still running may use them.
+	struct executor_node
+	{
+		ets_executor_t executor;
+		executor_node *next;
+	};
+
+	std::mutex executor_lock;
+	executor_node *all_executors = nullptr;
+	std::atomic<const ets_executor_t *> installed_executor{ nullptr };
+	std::atomic<unsigned int> default_hint{ 1 };
+
+	const ets_executor_t &library_executor()
+	{
+		static const ets_executor_t executor = [] {
+			const unsigned int n = std::thread::hardware_concurrency();
+			ets_thread_pool_t *pool = (n > 1 ? EternalTimestampThreadPool::create(n - 1) : nullptr);
+			if (pool)
+				return EternalTimestampThreadPool::executor(pool);
+			ets_executor_t serial{ run_serially, nullptr, 1 };
+			return serial;
+		}();
+		return executor;
+	}
+
+	const ets_executor_t &current_executor()
+	{
+		const ets_executor_t *e = installed_executor.load(std::memory_order_acquire);
+		return (e ? *e : library_executor());
+	}
+
+	unsigned int resolve_hint(unsigned int parallelism)
+	{
+		if (parallelism == ETS_PARALLELISM_DEFAULT)
+			parallelism = default_hint.load(std::memory_order_relaxed);
+		return parallelism;
+	}
+
+	// The chunks a worker has yet to process, [begin, end), packed into one word: begin in the upper half. The
+	// owner takes chunks from the front, thieves take half of what's left from the back.
+	struct alignas(64) chunk_range
+	{
+		std::atomic<uint64_t> range;
+	};
+
+	inline uint64_t pack(uint64_t begin, uint64_t end)
+	{
+		return (begin << 32) | end;
+	}
+
+	struct job
+	{
+		size_t count;
+		size_t grain;
+		void (*body)(void *ctx, size_t begin, size_t end);
+		void *ctx;
+		unsigned int workers;
+		chunk_range *ranges;
+	};
+
+	bool take_front(chunk_range &own, uint64_t &chunk)
+	{
+		uint64_t v = own.range.load(std::memory_order_acquire);
+		for (;;) {
+			const uint64_t begin = v >> 32;
+			const uint64_t end = v & 0xFFFFFFFFU;
+			if (begin >= end)
+				return false;
+			if (own.range.compare_exchange_weak(v, pack(begin + 1, end), std::memory_order_acq_rel)) {
+				chunk = begin;
+				return true;
+			}
+		}
+	}
+
+	bool steal(job &j, unsigned int self, uint64_t &chunk)
+	{
+		for (unsigned int k = 1; k < j.workers; k++) {
+			chunk_range &victim = j.ranges[(self + k) % j.workers];
+			uint64_t v = victim.range.load(std::memory_order_acquire);
+			for (;;) {
+				const uint64_t begin = v >> 32;
+				const uint64_t end = v & 0xFFFFFFFFU;
+				if (begin >= end)
+					break;
+				const uint64_t split = end - (end - begin + 1) / 2;
+				if (victim.range.compare_exchange_weak(v, pack(begin, split), std::memory_order_acq_rel)) {
+					// our own range is empty, hence left alone by the other thieves: no need for a CAS.
+					chunk = split;
+					j.ranges[self].range.store(pack(split + 1, end), std::memory_order_release);
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	void job_work(void *arg, unsigned int worker)
+	{
+		job &j = *static_cast<job *>(arg);
+		const bool nested = in_parallel_region;
+		in_parallel_region = true;
+
+		uint64_t chunk;
+		while (take_front(j.ranges[worker], chunk) || steal(j, worker, chunk)) {
+			const size_t begin = static_cast<size_t>(chunk) * j.grain;
+			const size_t end = (j.count - begin > j.grain ? begin + j.grain : j.count);
+			j.body(j.ctx, begin, end);
+		}
+
+		in_parallel_region = nested;
+	}
+}
+
+
+ets_thread_pool_t *EternalTimestampThreadPool::create(unsigned int threads)
+{
+	ets_thread_pool *pool = new (std::nothrow) ets_thread_pool();
+	if (!pool)
+		return nullptr;
+	try {
+		pool->threads.reserve(threads);
+		for (unsigned int i = 0; i < threads; i++)
+			pool->threads.emplace_back(worker_main, pool, i + 1);
+	}
+	catch (...) {
+		destroy(pool);
+		return nullptr;
+	}
+	return pool;
+}
+
+void EternalTimestampThreadPool::destroy(ets_thread_pool_t *pool)
+{
+	if (!pool)
+		return;
+	{
+		std::lock_guard<std::mutex> guard(pool->lock);
+		pool->stopping = true;
+	}
+	pool->wake.notify_all();
+	for (auto &t : pool->threads)
+		t.join();
+	delete pool;
+}
+
+ets_executor_t EternalTimestampThreadPool::executor(ets_thread_pool_t *pool)
+{
+	ets_executor_t e{ run_on_pool, pool, static_cast<unsigned int>(pool->threads.size() + 1) };
+	return e;
+}
+
+
+void EternalTimestampParallel::set_executor(const ets_executor_t *executor)
+{
+	if (!executor || !executor->run || executor->concurrency == 0) {
+		installed_executor.store(nullptr, std::memory_order_release);
+		return;
+	}
+	executor_node *node = new (std::nothrow) executor_node{ *executor, nullptr };
+	if (!node)
+		return;
+	std::lock_guard<std::mutex> guard(executor_lock);
+	node->next = all_executors;
+	all_executors = node;
+	installed_executor.store(&node->executor, std::memory_order_release);
+}
+
+void EternalTimestampParallel::set_default_parallelism(unsigned int parallelism)
+{
+	default_hint.store(parallelism == ETS_PARALLELISM_DEFAULT ? 1 : parallelism, std::memory_order_relaxed);
+}
+
+unsigned int EternalTimestampParallel::default_parallelism()
+{
+	return default_hint.load(std::memory_order_relaxed);
+}
+
+unsigned int EternalTimestampParallel::concurrency(unsigned int parallelism)
+{
+	const unsigned int hint = resolve_hint(parallelism);
+	if (hint <= 1)
+		return 1;
+	const unsigned int available = current_executor().concurrency;
+	return (hint < available ? hint : available);
+}
+
+void EternalTimestampParallel::run(size_t count, size_t grain, unsigned int parallelism, void (*body)(void *ctx, size_t begin, size_t end), void *ctx)
+{
+	if (!count)
+		return;
+	if (!grain)
+		grain = ETS_PARALLEL_GRAIN;
+
+	unsigned int workers = resolve_hint(parallelism);
+	size_t chunks = (count - 1) / grain + 1;
+	if (workers <= 1 || chunks < 2 || in_parallel_region) {
+		body(ctx, 0, count);
+		return;
+	}
+
+	const ets_executor_t &executor = current_executor();
+	if (workers > executor.concurrency)
+		workers = executor.concurrency;
+	if (workers > chunks)
+		workers = static_cast<unsigned int>(chunks);
+	if (workers <= 1) {
+		body(ctx, 0, count);
+		return;
+	}
+
+	// chunk numbers have to fit in 32 bits: grow the chunks of absurdly large columns.
+	while (chunks > 0xFFFFFFFFU) {
+		grain *= 2;
+		chunks = (count - 1) / grain + 1;
+	}
+
+	std::unique_ptr<chunk_range[]> ranges(new (std::nothrow) chunk_range[workers]);
+	if (!ranges) {
+		body(ctx, 0, count);
+		return;
+	}
+	for (unsigned int w = 0; w < workers; w++) {
+		ranges[w].range.store(pack(chunks * w / workers, chunks * (w + 1) / workers), std::memory_order_relaxed);
+	}
+
+	job j{ count, grain, body, ctx, workers, ranges.get() };
+	executor.run(executor.context, job_work, &j, workers);
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// C interface
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+extern "C" ets_thread_pool_t *ets_thread_pool_create(unsigned int threads)
+{
+	return EternalTimestampThreadPool::create(threads);
+}
+
+extern "C" void ets_thread_pool_destroy(ets_thread_pool_t *pool)
+{
+	EternalTimestampThreadPool::destroy(pool);
+}
+
+extern "C" ets_executor_t ets_thread_pool_executor(ets_thread_pool_t *pool)
+{
+	return EternalTimestampThreadPool::executor(pool);
+}
+
+extern "C" void ets_parallel_set_executor(const ets_executor_t *executor)
+{
+	EternalTimestampParallel::set_executor(executor);
+}
+
+extern "C" void ets_parallel_set_default_parallelism(unsigned int parallelism)
+{
+	EternalTimestampParallel::set_default_parallelism(parallelism);
+}
+
+extern "C" unsigned int ets_parallel_default_parallelism(void)
+{
+	return EternalTimestampParallel::default_parallelism();
+}
+
+extern "C" unsigned int ets_parallel_concurrency(unsigned int parallelism)
+{
+	return EternalTimestampParallel::concurrency(parallelism);
+}
+
+extern "C" void ets_parallel_for(size_t count, size_t grain, unsigned int parallelism, void (*body)(void *ctx, size_t begin, size_t end), void *ctx)
+{
+	EternalTimestampParallel::run(count, grain, parallelism, body, ctx);
+}
@@ -0,0 +1,604 @@
+
+#include "eternal_timestamp/eternal_timestamp_schedule.h"
+
+#include <cstring>
+
+#include "eternal_timestamp_instrumentation.h"
+#include "eternal_timestamp_internal.h"
+
+
+using namespace eternal_timestamp;
+
+
+namespace
+{
+	// In the time-of-day sets: the field is unspecified. Never collides with a value, as the sets use 60 bits at most.
+	const uint64_t UNSPECIFIED = 1ULL << 63;
+
+	const uint64_t ALL_HOURS = (1ULL << 24) - 1;
+	const uint64_t ALL_MINUTES = (1ULL << 60) - 1;      // and seconds
+
+	enum step_level
+	{
+		LEVEL_HOUR = 0,
+		LEVEL_MINUTE,
+		LEVEL_SECOND,
+		LEVEL_NONE,         // the frequency steps days, or longer periods
+	};
+
+	// The month lengths minus 28, 2 bits per month, January in the lowest bits.
+	const uint32_t MONTH_LENGTHS = (3 << 0) | (0 << 2) | (3 << 4) | (2 << 6) | (3 << 8) | (2 << 10)
+		| (3 << 12) | (3 << 14) | (2 << 16) | (3 << 18) | (2 << 20) | (3 << 22);
+
+	// The days 0, 7, 14, 21 and 28 of a month: multiplying a weekday set by this repeats it over the whole month.
+	const uint64_t WEEKS = 0x10204081ULL;
+
+	// Beyond this number of months without an occurrence, the rule has none left: the Gregorian calendar repeats
+	// itself every 400 years (which is a whole number of weeks), and the interval's phase repeats itself within
+	// `interval` of those cycles.
+	const uint64_t CALENDAR_CYCLE_MONTHS = 400 * 12;
+
+	inline int64_t floor_div(int64_t v, int64_t d)
+	{
+		return (v >= 0 ? v / d : -((-v + d - 1) / d));
+	}
+
+	inline int64_t floor_mod(int64_t v, int64_t d)
+	{
+		return v - floor_div(v, d) * d;
+	}
+
+	inline unsigned int lowest_bit(uint64_t mask)
+	{
+#if defined(__GNUC__)
+		return static_cast<unsigned int>(__builtin_ctzll(mask));
+#else
+		unsigned int n = 0;
+		while (!(mask & 1)) {
+			mask >>= 1;
+			n++;
+		}
+		return n;
+#endif
+	}
+
+	inline unsigned int month_length(int64_t y, unsigned int m)
+	{
+		const unsigned int leap = (y % 4 == 0) & ((y % 100 != 0) | (y % 400 == 0));
+		return 28 + ((MONTH_LENGTHS >> (2 * (m - 1))) & 3) + ((m == 2) & leap);
+	}
+
+	// Monday is 0; day 0 (1970/jan/01) was a Thursday.
+	inline unsigned int weekday_of(int64_t day)
+	{
+		return static_cast<unsigned int>(floor_mod(day + 3, 7));
+	}
+
+	inline uint32_t reverse_bits(uint32_t v)
+	{
+		v = ((v >> 1) & 0x55555555U) | ((v & 0x55555555U) << 1);
+		v = ((v >> 2) & 0x33333333U) | ((v & 0x33333333U) << 2);
+		v = ((v >> 4) & 0x0F0F0F0FU) | ((v & 0x0F0F0F0FU) << 4);
+		v = ((v >> 8) & 0x00FF00FFU) | ((v & 0x00FF00FFU) << 8);
+		return (v >> 16) | (v << 16);
+	}
+
+	// a bit every `interval` bits, starting at bit 0
+	uint64_t make_step_pattern(uint64_t interval)
+	{
+		if (interval == 1)
+			return ~0ULL;
+		uint64_t pattern = 0;
+		for (uint64_t i = 0; i < 64; i += interval)
+			pattern |= 1ULL << i;
+		return pattern;
+	}
+
+	// the step pattern moved to start at bit `phase`
+	inline uint64_t shift_pattern(uint64_t pattern, int64_t phase)
+	{
+		return (phase < 64 ? pattern << phase : 0);
+	}
+
+	inline unsigned int value_of(unsigned int bit)
+	{
+		return (bit == 63 ? 0 : bit);
+	}
+
+	inline uint64_t code_of(unsigned int bit, unsigned int field_size)
+	{
+		return (bit == 63 ? get_Invalid(field_size) : FIELD_VAL_OFFSET + bit);
+	}
+
+	inline bool in_modern_range(int64_t y)
+	{
+		const int64_t century = (y + MODERN_EPOCH) / 100;
+		return y + MODERN_EPOCH >= 100 && century < (1 << ETMT_CENTURY_BITS) && century != get_Invalid(ETMT_FIELDSIZE_CENTURY);
+	}
+
+	// Make `s.month` the current month; returns `false` past the end of the modern range.
+	bool load_month(ets_schedule_t &s)
+	{
+		const int64_t y = floor_div(s.month, 12);
+		const unsigned int m = static_cast<unsigned int>(s.month - y * 12) + 1;
+		if (!in_modern_range(y))
+			return false;
+		const int64_t yy = y + MODERN_EPOCH;
+		eternal_timestamp_t t{0};
+		t = ets_modern_set_century(t, yy / 100);
+		t = ets_modern_set_year(t, FIELD_VAL_OFFSET + yy % 100);
+		t = ets_modern_set_month(t, FIELD_VAL_OFFSET - 1 + m);
+		s.month_bits = t.t;
+		s.month_first_day = ets_days_from_civil(y, m, 1);
+		return true;
+	}
+
+	// The days of the current month which the rule selects, as a mask: bit d - 1 for day d.
+	uint32_t select_days(const ets_schedule_t &s)
+	{
+		const ets_schedule_rule_t &rule = s.rule;
+		const int64_t y = floor_div(s.month, 12);
+		const unsigned int m = static_cast<unsigned int>(s.month - y * 12) + 1;
+		const unsigned int length = month_length(y, m);
+		const int64_t first = s.month_first_day;
+
+		if (rule.by_month ? !((rule.by_month >> (m - 1)) & 1)
+			: rule.frequency == ETS_SCHEDULE_YEARLY && !rule.by_month_day && !rule.by_month_day_from_end && !rule.by_weekday && floor_mod(s.month - s.base_month, 12) != 0)
+			return 0;
+
+		uint64_t days = (1ULL << length) - 1;
+
+		// the days the interval steps to
+		if (rule.frequency == ETS_SCHEDULE_DAILY) {
+			days &= shift_pattern(s.step_pattern, floor_mod(s.base_day - first, rule.interval));
+		}
+		else if (rule.frequency == ETS_SCHEDULE_WEEKLY) {
+			const int64_t base_monday = s.base_day - weekday_of(s.base_day);
+			uint64_t weeks = 0;
+			for (int64_t monday = first - weekday_of(first); monday < first + length; monday += 7) {
+				if (floor_mod((monday - base_monday) / 7, rule.interval) == 0)
+					weeks |= (monday >= first ? 0x7FULL << (monday - first) : 0x7FULL >> (first - monday));
+			}
+			days &= weeks;
+		}
+
+		// the days of the month...
+		uint64_t selected = s.day_set;
+		if (rule.by_month_day_from_end)
+			selected |= reverse_bits(rule.by_month_day_from_end) >> (32 - length);
+		days &= selected;
+
+		// ... and of the week
+		const unsigned int w = weekday_of(first);
+		const uint64_t week = ((s.weekday_set >> w) | (s.weekday_set << (7 - w))) & 0x7F;
+		days &= week * WEEKS;
+
+		// nothing before the base
+		if (s.month == s.base_month)
+			days &= ~((1ULL << (s.base_day - first)) - 1);
+		return static_cast<uint32_t>(days);
+	}
+
+	// Move on to the next month the frequency steps to.
+	inline void advance_month(ets_schedule_t &s)
+	{
+		if (s.rule.frequency == ETS_SCHEDULE_MONTHLY)
+			s.month += s.rule.interval;
+		else if (s.rule.frequency == ETS_SCHEDULE_YEARLY && floor_mod(s.month, 12) == 11)
+			s.month += 12 * (static_cast<int64_t>(s.rule.interval) - 1) + 1;
+		else
+			s.month++;
+	}
+
+	inline int64_t current_day(const ets_schedule_t &s)
+	{
+		return s.month_first_day + s.day;
+	}
+
+	// The sets for the current day, hour and minute, aligned to the interval where the frequency steps that field.
+	inline uint64_t select_hours(const ets_schedule_t &s)
+	{
+		if (s.level != LEVEL_HOUR)
+			return s.hours;
+		return s.hours & shift_pattern(s.step_pattern, floor_mod(floor_div(s.base_position, 3600) - current_day(s) * 24, s.rule.interval));
+	}
+
+	inline uint64_t select_minutes(const ets_schedule_t &s)
+	{
+		if (s.level != LEVEL_MINUTE)
+			return s.minutes;
+		return s.minutes & shift_pattern(s.step_pattern, floor_mod(floor_div(s.base_position, 60) - current_day(s) * 1440 - s.hour * 60, s.rule.interval));
+	}
+
+	inline uint64_t select_seconds(const ets_schedule_t &s)
+	{
+		if (s.level != LEVEL_SECOND)
+			return s.seconds;
+		return s.seconds & shift_pattern(s.step_pattern, floor_mod(s.base_position - current_day(s) * 86400 - (s.hour * 60 + s.minute) * 60, s.rule.interval));
+	}
+
+	bool step(ets_schedule_t &s, eternal_timestamp_t &dst)
+	{
+		if (s.done)
+			return false;
+		const uint64_t idle_limit = CALENDAR_CYCLE_MONTHS
+			* (s.rule.frequency <= ETS_SCHEDULE_MONTHLY ? 1 : static_cast<uint64_t>(s.rule.interval)) + 12;
+		for (;;) {
+			if (s.seconds_left) {
+				const unsigned int second = lowest_bit(s.seconds_left);
+				s.seconds_left &= s.seconds_left - 1;
+
+				const int64_t position = current_day(s) * 86400 + (value_of(s.hour) * 60 + value_of(s.minute)) * 60 + value_of(second);
+				if (position < s.base_position)
+					continue;
+				if (position > s.until_position)
+					break;
+				dst.t = s.day_bits
+					| (code_of(s.hour, ETMT_FIELDSIZE_HOUR) << ETMT_HOUR_SHIFT)
+					| (code_of(s.minute, ETMT_FIELDSIZE_MINUTE) << ETMT_MINUTE_SHIFT)
+					| (code_of(second, ETMT_FIELDSIZE_SECONDS) << ETMT_SECONDS_SHIFT)
+					| s.subsecond_bits;
+				s.idle_months = 0;
+				if (++s.emitted == s.rule.count)
+					s.done = 1;
+				return true;
+			}
+			if (s.minutes_left) {
+				s.minute = lowest_bit(s.minutes_left);
+				s.minutes_left &= s.minutes_left - 1;
+				s.seconds_left = select_seconds(s);
+				continue;
+			}
+			if (s.hours_left) {
+				s.hour = lowest_bit(s.hours_left);
+				s.hours_left &= s.hours_left - 1;
+				s.minutes_left = select_minutes(s);
+				continue;
+			}
+			if (s.days_left) {
+				s.day = lowest_bit(s.days_left);
+				s.days_left &= s.days_left - 1;
+				s.day_bits = s.month_bits | (static_cast<uint64_t>(FIELD_VAL_OFFSET + s.day) << ETMT_DAY_SHIFT);
+				s.hours_left = select_hours(s);
+				continue;
+			}
+			if (++s.idle_months > idle_limit)
+				break;
+			advance_month(s);
+			if (!load_month(s) || s.month_first_day * 86400 > s.until_position)
+				break;
+			s.days_left = select_days(s);
+		}
+		s.done = 1;
+		return false;
+	}
+
+	// The set for a time field: the rule's, else every value where the frequency steps this field or a finer
+	// one, else the base's value.
+	uint64_t time_set(uint64_t by, uint64_t all, unsigned int field, unsigned int level, uint64_t code, unsigned int field_size)
+	{
+		if (by)
+			return by;
+		if (level != LEVEL_NONE && field <= level)
+			return all;
+		if (code == get_Invalid(field_size))
+			return UNSPECIFIED;
+		return 1ULL << (code - FIELD_VAL_OFFSET);
+	}
+
+
+	//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// RRULE text
+	//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	inline bool is_digit(char c)
+	{
+		return static_cast<unsigned char>(c - '0') <= 9;
+	}
+
+	inline char upper(char c)
+	{
+		return (c >= 'a' && c <= 'z' ? c - 'a' + 'A' : c);
+	}
+
+	bool equals(const char *p, const char *end, const char *word)
+	{
+		for (; p < end && *word; p++, word++) {
+			if (upper(*p) != *word)
+				return false;
+		}
+		return p == end && !*word;
+	}
+
+	bool parse_number(const char *&p, const char *end, uint64_t &dst)
+	{
+		if (p == end || !is_digit(*p))
+			return false;
+		dst = 0;
+		for (; p < end && is_digit(*p); p++) {
+			if (dst > (UINT64_MAX - 9) / 10)
+				return false;
+			dst = dst * 10 + (*p - '0');
+		}
+		return true;
+	}
+
+	// A comma separated list of numbers in [lo, hi], as a set with bit `v - lo` for number `v`. Negative numbers
+	// -1 .. -hi go into `negatives` as bit `-v - 1`, where that is allowed.
+	bool parse_list(const char *p, const char *end, unsigned int lo, unsigned int hi, uint64_t &dst, uint64_t *negatives)
+	{
+		dst = 0;
+		for (;;) {
+			const bool negative = (p < end && *p == '-');
+			if (negative && !negatives)
+				return false;
+			p += negative;
+			if (!negative && p < end && *p == '+')
+				p++;
+			uint64_t v;
+			if (!parse_number(p, end, v) || v < (negative ? 1 : lo) || v > hi)
+				return false;
+			if (negative)
+				*negatives |= 1ULL << (v - 1);
+			else
+				dst |= 1ULL << (v - lo);
+			if (p == end)
+				return true;
+			if (*p++ != ',')
+				return false;
+		}
+	}
+
+	const char *const weekday_names[7] = { "MO", "TU", "WE", "TH", "FR", "SA", "SU" };
+
+	bool parse_weekdays(const char *p, const char *end, uint8_t &dst)
+	{
+		dst = 0;
+		for (;;) {
+			const char *q = static_cast<const char *>(memchr(p, ',', end - p));
+			if (!q)
+				q = end;
+			// ordinals (-1FR) are not supported
+			int day = -1;
+			for (int i = 0; i < 7; i++) {
+				if (equals(p, q, weekday_names[i]))
+					day = i;
+			}
+			if (day < 0)
+				return false;
+			dst |= 1 << day;
+			if (q == end)
+				return true;
+			p = q + 1;
+		}
+	}
+
+	bool parse_part(ets_schedule_rule_t &rule, const char *name, const char *name_end, const char *p, const char *end, bool &have_frequency)
+	{
+		uint64_t set = 0;
+		uint64_t v;
+		if (equals(name, name_end, "FREQ")) {
+			static const char *const names[] = { "YEARLY", "MONTHLY", "WEEKLY", "DAILY", "HOURLY", "MINUTELY", "SECONDLY" };
+			for (int i = 0; i <= ETS_SCHEDULE_SECONDLY; i++) {
+				if (equals(p, end, names[i])) {
+					rule.frequency = static_cast<ets_schedule_frequency_t>(i);
+					have_frequency = true;
+					return true;
+				}
+			}
+			return false;
+		}
+		if (equals(name, name_end, "INTERVAL")) {
+			if (!parse_number(p, end, v) || p != end || v < 1 || v > UINT32_MAX)
+				return false;
+			rule.interval = static_cast<uint32_t>(v);
+			return true;
+		}
+		if (equals(name, name_end, "COUNT")) {
+			if (!parse_number(p, end, v) || p != end || v < 1)
+				return false;
+			rule.count = v;
+			return true;
+		}
+		if (equals(name, name_end, "UNTIL"))
+			return EternalTimestamp::cvt_from_iso8601(rule.until, p, end - p) == 0;
+		if (equals(name, name_end, "BYMONTH")) {
+			if (!parse_list(p, end, 1, 12, set, nullptr))
+				return false;
+			rule.by_month = static_cast<uint16_t>(set);
+			return true;
+		}
+		if (equals(name, name_end, "BYMONTHDAY")) {
+			uint64_t from_end = 0;
+			if (!parse_list(p, end, 1, 31, set, &from_end))
+				return false;
+			rule.by_month_day = static_cast<uint32_t>(set);
+			rule.by_month_day_from_end = static_cast<uint32_t>(from_end);
+			return true;
+		}
+		if (equals(name, name_end, "BYDAY"))
+			return parse_weekdays(p, end, rule.by_weekday);
+		if (equals(name, name_end, "BYHOUR")) {
+			if (!parse_list(p, end, 0, 23, set, nullptr))
+				return false;
+			rule.by_hour = static_cast<uint32_t>(set);
+			return true;
+		}
+		if (equals(name, name_end, "BYMINUTE"))
+			return parse_list(p, end, 0, 59, rule.by_minute, nullptr);
+		if (equals(name, name_end, "BYSECOND"))
+			return parse_list(p, end, 0, 59, rule.by_second, nullptr);
+		// weeks start on Monday
+		if (equals(name, name_end, "WKST"))
+			return equals(p, end, "MO");
+		return false;
+	}
+}
+
+
+void EternalTimestampSchedule::init_rule(ets_schedule_rule_t &rule, ets_schedule_frequency_t frequency)
+{
+	memset(&rule, 0, sizeof(rule));
+	rule.frequency = frequency;
+	rule.interval = 1;
+	rule.until = ets_make_unknown();
+}
+
+int EternalTimestampSchedule::parse_rule(ets_schedule_rule_t &dst, const char *text, size_t length)
+{
+	ETS_STATS_ENTRY(SCHEDULE_PARSE_RULE);
+	ets_schedule_rule_t rule;
+	init_rule(rule, ETS_SCHEDULE_DAILY);
+	const char *p = text;
+	const char *const end = text + length;
+	if (length >= 6 && equals(p, p + 6, "RRULE:"))
+		p += 6;
+
+	bool have_frequency = false;
+	while (p < end) {
+		const char *part_end = static_cast<const char *>(memchr(p, ';', end - p));
+		if (!part_end)
+			part_end = end;
+		const char *eq = static_cast<const char *>(memchr(p, '=', part_end - p));
+		if (!eq || !parse_part(rule, p, eq, eq + 1, part_end, have_frequency))
+			return -1;
+		p = part_end + (part_end < end);
+	}
+	// RFC 5545 doesn't allow both
+	if (!have_frequency || (rule.count && rule.until.t != ets_make_unknown().t))
+		return -1;
+	dst = rule;
+	return 0;
+}
+
+int EternalTimestampSchedule::init(ets_schedule_t &schedule, const ets_schedule_rule_t &rule, const eternal_timestamp_t base)
+{
+	ETS_STATS_ENTRY(SCHEDULE_INIT);
+	ets_schedule_t &s = schedule;
+	memset(&s, 0, sizeof(s));
+	s.rule = rule;
+	s.base = base;
+	s.done = 1;
+	if (!s.rule.interval)
+		s.rule.interval = 1;
+
+	if (rule.frequency < ETS_SCHEDULE_YEARLY || rule.frequency > ETS_SCHEDULE_SECONDLY
+		|| rule.by_month >> 12 || rule.by_weekday >> 7 || rule.by_month_day >> 31 || rule.by_month_day_from_end >> 31
+		|| rule.by_hour >> 24 || rule.by_minute >> 60 || rule.by_second >> 60)
+		return -1;
+	if (!ets_has_complete_modern_date(base))
+		return -1;
+
+	// the time of day
+	s.level = static_cast<uint8_t>(rule.frequency >= ETS_SCHEDULE_HOURLY ? rule.frequency - ETS_SCHEDULE_HOURLY : LEVEL_NONE);
+	const uint64_t hour = ets_modern_hour(base);
+	const uint64_t minute = ets_modern_minute(base);
+	const uint64_t second = ets_modern_seconds(base);
+	s.hours = time_set(rule.by_hour, ALL_HOURS, LEVEL_HOUR, s.level, hour, ETMT_FIELDSIZE_HOUR);
+	s.minutes = time_set(rule.by_minute, ALL_MINUTES, LEVEL_MINUTE, s.level, minute, ETMT_FIELDSIZE_MINUTE);
+	s.seconds = time_set(rule.by_second, ALL_MINUTES, LEVEL_SECOND, s.level, second, ETMT_FIELDSIZE_SECONDS);
+	// a minute without its hour, or a second without its minute, means nothing
+	if ((s.hours == UNSPECIFIED && s.minutes != UNSPECIFIED) || (s.minutes == UNSPECIFIED && s.seconds != UNSPECIFIED))
+		return -1;
+	// the fields the frequency steps must be known, to step from them
+	const uint64_t codes[3] = { hour, minute, second };
+	const unsigned int sizes[3] = { ETMT_FIELDSIZE_HOUR, ETMT_FIELDSIZE_MINUTE, ETMT_FIELDSIZE_SECONDS };
+	for (unsigned int i = 0; s.level != LEVEL_NONE && i <= s.level; i++) {
+		if (codes[i] == get_Invalid(sizes[i]))
+			return -1;
+	}
+	s.subsecond_bits = base.t & (~0ULL << ETMT_MILLISECONDS_SHIFT);
+
+	// the date
+	const int64_t y = static_cast<int64_t>(ets_modern_century(base)) * 100 + (static_cast<int64_t>(ets_modern_year(base)) - FIELD_VAL_OFFSET) - MODERN_EPOCH;
+	const unsigned int m = static_cast<unsigned int>(ets_modern_month(base)) + 1 - FIELD_VAL_OFFSET;
+	const unsigned int d = static_cast<unsigned int>(ets_modern_day(base)) + 1 - FIELD_VAL_OFFSET;
+	if (d > month_length(y, m))
+		return -1;
+	s.base_day = ets_days_from_civil(y, m, d);
+	s.base_month = y * 12 + m - 1;
+	s.base_position = s.base_day * 86400;
+	if (hour != get_Invalid(ETMT_FIELDSIZE_HOUR))
+		s.base_position += static_cast<int64_t>(hour - FIELD_VAL_OFFSET) * 3600;
+	if (minute != get_Invalid(ETMT_FIELDSIZE_MINUTE))
+		s.base_position += static_cast<int64_t>(minute - FIELD_VAL_OFFSET) * 60;
+	if (second != get_Invalid(ETMT_FIELDSIZE_SECONDS))
+		s.base_position += static_cast<int64_t>(second - FIELD_VAL_OFFSET);
+
+	const bool by_day = (rule.by_month_day || rule.by_month_day_from_end);
+	s.day_set = (by_day ? rule.by_month_day
+		: rule.frequency <= ETS_SCHEDULE_MONTHLY && !rule.by_weekday ? 1U << (d - 1)
+		: UINT32_MAX);
+	s.weekday_set = static_cast<uint8_t>(rule.by_weekday ? rule.by_weekday
+		: rule.frequency == ETS_SCHEDULE_WEEKLY ? 1 << weekday_of(s.base_day)
+		: 0x7F);
+	s.step_pattern = make_step_pattern(s.rule.interval);
+
+	// the limit: a partial UNTIL covers all of its period
+	s.until_position = INT64_MAX;
+	if (rule.until.t != ets_make_unknown().t) {
+		const eternal_timestamp_t u = rule.until;
+		if (ets_format_mode(u) || ets_modern_century(u) == get_Invalid(ETMT_FIELDSIZE_CENTURY) || ets_modern_year(u) == get_Invalid(ETMT_FIELDSIZE_YEAR))
+			return -1;
+		const int64_t uy = static_cast<int64_t>(ets_modern_century(u)) * 100 + (static_cast<int64_t>(ets_modern_year(u)) - FIELD_VAL_OFFSET) - MODERN_EPOCH;
+		const unsigned int um = (ets_modern_month(u) == get_Invalid(ETMT_FIELDSIZE_MONTH) ? 12 : static_cast<unsigned int>(ets_modern_month(u)) + 1 - FIELD_VAL_OFFSET);
+		const unsigned int ud = (ets_modern_day(u) == get_Invalid(ETMT_FIELDSIZE_DAY) ? month_length(uy, um) : static_cast<unsigned int>(ets_modern_day(u)) + 1 - FIELD_VAL_OFFSET);
+		const int64_t uh = (ets_modern_hour(u) == get_Invalid(ETMT_FIELDSIZE_HOUR) ? 23 : static_cast<int64_t>(ets_modern_hour(u)) - FIELD_VAL_OFFSET);
+		const int64_t umin = (ets_modern_minute(u) == get_Invalid(ETMT_FIELDSIZE_MINUTE) ? 59 : static_cast<int64_t>(ets_modern_minute(u)) - FIELD_VAL_OFFSET);
+		const int64_t us = (ets_modern_seconds(u) == get_Invalid(ETMT_FIELDSIZE_SECONDS) ? 59 : static_cast<int64_t>(ets_modern_seconds(u)) - FIELD_VAL_OFFSET);
+		s.until_position = ets_days_from_civil(uy, um, ud) * 86400 + (uh * 60 + umin) * 60 + us;
+	}
+
+	// the cursor, at the base's month
+	s.month = s.base_month;
+	s.done = 0;
+	if (!load_month(s))
+		return -1;
+	s.days_left = select_days(s);
+	return 0;
+}
+
+bool EternalTimestampSchedule::next(ets_schedule_t &schedule, eternal_timestamp_t &dst)
+{
+	ETS_STATS_ENTRY(SCHEDULE_NEXT);
+	return step(schedule, dst);
+}
+
+size_t EternalTimestampSchedule::generate(eternal_timestamp_t *dst, size_t capacity, ets_schedule_t &schedule)
+{
+	ETS_STATS_ENTRY(SCHEDULE_GENERATE);
+	size_t n = 0;
+	while (n < capacity && step(schedule, dst[n]))
+		n++;
+	return n;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// C interface
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+extern "C" void ets_schedule_init_rule(ets_schedule_rule_t *rule, ets_schedule_frequency_t frequency)
+{
+	EternalTimestampSchedule::init_rule(*rule, frequency);
+}
+
+extern "C" int ets_schedule_parse_rule(ets_schedule_rule_t *dst, const char *text, size_t length)
+{
+	return EternalTimestampSchedule::parse_rule(*dst, text, length);
+}
+
+extern "C" int ets_schedule_init(ets_schedule_t *schedule, const ets_schedule_rule_t *rule, eternal_timestamp_t base)
+{
+	return EternalTimestampSchedule::init(*schedule, *rule, base);
+}
+
+extern "C" BOOL ets_schedule_next(ets_schedule_t *schedule, eternal_timestamp_t *dst)
+{
+	return EternalTimestampSchedule::next(*schedule, *dst);
+}
+
+extern "C" size_t ets_schedule_generate(eternal_timestamp_t *dst, size_t capacity, ets_schedule_t *schedule)
+{
+	return EternalTimestampSchedule::generate(dst, capacity, *schedule);
+}
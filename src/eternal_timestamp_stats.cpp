@@ -0,0 +1,239 @@
+
+#include "eternal_timestamp/eternal_timestamp_stats.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <mutex>
+#include <new>
+
+#include "eternal_timestamp_instrumentation.h"
+
+
+using namespace eternal_timestamp;
+
+namespace
+{
+	const char *const counter_names[ETS_STATS_COUNT] = {
+#define ETS_STATS_NAME(id, name)      name,
+		ETS_STATS_ENTRY_POINTS(ETS_STATS_NAME)
+		ETS_STATS_EVENTS(ETS_STATS_NAME)
+#undef ETS_STATS_NAME
+	};
+
+#if defined(ETS_ENABLE_INSTRUMENTATION)
+
+	std::mutex registry_lock;
+	ets_stats_block *registry = nullptr;   // all blocks ever handed out, guarded by `registry_lock`
+	ets_stats_t baseline;                  // the sums at the last reset(), guarded by `registry_lock`
+
+	// Hands the thread's block back when the thread exits.
+	struct thread_attachment
+	{
+		ets_stats_block *block = nullptr;
+
+		~thread_attachment()
+		{
+			std::lock_guard<std::mutex> guard(registry_lock);
+			if (block)
+				block->in_use = false;
+			ets_stats_current_block = nullptr;
+			detached = true;
+		}
+
+		static thread_local bool detached;
+	};
+
+	thread_local bool thread_attachment::detached = false;
+
+	void sum_all_blocks(ets_stats_t &dst)
+	{
+		memset(&dst, 0, sizeof(dst));
+		for (const ets_stats_block *b = registry; b; b = b->next) {
+			for (int i = 0; i < ETS_STATS_COUNT; i++) {
+				dst.count[i] += b->count[i].load(std::memory_order_relaxed);
+				dst.ticks[i] += b->ticks[i].load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+#endif
+
+	// snprintf() onto the end of a bounded buffer, tracking the length of the full output.
+	struct appender
+	{
+		char *buf;
+		size_t size;
+		size_t length;
+
+		void printf(const char *fmt, ...)
+		{
+			va_list args;
+			va_start(args, fmt);
+			char *dst = (length < size ? buf + length : nullptr);
+			const int n = vsnprintf(dst, (dst ? size - length : 0), fmt, args);
+			va_end(args);
+			if (n > 0)
+				length += static_cast<size_t>(n);
+		}
+	};
+}
+
+#if defined(ETS_ENABLE_INSTRUMENTATION)
+
+thread_local ets_stats_block *ets_stats_current_block = nullptr;
+
+ets_stats_block *ets_stats_attach_thread()
+{
+	if (thread_attachment::detached)
+		return nullptr;
+
+	static thread_local thread_attachment attachment;
+
+	std::lock_guard<std::mutex> guard(registry_lock);
+	ets_stats_block *b = registry;
+	while (b && b->in_use)
+		b = b->next;
+	if (!b) {
+		b = new (std::nothrow) ets_stats_block();
+		if (!b)
+			return nullptr;
+		b->next = registry;
+		registry = b;
+	}
+	b->in_use = true;
+	attachment.block = b;
+	ets_stats_current_block = b;
+	return b;
+}
+
+#endif
+
+
+bool EternalTimestampStats::enabled()
+{
+#if defined(ETS_ENABLE_INSTRUMENTATION)
+	return true;
+#else
+	return false;
+#endif
+}
+
+bool EternalTimestampStats::timers_enabled()
+{
+#if defined(ETS_ENABLE_INSTRUMENTATION) && defined(ETS_ENABLE_INSTRUMENTATION_TIMERS)
+	return true;
+#else
+	return false;
+#endif
+}
+
+const char *EternalTimestampStats::tick_unit()
+{
+#if defined(ETS_STATS_HAVE_TSC)
+	return "cycles";
+#else
+	return "ns";
+#endif
+}
+
+const char *EternalTimestampStats::name(int id)
+{
+	if (id < 0 || id >= ETS_STATS_COUNT)
+		return nullptr;
+	return counter_names[id];
+}
+
+void EternalTimestampStats::snapshot(ets_stats_t &dst)
+{
+#if defined(ETS_ENABLE_INSTRUMENTATION)
+	std::lock_guard<std::mutex> guard(registry_lock);
+	sum_all_blocks(dst);
+	for (int i = 0; i < ETS_STATS_COUNT; i++) {
+		dst.count[i] -= baseline.count[i];
+		dst.ticks[i] -= baseline.ticks[i];
+	}
+#else
+	memset(&dst, 0, sizeof(dst));
+#endif
+}
+
+void EternalTimestampStats::reset()
+{
+#if defined(ETS_ENABLE_INSTRUMENTATION)
+	std::lock_guard<std::mutex> guard(registry_lock);
+	sum_all_blocks(baseline);
+#endif
+}
+
+size_t EternalTimestampStats::dump(char *buf, size_t size, const ets_stats_t &stats)
+{
+	appender out{buf, size, 0};
+	if (size)
+		buf[0] = 0;
+
+	out.printf("# HELP ets_calls_total Calls of the libeternaltimestamp entry points.\n");
+	out.printf("# TYPE ets_calls_total counter\n");
+	for (int i = 0; i < ETS_STATS_ENTRY_POINT_COUNT; i++) {
+		if (stats.count[i])
+			out.printf("ets_calls_total{entry=\"%s\"} %llu\n", counter_names[i], static_cast<unsigned long long>(stats.count[i]));
+	}
+
+	if (timers_enabled()) {
+		out.printf("# HELP ets_ticks_total Time spent in the libeternaltimestamp entry points, in %s.\n", tick_unit());
+		out.printf("# TYPE ets_ticks_total counter\n");
+		for (int i = 0; i < ETS_STATS_ENTRY_POINT_COUNT; i++) {
+			if (stats.ticks[i])
+				out.printf("ets_ticks_total{entry=\"%s\",unit=\"%s\"} %llu\n", counter_names[i], tick_unit(), static_cast<unsigned long long>(stats.ticks[i]));
+		}
+	}
+
+	out.printf("# HELP ets_events_total Notable code paths taken by libeternaltimestamp.\n");
+	out.printf("# TYPE ets_events_total counter\n");
+	for (int i = ETS_STATS_ENTRY_POINT_COUNT; i < ETS_STATS_COUNT; i++) {
+		if (stats.count[i])
+			out.printf("ets_events_total{event=\"%s\"} %llu\n", counter_names[i], static_cast<unsigned long long>(stats.count[i]));
+	}
+
+	return out.length;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// C interface
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+extern "C" int ets_stats_enabled(void)
+{
+	return EternalTimestampStats::enabled();
+}
+
+extern "C" int ets_stats_timers_enabled(void)
+{
+	return EternalTimestampStats::timers_enabled();
+}
+
+extern "C" const char *ets_stats_tick_unit(void)
+{
+	return EternalTimestampStats::tick_unit();
+}
+
+extern "C" const char *ets_stats_name(int id)
+{
+	return EternalTimestampStats::name(id);
+}
+
+extern "C" void ets_stats_snapshot(ets_stats_t *dst)
+{
+	EternalTimestampStats::snapshot(*dst);
+}
+
+extern "C" void ets_stats_reset(void)
+{
+	EternalTimestampStats::reset();
+}
+
+extern "C" size_t ets_stats_dump(char *buf, size_t size, const ets_stats_t *stats)
+{
+	return EternalTimestampStats::dump(buf, size, *stats);
+}
@@ -0,0 +1,358 @@
+
+#include "eternal_timestamp/eternal_timestamp_terms.h"
+
+#include "eternal_timestamp_instrumentation.h"
+#include "eternal_timestamp_internal.h"
+
+
+using namespace eternal_timestamp;
+
+
+namespace
+{
+	constexpr int LEVELS = ETS_TERM_LEVEL_COUNT;
+
+	constexpr unsigned int WIDTH[LEVELS] = {
+		ETMT_FIELDSIZE_CENTURY,
+		ETMT_FIELDSIZE_YEAR,
+		ETMT_FIELDSIZE_MONTH,
+		ETMT_FIELDSIZE_DAY,
+		ETMT_FIELDSIZE_HOUR,
+		ETMT_FIELDSIZE_MINUTE,
+		ETMT_FIELDSIZE_SECONDS,
+		ETMT_FIELDSIZE_MILLISECONDS,
+		ETMT_FIELDSIZE_MICROSECONDS,
+	};
+
+	// The legal values of each field, not counting 'unspecified'; the seconds include the leap second.
+	constexpr unsigned int VALUES[LEVELS] = { 0, 100, 12, 31, 24, 60, 61, 1000, 1000 };
+
+	constexpr unsigned int shift_of(int level)
+	{
+		return (level == LEVELS - 1 ? 0 : WIDTH[level + 1] + shift_of(level + 1));
+	}
+
+	// The position of each field in the sort key.
+	constexpr unsigned int SHIFT[LEVELS] = {
+		shift_of(0), shift_of(1), shift_of(2), shift_of(3), shift_of(4), shift_of(5), shift_of(6), shift_of(7), shift_of(8),
+	};
+
+	// The sort keys range from -2^62 (prehistoric) to 2^62 (modern): biased, they are 63-bit unsigned numbers and
+	// the terms take 64 bits.
+	constexpr uint64_t BIAS = 1ULL << 62;
+
+	inline uint64_t biased_key(const eternal_timestamp_t t)
+	{
+		return static_cast<uint64_t>(EternalTimestamp::calc_sort_key(t)) + BIAS;
+	}
+
+	inline ets_term_t make_term(uint64_t key, int level)
+	{
+		const unsigned int shift = SHIFT[level];
+		return ((key >> shift) << (shift + 1)) | (1ULL << shift);
+	}
+
+	// The levels to use, finest first.
+	int select_levels(int *dst, unsigned int levels)
+	{
+		levels |= 1U << ETS_TERM_MICROSECONDS;
+		int n = 0;
+		for (int level = LEVELS - 1; level >= 0; level--) {
+			if (levels & (1U << level))
+				dst[n++] = level;
+		}
+		return n;
+	}
+
+	// The range planner works on the keys as numbers whose digits are the fields. For modern timestamps each
+	// digit only runs through the legal values of its field (plus 'unspecified'), so that e.g. the 60 minutes of
+	// an hour make up a whole hour term; other ranges use the key's plain binary value, as prehistoric keys have
+	// their own layout.
+	struct number_system
+	{
+		bool digits;                          // mixed-radix field digits, or the plain key
+		uint64_t radix[LEVELS];
+		uint64_t weight[LEVELS];              // the value of a 1 in each digit
+
+		number_system()
+		{
+			digits = true;
+			uint64_t w = 1;
+			for (int level = LEVELS - 1; level >= 0; level--) {
+				// 'unspecified' is the zero(0) code, unless this build marks it with the largest code.
+				if (level == ETS_TERM_CENTURY || get_Invalid(WIDTH[level]) != 0)
+					radix[level] = 1ULL << WIDTH[level];
+				else
+					radix[level] = FIELD_VAL_OFFSET + VALUES[level];
+				weight[level] = w;
+				w *= radix[level];
+			}
+		}
+
+		// The size of a `level` term, in units of this number system.
+		uint64_t block(int level) const
+		{
+			return (digits ? weight[level] : 1ULL << SHIFT[level]);
+		}
+
+		// Key to number: false when a field is out of range.
+		bool from_key(uint64_t &dst, uint64_t key) const
+		{
+			if (!digits) {
+				dst = key;
+				return true;
+			}
+			uint64_t v = 0;
+			for (int level = 0; level < LEVELS; level++) {
+				const uint64_t code = (key >> SHIFT[level]) & ((1ULL << WIDTH[level]) - 1);
+				if (code >= radix[level])
+					return false;
+				v += code * weight[level];
+			}
+			dst = v;
+			return true;
+		}
+
+		uint64_t to_key(uint64_t v) const
+		{
+			if (!digits)
+				return v;
+			uint64_t key = BIAS;
+			for (int level = 0; level < LEVELS; level++) {
+				key |= (v / weight[level]) << SHIFT[level];
+				v %= weight[level];
+			}
+			return key;
+		}
+	};
+
+	const number_system modern_digits;
+
+	struct term_writer
+	{
+		ets_term_t *dst;
+		size_t capacity;
+		size_t count;
+		const number_system &numbers;
+
+		// The `level` terms for [from, to), both multiples of the `level` block size.
+		void run(int level, uint64_t from, uint64_t to)
+		{
+			const uint64_t block = numbers.block(level);
+			uint64_t n = (to - from) / block;
+			for (uint64_t v = from; n && count < capacity; n--, v += block)
+				dst[count++] = make_term(numbers.to_key(v), level);
+			count += static_cast<size_t>(n);
+		}
+	};
+
+	size_t plan(ets_term_t *dst, size_t capacity, const eternal_timestamp_t lo, const eternal_timestamp_t hi, unsigned int levels)
+	{
+		const uint64_t lo_key = biased_key(EternalTimestampTerms::calc_range_bound(lo));
+		const uint64_t hi_key = biased_key(EternalTimestampTerms::calc_range_bound(hi));
+		if (lo_key >= hi_key)
+			return 0;
+
+		number_system numbers = modern_digits;
+		numbers.digits = true;
+		uint64_t a, b;
+		if (lo_key < BIAS || !numbers.from_key(a, lo_key) || !numbers.from_key(b, hi_key)) {
+			numbers.digits = false;
+			a = lo_key;
+			b = hi_key;
+		}
+
+		int order[LEVELS];
+		const int n = select_levels(order, levels);
+		term_writer out{ dst, capacity, 0, numbers };
+
+		// the ends of the range at each level, working inwards to the largest aligned blocks.
+		for (int i = 0; i + 1 < n; i++) {
+			const uint64_t step = numbers.block(order[i + 1]);
+			const uint64_t a_up = (a + step - 1) / step * step;
+			const uint64_t b_down = b / step * step;
+			if (a_up >= b_down) {
+				out.run(order[i], a, b);
+				return out.count;
+			}
+			out.run(order[i], a, a_up);
+			out.run(order[i], b_down, b);
+			a = a_up;
+			b = b_down;
+		}
+		out.run(order[n - 1], a, b);
+		return out.count;
+	}
+}
+
+
+size_t EternalTimestampTerms::count_levels(unsigned int levels)
+{
+	levels = (levels | (1U << ETS_TERM_MICROSECONDS)) & ETS_TERM_LEVELS_ALL;
+	size_t n = 0;
+	for (; levels; levels &= levels - 1)
+		n++;
+	return n;
+}
+
+size_t EternalTimestampTerms::calc_terms(ets_term_t *dst, const eternal_timestamp_t t, unsigned int levels)
+{
+	ETS_STATS_ENTRY(TERMS_CALC_TERMS);
+	levels |= 1U << ETS_TERM_MICROSECONDS;
+	const uint64_t key = biased_key(t);
+	size_t n = 0;
+	for (int level = 0; level < LEVELS; level++) {
+		if (levels & (1U << level))
+			dst[n++] = make_term(key, level);
+	}
+	return n;
+}
+
+void EternalTimestampTerms::calc_terms_batch(ets_term_t *dst, const eternal_timestamp_t *src, size_t count, unsigned int levels, unsigned int parallelism)
+{
+	ETS_STATS_ENTRY(TERMS_CALC_TERMS_BATCH);
+	const size_t per_value = count_levels(levels);
+	EternalTimestampParallel::parallel_for(count, ETS_PARALLEL_GRAIN, parallelism, [=](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			calc_terms(dst + i * per_value, src[i], levels);
+		}
+	});
+}
+
+eternal_timestamp_t EternalTimestampTerms::calc_range_bound(const eternal_timestamp_t t)
+{
+	// only where 'unspecified' is the zero(0) code, which sorts first; codes 0 and 1 are 'unspecified' and the
+	// field's first value.
+	eternal_timestamp_t rv = t;
+	if (!EternalTimestamp::is_modern_format(t) || FIELD_VAL_OFFSET != 1)
+		return rv;
+	if (ets_modern_microseconds(rv) > 1)
+		return rv;
+	rv = ets_modern_set_microseconds(rv, 0);
+	if (ets_modern_milliseconds(rv) > 1)
+		return rv;
+	rv = ets_modern_set_milliseconds(rv, 0);
+	if (ets_modern_seconds(rv) > 1)
+		return rv;
+	rv = ets_modern_set_seconds(rv, 0);
+	if (ets_modern_minute(rv) > 1)
+		return rv;
+	rv = ets_modern_set_minute(rv, 0);
+	if (ets_modern_hour(rv) > 1)
+		return rv;
+	rv = ets_modern_set_hour(rv, 0);
+	if (ets_modern_day(rv) > 1)
+		return rv;
+	rv = ets_modern_set_day(rv, 0);
+	if (ets_modern_month(rv) > 1)
+		return rv;
+	rv = ets_modern_set_month(rv, 0);
+	if (ets_modern_year(rv) > 1)
+		return rv;
+	rv = ets_modern_set_year(rv, 0);
+	return rv;
+}
+
+size_t EternalTimestampTerms::plan_range(ets_term_t *dst, size_t capacity, const eternal_timestamp_t lo, const eternal_timestamp_t hi, unsigned int levels)
+{
+	ETS_STATS_ENTRY(TERMS_PLAN_RANGE);
+	return plan(dst, capacity, lo, hi, levels);
+}
+
+size_t EternalTimestampTerms::plan_ranges(ets_term_t *dst, size_t capacity, size_t *offsets, const eternal_timestamp_t *lo, const eternal_timestamp_t *hi, size_t count, unsigned int levels, unsigned int parallelism)
+{
+	ETS_STATS_ENTRY(TERMS_PLAN_RANGES);
+	// count, then write each range's terms at its offset.
+	offsets[0] = 0;
+	EternalTimestampParallel::parallel_for(count, ETS_PARALLEL_GRAIN / 16, parallelism, [=](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			offsets[i + 1] = plan(nullptr, 0, lo[i], hi[i], levels);
+		}
+	});
+	for (size_t i = 0; i < count; i++)
+		offsets[i + 1] += offsets[i];
+	const size_t total = offsets[count];
+	if (total > capacity)
+		return total;
+
+	EternalTimestampParallel::parallel_for(count, ETS_PARALLEL_GRAIN / 16, parallelism, [=](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			plan(dst + offsets[i], offsets[i + 1] - offsets[i], lo[i], hi[i], levels);
+		}
+	});
+	return total;
+}
+
+int EternalTimestampTerms::term_level(ets_term_t term)
+{
+	if (!term)
+		return -1;
+	unsigned int shift = 0;
+	while (!(term & 1)) {
+		term >>= 1;
+		shift++;
+	}
+	for (int level = 0; level < LEVELS; level++) {
+		if (SHIFT[level] == shift)
+			return level;
+	}
+	return -1;
+}
+
+size_t EternalTimestampTerms::format_term(char *dst, size_t capacity, ets_term_t term)
+{
+	if (capacity < ETS_TERM_TEXT_LENGTH + 1)
+		return 0;
+	static const char hex[] = "0123456789abcdef";
+	for (int i = ETS_TERM_TEXT_LENGTH - 1; i >= 0; i--) {
+		dst[i] = hex[term & 0x0F];
+		term >>= 4;
+	}
+	dst[ETS_TERM_TEXT_LENGTH] = 0;
+	return ETS_TERM_TEXT_LENGTH;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// C interface
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+extern "C" size_t ets_terms_count_levels(unsigned int levels)
+{
+	return EternalTimestampTerms::count_levels(levels);
+}
+
+extern "C" size_t ets_terms_calc_terms(ets_term_t *dst, const eternal_timestamp_t t, unsigned int levels)
+{
+	return EternalTimestampTerms::calc_terms(dst, t, levels);
+}
+
+extern "C" void ets_terms_calc_terms_batch(ets_term_t *dst, const eternal_timestamp_t *src, size_t count, unsigned int levels)
+{
+	EternalTimestampTerms::calc_terms_batch(dst, src, count, levels);
+}
+
+extern "C" eternal_timestamp_t ets_terms_calc_range_bound(const eternal_timestamp_t t)
+{
+	return EternalTimestampTerms::calc_range_bound(t);
+}
+
+extern "C" size_t ets_terms_plan_range(ets_term_t *dst, size_t capacity, const eternal_timestamp_t lo, const eternal_timestamp_t hi, unsigned int levels)
+{
+	return EternalTimestampTerms::plan_range(dst, capacity, lo, hi, levels);
+}
+
+extern "C" size_t ets_terms_plan_ranges(ets_term_t *dst, size_t capacity, size_t *offsets, const eternal_timestamp_t *lo, const eternal_timestamp_t *hi, size_t count, unsigned int levels)
+{
+	return EternalTimestampTerms::plan_ranges(dst, capacity, offsets, lo, hi, count, levels);
+}
+
+extern "C" int ets_terms_term_level(ets_term_t term)
+{
+	return EternalTimestampTerms::term_level(term);
+}
+
+extern "C" size_t ets_terms_format_term(char *dst, size_t capacity, ets_term_t term)
+{
+	return EternalTimestampTerms::format_term(dst, capacity, term);
+}
@@ -0,0 +1,853 @@
+
+#include "eternal_timestamp/eternal_timestamp_timer.h"
+
+#include <errno.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#include "eternal_timestamp_instrumentation.h"
+#include "eternal_timestamp_internal.h"
+
+
+using namespace eternal_timestamp;
+
+
+namespace
+{
+	constexpr uint32_t NIL = 0xFFFFFFFFU;
+
+	// The wheel levels, from the millisecond up to the day of the month. All slots live in one array, so that one
+	// bitmap tracks which of them are occupied.
+	constexpr int LEVELS = 5;
+	constexpr unsigned int LEVEL_SIZE[LEVELS] = { 1000, 60, 60, 24, 31 };
+	constexpr unsigned int LEVEL_BASE[LEVELS] = { 0, 1000, 1060, 1120, 1144 };
+	constexpr unsigned int SLOTS = 1175;
+	constexpr unsigned int BITMAP_WORDS = (SLOTS + 63) / 64;
+
+	// The timers live in segments which never move, as `post()` may add a segment while the owner is at work.
+	constexpr unsigned int SEGMENT_BITS = 12;
+	constexpr uint32_t SEGMENT_SIZE = 1U << SEGMENT_BITS;
+	constexpr uint32_t MAX_SEGMENTS = 1U << 16;
+
+	enum node_location : uint8_t
+	{
+		IN_FREE_LIST = 0,
+		IN_INTAKE,                        // posted, not yet taken in by the owner
+		IN_WHEEL,
+		IN_OVERFLOW,
+		IN_DUE,
+	};
+
+	// 32 bytes: two to a cache line.
+	struct node
+	{
+		eternal_timestamp_t deadline;
+		uint64_t payload;
+		uint32_t prev;                    // the heap position while in the overflow heap
+		uint32_t next;
+		uint32_t generation;              // bumped when the node is freed, which invalidates its handle
+		uint16_t slot;
+		uint8_t location;
+		uint8_t unused;
+	};
+
+	// A deadline or the current time: the month as a key which orders the months, and the field values
+	// (0-based) used as slot indexes in each level.
+	struct wheel_time
+	{
+		uint32_t month;
+		unsigned int field[LEVELS];
+	};
+
+	struct intake_entry
+	{
+		uint32_t index;
+		uint32_t generation;
+		bool cancel;
+	};
+
+	inline unsigned int field_value(unsigned int raw, unsigned int invalid)
+	{
+		return (raw == invalid ? 0 : raw - FIELD_VAL_OFFSET);
+	}
+
+	bool decode(wheel_time &dst, const eternal_timestamp_t t)
+	{
+		if (!ets_has_complete_modern_date(t))
+			return false;
+		dst.month = static_cast<uint32_t>((ets_modern_century(t) << 11) | (ets_modern_year(t) << 4) | ets_modern_month(t));
+		dst.field[0] = field_value(static_cast<unsigned int>(ets_modern_milliseconds(t)), get_Invalid(ETMT_FIELDSIZE_MILLISECONDS));
+		dst.field[1] = field_value(static_cast<unsigned int>(ets_modern_seconds(t)), get_Invalid(ETMT_FIELDSIZE_SECONDS));
+		dst.field[2] = field_value(static_cast<unsigned int>(ets_modern_minute(t)), get_Invalid(ETMT_FIELDSIZE_MINUTE));
+		dst.field[3] = field_value(static_cast<unsigned int>(ets_modern_hour(t)), get_Invalid(ETMT_FIELDSIZE_HOUR));
+		dst.field[4] = static_cast<unsigned int>(ets_modern_day(t)) - FIELD_VAL_OFFSET;
+		for (int k = 0; k < LEVELS; k++) {
+			if (dst.field[k] >= LEVEL_SIZE[k])
+				return false;
+		}
+		return true;
+	}
+
+	eternal_timestamp_t encode(const wheel_time &src)
+	{
+		eternal_timestamp_t t{0};
+		t = ets_modern_set_century(t, src.month >> 11);
+		t = ets_modern_set_year(t, (src.month >> 4) & 0x7F);
+		t = ets_modern_set_month(t, src.month & 0x0F);
+		t = ets_modern_set_day(t, src.field[4] + FIELD_VAL_OFFSET);
+		t = ets_modern_set_hour(t, src.field[3] + FIELD_VAL_OFFSET);
+		t = ets_modern_set_minute(t, src.field[2] + FIELD_VAL_OFFSET);
+		t = ets_modern_set_seconds(t, src.field[1] + FIELD_VAL_OFFSET);
+		t = ets_modern_set_milliseconds(t, src.field[0] + FIELD_VAL_OFFSET);
+		t = ets_modern_set_microseconds(t, FIELD_VAL_OFFSET);
+		return t;
+	}
+
+	inline uint64_t key_of(const wheel_time &t)
+	{
+		uint64_t k = t.month;
+		for (int j = LEVELS - 1; j >= 0; j--)
+			k = k * LEVEL_SIZE[j] + t.field[j];
+		return k;
+	}
+
+	inline unsigned int lowest_bit(uint64_t mask)
+	{
+#if defined(__GNUC__)
+		return static_cast<unsigned int>(__builtin_ctzll(mask));
+#else
+		unsigned int n = 0;
+		while (!(mask & 1)) {
+			mask >>= 1;
+			n++;
+		}
+		return n;
+#endif
+	}
+
+	inline ets_timer_handle_t make_handle(uint32_t index, uint32_t generation)
+	{
+		return (static_cast<uint64_t>(generation) << 32) | (static_cast<uint64_t>(index) + 1);
+	}
+}
+
+
+struct ets_timer_wheel
+{
+	// shared with the posting threads
+	std::mutex lock;                          // guards the fields below, up to `wheel_time now`
+	std::unique_ptr<node *[]> segments;       // MAX_SEGMENTS entries
+	std::atomic<uint32_t> allocated{ 0 };     // nodes ever handed out: the free list holds the returned ones
+	uint32_t free_list = NIL;
+	std::vector<intake_entry> intake;
+	std::atomic<bool> posted{ false };        // whether `intake` holds anything: the owner's fast check
+
+	// the owner's
+	wheel_time now;
+	uint32_t heads[SLOTS];
+	uint64_t occupied[BITMAP_WORDS];
+	std::vector<uint32_t> overflow;           // min-heap of the timers in later months
+	uint32_t due_head = NIL;
+	uint32_t due_tail = NIL;
+	size_t count = 0;
+	std::vector<intake_entry> taken;
+	uint32_t spare = NIL;                     // the nodes the owner freed: handed back to `free_list` when others post
+	uint32_t spare_tail = NIL;
+
+	node &at(uint32_t index) const
+	{
+		return segments[index >> SEGMENT_BITS][index & (SEGMENT_SIZE - 1)];
+	}
+
+	~ets_timer_wheel()
+	{
+		const uint32_t n = (allocated.load(std::memory_order_relaxed) + SEGMENT_SIZE - 1) >> SEGMENT_BITS;
+		for (uint32_t s = 0; s < n; s++)
+			delete[] segments[s];
+	}
+};
+
+
+namespace
+{
+	// Node allocation from the shared free list: callers hold the lock.
+	bool alloc_node(ets_timer_wheel *w, uint32_t &index)
+	{
+		if (w->free_list != NIL) {
+			index = w->free_list;
+			w->free_list = w->at(index).next;
+			return true;
+		}
+		const uint32_t n = w->allocated.load(std::memory_order_relaxed);
+		if ((n & (SEGMENT_SIZE - 1)) == 0) {
+			if ((n >> SEGMENT_BITS) >= MAX_SEGMENTS)
+				return false;
+			node *segment = new (std::nothrow) node[SEGMENT_SIZE];
+			if (!segment)
+				return false;
+			for (uint32_t i = 0; i < SEGMENT_SIZE; i++)
+				segment[i].generation = 1;
+			w->segments[n >> SEGMENT_BITS] = segment;
+		}
+		index = n;
+		w->allocated.store(n + 1, std::memory_order_release);
+		return true;
+	}
+
+	// The owner takes the nodes it freed itself first, without the lock.
+	bool alloc_owned(ets_timer_wheel *w, uint32_t &index)
+	{
+		if (w->spare != NIL) {
+			index = w->spare;
+			w->spare = w->at(index).next;
+			if (w->spare == NIL)
+				w->spare_tail = NIL;
+			return true;
+		}
+		std::lock_guard<std::mutex> guard(w->lock);
+		return alloc_node(w, index);
+	}
+
+	// Owner only. Posting threads never look at a node they did not allocate, so this needs no lock.
+	void free_node(ets_timer_wheel *w, uint32_t index)
+	{
+		node &n = w->at(index);
+		n.generation = (n.generation + 1 ? n.generation + 1 : 1);
+		n.location = IN_FREE_LIST;
+		n.next = w->spare;
+		w->spare = index;
+		if (w->spare_tail == NIL)
+			w->spare_tail = index;
+	}
+
+	// The node a handle refers to, if the handle is current.
+	node *lookup(ets_timer_wheel *w, ets_timer_handle_t handle, uint32_t &index)
+	{
+		const uint64_t i = (handle & 0xFFFFFFFFU);
+		if (i == 0 || i > w->allocated.load(std::memory_order_acquire))
+			return nullptr;
+		index = static_cast<uint32_t>(i - 1);
+		node &n = w->at(index);
+		if (n.generation != static_cast<uint32_t>(handle >> 32) || n.location == IN_FREE_LIST)
+			return nullptr;
+		return &n;
+	}
+
+	// The overflow heap, ordered by deadline.
+
+	uint64_t deadline_key(const ets_timer_wheel *w, uint32_t index)
+	{
+		wheel_time d;
+		decode(d, w->at(index).deadline);
+		return key_of(d);
+	}
+
+	void heap_set(ets_timer_wheel *w, size_t pos, uint32_t index)
+	{
+		w->overflow[pos] = index;
+		w->at(index).prev = static_cast<uint32_t>(pos);
+	}
+
+	void heap_sift_up(ets_timer_wheel *w, size_t pos)
+	{
+		const uint32_t index = w->overflow[pos];
+		const uint64_t key = deadline_key(w, index);
+		while (pos > 0) {
+			const size_t parent = (pos - 1) / 2;
+			if (deadline_key(w, w->overflow[parent]) <= key)
+				break;
+			heap_set(w, pos, w->overflow[parent]);
+			pos = parent;
+		}
+		heap_set(w, pos, index);
+	}
+
+	void heap_sift_down(ets_timer_wheel *w, size_t pos)
+	{
+		const size_t n = w->overflow.size();
+		const uint32_t index = w->overflow[pos];
+		const uint64_t key = deadline_key(w, index);
+		for (;;) {
+			size_t child = 2 * pos + 1;
+			if (child >= n)
+				break;
+			uint64_t child_key = deadline_key(w, w->overflow[child]);
+			if (child + 1 < n) {
+				const uint64_t right_key = deadline_key(w, w->overflow[child + 1]);
+				if (right_key < child_key) {
+					child++;
+					child_key = right_key;
+				}
+			}
+			if (key <= child_key)
+				break;
+			heap_set(w, pos, w->overflow[child]);
+			pos = child;
+		}
+		heap_set(w, pos, index);
+	}
+
+	void heap_remove(ets_timer_wheel *w, size_t pos)
+	{
+		const uint32_t last = w->overflow.back();
+		w->overflow.pop_back();
+		if (pos == w->overflow.size())
+			return;
+		heap_set(w, pos, last);
+		heap_sift_up(w, pos);
+		heap_sift_down(w, w->at(last).prev);
+	}
+
+	// The slot lists and the due list.
+
+	void set_occupied(ets_timer_wheel *w, unsigned int slot, bool occupied)
+	{
+		const uint64_t bit = 1ULL << (slot % 64);
+		if (occupied)
+			w->occupied[slot / 64] |= bit;
+		else
+			w->occupied[slot / 64] &= ~bit;
+	}
+
+	// The first occupied slot of `level` in [from, to], as an index into the level; -1 when there is none.
+	int next_slot(const ets_timer_wheel *w, int level, unsigned int from, unsigned int to)
+	{
+		if (from > to)
+			return -1;
+		unsigned int first = LEVEL_BASE[level] + from;
+		const unsigned int last = LEVEL_BASE[level] + to;
+		while (first <= last) {
+			const uint64_t bits = w->occupied[first / 64] >> (first % 64);
+			if (bits) {
+				const unsigned int slot = first + lowest_bit(bits);
+				return (slot <= last ? static_cast<int>(slot - LEVEL_BASE[level]) : -1);
+			}
+			first = (first / 64 + 1) * 64;
+		}
+		return -1;
+	}
+
+	void append_due(ets_timer_wheel *w, uint32_t index)
+	{
+		node &n = w->at(index);
+		n.location = IN_DUE;
+		n.prev = w->due_tail;
+		n.next = NIL;
+		if (w->due_tail != NIL)
+			w->at(w->due_tail).next = index;
+		else
+			w->due_head = index;
+		w->due_tail = index;
+	}
+
+	// Put a timer where it belongs relative to the current time.
+	void place(ets_timer_wheel *w, uint32_t index)
+	{
+		node &n = w->at(index);
+		wheel_time d;
+		decode(d, n.deadline);
+
+		if (key_of(d) <= key_of(w->now)) {
+			append_due(w, index);
+			return;
+		}
+		if (d.month != w->now.month) {
+			n.location = IN_OVERFLOW;
+			w->overflow.push_back(index);
+			heap_sift_up(w, w->overflow.size() - 1);
+			return;
+		}
+		int k = LEVELS - 1;
+		while (d.field[k] == w->now.field[k])
+			k--;
+		const unsigned int slot = LEVEL_BASE[k] + d.field[k];
+		n.location = IN_WHEEL;
+		n.slot = static_cast<uint16_t>(slot);
+		n.prev = NIL;
+		n.next = w->heads[slot];
+		if (n.next != NIL)
+			w->at(n.next).prev = index;
+		else
+			set_occupied(w, slot, true);
+		w->heads[slot] = index;
+	}
+
+	void unlink(ets_timer_wheel *w, uint32_t index)
+	{
+		node &n = w->at(index);
+		switch (n.location) {
+		case IN_WHEEL:
+			if (n.prev != NIL)
+				w->at(n.prev).next = n.next;
+			else
+				w->heads[n.slot] = n.next;
+			if (n.next != NIL)
+				w->at(n.next).prev = n.prev;
+			if (w->heads[n.slot] == NIL)
+				set_occupied(w, n.slot, false);
+			break;
+
+		case IN_DUE:
+			if (n.prev != NIL)
+				w->at(n.prev).next = n.next;
+			else
+				w->due_head = n.next;
+			if (n.next != NIL)
+				w->at(n.next).prev = n.prev;
+			else
+				w->due_tail = n.prev;
+			break;
+
+		case IN_OVERFLOW:
+			heap_remove(w, n.prev);
+			break;
+		}
+	}
+
+	// The time has reached slot `slot` of `level`: move its timers down.
+	void cascade(ets_timer_wheel *w, int level, unsigned int slot)
+	{
+		const unsigned int s = LEVEL_BASE[level] + slot;
+		uint32_t index = w->heads[s];
+		w->heads[s] = NIL;
+		set_occupied(w, s, false);
+		while (index != NIL) {
+			const uint32_t next = w->at(index).next;
+			ETS_STATS_EVENT(TIMER_WHEEL_CASCADE);
+			place(w, index);
+			index = next;
+		}
+	}
+
+	// Take in the requests posted by other threads.
+	//
+	// The requests are taken in the order they were posted, so a timer is always in the wheel by the time its
+	// cancellation comes along; a cancellation of a timer which has expired meanwhile finds the handle stale.
+	void take_intake(ets_timer_wheel *w)
+	{
+		if (!w->posted.load(std::memory_order_acquire))
+			return;
+		{
+			std::lock_guard<std::mutex> guard(w->lock);
+			w->taken.swap(w->intake);
+			w->posted.store(false, std::memory_order_relaxed);
+			// the others are busy posting: let them have our spare nodes
+			if (w->spare != NIL) {
+				w->at(w->spare_tail).next = w->free_list;
+				w->free_list = w->spare;
+				w->spare = NIL;
+				w->spare_tail = NIL;
+			}
+		}
+		for (const intake_entry &e : w->taken) {
+			const node &n = w->at(e.index);
+			if (n.generation != e.generation || n.location == IN_FREE_LIST)
+				continue;
+			if (!e.cancel) {
+				place(w, e.index);
+				w->count++;
+			}
+			else {
+				unlink(w, e.index);
+				w->count--;
+				free_node(w, e.index);
+			}
+		}
+		w->taken.clear();
+	}
+
+	// Queue a request for the owner: callers hold the lock.
+	bool post_request(ets_timer_wheel *w, uint32_t index, uint32_t generation, bool cancel)
+	{
+		try {
+			w->intake.push_back(intake_entry{ index, generation, cancel });
+		}
+		catch (const std::bad_alloc &) {
+			return false;
+		}
+		w->posted.store(true, std::memory_order_release);
+		return true;
+	}
+
+	bool same_unit(const wheel_time &a, const wheel_time &b, int level)
+	{
+		if (a.month != b.month)
+			return false;
+		for (int j = LEVELS - 1; j > level; j--) {
+			if (a.field[j] != b.field[j])
+				return false;
+		}
+		return true;
+	}
+}
+
+
+int EternalTimestampTimerWheel::create(ets_timer_wheel_t *&dst, const eternal_timestamp_t now)
+{
+	ETS_STATS_ENTRY(TIMER_WHEEL_CREATE);
+	dst = nullptr;
+	wheel_time t;
+	if (!decode(t, now))
+		return EINVAL;
+	ets_timer_wheel_t *w = new (std::nothrow) ets_timer_wheel_t();
+	if (!w)
+		return ENOMEM;
+	w->segments.reset(new (std::nothrow) node *[MAX_SEGMENTS]());
+	if (!w->segments) {
+		delete w;
+		return ENOMEM;
+	}
+	w->now = t;
+	for (unsigned int i = 0; i < SLOTS; i++)
+		w->heads[i] = NIL;
+	for (unsigned int i = 0; i < BITMAP_WORDS; i++)
+		w->occupied[i] = 0;
+	dst = w;
+	return 0;
+}
+
+void EternalTimestampTimerWheel::destroy(ets_timer_wheel_t *wheel)
+{
+	delete wheel;
+}
+
+int EternalTimestampTimerWheel::insert(ets_timer_wheel_t *wheel, ets_timer_handle_t *handle, const eternal_timestamp_t deadline, uint64_t payload)
+{
+	ETS_STATS_ENTRY(TIMER_WHEEL_INSERT);
+	if (handle)
+		*handle = 0;
+	wheel_time d;
+	if (!decode(d, deadline))
+		return EINVAL;
+
+	uint32_t index;
+	if (!alloc_owned(wheel, index))
+		return ENOMEM;
+	node &n = wheel->at(index);
+	n.deadline = deadline;
+	n.payload = payload;
+	place(wheel, index);
+	wheel->count++;
+	if (handle)
+		*handle = make_handle(index, n.generation);
+	return 0;
+}
+
+int EternalTimestampTimerWheel::insert_batch(ets_timer_wheel_t *wheel, ets_timer_handle_t *handles, const eternal_timestamp_t *deadlines, const uint64_t *payloads, size_t count)
+{
+	ETS_STATS_ENTRY(TIMER_WHEEL_INSERT_BATCH);
+	// the nodes for a chunk of timers at a time, so as to take the lock (if at all) once per chunk
+	const size_t CHUNK = 256;
+	uint32_t indexes[CHUNK];
+	for (size_t i = 0; i < count; ) {
+		size_t n = (count - i < CHUNK ? count - i : CHUNK);
+		int rv = 0;
+		wheel_time d;
+		for (size_t j = 0; j < n; j++) {
+			if (!decode(d, deadlines[i + j])) {
+				n = j;
+				rv = EINVAL;
+				break;
+			}
+		}
+		size_t j = 0;
+		for (; j < n && wheel->spare != NIL; j++)
+			alloc_owned(wheel, indexes[j]);
+		if (j < n) {
+			std::lock_guard<std::mutex> guard(wheel->lock);
+			for (; j < n; j++) {
+				if (!alloc_node(wheel, indexes[j])) {
+					n = j;
+					rv = ENOMEM;
+					break;
+				}
+			}
+		}
+		for (size_t j = 0; j < n; j++, i++) {
+			node &e = wheel->at(indexes[j]);
+			e.deadline = deadlines[i];
+			e.payload = (payloads ? payloads[i] : i);
+			place(wheel, indexes[j]);
+			if (handles)
+				handles[i] = make_handle(indexes[j], e.generation);
+		}
+		wheel->count += n;
+		if (rv) {
+			if (handles) {
+				for (; i < count; i++)
+					handles[i] = 0;
+			}
+			return rv;
+		}
+	}
+	return 0;
+}
+
+bool EternalTimestampTimerWheel::cancel(ets_timer_wheel_t *wheel, ets_timer_handle_t handle)
+{
+	ETS_STATS_ENTRY(TIMER_WHEEL_CANCEL);
+	take_intake(wheel);
+	uint32_t index;
+	node *n = lookup(wheel, handle, index);
+	if (!n)
+		return false;
+	if (n->location == IN_INTAKE) {
+		// posted after we took in the intake just now
+		std::lock_guard<std::mutex> guard(wheel->lock);
+		return post_request(wheel, index, n->generation, true);
+	}
+	unlink(wheel, index);
+	wheel->count--;
+	free_node(wheel, index);
+	return true;
+}
+
+int EternalTimestampTimerWheel::advance(ets_timer_wheel_t *wheel, const eternal_timestamp_t now)
+{
+	ETS_STATS_ENTRY(TIMER_WHEEL_ADVANCE);
+	take_intake(wheel);
+	wheel_time target;
+	if (!decode(target, now))
+		return EINVAL;
+	if (key_of(target) <= key_of(wheel->now))
+		return 0;
+
+	wheel_time &t = wheel->now;
+	for (;;) {
+		// the nearest occupied slot on the way to `target`, from the milliseconds up: when a level has none
+		// before the end of its round, the next level up decides where the lower levels' next round starts.
+		int k;
+		for (k = 0; k < LEVELS; k++) {
+			const bool within = same_unit(t, target, k);
+			const int s = next_slot(wheel, k, t.field[k] + 1, (within ? target.field[k] : LEVEL_SIZE[k] - 1));
+			if (s >= 0) {
+				t.field[k] = static_cast<unsigned int>(s);
+				for (int j = 0; j < k; j++)
+					t.field[j] = 0;
+				cascade(wheel, k, static_cast<unsigned int>(s));
+				break;
+			}
+			if (within) {
+				t = target;
+				return 0;
+			}
+		}
+		if (k < LEVELS)
+			continue;
+
+		// nothing left this month: on to the month of the first overflow timer, unless that is past `target`.
+		if (wheel->overflow.empty()) {
+			t = target;
+			return 0;
+		}
+		wheel_time first;
+		decode(first, wheel->at(wheel->overflow[0]).deadline);
+		if (first.month > target.month) {
+			t = target;
+			return 0;
+		}
+		t.month = first.month;
+		for (int j = 0; j < LEVELS; j++)
+			t.field[j] = 0;
+		while (!wheel->overflow.empty()) {
+			const uint32_t index = wheel->overflow[0];
+			decode(first, wheel->at(index).deadline);
+			if (first.month != t.month)
+				break;
+			heap_remove(wheel, 0);
+			ETS_STATS_EVENT(TIMER_WHEEL_CASCADE);
+			place(wheel, index);
+		}
+	}
+}
+
+size_t EternalTimestampTimerWheel::drain(ets_timer_wheel_t *wheel, ets_timer_t *dst, size_t capacity)
+{
+	ETS_STATS_ENTRY(TIMER_WHEEL_DRAIN);
+	size_t n = 0;
+	uint32_t index = wheel->due_head;
+	while (n < capacity && index != NIL) {
+		const node &e = wheel->at(index);
+		dst[n].handle = make_handle(index, e.generation);
+		dst[n].deadline = e.deadline;
+		dst[n].payload = e.payload;
+		n++;
+		index = e.next;
+	}
+	if (!n)
+		return 0;
+
+	uint32_t i = wheel->due_head;
+	while (i != index) {
+		const uint32_t next = wheel->at(i).next;
+		free_node(wheel, i);
+		i = next;
+	}
+	wheel->due_head = index;
+	if (index != NIL)
+		wheel->at(index).prev = NIL;
+	else
+		wheel->due_tail = NIL;
+	wheel->count -= n;
+	return n;
+}
+
+size_t EternalTimestampTimerWheel::poll(ets_timer_wheel_t *wheel, const eternal_timestamp_t now, ets_timer_t *dst, size_t capacity)
+{
+	advance(wheel, now);
+	return drain(wheel, dst, capacity);
+}
+
+bool EternalTimestampTimerWheel::next_expiry(const ets_timer_wheel_t *wheel, eternal_timestamp_t &dst)
+{
+	if (wheel->due_head != NIL) {
+		dst = wheel->at(wheel->due_head).deadline;
+		return true;
+	}
+	// any timer in a lower level expires before those in the levels above.
+	for (int k = 0; k < LEVELS; k++) {
+		const int s = next_slot(wheel, k, wheel->now.field[k] + 1, LEVEL_SIZE[k] - 1);
+		if (s < 0)
+			continue;
+		uint32_t index = wheel->heads[LEVEL_BASE[k] + s];
+		uint32_t best = index;
+		uint64_t best_key = deadline_key(wheel, index);
+		for (index = wheel->at(index).next; index != NIL; index = wheel->at(index).next) {
+			const uint64_t key = deadline_key(wheel, index);
+			if (key < best_key) {
+				best = index;
+				best_key = key;
+			}
+		}
+		dst = wheel->at(best).deadline;
+		return true;
+	}
+	if (!wheel->overflow.empty()) {
+		dst = wheel->at(wheel->overflow[0]).deadline;
+		return true;
+	}
+	return false;
+}
+
+size_t EternalTimestampTimerWheel::size(const ets_timer_wheel_t *wheel)
+{
+	return wheel->count;
+}
+
+eternal_timestamp_t EternalTimestampTimerWheel::now(const ets_timer_wheel_t *wheel)
+{
+	return encode(wheel->now);
+}
+
+int EternalTimestampTimerWheel::post(ets_timer_wheel_t *wheel, ets_timer_handle_t *handle, const eternal_timestamp_t deadline, uint64_t payload)
+{
+	ETS_STATS_ENTRY(TIMER_WHEEL_POST);
+	if (handle)
+		*handle = 0;
+	wheel_time d;
+	if (!decode(d, deadline))
+		return EINVAL;
+
+	std::lock_guard<std::mutex> guard(wheel->lock);
+	uint32_t index;
+	if (!alloc_node(wheel, index))
+		return ENOMEM;
+	node &n = wheel->at(index);
+	if (!post_request(wheel, index, n.generation, false)) {
+		n.next = wheel->free_list;
+		wheel->free_list = index;
+		return ENOMEM;
+	}
+	n.deadline = deadline;
+	n.payload = payload;
+	n.location = IN_INTAKE;
+	if (handle)
+		*handle = make_handle(index, n.generation);
+	return 0;
+}
+
+void EternalTimestampTimerWheel::post_cancel(ets_timer_wheel_t *wheel, ets_timer_handle_t handle)
+{
+	ETS_STATS_ENTRY(TIMER_WHEEL_POST_CANCEL);
+	const uint64_t i = (handle & 0xFFFFFFFFU);
+	std::lock_guard<std::mutex> guard(wheel->lock);
+	if (i == 0 || i > wheel->allocated.load(std::memory_order_relaxed))
+		return;
+	// the owner checks the handle; out of memory, the timer will expire regardless, as it may whenever
+	// cancelling from another thread.
+	post_request(wheel, static_cast<uint32_t>(i - 1), static_cast<uint32_t>(handle >> 32), true);
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// C interface
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+extern "C" int ets_timer_wheel_create(ets_timer_wheel_t **dst, const eternal_timestamp_t now)
+{
+	return EternalTimestampTimerWheel::create(*dst, now);
+}
+
+extern "C" void ets_timer_wheel_destroy(ets_timer_wheel_t *wheel)
+{
+	EternalTimestampTimerWheel::destroy(wheel);
+}
+
+extern "C" int ets_timer_wheel_insert(ets_timer_wheel_t *wheel, ets_timer_handle_t *handle, const eternal_timestamp_t deadline, uint64_t payload)
+{
+	return EternalTimestampTimerWheel::insert(wheel, handle, deadline, payload);
+}
+
+extern "C" int ets_timer_wheel_insert_batch(ets_timer_wheel_t *wheel, ets_timer_handle_t *handles, const eternal_timestamp_t *deadlines, const uint64_t *payloads, size_t count)
+{
+	return EternalTimestampTimerWheel::insert_batch(wheel, handles, deadlines, payloads, count);
+}
+
+extern "C" int ets_timer_wheel_cancel(ets_timer_wheel_t *wheel, ets_timer_handle_t handle)
+{
+	return EternalTimestampTimerWheel::cancel(wheel, handle);
+}
+
+extern "C" int ets_timer_wheel_advance(ets_timer_wheel_t *wheel, const eternal_timestamp_t now)
+{
+	return EternalTimestampTimerWheel::advance(wheel, now);
+}
+
+extern "C" size_t ets_timer_wheel_drain(ets_timer_wheel_t *wheel, ets_timer_t *dst, size_t capacity)
+{
+	return EternalTimestampTimerWheel::drain(wheel, dst, capacity);
+}
+
+extern "C" size_t ets_timer_wheel_poll(ets_timer_wheel_t *wheel, const eternal_timestamp_t now, ets_timer_t *dst, size_t capacity)
+{
+	return EternalTimestampTimerWheel::poll(wheel, now, dst, capacity);
+}
+
+extern "C" int ets_timer_wheel_next_expiry(const ets_timer_wheel_t *wheel, eternal_timestamp_t *dst)
+{
+	return EternalTimestampTimerWheel::next_expiry(wheel, *dst);
+}
+
+extern "C" size_t ets_timer_wheel_size(const ets_timer_wheel_t *wheel)
+{
+	return EternalTimestampTimerWheel::size(wheel);
+}
+
+extern "C" eternal_timestamp_t ets_timer_wheel_now(const ets_timer_wheel_t *wheel)
+{
+	return EternalTimestampTimerWheel::now(wheel);
+}
+
+extern "C" int ets_timer_wheel_post(ets_timer_wheel_t *wheel, ets_timer_handle_t *handle, const eternal_timestamp_t deadline, uint64_t payload)
+{
+	return EternalTimestampTimerWheel::post(wheel, handle, deadline, payload);
+}
+
+extern "C" void ets_timer_wheel_post_cancel(ets_timer_wheel_t *wheel, ets_timer_handle_t handle)
+{
+	EternalTimestampTimerWheel::post_cancel(wheel, handle);
+}
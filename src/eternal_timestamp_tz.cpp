@@ -0,0 +1,853 @@
+
+#include "eternal_timestamp/eternal_timestamp_tz.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <mutex>
+
+#include "eternal_timestamp_instrumentation.h"
+#include "eternal_timestamp_internal.h"
+
+
+using namespace eternal_timestamp;
+
+
+namespace
+{
+	constexpr int64_t SECONDS_PER_DAY = 86400;
+
+	// Transitions derived from the footer rule are compiled into the table up to this year; later times evaluate
+	// the rule on the fly. This keeps the table small while the common case is a plain binary search.
+	constexpr int64_t RULE_TABLE_END_YEAR = 2100;
+
+	// A POSIX TZ rule date, e.g. "M3.5.0/3"
+	struct tz_rule_date
+	{
+		char kind;             // 'J': day 1..365, never counting Feb 29; 'D': day 0..365; 'M': month.week.weekday
+		uint8_t month;
+		uint8_t week;          // 1..5; 5 is the last one in the month
+		uint16_t day;          // 'J', 'D': the day number; 'M': the weekday, 0 is Sunday
+		int32_t time;          // seconds since local midnight; may be negative or beyond 24h (RFC 8536)
+	};
+
+	// The POSIX TZ rule in the TZif footer, e.g. "CET-1CEST,M3.5.0,M10.5.0/3"
+	struct tz_rule
+	{
+		int32_t std_offset;    // seconds east of UTC
+		int32_t dst_offset;
+		bool has_dst;
+		tz_rule_date start;    // in local standard time
+		tz_rule_date end;      // in local daylight saving time
+	};
+}
+
+struct ets_tz_zone
+{
+	ets_tz_zone *next;         // the zone cache chain
+	const char *name;          // NULL for zones which are not cached
+	uint32_t count;            // the number of transitions
+	int32_t initial_offset;    // the offset before the first transition
+	bool has_rule;
+	tz_rule rule;              // applies beyond the last transition when `has_rule`
+	const int64_t *transitions;        // UTC seconds, ascending
+	const int64_t *local_transitions;  // the local time at which each transition's offset starts: `transitions[i] + offsets[i]`
+	const int32_t *offsets;            // the offset in effect from each transition onwards
+};
+
+
+namespace
+{
+	inline uint32_t load_be32(const unsigned char *p)
+	{
+		return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+	}
+
+	inline int64_t load_be64(const unsigned char *p)
+	{
+		return static_cast<int64_t>((uint64_t(load_be32(p)) << 32) | load_be32(p + 4));
+	}
+
+	inline int64_t floor_div(int64_t v, int64_t d)
+	{
+		return (v >= 0 ? v / d : -((-v + d - 1) / d));
+	}
+
+	inline bool is_leap_year(int64_t y)
+	{
+		return (y % 4 == 0 && y % 100 != 0) || y % 400 == 0;
+	}
+
+	inline int64_t year_of(int64_t seconds)
+	{
+		int64_t y;
+		unsigned int m, d;
+		ets_civil_from_days(floor_div(seconds, SECONDS_PER_DAY), y, m, d);
+		return y;
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// POSIX TZ rules
+
+	// [+|-]hh[:mm[:ss]]; hours up to 167 (RFC 8536 extension)
+	bool parse_hms(const char *&p, const char *end, int32_t &dst)
+	{
+		int sign = 1;
+		if (p < end && (*p == '+' || *p == '-')) {
+			sign = (*p == '-' ? -1 : 1);
+			p++;
+		}
+		int32_t v[3] = { 0, 0, 0 };
+		for (int i = 0; i < 3; i++) {
+			if (i > 0) {
+				if (p >= end || *p != ':')
+					break;
+				p++;
+			}
+			if (p >= end || *p < '0' || *p > '9')
+				return false;
+			int32_t n = 0;
+			for (int k = 0; k < 3 && p < end && *p >= '0' && *p <= '9'; k++)
+				n = n * 10 + (*p++ - '0');
+			v[i] = n;
+		}
+		if (v[0] > 167 || v[1] > 59 || v[2] > 59)
+			return false;
+		dst = sign * (v[0] * 3600 + v[1] * 60 + v[2]);
+		return true;
+	}
+
+	bool parse_zone_abbreviation(const char *&p, const char *end)
+	{
+		if (p < end && *p == '<') {
+			while (++p < end && *p != '>') {}
+			if (p >= end)
+				return false;
+			p++;
+			return true;
+		}
+		const char *start = p;
+		while (p < end && ((*p >= 'A' && *p <= 'Z') || (*p >= 'a' && *p <= 'z')))
+			p++;
+		return p - start >= 3;
+	}
+
+	bool parse_rule_date(const char *&p, const char *end, tz_rule_date &d)
+	{
+		d.time = 7200;
+		d.month = 0;
+		d.week = 0;
+		d.day = 0;
+		unsigned int n[3] = { 0, 0, 0 };
+		if (p < end && *p == 'M') {
+			d.kind = 'M';
+			p++;
+			for (int i = 0; i < 3; i++) {
+				if (i > 0) {
+					if (p >= end || *p != '.')
+						return false;
+					p++;
+				}
+				if (p >= end || *p < '0' || *p > '9')
+					return false;
+				while (p < end && *p >= '0' && *p <= '9' && n[i] < 1000)
+					n[i] = n[i] * 10 + (*p++ - '0');
+			}
+			if (n[0] < 1 || n[0] > 12 || n[1] < 1 || n[1] > 5 || n[2] > 6)
+				return false;
+			d.month = static_cast<uint8_t>(n[0]);
+			d.week = static_cast<uint8_t>(n[1]);
+			d.day = static_cast<uint16_t>(n[2]);
+		}
+		else {
+			d.kind = 'D';
+			if (p < end && *p == 'J') {
+				d.kind = 'J';
+				p++;
+			}
+			if (p >= end || *p < '0' || *p > '9')
+				return false;
+			while (p < end && *p >= '0' && *p <= '9' && n[0] < 1000)
+				n[0] = n[0] * 10 + (*p++ - '0');
+			if ((d.kind == 'J' && (n[0] < 1 || n[0] > 365)) || n[0] > 365)
+				return false;
+			d.day = static_cast<uint16_t>(n[0]);
+		}
+		if (p < end && *p == '/') {
+			p++;
+			if (!parse_hms(p, end, d.time))
+				return false;
+		}
+		return true;
+	}
+
+	// Parse the TZif footer. An empty footer is fine: it means there is no rule.
+	bool parse_posix_tz(const char *p, const char *end, tz_rule &r, bool &has_rule)
+	{
+		has_rule = false;
+		if (p == end)
+			return true;
+
+		int32_t posix_offset;
+		if (!parse_zone_abbreviation(p, end) || !parse_hms(p, end, posix_offset))
+			return false;
+		// POSIX counts west of Greenwich as positive.
+		r.std_offset = -posix_offset;
+		r.dst_offset = r.std_offset;
+		r.has_dst = false;
+		has_rule = true;
+		if (p == end)
+			return true;
+
+		if (!parse_zone_abbreviation(p, end))
+			return false;
+		r.has_dst = true;
+		r.dst_offset = r.std_offset + 3600;
+		if (p < end && *p != ',') {
+			if (!parse_hms(p, end, posix_offset))
+				return false;
+			r.dst_offset = -posix_offset;
+		}
+		if (p == end) {
+			// the POSIX default: the US rules
+			r.start = tz_rule_date{ 'M', 3, 2, 0, 7200 };
+			r.end = tz_rule_date{ 'M', 11, 1, 0, 7200 };
+			return true;
+		}
+		if (*p++ != ',' || !parse_rule_date(p, end, r.start) || p >= end || *p++ != ',' || !parse_rule_date(p, end, r.end))
+			return false;
+		return p == end;
+	}
+
+	// the local midnight of the rule date in year `y`, in seconds since 1970/jan/01
+	int64_t rule_date_seconds(const tz_rule_date &d, int64_t y)
+	{
+		int64_t days;
+		switch (d.kind) {
+		case 'J':
+			days = ets_days_from_civil(y, 1, 1) + d.day - 1 + (is_leap_year(y) && d.day >= 60 ? 1 : 0);
+			break;
+
+		case 'D':
+			days = ets_days_from_civil(y, 1, 1) + d.day;
+			break;
+
+		default: {
+			static const unsigned char month_days[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+			const int64_t first = ets_days_from_civil(y, d.month, 1);
+			const int64_t weekday = ((first + 4) % 7 + 7) % 7;      // 1970/jan/01 was a Thursday
+			days = first + (d.day - weekday + 7) % 7 + (d.week - 1) * 7;
+			const int64_t length = month_days[d.month - 1] + (d.month == 2 && is_leap_year(y) ? 1 : 0);
+			while (days >= first + length)
+				days -= 7;
+			break;
+		}
+		}
+		return days * SECONDS_PER_DAY + d.time;
+	}
+
+	// The rule's (two) transitions in year `y`, in ascending order.
+	void rule_transitions(const tz_rule &r, int64_t y, int64_t transitions[2], int32_t offsets[2])
+	{
+		const int64_t start = rule_date_seconds(r.start, y) - r.std_offset;
+		const int64_t end = rule_date_seconds(r.end, y) - r.dst_offset;
+		if (start < end) {
+			transitions[0] = start;
+			offsets[0] = r.dst_offset;
+			transitions[1] = end;
+			offsets[1] = r.std_offset;
+		}
+		else {
+			// southern hemisphere
+			transitions[0] = end;
+			offsets[0] = r.std_offset;
+			transitions[1] = start;
+			offsets[1] = r.dst_offset;
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// lookups
+
+	// A transition table: `offsets[i]` is in effect from `transitions[i]` onwards, `initial` before the first one.
+	struct table_view
+	{
+		const int64_t *transitions;
+		const int64_t *local_transitions;
+		const int32_t *offsets;
+		uint32_t count;
+		int32_t initial;
+	};
+
+	// The transitions of the footer rule around year `y`, for times beyond the compiled table.
+	struct rule_window
+	{
+		int64_t transitions[8];
+		int64_t local_transitions[8];
+		int32_t offsets[8];
+
+		table_view build(const tz_rule &r, int64_t y)
+		{
+			for (int i = 0; i < 4; i++) {
+				rule_transitions(r, y - 2 + i, transitions + 2 * i, offsets + 2 * i);
+			}
+			for (int i = 0; i < 8; i++) {
+				local_transitions[i] = transitions[i] + offsets[i];
+			}
+			return table_view{ transitions, local_transitions, offsets, 8, offsets[1] };
+		}
+	};
+
+	// The index of the last element <= `v` in the ascending array, -1 when there is none.
+	inline int64_t last_at_or_before(const int64_t *a, uint32_t count, int64_t v)
+	{
+		uint32_t lo = 0, n = count;
+		while (n > 0) {
+			const uint32_t half = n / 2;
+			if (a[lo + half] <= v) {
+				lo += half + 1;
+				n -= half + 1;
+			}
+			else {
+				n = half;
+			}
+		}
+		return static_cast<int64_t>(lo) - 1;
+	}
+
+	inline int32_t offset_of(const table_view &v, int64_t k)
+	{
+		return (k < 0 ? v.initial : v.offsets[k]);
+	}
+
+	// The interval [lo, hi) of UTC times, or of local times, for which a lookup result holds.
+	struct validity_interval
+	{
+		int64_t lo;
+		int64_t hi;
+	};
+
+	int32_t utc_offset_in(const table_view &v, int64_t u, validity_interval &range)
+	{
+		const int64_t k = last_at_or_before(v.transitions, v.count, u);
+		range.lo = (k < 0 ? INT64_MIN : v.transitions[k]);
+		range.hi = (k + 1 < v.count ? v.transitions[k + 1] : INT64_MAX);
+		return offset_of(v, k);
+	}
+
+	// Map local time `local` to UTC. Produces one instant for regular local times, two (ascending) for ambiguous
+	// ones and, for skipped local times, the instants using the offset before and after the transition.
+	//
+	// Return the number of instants which produce the local time when converted back (0, 1 or 2).
+	int local_to_utc_in(const table_view &v, int64_t local, int64_t instants[2], validity_interval &range)
+	{
+		// the last regime which starts at or before `local`, in local time; these starts ascend as long as
+		// transitions are further apart than the offsets differ, which is true for any real zone.
+		const int64_t k = last_at_or_before(v.local_transitions, v.count, local);
+		const int32_t offset = offset_of(v, k);
+
+		// this regime ends at the next transition, in this regime's local time:
+		const int64_t end = (k + 1 < v.count ? v.transitions[k + 1] + offset : INT64_MAX);
+		if (local >= end) {
+			// skipped: the clocks were turned forward
+			const int32_t next_offset = v.offsets[k + 1];
+			instants[0] = local - next_offset;
+			instants[1] = local - offset;
+			range.lo = range.hi = local;
+			return 0;
+		}
+
+		// ... but the local times from where the next regime starts are ambiguous
+		range.lo = (k < 0 ? INT64_MIN : v.local_transitions[k]);
+		range.hi = (k + 1 < v.count && v.local_transitions[k + 1] < end ? v.local_transitions[k + 1] : end);
+		if (k >= 0) {
+			// the previous regime ends at this transition, in its own local time; when that is beyond `local`,
+			// the clocks were turned back and `local` occurs twice.
+			const int32_t previous_offset = offset_of(v, k - 1);
+			const int64_t previous_end = v.transitions[k] + previous_offset;
+			if (local < previous_end) {
+				instants[0] = local - previous_offset;
+				instants[1] = local - offset;
+				range.lo = range.hi = local;
+				return 2;
+			}
+			if (previous_end > range.lo)
+				range.lo = previous_end;
+		}
+		instants[0] = instants[1] = local - offset;
+		return 1;
+	}
+
+	inline table_view table_of(const ets_tz_zone *zone)
+	{
+		return table_view{ zone->transitions, zone->local_transitions, zone->offsets, zone->count, zone->initial_offset };
+	}
+
+	// Times this far beyond the last transition are resolved through the footer rule. The margin keeps the
+	// table and the rule window from disagreeing about the regime which straddles the table end.
+	inline bool beyond_table(const ets_tz_zone *zone, int64_t t)
+	{
+		return zone->has_rule && (zone->count == 0 || t - 2 * SECONDS_PER_DAY > zone->transitions[zone->count - 1]);
+	}
+
+	int32_t utc_offset_at(const ets_tz_zone *zone, int64_t u, validity_interval &range)
+	{
+		if (!beyond_table(zone, u))
+			return utc_offset_in(table_of(zone), u, range);
+		if (!zone->rule.has_dst) {
+			range.lo = INT64_MIN;
+			range.hi = INT64_MAX;
+			return zone->rule.std_offset;
+		}
+		rule_window w;
+		const int32_t offset = utc_offset_in(w.build(zone->rule, year_of(u)), u, range);
+		// the window only covers a few years
+		range.lo = range.hi = u;
+		return offset;
+	}
+
+	int local_to_utc_at(const ets_tz_zone *zone, int64_t local, int64_t instants[2], validity_interval &range)
+	{
+		if (!beyond_table(zone, local))
+			return local_to_utc_in(table_of(zone), local, instants, range);
+		if (!zone->rule.has_dst) {
+			instants[0] = instants[1] = local - zone->rule.std_offset;
+			range.lo = INT64_MIN;
+			range.hi = INT64_MAX;
+			return 1;
+		}
+		rule_window w;
+		const int n = local_to_utc_in(w.build(zone->rule, year_of(local)), local, instants, range);
+		range.lo = range.hi = local;
+		return n;
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// TZif parsing
+
+	struct tzif_counts
+	{
+		uint32_t isutcnt, isstdcnt, leapcnt, timecnt, typecnt, charcnt;
+
+		size_t data_size(size_t time_size) const
+		{
+			return timecnt * time_size + timecnt + typecnt * size_t(6) + charcnt + leapcnt * (time_size + 4) + isstdcnt + isutcnt;
+		}
+	};
+
+	bool parse_tzif_header(const unsigned char *p, const unsigned char *end, tzif_counts &c, char &version)
+	{
+		if (end - p < 44 || memcmp(p, "TZif", 4))
+			return false;
+		version = static_cast<char>(p[4]);
+		c.isutcnt = load_be32(p + 20);
+		c.isstdcnt = load_be32(p + 24);
+		c.leapcnt = load_be32(p + 28);
+		c.timecnt = load_be32(p + 32);
+		c.typecnt = load_be32(p + 36);
+		c.charcnt = load_be32(p + 40);
+		// RFC 8536 section 3.1 limits
+		if (c.typecnt == 0 || c.typecnt > 256 || c.charcnt == 0 || (c.isutcnt && c.isutcnt != c.typecnt) || (c.isstdcnt && c.isstdcnt != c.typecnt) || c.timecnt > 1000000 || c.leapcnt > 100000 || c.charcnt > 100000)
+			return false;
+		return static_cast<size_t>(end - p - 44) >= c.data_size(4);
+	}
+
+	int compile_tzif(ets_tz_zone *&dst, const unsigned char *p, const unsigned char *end, const char *name)
+	{
+		tzif_counts c;
+		char version;
+		if (!parse_tzif_header(p, end, c, version))
+			return EINVAL;
+
+		size_t time_size = 4;
+		const unsigned char *footer = nullptr;
+		if (version >= '2') {
+			// skip the 32-bit data: the 64-bit block which follows is what we want.
+			p += 44 + c.data_size(4);
+			if (!parse_tzif_header(p, end, c, version) || static_cast<size_t>(end - p - 44) < c.data_size(8))
+				return EINVAL;
+			time_size = 8;
+			footer = p + 44 + c.data_size(8);
+		}
+		const unsigned char *times = p + 44;
+		const unsigned char *indexes = times + c.timecnt * time_size;
+		const unsigned char *types = indexes + c.timecnt;
+
+		for (uint32_t i = 0; i < c.typecnt; i++) {
+			const int32_t utoff = static_cast<int32_t>(load_be32(types + 6 * i));
+			if (utoff < -89999 || utoff > 93599)
+				return EINVAL;
+		}
+
+		tz_rule rule{};
+		bool has_rule = false;
+		if (footer) {
+			if (end - footer < 2 || *footer != '\n')
+				return EINVAL;
+			const unsigned char *footer_end = static_cast<const unsigned char *>(memchr(footer + 1, '\n', end - footer - 1));
+			if (!footer_end || !parse_posix_tz(reinterpret_cast<const char *>(footer + 1), reinterpret_cast<const char *>(footer_end), rule, has_rule))
+				return EINVAL;
+		}
+
+		// Transitions which don't change the offset (e.g. only the abbreviation changes) are dropped, and the
+		// rule's transitions are added up to `RULE_TABLE_END_YEAR`.
+		int64_t last = INT64_MIN;
+		if (c.timecnt)
+			last = (time_size == 8 ? load_be64(times + 8 * (c.timecnt - 1)) : static_cast<int32_t>(load_be32(times + 4 * (c.timecnt - 1))));
+		const int64_t first_rule_year = (c.timecnt ? year_of(last) : 1970);
+		const size_t rule_capacity = (has_rule && rule.has_dst && first_rule_year <= RULE_TABLE_END_YEAR ? 2 * static_cast<size_t>(RULE_TABLE_END_YEAR - first_rule_year + 1) : 0);
+		const size_t capacity = c.timecnt + rule_capacity;
+		const size_t name_size = (name ? strlen(name) + 1 : 0);
+
+		const size_t size = sizeof(ets_tz_zone) + capacity * (2 * sizeof(int64_t) + sizeof(int32_t)) + name_size;
+		ets_tz_zone *zone = static_cast<ets_tz_zone *>(malloc(size));
+		if (!zone)
+			return ENOMEM;
+		int64_t *transitions = reinterpret_cast<int64_t *>(zone + 1);
+		int64_t *local_transitions = transitions + capacity;
+		int32_t *offsets = reinterpret_cast<int32_t *>(local_transitions + capacity);
+		char *name_copy = reinterpret_cast<char *>(offsets + capacity);
+
+		// RFC 8536: local time before the first transition is given by time type 0.
+		zone->initial_offset = static_cast<int32_t>(load_be32(types));
+		int32_t current = zone->initial_offset;
+		uint32_t n = 0;
+		for (uint32_t i = 0; i < c.timecnt; i++) {
+			const int64_t t = (time_size == 8 ? load_be64(times + 8 * i) : static_cast<int32_t>(load_be32(times + 4 * i)));
+			if (indexes[i] >= c.typecnt || (n && t <= transitions[n - 1])) {
+				free(zone);
+				return EINVAL;
+			}
+			const int32_t offset = static_cast<int32_t>(load_be32(types + 6 * indexes[i]));
+			if (offset == current)
+				continue;
+			transitions[n] = t;
+			offsets[n] = offset;
+			current = offset;
+			n++;
+		}
+		if (rule_capacity) {
+			for (int64_t y = first_rule_year; y <= RULE_TABLE_END_YEAR; y++) {
+				int64_t rt[2];
+				int32_t ro[2];
+				rule_transitions(rule, y, rt, ro);
+				for (int k = 0; k < 2; k++) {
+					if (rt[k] <= last || ro[k] == current)
+						continue;
+					transitions[n] = rt[k];
+					offsets[n] = ro[k];
+					current = ro[k];
+					last = rt[k];
+					n++;
+				}
+			}
+		}
+		for (uint32_t i = 0; i < n; i++) {
+			local_transitions[i] = transitions[i] + offsets[i];
+		}
+
+		zone->next = nullptr;
+		zone->count = n;
+		zone->has_rule = has_rule;
+		zone->rule = rule;
+		zone->transitions = transitions;
+		zone->local_transitions = local_transitions;
+		zone->offsets = offsets;
+		zone->name = nullptr;
+		if (name) {
+			memcpy(name_copy, name, name_size);
+			zone->name = name_copy;
+		}
+		dst = zone;
+		return 0;
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// the zone cache
+
+	std::mutex zone_cache_lock;
+	ets_tz_zone *zone_cache = nullptr;
+
+	// Zone names are relative paths into the zoneinfo directory; don't let them escape it.
+	bool is_valid_zone_name(const char *name)
+	{
+		if (!name || !*name || *name == '/' || strlen(name) > 255)
+			return false;
+		for (const char *p = name; *p; p++) {
+			const bool component_start = (p == name || p[-1] == '/');
+			if (component_start && p[0] == '.' && (p[1] == '.' || p[1] == '/' || p[1] == 0))
+				return false;
+			if (*p == '\\')
+				return false;
+		}
+		return true;
+	}
+
+	int read_file(const char *path, unsigned char *&data, size_t &size)
+	{
+		FILE *f = fopen(path, "rb");
+		if (!f)
+			return (errno ? errno : ENOENT);
+		size_t capacity = 4096;
+		size = 0;
+		data = static_cast<unsigned char *>(malloc(capacity));
+		while (data) {
+			size += fread(data + size, 1, capacity - size, f);
+			if (size < capacity)
+				break;
+			// zoneinfo files are a few KB at most; anything this large is not one.
+			if (capacity >= (size_t(1) << 24)) {
+				free(data);
+				data = nullptr;
+				fclose(f);
+				return EINVAL;
+			}
+			capacity *= 2;
+			unsigned char *grown = static_cast<unsigned char *>(realloc(data, capacity));
+			if (!grown)
+				free(data);
+			data = grown;
+		}
+		const bool failed = ferror(f);
+		fclose(f);
+		if (!data)
+			return ENOMEM;
+		if (failed) {
+			free(data);
+			return EIO;
+		}
+		return 0;
+	}
+}
+
+
+int EternalTimestampZone::load(const ets_tz_zone_t *&dst, const char *name)
+{
+	ETS_STATS_ENTRY(TZ_LOAD);
+	if (!is_valid_zone_name(name))
+		return EINVAL;
+
+	std::lock_guard<std::mutex> guard(zone_cache_lock);
+	for (const ets_tz_zone *z = zone_cache; z; z = z->next) {
+		if (!strcmp(z->name, name)) {
+			dst = z;
+			return 0;
+		}
+	}
+
+	const char *dir = getenv("TZDIR");
+	if (!dir || !*dir)
+		dir = "/usr/share/zoneinfo";
+	char path[1024];
+	if (snprintf(path, sizeof(path), "%s/%s", dir, name) >= static_cast<int>(sizeof(path)))
+		return EINVAL;
+
+	unsigned char *data;
+	size_t size;
+	int rv = read_file(path, data, size);
+	if (rv)
+		return rv;
+	ets_tz_zone *zone;
+	rv = compile_tzif(zone, data, data + size, name);
+	free(data);
+	if (rv)
+		return rv;
+
+	zone->next = zone_cache;
+	zone_cache = zone;
+	dst = zone;
+	return 0;
+}
+
+int EternalTimestampZone::compile(ets_tz_zone_t *&dst, const void *data, size_t size)
+{
+	ETS_STATS_ENTRY(TZ_COMPILE);
+	const unsigned char *p = static_cast<const unsigned char *>(data);
+	return compile_tzif(dst, p, p + size, nullptr);
+}
+
+void EternalTimestampZone::release(ets_tz_zone_t *zone)
+{
+	// cached zones live as long as the process does.
+	if (zone && !zone->name)
+		free(zone);
+}
+
+int32_t EternalTimestampZone::utc_offset(const ets_tz_zone_t *zone, int64_t utc_seconds)
+{
+	ETS_STATS_ENTRY(TZ_UTC_OFFSET);
+	validity_interval range;
+	return utc_offset_at(zone, utc_seconds, range);
+}
+
+
+namespace
+{
+	// Shift a modern timestamp with complete date and hour by `delta` seconds; the unspecified fields below the
+	// hour remain unspecified. Return `false` when the result is outside the modern range.
+	bool shift_timestamp(eternal_timestamp_t &t, int64_t local, int64_t delta)
+	{
+		const int64_t shifted = local + delta;
+		const int64_t days = floor_div(shifted, SECONDS_PER_DAY);
+		const int64_t rest = shifted - days * SECONDS_PER_DAY;
+		int64_t y;
+		unsigned int m, d;
+		ets_civil_from_days(days, y, m, d);
+		const int64_t century = (y + MODERN_EPOCH) / 100;
+		if (y + MODERN_EPOCH < 0 || century > get_MaxInvalid(ETMT_FIELDSIZE_CENTURY) || century == get_Invalid(ETMT_FIELDSIZE_CENTURY))
+			return false;
+
+		t = ets_modern_set_century(t, static_cast<uint64_t>(century));
+		t = ets_modern_set_year(t, FIELD_VAL_OFFSET + static_cast<uint64_t>((y + MODERN_EPOCH) % 100));
+		t = ets_modern_set_month(t, FIELD_VAL_OFFSET - 1 + m);
+		t = ets_modern_set_day(t, FIELD_VAL_OFFSET - 1 + d);
+		t = ets_modern_set_hour(t, FIELD_VAL_OFFSET + static_cast<uint64_t>(rest / 3600));
+		if (ets_modern_minute(t) != get_Invalid(ETMT_FIELDSIZE_MINUTE))
+			t = ets_modern_set_minute(t, FIELD_VAL_OFFSET + static_cast<uint64_t>(rest / 60 % 60));
+		if (ets_modern_seconds(t) != get_Invalid(ETMT_FIELDSIZE_SECONDS))
+			t = ets_modern_set_seconds(t, FIELD_VAL_OFFSET + static_cast<uint64_t>(rest % 60));
+		return true;
+	}
+
+	// The timestamp as seconds since 1970/jan/01, taking unspecified minutes and seconds as zero.
+	// Return `false` when the timestamp cannot be placed on the time line, which includes fields out of their
+	// range, e.g. feb/31 or month 14.
+	inline bool to_seconds(int64_t &dst, const eternal_timestamp_t t)
+	{
+		if (!ets_has_complete_modern_date(t) || ets_modern_hour(t) == get_Invalid(ETMT_FIELDSIZE_HOUR) || !ets_has_valid_modern_fields(t))
+			return false;
+		const int64_t y = static_cast<int64_t>(ets_modern_century(t)) * 100 + (static_cast<int64_t>(ets_modern_year(t)) - FIELD_VAL_OFFSET) - MODERN_EPOCH;
+		int64_t s = ets_days_from_civil(y, static_cast<unsigned int>(ets_modern_month(t)) + 1 - FIELD_VAL_OFFSET, static_cast<unsigned int>(ets_modern_day(t)) + 1 - FIELD_VAL_OFFSET) * SECONDS_PER_DAY;
+		s += (static_cast<int64_t>(ets_modern_hour(t)) - FIELD_VAL_OFFSET) * 3600;
+		if (ets_modern_minute(t) != get_Invalid(ETMT_FIELDSIZE_MINUTE))
+			s += (static_cast<int64_t>(ets_modern_minute(t)) - FIELD_VAL_OFFSET) * 60;
+		if (ets_modern_seconds(t) != get_Invalid(ETMT_FIELDSIZE_SECONDS))
+			s += static_cast<int64_t>(ets_modern_seconds(t)) - FIELD_VAL_OFFSET;
+		dst = s;
+		return true;
+	}
+
+	inline void set_validity(uint8_t *validity, size_t i, bool valid)
+	{
+		if (!validity)
+			return;
+		const uint8_t bit = static_cast<uint8_t>(1u << (i % 8));
+		if (valid)
+			validity[i / 8] |= bit;
+		else
+			validity[i / 8] &= static_cast<uint8_t>(~bit);
+	}
+}
+
+
+size_t EternalTimestampZone::cvt_local_to_utc(eternal_timestamp_t *dst, uint8_t *validity, const eternal_timestamp_t *src, size_t count, const ets_tz_zone_t *zone, ets_tz_disambiguation how, unsigned int parallelism)
+{
+	ETS_STATS_ENTRY(TZ_CVT_LOCAL_TO_UTC);
+	return ets_parallel_sum(count, parallelism, [=](size_t begin, size_t end) {
+		// input is usually sorted or clustered in time: remember the local time interval of the last lookup
+		// within which the offset is the same, unambiguous one.
+		validity_interval cached{ 1, 0 };
+		int32_t cached_offset = 0;
+
+		size_t failures = 0;
+		for (size_t i = begin; i < end; i++) {
+			eternal_timestamp_t t = src[i];
+			int64_t local;
+			bool ok = to_seconds(local, t);
+			if (ok) {
+				int64_t delta = -cached_offset;
+				if (local < cached.lo || local >= cached.hi) {
+					int64_t instants[2];
+					validity_interval range;
+					const int n = local_to_utc_at(zone, local, instants, range);
+					if (n == 1) {
+						cached = range;
+						cached_offset = static_cast<int32_t>(local - instants[0]);
+					}
+					else if (how == ETS_TZ_REJECT) {
+						ok = false;
+					}
+					ETS_STATS_EVENT_IF(TZ_LOCAL_TIME_GAP, n == 0);
+					ETS_STATS_EVENT_IF(TZ_LOCAL_TIME_OVERLAP, n == 2);
+					int64_t instant = instants[0];
+					if (how == ETS_TZ_LATER || (how == ETS_TZ_COMPATIBLE && n == 0))
+						instant = instants[1];
+					delta = instant - local;
+				}
+				ok = ok && shift_timestamp(t, local, delta);
+			}
+			if (!ok) {
+				t = src[i];
+				failures++;
+			}
+			dst[i] = t;
+			set_validity(validity, i, ok);
+		}
+		return failures;
+	});
+}
+
+size_t EternalTimestampZone::cvt_utc_to_local(eternal_timestamp_t *dst, uint8_t *validity, const eternal_timestamp_t *src, size_t count, const ets_tz_zone_t *zone, unsigned int parallelism)
+{
+	ETS_STATS_ENTRY(TZ_CVT_UTC_TO_LOCAL);
+	return ets_parallel_sum(count, parallelism, [=](size_t begin, size_t end) {
+		validity_interval cached{ 1, 0 };
+		int32_t cached_offset = 0;
+
+		size_t failures = 0;
+		for (size_t i = begin; i < end; i++) {
+			eternal_timestamp_t t = src[i];
+			int64_t utc;
+			bool ok = to_seconds(utc, t);
+			if (ok) {
+				if (utc < cached.lo || utc >= cached.hi)
+					cached_offset = utc_offset_at(zone, utc, cached);
+				ok = shift_timestamp(t, utc, cached_offset);
+			}
+			if (!ok) {
+				t = src[i];
+				failures++;
+			}
+			dst[i] = t;
+			set_validity(validity, i, ok);
+		}
+		return failures;
+	});
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// C interface
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+extern "C" int ets_tz_load(const ets_tz_zone_t **dst, const char *name)
+{
+	return EternalTimestampZone::load(*dst, name);
+}
+
+extern "C" int ets_tz_compile(ets_tz_zone_t **dst, const void *data, size_t size)
+{
+	return EternalTimestampZone::compile(*dst, data, size);
+}
+
+extern "C" void ets_tz_release(ets_tz_zone_t *zone)
+{
+	EternalTimestampZone::release(zone);
+}
+
+extern "C" int32_t ets_tz_utc_offset(const ets_tz_zone_t *zone, int64_t utc_seconds)
+{
+	return EternalTimestampZone::utc_offset(zone, utc_seconds);
+}
+
+extern "C" size_t ets_tz_cvt_local_to_utc(eternal_timestamp_t *dst, uint8_t *validity, const eternal_timestamp_t *src, size_t count, const ets_tz_zone_t *zone, enum ets_tz_disambiguation how)
+{
+	return EternalTimestampZone::cvt_local_to_utc(dst, validity, src, count, zone, how);
+}
+
+extern "C" size_t ets_tz_cvt_utc_to_local(eternal_timestamp_t *dst, uint8_t *validity, const eternal_timestamp_t *src, size_t count, const ets_tz_zone_t *zone)
+{
+	return EternalTimestampZone::cvt_utc_to_local(dst, validity, src, count, zone);
+}
@@ -0,0 +1,35 @@
+#include "eternal_timestamp/eternal_timestamp_value.h"
+
+#include "eternal_timestamp_instrumentation.h"
+#include "eternal_timestamp_internal.h"
+
+
+using namespace eternal_timestamp;
+
+
+EternalTimestampValue eternal_clock::to_timestamp(const time_point &tp) noexcept
+{
+	ETS_STATS_ENTRY(CLOCK_TO_TIMESTAMP);
+
+	// the modern range: from the century after the epoch up to the top century code, which is 'unspecified' in
+	// builds where 'unspecified' sorts last.
+	static const int64_t lowest = ets_days_from_civil(100 - MODERN_EPOCH, 1, 1) * USECS_PER_DAY;
+	static const int64_t highest = ets_days_from_civil((get_MaxInvalid(ETMT_FIELDSIZE_CENTURY) + FIELD_VAL_OFFSET) * 100 - MODERN_EPOCH, 1, 1) * USECS_PER_DAY;
+
+	const int64_t usecs = tp.time_since_epoch().count();
+	if (usecs < lowest || usecs >= highest)
+		return ets_make_unknown();
+	return ets_encode_modern_from_unix_usecs(usecs);
+}
+
+int eternal_clock::from_timestamp(time_point &dst, const EternalTimestampValue t) noexcept
+{
+	ETS_STATS_ENTRY(CLOCK_FROM_TIMESTAMP);
+	int64_t usecs;
+	if (ets_decode_modern_to_unix_usecs(usecs, t.value())) {
+		dst = time_point();
+		return -1;
+	}
+	dst = time_point(duration(usecs));
+	return 0;
+}
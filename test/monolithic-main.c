@@ -8,7 +8,37 @@
 MONOLITHIC_CMD_TABLE_START()
 	{ "test_c", { .fa = eternalty_test_c_main } },
 	{ "test_cpp", { .fa = eternalty_test_cpp_main } },
+	{ "test_tm", { .fa = eternalty_test_tm_main } },
+	{ "test_sqlite", { .fa = eternalty_test_sqlite_main } },
+	{ "test_iso8601", { .fa = eternalty_test_iso8601_main } },
+	{ "test_bibdate", { .fa = eternalty_test_bibdate_main } },
+	{ "test_format", { .fa = eternalty_test_format_main } },
+	{ "test_tz", { .fa = eternalty_test_tz_main } },
+	{ "test_leap", { .fa = eternalty_test_leap_main } },
+	{ "test_hash", { .fa = eternalty_test_hash_main } },
+	{ "test_stats", { .fa = eternalty_test_stats_main } },
+	{ "test_parallel", { .fa = eternalty_test_parallel_main } },
+	{ "test_timer", { .fa = eternalty_test_timer_main } },
+	{ "test_terms", { .fa = eternalty_test_terms_main } },
+	{ "test_compact", { .fa = eternalty_test_compact_main } },
+	{ "test_layout", { .fa = eternalty_test_layout_main } },
+	{ "test_fields", { .fa = eternalty_test_fields_main } },
+	{ "test_value", { .fa = eternalty_test_value_main } },
+	{ "test_endian", { .fa = eternalty_test_endian_main } },
+	{ "test_fscrawl", { .fa = eternalty_test_fscrawl_main } },
+	{ "test_schedule", { .fa = eternalty_test_schedule_main } },
+	{ "test_calendar", { .fa = eternalty_test_calendar_main } },
+	{ "test_arrow", { .fa = eternalty_test_arrow_main } },
+	{ "test_logscan", { .fa = eternalty_test_logscan_main } },
     { "demo", {.fa = eternalty_demo_main } },
+    { "convert", {.fa = eternalty_convert_main } },
+    { "fscrawl", {.fa = eternalty_fscrawl_main } },
+    { "bench_hash", {.fa = eternalty_bench_hash_main } },
+    { "bench_parallel", {.fa = eternalty_bench_parallel_main } },
+    { "bench_timer", {.fa = eternalty_bench_timer_main } },
+    { "bench_suite", {.fa = eternalty_bench_suite_main } },
+    { "bench_fscrawl", {.fa = eternalty_bench_fscrawl_main } },
+    { "bench_logscan", {.fa = eternalty_bench_logscan_main } },
 
 MONOLITHIC_CMD_TABLE_END();
 
@@ -9,8 +9,38 @@ extern "C" {
 
 extern int eternalty_test_c_main(int argc, const char** argv);
 extern int eternalty_test_cpp_main(int argc, const char** argv);
+extern int eternalty_test_tm_main(int argc, const char** argv);
+extern int eternalty_test_sqlite_main(int argc, const char** argv);
+extern int eternalty_test_iso8601_main(int argc, const char** argv);
+extern int eternalty_test_bibdate_main(int argc, const char** argv);
+extern int eternalty_test_format_main(int argc, const char** argv);
+extern int eternalty_test_tz_main(int argc, const char** argv);
+extern int eternalty_test_leap_main(int argc, const char** argv);
+extern int eternalty_test_hash_main(int argc, const char** argv);
+extern int eternalty_test_stats_main(int argc, const char** argv);
+extern int eternalty_test_parallel_main(int argc, const char** argv);
+extern int eternalty_test_timer_main(int argc, const char** argv);
+extern int eternalty_test_terms_main(int argc, const char** argv);
+extern int eternalty_test_compact_main(int argc, const char** argv);
+extern int eternalty_test_layout_main(int argc, const char** argv);
+extern int eternalty_test_fields_main(int argc, const char** argv);
+extern int eternalty_test_value_main(int argc, const char** argv);
+extern int eternalty_test_endian_main(int argc, const char** argv);
+extern int eternalty_test_fscrawl_main(int argc, const char** argv);
+extern int eternalty_test_schedule_main(int argc, const char** argv);
+extern int eternalty_test_calendar_main(int argc, const char** argv);
+extern int eternalty_test_arrow_main(int argc, const char** argv);
+extern int eternalty_test_logscan_main(int argc, const char** argv);
 
 extern int eternalty_demo_main(int argc, const char** argv);
+extern int eternalty_convert_main(int argc, const char** argv);
+extern int eternalty_fscrawl_main(int argc, const char** argv);
+extern int eternalty_bench_hash_main(int argc, const char** argv);
+extern int eternalty_bench_parallel_main(int argc, const char** argv);
+extern int eternalty_bench_timer_main(int argc, const char** argv);
+extern int eternalty_bench_suite_main(int argc, const char** argv);
+extern int eternalty_bench_fscrawl_main(int argc, const char** argv);
+extern int eternalty_bench_logscan_main(int argc, const char** argv);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,340 @@
+
+#include <eternal_timestamp/eternal_timestamp.h>
+#include <eternal_timestamp/eternal_timestamp_arrow.h>
+#include <eternal_timestamp/eternal_timestamp_batch.h>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "monolithic_examples.h"
+
+
+using namespace eternal_timestamp;
+
+static int failures = 0;
+
+static void check(bool ok, const char *what)
+{
+	if (!ok) {
+		fprintf(stderr, "FAIL: %s\n", what);
+		failures++;
+	}
+}
+
+static eternal_timestamp_t parse(const char *iso8601)
+{
+	eternal_timestamp_t t;
+	t.t = 0;
+	EternalTimestamp::cvt_from_iso8601(t, iso8601, strlen(iso8601));
+	return t;
+}
+
+static bool bit_is_set(const uint8_t *bitmap, int64_t i)
+{
+	return (bitmap[i / 8] >> (i % 8)) & 1;
+}
+
+static bool is_unknown(const eternal_timestamp_t t)
+{
+	return t.t == EternalTimestamp::unknown().t;
+}
+
+static int owner_releases = 0;
+
+static void release_owner(void *owner)
+{
+	owner_releases++;
+	*static_cast<int *>(owner) = 1;
+}
+
+static void test_export_import()
+{
+	const eternal_timestamp_t values[10] = {
+		parse("2022-01-13T12:40:31.049352Z"), parse("1970-01-01"), parse("-0044-03-15"), parse("2020-09"), parse("20??"),
+		parse("1969-12-31T23:59:59.999999Z"), parse("2000-02-29T00:00Z"), parse("+12345-06-07"), parse("1582-10-15"), parse("2038-01-19T03:14:08Z"),
+	};
+	// entries 3 and 7 are null
+	const uint8_t validity[2] = { 0x77, 0x03 };
+
+	ArrowSchema schema;
+	ArrowArray array;
+	int released = 0;
+	owner_releases = 0;
+	check(EternalTimestampArrow::export_array(schema, array, values, validity, 10, release_owner, &released) == 0, "export_array succeeds");
+	check(array.length == 10 && array.null_count == 2 && array.offset == 0, "export_array counts the nulls");
+	check(array.buffers[1] == values && array.buffers[0] == validity, "export_array does not copy");
+	check(!strcmp(schema.format, "l") && (schema.flags & ARROW_FLAG_NULLABLE), "the storage type is a nullable int64");
+
+	// the extension metadata: two key/value pairs, the first one naming our extension type
+	{
+		const char *p = schema.metadata;
+		int32_t pairs = 0, len = 0;
+		check(p != nullptr, "the extension type is announced in the metadata");
+		if (p) {
+			memcpy(&pairs, p, sizeof(pairs));
+			p += sizeof(pairs);
+			check(pairs == 2, "the metadata holds the extension name and metadata");
+			memcpy(&len, p, sizeof(len));
+			p += sizeof(len);
+			check(len == 20 && !memcmp(p, "ARROW:extension:name", 20), "the first key is the extension name");
+			p += len;
+			memcpy(&len, p, sizeof(len));
+			p += sizeof(len);
+			check(len == static_cast<int32_t>(strlen(ETS_ARROW_EXTENSION_NAME)) && !memcmp(p, ETS_ARROW_EXTENSION_NAME, len), "the extension name");
+			p += len;
+			memcpy(&len, p, sizeof(len));
+			p += sizeof(len);
+			check(len == 24 && !memcmp(p, "ARROW:extension:metadata", 24), "the second key is the extension metadata");
+			p += len;
+			memcpy(&len, p, sizeof(len));
+			check(len == 0, "the extension metadata is empty");
+		}
+	}
+
+	// import: a zero-copy view of the same buffers
+	const eternal_timestamp_t *view = nullptr;
+	const uint8_t *view_validity = nullptr;
+	int64_t view_offset = -1, view_length = -1;
+	check(EternalTimestampArrow::import_array(view, view_validity, view_offset, view_length, schema, array) == 0, "import_array succeeds");
+	check(view == values && view_validity == validity && view_offset == 0 && view_length == 10, "import_array does not copy");
+
+	// a slice, as a consumer produces it: the values pointer and the validity offset reflect the array offset
+	array.offset = 3;
+	array.length = 6;
+	check(EternalTimestampArrow::import_array(view, view_validity, view_offset, view_length, schema, array) == 0, "import_array of a slice succeeds");
+	check(view == values + 3 && view_offset == 3 && view_length == 6, "import_array applies the array offset");
+	check(!bit_is_set(view_validity, view_offset + 0) && bit_is_set(view_validity, view_offset + 1) && !bit_is_set(view_validity, view_offset + 4), "import_array keeps the validity bits");
+
+	std::vector<eternal_timestamp_t> copy(6);
+	check(EternalTimestampArrow::cvt_from_array(copy.data(), schema, array) == 0, "cvt_from_array of the extension type succeeds");
+	check(is_unknown(copy[0]) && copy[1].t == values[4].t && copy[2].t == values[5].t && is_unknown(copy[4]) && copy[5].t == values[8].t, "cvt_from_array copies the slice and applies the nulls");
+
+	check(released == 0, "the owner is not released before the array");
+	array.release(&array);
+	schema.release(&schema);
+	check(released == 1 && owner_releases == 1 && array.release == nullptr && schema.release == nullptr, "releasing the array releases the owner once");
+
+	// without a validity bitmap
+	check(EternalTimestampArrow::export_array(schema, array, values, nullptr, 10, nullptr, nullptr) == 0, "export_array without validity succeeds");
+	check(array.null_count == 0 && array.buffers[0] == nullptr, "export_array without validity has no nulls");
+	check(EternalTimestampArrow::import_array(view, view_validity, view_offset, view_length, schema, array) == 0 && view_validity == nullptr, "import_array without validity");
+	array.release(&array);
+	schema.release(&schema);
+
+	// other storage types are not ours
+	{
+		ArrowSchema other;
+		ArrowArray other_array;
+		check(EternalTimestampArrow::cvt_to_array(other, other_array, ETS_ARROW_FORMAT_DATE32, values, 10) == 0, "cvt_to_array date32 succeeds");
+		check(EternalTimestampArrow::import_array(view, view_validity, view_offset, view_length, other, other_array) == EINVAL, "import_array rejects a date32 array");
+		other_array.release(&other_array);
+		other.release(&other);
+	}
+	check(EternalTimestampArrow::export_array(schema, array, nullptr, nullptr, 1, nullptr, nullptr) == EINVAL, "export_array rejects missing values");
+}
+
+static void test_round_trips()
+{
+	const eternal_timestamp_t src[6] = {
+		parse("2022-01-13T12:40:31.049352Z"), parse("1969-12-31T23:59:59.999999Z"), parse("-9900-01-01T00:00:00.000000Z"),
+		parse("2020-09"), parse("+41199-12-31T23:59:59.999999Z"), parse("1970-01-01T00:00:00.000000Z"),
+	};
+	const eternal_timestamp_t dates[6] = {
+		parse("2022-01-13"), parse("1969-12-31"), parse("-9900-01-01"), parse("2020-09"), parse("+41199-12-31"), parse("1970-01-01"),
+	};
+
+	ArrowSchema schema;
+	ArrowArray array;
+	std::vector<eternal_timestamp_t> back(6);
+
+	// timestamp[us]: lossless for complete timestamps; partial ones become nulls
+	check(EternalTimestampArrow::cvt_to_array(schema, array, ETS_ARROW_FORMAT_TIMESTAMP_US_UTC, src, 6) == 0, "cvt_to_array timestamp[us] succeeds");
+	check(!strcmp(schema.format, ETS_ARROW_FORMAT_TIMESTAMP_US_UTC) && schema.metadata == nullptr, "timestamp[us] is a native Arrow type");
+	check(array.null_count == 1 && !bit_is_set(static_cast<const uint8_t *>(array.buffers[0]), 3), "timestamp[us] marks the partial timestamp null");
+	check(static_cast<const int64_t *>(array.buffers[1])[0] == INT64_C(1642077631049352) && static_cast<const int64_t *>(array.buffers[1])[1] == -1, "timestamp[us] values");
+	check(EternalTimestampArrow::cvt_from_array(back.data(), schema, array) == 0, "cvt_from_array timestamp[us] succeeds");
+	for (int i = 0; i < 6; i++) {
+		check(i == 3 ? is_unknown(back[i]) : back[i].t == src[i].t, "timestamp[us] round trip");
+	}
+	// a slice of the same array
+	array.offset = 4;
+	array.length = 2;
+	check(EternalTimestampArrow::cvt_from_array(back.data(), schema, array) == 0 && back[0].t == src[4].t && back[1].t == src[5].t, "timestamp[us] slice");
+	array.release(&array);
+	schema.release(&schema);
+
+	// date32: the time of day is dropped, producing date-only timestamps
+	check(EternalTimestampArrow::cvt_to_array(schema, array, ETS_ARROW_FORMAT_DATE32, src, 6) == 0, "cvt_to_array date32 succeeds");
+	check(array.null_count == 1 && static_cast<const int32_t *>(array.buffers[1])[0] == 19005 && static_cast<const int32_t *>(array.buffers[1])[1] == -1, "date32 values");
+	check(EternalTimestampArrow::cvt_from_array(back.data(), schema, array) == 0, "cvt_from_array date32 succeeds");
+	for (int i = 0; i < 6; i++) {
+		check(i == 3 ? is_unknown(back[i]) : back[i].t == dates[i].t, "date32 round trip");
+	}
+	array.offset = 1;
+	array.length = 3;
+	check(EternalTimestampArrow::cvt_from_array(back.data(), schema, array) == 0 && back[0].t == dates[1].t && back[1].t == dates[2].t && is_unknown(back[2]), "date32 slice");
+	array.release(&array);
+	schema.release(&schema);
+
+	// date64: milliseconds, whole days
+	check(EternalTimestampArrow::cvt_to_array(schema, array, ETS_ARROW_FORMAT_DATE64, src, 6) == 0, "cvt_to_array date64 succeeds");
+	check(array.null_count == 1 && static_cast<const int64_t *>(array.buffers[1])[0] == INT64_C(19005) * 86400000 && static_cast<const int64_t *>(array.buffers[1])[1] == -86400000, "date64 values");
+	check(EternalTimestampArrow::cvt_from_array(back.data(), schema, array) == 0, "cvt_from_array date64 succeeds");
+	for (int i = 0; i < 6; i++) {
+		check(i == 3 ? is_unknown(back[i]) : back[i].t == dates[i].t, "date64 round trip");
+	}
+	array.release(&array);
+	schema.release(&schema);
+
+	// date64 values far beyond the int32 day range are out of range, not wrapped around
+	{
+		int64_t msecs[2] = { INT64_MAX, INT64_MIN };
+		const void *buffers[2] = { nullptr, msecs };
+		ArrowSchema s{};
+		ArrowArray a{};
+		s.format = ETS_ARROW_FORMAT_DATE64;
+		s.release = [](ArrowSchema *) {};
+		a.length = 2;
+		a.n_buffers = 2;
+		a.buffers = buffers;
+		a.release = [](ArrowArray *) {};
+		check(EternalTimestampArrow::cvt_from_array(back.data(), s, a) == 0 && is_unknown(back[0]) && is_unknown(back[1]), "date64 values beyond the modern range");
+	}
+
+	check(EternalTimestampArrow::cvt_to_array(schema, array, "tsn:UTC", src, 6) == EINVAL, "cvt_to_array rejects unsupported formats");
+}
+
+static void test_batch_unix()
+{
+	const int64_t usecs[8] = {
+		0, INT64_C(1642077631049352), -1, INT64_C(-374580979200000000), INT64_C(1237979203199999999),
+		INT64_C(-400000000000000000), INT64_C(1) << 62, INT64_C(-374580979200000001),
+	};
+	std::vector<eternal_timestamp_t> dst(8);
+	uint8_t validity[1] = { 0 };
+
+	check(EternalTimestampBatch::cvt_from_unix_usecs(dst.data(), validity, usecs, 8, 1) == 3, "cvt_from_unix_usecs counts the out-of-range values");
+	check(validity[0] == 0x1F, "cvt_from_unix_usecs flags the out-of-range values");
+	check(dst[1].t == parse("2022-01-13T12:40:31.049352Z").t && dst[2].t == parse("1969-12-31T23:59:59.999999Z").t, "cvt_from_unix_usecs values");
+	check(dst[3].t == parse("-9900-01-01T00:00:00.000000Z").t && dst[4].t == parse("+41199-12-31T23:59:59.999999Z").t, "cvt_from_unix_usecs range bounds");
+	check(is_unknown(dst[5]) && is_unknown(dst[6]) && is_unknown(dst[7]), "cvt_from_unix_usecs out-of-range values are unknown");
+
+	// and back: the round trip is lossless for the valid values
+	int64_t back[8];
+	uint8_t back_validity[1] = { 0 };
+	check(EternalTimestampBatch::cvt_to_unix_usecs(back, back_validity, dst.data(), 8, 1) == 3 && back_validity[0] == 0x1F, "cvt_to_unix_usecs flags the unknown timestamps");
+	for (int i = 0; i < 5; i++) {
+		check(back[i] == usecs[i], "usecs round trip");
+	}
+
+	// the validity bitmap MAY be NULL, and offset (sub-)batches work alike
+	check(EternalTimestampBatch::cvt_from_unix_usecs(dst.data(), nullptr, usecs + 3, 5, 1) == 3, "cvt_from_unix_usecs without validity");
+	check(dst[0].t == parse("-9900-01-01T00:00:00.000000Z").t && is_unknown(dst[2]), "cvt_from_unix_usecs on an offset batch");
+
+	const int64_t msecs[3] = { INT64_C(1642077631049), INT64_C(-374580979200001), INT64_C(1237979203199999) };
+	check(EternalTimestampBatch::cvt_from_unix_msecs(dst.data(), validity, msecs, 3, 1) == 1 && (validity[0] & 7) == 5, "cvt_from_unix_msecs range");
+	check(dst[0].t == parse("2022-01-13T12:40:31.049000Z").t && is_unknown(dst[1]), "cvt_from_unix_msecs values");
+
+	const int64_t seconds[3] = { INT64_C(1642077631), INT64_MIN, INT64_MAX };
+	check(EternalTimestampBatch::cvt_from_unix_seconds(dst.data(), validity, seconds, 3, 1) == 2 && (validity[0] & 7) == 1, "cvt_from_unix_seconds range");
+	check(dst[0].t == parse("2022-01-13T12:40:31.000000Z").t && is_unknown(dst[1]) && is_unknown(dst[2]), "cvt_from_unix_seconds values");
+
+	const int32_t days[4] = { 19005, -4335428, INT32_MIN, INT32_MAX };
+	check(EternalTimestampBatch::cvt_from_unix_days(dst.data(), validity, days, 4, 1) == 2 && (validity[0] & 15) == 3, "cvt_from_unix_days range");
+	check(dst[0].t == parse("2022-01-13").t && dst[1].t == parse("-9900-01-01").t && is_unknown(dst[2]) && is_unknown(dst[3]), "cvt_from_unix_days values");
+
+	// a larger batch, split across threads: the validity bits of every chunk land at the right place
+	const size_t count = 100000;
+	std::vector<int64_t> src(count);
+	for (size_t i = 0; i < count; i++) {
+		src[i] = (i % 7 == 3 ? INT64_MIN + static_cast<int64_t>(i) : static_cast<int64_t>(i) * INT64_C(123456789013));
+	}
+	std::vector<eternal_timestamp_t> big(count);
+	std::vector<uint8_t> big_validity((count + 7) / 8);
+	std::vector<int64_t> big_back(count);
+	const size_t expected = (count + 3) / 7;
+	check(EternalTimestampBatch::cvt_from_unix_usecs(big.data(), big_validity.data(), src.data(), count, 4) == expected, "parallel cvt_from_unix_usecs counts the failures");
+	check(EternalTimestampBatch::cvt_to_unix_usecs(big_back.data(), nullptr, big.data(), count, 4) == expected, "parallel cvt_to_unix_usecs counts the failures");
+	bool ok = true;
+	for (size_t i = 0; i < count; i++) {
+		const bool valid = (i % 7 != 3);
+		ok = ok && bit_is_set(big_validity.data(), static_cast<int64_t>(i)) == valid && (valid ? big_back[i] == src[i] : is_unknown(big[i]));
+	}
+	check(ok, "parallel usecs round trip and validity");
+}
+
+
+// Timestamps whose fields hold codes beyond their range: the UNIX conversions and Arrow export flag them instead
+// of producing some epoch value.
+static void test_invalid_fields()
+{
+	// the code of the zero-based value 0.
+	const uint64_t first = (ETS_UNSPECIFIED_CODE(ETMT_MONTH_BITS) == 0 ? 1 : 0);
+	const eternal_timestamp_t base = parse("2022-02-13T12:40:31.049352Z");
+	const eternal_timestamp_t leap = parse("2024-02-29T12:40:31.049352Z");
+	const eternal_timestamp_t src[11] = {
+		ets_modern_set_month(base, first + 12),             // month 13
+		ets_modern_set_day(base, first + 30),               // February 31st
+		ets_modern_set_day(base, first + 28),               // February 29th, 2022
+		ets_modern_set_hour(base, first + 24),
+		ets_modern_set_minute(base, first + 60),
+		ets_modern_set_seconds(base, first + 60),           // the leap second has no UNIX time
+		ets_modern_set_milliseconds(base, first + 1000),
+		ets_modern_set_microseconds(base, first + 1000),
+		ets_modern_set_year(base, first + 100),
+		leap,
+		base,
+	};
+	const uint8_t valid = 0x06;     // the last two, in the second byte
+
+	std::vector<int64_t> usecs(11, -1);
+	uint8_t validity[2] = { 0xFF, 0xFF };
+	check(EternalTimestampBatch::cvt_to_unix_usecs(usecs.data(), validity, src, 11, 1) == 9 && validity[0] == 0 && (validity[1] & 7) == valid, "cvt_to_unix_usecs flags the fields out of range");
+	check(usecs[0] == 0 && usecs[9] == INT64_C(1709210431049352) && usecs[10] == INT64_C(1644756031049352), "cvt_to_unix_usecs values");
+	for (int i = 0; i < 11; i++) {
+		int64_t one = -1;
+		int32_t days = -1;
+		const size_t expected = (i < 9 ? 1 : 0);
+		check(EternalTimestampBatch::cvt_to_unix_usecs(&one, nullptr, src + i, 1, 1) == expected && one == usecs[i], "cvt_to_unix_usecs, one value at a time");
+		check(EternalTimestampBatch::cvt_to_unix_days(&days, nullptr, src + i, 1, 1) == expected && (expected ? days == 0 : days == usecs[i] / INT64_C(86400000000)), "cvt_to_unix_days, one value at a time");
+	}
+
+	ArrowSchema schema;
+	ArrowArray array;
+	check(EternalTimestampArrow::cvt_to_array(schema, array, ETS_ARROW_FORMAT_TIMESTAMP_US_UTC, src, 11) == 0, "cvt_to_array timestamp[us] with fields out of range");
+	const uint8_t *bitmap = static_cast<const uint8_t *>(array.buffers[0]);
+	check(array.null_count == 9 && bitmap[0] == 0 && (bitmap[1] & 7) == valid, "timestamp[us] nulls the fields out of range");
+	check(static_cast<const int64_t *>(array.buffers[1])[10] == INT64_C(1644756031049352), "timestamp[us] keeps the valid values");
+	array.release(&array);
+	schema.release(&schema);
+
+	check(EternalTimestampArrow::cvt_to_array(schema, array, ETS_ARROW_FORMAT_DATE32, src, 11) == 0, "cvt_to_array date32 with fields out of range");
+	bitmap = static_cast<const uint8_t *>(array.buffers[0]);
+	check(array.null_count == 9 && bitmap[0] == 0 && (bitmap[1] & 7) == valid && static_cast<const int32_t *>(array.buffers[1])[9] == 19782, "date32 nulls the fields out of range");
+	array.release(&array);
+	schema.release(&schema);
+}
+
+#if defined(BUILD_MONOLITHIC)
+#define main(cnt, arr)      eternalty_test_arrow_main(cnt, arr)
+#endif
+
+int main(int argc, const char **argv)
+{
+	fprintf(stderr, "Eternal Timestamp Test (Arrow C Data Interface, batch UNIX conversions)\n\n");
+
+	test_export_import();
+	test_round_trips();
+	test_batch_unix();
+	test_invalid_fields();
+
+	if (failures) {
+		fprintf(stderr, "\n%d test(s) FAILED\n", failures);
+		return EXIT_FAILURE;
+	}
+	fprintf(stderr, "All tests passed\n");
+	return EXIT_SUCCESS;
+}
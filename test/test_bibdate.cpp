@@ -0,0 +1,156 @@
+
+#include <eternal_timestamp/eternal_timestamp_bibdate.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "monolithic_examples.h"
+
+
+using namespace eternal_timestamp;
+
+static int failures = 0;
+
+// render the specified fields of a (partial) timestamp; unspecified fields are shown as '?'.
+static std::string describe(const eternal_timestamp_t t)
+{
+	char buf[80];
+	if (ets_format_mode(t)) {
+		snprintf(buf, sizeof(buf), "%llu years ago (10^%u)", static_cast<unsigned long long>(ets_prehistoric_years(t)), static_cast<unsigned>(ets_prehistoric_precision(t)));
+		return buf;
+	}
+
+	const int century = static_cast<int>(ets_modern_century(t));
+	const int year = static_cast<int>(ets_modern_year(t));
+	const unsigned month = static_cast<unsigned>(ets_modern_month(t));
+	const unsigned day = static_cast<unsigned>(ets_modern_day(t));
+	if (!century)
+		snprintf(buf, sizeof(buf), "?");
+	else if (!year)
+		snprintf(buf, sizeof(buf), "%dxx", century - 100);
+	else
+		snprintf(buf, sizeof(buf), "%d", century * 100 + year - 1 - 10000);
+	std::string rv = buf;
+	if (month || day) {
+		snprintf(buf, sizeof(buf), "-%02u", month);
+		rv += (month ? buf : "-?");
+		snprintf(buf, sizeof(buf), "-%02u", day);
+		rv += (day ? buf : "-?");
+	}
+	return rv;
+}
+
+static void check(const char *input, const char *expected, int min_confidence, int max_confidence, unsigned int qualifiers)
+{
+	eternal_timestamp_t t;
+	ets_bibdate_info_t info;
+	const int confidence = EternalTimestampBibDate::parse(t, info, input, strlen(input));
+
+	const std::string actual = (confidence ? describe(t) : "(not a date)");
+	if (actual != (expected ? expected : "(not a date)") || confidence < min_confidence || confidence > max_confidence || info.qualifiers != qualifiers) {
+		fprintf(stderr, "FAIL: '%s'\n  expected: %s, confidence %d..%d, qualifiers 0x%02x\n  actual:   %s, confidence %d, qualifiers 0x%02x\n",
+			input, (expected ? expected : "(not a date)"), min_confidence, max_confidence, qualifiers, actual.c_str(), confidence, info.qualifiers);
+		failures++;
+	}
+}
+
+
+#if defined(BUILD_MONOLITHIC)
+#define main(cnt, arr)      eternalty_test_bibdate_main(cnt, arr)
+#endif
+
+int main(int argc, const char **argv)
+{
+	fprintf(stderr, "Eternal Timestamp Test (bibliographic dates)\n\n");
+
+	// ISO 8601 takes the fast path
+	check("1922-01-13", "1922-01-13", 100, 100, 0);
+	check(" 2022-01 ", "2022-01-?", 100, 100, 0);
+
+	// textual dates
+	check("13 Jan. 1922", "1922-01-13", 90, 100, 0);
+	check("Jan. 13, 1922", "1922-01-13", 90, 100, 0);
+	check("1922 Jan 13", "1922-01-13", 90, 100, 0);
+	check("Thu, 13 Jan 2022 12:40:31 GMT", "2022-01-13", 90, 100, 0);
+	check("F\xc3\xa9vrier 1922", "1922-02-?", 85, 100, 0);
+	check("13. M\xc3\xa4rz 1922", "1922-03-13", 90, 100, 0);
+	check("Spring 1923", "1923-03-?", 85, 100, ETS_BIBDATE_SEASON);
+	check("13 January", "?-01-13", 50, 80, 0);
+	check("30 Feb 1922", "1922-02-?", 30, 70, 0);
+
+	// numeric dates
+	check("13/01/1922", "1922-01-13", 90, 100, 0);
+	check("01/13/1922", "1922-01-13", 90, 100, 0);
+	check("13.01.1922", "1922-01-13", 80, 100, 0);
+	check("03/04/1922", "1922-03-04", 40, 70, 0);
+	check("13/01/22", "2022-01-13", 40, 70, 0);
+	check("1922/05", "1922-05-?", 80, 100, 0);
+
+	// vague dates
+	check("circa 1850", "1850", 85, 100, ETS_BIBDATE_CIRCA);
+	check("c. 1850", "1850", 85, 100, ETS_BIBDATE_CIRCA);
+	check("c1922", "1922", 85, 100, 0);
+	check("[1922?]", "1922", 85, 100, ETS_BIBDATE_UNCERTAIN);
+	check("1920s", "1920", 80, 100, ETS_BIBDATE_DECADE);
+	check("1920's", "1920", 80, 100, ETS_BIBDATE_DECADE);
+	check("192-?", "1920", 80, 100, ETS_BIBDATE_DECADE | ETS_BIBDATE_UNCERTAIN);
+	check("19--", "19xx", 80, 100, ETS_BIBDATE_CENTURY);
+	check("1800s", "18xx", 50, 90, ETS_BIBDATE_CENTURY);
+	check("19th century", "18xx", 80, 100, ETS_BIBDATE_CENTURY);
+	check("late 19th c.", "18xx", 70, 100, ETS_BIBDATE_CENTURY);
+	check("XIXe si\xc3\xa8" "cle", "18xx", 80, 100, ETS_BIBDATE_CENTURY);
+	check("3rd century BC", "-3xx", 80, 100, ETS_BIBDATE_CENTURY);
+	check("2nd millennium BC", "-20xx", 80, 100, ETS_BIBDATE_MILLENNIUM);
+
+	// eras, ranges
+	check("44 BC", "-43", 85, 100, 0);
+	check("AD 79", "79", 85, 100, 0);
+	check("1922 B.C.E.", "-1921", 85, 100, 0);
+	check("1850-1860", "1850", 85, 100, ETS_BIBDATE_RANGE);
+	check("1850/51", "1850", 85, 100, ETS_BIBDATE_RANGE);
+	check("300-200 BC", "-299", 85, 100, ETS_BIBDATE_RANGE);
+	check("13-15 January 1922", "1922-01-13", 90, 100, ETS_BIBDATE_RANGE);
+	check("Jan-Mar 1922", "1922-01-?", 85, 100, ETS_BIBDATE_RANGE);
+	check("Jan 13 - Feb 2, 1922", "1922-01-13", 90, 100, ETS_BIBDATE_RANGE);
+
+	// deep past
+	check("ca. 40,000 BP", "38050 years ago (10^4)", 85, 100, ETS_BIBDATE_CIRCA | ETS_BIBDATE_BEFORE_PRESENT);
+	check("10,000 years ago", "-8050", 80, 100, ETS_BIBDATE_BEFORE_PRESENT);
+	check("2.5 million years ago", "2498050 years ago (10^5)", 80, 100, ETS_BIBDATE_BEFORE_PRESENT);
+	check("40000 BC", "39999 years ago (10^4)", 85, 100, 0);
+
+	// not dates
+	check("", nullptr, 0, 0, 0);
+	check("n.d.", nullptr, 0, 0, 0);
+	check("s.d.", nullptr, 0, 0, 0);
+	check("Smith, J.", nullptr, 0, 0, 0);
+	check("Vol. 12", "12", 1, 40, 0);
+
+	// batch APIs
+	{
+		const char *strings[] = { "circa 1850", "n.d.", nullptr, "Spring 1923" };
+		eternal_timestamp_t dst[4];
+		ets_bibdate_info_t info[4];
+		const size_t unrecognized = EternalTimestampBibDate::parse(dst, info, strings, nullptr, 4);
+		if (unrecognized != 2 || info[0].qualifiers != ETS_BIBDATE_CIRCA || info[1].confidence || info[2].confidence || describe(dst[3]) != "1923-03-?") {
+			fprintf(stderr, "FAIL: EternalTimestampBibDate::parse() batch: %zu unrecognized\n", unrecognized);
+			failures++;
+		}
+
+		const char data[] = "1920sXIXe si\xc3\xa8" "cleundated";
+		const int32_t offsets[] = { 0, 5, 17, 24 };
+		const size_t unrecognized_column = EternalTimestampBibDate::parse_column(dst, nullptr, data, offsets, 3);
+		if (unrecognized_column != 1 || describe(dst[0]) != "1920" || describe(dst[1]) != "18xx") {
+			fprintf(stderr, "FAIL: EternalTimestampBibDate::parse_column(): %zu unrecognized\n", unrecognized_column);
+			failures++;
+		}
+	}
+
+	if (failures) {
+		fprintf(stderr, "\n%d test(s) FAILED\n", failures);
+		return EXIT_FAILURE;
+	}
+	fprintf(stderr, "All tests passed\n");
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,264 @@
+#include <eternal_timestamp/eternal_timestamp.h>
+#include <eternal_timestamp/eternal_timestamp_calendar.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "monolithic_examples.h"
+
+
+using namespace eternal_timestamp;
+
+static int failures = 0;
+
+static void check(bool ok, const char *what)
+{
+	if (!ok) {
+		fprintf(stderr, "FAIL: %s\n", what);
+		failures++;
+	}
+}
+
+static eternal_timestamp_t parse(const char *iso8601)
+{
+	eternal_timestamp_t t;
+	t.t = 0;
+	EternalTimestamp::cvt_from_iso8601(t, iso8601, strlen(iso8601));
+	return t;
+}
+
+// `years` counts back from 0 AD; `precision` is the power of 10 the age is known to.
+static eternal_timestamp_t prehistoric(uint64_t years, unsigned precision)
+{
+	eternal_timestamp_t t{0};
+	t = ets_format_set_mode(t, 1);
+	t = ets_prehistoric_set_years(t, years);
+	t = ets_prehistoric_set_precision(t, precision);
+	return t;
+}
+
+// `week` and `iso_year` as `EternalTimestampCalendar::iso_week()` produces them.
+static bool iso_week_is(const char *date, int week, int32_t iso_year)
+{
+	int32_t y = -1;
+	return EternalTimestampCalendar::iso_week(parse(date), &y) == week && y == iso_year;
+}
+
+static void test_examples()
+{
+	check(EternalTimestampCalendar::weekday(parse("2024-01-01")) == 1, "2024-01-01 is a Monday");
+	check(EternalTimestampCalendar::weekday(parse("2022-01-13T12:40:00.123")) == 4, "2022-01-13 is a Thursday");
+	check(EternalTimestampCalendar::weekday(parse("1969-12-31")) == 3, "before 1970");
+	check(EternalTimestampCalendar::weekday(parse("2038-01-19T03:14:08Z")) == 2, "beyond 32-bit time_t");
+	check(EternalTimestampCalendar::weekday(parse("2000-02-29")) == 2 && EternalTimestampCalendar::weekday(parse("2100-03-01")) == 1, "leap centuries");
+	check(EternalTimestampCalendar::weekday(parse("1582-10-15")) == 5 && EternalTimestampCalendar::weekday(parse("1582-10-04")) == 1, "the proleptic Gregorian calendar");
+	check(EternalTimestampCalendar::weekday(parse("0000-03-01")) == 3 && EternalTimestampCalendar::weekday(parse("-0001-12-31")) == 5, "B.C. years");
+	check(EternalTimestampCalendar::weekday(parse("-9900-01-01")) == 5 && EternalTimestampCalendar::weekday(parse("+12345-06-07")) == 4, "the far past and future");
+
+	check(EternalTimestampCalendar::day_of_year(parse("2020-12-31")) == 366 && EternalTimestampCalendar::day_of_year(parse("1900-12-31")) == 365, "the last day of the year");
+	check(EternalTimestampCalendar::day_of_year(parse("2000-03-01")) == 61 && EternalTimestampCalendar::day_of_year(parse("2001-03-01")) == 60, "March 1st");
+
+	check(iso_week_is("2021-01-01", 53, 2020) && iso_week_is("2021-01-04", 1, 2021), "a week 53 of the previous year");
+	check(iso_week_is("2008-12-29", 1, 2009) && iso_week_is("2008-12-28", 52, 2008), "a week 1 of the next year");
+	check(iso_week_is("2020-12-31", 53, 2020) && iso_week_is("2015-12-31", 53, 2015) && iso_week_is("2016-01-03", 53, 2015), "53-week years");
+	check(iso_week_is("2022-01-02", 52, 2021) && iso_week_is("2022-01-03", 1, 2022), "a week 52 of the previous year");
+	check(iso_week_is("0000-01-01", 52, -1) && iso_week_is("-9900-01-01", 53, -9901), "ISO weeks of B.C. years");
+	check(EternalTimestampCalendar::iso_week(parse("2022-06-15")) == 24, "no year wanted");
+
+	check(EternalTimestampCalendar::quarter(parse("2022-01-31")) == 1 && EternalTimestampCalendar::quarter(parse("2022-06")) == 2
+		&& EternalTimestampCalendar::quarter(parse("2022-07-01")) == 3 && EternalTimestampCalendar::quarter(parse("2022-12")) == 4, "quarters");
+}
+
+static void test_unspecified()
+{
+	const eternal_timestamp_t partial[] = { parse("2020-09"), parse("2020"), parse("20"), prehistoric(50000, 0), prehistoric(1000000, 3) };
+	for (const eternal_timestamp_t t : partial) {
+		int32_t y = 12345;
+		check(EternalTimestampCalendar::weekday(t) == ETS_CALENDAR_UNSPECIFIED, "no weekday without a complete date");
+		check(EternalTimestampCalendar::day_of_year(t) == ETS_CALENDAR_UNSPECIFIED, "no day of the year without a complete date");
+		check(EternalTimestampCalendar::iso_week(t, &y) == ETS_CALENDAR_UNSPECIFIED && y == 12345, "no ISO week without a complete date");
+	}
+	check(EternalTimestampCalendar::quarter(partial[0]) == 3, "the quarter needs the month only");
+	check(EternalTimestampCalendar::quarter(partial[1]) == ETS_CALENDAR_UNSPECIFIED && EternalTimestampCalendar::quarter(partial[3]) == ETS_CALENDAR_UNSPECIFIED, "no quarter without a month");
+
+	// the month and day without the year
+	eternal_timestamp_t t = parse("2020-09-13");
+	t = ets_modern_set_year(t, ets_modern_year(parse("20")));
+	check(EternalTimestampCalendar::weekday(t) == ETS_CALENDAR_UNSPECIFIED && EternalTimestampCalendar::quarter(t) == 3, "no year");
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// the reference: count days
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static int64_t floor_div(int64_t v, int64_t d)
+{
+	return (v >= 0 ? v / d : -((-v + d - 1) / d));
+}
+
+// Days since 1970/jan/01.
+static int64_t days_from_civil(int64_t y, int m, int d)
+{
+	y -= m <= 2;
+	const int64_t era = floor_div(y, 400);
+	const int64_t yoe = y - era * 400;
+	const int64_t doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+	return era * 146097 + yoe * 365 + yoe / 4 - yoe / 100 + doy - 719468;
+}
+
+static int days_in_month(int64_t y, int m)
+{
+	switch (m) {
+	case 2:
+		return ((y % 4 == 0 && y % 100 != 0) || y % 400 == 0) ? 29 : 28;
+	case 4: case 6: case 9: case 11:
+		return 30;
+	default:
+		return 31;
+	}
+}
+
+struct expected_fields
+{
+	int weekday;
+	int day_of_year;
+	int week;
+	int32_t iso_year;
+};
+
+static expected_fields reference(int64_t y, int m, int d)
+{
+	expected_fields e;
+	const int64_t day = days_from_civil(y, m, d);
+	e.weekday = static_cast<int>(day + 3 - floor_div(day + 3, 7) * 7) + 1;
+	e.day_of_year = static_cast<int>(day - days_from_civil(y, 1, 1)) + 1;
+	// the week is the one of its Thursday, and so is the year
+	const int64_t thursday = day + 4 - e.weekday;
+	int64_t iso_year = y;
+	if (thursday < days_from_civil(y, 1, 1))
+		iso_year--;
+	else if (thursday >= days_from_civil(y + 1, 1, 1))
+		iso_year++;
+	e.week = static_cast<int>((thursday - days_from_civil(iso_year, 1, 1)) / 7) + 1;
+	e.iso_year = static_cast<int32_t>(iso_year);
+	return e;
+}
+
+static eternal_timestamp_t make(int64_t y, int m, int d)
+{
+	char text[80];
+	if (y < 0)
+		snprintf(text, sizeof(text), "-%04lld-%02d-%02d", static_cast<long long>(-y), m, d);
+	else if (y > 9999)
+		snprintf(text, sizeof(text), "+%lld-%02d-%02d", static_cast<long long>(y), m, d);
+	else
+		snprintf(text, sizeof(text), "%04lld-%02d-%02dT%02d:30", static_cast<long long>(y), m, d, d % 24);
+	return parse(text);
+}
+
+// Every day of [first, last], with a partial timestamp thrown in now and then.
+static void test_against_reference(int64_t first, int64_t last)
+{
+	std::vector<eternal_timestamp_t> column;
+	std::vector<expected_fields> expected;
+	const eternal_timestamp_t partial[] = { parse("2020-09"), parse("1999"), prehistoric(60000, 1) };
+	const expected_fields none = { 0, 0, 0, 0 };
+	size_t unspecified = 0;
+	for (int64_t y = first; y <= last; y++) {
+		for (int m = 1; m <= 12; m++) {
+			for (int d = 1; d <= days_in_month(y, m); d++) {
+				column.push_back(make(y, m, d));
+				expected.push_back(reference(y, m, d));
+				if ((y * 31 + m * 7 + d) % 97 == 0) {
+					column.push_back(partial[unspecified++ % 3]);
+					expected.push_back(none);
+				}
+			}
+		}
+	}
+
+	bool scalar_ok = true;
+	for (size_t i = 0; i < column.size(); i++) {
+		int32_t y = 0;
+		const expected_fields &e = expected[i];
+		scalar_ok = scalar_ok && EternalTimestampCalendar::weekday(column[i]) == e.weekday && EternalTimestampCalendar::day_of_year(column[i]) == e.day_of_year
+			&& EternalTimestampCalendar::iso_week(column[i], &y) == e.week && y == e.iso_year;
+	}
+	check(scalar_ok, "the derived fields");
+
+	const size_t n = column.size();
+	for (const unsigned int parallelism : { 1U, ETS_PARALLELISM_ALL }) {
+		std::vector<uint8_t> weekdays(n, 0xFF), weeks(n, 0xFF), quarters(n, 0xFF);
+		std::vector<uint16_t> days(n, 0xFFFF);
+		std::vector<int32_t> years(n, -1);
+		// the odd offsets and lengths keep the vector kernels' tails busy
+		check(EternalTimestampCalendar::calc_weekdays(weekdays.data() + 3, column.data() + 3, n - 5, parallelism) + EternalTimestampCalendar::calc_weekdays(weekdays.data(), column.data(), 3, parallelism)
+			+ EternalTimestampCalendar::calc_weekdays(weekdays.data() + n - 2, column.data() + n - 2, 2, parallelism) == unspecified, "calc_weekdays(): failures");
+		check(EternalTimestampCalendar::calc_days_of_year(days.data(), column.data(), n, parallelism) == unspecified, "calc_days_of_year(): failures");
+		check(EternalTimestampCalendar::calc_iso_weeks(weeks.data(), years.data(), column.data(), n, parallelism) == unspecified, "calc_iso_weeks(): failures");
+		check(EternalTimestampCalendar::calc_iso_weeks(weeks.data(), nullptr, column.data(), n, parallelism) == unspecified, "calc_iso_weeks(): no years");
+		EternalTimestampCalendar::calc_quarters(quarters.data(), column.data(), n, parallelism);
+
+		bool ok = true;
+		uint64_t histogram[8] = { 0 };
+		for (size_t i = 0; i < n; i++) {
+			const expected_fields &e = expected[i];
+			ok = ok && weekdays[i] == e.weekday && days[i] == e.day_of_year && weeks[i] == e.week && years[i] == e.iso_year
+				&& quarters[i] == EternalTimestampCalendar::quarter(column[i]);
+			histogram[e.weekday]++;
+		}
+		check(ok, "the batch calls");
+
+		uint64_t counts[8];
+		EternalTimestampCalendar::count_weekdays(counts, column.data(), n, parallelism);
+		check(memcmp(counts, histogram, sizeof(counts)) == 0 && counts[0] == unspecified, "count_weekdays()");
+	}
+}
+
+static void test_c_api()
+{
+	const eternal_timestamp_t t[3] = { parse("2021-01-01"), parse("2021-02"), parse("2021-12-31T23:59:59") };
+	int32_t y = 0;
+	check(ets_calendar_weekday(t[0]) == 5 && ets_calendar_day_of_year(t[2]) == 365 && ets_calendar_iso_week(t[0], &y) == 53 && y == 2020 && ets_calendar_quarter(t[1]) == 1, "the C API");
+
+	uint8_t weekdays[3], weeks[3], quarters[3];
+	uint16_t days[3];
+	int32_t years[3];
+	uint64_t counts[8];
+	check(ets_calendar_calc_weekdays(weekdays, t, 3) == 1 && weekdays[0] == 5 && weekdays[1] == 0 && weekdays[2] == 5, "ets_calendar_calc_weekdays()");
+	check(ets_calendar_calc_days_of_year(days, t, 3) == 1 && days[0] == 1 && days[1] == 0 && days[2] == 365, "ets_calendar_calc_days_of_year()");
+	check(ets_calendar_calc_iso_weeks(weeks, years, t, 3) == 1 && weeks[0] == 53 && years[0] == 2020 && weeks[1] == 0 && years[1] == 0 && weeks[2] == 52 && years[2] == 2021, "ets_calendar_calc_iso_weeks()");
+	check(ets_calendar_calc_quarters(quarters, t, 3) == 0 && quarters[0] == 1 && quarters[1] == 1 && quarters[2] == 4, "ets_calendar_calc_quarters()");
+	ets_calendar_count_weekdays(counts, t, 3);
+	check(counts[0] == 1 && counts[5] == 2 && counts[1] + counts[2] + counts[3] + counts[4] + counts[6] + counts[7] == 0, "ets_calendar_count_weekdays()");
+}
+
+
+#if defined(BUILD_MONOLITHIC)
+#define main(cnt, arr)      eternalty_test_calendar_main(cnt, arr)
+#endif
+
+int main(int argc, const char **argv)
+{
+	(void)argc;
+	(void)argv;
+
+	fprintf(stderr, "Eternal Timestamp Test (derived calendar fields)\n\n");
+
+	test_examples();
+	test_unspecified();
+	// a whole 400-year cycle and then some: all dates the vector kernel can meet
+	test_against_reference(1600, 2400);
+	test_against_reference(-9900, -9800);
+	test_against_reference(-5, 5);
+	test_against_reference(11990, 12010);
+	test_c_api();
+
+	if (failures) {
+		fprintf(stderr, "\n%d test(s) FAILED\n", failures);
+		return EXIT_FAILURE;
+	}
+	fprintf(stderr, "All tests passed\n");
+	return EXIT_SUCCESS;
+}
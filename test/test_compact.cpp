@@ -0,0 +1,288 @@
+#include <eternal_timestamp/eternal_timestamp.h>
+#include <eternal_timestamp/eternal_timestamp_batch.h>
+#include <eternal_timestamp/eternal_timestamp_compact.h>
+#include <eternal_timestamp/eternal_timestamp_parallel.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "monolithic_examples.h"
+
+
+using namespace eternal_timestamp;
+
+static int failures = 0;
+
+static void check(bool ok, const char *what)
+{
+	if (!ok) {
+		fprintf(stderr, "FAIL: %s\n", what);
+		failures++;
+	}
+}
+
+static eternal_timestamp_t parse(const char *iso8601)
+{
+	eternal_timestamp_t t;
+	t.t = 0;
+	EternalTimestamp::cvt_from_iso8601(t, iso8601, strlen(iso8601));
+	return t;
+}
+
+static int sign(int64_t x)
+{
+	return (x > 0) - (x < 0);
+}
+
+static bool bit(const std::vector<uint8_t> &validity, size_t i)
+{
+	return (validity[i / 8] >> (i % 8)) & 1;
+}
+
+// A column of timestamps: mostly ones which narrow to `want` (0: dates, 1: seconds), some which don't.
+static std::vector<eternal_timestamp_t> make_column(std::mt19937_64 &rng, size_t count, int want)
+{
+	static const char *const others[] = {
+		"2020", "2020-09", "2020-09-13", "2020-09-13T12", "2020-09-13T12:30", "2020-09-13T12:30:15",
+		"2016-12-31T23:59:60", "2020-09-13T12:30:15.250", "2020-09-13T12:30:15.250001", "-20000", "-12000-01-01",
+		"0001-01-01", "9999-12-31T23:59:59",
+	};
+	std::vector<eternal_timestamp_t> column(count);
+	for (size_t i = 0; i < count; i++) {
+		const uint64_t r = rng();
+		if (r % 8 == 0) {
+			column[i] = parse(others[(r >> 8) % (sizeof(others) / sizeof(others[0]))]);
+		} else if (want == 0) {
+			const int32_t days = static_cast<int32_t>((r >> 8) % 40000) - 5000;
+			EternalTimestampBatch::cvt_from_unix_days(&column[i], nullptr, &days, 1, 1);
+		} else {
+			const int64_t seconds = static_cast<int64_t>((r >> 8) % 4000000000ULL) - 500000000;
+			EternalTimestampBatch::cvt_from_unix_seconds(&column[i], nullptr, &seconds, 1, 1);
+		}
+	}
+	return column;
+}
+
+static void test_single_values()
+{
+	struct
+	{
+		const char *text;
+		bool date32;
+		bool datetime48;
+	} const cases[] = {
+		{ "2020-09-13", true, true },
+		{ "2020-09-13T00:00:00.000000", true, true },
+		{ "2020", true, true },
+		{ "2020-09", true, true },
+		{ "2020-09-13T12:30:15", false, true },
+		{ "2020-09-13T12:30:15.000000", false, true },
+		{ "2020-09-13T12", false, true },
+		{ "2016-12-31T23:59:60", false, true },
+		{ "2020-09-13T00:00:00", false, true },
+		{ "2020-09-13T12:30:15.250", false, false },
+		{ "2020-09-13T12:30:15.000001", false, false },
+		{ "2020-09-13T00:00:00.000", false, false },
+		{ "-20000", false, false },
+		{ "-12000-01-01", false, false },
+	};
+	bool date32_ok = true, datetime48_ok = true;
+	for (const auto &c : cases) {
+		const eternal_timestamp_t t = parse(c.text);
+		eternal_timestamp_t back;
+		ets_date32_t d;
+		if (EternalTimestampCompact::narrow_date32(d, t) != (c.date32 ? 0 : -1)) {
+			fprintf(stderr, "  narrow_date32(%s)\n", c.text);
+			date32_ok = false;
+		} else if (c.date32 && (EternalTimestampCompact::widen_date32(back, d) != 0 || back.t != t.t)) {
+			fprintf(stderr, "  widen_date32(narrow_date32(%s))\n", c.text);
+			date32_ok = false;
+		} else if (!c.date32 && d != 0) {
+			date32_ok = false;
+		}
+		ets_datetime48_t s;
+		if (EternalTimestampCompact::narrow_datetime48(s, t) != (c.datetime48 ? 0 : -1)) {
+			fprintf(stderr, "  narrow_datetime48(%s)\n", c.text);
+			datetime48_ok = false;
+		} else if (c.datetime48 && (EternalTimestampCompact::widen_datetime48(back, s) != 0 || back.t != t.t)) {
+			fprintf(stderr, "  widen_datetime48(narrow_datetime48(%s))\n", c.text);
+			datetime48_ok = false;
+		} else if (!c.datetime48 && ets_datetime48_value(s) != 0) {
+			datetime48_ok = false;
+		}
+	}
+	check(date32_ok, "narrow_date32() / widen_date32()");
+	check(datetime48_ok, "narrow_datetime48() / widen_datetime48()");
+
+	// the stored layout
+	ets_date32_t d;
+	EternalTimestampCompact::narrow_date32(d, parse("2020-09-13"));
+	check(d >> 26 == 0 && ((d >> 1) & 31) == 13 && ((d >> 6) & 15) == 9 && (d & 1) == 0, "ets_date32_t layout");
+	ets_datetime48_t s;
+	EternalTimestampCompact::narrow_datetime48(s, parse("2020-09-13T12:30:15.000000"));
+	check(s.bytes[0] >> 3 == 0 && (s.bytes[5] & 1) == 1 && ((s.bytes[5] >> 1) & 63) == 16, "ets_datetime48_t layout");
+
+	// stray bits
+	eternal_timestamp_t back;
+	check(EternalTimestampCompact::widen_date32(back, 1U << 26) == -1 && !EternalTimestamp::has_century(back), "widen_date32(): stray bits");
+	ets_datetime48_t bad = { { 0x08, 0, 0, 0, 0, 0 } };
+	check(EternalTimestampCompact::widen_datetime48(back, bad) == -1 && !EternalTimestamp::has_century(back), "widen_datetime48(): stray bits");
+}
+
+// The narrow forms compare like the sort keys of what they encode.
+static void test_order()
+{
+	std::mt19937_64 rng(7);
+	for (int want = 0; want < 2; want++) {
+		const auto column = make_column(rng, 4000, want);
+		bool ok = true;
+		for (size_t i = 0; i < column.size(); i++) {
+			const eternal_timestamp_t a = column[i];
+			const eternal_timestamp_t b = column[rng() % column.size()];
+			const int expected = sign(EternalTimestamp::calc_sort_key(a) - EternalTimestamp::calc_sort_key(b));
+			if (want == 0) {
+				ets_date32_t x, y;
+				if (EternalTimestampCompact::narrow_date32(x, a) == 0 && EternalTimestampCompact::narrow_date32(y, b) == 0)
+					ok &= ((x > y) - (x < y) == expected);
+			} else {
+				ets_datetime48_t x, y;
+				if (EternalTimestampCompact::narrow_datetime48(x, a) == 0 && EternalTimestampCompact::narrow_datetime48(y, b) == 0) {
+					ok &= (ets_datetime48_compare(x, y) == expected);
+					ok &= (sign(memcmp(x.bytes, y.bytes, sizeof(x.bytes))) == expected);
+				}
+			}
+		}
+		check(ok, want == 0 ? "ets_date32_t order" : "ets_datetime48_t order");
+	}
+
+	// midnight and the unspecified time of day, the same second with and without its .000000
+	ets_date32_t x, y;
+	EternalTimestampCompact::narrow_date32(x, parse("2020-09-13"));
+	EternalTimestampCompact::narrow_date32(y, parse("2020-09-13T00:00:00.000000"));
+	check(x < y, "ets_date32_t order: the unspecified time of day first");
+	ets_datetime48_t u, v;
+	EternalTimestampCompact::narrow_datetime48(u, parse("2020-09-13T12:30:15"));
+	EternalTimestampCompact::narrow_datetime48(v, parse("2020-09-13T12:30:15.000000"));
+	check(ets_datetime48_compare(u, v) < 0, "ets_datetime48_t order: the unspecified sub-seconds first");
+}
+
+// The batch kernels against the single value functions, for all lengths around the vector width.
+static void test_batch()
+{
+	std::mt19937_64 rng(42);
+	bool date32_ok = true, datetime48_ok = true;
+	std::vector<size_t> lengths;
+	for (size_t n = 0; n <= 40; n++)
+		lengths.push_back(n);
+	lengths.push_back(10007);
+	lengths.push_back(3 * ETS_PARALLEL_GRAIN + 13);
+
+	for (size_t n : lengths) {
+		for (int want = 0; want < 2; want++) {
+			const auto column = make_column(rng, n, want);
+			std::vector<uint8_t> validity((n + 7) / 8, 0x5A);
+			std::vector<uint8_t> widened_validity((n + 7) / 8, 0xA5);
+			std::vector<eternal_timestamp_t> widened(n);
+
+			size_t expected_failures = 0;
+			if (want == 0) {
+				std::vector<ets_date32_t> narrow(n);
+				const size_t failed = EternalTimestampCompact::narrow_date32_batch(narrow.data(), validity.data(), column.data(), n, ETS_PARALLELISM_ALL);
+				bool ok = true;
+				for (size_t i = 0; i < n; i++) {
+					ets_date32_t d;
+					const bool valid = (EternalTimestampCompact::narrow_date32(d, column[i]) == 0);
+					expected_failures += !valid;
+					ok &= (d == narrow[i] && bit(validity, i) == valid);
+				}
+				ok &= (failed == expected_failures);
+
+				const size_t widen_failed = EternalTimestampCompact::widen_date32_batch(widened.data(), widened_validity.data(), narrow.data(), n, ETS_PARALLELISM_ALL);
+				ok &= (widen_failed == 0);
+				for (size_t i = 0; i < n; i++)
+					ok &= (bit(widened_validity, i) && (!bit(validity, i) || widened[i].t == column[i].t));
+
+				// corrupt values widen to 'unknown'
+				if (n) {
+					narrow[n - 1] |= 0x80000000U;
+					ok &= (EternalTimestampCompact::widen_date32_batch(widened.data(), widened_validity.data(), narrow.data(), n, 1) == 1);
+					ok &= (!bit(widened_validity, n - 1) && !EternalTimestamp::has_century(widened[n - 1]));
+				}
+				date32_ok &= ok;
+			} else {
+				std::vector<ets_datetime48_t> narrow(n);
+				const size_t failed = EternalTimestampCompact::narrow_datetime48_batch(narrow.data(), validity.data(), column.data(), n, ETS_PARALLELISM_ALL);
+				bool ok = true;
+				for (size_t i = 0; i < n; i++) {
+					ets_datetime48_t s;
+					const bool valid = (EternalTimestampCompact::narrow_datetime48(s, column[i]) == 0);
+					expected_failures += !valid;
+					ok &= (memcmp(s.bytes, narrow[i].bytes, sizeof(s.bytes)) == 0 && bit(validity, i) == valid);
+				}
+				ok &= (failed == expected_failures);
+
+				const size_t widen_failed = EternalTimestampCompact::widen_datetime48_batch(widened.data(), widened_validity.data(), narrow.data(), n, ETS_PARALLELISM_ALL);
+				ok &= (widen_failed == 0);
+				for (size_t i = 0; i < n; i++)
+					ok &= (bit(widened_validity, i) && (!bit(validity, i) || widened[i].t == column[i].t));
+
+				if (n) {
+					narrow[0].bytes[0] = 0xFF;
+					ok &= (EternalTimestampCompact::widen_datetime48_batch(widened.data(), widened_validity.data(), narrow.data(), n, 1) == 1);
+					ok &= (!bit(widened_validity, 0) && !EternalTimestamp::has_century(widened[0]));
+				}
+				datetime48_ok &= ok;
+			}
+		}
+	}
+	check(date32_ok, "narrow_date32_batch() / widen_date32_batch()");
+	check(datetime48_ok, "narrow_datetime48_batch() / widen_datetime48_batch()");
+
+	// no validity bitmap
+	const auto column = make_column(rng, 100, 1);
+	std::vector<ets_datetime48_t> narrow(column.size());
+	std::vector<uint8_t> validity((column.size() + 7) / 8);
+	check(EternalTimestampCompact::narrow_datetime48_batch(narrow.data(), nullptr, column.data(), column.size()) == EternalTimestampCompact::narrow_datetime48_batch(narrow.data(), validity.data(), column.data(), column.size()), "narrow_datetime48_batch(): NULL validity");
+}
+
+static void test_c_interface()
+{
+	const eternal_timestamp_t t = parse("2020-09-13T12:30:15");
+	eternal_timestamp_t back;
+	ets_date32_t d;
+	ets_datetime48_t s;
+	check(ets_compact_narrow_date32(&d, parse("2020-09-13")) == 0 && ets_compact_widen_date32(&back, d) == 0 && back.t == parse("2020-09-13").t, "ets_compact_narrow_date32() / ets_compact_widen_date32()");
+	check(ets_compact_narrow_date32(&d, t) == -1, "ets_compact_narrow_date32(): time of day");
+	check(ets_compact_narrow_datetime48(&s, t) == 0 && ets_compact_widen_datetime48(&back, s) == 0 && back.t == t.t, "ets_compact_narrow_datetime48() / ets_compact_widen_datetime48()");
+	check(ets_compact_narrow_date32_batch(&d, nullptr, &t, 1) == 1, "ets_compact_narrow_date32_batch()");
+	check(ets_compact_widen_date32_batch(&back, nullptr, &d, 1) == 0, "ets_compact_widen_date32_batch()");
+	check(ets_compact_narrow_datetime48_batch(&s, nullptr, &t, 1) == 0, "ets_compact_narrow_datetime48_batch()");
+	check(ets_compact_widen_datetime48_batch(&back, nullptr, &s, 1) == 0 && back.t == t.t, "ets_compact_widen_datetime48_batch()");
+}
+
+
+#if defined(BUILD_MONOLITHIC)
+#define main(cnt, arr)      eternalty_test_compact_main(cnt, arr)
+#endif
+
+int main(int argc, const char **argv)
+{
+	(void)argc;
+	(void)argv;
+
+	fprintf(stderr, "Eternal Timestamp Test (compact encodings)\n\n");
+
+	test_single_values();
+	test_order();
+	test_batch();
+	test_c_interface();
+
+	if (failures) {
+		fprintf(stderr, "\n%d test(s) FAILED\n", failures);
+		return EXIT_FAILURE;
+	}
+	fprintf(stderr, "All tests passed\n");
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,212 @@
+#include <eternal_timestamp/eternal_timestamp.h>
+#include <eternal_timestamp/eternal_timestamp_endian.h>
+#include <eternal_timestamp/eternal_timestamp_parallel.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "monolithic_examples.h"
+
+
+using namespace eternal_timestamp;
+
+static int failures = 0;
+
+static void check(bool ok, const char *what)
+{
+	if (!ok) {
+		fprintf(stderr, "FAIL: %s\n", what);
+		failures++;
+	}
+}
+
+static eternal_timestamp_t make(uint64_t v)
+{
+	eternal_timestamp_t t;
+	t.t = v;
+	return t;
+}
+
+// The bytes of `v` in byte order `order`, spelled out independently of the host's.
+static void put_bytes(uint8_t *p, uint64_t v, ets_byte_order_t order)
+{
+	for (int i = 0; i < 8; i++)
+		p[order == ETS_BYTE_ORDER_BIG ? 7 - i : i] = static_cast<uint8_t>(v >> (8 * i));
+}
+
+static const uint64_t sample = 0x0102030405060708ULL;
+
+static void test_single_values()
+{
+	const uint8_t le[8] = { 8, 7, 6, 5, 4, 3, 2, 1 };
+	const uint8_t be[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+	check(ets_bswap64(sample) == 0x0807060504030201ULL, "ets_bswap64");
+
+	// at every alignment
+	uint8_t buf[8 + 16];
+	for (int offset = 0; offset < 16; offset++) {
+		memset(buf, 0xEE, sizeof(buf));
+		ets_store_timestamp(buf + offset, make(sample), ETS_BYTE_ORDER_LITTLE);
+		check(memcmp(buf + offset, le, 8) == 0 && ets_load_timestamp(buf + offset, ETS_BYTE_ORDER_LITTLE).t == sample, "little-endian");
+		check(ets_load_timestamp(buf + offset, ETS_BYTE_ORDER_BIG).t == ets_bswap64(sample), "little-endian read as big-endian");
+		ets_store_timestamp(buf + offset, make(sample), ETS_BYTE_ORDER_BIG);
+		check(memcmp(buf + offset, be, 8) == 0 && ets_load_timestamp(buf + offset, ETS_BYTE_ORDER_BIG).t == sample, "big-endian");
+		check(buf[offset + 8] == 0xEE && (offset == 0 || buf[offset - 1] == 0xEE), "no stray writes");
+	}
+
+	// the 'network' format is little-endian
+	const eternal_timestamp_t n = EternalTimestamp::hton(make(sample));
+	check(memcmp(&n.t, le, 8) == 0 && EternalTimestamp::ntoh(n).t == sample, "hton / ntoh");
+	check(EternalTimestamp::ntoh_is_an_empty_op(n) == (ETS_BYTE_ORDER_NATIVE == ETS_BYTE_ORDER_LITTLE), "ntoh_is_an_empty_op");
+	check(ets_ntoh(ets_hton(make(sample))).t == sample, "ets_hton / ets_ntoh");
+}
+
+// The views, in both byte orders: on any host one of them is the byte-swapped layout.
+template <ets_byte_order_t Order>
+static void test_views(const char *name)
+{
+	std::mt19937_64 rng(45);
+	const size_t count = 1000;
+	std::vector<uint64_t> values(count);
+	for (auto &v : values)
+		v = rng();
+
+	// packed records of 13 bytes, the timestamp 3 bytes in: every value is misaligned somehow
+	const size_t stride = 13;
+	std::vector<uint8_t> records(count * stride + 1, 0xEE);
+	uint8_t *const base = records.data() + 1;
+	for (size_t i = 0; i < count; i++)
+		put_bytes(base + i * stride + 3, values[i], Order);
+
+	const EternalTimestampBytesView<Order> view(base + 3, count, stride);
+	bool ok = (view.size() == count && !view.empty() && view.stride() == stride);
+	for (size_t i = 0; i < count; i++)
+		ok = ok && view[i].t == values[i];
+	check(ok, name);
+
+	size_t n = 0;
+	ok = true;
+	for (const eternal_timestamp_t t : view)
+		ok = ok && t.t == values[n++];
+	check(ok && n == count, "iteration");
+
+	const EternalTimestampBytesView<Order> sub = view.subview(10, 5);
+	check(sub.size() == 5 && sub[0].t == values[10] && sub[4].t == values[14], "subview");
+
+	std::vector<eternal_timestamp_t> copy(count);
+	view.copy_to(copy.data());
+	ok = true;
+	for (size_t i = 0; i < count; i++)
+		ok = ok && copy[i].t == values[i];
+	check(ok, "copy_to, strided");
+
+	// writes through the view, leaving the bytes around the values alone
+	const EternalTimestampMutableBytesView<Order> out(base + 3, count, stride);
+	std::vector<uint8_t> before = records;
+	for (size_t i = 0; i < count; i++)
+		out[i] = make(~values[i]);
+	ok = true;
+	for (size_t i = 0; i < count; i++) {
+		uint8_t expected[8];
+		put_bytes(expected, ~values[i], Order);
+		ok = ok && memcmp(base + i * stride + 3, expected, 8) == 0 && out.get(i).t == ~values[i];
+	}
+	check(ok, "writes");
+	for (size_t i = 0; i < count; i++) {
+		memset(&before[1 + i * stride + 3], 0, 8);
+		memset(&records[1 + i * stride + 3], 0, 8);
+	}
+	check(before == records, "the bytes between the values are left alone");
+
+	out.copy_from(copy.data());
+	out[1] = out[0];
+	out.set(2, make(sample));
+	const EternalTimestampBytesView<Order> back = out;
+	check(back[0].t == values[0] && back[1].t == values[0] && back[2].t == sample && back[3].t == values[3], "copy_from / operator= / set");
+}
+
+// The bulk conversions against the single value ones, at all alignments, tail lengths and byte orders.
+static void test_bulk()
+{
+	std::mt19937_64 rng(4545);
+	for (size_t count : { 0, 1, 2, 3, 4, 5, 7, 8, 9, 31, 100, 3 * ETS_PARALLEL_GRAIN + 17 }) {
+		std::vector<uint64_t> values(count);
+		std::vector<eternal_timestamp_t> src(count);
+		for (size_t i = 0; i < count; i++)
+			src[i].t = values[i] = rng();
+
+		for (size_t offset : { 0, 1, 3, 8 }) {
+			std::vector<uint8_t> buf(count * 8 + offset + 8);
+			uint8_t *const p = buf.data() + offset;
+
+			for (const ets_byte_order_t order : { ETS_BYTE_ORDER_LITTLE, ETS_BYTE_ORDER_BIG }) {
+				EternalTimestampEndian::store(p, src.data(), count, order, 8, ETS_PARALLELISM_ALL);
+				bool ok = true;
+				for (size_t i = 0; i < count; i++) {
+					uint8_t expected[8];
+					put_bytes(expected, values[i], order);
+					ok = ok && memcmp(p + i * 8, expected, 8) == 0;
+				}
+				check(ok, order == ETS_BYTE_ORDER_BIG ? "store, big-endian" : "store, little-endian");
+
+				std::vector<eternal_timestamp_t> dst(count);
+				EternalTimestampEndian::load(dst.data(), p, count, order, 8, ETS_PARALLELISM_ALL);
+				check(std::equal(src.begin(), src.end(), dst.begin(), [](eternal_timestamp_t a, eternal_timestamp_t b) { return a.t == b.t; }), "load");
+			}
+
+			// byte-swapped, in place and to another buffer
+			for (size_t i = 0; i < count; i++)
+				put_bytes(p + i * 8, values[i], ETS_BYTE_ORDER_LITTLE);
+			std::vector<uint8_t> other(count * 8 + 1);
+			ets_endian_byteswap(other.data() + 1, p, count);
+			EternalTimestampEndian::byteswap(p, p, count, ETS_PARALLELISM_ALL);
+			bool ok = true;
+			for (size_t i = 0; i < count; i++) {
+				uint8_t expected[8];
+				put_bytes(expected, values[i], ETS_BYTE_ORDER_BIG);
+				ok = ok && memcmp(p + i * 8, expected, 8) == 0 && memcmp(other.data() + 1 + i * 8, expected, 8) == 0;
+			}
+			check(ok, "byteswap");
+		}
+	}
+
+	// the C interface, strided
+	std::vector<uint8_t> records(10 * 12);
+	std::vector<eternal_timestamp_t> src(10), dst(10);
+	for (int i = 0; i < 10; i++)
+		src[i].t = sample * i;
+	ets_endian_store(records.data(), src.data(), 10, ETS_BYTE_ORDER_BIG, 12);
+	ets_endian_load(dst.data(), records.data(), 10, ETS_BYTE_ORDER_BIG, 12);
+	bool ok = true;
+	for (int i = 0; i < 10; i++)
+		ok = ok && dst[i].t == sample * i && ets_load_timestamp(&records[i * 12], ETS_BYTE_ORDER_BIG).t == sample * i;
+	check(ok, "ets_endian_store / ets_endian_load");
+}
+
+
+#if defined(BUILD_MONOLITHIC)
+#define main(cnt, arr)      eternalty_test_endian_main(cnt, arr)
+#endif
+
+int main(int argc, const char **argv)
+{
+	(void)argc;
+	(void)argv;
+
+	fprintf(stderr, "Eternal Timestamp Test (byte order)\n\n");
+
+	test_single_values();
+	test_views<ETS_BYTE_ORDER_LITTLE>("little-endian view");
+	test_views<ETS_BYTE_ORDER_BIG>("big-endian view");
+	test_bulk();
+
+	if (failures) {
+		fprintf(stderr, "\n%d test(s) FAILED\n", failures);
+		return EXIT_FAILURE;
+	}
+	fprintf(stderr, "All tests passed\n");
+	return EXIT_SUCCESS;
+}
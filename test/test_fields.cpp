@@ -0,0 +1,175 @@
+#include <eternal_timestamp/eternal_timestamp.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+#include "monolithic_examples.h"
+
+
+using namespace eternal_timestamp;
+
+static int failures = 0;
+
+static void check(bool ok, const char *what)
+{
+	if (!ok) {
+		fprintf(stderr, "FAIL: %s\n", what);
+		failures++;
+	}
+}
+
+static eternal_timestamp_t parse(const char *iso8601)
+{
+	eternal_timestamp_t t;
+	t.t = 0;
+	EternalTimestamp::cvt_from_iso8601(t, iso8601, strlen(iso8601));
+	return t;
+}
+
+static const char *const samples[] = {
+	"2020", "2020-09", "2020-09-13", "2020-09-13T12", "2020-09-13T12:30", "2020-09-13T12:30:15",
+	"2020-09-13T12:30:15.250", "2020-09-13T12:30:15.250001", "2016-12-31T23:59:60", "1970-01-01T00:00:00",
+	"0001-01-01", "-0044-03-15", "-9000-06-01T06", "-12000-01-01", "-12000-01-01T06:30", "-20000", "-5000000",
+};
+
+// 2020-09-13T12:30:15.250001 and -12000-01-01T06:30, put together from their codes.
+static constexpr eternal_timestamp_t modern_sample = { (120ULL << ETMT_CENTURY_SHIFT) | (21ULL << ETMT_YEAR_SHIFT) | (9ULL << ETMT_MONTH_SHIFT) | (13ULL << ETMT_DAY_SHIFT) | (13ULL << ETMT_HOUR_SHIFT) | (31ULL << ETMT_MINUTE_SHIFT) | (16ULL << ETMT_SECONDS_SHIFT) | (251ULL << ETMT_MILLISECONDS_SHIFT) | (2ULL << ETMT_MICROSECONDS_SHIFT) };
+static constexpr eternal_timestamp_t prehistoric_sample = { (1ULL << ETS_MODE_SHIFT) | (12000ULL << ETPHT_YEARS_SHIFT) | (1ULL << ETPHT_MONTH_SHIFT) | (1ULL << ETPHT_DAY_SHIFT) | (7ULL << ETPHT_HOUR_SHIFT) | (31ULL << ETPHT_MINUTE_SHIFT) };
+
+// The accessors and predicates are usable in constant expressions.
+static_assert(ets_modern_century(modern_sample) == 120 && ets_modern_microseconds(modern_sample) == 2, "modern accessors");
+static_assert(ets_prehistoric_years(prehistoric_sample) == 12000 && ets_prehistoric_minute(prehistoric_sample) == 31, "prehistoric accessors");
+static_assert(ets_modern_set_microseconds(modern_sample, 0).t == (modern_sample.t & ~(1023ULL << ETMT_MICROSECONDS_SHIFT)), "setters");
+static_assert(ets_modern_set_hour(modern_sample, 32).t == ets_modern_set_hour(modern_sample, 0).t, "setters keep to their field");
+static_assert(EternalTimestamp::is_modern_format(modern_sample) && EternalTimestamp::is_prehistoric_format(prehistoric_sample), "format predicates");
+static_assert(EternalTimestamp::has_time(modern_sample) && EternalTimestamp::has_complete_date(prehistoric_sample), "field predicates");
+static_assert(!EternalTimestamp::has_seconds(prehistoric_sample) && EternalTimestamp::has_hh_mm_ss(prehistoric_sample), "prehistoric timestamps lack seconds");
+static_assert(!EternalTimestamp::has_age(EternalTimestamp::unknown()) && !EternalTimestamp::has_month(EternalTimestamp::unknown()), "unknown()");
+#if defined(ETS_HEADER_ONLY)
+static_assert(ets_has_century(modern_sample) && !ets_has_year(ets_unknown()), "the C predicates are inline in header-only builds");
+#endif
+
+// The accessors read what the bitfields hold (the modern bitfields are laid out alike by all compilers).
+static void test_accessors()
+{
+	std::mt19937_64 rng(43);
+	for (int i = 0; i < 10000; i++) {
+		eternal_timestamp_t t;
+		t.t = rng() & ~3ULL;
+		check(ets_format_sign(t) == 0 && ets_format_mode(t) == 0, "format bits");
+		check(ets_modern_century(t) == t.modern.century, "century");
+		check(ets_modern_year(t) == t.modern.year, "year");
+		check(ets_modern_month(t) == t.modern.month, "month");
+		check(ets_modern_day(t) == t.modern.day, "day");
+		check(ets_modern_hour(t) == t.modern.hour, "hour");
+		check(ets_modern_minute(t) == t.modern.minute, "minute");
+		check(ets_modern_seconds(t) == t.modern.seconds, "seconds");
+		check(ets_modern_milliseconds(t) == t.modern.milliseconds, "milliseconds");
+		check(ets_modern_microseconds(t) == t.modern.microseconds, "microseconds");
+	}
+
+	// the setters touch their own field only, and write all of it.
+	eternal_timestamp_t t;
+	t.t = ~0ULL;
+	t = ets_prehistoric_set_years(t, 0);
+	check(t.t == ~(((1ULL << ETPHT_YEARS_BITS) - 1) << ETPHT_YEARS_SHIFT), "prehistoric_set_years");
+	t = ets_prehistoric_set_years(t, 48000);
+	check(ets_prehistoric_years(t) == 48000 && ets_prehistoric_month(t) == 15 && ets_format_mode(t) == 1, "prehistoric_set_years round trip");
+	t.t = 0;
+	t = ets_prehistoric_set_precision(t, 5);
+	t = ets_format_set_mode(t, 1);
+	check(t.t == ((5ULL << 60) | 2), "prehistoric_set_precision");
+	check(ets_prehistoric_precision(t) == 5 && ets_prehistoric_years(t) == 0, "prehistoric_precision");
+}
+
+// The predicates against the fields of parsed timestamps.
+static void test_predicates()
+{
+	for (const char *s : samples) {
+		const eternal_timestamp_t t = parse(s);
+		const bool modern = !ets_format_mode(t);
+		check(EternalTimestamp::is_modern_format(t) == modern, s);
+		check(EternalTimestamp::is_prehistoric_format(t) == !modern, s);
+
+		if (modern) {
+			check(EternalTimestamp::has_century(t) == (ets_modern_century(t) != ETS_UNSPECIFIED_CODE(ETMT_CENTURY_BITS)), s);
+			check(EternalTimestamp::has_month(t) == (strlen(s) >= 7), s);
+			check(EternalTimestamp::has_day(t) == (strlen(s) >= 10), s);
+			check(EternalTimestamp::has_hour(t) == (strlen(s) >= 13), s);
+			check(EternalTimestamp::has_minute(t) == (strlen(s) >= 16), s);
+			check(EternalTimestamp::has_seconds(t) == (strlen(s) >= 19), s);
+			check(EternalTimestamp::has_microseconds(t) == (strlen(s) >= 26), s);
+			check(EternalTimestamp::has_complete_date(t) == (strlen(s) >= 10), s);
+			check(EternalTimestamp::has_hh_mm_ss(t) == (strlen(s) >= 19), s);
+		} else {
+			check(EternalTimestamp::has_age(t), s);
+			check(!EternalTimestamp::has_seconds(t) && !EternalTimestamp::has_milliseconds(t), s);
+			check(EternalTimestamp::has_hour(t) == (strchr(s, 'T') != NULL), s);
+			check(EternalTimestamp::has_time(t) == (strchr(s, ':') != NULL), s);
+			check(EternalTimestamp::has_complete_date(t) == (strlen(s) >= 11), s);
+		}
+	}
+
+	// prehistoric years known to the century or the millennium only.
+	eternal_timestamp_t t = parse("-5000000");
+	t = ets_prehistoric_set_precision(t, 2);
+	check(EternalTimestamp::has_century(t) && !EternalTimestamp::has_year(t) && !EternalTimestamp::has_complete_date(t), "precision 2");
+	t = ets_prehistoric_set_precision(t, 3);
+	check(!EternalTimestamp::has_century(t) && EternalTimestamp::has_age(t), "precision 3");
+}
+
+// The C interface, be it the library's functions or the header-only ones.
+static void test_c_interface()
+{
+	std::mt19937_64 rng(4343);
+	for (int i = 0; i < 10000; i++) {
+		eternal_timestamp_t t;
+		t.t = rng() & ~1ULL;
+		check(!ets_has_century(t) == !EternalTimestamp::has_century(t), "ets_has_century");
+		check(!ets_has_year(t) == !EternalTimestamp::has_year(t), "ets_has_year");
+		check(!ets_has_century_and_year(t) == !EternalTimestamp::has_century_and_year(t), "ets_has_century_and_year");
+		check(!ets_has_age(t) == !EternalTimestamp::has_age(t), "ets_has_age");
+		check(!ets_has_month(t) == !EternalTimestamp::has_month(t), "ets_has_month");
+		check(!ets_has_day(t) == !EternalTimestamp::has_day(t), "ets_has_day");
+		check(!ets_has_hour(t) == !EternalTimestamp::has_hour(t), "ets_has_hour");
+		check(!ets_has_minute(t) == !EternalTimestamp::has_minute(t), "ets_has_minute");
+		check(!ets_has_seconds(t) == !EternalTimestamp::has_seconds(t), "ets_has_seconds");
+		check(!ets_has_milliseconds(t) == !EternalTimestamp::has_milliseconds(t), "ets_has_milliseconds");
+		check(!ets_has_microseconds(t) == !EternalTimestamp::has_microseconds(t), "ets_has_microseconds");
+		check(!ets_has_complete_date(t) == !EternalTimestamp::has_complete_date(t), "ets_has_complete_date");
+		check(!ets_has_time(t) == !EternalTimestamp::has_time(t), "ets_has_time");
+		check(!ets_has_hh_mm_ss(t) == !EternalTimestamp::has_hh_mm_ss(t), "ets_has_hh_mm_ss");
+		check(!ets_is_modern_format(t) == !EternalTimestamp::is_modern_format(t), "ets_is_modern_format");
+		check(!ets_is_prehistoric_format(t) == !EternalTimestamp::is_prehistoric_format(t), "ets_is_prehistoric_format");
+	}
+
+	const eternal_timestamp_t u = ets_unknown();
+	check(u.t == EternalTimestamp::unknown().t, "ets_unknown");
+	check(!ets_has_age(u) && !ets_has_month(u) && !ets_has_day(u) && !ets_has_hour(u) && !ets_has_minute(u), "ets_unknown fields");
+	check(!ets_has_seconds(u) && !ets_has_milliseconds(u) && !ets_has_microseconds(u) && ets_is_modern_format(u), "ets_unknown subformat");
+}
+
+
+#if defined(BUILD_MONOLITHIC)
+#define main(cnt, arr)      eternalty_test_fields_main(cnt, arr)
+#endif
+
+int main(int argc, const char **argv)
+{
+	(void)argc;
+	(void)argv;
+
+	fprintf(stderr, "Eternal Timestamp Test (field accessors)\n\n");
+
+	test_accessors();
+	test_predicates();
+	test_c_interface();
+
+	if (failures) {
+		fprintf(stderr, "\n%d test(s) FAILED\n", failures);
+		return EXIT_FAILURE;
+	}
+	fprintf(stderr, "All tests passed\n");
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,184 @@
+
+#include <eternal_timestamp/eternal_timestamp.h>
+#include <eternal_timestamp/eternal_timestamp_format.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "monolithic_examples.h"
+
+
+using namespace eternal_timestamp;
+
+static int failures = 0;
+
+static eternal_timestamp_t iso(const char *str)
+{
+	eternal_timestamp_t t{0};
+	if (EternalTimestamp::cvt_from_iso8601(t, str, strlen(str))) {
+		fprintf(stderr, "FAIL: cannot parse test input '%s'\n", str);
+		failures++;
+	}
+	return t;
+}
+
+// `years` counts back from 0 AD; `precision` is the power of 10 the age is known to.
+static eternal_timestamp_t prehistoric(uint64_t years, unsigned precision)
+{
+	eternal_timestamp_t t{0};
+	t = ets_format_set_mode(t, 1);
+	t = ets_prehistoric_set_years(t, years);
+	t = ets_prehistoric_set_precision(t, precision);
+	return t;
+}
+
+static void check(const char *pattern, const eternal_timestamp_t t, const char *expected)
+{
+	ets_format_pattern_t fmt;
+	size_t error_offset = 0;
+	if (EternalTimestampFormat::compile(fmt, pattern, &error_offset)) {
+		fprintf(stderr, "FAIL: pattern '%s' rejected at offset %zu\n", pattern, error_offset);
+		failures++;
+		return;
+	}
+
+	char buf[256];
+	const size_t n = EternalTimestampFormat::format(buf, sizeof(buf), fmt, t);
+	if (n != strlen(expected) || strcmp(buf, expected) || n > fmt.max_length) {
+		fprintf(stderr, "FAIL: pattern '%s'\n  expected: '%s'\n  actual:   '%s' (%zu characters, max %u)\n", pattern, expected, buf, n, fmt.max_length);
+		failures++;
+	}
+}
+
+static void check_rejected(const char *pattern, size_t expected_offset)
+{
+	ets_format_pattern_t fmt;
+	size_t error_offset = ~size_t(0);
+	if (!EternalTimestampFormat::compile(fmt, pattern, &error_offset) || error_offset != expected_offset) {
+		fprintf(stderr, "FAIL: pattern '%s' should be rejected at offset %zu; error offset: %zu\n", pattern, expected_offset, error_offset);
+		failures++;
+	}
+}
+
+
+#if defined(BUILD_MONOLITHIC)
+#define main(cnt, arr)      eternalty_test_format_main(cnt, arr)
+#endif
+
+int main(int argc, const char **argv)
+{
+	fprintf(stderr, "Eternal Timestamp Test (format patterns)\n\n");
+
+	const eternal_timestamp_t t = iso("2022-01-13T12:40:31.049352");
+
+	check("%Y-%m-%d %H:%M:%S.%f", t, "2022-01-13 12:40:31.049352");
+	check("%FT%T", t, "2022-01-13T12:40:31");
+	check("%d %b %Y, %I:%M %p", t, "13 Jan 2022, 12:40 PM");
+	check("%e %B %y", iso("1922-09-03T00:05"), " 3 September 22");
+	check("%I%p", iso("1922-09-03T00:05"), "12AM");
+	check("%C/%y", t, "20/22");
+	check("%3f %6f", t, "049 049352");
+	check("100%% [sic]", t, "100% sic");
+	check("100%% %[sic%]", t, "100% [sic]");
+	check("%|", t, "|");
+
+	// unspecified fields
+	check("%F %T", iso("2022-01"), "2022-01-?? ??:??:??");
+	check("%B %Y", iso("2022"), "??? 2022");
+	check("%f", iso("2022-01-13T12:40:31.049"), "049");
+	check("%f|%6f", iso("2022-01-13T12:40:31"), "???");
+	check("%6f", iso("2022-01-13T12:40:31.049"), "??????");
+
+	// optional sections render timestamps at the precision they were specified at
+	check(ETS_FORMAT_ISO8601, t, "2022-01-13T12:40:31.049352");
+	check(ETS_FORMAT_ISO8601, iso("2022-01-13T12:40:31.049"), "2022-01-13T12:40:31.049");
+	check(ETS_FORMAT_ISO8601, iso("2022-01-13T12"), "2022-01-13T12");
+	check(ETS_FORMAT_ISO8601, iso("2022"), "2022");
+	check("%Y[ (%B)][ %H:%M]", iso("2022-01"), "2022 (January)");
+	check("[%d ][%B ]%Y", iso("2022-01"), "January 2022");
+	check("[[%H]%d]", iso("2022-01-13"), "13");
+
+	// B.C.
+	check("%Y", iso("-0043-03-15"), "-0043");
+	check("%EY", iso("-0043-03-15"), "44 BC");
+	check("%EY", iso("0000"), "1 BC");
+	check("%EY", t, "2022");
+	check("%C %y", iso("-0043"), "-01 57");
+
+	// century only
+	{
+		eternal_timestamp_t c = iso("1850");
+		c = ets_modern_set_year(c, 0);
+		check("%Y[-%m]", c, "18??");
+		check("%C/%y", c, "18/??");
+		check("[%Y]", c, "");
+		check("[%C]", c, "18");
+	}
+
+	// prehistoric timestamps use their own alternative, or "approx. N years ago" by default
+	check(ETS_FORMAT_ISO8601, prehistoric(38050, 4), "approx. 40000 years ago");
+	check(ETS_FORMAT_ISO8601, prehistoric(2498050, 5), "approx. 2500000 years ago");
+	check(ETS_FORMAT_ISO8601, prehistoric(50000, 0), "50000 years ago");
+	check("%F|%~%N BC[ (%Y)]", prehistoric(38050, 4), "approx. 40000 BC");
+	check("%F|%~%N BC[ (%Y)]", prehistoric(38050, 1), "approx. 38050 BC (-38050)");
+	check("%F|%Y-%m-%d %H:%M", iso("-050000-01-01T10:20"), "-50000-01-01 10:20");
+	check("%F|%~%N", prehistoric(0, 0), "?");
+
+	// bad patterns
+	check_rejected("%Y-%q", 3);
+	check_rejected("%Y-%", 3);
+	check_rejected("%Y[-%m", 6);
+	check_rejected("%Y]", 2);
+	check_rejected("[%Y|%N]", 3);
+	check_rejected("%Y|%N|%C", 5);
+	check_rejected("%E", 0);
+
+	// patterns which don't fit
+	{
+		std::string big(ETS_FORMAT_MAX_LITERALS + 1, 'x');
+		check_rejected(big.c_str(), ETS_FORMAT_MAX_LITERALS);
+		std::string many;
+		for (int i = 0; i <= ETS_FORMAT_MAX_OPS; i++)
+			many += "%Y";
+		check_rejected(many.c_str(), 2 * ETS_FORMAT_MAX_OPS);
+		// ... including the default prehistoric alternative
+		many.resize(2 * ETS_FORMAT_MAX_OPS - 2);
+		check_rejected(many.c_str(), many.size());
+	}
+
+	// truncation follows snprintf() semantics
+	{
+		ets_format_pattern_t fmt;
+		EternalTimestampFormat::compile(fmt, "%FT%T", nullptr);
+		char buf[8];
+		const size_t n = EternalTimestampFormat::format(buf, sizeof(buf), fmt, t);
+		if (n != 19 || strcmp(buf, "2022-01")) {
+			fprintf(stderr, "FAIL: truncated format: '%s' (%zu characters)\n", buf, n);
+			failures++;
+		}
+	}
+
+	// Arrow column output, resumable when the data buffer is full
+	{
+		ets_format_pattern_t fmt;
+		EternalTimestampFormat::compile(fmt, ETS_FORMAT_ISO8601, nullptr);
+		const eternal_timestamp_t src[4] = { iso("2022"), iso("2022-01-13"), prehistoric(38050, 4), iso("1999-12-31T23:59") };
+		char data[64];
+		int32_t offsets[5] = { 0 };
+		const size_t first = EternalTimestampFormat::format_column(data, 20, offsets, fmt, src, 4);
+		const size_t rest = EternalTimestampFormat::format_column(data, sizeof(data), offsets + first, fmt, src + first, 4 - first);
+		const std::string column(data, offsets[4]);
+		if (first != 2 || rest != 2 || column != "20222022-01-13approx. 40000 years ago1999-12-31T23:59" || offsets[1] != 4 || offsets[2] != 14 || offsets[3] != 37) {
+			fprintf(stderr, "FAIL: EternalTimestampFormat::format_column(): %zu + %zu rendered: '%s'\n", first, rest, column.c_str());
+			failures++;
+		}
+	}
+
+	if (failures) {
+		fprintf(stderr, "\n%d test(s) FAILED\n", failures);
+		return EXIT_FAILURE;
+	}
+	fprintf(stderr, "All tests passed\n");
+	return EXIT_SUCCESS;
+}
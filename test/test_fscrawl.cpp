@@ -0,0 +1,215 @@
+#include <eternal_timestamp/eternal_timestamp.h>
+#include <eternal_timestamp/eternal_timestamp_batch.h>
+#include <eternal_timestamp/eternal_timestamp_fscrawl.h>
+#include <eternal_timestamp/eternal_timestamp_parallel.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <ftw.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "monolithic_examples.h"
+
+
+using namespace eternal_timestamp;
+
+static int failures = 0;
+
+static void check(bool ok, const char *what)
+{
+	if (!ok) {
+		fprintf(stderr, "FAIL: %s\n", what);
+		failures++;
+	}
+}
+
+#if !defined(_WIN32)
+
+// 2021-05-06T07:08:09.123456789Z, which the crawl reports as ...09.123456
+static const struct timespec file_time = { 1620284889, 123456789 };
+static const int64_t file_usecs = 1620284889123456LL;
+
+static const size_t many = 1500;       // more than fit in a batch
+
+static std::string root;
+
+static void make_file(const std::string &path)
+{
+	const int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	check(fd >= 0 && write(fd, "eternal", 7) == 7, "create a file");
+	if (fd >= 0)
+		close(fd);
+	const struct timespec times[2] = { file_time, file_time };
+	check(utimensat(AT_FDCWD, path.c_str(), times, AT_SYMLINK_NOFOLLOW) == 0, "set the file times");
+}
+
+// root/
+//   a/x, a/y
+//   b/c/d/file, b/c/up -> ../.. (a cycle when following links)
+//   many/0 .. many/1499
+//   .hidden/z
+//   link -> a
+static bool make_tree()
+{
+	char tmpl[] = "/tmp/ets_fscrawl_XXXXXX";
+	if (!mkdtemp(tmpl))
+		return false;
+	root = tmpl;
+	for (const char *dir : { "/a", "/b", "/b/c", "/b/c/d", "/many", "/.hidden" })
+		check(mkdir((root + dir).c_str(), 0755) == 0, "mkdir");
+	for (const char *file : { "/a/x", "/a/y", "/b/c/d/file", "/.hidden/z" })
+		make_file(root + file);
+	for (size_t i = 0; i < many; i++)
+		make_file(root + "/many/" + std::to_string(i));
+	check(symlink("../..", (root + "/b/c/up").c_str()) == 0 && symlink("a", (root + "/link").c_str()) == 0, "symlink");
+	return true;
+}
+
+static int remove_entry(const char *path, const struct stat *, int, struct FTW *)
+{
+	return remove(path);
+}
+
+static void remove_tree()
+{
+	check(nftw(root.c_str(), remove_entry, 16, FTW_DEPTH | FTW_PHYS) == 0, "remove the tree");
+}
+
+// path below the root --> row
+static std::map<std::string, size_t> index_of(const EternalTimestampFsColumns &cols)
+{
+	std::map<std::string, size_t> m;
+	for (size_t i = 0; i < cols.size(); i++) {
+		const std::string p = cols.path(i);
+		m[p.size() > root.size() ? p.substr(root.size()) : std::string()] = i;
+	}
+	return m;
+}
+
+static void test_crawl()
+{
+	eternal_timestamp_t expected;
+	EternalTimestampBatch::cvt_from_unix_usecs(&expected, nullptr, &file_usecs, 1, 1);
+
+	for (const unsigned int parallelism : { 1U, ETS_PARALLELISM_ALL }) {
+		EternalTimestampFsColumns cols;
+		ets_fscrawl_stats_t stats;
+		check(EternalTimestampFsCrawl::collect(root.c_str(), 0, cols, &stats, parallelism) == 0, "collect()");
+
+		// root, a, a/x, a/y, b, b/c, b/c/d, b/c/d/file, b/c/up, many, many/*, .hidden, .hidden/z, link
+		const size_t total = 13 + many;
+		const std::map<std::string, size_t> rows = index_of(cols);
+		check(cols.size() == total && rows.size() == total && stats.entries == total && stats.errors == 0, "all entries, once");
+		check(stats.directories == 7, "the directories read");
+		check(cols.path_offsets.size() == total + 1 && cols.atime.size() == total && cols.btime.size() == total, "the columns");
+
+		check(rows.count("") && cols.path(rows.at("")) == root, "the root");
+		check(rows.count("/b/c/d/file") && rows.count("/many/1499") && rows.count("/.hidden/z") && !rows.count("/link/x"), "the paths");
+		if (rows.count("/b/c/d/file")) {
+			const size_t i = rows.at("/b/c/d/file");
+			check(cols.mtime[i].t == expected.t && cols.atime[i].t == expected.t, "microsecond precision");
+			check(cols.sizes[i] == 7 && S_ISREG(cols.modes[i]), "size and mode");
+			check(EternalTimestamp::has_microseconds(cols.ctime[i]) && EternalTimestamp::calc_sort_key(cols.ctime[i]) > EternalTimestamp::calc_sort_key(expected), "the status change time");
+			check(cols.btime[i].t == ets_unknown().t || EternalTimestamp::has_microseconds(cols.btime[i]), "the birth time");
+		}
+		if (rows.count("/link"))
+			check(S_ISLNK(cols.modes[rows.at("/link")]), "links are reported as such");
+	}
+
+	// the flags
+	EternalTimestampFsColumns cols;
+	check(EternalTimestampFsCrawl::collect(root.c_str(), ETS_FSCRAWL_SKIP_HIDDEN, cols, nullptr, ETS_PARALLELISM_ALL) == 0 && cols.size() == 11 + many && !index_of(cols).count("/.hidden"), "ETS_FSCRAWL_SKIP_HIDDEN");
+
+	cols.clear();
+	ets_fscrawl_stats_t stats;
+	check(EternalTimestampFsCrawl::collect(root.c_str(), ETS_FSCRAWL_FOLLOW_SYMLINKS | ETS_FSCRAWL_ONE_FILESYSTEM, cols, &stats, ETS_PARALLELISM_ALL) == 0, "ETS_FSCRAWL_FOLLOW_SYMLINKS");
+	const std::map<std::string, size_t> rows = index_of(cols);
+	// 'a' and 'link' are the same directory, read through whichever comes first; 'b/c/up' is the root again
+	check(rows.count("/link") && S_ISDIR(cols.modes[rows.at("/link")]) && rows.count("/a/x") + rows.count("/link/x") == 1 && !rows.count("/b/c/up/a"), "links followed, without cycles");
+	check(stats.directories == 7 && cols.size() == 13 + many, "ETS_FSCRAWL_FOLLOW_SYMLINKS: entries");
+
+	// a single file, with the trailing slashes of a directory path dropped
+	cols.clear();
+	check(EternalTimestampFsCrawl::collect((root + "/a/x").c_str(), 0, cols) == 0 && cols.size() == 1 && cols.path(0) == root + "/a/x", "a file as the root");
+	cols.clear();
+	check(EternalTimestampFsCrawl::collect((root + "/a//").c_str(), 0, cols) == 0 && cols.size() == 3 && index_of(cols).count("/a/x"), "trailing slashes");
+}
+
+static int count_entries(void *context, const ets_fscrawl_entry_t *entries, size_t count)
+{
+	bool ok = (count <= ETS_FSCRAWL_BATCH);
+	for (size_t i = 0; i < count; i++)
+		ok = ok && strlen(entries[i].path) == entries[i].path_length && (entries[i].depth == 0) == (entries[i].path_length == root.size());
+	check(ok, "the entries");
+	*static_cast<size_t *>(context) += count;
+	return 0;
+}
+
+static void test_callbacks()
+{
+	size_t n = 0;
+	ets_fscrawl_stats_t stats;
+	check(ets_fscrawl(root.c_str(), 0, count_entries, &n, &stats, ETS_PARALLELISM_ALL) == 0 && n == 13 + many && stats.entries == n, "ets_fscrawl()");
+
+	// stop after the first batch
+	size_t batches = 0;
+	errno = 0;
+	check(EternalTimestampFsCrawl::crawl(root.c_str(), 0, [&batches](const ets_fscrawl_entry_t *, size_t) {
+		batches++;
+		return false;
+	}, &stats, ETS_PARALLELISM_ALL) == -1 && errno == ECANCELED && batches == 1, "stopping the crawl");
+
+	errno = 0;
+	check(ets_fscrawl((root + "/missing").c_str(), 0, count_entries, &n, &stats, 1) == -1 && errno == ENOENT && stats.entries == 0, "a missing root");
+}
+
+#endif // !_WIN32
+
+
+#if defined(BUILD_MONOLITHIC)
+#define main(cnt, arr)      eternalty_test_fscrawl_main(cnt, arr)
+#endif
+
+int main(int argc, const char **argv)
+{
+	(void)argc;
+	(void)argv;
+
+	fprintf(stderr, "Eternal Timestamp Test (file system crawler)\n\n");
+
+#if defined(_WIN32)
+	size_t n = 0;
+	check(ets_fscrawl(".", 0, nullptr, &n, nullptr, 1) == -1 && errno == ENOSYS, "not available");
+#else
+	if (!make_tree()) {
+		fprintf(stderr, "cannot create a temporary directory\n");
+		return EXIT_FAILURE;
+	}
+	// four crawler threads, however many cores the machine has
+	ets_thread_pool_t *pool = EternalTimestampThreadPool::create(3);
+	const ets_executor_t executor = EternalTimestampThreadPool::executor(pool);
+	EternalTimestampParallel::set_executor(&executor);
+	test_crawl();
+	test_callbacks();
+	EternalTimestampParallel::set_executor(nullptr);
+	EternalTimestampThreadPool::destroy(pool);
+	remove_tree();
+#endif
+
+	if (failures) {
+		fprintf(stderr, "\n%d test(s) FAILED\n", failures);
+		return EXIT_FAILURE;
+	}
+	fprintf(stderr, "All tests passed\n");
+	return EXIT_SUCCESS;
+}
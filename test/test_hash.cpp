@@ -0,0 +1,210 @@
+
+#include <eternal_timestamp/eternal_timestamp.h>
+#include <eternal_timestamp/eternal_timestamp_batch.h>
+#include <eternal_timestamp/eternal_timestamp_hash.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "monolithic_examples.h"
+
+
+using namespace eternal_timestamp;
+
+static int failures = 0;
+
+static void check(bool ok, const char *what)
+{
+	if (!ok) {
+		fprintf(stderr, "FAIL: %s\n", what);
+		failures++;
+	}
+}
+
+// `count` timestamps at one second intervals, the way log records come in.
+static std::vector<eternal_timestamp_t> seconds_from(int64_t start, size_t count)
+{
+	std::vector<int64_t> seconds(count);
+	for (size_t i = 0; i < count; i++)
+		seconds[i] = start + static_cast<int64_t>(i);
+	std::vector<eternal_timestamp_t> v(count);
+	EternalTimestampBatch::cvt_from_unix_seconds(v.data(), nullptr, seconds.data(), count);
+	return v;
+}
+
+
+#if defined(BUILD_MONOLITHIC)
+#define main(cnt, arr)      eternalty_test_hash_main(cnt, arr)
+#endif
+
+int main(int argc, const char **argv)
+{
+	fprintf(stderr, "Eternal Timestamp Test (hashing, hash tables)\n\n");
+
+	// Regular timestamps must spread evenly over the low hash bits, which index the tables: with 2^16 buckets
+	// and 2^20 keys, a uniform hash puts 16 +/- 4 in each bucket.
+	{
+		const auto keys = seconds_from(1641000000, 1 << 20);
+		std::vector<uint32_t> buckets(1 << 16);
+		for (const auto &k : keys)
+			buckets[ets_hash(k) & 0xFFFF]++;
+		double chi2 = 0;
+		uint32_t max = 0;
+		for (uint32_t n : buckets) {
+			chi2 += (n - 16.0) * (n - 16.0) / 16.0;
+			max = (n > max ? n : max);
+		}
+		// the expected value of chi^2 is the number of buckets - 1, with a standard deviation of ~362
+		if (chi2 > 65535 + 5 * 362 || max > 48) {
+			fprintf(stderr, "FAIL: ets_hash() distribution: chi^2 = %.0f, largest bucket %u\n", chi2, max);
+			failures++;
+		}
+	}
+
+	// avalanche: each input bit flips each output bit about half the time
+	{
+		std::mt19937_64 rng(1);
+		std::vector<uint32_t> flips(64 * 64);
+		const int rounds = 4000;
+		for (int r = 0; r < rounds; r++) {
+			eternal_timestamp_t t;
+			t.t = rng();
+			const uint64_t h = ets_hash(t);
+			for (int i = 0; i < 64; i++) {
+				eternal_timestamp_t u = t;
+				u.t ^= uint64_t(1) << i;
+				const uint64_t d = h ^ ets_hash(u);
+				for (int o = 0; o < 64; o++)
+					flips[i * 64 + o] += (d >> o) & 1;
+			}
+		}
+		uint32_t lo = rounds, hi = 0;
+		for (uint32_t f : flips) {
+			lo = (f < lo ? f : lo);
+			hi = (f > hi ? f : hi);
+		}
+		if (lo < rounds * 0.42 || hi > rounds * 0.58) {
+			fprintf(stderr, "FAIL: ets_hash() avalanche: flip rates %.3f .. %.3f\n", lo / double(rounds), hi / double(rounds));
+			failures++;
+		}
+	}
+
+	// random operations against std::unordered_map; a small key space makes for plenty of hits and tombstones
+	{
+		EternalTimestampHashMap map;
+		std::unordered_map<uint64_t, uint64_t> reference;
+		std::mt19937_64 rng(2);
+		const auto domain = seconds_from(1641000000, 5000);
+		for (int i = 0; i < 300000; i++) {
+			const eternal_timestamp_t k = domain[rng() % domain.size()];
+			const int op = static_cast<int>(rng() % 4);
+			if (op == 0) {
+				bool inserted = false;
+				map.insert(k, i, &inserted);
+				const bool expected = reference.emplace(k.t, i).second;
+				if (inserted != expected) {
+					check(false, "EternalTimestampHashMap::insert()");
+					break;
+				}
+			}
+			else if (op == 1) {
+				if (map.erase(k) != (reference.erase(k.t) == 1)) {
+					check(false, "EternalTimestampHashMap::erase()");
+					break;
+				}
+			}
+			else {
+				uint64_t v = 0;
+				const auto it = reference.find(k.t);
+				if (map.find(k, &v) != (it != reference.end()) || (it != reference.end() && v != it->second)) {
+					check(false, "EternalTimestampHashMap::find()");
+					break;
+				}
+			}
+			if (map.size() != reference.size()) {
+				check(false, "EternalTimestampHashMap::size()");
+				break;
+			}
+		}
+
+		map.assign(domain[0], 42);
+		uint64_t v = 0;
+		check(map.find(domain[0], &v) && v == 42, "EternalTimestampHashMap::assign()");
+
+		EternalTimestampHashMap moved(std::move(map));
+		check(map.size() == 0 && !map.contains(domain[0]) && moved.contains(domain[0]), "EternalTimestampHashMap move");
+		moved.clear();
+		check(moved.size() == 0 && !moved.contains(domain[0]), "EternalTimestampHashMap::clear()");
+	}
+
+	// deduplication of a column: the `inserted` bits mark the first occurrences
+	{
+		std::mt19937_64 rng(3);
+		const auto domain = seconds_from(1641000000, 100000);
+		std::vector<eternal_timestamp_t> column(250000);
+		for (auto &k : column)
+			k = domain[rng() % domain.size()];
+
+		EternalTimestampHashMap map;
+		std::vector<uint8_t> inserted((column.size() + 7) / 8);
+		check(map.insert_batch(column.data(), nullptr, column.size(), inserted.data()) == 0, "EternalTimestampHashMap::insert_batch()");
+
+		std::unordered_map<uint64_t, uint64_t> first;
+		bool ok = true;
+		for (size_t i = 0; i < column.size(); i++) {
+			const bool is_first = first.emplace(column[i].t, i).second;
+			ok &= (((inserted[i / 8] >> (i % 8)) & 1) == is_first);
+		}
+		check(ok && map.size() == first.size(), "EternalTimestampHashMap::insert_batch() dedup bitmap");
+
+		// joins: look up the whole domain, half of which is present
+		std::vector<uint64_t> values(domain.size());
+		std::vector<uint8_t> found((domain.size() + 7) / 8);
+		const size_t hits = map.find_batch(values.data(), found.data(), domain.data(), domain.size());
+		ok = (hits == first.size());
+		for (size_t i = 0; i < domain.size(); i++) {
+			const auto it = first.find(domain[i].t);
+			const bool f = (found[i / 8] >> (i % 8)) & 1;
+			ok &= (f == (it != first.end())) && values[i] == (f ? it->second : 0);
+		}
+		check(ok, "EternalTimestampHashMap::find_batch()");
+	}
+
+	// sets
+	{
+		const auto keys = seconds_from(0, 1000);
+		EternalTimestampHashSet set;
+		check(set.insert_batch(keys.data(), keys.size(), nullptr) == 0 && set.size() == 1000, "EternalTimestampHashSet::insert_batch()");
+		bool inserted = true;
+		set.insert(keys[7], &inserted);
+		check(!inserted && set.contains(keys[999]), "EternalTimestampHashSet::insert()");
+		const auto others = seconds_from(500, 1000);
+		std::vector<uint8_t> found(1000 / 8);
+		check(set.contains_batch(found.data(), others.data(), others.size()) == 500 && found[0] == 0xFF && found[124] == 0, "EternalTimestampHashSet::contains_batch()");
+	}
+
+	// the C interface
+	{
+		ets_hash_map_t *map = ets_hash_map_create(100);
+		const auto keys = seconds_from(1641000000, 3);
+		int inserted = 0;
+		uint64_t v = 0;
+		check(map && ets_hash_map_insert(map, keys[0], 7, &inserted) == 0 && inserted, "ets_hash_map_insert()");
+		check(ets_hash_map_find(map, keys[0], &v) && v == 7 && !ets_hash_map_find(map, keys[1], &v), "ets_hash_map_find()");
+		check(ets_hash_map_insert_batch(map, keys.data(), nullptr, 3, nullptr) == 0 && ets_hash_map_size(map) == 3, "ets_hash_map_insert_batch()");
+		check(ets_hash_map_erase(map, keys[0]) && !ets_hash_map_erase(map, keys[0]), "ets_hash_map_erase()");
+		ets_hash_map_destroy(map);
+	}
+
+	if (failures) {
+		fprintf(stderr, "\n%d test(s) FAILED\n", failures);
+		return EXIT_FAILURE;
+	}
+	fprintf(stderr, "All tests passed\n");
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,271 @@
+
+#include <eternal_timestamp/eternal_timestamp.h>
+#include <eternal_timestamp/eternal_timestamp_batch.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "monolithic_examples.h"
+
+
+using namespace eternal_timestamp;
+
+static int failures = 0;
+
+// render the specified fields of a (partial) timestamp, stopping at the first unspecified one.
+static std::string describe(const eternal_timestamp_t t)
+{
+	char buf[80];
+	if (ets_format_mode(t)) {
+		const unsigned month = static_cast<unsigned>(ets_prehistoric_month(t));
+		const unsigned day = static_cast<unsigned>(ets_prehistoric_day(t));
+		const unsigned hour = static_cast<unsigned>(ets_prehistoric_hour(t));
+		const unsigned minute = static_cast<unsigned>(ets_prehistoric_minute(t));
+		int n = snprintf(buf, sizeof(buf), "-%llu", static_cast<unsigned long long>(ets_prehistoric_years(t)));
+		if (month) {
+			n += snprintf(buf + n, sizeof(buf) - n, "-%02u", month);
+			if (day) {
+				n += snprintf(buf + n, sizeof(buf) - n, "-%02u", day);
+				if (hour) {
+					n += snprintf(buf + n, sizeof(buf) - n, "T%02u", hour - 1);
+					if (minute)
+						n += snprintf(buf + n, sizeof(buf) - n, ":%02u", minute - 1);
+				}
+			}
+		}
+		snprintf(buf + n, sizeof(buf) - n, " (prehistoric)");
+		return buf;
+	}
+
+	const int century = static_cast<int>(ets_modern_century(t));
+	const int year = static_cast<int>(ets_modern_year(t));
+	const unsigned month = static_cast<unsigned>(ets_modern_month(t));
+	const unsigned day = static_cast<unsigned>(ets_modern_day(t));
+	const unsigned hour = static_cast<unsigned>(ets_modern_hour(t));
+	const unsigned minute = static_cast<unsigned>(ets_modern_minute(t));
+	const unsigned seconds = static_cast<unsigned>(ets_modern_seconds(t));
+	const unsigned milliseconds = static_cast<unsigned>(ets_modern_milliseconds(t));
+	const unsigned microseconds = static_cast<unsigned>(ets_modern_microseconds(t));
+	int n = snprintf(buf, sizeof(buf), "%d", century * 100 + year - 1 - 10000);
+	if (month) {
+		n += snprintf(buf + n, sizeof(buf) - n, "-%02u", month);
+		if (day) {
+			n += snprintf(buf + n, sizeof(buf) - n, "-%02u", day);
+			if (hour) {
+				n += snprintf(buf + n, sizeof(buf) - n, "T%02u", hour - 1);
+				if (minute) {
+					n += snprintf(buf + n, sizeof(buf) - n, ":%02u", minute - 1);
+					if (seconds) {
+						n += snprintf(buf + n, sizeof(buf) - n, ":%02u", seconds - 1);
+						if (milliseconds) {
+							n += snprintf(buf + n, sizeof(buf) - n, ".%03u", milliseconds - 1);
+							if (microseconds)
+								snprintf(buf + n, sizeof(buf) - n, "%03u", microseconds - 1);
+						}
+					}
+				}
+			}
+		}
+	}
+	return buf;
+}
+
+// parse with both the fast and the reference implementation; `expected` is NULL when the input must be rejected.
+static void check(const char *input, const char *expected)
+{
+	eternal_timestamp_t fast{0}, ref{0};
+	const int rc_fast = EternalTimestamp::cvt_from_iso8601(fast, input, strlen(input));
+	const int rc_ref = EternalTimestamp::cvt_from_iso8601_scalar(ref, input, strlen(input));
+
+	const std::string actual = (rc_fast ? "(rejected)" : describe(fast));
+	if (actual != (expected ? expected : "(rejected)")) {
+		fprintf(stderr, "FAIL: '%s'\n  expected: %s\n  actual:   %s\n", input, (expected ? expected : "(rejected)"), actual.c_str());
+		failures++;
+	}
+	if (rc_fast != rc_ref || (!rc_fast && fast.t != ref.t)) {
+		fprintf(stderr, "FAIL: '%s': fast and reference implementations disagree\n", input);
+		failures++;
+	}
+}
+
+
+#if defined(BUILD_MONOLITHIC)
+#define main(cnt, arr)      eternalty_test_iso8601_main(cnt, arr)
+#endif
+
+int main(int argc, const char **argv)
+{
+	fprintf(stderr, "Eternal Timestamp Test (ISO 8601 parser)\n\n");
+
+	// reduced precision produces partial timestamps
+	check("2022", "2022");
+	check("2022-01", "2022-01");
+	check("2022-01-13", "2022-01-13");
+	check("2022-01-13T12", "2022-01-13T12");
+	check("2022-01-13T12:40", "2022-01-13T12:40");
+	check("2022-01-13T12:40:31", "2022-01-13T12:40:31");
+	check("2022-01-13T12:40:31.049", "2022-01-13T12:40:31.049");
+	check("2022-01-13T12:40:31.049352", "2022-01-13T12:40:31.049352");
+	check("2022-01-13T12:40:31.049352789Z", "2022-01-13T12:40:31.049352");
+	check("2022-01-13 12:40:31,5", "2022-01-13T12:40:31.500");
+
+	// basic format
+	check("20220113", "2022-01-13");
+	check("20220113T1240", "2022-01-13T12:40");
+	check("20220113T124031.25Z", "2022-01-13T12:40:31.250");
+
+	// zones are converted to UTC
+	check("2022-01-13T12:40:31Z", "2022-01-13T12:40:31");
+	check("2022-01-13T00:30:00+01:00", "2022-01-12T23:30:00");
+	check("2022-12-31T23:30-0100", "2023-01-01T00:30");
+	check("2022-01-13T12+05", "2022-01-13T07");
+	check("2022-01-13T12:40:31.049352+05:30", "2022-01-13T07:10:31.049352");
+
+	// expanded years
+	check("-0044-03-15", "-44-03-15");
+	check("+012345-06-07", "12345-06-07");
+	check("-9900-01-01", "-9900-01-01");
+	check("-9950-01-01", "-9950-01-01 (prehistoric)");
+	check("-050000-01-01T10:20:30", "-50000-01-01T10:20 (prehistoric)");
+	check("-1000000000", "-1000000000 (prehistoric)");
+
+	// garbage
+	check("", nullptr);
+	check("2022-02-29", nullptr);
+	check("2024-02-29", "2024-02-29");
+	check("2022-13-01", nullptr);
+	check("2022-01-32", nullptr);
+	check("2022-1-13", nullptr);
+	check("202201", nullptr);
+	check("2022-01-13Z", nullptr);
+	check("2022-01-13T24:00", nullptr);
+	check("2022-01-13T12:60", nullptr);
+	check("2022-01-13T12:40:31.", nullptr);
+	check("2022-01-13T12:40:31.Z", nullptr);
+	check("2022-01-13T12:40:31+1", nullptr);
+	check("2022-01-13T12:40:31 ", nullptr);
+	check("2022-01-13X12:40:31", nullptr);
+	check("+99999-01-01", nullptr);
+
+	// the fast path and the reference implementation must agree on everything, including rejects
+	{
+		static const char *const seeds[] = {
+			"2022-01-13T12:40:31.049352Z",
+			"2022-01-13T12:40:31+05:30",
+			"1999-12-31 23:59:59,123",
+			"2000-02-29T00:00:00.1234567890123",
+		};
+		static const char alphabet[] = "0123456789-:T.Z+ ,";
+		std::mt19937 rng(20220113);
+		int disagreements = 0;
+		for (int i = 0; i < 200000; i++) {
+			std::string s = seeds[i % 4];
+			for (int k = rng() % 3; k > 0; k--) {
+				const size_t pos = rng() % s.size();
+				const char c = alphabet[rng() % (sizeof(alphabet) - 1)];
+				switch (rng() % 3) {
+				case 0: s[pos] = c; break;
+				case 1: s.erase(pos, 1); break;
+				default: s.insert(pos, 1, c); break;
+				}
+			}
+			eternal_timestamp_t fast{0}, ref{0};
+			const int rc_fast = EternalTimestamp::cvt_from_iso8601(fast, s.data(), s.size());
+			const int rc_ref = EternalTimestamp::cvt_from_iso8601_scalar(ref, s.data(), s.size());
+			if (rc_fast != rc_ref || (!rc_fast && fast.t != ref.t)) {
+				if (disagreements++ < 10)
+					fprintf(stderr, "FAIL: '%s': fast and reference implementations disagree\n", s.c_str());
+			}
+		}
+		failures += disagreements;
+	}
+
+	// batch APIs
+	{
+		const char *strings[] = { "2022-01-13T12:40:31Z", "garbage", nullptr, "2022-01" };
+		eternal_timestamp_t dst[4];
+		uint8_t validity = 0;
+		const size_t failed = EternalTimestampBatch::cvt_from_iso8601(dst, &validity, strings, nullptr, 4);
+		if (failed != 2 || validity != 0x09 || describe(dst[3]) != "2022-01") {
+			fprintf(stderr, "FAIL: EternalTimestampBatch::cvt_from_iso8601(): %zu failures, validity 0x%02x\n", failed, validity);
+			failures++;
+		}
+
+		const char data[] = "2022-01-13T12:40:31Z2022-13" "1999-12-31";
+		const int32_t offsets[] = { 0, 20, 27, 37 };
+		validity = 0;
+		const size_t failed_column = EternalTimestampBatch::cvt_from_iso8601_column(dst, &validity, data, offsets, 3);
+		if (failed_column != 1 || validity != 0x05 || describe(dst[2]) != "1999-12-31") {
+			fprintf(stderr, "FAIL: EternalTimestampBatch::cvt_from_iso8601_column(): %zu failures, validity 0x%02x\n", failed_column, validity);
+			failures++;
+		}
+	}
+
+	// RFC 3339 writer: known outputs, then round trips through the parser
+	{
+		const char *inputs[] = { "2022-01-13T12:40:31.049352Z", "2022-01-13T12:40:31.049Z", "2022-01-13T12:40Z", "2022-01-13T12Z",
+			"2022-01-13", "2022-01", "2022", "-0044-03-15", "+12345-06-07T08:09:10Z", "-050000-01-01", "0000-01-01T00:00:00Z" };
+		const char expected[] = "2022-01-13T12:40:31.049352Z" "2022-01-13T12:40:31.049Z" "2022-01-13T12:40Z" "2022-01-13T12Z"
+			"2022-01-13" "2022-01" "2022" "-0044-03-15" "+12345-06-07T08:09:10Z" "" "0000-01-01T00:00:00Z";
+		const size_t n = sizeof(inputs) / sizeof(inputs[0]);
+		eternal_timestamp_t src[n];
+		EternalTimestampBatch::cvt_from_iso8601(src, nullptr, inputs, nullptr, n);
+
+		char data[sizeof(expected)];
+		int32_t offsets[n + 1] = { 0 };
+		uint8_t validity[2] = { 0 };
+		const size_t first = EternalTimestampBatch::cvt_to_rfc3339_column(data, 60, offsets, validity, src, 0, n);
+		const size_t rest = EternalTimestampBatch::cvt_to_rfc3339_column(data, sizeof(data), offsets, validity, src, first, n);
+		if (first != 2 || rest != n || std::string(data, offsets[n]) != expected || validity[0] != 0xFF || validity[1] != 0x05) {
+			fprintf(stderr, "FAIL: EternalTimestampBatch::cvt_to_rfc3339_column(): %zu, %zu rendered, validity 0x%02x%02x: '%.*s'\n",
+				first, rest, validity[1], validity[0], static_cast<int>(offsets[n]), data);
+			failures++;
+		}
+
+		std::mt19937_64 rng(20220113);
+		std::vector<int64_t> usecs(100000);
+		uint64_t base = 0;
+		for (auto &v : usecs) {
+			// mostly sorted, with the occasional jump, like the pages of an API response; years -7500 .. +39000
+			base += (rng() % 64 ? rng() % 3600000000ull : rng() % 100000000000000000ull);
+			v = static_cast<int64_t>(base % 1450000000000000000ull) - 300000000000000000ll;
+		}
+		std::vector<eternal_timestamp_t> ts(usecs.size());
+		EternalTimestampBatch::cvt_from_unix_usecs(ts.data(), nullptr, usecs.data(), usecs.size());
+		for (auto &t : ts) {
+			// reduce the precision of some
+			switch (rng() % 8) {
+			case 4: t = ets_modern_set_hour(t, 0); // fall through
+			case 3: t = ets_modern_set_minute(t, 0); // fall through
+			case 2: t = ets_modern_set_seconds(t, 0); // fall through
+			case 1: t = ets_modern_set_milliseconds(t, 0); // fall through
+			case 0: t = ets_modern_set_microseconds(t, 0); break;
+			default: break;
+			}
+		}
+
+		std::vector<char> text(ts.size() * ETS_BATCH_RFC3339_MAX_LENGTH);
+		std::vector<int32_t> text_offsets(ts.size() + 1, 0);
+		std::vector<eternal_timestamp_t> back(ts.size());
+		const size_t rendered = EternalTimestampBatch::cvt_to_rfc3339_column(text.data(), text.size(), text_offsets.data(), nullptr, ts.data(), 0, ts.size());
+		const size_t failed = EternalTimestampBatch::cvt_from_iso8601_column(back.data(), nullptr, text.data(), text_offsets.data(), ts.size());
+		int mismatches = 0;
+		for (size_t i = 0; i < ts.size(); i++) {
+			if (back[i].t != ts[i].t && mismatches++ < 10)
+				fprintf(stderr, "FAIL: RFC 3339 round trip: '%.*s'\n", static_cast<int>(text_offsets[i + 1] - text_offsets[i]), text.data() + text_offsets[i]);
+		}
+		if (rendered != ts.size() || failed)
+			mismatches++;
+		failures += mismatches;
+	}
+
+	if (failures) {
+		fprintf(stderr, "\n%d test(s) FAILED\n", failures);
+		return EXIT_FAILURE;
+	}
+	fprintf(stderr, "All tests passed\n");
+	return EXIT_SUCCESS;
+}
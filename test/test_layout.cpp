@@ -0,0 +1,443 @@
+#include <eternal_timestamp/eternal_timestamp.h>
+#include <eternal_timestamp/eternal_timestamp_batch.h>
+#include <eternal_timestamp/eternal_timestamp_layout.h>
+#include <eternal_timestamp/eternal_timestamp_parallel.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "monolithic_examples.h"
+
+
+using namespace eternal_timestamp;
+
+typedef EternalTimestampLayout<> Native;
+typedef EternalTimestampExtendedLayout Extended;
+
+// The library's field positions with the 'unspecified' marker sorting last.
+typedef EternalTimestampLayout<1, !Native::unspecified_sorts_first> Flipped;
+
+static int failures = 0;
+
+static void check(bool ok, const char *what)
+{
+	if (!ok) {
+		fprintf(stderr, "FAIL: %s\n", what);
+		failures++;
+	}
+}
+
+static eternal_timestamp_t parse(const char *iso8601)
+{
+	eternal_timestamp_t t;
+	t.t = 0;
+	EternalTimestamp::cvt_from_iso8601(t, iso8601, strlen(iso8601));
+	return t;
+}
+
+static bool bit(const std::vector<uint8_t> &validity, size_t i)
+{
+	return (validity[i / 8] >> (i % 8)) & 1;
+}
+
+static const char *const samples[] = {
+	"2020", "2020-09", "2020-09-13", "2020-09-13T12", "2020-09-13T12:30", "2020-09-13T12:30:15",
+	"2020-09-13T12:30:15.250", "2020-09-13T12:30:15.250001", "2016-12-31T23:59:60", "1970-01-01T00:00:00",
+	"0001-01-01", "-0044-03-15", "-9000-06-01T06", "-12000-01-01", "-20000", "-5000000", "9999-12-31T23:59:59.999999",
+};
+
+// Any timestamp in the library's format, malformed ones excepted.
+static eternal_timestamp_t random_timestamp(std::mt19937_64 &rng)
+{
+	eternal_timestamp_t t;
+	t.t = rng() & ~1ULL;
+	return t;
+}
+
+// The default instantiation describes the bitfields.
+static void test_native_layout()
+{
+	eternal_timestamp_t t;
+	t.t = 0;
+	t.modern.century = Native::modern::century::max;
+	check(t.t == Native::modern::century::mask, "century");
+	t.t = 0;
+	t.modern.year = Native::modern::year::max;
+	check(t.t == Native::modern::year::mask, "year");
+	t.t = 0;
+	t.modern.month = Native::modern::month::max;
+	check(t.t == Native::modern::month::mask, "month");
+	t.t = 0;
+	t.modern.day = Native::modern::day::max;
+	check(t.t == Native::modern::day::mask, "day");
+	t.t = 0;
+	t.modern.hour = Native::modern::hour::max;
+	check(t.t == Native::modern::hour::mask, "hour");
+	t.t = 0;
+	t.modern.minute = Native::modern::minute::max;
+	check(t.t == Native::modern::minute::mask, "minute");
+	t.t = 0;
+	t.modern.seconds = Native::modern::seconds::max;
+	check(t.t == Native::modern::seconds::mask, "seconds");
+	t.t = 0;
+	t.modern.milliseconds = Native::modern::milliseconds::max;
+	check(t.t == Native::modern::milliseconds::mask, "milliseconds");
+	t.t = 0;
+	t.modern.microseconds = Native::modern::microseconds::max;
+	check(t.t == Native::modern::microseconds::mask, "microseconds");
+	t.t = 0;
+	t.modern.mode = 1;
+	check(t.t == Native::mode_mask, "mode");
+
+	t.t = 0;
+	t.prehistoric.years = Native::prehistoric::years::max;
+	check(t.t == Native::prehistoric::years::mask, "years");
+	t.t = 0;
+	t.prehistoric.month = Native::prehistoric::month::max;
+	check(t.t == Native::prehistoric::month::mask, "prehistoric month");
+	t.t = 0;
+	t.prehistoric.day = Native::prehistoric::day::max;
+	check(t.t == Native::prehistoric::day::mask, "prehistoric day");
+	t.t = 0;
+	t.prehistoric.hour = Native::prehistoric::hour::max;
+	check(t.t == Native::prehistoric::hour::mask, "prehistoric hour");
+	t.t = 0;
+	t.prehistoric.minute = Native::prehistoric::minute::max;
+	check(t.t == Native::prehistoric::minute::mask, "prehistoric minute");
+	t.t = 0;
+	t.prehistoric.precision = Native::prehistoric::precision::max;
+	check(t.t == Native::prehistoric::precision::mask, "precision");
+
+	check(Native::unknown() == (Native::unspecified_sorts_first ? 0 : ~(Native::mode_mask | 1)), "unknown()");
+	check(Native::is_prehistoric_format(parse("-20000").t) && Native::is_modern_format(parse("2020").t), "is_modern_format()");
+	check(Native::is_unspecified<Native::modern::month>(parse("2020").t) && !Native::is_unspecified<Native::modern::year>(parse("2020").t), "is_unspecified()");
+
+	static_assert(Native::modern::century::get(Native::modern::century::set(0, 100)) == 100, "constexpr accessors");
+	static_assert(Extended::modern::width == 63 && Extended::prehistoric::width == 63, "the extended layout uses all bits");
+}
+
+static void test_sort_key()
+{
+	std::mt19937_64 rng(42);
+	for (int i = 0; i < 100000; i++) {
+		const eternal_timestamp_t t = (i < 17 ? parse(samples[i]) : random_timestamp(rng));
+		const int64_t key = EternalTimestamp::calc_sort_key(t);
+		check(Native::calc_sort_key(t.t) == key, "calc_sort_key(): native");
+
+		uint64_t x;
+		check(Extended::cvt_from_native(x, t) == 0, "cvt_from_native()");
+		check(Extended::calc_sort_key(x) == key, "calc_sort_key(): extended");
+		if (Extended::is_modern_format(x))
+			check(x == static_cast<uint64_t>(key), "extended: modern values are their own sort keys");
+		else
+			check(static_cast<int64_t>(x) < 0, "extended: prehistoric values are negative");
+	}
+
+	// with 'unspecified' sorting last, a year comes after all of its months.
+	uint64_t year, december;
+	check(Flipped::cvt_from_native(year, parse("2020")) == 0 && Flipped::cvt_from_native(december, parse("2020-12-31T23:59:59")) == 0, "flipped");
+	check(Flipped::calc_sort_key(year) > Flipped::calc_sort_key(december) && Native::calc_sort_key(parse("2020").t) < Native::calc_sort_key(parse("2020-12-31T23:59:59").t), "flipped: 'unspecified' sorts last");
+}
+
+static void test_conversions()
+{
+	std::mt19937_64 rng(7);
+	for (int i = 0; i < 100000; i++) {
+		const eternal_timestamp_t t = (i < 17 ? parse(samples[i]) : random_timestamp(rng));
+		uint64_t x, f, g;
+		eternal_timestamp_t back;
+		check(Extended::cvt_from_native(x, t) == 0 && Extended::cvt_to_native(back, x) == 0 && back.t == t.t, "native -> extended -> native");
+
+		// extended to the flipped layout and back, directly.
+		if (Flipped::cvt_from_layout<Extended>(f, x) == 0) {
+			check(Flipped::cvt_to_layout<Extended>(g, f) == 0 && g == x, "extended -> flipped -> extended");
+			check(Native::is_unspecified<Native::modern::day>(t.t) == Flipped::is_unspecified<Flipped::modern::day>(f) || Native::is_prehistoric_format(t.t), "flipped: 'unspecified' stays 'unspecified'");
+		}
+	}
+
+	eternal_timestamp_t n;
+	uint64_t x;
+
+	// values which don't fit the library's format, and malformed ones.
+	x = Extended::modern::century::set(0, 600);
+	check(Extended::cvt_to_native(n, x) == -1 && n.t == Native::unknown(), "cvt_to_native(): century 600");
+	x = Extended::prehistoric::years::set(Extended::mode_mask, 1ULL << 38);
+	check(Extended::cvt_to_native(n, x) == -1 && n.t == Native::unknown(), "cvt_to_native(): 2^38 years");
+	n.t = parse("2020").t | 1;
+	check(Extended::cvt_from_native(x, n) == -1 && x == Extended::unknown(), "cvt_from_native(): sign bit");
+	check(Native::cvt_from_layout<Native>(x, n.t) == -1, "cvt_from_layout(): sign bit");
+	check(Native::cvt_from_layout<Native>(x, parse("2020").t) == 0 && x == parse("2020").t, "cvt_from_layout(): identity");
+
+	// timeinfo structs.
+	for (size_t i = 0; i < sizeof(samples) / sizeof(samples[0]); i++) {
+		const eternal_timestamp_t t = parse(samples[i]);
+		eternal_time_tm a, b;
+		memset(&a, 0, sizeof(a));
+		memset(&b, 0, sizeof(b));
+		check(Extended::cvt_from_native(x, t) == 0, samples[i]);
+		const int ra = EternalTimestamp::cvt_to_timeinfo_struct(a, t);
+		const int rb = Extended::cvt_to_timeinfo_struct(b, x);
+		check(ra == rb && memcmp(&a, &b, sizeof(a)) == 0, "cvt_to_timeinfo_struct()");
+	}
+}
+
+static void test_batch()
+{
+	std::mt19937_64 rng(1234);
+	const size_t lengths[] = { 0, 1, 7, 8, 9, 15, 16, 17, 63, 64, 65, 10007, 3 * ETS_PARALLEL_GRAIN + 13 };
+	for (size_t n : lengths) {
+		std::vector<eternal_timestamp_t> src(n);
+		size_t malformed = 0;
+		for (size_t i = 0; i < n; i++) {
+			src[i] = random_timestamp(rng);
+			if (rng() % 16 == 0) {
+				src[i].t |= 1;
+				malformed++;
+			}
+		}
+
+		std::vector<uint64_t> x(n + 1, 0);
+		std::vector<uint8_t> validity(n / 8 + 1, 0xAA);
+		const uint8_t tail = validity.back();
+		check(Extended::cvt_from_native_batch(x.data(), validity.data(), src.data(), n, ETS_PARALLELISM_ALL) == malformed, "cvt_from_native_batch(): failures");
+		bool same = true;
+		for (size_t i = 0; i < n; i++) {
+			uint64_t y;
+			const bool ok = (Extended::cvt_from_native(y, src[i]) == 0);
+			same = same && y == x[i] && bit(validity, i) == ok;
+		}
+		check(same, "cvt_from_native_batch() == cvt_from_native()");
+		check((validity.back() & ~((1U << (n % 8)) - 1) & 0xFF) == (tail & ~((1U << (n % 8)) - 1) & 0xFF), "cvt_from_native_batch(): bits beyond the end");
+		check(x[n] == 0, "cvt_from_native_batch(): values beyond the end");
+
+		std::vector<eternal_timestamp_t> back(n);
+		check(Extended::cvt_to_native_batch(back.data(), nullptr, x.data(), n, ETS_PARALLELISM_ALL) == 0, "cvt_to_native_batch()");
+		same = true;
+		for (size_t i = 0; i < n; i++)
+			same = same && (bit(validity, i) ? back[i].t == src[i].t : back[i].t == Native::unknown());
+		check(same, "cvt_to_native_batch(): round trip");
+
+		std::vector<uint64_t> f(n);
+		check(Flipped::cvt_from_layout_batch<Extended>(f.data(), nullptr, x.data(), n, ETS_PARALLELISM_ALL) == Flipped::cvt_from_layout_batch<Extended>(f.data(), nullptr, x.data(), n, 1), "cvt_from_layout_batch(): parallel");
+
+		std::vector<int64_t> keys(n);
+		Extended::calc_sort_key_batch(keys.data(), x.data(), n, ETS_PARALLELISM_ALL);
+		same = true;
+		for (size_t i = 0; i < n; i++)
+			same = same && keys[i] == Extended::calc_sort_key(x[i]);
+		check(same, "calc_sort_key_batch()");
+	}
+}
+
+// Render a column as RFC 3339 text and split it up again.
+template <class Layout>
+static std::vector<std::string> render(const std::vector<uint64_t> &src)
+{
+	std::vector<char> data(src.size() * ETS_BATCH_RFC3339_MAX_LENGTH + 1);
+	std::vector<int32_t> offsets(src.size() + 1, 0);
+	check(EternalTimestampLayoutBatch<Layout>::cvt_to_rfc3339_column(data.data(), data.size(), offsets.data(), nullptr, src.data(), 0, src.size()) == src.size(), "cvt_to_rfc3339_column()");
+	std::vector<std::string> text;
+	for (size_t i = 0; i < src.size(); i++)
+		text.push_back(std::string(data.data() + offsets[i], offsets[i + 1] - offsets[i]));
+	return text;
+}
+
+// The batch kernels work on the fields of the layout: they agree with the library's own format within its
+// range, and cover the whole range of the extended layout.
+static void test_layout_batch()
+{
+	typedef EternalTimestampLayoutBatch<Extended> ExtendedBatch;
+	std::mt19937_64 rng(4242);
+
+	// from and to UNIX time, against `EternalTimestampBatch` and a conversion of its results.
+	const int64_t lo = -374580979200LL * 1000000, hi = 1237979203199LL * 1000000 + 999999;
+	const size_t lengths[] = { 0, 1, 9, 10007, 3 * ETS_PARALLEL_GRAIN + 13 };
+	for (size_t n : lengths) {
+		std::vector<int64_t> usecs(n);
+		for (size_t i = 0; i < n; i++)
+			usecs[i] = (i % 64 == 63 ? static_cast<int64_t>(rng()) : lo + static_cast<int64_t>(rng() % static_cast<uint64_t>(hi - lo + 1)));
+
+		std::vector<eternal_timestamp_t> native(n);
+		std::vector<uint8_t> native_validity(n / 8 + 1, 0);
+		const size_t native_failed = EternalTimestampBatch::cvt_from_unix_usecs(native.data(), native_validity.data(), usecs.data(), n);
+		std::vector<uint64_t> x(n);
+		std::vector<uint8_t> validity(n / 8 + 1, 0);
+		const size_t failed = ExtendedBatch::cvt_from_unix_usecs(x.data(), validity.data(), usecs.data(), n, ETS_PARALLELISM_ALL);
+		check(failed <= native_failed, "cvt_from_unix_usecs(): the extended range holds the native one");
+		bool same = true;
+		for (size_t i = 0; i < n; i++) {
+			uint64_t y;
+			if (bit(native_validity, i))
+				same = same && bit(validity, i) && Extended::cvt_from_native(y, native[i]) == 0 && y == x[i];
+		}
+		check(same, "cvt_from_unix_usecs() == EternalTimestampBatch::cvt_from_unix_usecs()");
+
+		std::vector<int64_t> back(n);
+		std::vector<uint8_t> back_validity(n / 8 + 1, 0);
+		check(ExtendedBatch::cvt_to_unix_usecs(back.data(), back_validity.data(), x.data(), n, ETS_PARALLELISM_ALL) == failed, "cvt_to_unix_usecs(): failures");
+		same = true;
+		for (size_t i = 0; i < n; i++)
+			same = same && bit(back_validity, i) == bit(validity, i) && (!bit(validity, i) || back[i] == usecs[i]);
+		check(same, "cvt_to_unix_usecs(): round trip");
+	}
+
+	// beyond the native range: 48000 years, i.e. 120 Gregorian cycles, after 2000-06-07T08:09:10.111213Z.
+	const int64_t cycles = 120LL * 146097 * 86400 * 1000000;
+	const int64_t usecs = 960365350111213LL + cycles;
+	eternal_timestamp_t n;
+	uint64_t x = 0;
+	uint8_t validity = 0;
+	check(EternalTimestampBatch::cvt_from_unix_usecs(&n, nullptr, &usecs, 1) == 1, "+50000: beyond the native range");
+	check(ExtendedBatch::cvt_from_unix_usecs(&x, &validity, &usecs, 1) == 0 && validity == 1, "+50000: cvt_from_unix_usecs()");
+	check(render<Extended>({ x })[0] == "+50000-06-07T08:09:10.111213Z", "+50000: cvt_to_rfc3339_column()");
+	const char text[] = "+50000-06-07T08:09:10.111213Z";
+	const int32_t offsets[2] = { 0, static_cast<int32_t>(strlen(text)) };
+	uint64_t parsed = 0;
+	check(ExtendedBatch::cvt_from_iso8601_column(&parsed, nullptr, text, offsets, 1) == 0 && parsed == x, "+50000: cvt_from_iso8601_column()");
+	int64_t back = 0;
+	check(ExtendedBatch::cvt_to_unix_usecs(&back, nullptr, &x, 1) == 0 && back == usecs, "+50000: cvt_to_unix_usecs()");
+	check(ExtendedBatch::cvt_to_unix_msecs(&back, nullptr, &x, 1) == 0 && back == usecs / 1000, "+50000: cvt_to_unix_msecs()");
+	check(ExtendedBatch::cvt_to_unix_seconds(&back, nullptr, &x, 1) == 0 && back == usecs / 1000000, "+50000: cvt_to_unix_seconds()");
+	int32_t days = 0;
+	check(ExtendedBatch::cvt_to_unix_days(&days, nullptr, &x, 1) == 0 && days == usecs / 86400000000LL, "+50000: cvt_to_unix_days()");
+	check(ExtendedBatch::cvt_from_unix_days(&x, nullptr, &days, 1) == 0 && render<Extended>({ x })[0] == "+50000-06-07", "+50000: cvt_from_unix_days()");
+	const int64_t seconds = usecs / 1000000 - 3600, msecs = usecs / 1000 + 1;
+	check(ExtendedBatch::cvt_from_unix_seconds(&x, nullptr, &seconds, 1) == 0 && render<Extended>({ x })[0] == "+50000-06-07T07:09:10.000000Z", "+50000: cvt_from_unix_seconds()");
+	check(ExtendedBatch::cvt_from_unix_msecs(&x, nullptr, &msecs, 1) == 0 && render<Extended>({ x })[0] == "+50000-06-07T08:09:10.112000Z", "+50000: cvt_from_unix_msecs()");
+	const int64_t too_far = INT64_C(1) << 62;
+	check(ExtendedBatch::cvt_from_unix_usecs(&x, &validity, &too_far, 1) == 1 && validity == 0 && x == Extended::unknown(), "beyond the extended range");
+
+	// the parser and the renderer produce the same values and text as the library's own format does, in
+	// either layout.
+	std::vector<uint64_t> native, extended, flipped;
+	std::string column;
+	std::vector<int32_t> column_offsets(1, 0);
+	for (const char *s : samples) {
+		uint64_t y;
+		native.push_back(parse(s).t);
+		check(Extended::cvt_from_native(y, parse(s)) == 0, s);
+		extended.push_back(y);
+		check(Flipped::cvt_from_native(y, parse(s)) == 0, s);
+		flipped.push_back(y);
+		column += s;
+		column_offsets.push_back(static_cast<int32_t>(column.size()));
+	}
+	const size_t count = native.size();
+	std::vector<uint64_t> e(count), f(count);
+	check(ExtendedBatch::cvt_from_iso8601_column(e.data(), nullptr, column.data(), column_offsets.data(), count) == 0 && e == extended, "cvt_from_iso8601_column(): extended");
+	check(EternalTimestampLayoutBatch<Flipped>::cvt_from_iso8601_column(f.data(), nullptr, column.data(), column_offsets.data(), count) == 0 && f == flipped, "cvt_from_iso8601_column(): flipped markers");
+	check(render<Extended>(extended) == render<Native>(native) && render<Flipped>(flipped) == render<Native>(native), "cvt_to_rfc3339_column(): all layouts");
+
+	check(ets_layout_extended_cvt_from_unix_usecs(&x, nullptr, &usecs, 1) == 0 && ets_layout_extended_cvt_to_unix_usecs(&back, nullptr, &x, 1) == 0 && back == usecs, "ets_layout_extended_cvt_from_unix_usecs() / ets_layout_extended_cvt_to_unix_usecs()");
+}
+
+// The runtime transcoder against the templates, both ways, single values and in bulk.
+static void test_transcoder()
+{
+	typedef EternalTimestampUnspecifiedFirstLayout First;
+	typedef EternalTimestampUnspecifiedLastLayout Last;
+	std::mt19937_64 rng(47);
+
+	check(Native::unknown() == (ETS_UNSPECIFIED_NATIVE == ETS_UNSPECIFIED_SORTS_FIRST ? First::unknown() : Last::unknown()), "ETS_UNSPECIFIED_NATIVE");
+	for (int i = 0; i < 100000; i++) {
+		uint64_t t = (i < 17 ? parse(samples[i]).t : rng());
+		if (i >= 17 && i % 3)
+			t &= ~1ULL;
+		uint64_t a, b, back;
+		int ra = EternalTimestampMarkerTranscoder::transcode(a, t, ETS_UNSPECIFIED_SORTS_FIRST, ETS_UNSPECIFIED_SORTS_LAST);
+		int rb = Last::cvt_from_layout<First>(b, t);
+		check(ra == rb && a == b, "first -> last");
+		if (ra == 0)
+			check(EternalTimestampMarkerTranscoder::transcode(back, a, ETS_UNSPECIFIED_SORTS_LAST, ETS_UNSPECIFIED_SORTS_FIRST) == 0 && back == t, "first -> last -> first");
+
+		ra = EternalTimestampMarkerTranscoder::transcode(a, t, ETS_UNSPECIFIED_SORTS_LAST, ETS_UNSPECIFIED_SORTS_FIRST);
+		rb = First::cvt_from_layout<Last>(b, t);
+		check(ra == rb && a == b, "last -> first");
+
+		ra = EternalTimestampMarkerTranscoder::transcode(a, t, ETS_UNSPECIFIED_SORTS_LAST, ETS_UNSPECIFIED_SORTS_LAST);
+		rb = Last::cvt_from_layout<Last>(b, t);
+		check(ra == rb && a == b, "last -> last");
+	}
+
+	// the sort order carries over: a field which was 'unspecified' now sorts after all values.
+	uint64_t y, ym;
+	const eternal_timestamp_t year = parse("2020"), month = parse("2020-12");
+	if (ETS_UNSPECIFIED_NATIVE == ETS_UNSPECIFIED_SORTS_FIRST) {
+		check(ets_layout_transcode_markers(&y, year.t, ETS_UNSPECIFIED_SORTS_FIRST, ETS_UNSPECIFIED_SORTS_LAST) == 0
+			&& ets_layout_transcode_markers(&ym, month.t, ETS_UNSPECIFIED_SORTS_FIRST, ETS_UNSPECIFIED_SORTS_LAST) == 0
+			&& Last::calc_sort_key(y) > Last::calc_sort_key(ym) && EternalTimestamp::calc_sort_key(year) < EternalTimestamp::calc_sort_key(month), "sort order");
+	}
+
+	const size_t lengths[] = { 0, 1, 2, 7, 8, 9, 17, 64, 65, 3 * ETS_PARALLEL_GRAIN + 13 };
+	for (size_t n : lengths) {
+		std::vector<uint64_t> src(n);
+		for (size_t i = 0; i < n; i++)
+			src[i] = rng() & ~static_cast<uint64_t>(rng() % 8 != 0);
+
+		for (const ets_unspecified_marker_t from : { ETS_UNSPECIFIED_SORTS_FIRST, ETS_UNSPECIFIED_SORTS_LAST }) {
+			for (const ets_unspecified_marker_t to : { ETS_UNSPECIFIED_SORTS_FIRST, ETS_UNSPECIFIED_SORTS_LAST }) {
+				std::vector<uint64_t> dst(n + 1, 0);
+				std::vector<uint8_t> validity(n / 8 + 1, 0xAA);
+				const uint8_t tail = validity.back();
+				const size_t failed = EternalTimestampMarkerTranscoder::transcode_batch(dst.data(), validity.data(), src.data(), n, from, to, ETS_PARALLELISM_ALL);
+				size_t expected = 0;
+				bool same = true;
+				for (size_t i = 0; i < n; i++) {
+					uint64_t x;
+					const bool ok = (EternalTimestampMarkerTranscoder::transcode(x, src[i], from, to) == 0);
+					expected += !ok;
+					same = same && x == dst[i] && bit(validity, i) == ok;
+				}
+				check(same && failed == expected, "transcode_batch() == transcode()");
+				check((validity.back() & ~((1U << (n % 8)) - 1) & 0xFF) == (tail & ~((1U << (n % 8)) - 1) & 0xFF), "transcode_batch(): bits beyond the end");
+				check(dst[n] == 0, "transcode_batch(): values beyond the end");
+
+				// in place, as for a memory mapped column
+				std::vector<uint64_t> column = src;
+				check(ets_layout_transcode_markers_batch(column.data(), nullptr, column.data(), n, from, to) == failed && column == std::vector<uint64_t>(dst.begin(), dst.begin() + n), "transcode_batch(): in place");
+			}
+		}
+	}
+}
+
+static void test_c_interface()
+{
+	const eternal_timestamp_t t = parse("2020-09-13T12:30:15");
+	eternal_timestamp_t back;
+	uint64_t x;
+	check(ets_layout_cvt_to_extended(&x, t) == 0 && ets_layout_cvt_from_extended(&back, x) == 0 && back.t == t.t, "ets_layout_cvt_to_extended() / ets_layout_cvt_from_extended()");
+	check(ets_layout_extended_sort_key(x) == EternalTimestamp::calc_sort_key(t), "ets_layout_extended_sort_key()");
+	check(ets_layout_cvt_to_extended_batch(&x, nullptr, &t, 1) == 0, "ets_layout_cvt_to_extended_batch()");
+	check(ets_layout_cvt_from_extended_batch(&back, nullptr, &x, 1) == 0 && back.t == t.t, "ets_layout_cvt_from_extended_batch()");
+}
+
+
+#if defined(BUILD_MONOLITHIC)
+#define main(cnt, arr)      eternalty_test_layout_main(cnt, arr)
+#endif
+
+int main(int argc, const char **argv)
+{
+	(void)argc;
+	(void)argv;
+
+	fprintf(stderr, "Eternal Timestamp Test (layout templates)\n\n");
+
+	test_native_layout();
+	test_sort_key();
+	test_conversions();
+	test_batch();
+	test_layout_batch();
+	test_transcoder();
+	test_c_interface();
+
+	if (failures) {
+		fprintf(stderr, "\n%d test(s) FAILED\n", failures);
+		return EXIT_FAILURE;
+	}
+	fprintf(stderr, "All tests passed\n");
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,212 @@
+
+#include <eternal_timestamp/eternal_timestamp.h>
+#include <eternal_timestamp/eternal_timestamp_batch.h>
+#include <eternal_timestamp/eternal_timestamp_format.h>
+#include <eternal_timestamp/eternal_timestamp_leap.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "monolithic_examples.h"
+
+
+using namespace eternal_timestamp;
+
+static int failures = 0;
+
+static eternal_timestamp_t iso(const char *str)
+{
+	eternal_timestamp_t t{0};
+	if (EternalTimestamp::cvt_from_iso8601(t, str, strlen(str))) {
+		fprintf(stderr, "FAIL: cannot parse test input '%s'\n", str);
+		failures++;
+	}
+	return t;
+}
+
+static std::string text(const eternal_timestamp_t t)
+{
+	static ets_format_pattern_t fmt;
+	static const int compiled = EternalTimestampFormat::compile(fmt, ETS_FORMAT_ISO8601, nullptr);
+	(void)compiled;
+	char buf[64];
+	EternalTimestampFormat::format(buf, sizeof(buf), fmt, t);
+	return buf;
+}
+
+static const char *scale_name(ets_time_scale scale)
+{
+	return (scale == ETS_SCALE_UTC ? "UTC" : scale == ETS_SCALE_TAI ? "TAI" : "GPS");
+}
+
+// `expected` NULL: the conversion should fail
+static void check(const char *str, ets_time_scale from, ets_time_scale to, const char *expected)
+{
+	const eternal_timestamp_t src = iso(str);
+	eternal_timestamp_t dst;
+	uint8_t validity = 0;
+	const size_t n = EternalTimestampLeapSeconds::cvt_time_scale(&dst, &validity, &src, 1, from, to);
+	const bool ok = (expected ? n == 0 && validity == 1 && text(dst) == expected : n == 1 && validity == 0 && dst.t == src.t);
+	if (!ok) {
+		fprintf(stderr, "FAIL: %s %s to %s: expected %s, got %s\n", scale_name(from), str, scale_name(to), expected ? expected : "failure", n ? "failure" : text(dst).c_str());
+		failures++;
+	}
+}
+
+static void check_delta(const char *from, const char *to, int64_t expected)
+{
+	const eternal_timestamp_t a = iso(from);
+	const eternal_timestamp_t b = iso(to);
+	int64_t delta = -1;
+	uint8_t validity = 0;
+	EternalTimestampLeapSeconds::calc_delta_usecs(&delta, &validity, &a, &b, 1);
+	if (validity != 1 || delta != expected) {
+		fprintf(stderr, "FAIL: %s - %s: expected %lld usecs, got %lld\n", to, from, static_cast<long long>(expected), static_cast<long long>(delta));
+		failures++;
+	}
+}
+
+
+#if defined(BUILD_MONOLITHIC)
+#define main(cnt, arr)      eternalty_test_leap_main(cnt, arr)
+#endif
+
+int main(int argc, const char **argv)
+{
+	fprintf(stderr, "Eternal Timestamp Test (leap seconds, TAI, GPS)\n\n");
+
+	if (EternalTimestampLeapSeconds::tai_minus_utc(1483228799) != 36 || EternalTimestampLeapSeconds::tai_minus_utc(1483228800) != 37 || EternalTimestampLeapSeconds::tai_minus_utc(0) != 10) {
+		fprintf(stderr, "FAIL: TAI - UTC around 2017/jan/01\n");
+		failures++;
+	}
+
+	// the leap second at the end of 2016
+	check("2016-12-31T23:59:59", ETS_SCALE_UTC, ETS_SCALE_TAI, "2017-01-01T00:00:35");
+	check("2016-12-31T23:59:60", ETS_SCALE_UTC, ETS_SCALE_TAI, "2017-01-01T00:00:36");
+	check("2017-01-01T00:00:00", ETS_SCALE_UTC, ETS_SCALE_TAI, "2017-01-01T00:00:37");
+	check("2016-12-31T23:59:60.5", ETS_SCALE_UTC, ETS_SCALE_GPS, "2017-01-01T00:00:17.500");
+	check("2017-01-01T00:00:35", ETS_SCALE_TAI, ETS_SCALE_UTC, "2016-12-31T23:59:59");
+	check("2017-01-01T00:00:36.123456", ETS_SCALE_TAI, ETS_SCALE_UTC, "2016-12-31T23:59:60.123456");
+	check("2017-01-01T00:00:37", ETS_SCALE_TAI, ETS_SCALE_UTC, "2017-01-01T00:00:00");
+	check("2017-01-01T00:00:17", ETS_SCALE_GPS, ETS_SCALE_UTC, "2016-12-31T23:59:60");
+	check("2016-12-31T23:59:60", ETS_SCALE_UTC, ETS_SCALE_UTC, "2016-12-31T23:59:60");
+	check("1972-06-30T23:59:60", ETS_SCALE_UTC, ETS_SCALE_TAI, "1972-07-01T00:00:10");
+
+	// GPS time
+	check("1980-01-06T00:00:00", ETS_SCALE_GPS, ETS_SCALE_UTC, "1980-01-06T00:00:00");
+	check("2022-01-13T12:40:31.049", ETS_SCALE_UTC, ETS_SCALE_GPS, "2022-01-13T12:40:49.049");
+	check("2022-01-13T12:40:49.049", ETS_SCALE_GPS, ETS_SCALE_TAI, "2022-01-13T12:41:08.049");
+
+	// no such leap second, leap seconds in time scales which have none, partial timestamps
+	check("2015-12-31T23:59:60", ETS_SCALE_UTC, ETS_SCALE_TAI, nullptr);
+	check("2016-12-31T23:58:60", ETS_SCALE_UTC, ETS_SCALE_TAI, nullptr);
+	check("2016-12-31T23:59:60", ETS_SCALE_TAI, ETS_SCALE_UTC, nullptr);
+	check("2016-12-31T23:59", ETS_SCALE_UTC, ETS_SCALE_TAI, nullptr);
+	check("2016-12-31", ETS_SCALE_UTC, ETS_SCALE_TAI, nullptr);
+
+	// fields out of their range: feb/30 in a leap year, month 13
+	{
+		const eternal_timestamp_t base = iso("2016-02-13T12:00:00");
+		const eternal_timestamp_t bad[2] = { ets_modern_set_day(base, ets_modern_day(base) + 17), ets_modern_set_month(base, ets_modern_month(base) + 11) };
+		eternal_timestamp_t out[2];
+		int64_t delta[2] = { -1, -1 };
+		uint8_t validity = 0xFF;
+		size_t n = EternalTimestampLeapSeconds::cvt_time_scale(out, &validity, bad, 2, ETS_SCALE_UTC, ETS_SCALE_TAI);
+		bool ok = (n == 2 && (validity & 3) == 0 && out[0].t == bad[0].t && out[1].t == bad[1].t);
+		const eternal_timestamp_t from[2] = { base, base };
+		validity = 0xFF;
+		n = EternalTimestampLeapSeconds::calc_delta_usecs(delta, &validity, from, bad, 2);
+		ok = ok && n == 2 && (validity & 3) == 0 && delta[0] == 0 && delta[1] == 0;
+		if (!ok) {
+			fprintf(stderr, "FAIL: out of range fields were converted\n");
+			failures++;
+		}
+	}
+
+	// a whole frame, one call: every TAI second maps to a distinct UTC reading, the leap second included
+	{
+		const size_t count = 40;
+		std::vector<int64_t> tai_seconds(count);
+		for (size_t i = 0; i < count; i++)
+			tai_seconds[i] = 1483228800 + 36 - 20 + static_cast<int64_t>(i);
+		std::vector<eternal_timestamp_t> tai(count), utc(count), back(count);
+		EternalTimestampBatch::cvt_from_unix_seconds(tai.data(), nullptr, tai_seconds.data(), count);
+		std::vector<uint8_t> validity((count + 7) / 8);
+		size_t n = EternalTimestampLeapSeconds::cvt_time_scale(utc.data(), validity.data(), tai.data(), count, ETS_SCALE_TAI, ETS_SCALE_UTC);
+		n += EternalTimestampLeapSeconds::cvt_time_scale(back.data(), validity.data(), utc.data(), count, ETS_SCALE_UTC, ETS_SCALE_TAI);
+		int leaps = 0;
+		for (size_t i = 0; i < count; i++) {
+			if (back[i].t != tai[i].t || (i && text(utc[i]) <= text(utc[i - 1]))) {
+				fprintf(stderr, "FAIL: frame: TAI %s -> UTC %s -> TAI %s\n", text(tai[i]).c_str(), text(utc[i]).c_str(), text(back[i]).c_str());
+				failures++;
+				break;
+			}
+			leaps += (text(utc[i]) == "2016-12-31T23:59:60.000000");
+		}
+		if (n || leaps != 1) {
+			fprintf(stderr, "FAIL: frame: %zu failures, %d leap seconds\n", n, leaps);
+			failures++;
+		}
+	}
+
+	// exact deltas
+	check_delta("2016-12-31T23:59:59", "2017-01-01T00:00:00", 2000000);
+	check_delta("2016-12-31T23:59:60", "2017-01-01T00:00:00", 1000000);
+	check_delta("2017-01-01T00:00:00", "2016-12-31T23:59:59.5", -1500000);
+	check_delta("2016-12-31", "2017-01-01", 86401000000LL);
+	check_delta("1972-01-01", "2017-01-01", (1483228800LL - 63072000 + 27) * 1000000);
+	check_delta("2022-01-13T12", "2022-01-13T12:40:31.049352", 2431049352LL);
+
+	// custom tables: a (hypothetical) negative leap second drops 23:59:59
+	{
+		const ets_leap_second_t entries[] = { { 63072000, 10 }, { 1483228800, 11 }, { 1900000000 - 1900000000 % 86400, 10 } };
+		if (EternalTimestampLeapSeconds::set_table(entries, 3, 0) || EternalTimestampLeapSeconds::table_expiry() != 0) {
+			fprintf(stderr, "FAIL: cannot set a custom table\n");
+			failures++;
+		}
+		check("2030-03-16T23:59:58", ETS_SCALE_UTC, ETS_SCALE_TAI, "2030-03-17T00:00:09");
+		check("2030-03-17T00:00:09", ETS_SCALE_TAI, ETS_SCALE_UTC, "2030-03-16T23:59:58");
+		check("2030-03-17T00:00:10", ETS_SCALE_TAI, ETS_SCALE_UTC, "2030-03-17T00:00:00");
+		check("2016-12-31T23:59:60", ETS_SCALE_UTC, ETS_SCALE_TAI, "2017-01-01T00:00:10");
+
+		const ets_leap_second_t bad[] = { { 63072000, 10 }, { 78796800, 12 } };
+		if (EternalTimestampLeapSeconds::set_table(bad, 2, 0) != EINVAL || EternalTimestampLeapSeconds::set_table(entries, 0, 0) != EINVAL) {
+			fprintf(stderr, "FAIL: an invalid table was accepted\n");
+			failures++;
+		}
+
+		EternalTimestampLeapSeconds::reset_table();
+		check("2016-12-31T23:59:60", ETS_SCALE_UTC, ETS_SCALE_TAI, "2017-01-01T00:00:36");
+	}
+
+	// the system's copy of the IERS table, when there is one, should agree with ours
+	if (!EternalTimestampLeapSeconds::load_table(nullptr)) {
+		fprintf(stderr, "  ... loaded the system's leap-seconds.list\n");
+		for (int64_t t = 0; t < 1800000000; t += 86400 / 2) {
+			if (EternalTimestampLeapSeconds::tai_minus_utc(t) != ets_leap_tai_minus_utc(t)) {
+				fprintf(stderr, "FAIL: C and C++ interfaces disagree\n");
+				failures++;
+				break;
+			}
+		}
+		if (EternalTimestampLeapSeconds::table_expiry() <= 1483228800 || EternalTimestampLeapSeconds::tai_minus_utc(1483228800) != 37) {
+			fprintf(stderr, "FAIL: the system's leap-seconds.list does not match\n");
+			failures++;
+		}
+		EternalTimestampLeapSeconds::reset_table();
+	}
+	if (EternalTimestampLeapSeconds::load_table("/nonexistent/leap-seconds.list") != ENOENT) {
+		fprintf(stderr, "FAIL: loading a nonexistent file should fail\n");
+		failures++;
+	}
+
+	if (failures) {
+		fprintf(stderr, "\n%d test(s) FAILED\n", failures);
+		return EXIT_FAILURE;
+	}
+	fprintf(stderr, "All tests passed\n");
+	return EXIT_SUCCESS;
+}
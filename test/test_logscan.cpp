@@ -0,0 +1,195 @@
+
+#include <eternal_timestamp/eternal_timestamp.h>
+#include <eternal_timestamp/eternal_timestamp_logscan.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "monolithic_examples.h"
+
+
+using namespace eternal_timestamp;
+
+static int failures = 0;
+
+static void check(bool ok, const char *what)
+{
+	if (!ok) {
+		fprintf(stderr, "FAIL: %s\n", what);
+		failures++;
+	}
+}
+
+static eternal_timestamp_t parse(const char *iso8601)
+{
+	eternal_timestamp_t t;
+	t.t = 0;
+	EternalTimestamp::cvt_from_iso8601(t, iso8601, strlen(iso8601));
+	return t;
+}
+
+static bool is_unknown(const eternal_timestamp_t t)
+{
+	return t.t == EternalTimestamp::unknown().t;
+}
+
+// parse a single line in the given (or detected) format and compare against the ISO 8601 rendering.
+static bool line_is(const char *line, ets_log_format_t format, const char *expected, int year = 2022)
+{
+	ets_logscan_state_t state;
+	EternalTimestampLogScan::init(state, format, year);
+	eternal_timestamp_t t;
+	if (!EternalTimestampLogScan::parse_line(t, state, line, strlen(line)))
+		return false;
+	return t.t == parse(expected).t;
+}
+
+static bool line_fails(const char *line, ets_log_format_t format, int year = 2022)
+{
+	ets_logscan_state_t state;
+	EternalTimestampLogScan::init(state, format, year);
+	eternal_timestamp_t t;
+	return !EternalTimestampLogScan::parse_line(t, state, line, strlen(line)) && is_unknown(t);
+}
+
+static void test_formats()
+{
+	const char *rfc3339 = "2022-01-13T12:40:31.049352Z GET /index.html";
+	const char *rfc5424 = "<34>1 2022-01-13T12:40:31.049Z host app - - - message";
+	const char *rfc3164 = "<34>Jan 13 12:40:31 host app: message";
+	const char *clf = "127.0.0.1 - - [13/Jan/2022:12:40:31 +0000] \"GET / HTTP/1.1\" 200 612";
+	const char *nginx = "2022/01/13 12:40:31 [error] 1234#0: *1 open() failed";
+	const char *apache = "[Thu Jan 13 12:40:31.049352 2022] [core:error] [pid 1234] message";
+
+	check(EternalTimestampLogScan::detect_format(rfc3339, strlen(rfc3339)) == ETS_LOG_FORMAT_RFC3339, "detect RFC 3339");
+	check(EternalTimestampLogScan::detect_format(rfc5424, strlen(rfc5424)) == ETS_LOG_FORMAT_SYSLOG_RFC5424, "detect RFC 5424 syslog");
+	check(EternalTimestampLogScan::detect_format(rfc3164, strlen(rfc3164)) == ETS_LOG_FORMAT_SYSLOG_RFC3164, "detect RFC 3164 syslog");
+	check(EternalTimestampLogScan::detect_format(clf, strlen(clf)) == ETS_LOG_FORMAT_COMMON_LOG, "detect the Common Log Format");
+	check(EternalTimestampLogScan::detect_format(nginx, strlen(nginx)) == ETS_LOG_FORMAT_NGINX_ERROR, "detect the nginx error log");
+	check(EternalTimestampLogScan::detect_format(apache, strlen(apache)) == ETS_LOG_FORMAT_APACHE_ERROR, "detect the Apache error log");
+	check(EternalTimestampLogScan::detect_format("at java.lang.Thread.run", 23) == ETS_LOG_FORMAT_UNKNOWN, "detect nothing in a stack trace");
+
+	check(line_is(rfc3339, ETS_LOG_FORMAT_UNKNOWN, "2022-01-13T12:40:31.049352"), "RFC 3339");
+	check(line_is("2022-01-13 12:40:31,049 INFO message", ETS_LOG_FORMAT_RFC3339, "2022-01-13T12:40:31.049"), "RFC 3339 with a space and a comma");
+	check(line_is("[2022-01-13T12:40:31+01:00] message", ETS_LOG_FORMAT_RFC3339, "2022-01-13T11:40:31"), "RFC 3339 bracketed, with a UTC offset");
+	check(line_is("2022-01-01T00:30:00-0130 message", ETS_LOG_FORMAT_RFC3339, "2022-01-01T02:00:00"), "RFC 3339 with a negative UTC offset");
+	check(line_is("2022-01-01T00:30:00+01:00", ETS_LOG_FORMAT_RFC3339, "2021-12-31T23:30:00"), "a UTC offset crossing new year");
+	check(line_is(rfc5424, ETS_LOG_FORMAT_UNKNOWN, "2022-01-13T12:40:31.049"), "RFC 5424 syslog");
+	check(line_is(rfc3164, ETS_LOG_FORMAT_UNKNOWN, "2022-01-13T12:40:31"), "RFC 3164 syslog");
+	check(line_is("Jan  3 02:04:05 host app: message", ETS_LOG_FORMAT_SYSLOG_RFC3164, "2021-01-03T02:04:05", 2021), "RFC 3164 syslog, space padded day, no priority");
+	check(line_is(clf, ETS_LOG_FORMAT_UNKNOWN, "2022-01-13T12:40:31"), "the Common Log Format");
+	check(line_is("::1 - frank [10/Oct/2000:13:55:36 -0700] \"GET /apache_pb.gif HTTP/1.0\" 200 2326", ETS_LOG_FORMAT_COMMON_LOG, "2000-10-10T20:55:36"), "the Common Log Format with a UTC offset");
+	check(line_is(nginx, ETS_LOG_FORMAT_UNKNOWN, "2022-01-13T12:40:31"), "the nginx error log");
+	check(line_is(apache, ETS_LOG_FORMAT_UNKNOWN, "2022-01-13T12:40:31.049352"), "the Apache error log");
+	check(line_is("[Thu Jan  6 02:04:05 2022] [core:error] message", ETS_LOG_FORMAT_APACHE_ERROR, "2022-01-06T02:04:05"), "the Apache error log without fraction");
+
+	// a line in another format does not match a preset one
+	check(line_fails(nginx, ETS_LOG_FORMAT_RFC3339), "nginx is not RFC 3339");
+	check(line_fails(rfc3339, ETS_LOG_FORMAT_COMMON_LOG), "RFC 3339 is not the Common Log Format");
+	check(line_fails("", ETS_LOG_FORMAT_RFC3339), "an empty line");
+	check(line_fails("2022-01-13T12:40", ETS_LOG_FORMAT_RFC3339), "a truncated line");
+}
+
+static void test_ranges()
+{
+	check(line_fails("2022-13-01T12:40:31Z", ETS_LOG_FORMAT_RFC3339), "month 13");
+	check(line_fails("2022-01-32T12:40:31Z", ETS_LOG_FORMAT_RFC3339), "January 32nd");
+	check(line_fails("2022-02-31T12:40:31Z", ETS_LOG_FORMAT_RFC3339), "February 31st");
+	check(line_fails("2022-04-31T12:40:31Z", ETS_LOG_FORMAT_RFC3339), "April 31st");
+	check(line_fails("2022-02-29T12:40:31Z", ETS_LOG_FORMAT_RFC3339), "Feb 29 in a common year");
+	check(line_fails("1900-02-29T12:40:31Z", ETS_LOG_FORMAT_RFC3339), "Feb 29 in a common century year");
+	check(line_is("2000-02-29T12:40:31Z", ETS_LOG_FORMAT_RFC3339, "2000-02-29T12:40:31"), "Feb 29 in a leap century year");
+	check(line_is("2024/02/29 12:40:31 [error]", ETS_LOG_FORMAT_NGINX_ERROR, "2024-02-29T12:40:31"), "Feb 29 in a leap year");
+	check(line_fails("2022-01-13T24:00:00Z", ETS_LOG_FORMAT_RFC3339), "hour 24");
+	check(line_is("2016-12-31T23:59:60Z", ETS_LOG_FORMAT_RFC3339, "2016-12-31T23:59:60"), "a leap second");
+	check(line_fails("127.0.0.1 - - [31/Jun/2022:12:40:31 +0000] \"GET /\"", ETS_LOG_FORMAT_COMMON_LOG), "June 31st in the Common Log Format");
+	check(line_fails("[Wed Sep 31 12:40:31 2022] [core:error]", ETS_LOG_FORMAT_APACHE_ERROR), "September 31st in the Apache error log");
+
+	// RFC 3164: the year is only known once the state supplies it
+	check(line_is("Feb 29 12:40:31 host app:", ETS_LOG_FORMAT_SYSLOG_RFC3164, "2024-02-29T12:40:31", 2024), "RFC 3164 Feb 29 in a leap year");
+	check(line_fails("Feb 29 12:40:31 host app:", ETS_LOG_FORMAT_SYSLOG_RFC3164, 2023), "RFC 3164 Feb 29 in a common year");
+	check(line_fails("Feb 30 12:40:31 host app:", ETS_LOG_FORMAT_SYSLOG_RFC3164, 2024), "RFC 3164 Feb 30");
+}
+
+static void test_rfc3164_rollover()
+{
+	const char log[] =
+		"Dec 30 23:59:58 host app: one\n"
+		"Dec 31 23:59:59 host app: two\n"
+		"Jan  1 00:00:00 host app: three\n"
+		"Jan  1 00:00:01 host app: four\n"
+		"Mar  1 00:00:00 host app: five\n"
+		"Dec 31 00:00:00 host app: six\n"
+		"Jan  1 00:00:00 host app: seven\n";
+	eternal_timestamp_t ts[8];
+	size_t consumed = 0;
+	ets_logscan_state_t state;
+	EternalTimestampLogScan::init(state, ETS_LOG_FORMAT_UNKNOWN, 2021);
+	check(EternalTimestampLogScan::scan(ts, nullptr, 8, state, log, sizeof(log) - 1, false, consumed) == 7 && consumed == sizeof(log) - 1, "scan all syslog lines");
+	check(state.format == ETS_LOG_FORMAT_SYSLOG_RFC3164, "the format is detected");
+	check(ts[0].t == parse("2021-12-30T23:59:58").t && ts[1].t == parse("2021-12-31T23:59:59").t, "the initial year");
+	check(ts[2].t == parse("2022-01-01T00:00:00").t && ts[3].t == parse("2022-01-01T00:00:01").t, "the year advances at new year");
+	check(ts[4].t == parse("2022-03-01T00:00:00").t, "the year stays put when the month advances");
+	// a jump forwards never advances the year; only a jump backwards by more than half a year does.
+	check(ts[5].t == parse("2022-12-31T00:00:00").t && ts[6].t == parse("2023-01-01T00:00:00").t, "a second new year");
+	check(state.year == 2023, "the state keeps the year");
+}
+
+static void test_scan()
+{
+	const std::string log =
+		"2022-01-13T12:40:31.049352Z first\n"
+		"\tat java.lang.Thread.run(Thread.java:750)\n"
+		"\n"
+		"2022-01-13T12:40:32Z second\n"
+		"2022-01-14T00:00:00.5Z third";
+	eternal_timestamp_t ts[8];
+	size_t offsets[8];
+	size_t consumed = 0;
+	ets_logscan_state_t state;
+	EternalTimestampLogScan::init(state, ETS_LOG_FORMAT_UNKNOWN, 2022);
+
+	// without `at_eof` the unterminated last line is left for the next call
+	check(EternalTimestampLogScan::scan(ts, offsets, 8, state, log.data(), log.size(), false, consumed) == 4, "scan the terminated lines");
+	check(consumed == log.rfind('\n') + 1, "the unterminated last line is not consumed");
+	check(offsets[0] == 0 && offsets[1] == 34 && offsets[2] == 76 && offsets[3] == 77, "line offsets");
+	check(ts[0].t == parse("2022-01-13T12:40:31.049352").t && ts[3].t == parse("2022-01-13T12:40:32").t, "timestamps");
+	check(is_unknown(ts[1]) && is_unknown(ts[2]), "lines without a timestamp");
+
+	size_t rest = 0;
+	check(EternalTimestampLogScan::scan(ts, offsets, 8, state, log.data() + consumed, log.size() - consumed, false, rest) == 0 && rest == 0, "nothing more without at_eof");
+	check(EternalTimestampLogScan::scan(ts, offsets, 8, state, log.data() + consumed, log.size() - consumed, true, rest) == 1, "the last line at eof");
+	check(rest == log.size() - consumed && offsets[0] == 0 && ts[0].t == parse("2022-01-14T00:00:00.500").t, "the unterminated last line");
+
+	// capacity limits the lines per call; `consumed` tells where to continue
+	check(EternalTimestampLogScan::scan(ts, offsets, 2, state, log.data(), log.size(), true, consumed) == 2 && consumed == 76, "scan with a small capacity");
+	check(EternalTimestampLogScan::scan(ts, nullptr, 8, state, log.data() + consumed, log.size() - consumed, true, rest) == 3 && consumed + rest == log.size(), "continue after a partial scan");
+	check(is_unknown(ts[0]) && ts[2].t == parse("2022-01-14T00:00:00.500").t, "the continued scan");
+
+	// a trailing newline does not produce an empty last line
+	check(EternalTimestampLogScan::scan(ts, offsets, 8, state, "2022-01-13T12:40:31Z\n", 21, true, consumed) == 1 && consumed == 21, "a terminated last line at eof");
+	check(EternalTimestampLogScan::scan(ts, offsets, 8, state, "", 0, true, consumed) == 0 && consumed == 0, "an empty buffer");
+}
+
+
+#if defined(BUILD_MONOLITHIC)
+#define main(cnt, arr)      eternalty_test_logscan_main(cnt, arr)
+#endif
+
+int main(int argc, const char **argv)
+{
+	fprintf(stderr, "Eternal Timestamp Test (log line scanner)\n\n");
+
+	test_formats();
+	test_ranges();
+	test_rfc3164_rollover();
+	test_scan();
+
+	if (failures) {
+		fprintf(stderr, "\n%d test(s) FAILED\n", failures);
+		return EXIT_FAILURE;
+	}
+	fprintf(stderr, "All tests passed\n");
+	return EXIT_SUCCESS;
+}
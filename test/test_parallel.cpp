@@ -0,0 +1,480 @@
+
+#include <eternal_timestamp/eternal_timestamp.h>
+#include <eternal_timestamp/eternal_timestamp_arrow.h>
+#include <eternal_timestamp/eternal_timestamp_batch.h>
+#include <eternal_timestamp/eternal_timestamp_bibdate.h>
+#include <eternal_timestamp/eternal_timestamp_format.h>
+#include <eternal_timestamp/eternal_timestamp_hash.h>
+#include <eternal_timestamp/eternal_timestamp_leap.h>
+#include <eternal_timestamp/eternal_timestamp_parallel.h>
+#include <eternal_timestamp/eternal_timestamp_tz.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "monolithic_examples.h"
+
+
+using namespace eternal_timestamp;
+
+static int failures = 0;
+
+static void check(bool ok, const char *what)
+{
+	if (!ok) {
+		fprintf(stderr, "FAIL: %s\n", what);
+		failures++;
+	}
+}
+
+// large enough for a dozen chunks, not a multiple of anything in particular.
+static const size_t N = 12 * ETS_PARALLEL_GRAIN + 1234;
+
+static const unsigned int SERIAL = 1;
+static const unsigned int PARALLEL = ETS_PARALLELISM_ALL;
+
+static size_t bitmap_size(size_t count)
+{
+	return (count + 7) / 8;
+}
+
+static bool same(const eternal_timestamp_t *a, const eternal_timestamp_t *b, size_t count)
+{
+	for (size_t i = 0; i < count; i++) {
+		if (a[i].t != b[i].t)
+			return false;
+	}
+	return true;
+}
+
+// Log-like input: mostly ascending, in bursts, with the odd value which the conversions reject.
+static std::vector<eternal_timestamp_t> make_column(size_t count)
+{
+	std::mt19937_64 rng(20260101);
+	std::vector<int64_t> usecs(count);
+	int64_t t = 1600000000LL * 1000000;
+	for (size_t i = 0; i < count; i++) {
+		t += static_cast<int64_t>(rng() % 90000000);
+		usecs[i] = t;
+	}
+	std::vector<eternal_timestamp_t> v(count);
+	EternalTimestampBatch::cvt_from_unix_usecs(v.data(), nullptr, usecs.data(), count, SERIAL);
+
+	for (size_t i = 17; i < count; i += 997) {
+		eternal_timestamp_t &x = v[i];
+		switch (i % 3) {
+		case 0:
+			x.t = 0;
+			x = ets_format_set_mode(x, 1);
+			x = ets_prehistoric_set_years(x, 40000);
+			break;
+		case 1:
+			EternalTimestamp::cvt_from_iso8601(x, "2020-09", 7);
+			break;
+		default:
+			EternalTimestamp::cvt_from_iso8601(x, "2020-09-13T12", 13);
+			break;
+		}
+	}
+	return v;
+}
+
+// An executor which runs everything on the calling thread, counting its invocations.
+static std::atomic<unsigned int> user_runs{ 0 };
+
+static void run_inline(void *context, void (*work)(void *arg, unsigned int worker), void *arg, unsigned int workers)
+{
+	user_runs.fetch_add(1);
+	check(context == &user_runs, "executor context");
+	for (unsigned int i = workers; i-- > 0; )
+		work(arg, i);
+}
+
+static void count_indexes(void *ctx, size_t begin, size_t end)
+{
+	std::atomic<unsigned int> *seen = static_cast<std::atomic<unsigned int> *>(ctx);
+	for (size_t i = begin; i < end; i++)
+		seen[i].fetch_add(1);
+}
+
+static void test_parallel_for(const char *label)
+{
+	const size_t count = 100003;
+	const size_t grain = 1000;
+	std::vector<std::atomic<unsigned int>> seen(count);
+	for (auto &s : seen)
+		s.store(0);
+	std::atomic<bool> aligned{ true };
+
+	EternalTimestampParallel::parallel_for(count, grain, PARALLEL, [&](size_t begin, size_t end) {
+		if (begin % grain != 0 || (end % grain != 0 && end != count) || begin >= end)
+			aligned.store(false);
+		count_indexes(seen.data(), begin, end);
+	});
+	bool once = true;
+	for (auto &s : seen)
+		once &= (s.load() == 1);
+	check(once, label);
+	check(aligned.load(), "parallel_for() ranges consist of whole chunks");
+
+	// the span form
+	std::vector<eternal_timestamp_t> v = make_column(N);
+	std::vector<int64_t> keys(N), expected(N);
+	EternalTimestampBatch::calc_sort_keys(expected.data(), v.data(), N, SERIAL);
+	EternalTimestampParallel::parallel_for(v.data(), N, PARALLEL, [&](eternal_timestamp_t *span, size_t length, size_t offset) {
+		for (size_t i = 0; i < length; i++)
+			keys[offset + i] = EternalTimestamp::calc_sort_key(span[i]);
+	});
+	check(keys == expected, "parallel_for() over a span");
+}
+
+static void test_batch()
+{
+	const std::vector<eternal_timestamp_t> src = make_column(N);
+	std::vector<uint8_t> valid_s(bitmap_size(N)), valid_p(bitmap_size(N));
+	std::vector<eternal_timestamp_t> ts_s(N), ts_p(N);
+	std::vector<int64_t> i64_s(N), i64_p(N);
+	std::vector<int32_t> i32_s(N), i32_p(N);
+
+	// to and from UNIX time
+	{
+		size_t a = EternalTimestampBatch::cvt_to_unix_usecs(i64_s.data(), valid_s.data(), src.data(), N, SERIAL);
+		size_t b = EternalTimestampBatch::cvt_to_unix_usecs(i64_p.data(), valid_p.data(), src.data(), N, PARALLEL);
+		check(a == b && a > 0 && i64_s == i64_p && valid_s == valid_p, "cvt_to_unix_usecs()");
+		EternalTimestampBatch::cvt_from_unix_usecs(ts_s.data(), nullptr, i64_s.data(), N, SERIAL);
+		EternalTimestampBatch::cvt_from_unix_usecs(ts_p.data(), nullptr, i64_s.data(), N, PARALLEL);
+		check(same(ts_s.data(), ts_p.data(), N), "cvt_from_unix_usecs()");
+
+		a = EternalTimestampBatch::cvt_to_unix_msecs(i64_s.data(), valid_s.data(), src.data(), N, SERIAL);
+		b = EternalTimestampBatch::cvt_to_unix_msecs(i64_p.data(), valid_p.data(), src.data(), N, PARALLEL);
+		check(a == b && i64_s == i64_p && valid_s == valid_p, "cvt_to_unix_msecs()");
+		EternalTimestampBatch::cvt_from_unix_msecs(ts_s.data(), nullptr, i64_s.data(), N, SERIAL);
+		EternalTimestampBatch::cvt_from_unix_msecs(ts_p.data(), nullptr, i64_s.data(), N, PARALLEL);
+		check(same(ts_s.data(), ts_p.data(), N), "cvt_from_unix_msecs()");
+
+		a = EternalTimestampBatch::cvt_to_unix_seconds(i64_s.data(), valid_s.data(), src.data(), N, SERIAL);
+		b = EternalTimestampBatch::cvt_to_unix_seconds(i64_p.data(), valid_p.data(), src.data(), N, PARALLEL);
+		check(a == b && i64_s == i64_p && valid_s == valid_p, "cvt_to_unix_seconds()");
+		EternalTimestampBatch::cvt_from_unix_seconds(ts_s.data(), nullptr, i64_s.data(), N, SERIAL);
+		EternalTimestampBatch::cvt_from_unix_seconds(ts_p.data(), nullptr, i64_s.data(), N, PARALLEL);
+		check(same(ts_s.data(), ts_p.data(), N), "cvt_from_unix_seconds()");
+
+		a = EternalTimestampBatch::cvt_to_unix_days(i32_s.data(), valid_s.data(), src.data(), N, SERIAL);
+		b = EternalTimestampBatch::cvt_to_unix_days(i32_p.data(), valid_p.data(), src.data(), N, PARALLEL);
+		check(a == b && i32_s == i32_p && valid_s == valid_p, "cvt_to_unix_days()");
+		EternalTimestampBatch::cvt_from_unix_days(ts_s.data(), nullptr, i32_s.data(), N, SERIAL);
+		EternalTimestampBatch::cvt_from_unix_days(ts_p.data(), nullptr, i32_s.data(), N, PARALLEL);
+		check(same(ts_s.data(), ts_p.data(), N), "cvt_from_unix_days()");
+
+		// without a validity bitmap
+		b = EternalTimestampBatch::cvt_to_unix_usecs(i64_p.data(), nullptr, src.data(), N, PARALLEL);
+		check(a == b, "cvt_to_unix_usecs() without validity bitmap");
+
+		EternalTimestampBatch::calc_sort_keys(i64_s.data(), src.data(), N, SERIAL);
+		EternalTimestampBatch::calc_sort_keys(i64_p.data(), src.data(), N, PARALLEL);
+		check(i64_s == i64_p, "calc_sort_keys()");
+	}
+
+	// RFC 3339 text and back
+	std::vector<char> text_s(N * ETS_BATCH_RFC3339_MAX_LENGTH), text_p(N * ETS_BATCH_RFC3339_MAX_LENGTH);
+	std::vector<int32_t> offsets_s(N + 1), offsets_p(N + 1);
+	{
+		offsets_s[0] = offsets_p[0] = 0;
+		size_t a = EternalTimestampBatch::cvt_to_rfc3339_column(text_s.data(), text_s.size(), offsets_s.data(), valid_s.data(), src.data(), 0, N, SERIAL);
+		size_t b = EternalTimestampBatch::cvt_to_rfc3339_column(text_p.data(), text_p.size(), offsets_p.data(), valid_p.data(), src.data(), 0, N, PARALLEL);
+		const size_t used = static_cast<size_t>(offsets_s[N]);
+		check(a == N && b == N && offsets_s == offsets_p && valid_s == valid_p && !memcmp(text_s.data(), text_p.data(), used), "cvt_to_rfc3339_column()");
+
+		// continuing halfway, at some offset into the buffer
+		const size_t start = 5 * ETS_PARALLEL_GRAIN + 8;
+		std::fill(text_p.begin(), text_p.end(), '\0');
+		std::fill(offsets_p.begin(), offsets_p.end(), 0);
+		offsets_p[start] = offsets_s[start];
+		b = EternalTimestampBatch::cvt_to_rfc3339_column(text_p.data(), text_p.size(), offsets_p.data(), valid_p.data(), src.data(), start, N, PARALLEL);
+		check(b == N && !memcmp(offsets_s.data() + start, offsets_p.data() + start, (N + 1 - start) * sizeof(int32_t)) && !memcmp(text_s.data() + offsets_s[start], text_p.data() + offsets_s[start], used - offsets_s[start]), "cvt_to_rfc3339_column() from `start`");
+
+		// too little room for the worst case: rendered as far as it goes
+		std::vector<char> small(used / 2);
+		offsets_p[0] = 0;
+		b = EternalTimestampBatch::cvt_to_rfc3339_column(small.data(), small.size(), offsets_p.data(), nullptr, src.data(), 0, N, PARALLEL);
+		check(b < N && static_cast<size_t>(offsets_p[b]) <= small.size() && !memcmp(small.data(), text_s.data(), offsets_p[b]), "cvt_to_rfc3339_column() with a full buffer");
+	}
+	{
+		size_t a = EternalTimestampBatch::cvt_from_iso8601_column(ts_s.data(), valid_s.data(), text_s.data(), offsets_s.data(), N, SERIAL);
+		size_t b = EternalTimestampBatch::cvt_from_iso8601_column(ts_p.data(), valid_p.data(), text_s.data(), offsets_s.data(), N, PARALLEL);
+		check(a == b && same(ts_s.data(), ts_p.data(), N) && valid_s == valid_p, "cvt_from_iso8601_column()");
+
+		std::vector<const char *> strings(N);
+		std::vector<size_t> lengths(N);
+		for (size_t i = 0; i < N; i++) {
+			strings[i] = text_s.data() + offsets_s[i];
+			lengths[i] = static_cast<size_t>(offsets_s[i + 1] - offsets_s[i]);
+		}
+		strings[N / 2] = nullptr;
+		lengths[N / 2] = 0;
+		a = EternalTimestampBatch::cvt_from_iso8601(ts_s.data(), valid_s.data(), strings.data(), lengths.data(), N, SERIAL);
+		b = EternalTimestampBatch::cvt_from_iso8601(ts_p.data(), valid_p.data(), strings.data(), lengths.data(), N, PARALLEL);
+		check(a == b && a > 0 && same(ts_s.data(), ts_p.data(), N) && valid_s == valid_p, "cvt_from_iso8601()");
+
+		std::vector<ets_bibdate_info_t> info_s(N), info_p(N);
+		a = EternalTimestampBibDate::parse_column(ts_s.data(), info_s.data(), text_s.data(), offsets_s.data(), N, SERIAL);
+		b = EternalTimestampBibDate::parse_column(ts_p.data(), info_p.data(), text_s.data(), offsets_s.data(), N, PARALLEL);
+		check(a == b && same(ts_s.data(), ts_p.data(), N) && !memcmp(info_s.data(), info_p.data(), N * sizeof(info_s[0])), "EternalTimestampBibDate::parse_column()");
+		a = EternalTimestampBibDate::parse(ts_s.data(), nullptr, strings.data(), lengths.data(), N, SERIAL);
+		b = EternalTimestampBibDate::parse(ts_p.data(), nullptr, strings.data(), lengths.data(), N, PARALLEL);
+		check(a == b && same(ts_s.data(), ts_p.data(), N), "EternalTimestampBibDate::parse()");
+	}
+
+	// formatting
+	{
+		ets_format_pattern_t pattern;
+		check(!EternalTimestampFormat::compile(pattern, "%d/%m/%Y %H:%M:%S", nullptr), "compile the format");
+		std::vector<char> out_s(N * pattern.max_length), out_p(N * pattern.max_length);
+		offsets_s[0] = offsets_p[0] = 0;
+		size_t a = EternalTimestampFormat::format_column(out_s.data(), out_s.size(), offsets_s.data(), pattern, src.data(), N, SERIAL);
+		size_t b = EternalTimestampFormat::format_column(out_p.data(), out_p.size(), offsets_p.data(), pattern, src.data(), N, PARALLEL);
+		check(a == N && b == N && offsets_s == offsets_p && !memcmp(out_s.data(), out_p.data(), offsets_s[N]), "EternalTimestampFormat::format_column()");
+
+		// more than 256 chunks, which are rendered in multiple rounds
+		const size_t M = 260 * ETS_PARALLEL_GRAIN + 77;
+		const std::vector<eternal_timestamp_t> many = make_column(M);
+		check(!EternalTimestampFormat::compile(pattern, "%H:%M", nullptr), "compile the short format");
+		std::vector<char> many_s(M * pattern.max_length), many_p(M * pattern.max_length);
+		std::vector<int32_t> many_offsets_s(M + 1), many_offsets_p(M + 1);
+		a = EternalTimestampFormat::format_column(many_s.data(), many_s.size(), many_offsets_s.data(), pattern, many.data(), M, SERIAL);
+		b = EternalTimestampFormat::format_column(many_p.data(), many_p.size(), many_offsets_p.data(), pattern, many.data(), M, PARALLEL);
+		check(a == M && b == M && many_offsets_s == many_offsets_p && !memcmp(many_s.data(), many_p.data(), many_offsets_s[M]), "EternalTimestampFormat::format_column() of a long column");
+	}
+
+	// Arrow
+	{
+		struct ArrowSchema schema_s, schema_p;
+		struct ArrowArray array_s, array_p;
+		const char *formats[] = { ETS_ARROW_FORMAT_TIMESTAMP_US_UTC, ETS_ARROW_FORMAT_DATE32, ETS_ARROW_FORMAT_DATE64 };
+		for (const char *format : formats) {
+			int rv = EternalTimestampArrow::cvt_to_array(schema_s, array_s, format, src.data(), N, SERIAL);
+			rv |= EternalTimestampArrow::cvt_to_array(schema_p, array_p, format, src.data(), N, PARALLEL);
+			check(!rv, "EternalTimestampArrow::cvt_to_array()");
+			if (rv)
+				continue;
+			const size_t width = (!strcmp(format, ETS_ARROW_FORMAT_DATE32) ? 4 : 8);
+			check(array_s.null_count == array_p.null_count && array_s.null_count > 0
+				&& !memcmp(array_s.buffers[0], array_p.buffers[0], bitmap_size(N))
+				&& !memcmp(array_s.buffers[1], array_p.buffers[1], N * width), format);
+
+			EternalTimestampArrow::cvt_from_array(ts_s.data(), schema_s, array_s, SERIAL);
+			EternalTimestampArrow::cvt_from_array(ts_p.data(), schema_p, array_p, PARALLEL);
+			check(same(ts_s.data(), ts_p.data(), N), "EternalTimestampArrow::cvt_from_array()");
+			array_s.release(&array_s);
+			schema_s.release(&schema_s);
+			array_p.release(&array_p);
+			schema_p.release(&schema_p);
+		}
+	}
+
+	// time scales
+	{
+		size_t a = EternalTimestampLeapSeconds::cvt_time_scale(ts_s.data(), valid_s.data(), src.data(), N, ETS_SCALE_UTC, ETS_SCALE_TAI, SERIAL);
+		size_t b = EternalTimestampLeapSeconds::cvt_time_scale(ts_p.data(), valid_p.data(), src.data(), N, ETS_SCALE_UTC, ETS_SCALE_TAI, PARALLEL);
+		check(a == b && same(ts_s.data(), ts_p.data(), N) && valid_s == valid_p, "EternalTimestampLeapSeconds::cvt_time_scale()");
+
+		a = EternalTimestampLeapSeconds::calc_delta_usecs(i64_s.data(), valid_s.data(), src.data(), src.data() + 1, N - 1, SERIAL);
+		b = EternalTimestampLeapSeconds::calc_delta_usecs(i64_p.data(), valid_p.data(), src.data(), src.data() + 1, N - 1, PARALLEL);
+		check(a == b && !memcmp(i64_s.data(), i64_p.data(), (N - 1) * sizeof(int64_t)) && valid_s == valid_p, "EternalTimestampLeapSeconds::calc_delta_usecs()");
+	}
+
+	// time zones
+	const ets_tz_zone_t *zone = nullptr;
+	if (!EternalTimestampZone::load(zone, "Europe/Amsterdam")) {
+		size_t a = EternalTimestampZone::cvt_local_to_utc(ts_s.data(), valid_s.data(), src.data(), N, zone, ETS_TZ_REJECT, SERIAL);
+		size_t b = EternalTimestampZone::cvt_local_to_utc(ts_p.data(), valid_p.data(), src.data(), N, zone, ETS_TZ_REJECT, PARALLEL);
+		check(a == b && same(ts_s.data(), ts_p.data(), N) && valid_s == valid_p, "EternalTimestampZone::cvt_local_to_utc()");
+		a = EternalTimestampZone::cvt_utc_to_local(ts_s.data(), valid_s.data(), src.data(), N, zone, SERIAL);
+		b = EternalTimestampZone::cvt_utc_to_local(ts_p.data(), valid_p.data(), src.data(), N, zone, PARALLEL);
+		check(a == b && same(ts_s.data(), ts_p.data(), N) && valid_s == valid_p, "EternalTimestampZone::cvt_utc_to_local()");
+	}
+	else {
+		fprintf(stderr, "  ... no zoneinfo database: skipping the time zone conversions\n");
+	}
+
+	// hash lookups
+	{
+		EternalTimestampHashMap map;
+		check(!map.insert_batch(src.data(), nullptr, N / 2, nullptr), "insert_batch()");
+		std::vector<uint64_t> values_s(N), values_p(N);
+		size_t a = map.find_batch(values_s.data(), valid_s.data(), src.data(), N, SERIAL);
+		size_t b = map.find_batch(values_p.data(), valid_p.data(), src.data(), N, PARALLEL);
+		check(a == b && a >= N / 2 - 100 && values_s == values_p && valid_s == valid_p, "EternalTimestampHashMap::find_batch()");
+	}
+}
+
+static void test_nesting()
+{
+	// parallel calls from within a parallel region run on the calling thread: as a single call.
+	std::atomic<unsigned int> outer{ 0 }, inner{ 0 };
+	std::atomic<bool> single{ true };
+	EternalTimestampParallel::parallel_for(64, 1, PARALLEL, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			unsigned int calls = 0;
+			EternalTimestampParallel::parallel_for(10000, 10, PARALLEL, [&](size_t b, size_t e) {
+				calls++;
+				if (b != 0 || e != 10000)
+					single.store(false);
+			});
+			inner.fetch_add(calls);
+			outer.fetch_add(1);
+		}
+	});
+	check(outer.load() == 64 && inner.load() == 64 && single.load(), "nested parallel_for()");
+
+	// ... and so do the batch APIs
+	std::vector<eternal_timestamp_t> v = make_column(N);
+	std::vector<int64_t> expected(N), keys(N);
+	EternalTimestampBatch::calc_sort_keys(expected.data(), v.data(), N, SERIAL);
+	EternalTimestampParallel::parallel_for(2, 1, PARALLEL, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			if (i == 0)
+				EternalTimestampBatch::calc_sort_keys(keys.data(), v.data(), N / 2, PARALLEL);
+			else
+				EternalTimestampBatch::calc_sort_keys(keys.data() + N / 2, v.data() + N / 2, N - N / 2, PARALLEL);
+		}
+	});
+	check(keys == expected, "batch calls from within parallel_for()");
+}
+
+
+#if defined(BUILD_MONOLITHIC)
+#define main(cnt, arr)      eternalty_test_parallel_main(cnt, arr)
+#endif
+
+int main(int argc, const char **argv)
+{
+	fprintf(stderr, "Eternal Timestamp Test (parallel batch APIs)\n\n");
+
+	// hints
+	check(EternalTimestampParallel::default_parallelism() == 1, "the default parallelism is 1");
+	check(EternalTimestampParallel::concurrency(SERIAL) == 1 && EternalTimestampParallel::concurrency(ETS_PARALLELISM_DEFAULT) == 1, "concurrency() of serial hints");
+	check(EternalTimestampParallel::concurrency(PARALLEL) >= 1, "concurrency()");
+
+	// a single thread makes a single call covering everything
+	{
+		unsigned int calls = 0;
+		EternalTimestampParallel::parallel_for(100000, 100, SERIAL, [&](size_t begin, size_t end) {
+			calls++;
+			check(begin == 0 && end == 100000, "parallel_for() on a single thread");
+		});
+		check(calls == 1, "parallel_for() on a single thread: one call");
+		EternalTimestampParallel::parallel_for(0, 100, PARALLEL, [&](size_t, size_t) {
+			calls++;
+		});
+		check(calls == 1, "parallel_for() of nothing");
+	}
+
+	// the library's own pool, whatever its size on this machine
+	fprintf(stderr, "  ... %u hardware thread(s)\n", EternalTimestampParallel::concurrency(PARALLEL));
+	test_parallel_for("parallel_for() on the library pool covers each index once");
+
+	// our own pool: four threads, also when this machine has fewer cores
+	ets_thread_pool_t *pool = EternalTimestampThreadPool::create(3);
+	check(pool != nullptr, "EternalTimestampThreadPool::create()");
+	if (pool) {
+		const ets_executor_t executor = EternalTimestampThreadPool::executor(pool);
+		check(executor.concurrency == 4, "the pool executor concurrency");
+		EternalTimestampParallel::set_executor(&executor);
+		check(EternalTimestampParallel::concurrency(PARALLEL) == 4 && EternalTimestampParallel::concurrency(2) == 2, "concurrency() on the pool");
+
+		test_parallel_for("parallel_for() on a 4 thread pool covers each index once");
+		test_batch();
+		test_nesting();
+
+		// the process-wide default
+		EternalTimestampParallel::set_default_parallelism(3);
+		check(EternalTimestampParallel::default_parallelism() == 3 && EternalTimestampParallel::concurrency(ETS_PARALLELISM_DEFAULT) == 3, "set_default_parallelism()");
+		std::vector<eternal_timestamp_t> v = make_column(N);
+		std::vector<int64_t> expected(N), keys(N);
+		EternalTimestampBatch::calc_sort_keys(expected.data(), v.data(), N, SERIAL);
+		ets_batch_calc_sort_keys(keys.data(), v.data(), N);
+		check(keys == expected, "the C interface uses the default parallelism");
+		EternalTimestampParallel::set_default_parallelism(ETS_PARALLELISM_DEFAULT);
+		check(EternalTimestampParallel::default_parallelism() == 1, "set_default_parallelism(ETS_PARALLELISM_DEFAULT) restores 1");
+
+		// calls from multiple threads at once share the pool: the ones which find it busy run on their own thread
+		{
+			std::vector<std::thread> threads;
+			std::atomic<int> wrong{ 0 };
+			for (int k = 0; k < 4; k++) {
+				threads.emplace_back([&] {
+					std::vector<int64_t> mine(N);
+					for (int round = 0; round < 5; round++) {
+						EternalTimestampBatch::calc_sort_keys(mine.data(), v.data(), N, PARALLEL);
+						if (mine != expected)
+							wrong.fetch_add(1);
+					}
+				});
+			}
+			for (auto &th : threads)
+				th.join();
+			check(wrong.load() == 0, "concurrent calls on the pool");
+		}
+
+		EternalTimestampParallel::set_executor(nullptr);
+		EternalTimestampThreadPool::destroy(pool);
+	}
+
+	// an executor supplied by the application
+	{
+		ets_executor_t user{ run_inline, &user_runs, 8 };
+		EternalTimestampParallel::set_executor(&user);
+		check(EternalTimestampParallel::concurrency(PARALLEL) == 8, "concurrency() of a user executor");
+		test_parallel_for("parallel_for() on a user executor covers each index once");
+		check(user_runs.load() > 0, "the user executor is used");
+
+		// too short to split: no need to bother the executor
+		const unsigned int runs = user_runs.load();
+		std::vector<eternal_timestamp_t> v = make_column(100);
+		std::vector<int64_t> keys(100);
+		EternalTimestampBatch::calc_sort_keys(keys.data(), v.data(), 100, PARALLEL);
+		check(user_runs.load() == runs, "short columns run on the calling thread");
+		EternalTimestampParallel::set_executor(nullptr);
+	}
+
+	// the C interface
+	{
+		ets_thread_pool_t *p = ets_thread_pool_create(1);
+		check(p != nullptr, "ets_thread_pool_create()");
+		if (p) {
+			const ets_executor_t e = ets_thread_pool_executor(p);
+			ets_parallel_set_executor(&e);
+			check(ets_parallel_concurrency(PARALLEL) == 2, "ets_parallel_concurrency()");
+			ets_parallel_set_default_parallelism(2);
+			check(ets_parallel_default_parallelism() == 2, "ets_parallel_default_parallelism()");
+
+			const size_t count = 54321;
+			std::vector<std::atomic<unsigned int>> seen(count);
+			for (auto &s : seen)
+				s.store(0);
+			ets_parallel_for(count, 0, ETS_PARALLELISM_DEFAULT, count_indexes, seen.data());
+			bool once = true;
+			for (auto &s : seen)
+				once &= (s.load() == 1);
+			check(once, "ets_parallel_for()");
+
+			ets_parallel_set_default_parallelism(1);
+			ets_parallel_set_executor(nullptr);
+			ets_thread_pool_destroy(p);
+		}
+	}
+
+	if (failures) {
+		fprintf(stderr, "\n%d test(s) FAILED\n", failures);
+		return EXIT_FAILURE;
+	}
+	fprintf(stderr, "All tests passed\n");
+	return EXIT_SUCCESS;
+}
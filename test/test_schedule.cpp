@@ -0,0 +1,371 @@
+#include <eternal_timestamp/eternal_timestamp.h>
+#include <eternal_timestamp/eternal_timestamp_schedule.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "monolithic_examples.h"
+
+
+using namespace eternal_timestamp;
+
+static int failures = 0;
+
+static void check(bool ok, const char *what)
+{
+	if (!ok) {
+		fprintf(stderr, "FAIL: %s\n", what);
+		failures++;
+	}
+}
+
+static eternal_timestamp_t parse(const char *iso8601)
+{
+	eternal_timestamp_t t;
+	t.t = 0;
+	EternalTimestamp::cvt_from_iso8601(t, iso8601, strlen(iso8601));
+	return t;
+}
+
+static bool parse_rule(ets_schedule_rule_t &rule, const char *text)
+{
+	return EternalTimestampSchedule::parse_rule(rule, text, strlen(text)) == 0;
+}
+
+// The occurrences of `text` from `base`, up to `max`.
+static std::vector<eternal_timestamp_t> expand(const char *text, const char *base, size_t max)
+{
+	ets_schedule_rule_t rule;
+	ets_schedule_t s;
+	std::vector<eternal_timestamp_t> rv(max);
+	if (!parse_rule(rule, text) || EternalTimestampSchedule::init(s, rule, parse(base)) != 0)
+		return std::vector<eternal_timestamp_t>();
+	rv.resize(EternalTimestampSchedule::generate(rv.data(), max, s));
+	return rv;
+}
+
+static bool same(const std::vector<eternal_timestamp_t> &got, const std::vector<const char *> &expected)
+{
+	if (got.size() != expected.size())
+		return false;
+	for (size_t i = 0; i < got.size(); i++) {
+		if (got[i].t != parse(expected[i]).t)
+			return false;
+	}
+	return true;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// the reference: check every day, and every time of day, against the rule
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct civil
+{
+	int y, m, d;
+};
+
+static int days_in_month(int y, int m)
+{
+	switch (m) {
+	case 2:
+		return (y % 4 == 0 && y % 100 != 0) || y % 400 == 0 ? 29 : 28;
+	case 4: case 6: case 9: case 11:
+		return 30;
+	default:
+		return 31;
+	}
+}
+
+static void next_day(civil &c)
+{
+	if (++c.d > days_in_month(c.y, c.m)) {
+		c.d = 1;
+		if (++c.m > 12) {
+			c.m = 1;
+			c.y++;
+		}
+	}
+}
+
+// Monday is 0 (Sakamoto's method)
+static int weekday(const civil &c)
+{
+	static const int t[12] = { 0, 3, 2, 5, 0, 3, 5, 1, 4, 6, 2, 4 };
+	const int y = c.y - (c.m < 3);
+	return (y + y / 4 - y / 100 + y / 400 + t[c.m - 1] + c.d + 6) % 7;
+}
+
+// A negative hour, minute or second is 'unspecified', and so is everything after it.
+static eternal_timestamp_t make(const civil &c, int h, int mi, int s)
+{
+	char text[80];
+	if (h < 0)
+		snprintf(text, sizeof(text), "%04d-%02d-%02d", c.y, c.m, c.d);
+	else if (mi < 0)
+		snprintf(text, sizeof(text), "%04d-%02d-%02dT%02d", c.y, c.m, c.d, h);
+	else if (s < 0)
+		snprintf(text, sizeof(text), "%04d-%02d-%02dT%02d:%02d", c.y, c.m, c.d, h, mi);
+	else
+		snprintf(text, sizeof(text), "%04d-%02d-%02dT%02d:%02d:%02d", c.y, c.m, c.d, h, mi, s);
+	return parse(text);
+}
+
+// The first `max` occurrences within `days` days of the base, which has its time given down to the second or not
+// at all.
+static std::vector<eternal_timestamp_t> reference(const ets_schedule_rule_t &rule, const civil &base, int bh, int bm, int bs, size_t max, int days)
+{
+	std::vector<eternal_timestamp_t> rv;
+	const int64_t k = (rule.interval ? rule.interval : 1);
+	const int level = (rule.frequency >= ETS_SCHEDULE_HOURLY ? rule.frequency - ETS_SCHEDULE_HOURLY : 3);
+	const bool by_day = (rule.by_month_day || rule.by_month_day_from_end);
+	const int base_weekday = weekday(base);
+	const int64_t base_seconds = (bh < 0 ? 0 : (bh * 60 + bm) * 60 + bs);
+
+	// the values of a time field: -1 stands for 'unspecified'
+	auto values = [&](uint64_t by, int field, int range, int base_value) {
+		std::vector<int> v;
+		for (int i = 0; i < range; i++) {
+			if (by ? (by >> i) & 1 : (level < 3 && field <= level) || i == base_value)
+				v.push_back(i);
+		}
+		if (v.empty())
+			v.push_back(-1);
+		return v;
+	};
+	const std::vector<int> hours = values(rule.by_hour, 0, 24, bh);
+	const std::vector<int> minutes = values(rule.by_minute, 1, 60, bm);
+	const std::vector<int> seconds = values(rule.by_second, 2, 60, bs);
+	static const int64_t units[3] = { 3600, 60, 1 };
+
+	civil c = base;
+	for (int64_t day = 0; day < days && rv.size() < max; day++, next_day(c)) {
+		const int wd = static_cast<int>((base_weekday + day) % 7);
+		if (rule.by_month ? !((rule.by_month >> (c.m - 1)) & 1)
+			: rule.frequency == ETS_SCHEDULE_YEARLY && !by_day && !rule.by_weekday && c.m != base.m)
+			continue;
+		if (by_day ? !((rule.by_month_day >> (c.d - 1)) & 1) && !((rule.by_month_day_from_end >> (days_in_month(c.y, c.m) - c.d)) & 1)
+			: rule.frequency <= ETS_SCHEDULE_MONTHLY && !rule.by_weekday && c.d != base.d)
+			continue;
+		if (rule.by_weekday ? !((rule.by_weekday >> wd) & 1) : rule.frequency == ETS_SCHEDULE_WEEKLY && wd != base_weekday)
+			continue;
+		bool aligned = true;
+		switch (rule.frequency) {
+		case ETS_SCHEDULE_YEARLY: aligned = (c.y - base.y) % k == 0; break;
+		case ETS_SCHEDULE_MONTHLY: aligned = ((c.y - base.y) * 12 + c.m - base.m) % k == 0; break;
+		case ETS_SCHEDULE_WEEKLY: aligned = ((day + base_weekday) / 7) % k == 0; break;
+		case ETS_SCHEDULE_DAILY: aligned = day % k == 0; break;
+		default: break;
+		}
+		if (!aligned)
+			continue;
+		for (int h : hours) {
+			for (int mi : minutes) {
+				for (int s : seconds) {
+					const int64_t t = day * 86400 + (h < 0 ? 0 : (h * 60 + (mi < 0 ? 0 : mi)) * 60 + (s < 0 ? 0 : s));
+					if (t < base_seconds || (level < 3 && (t / units[level] - base_seconds / units[level]) % k != 0))
+						continue;
+					if (rv.size() < max)
+						rv.push_back(make(c, h, mi, s));
+				}
+			}
+		}
+	}
+	return rv;
+}
+
+static uint64_t random_set(std::mt19937_64 &rng, int range, int bits)
+{
+	uint64_t set = 0;
+	for (int i = 0; i < bits; i++)
+		set |= 1ULL << (rng() % range);
+	return set;
+}
+
+static void test_against_reference()
+{
+	std::mt19937_64 rng(49);
+	const size_t max = 300;
+	int tested = 0;
+	for (int i = 0; i < 1500; i++) {
+		ets_schedule_rule_t rule;
+		EternalTimestampSchedule::init_rule(rule, static_cast<ets_schedule_frequency_t>(rng() % 7));
+		rule.interval = static_cast<uint32_t>(rng() % 4 ? 1 + rng() % 4 : 5 + rng() % 60);
+		if (rng() % 4 == 0)
+			rule.by_month = static_cast<uint16_t>(random_set(rng, 12, 1 + rng() % 6));
+		if (rng() % 3 == 0)
+			rule.by_weekday = static_cast<uint8_t>(random_set(rng, 7, 1 + rng() % 4));
+		if (rng() % 5 == 0)
+			rule.by_month_day = static_cast<uint32_t>(random_set(rng, 31, 1 + rng() % 4));
+		if (rng() % 6 == 0)
+			rule.by_month_day_from_end = static_cast<uint32_t>(random_set(rng, 31, 1 + rng() % 3));
+		if (rng() % 3 == 0)
+			rule.by_hour = static_cast<uint32_t>(random_set(rng, 24, 1 + rng() % 6));
+		if (rng() % 4 == 0)
+			rule.by_minute = random_set(rng, 60, 1 + rng() % 4);
+		if (rng() % 5 == 0)
+			rule.by_second = random_set(rng, 60, 1 + rng() % 4);
+
+		const civil base = { 1990 + static_cast<int>(rng() % 45), 1 + static_cast<int>(rng() % 12), 1 + static_cast<int>(rng() % 28) };
+		const bool timed = (rng() % 5 != 0);
+		const int bh = (timed ? static_cast<int>(rng() % 24) : -1);
+		const int bm = (timed ? static_cast<int>(rng() % 60) : -1);
+		const int bs = (timed ? static_cast<int>(rng() % 60) : -1);
+
+		// bound both by an UNTIL date
+		const int days = (rule.frequency == ETS_SCHEDULE_SECONDLY ? 3 : rule.frequency >= ETS_SCHEDULE_HOURLY ? 40 : 4000);
+		civil until = base;
+		for (int d = 1; d < days; d++)
+			next_day(until);
+		rule.until = make(until, -1, -1, -1);
+
+		ets_schedule_t s;
+		if (EternalTimestampSchedule::init(s, rule, make(base, bh, bm, bs)) != 0) {
+			// only the rules which give a time field below an unspecified one, or step an unspecified one
+			check(!timed && (rule.frequency >= ETS_SCHEDULE_HOURLY || rule.by_minute || rule.by_second), "init() fails on the invalid rules only");
+			continue;
+		}
+		tested++;
+		std::vector<eternal_timestamp_t> got(max);
+		got.resize(EternalTimestampSchedule::generate(got.data(), max, s));
+		const std::vector<eternal_timestamp_t> expected = reference(rule, base, bh, bm, bs, max, days);
+		bool ok = (got.size() == expected.size());
+		for (size_t j = 0; ok && j < got.size(); j++)
+			ok = (got[j].t == expected[j].t);
+		if (!ok) {
+			fprintf(stderr, "  case %d: frequency %d, interval %u, base %04d-%02d-%02d %d:%d:%d: %zu occurrences, expected %zu\n",
+				i, rule.frequency, rule.interval, base.y, base.m, base.d, bh, bm, bs, got.size(), expected.size());
+		}
+		check(ok, "the occurrences match the reference");
+	}
+	check(tested > 1200, "most random rules are valid");
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// the usual suspects
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void test_examples()
+{
+	check(same(expand("FREQ=DAILY;BYDAY=MO,TU,WE,TH,FR;BYHOUR=9;BYMINUTE=0;BYSECOND=0", "2024-03-01T10:00:00", 6),
+		{ "2024-03-04T09:00:00", "2024-03-05T09:00:00", "2024-03-06T09:00:00", "2024-03-07T09:00:00", "2024-03-08T09:00:00", "2024-03-11T09:00:00" }),
+		"every weekday at 09:00");
+	check(same(expand("FREQ=MONTHLY;BYMONTHDAY=-1;COUNT=4", "2023-12-15", 10),
+		{ "2023-12-31", "2024-01-31", "2024-02-29", "2024-03-31" }),
+		"the last day of each month, as dates");
+	check(same(expand("FREQ=HOURLY;BYDAY=MO,TU,WE,TH,FR;BYHOUR=9,10,11,12,13,14,15,16,17", "2024-03-01T16:30:00", 4),
+		{ "2024-03-01T16:30:00", "2024-03-01T17:30:00", "2024-03-04T09:30:00", "2024-03-04T10:30:00" }),
+		"hourly within business hours");
+	check(same(expand("FREQ=YEARLY;BYMONTH=2;BYMONTHDAY=29;COUNT=3", "2021-01-01", 10),
+		{ "2024-02-29", "2028-02-29", "2032-02-29" }),
+		"leap days");
+	check(same(expand("FREQ=MONTHLY;BYMONTHDAY=31", "2024-01-31T08:00", 4),
+		{ "2024-01-31T08:00", "2024-03-31T08:00", "2024-05-31T08:00", "2024-07-31T08:00" }),
+		"months without the day are skipped");
+	check(same(expand("FREQ=WEEKLY;INTERVAL=2;BYDAY=MO,FR", "2024-03-06T12", 4),
+		{ "2024-03-08T12", "2024-03-18T12", "2024-03-22T12", "2024-04-01T12" }),
+		"every other week");
+	check(same(expand("FREQ=DAILY;UNTIL=2024-03", "2024-03-29", 10),
+		{ "2024-03-29", "2024-03-30", "2024-03-31" }),
+		"a partial UNTIL covers its period");
+	check(same(expand("FREQ=MINUTELY;INTERVAL=20;UNTIL=20240301T010000Z", "2024-02-29T23:50:00", 10),
+		{ "2024-02-29T23:50:00", "2024-03-01T00:10:00", "2024-03-01T00:30:00", "2024-03-01T00:50:00" }),
+		"minutes across midnight, with a basic UNTIL");
+
+	// sub-second fields come with the base
+	std::vector<eternal_timestamp_t> v = expand("FREQ=DAILY;COUNT=2", "2024-03-01T10:00:00.250", 10);
+	check(v.size() == 2 && v[1].t == parse("2024-03-02T10:00:00.250").t, "milliseconds are copied");
+
+	// no occurrences at all, or no more beyond the end of the modern range: these must end
+	check(expand("FREQ=YEARLY;BYMONTH=2;BYMONTHDAY=30", "2024-01-01", 10).empty() && expand("FREQ=DAILY;BYMONTHDAY=31;BYMONTH=4,6", "2024-01-01", 10).empty(), "rules without occurrences");
+	v = expand("FREQ=YEARLY;INTERVAL=1000", "2024-07-01", 1000);
+	check(v.size() > 30 && v.size() < 50 && EternalTimestamp::has_year(v.back()), "the end of the modern range");
+}
+
+static void test_iteration()
+{
+	// an open-ended rule, drained lazily, in chunks, and through the C interface
+	ets_schedule_rule_t rule;
+	check(parse_rule(rule, "RRULE:freq=secondly;wkst=MO") && rule.frequency == ETS_SCHEDULE_SECONDLY && rule.count == 0 && rule.until.t == ets_unknown().t, "parse_rule(): open-ended");
+	ets_schedule_t lazy, chunked;
+	check(EternalTimestampSchedule::init(lazy, rule, parse("2024-01-01T00:00:00")) == 0 && ets_schedule_init(&chunked, &rule, parse("2024-01-01T00:00:00")) == 0, "init()");
+
+	eternal_timestamp_t t = ets_unknown();
+	bool ok = true;
+	std::vector<eternal_timestamp_t> chunk(777);
+	size_t in_chunk = chunk.size();
+	size_t pos = chunk.size();
+	for (int i = 0; i < 100000 && ok; i++) {
+		ok = EternalTimestampSchedule::next(lazy, t);
+		if (pos == in_chunk) {
+			in_chunk = (i % 2 ? ets_schedule_generate(chunk.data(), chunk.size(), &chunked) : EternalTimestampSchedule::generate(chunk.data(), chunk.size(), chunked));
+			pos = 0;
+			ok = ok && in_chunk == chunk.size();
+		}
+		ok = ok && chunk[pos++].t == t.t;
+	}
+	check(ok && t.t == parse("2024-01-02T03:46:39").t && lazy.emitted == 100000, "next() and generate() agree");
+
+	ets_schedule_rule_t daily;
+	ets_schedule_init_rule(&daily, ETS_SCHEDULE_DAILY);
+	daily.count = 2;
+	check(ets_schedule_init(&lazy, &daily, parse("2024-01-01")) == 0 && ets_schedule_next(&lazy, &t) && ets_schedule_next(&lazy, &t) && !ets_schedule_next(&lazy, &t) && t.t == parse("2024-01-02").t, "COUNT");
+}
+
+static void test_errors()
+{
+	ets_schedule_rule_t rule;
+	for (const char *bad : { "", "INTERVAL=2", "FREQ=FORTNIGHTLY", "FREQ=DAILY;INTERVAL=0", "FREQ=DAILY;BYDAY=-1FR", "FREQ=DAILY;BYHOUR=24",
+		"FREQ=DAILY;BYMONTHDAY=0", "FREQ=DAILY;BYMONTHDAY=-32", "FREQ=DAILY;BYSETPOS=1", "FREQ=DAILY;WKST=SU", "FREQ=DAILY;COUNT=2;UNTIL=2030",
+		"FREQ=DAILY;BYMINUTE=1,", "FREQ=DAILY;UNTIL=tomorrow", "FREQ" }) {
+		check(!parse_rule(rule, bad), bad);
+	}
+	check(parse_rule(rule, "FREQ=MONTHLY;INTERVAL=3;BYMONTHDAY=1,15,-1,-2;BYMONTH=1,12;BYDAY=SA,SU;BYHOUR=0,23;BYMINUTE=0,59;BYSECOND=30;COUNT=7")
+		&& rule.frequency == ETS_SCHEDULE_MONTHLY && rule.interval == 3 && rule.by_month_day == ((1 << 0) | (1 << 14)) && rule.by_month_day_from_end == 3
+		&& rule.by_month == 0x801 && rule.by_weekday == (ETS_SCHEDULE_SATURDAY | ETS_SCHEDULE_SUNDAY) && rule.by_hour == 0x800001
+		&& rule.by_minute == ((1ULL << 59) | 1) && rule.by_second == (1ULL << 30) && rule.count == 7, "parse_rule()");
+
+	ets_schedule_t s;
+	ets_schedule_init_rule(&rule, ETS_SCHEDULE_HOURLY);
+	check(ets_schedule_init(&s, &rule, parse("2024-01-01")) == -1, "the hours to step from are unspecified");
+	ets_schedule_init_rule(&rule, ETS_SCHEDULE_DAILY);
+	rule.by_minute = 1;
+	check(ets_schedule_init(&s, &rule, parse("2024-01-01")) == -1, "minutes without hours");
+	rule.by_hour = 1 << 9;
+	check(ets_schedule_init(&s, &rule, parse("2024-01-01")) == 0, "minutes with hours");
+	rule.by_hour = 1 << 24;
+	check(ets_schedule_init(&s, &rule, parse("2024-01-01")) == -1, "an hour out of range");
+	ets_schedule_init_rule(&rule, ETS_SCHEDULE_DAILY);
+	check(ets_schedule_init(&s, &rule, parse("2024-01")) == -1 && ets_schedule_init(&s, &rule, parse("-20000")) == -1, "no complete modern date");
+	rule.until = parse("-20000");
+	check(ets_schedule_init(&s, &rule, parse("2024-01-01")) == -1, "a prehistoric UNTIL");
+	check(!ets_schedule_next(&s, &rule.until), "a failed init() leaves an exhausted schedule");
+}
+
+
+#if defined(BUILD_MONOLITHIC)
+#define main(cnt, arr)      eternalty_test_schedule_main(cnt, arr)
+#endif
+
+int main(int argc, const char **argv)
+{
+	(void)argc;
+	(void)argv;
+
+	fprintf(stderr, "Eternal Timestamp Test (recurrence rules)\n\n");
+
+	test_examples();
+	test_iteration();
+	test_errors();
+	test_against_reference();
+
+	if (failures) {
+		fprintf(stderr, "\n%d test(s) FAILED\n", failures);
+		return EXIT_FAILURE;
+	}
+	fprintf(stderr, "All tests passed\n");
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,176 @@
+
+#include <eternal_timestamp/eternal_timestamp.h>
+#include <sqlite3.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "monolithic_examples.h"
+
+
+#ifndef ETS_SQLITE_EXTENSION_PATH
+#define ETS_SQLITE_EXTENSION_PATH   "./eternaltimestamp"
+#endif
+
+static int failures = 0;
+
+// run a query producing a single value and compare its text representation against the expected value.
+static void check(sqlite3 *db, const char *sql, const char *expected)
+{
+	sqlite3_stmt *stmt = nullptr;
+	if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+		fprintf(stderr, "FAIL: %s\n  prepare: %s\n", sql, sqlite3_errmsg(db));
+		failures++;
+		return;
+	}
+	const char *actual = "(no row)";
+	int rc = sqlite3_step(stmt);
+	if (rc == SQLITE_ROW) {
+		actual = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0));
+		if (!actual)
+			actual = "NULL";
+	}
+	else if (rc != SQLITE_DONE) {
+		actual = sqlite3_errmsg(db);
+	}
+	if (strcmp(actual, expected)) {
+		fprintf(stderr, "FAIL: %s\n  expected: %s\n  actual:   %s\n", sql, expected, actual);
+		failures++;
+	}
+	sqlite3_finalize(stmt);
+}
+
+// check that the query plan for the given query mentions the expected phrase, e.g. the use of an index.
+static void check_plan(sqlite3 *db, const char *query, const char *expected)
+{
+	char sql[500];
+	snprintf(sql, sizeof(sql), "EXPLAIN QUERY PLAN %s", query);
+	sqlite3_stmt *stmt = nullptr;
+	if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+		fprintf(stderr, "FAIL: %s\n  prepare: %s\n", sql, sqlite3_errmsg(db));
+		failures++;
+		return;
+	}
+	bool found = false;
+	while (sqlite3_step(stmt) == SQLITE_ROW) {
+		const char *detail = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 3));
+		if (detail && strstr(detail, expected))
+			found = true;
+	}
+	if (!found) {
+		fprintf(stderr, "FAIL: %s\n  expected plan to mention: %s\n", sql, expected);
+		failures++;
+	}
+	sqlite3_finalize(stmt);
+}
+
+
+#if defined(BUILD_MONOLITHIC)
+#define main(cnt, arr)      eternalty_test_sqlite_main(cnt, arr)
+#endif
+
+int main(int argc, const char **argv)
+{
+	fprintf(stderr, "Eternal Timestamp Test (SQLite extension)\n\n");
+
+	const char *path = (argc > 1 ? argv[1] : ETS_SQLITE_EXTENSION_PATH);
+
+	sqlite3 *db = nullptr;
+	if (sqlite3_open(":memory:", &db) != SQLITE_OK) {
+		fprintf(stderr, "cannot open database\n");
+		return EXIT_FAILURE;
+	}
+	sqlite3_enable_load_extension(db, 1);
+	char *err = nullptr;
+	if (sqlite3_load_extension(db, path, nullptr, &err) != SQLITE_OK) {
+		fprintf(stderr, "cannot load extension %s: %s\n", path, err);
+		sqlite3_free(err);
+		sqlite3_close(db);
+		return EXIT_FAILURE;
+	}
+
+	// scalar functions
+	check(db, "SELECT ets_format(ets_from_unix(0))", "1970-01-01T00:00:00.000000");
+	check(db, "SELECT ets_format(ets_from_unix(1642077631.049352))", "2022-01-13T12:40:31.049352");
+	check(db, "SELECT ets_format(ets_from_unix(1642077631, 49352))", "2022-01-13T12:40:31.049352");
+	check(db, "SELECT ets_to_unix(ets_from_unix(1642077631))", "1642077631.0");
+	check(db, "SELECT ets_format(ets_from_unix(-62167219201))", "-0001-12-31T23:59:59.000000");
+	check(db, "SELECT ets_format(ets_from_unix(-374580979200))", "-9900-01-01T00:00:00.000000");
+	check(db, "SELECT ets_format(ets_from_unix(1237979203199, 999999))", "41199-12-31T23:59:59.999999");
+	check(db, "SELECT ets_from_unix(-374580979201)", "ets_from_unix: value out of range");
+	check(db, "SELECT ets_from_unix(-374580979200, -1)", "ets_from_unix: value out of range");
+	check(db, "SELECT ets_from_unix(1237979203200)", "ets_from_unix: value out of range");
+	check(db, "SELECT ets_from_unix(-500000000000)", "ets_from_unix: value out of range");
+	check(db, "SELECT ets_from_unix(-500000000000.0)", "ets_from_unix: value out of range");
+	check(db, "SELECT ets_from_unix(0, 9223372036854775807)", "ets_from_unix: value out of range");
+	check(db, "SELECT ets_from_unix(-1, -9223372036854775808)", "ets_from_unix: value out of range");
+	check(db, "SELECT ets_format(ets_trunc(ets_from_unix(1642077631), 'minute'))", "2022-01-13T12:40");
+	check(db, "SELECT ets_format(ets_trunc(ets_from_unix(1642077631), 'month'))", "2022-01");
+	check(db, "SELECT ets_format(ets_from_unix(1642077631), '%d %B %Y, %H:%M')", "13 January 2022, 12:40");
+	check(db, "SELECT ets_format(ets_trunc(ets_from_unix(1642077631), 'month'), '%Y[-%m[-%d]]')", "2022-01");
+	// many rows through one compiled pattern, then a pattern which changes from row to row
+	check(db, "SELECT group_concat(ets_format(value, '%Y-%m-%d'), ' ') FROM ets_series(ets_from_unix(0), ets_from_unix(86400 * 4))",
+		"1970-01-01 1970-01-02 1970-01-03 1970-01-04 1970-01-05");
+	check(db, "SELECT group_concat(ets_format(column1, column2), ' ') "
+		"FROM (VALUES (ets_from_unix(0), '%Y'), (ets_from_unix(0), '%m'), (ets_from_unix(86400), '%m'), (ets_from_unix(86400), '%d'))",
+		"1970 01 01 02");
+	check(db, "SELECT ets_format(1, '%q')", "ets_format: invalid pattern");
+	check(db, "SELECT ets_trunc(1, 'fortnight')", "ets_trunc: unknown unit");
+	check(db, "SELECT ets_delta(ets_from_unix(0), ets_from_unix(1)) > 0", "1");
+	check(db, "SELECT ets_delta(ets_from_unix(1), ets_from_unix(0)) < 0", "1");
+	check(db, "SELECT ets_format(NULL) IS NULL", "1");
+	check(db, "SELECT ets_delta(ets_now(), ets_now()) > 0", "1");
+
+	// ordering: a prehistoric timestamp (mode bit set) sorts before any modern one; within each subformat by time.
+	sqlite3_exec(db,
+		"CREATE TABLE ev(ts INTEGER);"
+		"CREATE INDEX ev_key ON ev(ets_sortkey(ts));"
+		"INSERT INTO ev VALUES (ets_from_unix(0)), (ets_from_unix(-86400)), (ets_trunc(ets_from_unix(0), 'day')), (ets_from_unix(86400));",
+		nullptr, nullptr, nullptr);
+	{
+		eternal_timestamp_t t{0};
+		t = ets_format_set_mode(t, 1);
+		t = ets_prehistoric_set_years(t, 48000);
+		char sql[200];
+		snprintf(sql, sizeof(sql), "INSERT INTO ev VALUES (%lld);", static_cast<long long>(t.t));
+		sqlite3_exec(db, sql, nullptr, nullptr, nullptr);
+		t = ets_prehistoric_set_years(t, 100000);
+		snprintf(sql, sizeof(sql), "INSERT INTO ev VALUES (%lld);", static_cast<long long>(t.t));
+		sqlite3_exec(db, sql, nullptr, nullptr, nullptr);
+	}
+	check(db, "SELECT group_concat(ets_format(ts), ' | ') FROM (SELECT ts FROM ev ORDER BY ets_sortkey(ts))",
+		"100000 BC | 48000 BC | 1969-12-31T00:00:00.000000 | 1970-01-01 | 1970-01-01T00:00:00.000000 | 1970-01-02T00:00:00.000000");
+	check(db, "SELECT ets_cmp(min(ts), ets_from_unix(0)) FROM ev WHERE ets_format(ts) = '48000 BC'", "-1");
+	check(db, "SELECT count(*) FROM ev WHERE ets_sortkey(ts) BETWEEN ets_sortkey(ets_from_unix(-1)) AND ets_sortkey(ets_from_unix(1))", "2");
+	check_plan(db, "SELECT * FROM ev WHERE ets_sortkey(ts) > 0", "USING INDEX ev_key");
+
+	// ets_series table-valued function
+	check(db, "SELECT count(*) FROM ets_series(ets_from_unix(0), ets_from_unix(86400 * 10))", "11");
+	check(db, "SELECT count(*) FROM ets_series(ets_from_unix(0), ets_from_unix(3600), 60000000)", "61");
+	check(db, "SELECT count(*) FROM ets_series(ets_from_unix(0), ets_from_unix(3600), 'minute')", "61");
+	check(db, "SELECT count(*) FROM ets_series(ets_from_unix(0), ets_from_unix(86400 * 10)) "
+		"WHERE value >= ets_from_unix(86400 * 3) AND value < ets_from_unix(86400 * 5)", "2");
+	check(db, "SELECT count(*) FROM ets_series(ets_from_unix(0), ets_from_unix(86400 * 10)) "
+		"WHERE value > ets_from_unix(86400 * 3) AND value <= ets_from_unix(86400 * 5)", "2");
+	// the bounds are pushed down into the generator: this would otherwise enumerate ~10^17 microseconds
+	check(db, "SELECT count(*) FROM ets_series(ets_from_unix(0), ets_from_unix(3000000000), 1) "
+		"WHERE value >= ets_from_unix(1000000) AND value < ets_from_unix(1000000, 10)", "10");
+	check(db, "SELECT count(*) FROM ets_series(ets_from_unix(0), ets_from_unix(86400 * 10)) WHERE value = ets_from_unix(86400 * 4)", "1");
+	check(db, "SELECT count(*) FROM ets_series(ets_from_unix(0), ets_from_unix(86400 * 10)) WHERE value = ets_from_unix(86400 * 4 + 1)", "0");
+	check(db, "SELECT group_concat(ets_format(value), ' ') FROM ets_series "
+		"WHERE value >= ets_from_unix(1643587200) AND value <= ets_from_unix(1651363200) AND step = 'month'",
+		"2022-01-31T00:00:00.000000 2022-02-28T00:00:00.000000 2022-03-31T00:00:00.000000 2022-04-30T00:00:00.000000");
+	// a truncated (partial) timestamp works as a bound as well: 'all of January 2nd'
+	check(db, "SELECT count(*) FROM ets_series(ets_from_unix(0), ets_from_unix(86400 * 3), 'hour') "
+		"WHERE value >= ets_trunc(ets_from_unix(86400), 'day') AND value < ets_trunc(ets_from_unix(86400 * 2), 'day')", "24");
+	check(db, "SELECT count(*) FROM ets_series(ets_from_unix(0))", "ets_series: a stop value or an upper bound on 'value' is required");
+
+	sqlite3_close(db);
+
+	if (failures) {
+		fprintf(stderr, "\n%d test(s) FAILED\n", failures);
+		return EXIT_FAILURE;
+	}
+	fprintf(stderr, "All tests passed\n");
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,152 @@
+
+#include <eternal_timestamp/eternal_timestamp.h>
+#include <eternal_timestamp/eternal_timestamp_batch.h>
+#include <eternal_timestamp/eternal_timestamp_stats.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "monolithic_examples.h"
+
+
+using namespace eternal_timestamp;
+
+static int failures = 0;
+
+static void check(bool ok, const char *what)
+{
+	if (!ok) {
+		fprintf(stderr, "FAIL: %s\n", what);
+		failures++;
+	}
+}
+
+static std::string dump(const ets_stats_t &stats)
+{
+	std::string s(EternalTimestampStats::dump(nullptr, 0, stats), ' ');
+	EternalTimestampStats::dump(&s[0], s.size() + 1, stats);
+	return s;
+}
+
+
+#if defined(BUILD_MONOLITHIC)
+#define main(cnt, arr)      eternalty_test_stats_main(cnt, arr)
+#endif
+
+int main(int argc, const char **argv)
+{
+	fprintf(stderr, "Eternal Timestamp Test (instrumentation counters)\n\n");
+
+	const bool enabled = EternalTimestampStats::enabled();
+	fprintf(stderr, "  ... instrumentation %s, timers %s\n", (enabled ? "compiled in" : "compiled out"), (EternalTimestampStats::timers_enabled() ? "compiled in" : "compiled out"));
+	check(enabled || !EternalTimestampStats::timers_enabled(), "timers without counters");
+
+	check(!strcmp(EternalTimestampStats::name(ETS_STATS_NOW), "EternalTimestamp::now"), "EternalTimestampStats::name(ETS_STATS_NOW)");
+	check(!strcmp(EternalTimestampStats::name(ETS_STATS_ENTRY_POINT_COUNT), "now_bumped"), "the first event follows the entry points");
+	check(!strcmp(EternalTimestampStats::name(ETS_STATS_COUNT - 1), "hash_map_rehash"), "EternalTimestampStats::name() of the last event");
+	check(!EternalTimestampStats::name(-1) && !EternalTimestampStats::name(ETS_STATS_COUNT), "EternalTimestampStats::name() out of range");
+
+	EternalTimestampStats::reset();
+	ets_stats_t stats;
+	EternalTimestampStats::snapshot(stats);
+	bool zero = true;
+	for (int i = 0; i < ETS_STATS_COUNT; i++)
+		zero &= (stats.count[i] == 0 && stats.ticks[i] == 0);
+	check(zero, "all counters are zero after reset()");
+
+	// calls and events on this thread
+	const int now_calls = 100000;
+	for (int i = 0; i < now_calls; i++)
+		EternalTimestamp::now();
+
+	eternal_timestamp_t t;
+	EternalTimestamp::cvt_from_iso8601(t, "2022-01-13T12:40:31.049352", 26);
+	EternalTimestamp::cvt_from_iso8601(t, "2022-01-13", 10);
+	EternalTimestamp::cvt_from_iso8601(t, "20220113T124031", 15);
+
+	eternal_timestamp_t ancient;
+	ancient.t = 0;
+	ancient = ets_format_set_mode(ancient, 1);
+	ancient = ets_prehistoric_set_years(ancient, 40000);
+	EternalTimestamp::calc_time_fast_delta(t, ancient);
+	EternalTimestamp::calc_time_fast_delta(t, t);
+
+	// calls on other threads, some of which have exited by the time of the snapshot
+	const int threads = 4;
+	const int keys = 1000;
+	{
+		std::vector<std::thread> pool;
+		for (int i = 0; i < threads; i++) {
+			pool.emplace_back([] {
+				const eternal_timestamp_t now = EternalTimestamp::now();
+				for (int k = 0; k < keys; k++)
+					EternalTimestamp::calc_sort_key(now);
+			});
+		}
+		for (auto &th : pool)
+			th.join();
+	}
+
+	EternalTimestampStats::snapshot(stats);
+	if (enabled) {
+		check(stats.count[ETS_STATS_NOW] == now_calls + threads, "calls of EternalTimestamp::now()");
+		check(stats.count[ETS_STATS_CVT_FROM_ISO8601] == 3, "calls of EternalTimestamp::cvt_from_iso8601()");
+		check(stats.count[ETS_STATS_CVT_UNSPECIFIED_FIELDS] == 2, "conversions producing unspecified fields");
+		check(stats.count[ETS_STATS_ISO8601_SCALAR_FALLBACK] == 2, "ISO 8601 parses off the fast path");
+		check(stats.count[ETS_STATS_CALC_TIME_FAST_DELTA] == 2 && stats.count[ETS_STATS_FAST_DELTA_CROSS_MODE] == 1, "cross-mode fast deltas");
+		check(stats.count[ETS_STATS_CALC_SORT_KEY] == threads * keys, "calls from exited threads");
+		check(stats.count[ETS_STATS_NOW_BUMPED] <= stats.count[ETS_STATS_NOW], "bumped now() readings");
+		fprintf(stderr, "  ... %llu of %llu now() readings were bumped\n", static_cast<unsigned long long>(stats.count[ETS_STATS_NOW_BUMPED]), static_cast<unsigned long long>(stats.count[ETS_STATS_NOW]));
+		if (EternalTimestampStats::timers_enabled())
+			check(stats.ticks[ETS_STATS_NOW] > 0 && stats.ticks[ETS_STATS_NOW_BUMPED] == 0, "timers");
+		else
+			check(stats.ticks[ETS_STATS_NOW] == 0, "no timers");
+
+		// the dump lists the counters which are not zero
+		const std::string text = dump(stats);
+		check(text.find("ets_calls_total{entry=\"EternalTimestamp::cvt_from_iso8601\"} 3\n") != std::string::npos, "dump: calls");
+		check(text.find("ets_events_total{event=\"fast_delta_cross_mode\"} 1\n") != std::string::npos, "dump: events");
+		check(text.find("EternalTimestampZone") == std::string::npos, "dump: zero counters are left out");
+
+		// reset() starts over, also for the counts of the other threads
+		EternalTimestampStats::reset();
+		EternalTimestamp::calc_sort_key(t);
+		EternalTimestampStats::snapshot(stats);
+		check(stats.count[ETS_STATS_CALC_SORT_KEY] == 1 && stats.count[ETS_STATS_NOW] == 0, "EternalTimestampStats::reset()");
+	}
+	else {
+		zero = true;
+		for (int i = 0; i < ETS_STATS_COUNT; i++)
+			zero &= (stats.count[i] == 0 && stats.ticks[i] == 0);
+		check(zero, "no counts when compiled out");
+		check(dump(stats).find("} ") == std::string::npos, "dump: no samples when compiled out");
+	}
+
+	// snprintf() semantics
+	{
+		const size_t length = EternalTimestampStats::dump(nullptr, 0, stats);
+		char small[16];
+		check(EternalTimestampStats::dump(small, sizeof(small), stats) == length && strlen(small) == sizeof(small) - 1, "EternalTimestampStats::dump() truncation");
+	}
+
+	// the C interface
+	{
+		ets_stats_t c;
+		ets_stats_snapshot(&c);
+		check(ets_stats_enabled() == enabled && !strcmp(ets_stats_name(ETS_STATS_TZ_LOAD), "EternalTimestampZone::load"), "ets_stats_enabled(), ets_stats_name()");
+		check(ets_stats_dump(nullptr, 0, &c) == EternalTimestampStats::dump(nullptr, 0, c), "ets_stats_dump()");
+		ets_stats_reset();
+		ets_stats_snapshot(&c);
+		check(c.count[ETS_STATS_CALC_SORT_KEY] == 0, "ets_stats_reset()");
+	}
+
+	if (failures) {
+		fprintf(stderr, "\n%d test(s) FAILED\n", failures);
+		return EXIT_FAILURE;
+	}
+	fprintf(stderr, "All tests passed\n");
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,333 @@
+#include <eternal_timestamp/eternal_timestamp.h>
+#include <eternal_timestamp/eternal_timestamp_batch.h>
+#include <eternal_timestamp/eternal_timestamp_parallel.h>
+#include <eternal_timestamp/eternal_timestamp_terms.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "monolithic_examples.h"
+
+
+using namespace eternal_timestamp;
+
+static int failures = 0;
+
+static void check(bool ok, const char *what)
+{
+	if (!ok) {
+		fprintf(stderr, "FAIL: %s\n", what);
+		failures++;
+	}
+}
+
+static eternal_timestamp_t parse(const char *iso8601)
+{
+	eternal_timestamp_t t;
+	t.t = 0;
+	EternalTimestamp::cvt_from_iso8601(t, iso8601, strlen(iso8601));
+	return t;
+}
+
+static eternal_timestamp_t at(int64_t usecs)
+{
+	eternal_timestamp_t t;
+	EternalTimestampBatch::cvt_from_unix_usecs(&t, nullptr, &usecs, 1, 1);
+	return t;
+}
+
+// The documents: log-like timestamps over a few years, plus the awkward ones: partial timestamps, values on
+// field boundaries, leap seconds and prehistoric dates.
+static std::vector<eternal_timestamp_t> make_documents(std::mt19937_64 &rng)
+{
+	std::vector<eternal_timestamp_t> docs;
+	const int64_t start = 1546300800LL * 1000000;                 // 2019-01-01
+	const int64_t span = 3LL * 365 * 86400 * 1000000;
+	for (int i = 0; i < 15000; i++) {
+		int64_t usecs = start + static_cast<int64_t>(rng() % static_cast<uint64_t>(span));
+		switch (rng() % 4) {
+		case 0:
+			usecs -= usecs % 1000000;                                 // on the second
+			break;
+		case 1:
+			usecs -= usecs % (86400LL * 1000000);                     // at midnight
+			break;
+		}
+		docs.push_back(at(usecs));
+	}
+
+	static const char *const specials[] = {
+		"2019", "2020", "2020-09", "2020-09-01", "2020-09-13", "2020-09-13T12", "2020-09-13T12:30",
+		"2020-09-13T12:30:15", "2020-09-13T12:30:15.250", "2020-10", "2020-10-01", "2021",
+		"2019-12-28T09:30", "2019-12-28T09:29:59.999999", "2019-12-31T23:59:59.999999", "2020-01-01T00:00:00",
+		"2016-12-31T23:59:60", "2016-12-31T23:59:60.500", "2019-06-30T23:59:60",
+		"0001-01-01", "-9000", "-12000-01-01", "-20000", "-20000-05", "1970-01-01",
+	};
+	for (const char *s : specials) {
+		for (int i = 0; i < 5; i++)
+			docs.push_back(parse(s));
+	}
+	return docs;
+}
+
+// An index: (term, document) pairs, sorted.
+typedef std::vector<std::pair<ets_term_t, size_t>> term_index;
+
+static term_index make_index(const std::vector<eternal_timestamp_t> &docs, unsigned int levels)
+{
+	const size_t per_doc = EternalTimestampTerms::count_levels(levels);
+	std::vector<ets_term_t> terms(docs.size() * per_doc);
+	EternalTimestampTerms::calc_terms_batch(terms.data(), docs.data(), docs.size(), levels, 1);
+	term_index index;
+	for (size_t i = 0; i < terms.size(); i++)
+		index.emplace_back(terms[i], i / per_doc);
+	std::sort(index.begin(), index.end());
+	return index;
+}
+
+// Run the query against the index and against the documents themselves; false when they disagree.
+static bool query_matches(const term_index &index, const std::vector<eternal_timestamp_t> &docs, const eternal_timestamp_t lo, const eternal_timestamp_t hi, unsigned int levels, size_t *term_count = nullptr)
+{
+	std::vector<ets_term_t> terms(64);
+	size_t n = EternalTimestampTerms::plan_range(terms.data(), terms.size(), lo, hi, levels);
+	if (n > terms.size()) {
+		terms.resize(n);
+		if (EternalTimestampTerms::plan_range(terms.data(), terms.size(), lo, hi, levels) != n)
+			return false;
+	}
+	terms.resize(n);
+	if (term_count)
+		*term_count = n;
+
+	std::vector<unsigned int> hits(docs.size(), 0);
+	for (ets_term_t term : terms) {
+		auto it = std::lower_bound(index.begin(), index.end(), std::make_pair(term, static_cast<size_t>(0)));
+		for (; it != index.end() && it->first == term; ++it)
+			hits[it->second]++;
+	}
+
+	const int64_t lo_key = EternalTimestamp::calc_sort_key(EternalTimestampTerms::calc_range_bound(lo));
+	const int64_t hi_key = EternalTimestamp::calc_sort_key(EternalTimestampTerms::calc_range_bound(hi));
+	for (size_t i = 0; i < docs.size(); i++) {
+		const int64_t key = EternalTimestamp::calc_sort_key(docs[i]);
+		const unsigned int expected = (lo_key <= key && key < hi_key);
+		// the terms are disjoint: a match is a single hit
+		if (hits[i] != expected)
+			return false;
+	}
+	return true;
+}
+
+// A range bound: a document's timestamp, or a partial timestamp / boundary made from one.
+static eternal_timestamp_t make_bound(std::mt19937_64 &rng, const std::vector<eternal_timestamp_t> &docs)
+{
+	const eternal_timestamp_t t = docs[rng() % docs.size()];
+	if (!EternalTimestamp::is_modern_format(t) || rng() % 2)
+		return t;
+	// cut after the year, month, day, hour, minute or second: the rest unspecified, or at its first value
+	const unsigned int code = static_cast<unsigned int>(rng() % 3 == 0);
+	eternal_timestamp_t bound = t;
+	switch (rng() % 6) {
+	case 0:
+		bound = ets_modern_set_month(bound, code);
+		[[fallthrough]];
+	case 1:
+		bound = ets_modern_set_day(bound, code);
+		[[fallthrough]];
+	case 2:
+		bound = ets_modern_set_hour(bound, code);
+		[[fallthrough]];
+	case 3:
+		bound = ets_modern_set_minute(bound, code);
+		[[fallthrough]];
+	case 4:
+		bound = ets_modern_set_seconds(bound, code);
+		[[fallthrough]];
+	default:
+		bound = ets_modern_set_milliseconds(bound, code);
+		bound = ets_modern_set_microseconds(bound, code);
+	}
+	return bound;
+}
+
+static void test_against_brute_force()
+{
+	std::mt19937_64 rng(20200913);
+	const std::vector<eternal_timestamp_t> docs = make_documents(rng);
+
+	const unsigned int level_sets[] = {
+		ETS_TERM_LEVELS_ALL,
+		(1U << ETS_TERM_YEAR) | (1U << ETS_TERM_DAY) | (1U << ETS_TERM_MINUTE) | (1U << ETS_TERM_MILLISECONDS),
+		(1U << ETS_TERM_MONTH) | (1U << ETS_TERM_HOUR) | (1U << ETS_TERM_SECONDS),
+	};
+	for (unsigned int levels : level_sets) {
+		const term_index index = make_index(docs, levels);
+		bool ok = true;
+		size_t max_terms = 0;
+		for (int q = 0; q < 400; q++) {
+			eternal_timestamp_t lo = make_bound(rng, docs);
+			eternal_timestamp_t hi = make_bound(rng, docs);
+			if (EternalTimestamp::calc_sort_key(hi) < EternalTimestamp::calc_sort_key(lo))
+				std::swap(lo, hi);
+			// the sparse level sets take whole days of milliseconds: keep those ranges short
+			if (levels != ETS_TERM_LEVELS_ALL) {
+				size_t n = EternalTimestampTerms::plan_range(nullptr, 0, lo, hi, levels);
+				if (n > 200000)
+					continue;
+			}
+			size_t n = 0;
+			ok &= query_matches(index, docs, lo, hi, levels, &n);
+			if (n > max_terms)
+				max_terms = n;
+		}
+		check(ok, "plan_range(): the terms match what the range does");
+		if (levels == ETS_TERM_LEVELS_ALL)
+			check(max_terms <= 5200, "plan_range(): at most some 5000 terms");
+	}
+
+	// the empty range and a single microsecond
+	const term_index index = make_index(docs, ETS_TERM_LEVELS_ALL);
+	const eternal_timestamp_t t = parse("2020-09-13T12:30:15.250");
+	check(EternalTimestampTerms::plan_range(nullptr, 0, t, t) == 0, "plan_range(): empty range");
+	check(EternalTimestampTerms::plan_range(nullptr, 0, parse("2021"), parse("2020")) == 0, "plan_range(): reversed range");
+	size_t n = 0;
+	check(query_matches(index, docs, t, parse("2020-09-13T12:30:15.250001"), ETS_TERM_LEVELS_ALL, &n) && n == 2, "plan_range(): [.250, .250001) is .250 and its partial .250xxx");
+}
+
+static void test_minimal_sets()
+{
+	ets_term_t terms[128];
+
+	// one month
+	size_t n = EternalTimestampTerms::plan_range(terms, 128, parse("2020-09-01T00:00:00.000000"), parse("2020-10-01T00:00:00.000000"));
+	check(n == 1 && EternalTimestampTerms::term_level(terms[0]) == ETS_TERM_MONTH, "plan_range(): a month is one term");
+	ets_term_t month[ETS_TERM_LEVEL_COUNT];
+	EternalTimestampTerms::calc_terms(month, parse("2020-09-17T08:00"));
+	check(terms[0] == month[ETS_TERM_MONTH], "plan_range(): the month term");
+	check(EternalTimestampTerms::plan_range(terms, 128, parse("2020-09"), parse("2020-10")) == 1, "plan_range(): partial bounds");
+
+	// the example from the header
+	n = EternalTimestampTerms::plan_range(terms, 128, parse("2019-12-28T09:30"), parse("2021"));
+	check(n == 48, "plan_range(): [2019-12-28T09:30, 2021) is 48 terms");
+	size_t per_level[ETS_TERM_LEVEL_COUNT] = { 0 };
+	for (size_t i = 0; i < n && i < 128; i++)
+		per_level[EternalTimestampTerms::term_level(terms[i])]++;
+	check(per_level[ETS_TERM_MINUTE] == 30 && per_level[ETS_TERM_HOUR] == 14 && per_level[ETS_TERM_DAY] == 3 && per_level[ETS_TERM_YEAR] == 1, "plan_range(): terms per level");
+
+	// a whole century, and a whole day with the day level left out
+	check(EternalTimestampTerms::plan_range(terms, 128, parse("2000"), parse("2100")) == 1, "plan_range(): a century");
+	n = EternalTimestampTerms::plan_range(terms, 128, parse("2020-09-13"), parse("2020-09-14"), ETS_TERM_LEVELS_ALL & ~(1U << ETS_TERM_DAY));
+	check(n == 25 && EternalTimestampTerms::term_level(terms[0]) == ETS_TERM_HOUR, "plan_range(): a day in hours, plus the partial one");
+
+	// too little room
+	check(EternalTimestampTerms::plan_range(terms, 10, parse("2019-12-28T09:30"), parse("2021")) == 48, "plan_range(): capacity");
+}
+
+static void test_batch()
+{
+	std::mt19937_64 rng(42);
+	const std::vector<eternal_timestamp_t> docs = make_documents(rng);
+
+	const size_t per_doc = EternalTimestampTerms::count_levels(ETS_TERM_LEVELS_ALL);
+	check(per_doc == ETS_TERM_LEVEL_COUNT, "count_levels()");
+	check(EternalTimestampTerms::count_levels(0) == 1 && EternalTimestampTerms::count_levels(1U << ETS_TERM_DAY) == 2, "count_levels(): microseconds always");
+
+	std::vector<ets_term_t> serial(docs.size() * per_doc), parallel(docs.size() * per_doc);
+	EternalTimestampTerms::calc_terms_batch(serial.data(), docs.data(), docs.size(), ETS_TERM_LEVELS_ALL, 1);
+	EternalTimestampTerms::calc_terms_batch(parallel.data(), docs.data(), docs.size(), ETS_TERM_LEVELS_ALL, ETS_PARALLELISM_ALL);
+	check(serial == parallel, "calc_terms_batch(): parallel");
+	ets_term_t one[ETS_TERM_LEVEL_COUNT];
+	bool same = true;
+	bool levels_ok = true;
+	for (size_t i = 0; i < docs.size(); i++) {
+		EternalTimestampTerms::calc_terms(one, docs[i]);
+		for (size_t j = 0; j < per_doc; j++) {
+			same &= (one[j] == serial[i * per_doc + j]);
+			levels_ok &= (EternalTimestampTerms::term_level(one[j]) == static_cast<int>(j));
+		}
+	}
+	check(same, "calc_terms_batch() vs. calc_terms()");
+	check(levels_ok, "term_level()");
+
+	const size_t count = 300;
+	std::vector<eternal_timestamp_t> lo(count), hi(count);
+	for (size_t i = 0; i < count; i++) {
+		lo[i] = docs[rng() % docs.size()];
+		hi[i] = docs[rng() % docs.size()];
+	}
+	std::vector<size_t> offsets(count + 1);
+	const size_t total = EternalTimestampTerms::plan_ranges(nullptr, 0, offsets.data(), lo.data(), hi.data(), count);
+	check(total == offsets[count], "plan_ranges(): offsets");
+	std::vector<ets_term_t> terms(total);
+	check(EternalTimestampTerms::plan_ranges(terms.data(), terms.size(), offsets.data(), lo.data(), hi.data(), count, ETS_TERM_LEVELS_ALL, ETS_PARALLELISM_ALL) == total, "plan_ranges()");
+	bool ranges_ok = true;
+	std::vector<ets_term_t> expected(8000);
+	for (size_t i = 0; i < count; i++) {
+		const size_t n = EternalTimestampTerms::plan_range(expected.data(), expected.size(), lo[i], hi[i]);
+		ranges_ok &= (n == offsets[i + 1] - offsets[i] && std::equal(expected.begin(), expected.begin() + n, terms.begin() + offsets[i]));
+	}
+	check(ranges_ok, "plan_ranges() vs. plan_range()");
+}
+
+static void test_misc()
+{
+	check(EternalTimestampTerms::calc_range_bound(parse("2020-09-01T00:00:00.000000")).t == parse("2020-09").t, "calc_range_bound(): month");
+	check(EternalTimestampTerms::calc_range_bound(parse("2020-01-01T00:00:00")).t == parse("2020").t, "calc_range_bound(): year");
+	check(EternalTimestampTerms::calc_range_bound(parse("2020-09-13T12:00:00.000000")).t == parse("2020-09-13T12").t, "calc_range_bound(): hour");
+	check(EternalTimestampTerms::calc_range_bound(parse("2020-09-13T12:00:00.000001")).t == parse("2020-09-13T12:00:00.000001").t, "calc_range_bound(): not on a boundary");
+	check(EternalTimestampTerms::calc_range_bound(parse("-20000")).t == parse("-20000").t, "calc_range_bound(): prehistoric");
+
+	check(EternalTimestampTerms::term_level(0) == -1 && EternalTimestampTerms::term_level(1ULL << 5) == -1, "term_level(): not a term");
+
+	// text terms sort like the terms
+	ets_term_t a[ETS_TERM_LEVEL_COUNT], b[ETS_TERM_LEVEL_COUNT];
+	EternalTimestampTerms::calc_terms(a, parse("2020-09-13T12:30:15.250"));
+	EternalTimestampTerms::calc_terms(b, parse("2020-09-13T12:30:15.251"));
+	char ta[ETS_TERM_TEXT_LENGTH + 1], tb[ETS_TERM_TEXT_LENGTH + 1];
+	check(EternalTimestampTerms::format_term(ta, sizeof(ta), a[ETS_TERM_MILLISECONDS]) == ETS_TERM_TEXT_LENGTH, "format_term()");
+	EternalTimestampTerms::format_term(tb, sizeof(tb), b[ETS_TERM_MILLISECONDS]);
+	check(strlen(ta) == ETS_TERM_TEXT_LENGTH && strcmp(ta, tb) < 0, "format_term(): order");
+	check(EternalTimestampTerms::format_term(ta, ETS_TERM_TEXT_LENGTH, a[0]) == 0, "format_term(): capacity");
+	check(a[ETS_TERM_SECONDS] == b[ETS_TERM_SECONDS] && a[ETS_TERM_MILLISECONDS] != b[ETS_TERM_MILLISECONDS], "calc_terms(): prefixes");
+
+	// the C interface
+	ets_term_t terms[ETS_TERM_LEVEL_COUNT];
+	check(ets_terms_count_levels(1U << ETS_TERM_YEAR) == 2, "ets_terms_count_levels()");
+	check(ets_terms_calc_terms(terms, parse("2020-09-13"), 1U << ETS_TERM_YEAR) == 2 && ets_terms_term_level(terms[0]) == ETS_TERM_YEAR, "ets_terms_calc_terms()");
+	const eternal_timestamp_t lo = parse("2020"), hi = parse("2021");
+	ets_terms_calc_terms_batch(terms, &lo, 1, 1U << ETS_TERM_YEAR);
+	ets_term_t planned[4];
+	check(ets_terms_plan_range(planned, 4, lo, hi, 1U << ETS_TERM_YEAR) == 1 && planned[0] == terms[0], "ets_terms_plan_range()");
+	size_t offsets[2];
+	check(ets_terms_plan_ranges(planned, 4, offsets, &lo, &hi, 1, 1U << ETS_TERM_YEAR) == 1 && offsets[1] == 1, "ets_terms_plan_ranges()");
+	check(ets_terms_calc_range_bound(parse("2020-01-01")).t == lo.t, "ets_terms_calc_range_bound()");
+	char text[ETS_TERM_TEXT_LENGTH + 1];
+	check(ets_terms_format_term(text, sizeof(text), 0x0123456789abcdefULL) == ETS_TERM_TEXT_LENGTH && strcmp(text, "0123456789abcdef") == 0, "ets_terms_format_term()");
+}
+
+
+#if defined(BUILD_MONOLITHIC)
+#define main(cnt, arr)      eternalty_test_terms_main(cnt, arr)
+#endif
+
+int main(int argc, const char **argv)
+{
+	(void)argc;
+	(void)argv;
+
+	test_against_brute_force();
+	test_minimal_sets();
+	test_batch();
+	test_misc();
+
+	if (failures) {
+		fprintf(stderr, "\n%d test(s) FAILED\n", failures);
+		return EXIT_FAILURE;
+	}
+	fprintf(stderr, "All tests passed\n");
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,338 @@
+#include <eternal_timestamp/eternal_timestamp.h>
+#include <eternal_timestamp/eternal_timestamp_batch.h>
+#include <eternal_timestamp/eternal_timestamp_timer.h>
+#include <errno.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "monolithic_examples.h"
+
+
+using namespace eternal_timestamp;
+
+static int failures = 0;
+
+static void check(bool ok, const char *what)
+{
+	if (!ok) {
+		fprintf(stderr, "FAIL: %s\n", what);
+		failures++;
+	}
+}
+
+static const int64_t USECS_PER_MSEC = 1000;
+static const int64_t USECS_PER_DAY = 86400LL * 1000000;
+
+// 2026-01-01T00:00:00Z
+static const int64_t BASE = 1767225600LL * 1000000;
+
+static eternal_timestamp_t at(int64_t usecs)
+{
+	eternal_timestamp_t t;
+	EternalTimestampBatch::cvt_from_unix_usecs(&t, nullptr, &usecs, 1, 1);
+	return t;
+}
+
+static int64_t usecs_of(const eternal_timestamp_t t)
+{
+	int64_t usecs = 0;
+	uint8_t validity = 0;
+	EternalTimestampBatch::cvt_to_unix_usecs(&usecs, &validity, &t, 1, 1);
+	return usecs;
+}
+
+static eternal_timestamp_t parse(const char *iso8601)
+{
+	eternal_timestamp_t t;
+	t.t = 0;
+	EternalTimestamp::cvt_from_iso8601(t, iso8601, strlen(iso8601));
+	return t;
+}
+
+static int64_t msecs(int64_t usecs)
+{
+	return usecs / USECS_PER_MSEC;
+}
+
+struct reference_timer
+{
+	int64_t deadline;                     // usecs
+	ets_timer_handle_t handle;
+	bool cancelled;
+	bool drained;
+};
+
+// Random timers over three months, checked against the plain list while the time moves forward in steps of a
+// millisecond to a few days.
+static void test_against_reference()
+{
+	std::mt19937_64 rng(20260101);
+	const size_t N = 50000;
+	const int64_t span = 92 * USECS_PER_DAY;
+
+	ets_timer_wheel_t *wheel = nullptr;
+	check(EternalTimestampTimerWheel::create(wheel, at(BASE)) == 0, "create()");
+
+	std::vector<reference_timer> timers(N);
+	for (size_t i = 0; i < N; i++) {
+		// clusters around the current time (short timeouts) and the odd one far out
+		int64_t delta;
+		switch (rng() % 4) {
+		case 0:
+			delta = static_cast<int64_t>(rng() % 2000) * USECS_PER_MSEC;
+			break;
+		case 1:
+			delta = static_cast<int64_t>(rng() % (3600LL * 1000000));
+			break;
+		default:
+			delta = static_cast<int64_t>(rng() % static_cast<uint64_t>(span));
+			break;
+		}
+		timers[i].deadline = BASE + delta;
+		timers[i].cancelled = false;
+		timers[i].drained = false;
+		check(EternalTimestampTimerWheel::insert(wheel, &timers[i].handle, at(timers[i].deadline), i) == 0, "insert()");
+	}
+	check(EternalTimestampTimerWheel::size(wheel) == N, "size() after insert()");
+
+	size_t cancelled = 0;
+	for (size_t i = 0; i < N; i += 3) {
+		cancelled += EternalTimestampTimerWheel::cancel(wheel, timers[i].handle);
+		timers[i].cancelled = true;
+	}
+	check(cancelled == (N + 2) / 3, "cancel()");
+	check(!EternalTimestampTimerWheel::cancel(wheel, timers[0].handle), "cancel() twice");
+	check(EternalTimestampTimerWheel::size(wheel) == N - cancelled, "size() after cancel()");
+
+	std::vector<ets_timer_t> out(977);
+	int64_t now = BASE;
+	int64_t last_drained = BASE;
+	bool ordered = true;
+	bool in_time = true;
+	bool known = true;
+	bool next_ok = true;
+	size_t drained = 0;
+	while (now < BASE + span + USECS_PER_DAY) {
+		// the earliest remaining deadline
+		int64_t earliest = INT64_MAX;
+		for (const auto &r : timers) {
+			if (!r.cancelled && !r.drained && r.deadline < earliest)
+				earliest = r.deadline;
+		}
+		eternal_timestamp_t next;
+		if (earliest == INT64_MAX)
+			next_ok &= !EternalTimestampTimerWheel::next_expiry(wheel, next);
+		else
+			next_ok &= (EternalTimestampTimerWheel::next_expiry(wheel, next) && usecs_of(next) == earliest);
+
+		switch (rng() % 3) {
+		case 0:
+			now += USECS_PER_MSEC;
+			break;
+		case 1:
+			now += static_cast<int64_t>(rng() % (600LL * 1000000));
+			break;
+		default:
+			now += static_cast<int64_t>(rng() % (3 * USECS_PER_DAY));
+			break;
+		}
+		check(EternalTimestampTimerWheel::advance(wheel, at(now)) == 0, "advance()");
+
+		size_t n;
+		while ((n = EternalTimestampTimerWheel::drain(wheel, out.data(), out.size())) != 0) {
+			for (size_t j = 0; j < n; j++) {
+				const uint64_t i = out[j].payload;
+				if (i >= N || timers[i].cancelled || timers[i].drained || out[j].handle != timers[i].handle) {
+					known = false;
+					continue;
+				}
+				timers[i].drained = true;
+				drained++;
+				const int64_t d = usecs_of(out[j].deadline);
+				in_time &= (d == timers[i].deadline && msecs(d) <= msecs(now));
+				ordered &= (msecs(d) >= msecs(last_drained));
+				last_drained = d;
+			}
+		}
+		// nothing which is due may be left behind
+		for (const auto &r : timers)
+			in_time &= (r.cancelled || r.drained || msecs(r.deadline) > msecs(now));
+	}
+	check(known, "drain(): timers are the inserted ones, each once");
+	check(in_time, "drain(): timers expire on time");
+	check(ordered, "drain(): timers expire in deadline order");
+	check(next_ok, "next_expiry()");
+	check(drained == N - cancelled, "drain(): all timers expire");
+	check(EternalTimestampTimerWheel::size(wheel) == 0, "size() when empty");
+	check(!EternalTimestampTimerWheel::cancel(wheel, timers[1].handle), "cancel() after drain()");
+
+	EternalTimestampTimerWheel::destroy(wheel);
+}
+
+static void test_edge_cases()
+{
+	ets_timer_wheel_t *wheel = nullptr;
+	check(EternalTimestampTimerWheel::create(wheel, parse("2020-09")) == EINVAL, "create(): incomplete date");
+	check(wheel == nullptr, "create(): no wheel on failure");
+
+	// the last millisecond of the year
+	check(EternalTimestampTimerWheel::create(wheel, parse("2025-12-31T23:59:59.999")) == 0, "create()");
+	ets_timer_handle_t h[6];
+	check(EternalTimestampTimerWheel::insert(wheel, &h[0], parse("2026-01-01T00:00:00.000"), 0) == 0, "insert(): next year");
+	check(EternalTimestampTimerWheel::insert(wheel, &h[1], parse("2026-01-01T00:00:00.001"), 1) == 0, "insert(): next year");
+	check(EternalTimestampTimerWheel::insert(wheel, &h[2], parse("2026-03-01T12"), 2) == 0, "insert(): unspecified time fields");
+	check(EternalTimestampTimerWheel::insert(wheel, &h[3], parse("2025-12-31T23:59:59.999"), 3) == 0, "insert(): now");
+	check(EternalTimestampTimerWheel::insert(wheel, &h[4], parse("1999-01-01"), 4) == 0, "insert(): past");
+	check(EternalTimestampTimerWheel::insert(wheel, &h[5], parse("2026-01"), 5) == EINVAL && h[5] == 0, "insert(): incomplete date");
+	check(EternalTimestampTimerWheel::size(wheel) == 5, "size()");
+
+	// due at once, but not drained yet: still cancellable
+	check(EternalTimestampTimerWheel::cancel(wheel, h[4]), "cancel(): expired timer");
+	check(!EternalTimestampTimerWheel::cancel(wheel, h[4]), "cancel(): stale handle");
+	check(!EternalTimestampTimerWheel::cancel(wheel, 0), "cancel(): zero handle");
+	check(!EternalTimestampTimerWheel::cancel(wheel, 12345), "cancel(): unknown handle");
+
+	ets_timer_t out[8];
+	check(EternalTimestampTimerWheel::drain(wheel, out, 8) == 1 && out[0].payload == 3 && out[0].handle == h[3], "drain(): due at once");
+
+	check(EternalTimestampTimerWheel::advance(wheel, parse("2026-01")) == EINVAL, "advance(): incomplete date");
+	check(EternalTimestampTimerWheel::advance(wheel, parse("2025-06-01")) == 0, "advance(): backwards");
+	check(EternalTimestampTimerWheel::drain(wheel, out, 8) == 0, "advance(): backwards is a no-op");
+
+	eternal_timestamp_t next;
+	check(EternalTimestampTimerWheel::next_expiry(wheel, next) && next.t == parse("2026-01-01T00:00:00.000").t, "next_expiry()");
+	check(EternalTimestampTimerWheel::poll(wheel, parse("2026-01-01T00:00:00.000"), out, 8) == 1 && out[0].payload == 0, "poll(): year rollover");
+	check(usecs_of(EternalTimestampTimerWheel::now(wheel)) == BASE, "now()");
+	check(EternalTimestampTimerWheel::poll(wheel, parse("2026-03-01T11:59:59.999999"), out, 8) == 1 && out[0].payload == 1, "poll(): overflow heap");
+	check(EternalTimestampTimerWheel::poll(wheel, parse("2026-03-01T12:00:00.000"), out, 8) == 1 && out[0].payload == 2, "poll(): unspecified time fields");
+	check(!EternalTimestampTimerWheel::next_expiry(wheel, next), "next_expiry(): empty");
+
+	// insert_batch() without payloads
+	eternal_timestamp_t deadlines[4] = {
+		parse("2026-03-01T12:00:00.002"),
+		parse("2026-03-01T12:00:00.001"),
+		parse("2027-03-01"),
+		parse("2026-03-01T12:00:00.003"),
+	};
+	ets_timer_handle_t handles[4];
+	check(EternalTimestampTimerWheel::insert_batch(wheel, handles, deadlines, nullptr, 4) == 0, "insert_batch()");
+	check(EternalTimestampTimerWheel::poll(wheel, parse("2026-03-01T12:00:00.002"), out, 8) == 2 && out[0].payload == 1 && out[1].payload == 0, "insert_batch(): payloads");
+	deadlines[1] = parse("2020");
+	check(EternalTimestampTimerWheel::insert_batch(wheel, handles, deadlines, nullptr, 4) == EINVAL && handles[0] != 0 && handles[1] == 0 && handles[3] == 0, "insert_batch(): failure");
+	check(EternalTimestampTimerWheel::size(wheel) == 3, "insert_batch(): size()");
+
+	// handles are not reused
+	check(EternalTimestampTimerWheel::cancel(wheel, handles[0]), "cancel()");
+	ets_timer_handle_t again;
+	EternalTimestampTimerWheel::insert(wheel, &again, deadlines[0], 0);
+	check(again != handles[0] && !EternalTimestampTimerWheel::cancel(wheel, handles[0]), "cancel(): reused node");
+
+	EternalTimestampTimerWheel::destroy(wheel);
+}
+
+// Producers post timers and cancel some of them while the owner polls.
+static void test_post()
+{
+	ets_timer_wheel_t *wheel = nullptr;
+	EternalTimestampTimerWheel::create(wheel, at(BASE));
+
+	const unsigned int PRODUCERS = 4;
+	const size_t PER_PRODUCER = 20000;
+	std::atomic<unsigned int> done{ 0 };
+	std::vector<std::thread> producers;
+	for (unsigned int p = 0; p < PRODUCERS; p++) {
+		producers.emplace_back([&, p] {
+			std::mt19937_64 rng(p);
+			for (size_t i = 0; i < PER_PRODUCER; i++) {
+				ets_timer_handle_t h;
+				const uint64_t payload = p * PER_PRODUCER + i;
+				if (EternalTimestampTimerWheel::post(wheel, &h, at(BASE + static_cast<int64_t>(rng() % (60LL * 1000000))), payload))
+					continue;
+				// cancelled timers have odd payloads; cancelling may come too late
+				if (payload % 2 && rng() % 2)
+					EternalTimestampTimerWheel::post_cancel(wheel, h);
+			}
+			done++;
+		});
+	}
+
+	std::vector<unsigned int> seen(PRODUCERS * PER_PRODUCER, 0);
+	ets_timer_t out[256];
+	int64_t now = BASE;
+	for (;;) {
+		const bool finished = (done.load() == PRODUCERS);
+		now += 7 * USECS_PER_MSEC;
+		size_t n;
+		while ((n = EternalTimestampTimerWheel::poll(wheel, at(now), out, 256)) != 0) {
+			for (size_t j = 0; j < n; j++)
+				seen[out[j].payload]++;
+		}
+		if (finished && now > BASE + 61LL * 1000000)
+			break;
+	}
+	for (auto &t : producers)
+		t.join();
+
+	bool once = true;
+	bool evens = true;
+	for (size_t i = 0; i < seen.size(); i++) {
+		once &= (seen[i] <= 1);
+		evens &= (i % 2 || seen[i] == 1);
+	}
+	check(once, "post(): each timer expires at most once");
+	check(evens, "post(): timers which were not cancelled expire");
+	check(EternalTimestampTimerWheel::size(wheel) == 0, "post(): size() when done");
+
+	EternalTimestampTimerWheel::destroy(wheel);
+}
+
+static void test_c_api()
+{
+	ets_timer_wheel_t *wheel = nullptr;
+	check(ets_timer_wheel_create(&wheel, parse("2026-01-01T00:00:00")) == 0, "ets_timer_wheel_create()");
+	ets_timer_handle_t h1, h2, h3;
+	check(ets_timer_wheel_insert(wheel, &h1, parse("2026-01-01T00:00:01"), 1) == 0, "ets_timer_wheel_insert()");
+	const eternal_timestamp_t d = parse("2026-01-01T00:00:02");
+	check(ets_timer_wheel_insert_batch(wheel, &h2, &d, nullptr, 1) == 0, "ets_timer_wheel_insert_batch()");
+	check(ets_timer_wheel_post(wheel, &h3, parse("2026-01-01T00:00:03"), 3) == 0, "ets_timer_wheel_post()");
+	check(ets_timer_wheel_size(wheel) == 2, "ets_timer_wheel_size()");
+	ets_timer_wheel_post_cancel(wheel, h3);
+	check(ets_timer_wheel_cancel(wheel, h2) == 1, "ets_timer_wheel_cancel()");
+	check(ets_timer_wheel_advance(wheel, parse("2026-01-01T00:00:05")) == 0, "ets_timer_wheel_advance()");
+	eternal_timestamp_t next;
+	check(ets_timer_wheel_next_expiry(wheel, &next) == 1 && next.t == parse("2026-01-01T00:00:01").t, "ets_timer_wheel_next_expiry()");
+	ets_timer_t out[4];
+	check(ets_timer_wheel_drain(wheel, out, 4) == 1 && out[0].payload == 1 && out[0].handle == h1, "ets_timer_wheel_drain()");
+	check(ets_timer_wheel_poll(wheel, parse("2026-01-02"), out, 4) == 0, "ets_timer_wheel_poll()");
+	check(usecs_of(ets_timer_wheel_now(wheel)) == BASE + USECS_PER_DAY, "ets_timer_wheel_now()");
+	ets_timer_wheel_destroy(wheel);
+}
+
+
+#if defined(BUILD_MONOLITHIC)
+#define main(cnt, arr)      eternalty_test_timer_main(cnt, arr)
+#endif
+
+int main(int argc, const char **argv)
+{
+	(void)argc;
+	(void)argv;
+
+	test_against_reference();
+	test_edge_cases();
+	test_post();
+	test_c_api();
+
+	if (failures) {
+		fprintf(stderr, "\n%d test(s) FAILED\n", failures);
+		return EXIT_FAILURE;
+	}
+	fprintf(stderr, "All tests passed\n");
+	return EXIT_SUCCESS;
+}
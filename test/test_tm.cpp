@@ -0,0 +1,180 @@
+#include <eternal_timestamp/eternal_timestamp.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+#include "monolithic_examples.h"
+
+
+using namespace eternal_timestamp;
+
+static int failures = 0;
+
+static void check(bool ok, const char *what)
+{
+	if (!ok) {
+		fprintf(stderr, "FAIL: %s\n", what);
+		failures++;
+	}
+}
+
+// The value fields store value+1 when the 'unspecified' marker sorts before the first value; month and day
+// store value-1 on top of that.
+static const unsigned OFS = (ETS_UNSPECIFIED_MARKER_SORTS_BEFORE_1ST_VALUE ? 1 : 0);
+
+static struct tm make_tm(int year, int month, int day, int hour, int minute, int seconds)
+{
+	struct tm ts;
+	memset(&ts, 0, sizeof(ts));
+	ts.tm_year = year - 1900;
+	ts.tm_mon = month - 1;
+	ts.tm_mday = day;
+	ts.tm_hour = hour;
+	ts.tm_min = minute;
+	ts.tm_sec = seconds;
+	return ts;
+}
+
+static bool is_modern_date(const eternal_timestamp_t t, unsigned century, unsigned year, unsigned month, unsigned day, unsigned hour, unsigned minute, unsigned seconds)
+{
+	return ets_format_sign(t) == 0
+		&& ets_format_mode(t) == 0
+		&& ets_modern_century(t) == century
+		&& ets_modern_year(t) == OFS + year
+		&& ets_modern_month(t) == OFS - 1 + month
+		&& ets_modern_day(t) == OFS - 1 + day
+		&& ets_modern_hour(t) == OFS + hour
+		&& ets_modern_minute(t) == OFS + minute
+		&& ets_modern_seconds(t) == OFS + seconds;
+}
+
+static void test_from_tm()
+{
+	eternal_timestamp_t t;
+
+	struct tm ts = make_tm(2022, 1, 13, 12, 40, 31);
+	t.t = 0;
+	check(EternalTimestamp::cvt_from_tm(t, ts) == 0, "cvt_from_tm 2022");
+	// centuries count from 10000 B.C.
+	check(is_modern_date(t, 120, 22, 1, 13, 12, 40, 31), "cvt_from_tm 2022 is modern");
+
+	ts = make_tm(1, 12, 31, 23, 59, 59);
+	t.t = 0;
+	check(EternalTimestamp::cvt_from_tm(t, ts) == 0, "cvt_from_tm 1 A.D.");
+	check(is_modern_date(t, 100, 1, 12, 31, 23, 59, 59), "cvt_from_tm 1 A.D. is modern");
+
+	ts = make_tm(-500, 3, 15, 0, 0, 0);
+	t.t = 0;
+	check(EternalTimestamp::cvt_from_tm(t, ts) == 0, "cvt_from_tm 500 B.C.");
+	check(is_modern_date(t, 95, 0, 3, 15, 0, 0, 0), "cvt_from_tm 500 B.C. is modern");
+
+	// before the modern epoch: the prehistoric subformat counts the years back from 0 A.D.
+	ts = make_tm(-50000, 6, 1, 10, 30, 0);
+	t.t = 0;
+	check(EternalTimestamp::cvt_from_tm(t, ts) == 0, "cvt_from_tm 50000 B.C.");
+	check(ets_format_sign(t) == 0 && ets_format_mode(t) == 1, "cvt_from_tm 50000 B.C. is prehistoric");
+	check(ets_prehistoric_years(t) == 50000 && ets_prehistoric_precision(t) == 0, "cvt_from_tm 50000 B.C. years");
+	check(ets_prehistoric_month(t) == OFS - 1 + 6 && ets_prehistoric_day(t) == OFS - 1 + 1, "cvt_from_tm 50000 B.C. date");
+	check(ets_prehistoric_hour(t) == OFS + 10 && ets_prehistoric_minute(t) == OFS + 30, "cvt_from_tm 50000 B.C. time");
+}
+
+static void test_from_time_t()
+{
+	eternal_timestamp_t t;
+
+	t.t = 0;
+	check(EternalTimestamp::cvt_from_time_t(t, 1642077631) == 0, "cvt_from_time_t 2022");
+	check(is_modern_date(t, 120, 22, 1, 13, 12, 40, 31), "cvt_from_time_t 2022 is modern");
+
+	t.t = 0;
+	check(EternalTimestamp::cvt_from_time_t(t, 0) == 0, "cvt_from_time_t epoch");
+	check(is_modern_date(t, 119, 70, 1, 1, 0, 0, 0), "cvt_from_time_t epoch is 1970-01-01");
+
+	t.t = 0;
+	check(EternalTimestamp::cvt_from_time_t(t, -1) == 0, "cvt_from_time_t -1");
+	check(is_modern_date(t, 119, 69, 12, 31, 23, 59, 59), "cvt_from_time_t -1 is 1969-12-31T23:59:59");
+
+	// 2000-02-29: leap day of a century leap year
+	t.t = 0;
+	check(EternalTimestamp::cvt_from_time_t(t, 951782400) == 0, "cvt_from_time_t 2000-02-29");
+	check(is_modern_date(t, 120, 0, 2, 29, 0, 0, 0), "cvt_from_time_t 2000-02-29 date");
+
+	// the same instant through both entry points gives the same bits
+	for (time_t s = -2208988800; s < 4102444800; s += 86399 * 37) {
+		eternal_timestamp_t a, b;
+		a.t = 0;
+		b.t = 0;
+		struct tm ts;
+#if defined(_WIN32) || defined(_WIN64)
+		gmtime_s(&ts, &s);
+#else
+		gmtime_r(&s, &ts);
+#endif
+		EternalTimestamp::cvt_from_time_t(a, s);
+		EternalTimestamp::cvt_from_tm(b, ts);
+		if (a.t != b.t) {
+			check(false, "cvt_from_time_t agrees with gmtime + cvt_from_tm");
+			break;
+		}
+	}
+}
+
+// cvt_to_timeinfo_struct() produces the natural field values, which cvt_from_timeinfo_struct() takes back to the
+// same timestamp.
+static void test_timeinfo_round_trip()
+{
+	eternal_timestamp_t t;
+	struct eternal_time_tm ts;
+
+	check(EternalTimestamp::cvt_from_iso8601(t, "2022-01-13T12:40:31.049352", 26) == 0, "parse 2022-01-13T12:40:31.049352");
+	check(EternalTimestamp::cvt_to_timeinfo_struct(ts, t) == 0, "cvt_to_timeinfo_struct 2022");
+	check(ts.unspecified == 0 && ts.large_year == 2022 && ts.year == 2022 && ts.month == 1 && ts.day == 13, "cvt_to_timeinfo_struct 2022 date");
+	check(ts.hour == 12 && ts.minute == 40 && ts.seconds == 31 && ts.milliseconds == 49 && ts.microseconds == 352, "cvt_to_timeinfo_struct 2022 time");
+
+	const char *inputs[] = { "2022-01-13T12:40:31.049352", "1999-12-31T23:59:59.999999", "2000-02-29T00:00:00.000000", "0001-01-01T00:00:00.000001", "-0500-03-15T06:07:08", "1850-07", "2022" };
+	for (const char *input : inputs) {
+		eternal_timestamp_t back;
+		back.t = 0;
+		const bool ok = EternalTimestamp::cvt_from_iso8601(t, input, strlen(input)) == 0
+			&& EternalTimestamp::cvt_to_timeinfo_struct(ts, t) == 0
+			&& EternalTimestamp::cvt_from_timeinfo_struct(back, ts) == 0
+			&& back.t == t.t;
+		if (!ok) {
+			fprintf(stderr, "FAIL: timeinfo round trip of %s\n", input);
+			failures++;
+		}
+	}
+
+	// before the modern epoch
+	t.t = 0;
+	check(EternalTimestamp::cvt_from_tm(t, make_tm(-50000, 6, 1, 10, 30, 0)) == 0, "cvt_from_tm 50000 B.C.");
+	check(EternalTimestamp::cvt_to_timeinfo_struct(ts, t) == 0, "cvt_to_timeinfo_struct 50000 B.C.");
+	check(ts.large_year == -50000 && ts.month == 6 && ts.day == 1 && ts.hour == 10 && ts.minute == 30, "cvt_to_timeinfo_struct 50000 B.C. fields");
+	eternal_timestamp_t back;
+	back.t = 0;
+	check(EternalTimestamp::cvt_from_timeinfo_struct(back, ts) == 0 && back.t == t.t, "timeinfo round trip of 50000 B.C.");
+}
+
+#if defined(BUILD_MONOLITHIC)
+#define main(cnt, arr)      eternalty_test_tm_main(cnt, arr)
+#endif
+
+int main(int argc, const char **argv)
+{
+	(void)argc;
+	(void)argv;
+
+	fprintf(stderr, "Eternal Timestamp Test (struct tm / time_t conversions)\n\n");
+
+	test_from_tm();
+	test_from_time_t();
+	test_timeinfo_round_trip();
+
+	if (failures) {
+		fprintf(stderr, "\n%d test(s) FAILED\n", failures);
+		return EXIT_FAILURE;
+	}
+	fprintf(stderr, "All tests passed\n");
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,342 @@
+
+#include <eternal_timestamp/eternal_timestamp.h>
+#include <eternal_timestamp/eternal_timestamp_batch.h>
+#include <eternal_timestamp/eternal_timestamp_format.h>
+#include <eternal_timestamp/eternal_timestamp_tz.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <time.h>
+#endif
+
+#include "monolithic_examples.h"
+
+
+using namespace eternal_timestamp;
+
+static int failures = 0;
+
+static eternal_timestamp_t iso(const char *str)
+{
+	eternal_timestamp_t t{0};
+	if (EternalTimestamp::cvt_from_iso8601(t, str, strlen(str))) {
+		fprintf(stderr, "FAIL: cannot parse test input '%s'\n", str);
+		failures++;
+	}
+	return t;
+}
+
+static std::string text(const eternal_timestamp_t t)
+{
+	static ets_format_pattern_t fmt;
+	static const int compiled = EternalTimestampFormat::compile(fmt, ETS_FORMAT_ISO8601, nullptr);
+	(void)compiled;
+	char buf[64];
+	EternalTimestampFormat::format(buf, sizeof(buf), fmt, t);
+	return buf;
+}
+
+// `expected` NULL: the conversion should fail
+static void check_local_to_utc(const ets_tz_zone_t *zone, const char *local, ets_tz_disambiguation how, const char *expected)
+{
+	const eternal_timestamp_t src = iso(local);
+	eternal_timestamp_t dst;
+	uint8_t validity = 0;
+	const size_t n = EternalTimestampZone::cvt_local_to_utc(&dst, &validity, &src, 1, zone, how);
+	const bool ok = (expected ? n == 0 && validity == 1 && text(dst) == expected : n == 1 && validity == 0 && dst.t == src.t);
+	if (!ok) {
+		fprintf(stderr, "FAIL: local %s (disambiguation %d) to UTC: expected %s, got %s (%s)\n", local, how, expected ? expected : "failure", text(dst).c_str(), n ? "failed" : "ok");
+		failures++;
+	}
+}
+
+static void check_utc_to_local(const ets_tz_zone_t *zone, const char *utc, const char *expected)
+{
+	const eternal_timestamp_t src = iso(utc);
+	eternal_timestamp_t dst;
+	uint8_t validity = 0;
+	const size_t n = EternalTimestampZone::cvt_utc_to_local(&dst, &validity, &src, 1, zone);
+	if (n != 0 || validity != 1 || text(dst) != expected) {
+		fprintf(stderr, "FAIL: UTC %s to local: expected %s, got %s\n", utc, expected, text(dst).c_str());
+		failures++;
+	}
+}
+
+static void check_offset(const ets_tz_zone_t *zone, const char *utc, int32_t expected)
+{
+	eternal_timestamp_t t = iso(utc);
+	int64_t seconds = 0;
+	EternalTimestampBatch::cvt_to_unix_seconds(&seconds, nullptr, &t, 1);
+	const int32_t offset = EternalTimestampZone::utc_offset(zone, seconds);
+	if (offset != expected) {
+		fprintf(stderr, "FAIL: UTC offset at %s: expected %d, got %d\n", utc, expected, offset);
+		failures++;
+	}
+}
+
+// A minimal TZif version 2 image: the 64-bit block only (the 32-bit block is empty, as allowed by RFC 8536).
+static std::vector<unsigned char> make_tzif(const std::vector<int64_t> &transitions, const std::vector<unsigned char> &types, const std::vector<int32_t> &offsets, const char *footer)
+{
+	std::vector<unsigned char> v;
+	auto be32 = [&](uint32_t x) { for (int i = 24; i >= 0; i -= 8) v.push_back(static_cast<unsigned char>(x >> i)); };
+	auto be64 = [&](int64_t x) { be32(static_cast<uint32_t>(static_cast<uint64_t>(x) >> 32)); be32(static_cast<uint32_t>(x)); };
+	auto header = [&](uint32_t timecnt, uint32_t typecnt, uint32_t charcnt) {
+		v.insert(v.end(), { 'T', 'Z', 'i', 'f', '2' });
+		v.insert(v.end(), 15, 0);
+		be32(0); be32(0); be32(0);
+		be32(timecnt); be32(typecnt); be32(charcnt);
+	};
+
+	header(0, 1, 1);
+	v.insert(v.end(), 6, 0);
+	v.push_back(0);
+
+	header(static_cast<uint32_t>(transitions.size()), static_cast<uint32_t>(offsets.size()), 4);
+	for (int64_t t : transitions)
+		be64(t);
+	v.insert(v.end(), types.begin(), types.end());
+	for (int32_t offset : offsets) {
+		be32(static_cast<uint32_t>(offset));
+		v.push_back(offset != offsets[0]);
+		v.push_back(0);
+	}
+	v.insert(v.end(), { 'X', 'X', 'X', 0 });
+	v.push_back('\n');
+	v.insert(v.end(), footer, footer + strlen(footer));
+	v.push_back('\n');
+	return v;
+}
+
+#if !defined(_WIN32)
+
+// Compare against the C library for random moments between 1900 and 2100.
+static void check_against_libc(const char *name)
+{
+	const ets_tz_zone_t *zone;
+	if (EternalTimestampZone::load(zone, name))
+		return;
+	fprintf(stderr, "  ... comparing %s against localtime_r()\n", name);
+
+	setenv("TZ", name, 1);
+	tzset();
+
+	std::mt19937_64 rng(42);
+	std::uniform_int_distribution<int64_t> dist(-2208988800LL, 4102444800LL);
+	int mismatches = 0;
+	for (int i = 0; i < 20000 && mismatches < 10; i++) {
+		const int64_t u = dist(rng);
+		const time_t tt = static_cast<time_t>(u);
+		struct tm tm;
+		if (!localtime_r(&tt, &tm))
+			continue;
+		const int32_t offset = EternalTimestampZone::utc_offset(zone, u);
+		if (offset != tm.tm_gmtoff) {
+			fprintf(stderr, "FAIL: %s: UTC offset at %lld: expected %ld, got %d\n", name, static_cast<long long>(u), static_cast<long>(tm.tm_gmtoff), offset);
+			mismatches++;
+			continue;
+		}
+
+		// local -> UTC must land on the original moment for one of the disambiguations, and map back
+		eternal_timestamp_t utc;
+		EternalTimestampBatch::cvt_from_unix_seconds(&utc, nullptr, &u, 1);
+		eternal_timestamp_t local, earlier, later, back;
+		EternalTimestampZone::cvt_utc_to_local(&local, nullptr, &utc, 1, zone);
+		EternalTimestampZone::cvt_local_to_utc(&earlier, nullptr, &local, 1, zone, ETS_TZ_EARLIER);
+		EternalTimestampZone::cvt_local_to_utc(&later, nullptr, &local, 1, zone, ETS_TZ_LATER);
+		EternalTimestampZone::cvt_utc_to_local(&back, nullptr, &earlier, 1, zone);
+		if ((earlier.t != utc.t && later.t != utc.t) || back.t != local.t) {
+			fprintf(stderr, "FAIL: %s: round trip of %s via %s: %s / %s\n", name, text(utc).c_str(), text(local).c_str(), text(earlier).c_str(), text(later).c_str());
+			mismatches++;
+		}
+	}
+	failures += mismatches;
+
+	// sorted batches, as produced by log ingestion, must match the one-by-one conversions
+	{
+		const size_t count = 3 * 366 * 24 * 4;
+		std::vector<int64_t> seconds(count);
+		for (size_t i = 0; i < count; i++)
+			seconds[i] = 1577836800 + 900 * static_cast<int64_t>(i) + 7;
+		std::vector<eternal_timestamp_t> utc(count), local(count), batch(count);
+		EternalTimestampBatch::cvt_from_unix_seconds(utc.data(), nullptr, seconds.data(), count);
+		EternalTimestampZone::cvt_utc_to_local(local.data(), nullptr, utc.data(), count, zone);
+		EternalTimestampZone::cvt_local_to_utc(batch.data(), nullptr, local.data(), count, zone, ETS_TZ_LATER);
+		for (size_t i = 0; i < count; i++) {
+			eternal_timestamp_t single_local, single_utc;
+			EternalTimestampZone::cvt_utc_to_local(&single_local, nullptr, &utc[i], 1, zone);
+			EternalTimestampZone::cvt_local_to_utc(&single_utc, nullptr, &local[i], 1, zone, ETS_TZ_LATER);
+			if (single_local.t != local[i].t || single_utc.t != batch[i].t) {
+				fprintf(stderr, "FAIL: %s: batch conversion of %s differs: %s / %s\n", name, text(utc[i]).c_str(), text(local[i]).c_str(), text(batch[i]).c_str());
+				failures++;
+				break;
+			}
+		}
+	}
+
+	unsetenv("TZ");
+	tzset();
+}
+
+#endif
+
+
+#if defined(BUILD_MONOLITHIC)
+#define main(cnt, arr)      eternalty_test_tz_main(cnt, arr)
+#endif
+
+int main(int argc, const char **argv)
+{
+	fprintf(stderr, "Eternal Timestamp Test (time zones)\n\n");
+
+	// CET/CEST, with 2020's transitions listed and the rule in the footer for everything after
+	{
+		const auto image = make_tzif({ 1585443600, 1603587600 }, { 1, 0 }, { 3600, 7200 }, "CET-1CEST,M3.5.0,M10.5.0/3");
+		ets_tz_zone_t *zone = nullptr;
+		if (EternalTimestampZone::compile(zone, image.data(), image.size())) {
+			fprintf(stderr, "FAIL: cannot compile the test zone\n");
+			return EXIT_FAILURE;
+		}
+
+		check_offset(zone, "1900-07-01T00:00:00", 3600);
+		check_offset(zone, "2020-03-29T00:59:59", 3600);
+		check_offset(zone, "2020-03-29T01:00:00", 7200);
+		check_offset(zone, "2020-10-25T00:59:59", 7200);
+		check_offset(zone, "2020-10-25T01:00:00", 3600);
+		check_offset(zone, "2050-03-27T00:59:59", 3600);
+		check_offset(zone, "2050-03-27T01:00:00", 7200);
+		// beyond the compiled table
+		check_offset(zone, "2150-07-01T12:00:00", 7200);
+		check_offset(zone, "2150-12-01T12:00:00", 3600);
+		check_offset(zone, "2150-10-25T00:59:59", 7200);
+		check_offset(zone, "2150-10-25T01:00:00", 3600);
+
+		check_utc_to_local(zone, "2020-07-01T10:15:30.5", "2020-07-01T12:15:30.500");
+		check_utc_to_local(zone, "2020-12-31T23:30", "2021-01-01T00:30");
+		check_local_to_utc(zone, "2021-01-01T00:30", ETS_TZ_COMPATIBLE, "2020-12-31T23:30");
+		check_local_to_utc(zone, "2150-07-01T12:00", ETS_TZ_COMPATIBLE, "2150-07-01T10:00");
+
+		// unspecified fields stay unspecified; incomplete timestamps are not converted
+		check_local_to_utc(zone, "2020-07-01T12", ETS_TZ_COMPATIBLE, "2020-07-01T10");
+		check_local_to_utc(zone, "2020-07-01", ETS_TZ_COMPATIBLE, nullptr);
+		check_local_to_utc(zone, "2020", ETS_TZ_COMPATIBLE, nullptr);
+
+		// fields out of their range can't be placed on the time line: feb/31, month 14
+		{
+			const eternal_timestamp_t base = iso("2021-02-13T12:00");
+			eternal_timestamp_t bad[2] = { ets_modern_set_day(base, ets_modern_day(base) + 18), ets_modern_set_month(base, ets_modern_month(base) + 12) };
+			eternal_timestamp_t out[2];
+			uint8_t validity = 0xFF;
+			size_t n = EternalTimestampZone::cvt_local_to_utc(out, &validity, bad, 2, zone, ETS_TZ_COMPATIBLE);
+			bool ok = (n == 2 && (validity & 3) == 0 && out[0].t == bad[0].t && out[1].t == bad[1].t);
+			validity = 0xFF;
+			n = EternalTimestampZone::cvt_utc_to_local(out, &validity, bad, 2, zone);
+			ok = ok && n == 2 && (validity & 3) == 0 && out[0].t == bad[0].t && out[1].t == bad[1].t;
+			if (!ok) {
+				fprintf(stderr, "FAIL: out of range fields were converted\n");
+				failures++;
+			}
+		}
+
+		// 02:00-03:00 is skipped on 2020/mar/29
+		check_local_to_utc(zone, "2020-03-29T01:59:59", ETS_TZ_COMPATIBLE, "2020-03-29T00:59:59");
+		check_local_to_utc(zone, "2020-03-29T02:30", ETS_TZ_COMPATIBLE, "2020-03-29T01:30");
+		check_local_to_utc(zone, "2020-03-29T02:30", ETS_TZ_LATER, "2020-03-29T01:30");
+		check_local_to_utc(zone, "2020-03-29T02:30", ETS_TZ_EARLIER, "2020-03-29T00:30");
+		check_local_to_utc(zone, "2020-03-29T02:30", ETS_TZ_REJECT, nullptr);
+		check_local_to_utc(zone, "2020-03-29T03:00", ETS_TZ_REJECT, "2020-03-29T01:00");
+
+		// 02:00-03:00 occurs twice on 2020/oct/25
+		check_local_to_utc(zone, "2020-10-25T02:30", ETS_TZ_COMPATIBLE, "2020-10-25T00:30");
+		check_local_to_utc(zone, "2020-10-25T02:30", ETS_TZ_EARLIER, "2020-10-25T00:30");
+		check_local_to_utc(zone, "2020-10-25T02:30", ETS_TZ_LATER, "2020-10-25T01:30");
+		check_local_to_utc(zone, "2020-10-25T02:30", ETS_TZ_REJECT, nullptr);
+		check_local_to_utc(zone, "2020-10-25T03:00", ETS_TZ_REJECT, "2020-10-25T02:00");
+		check_local_to_utc(zone, "2150-10-25T02:30", ETS_TZ_LATER, "2150-10-25T01:30");
+		check_local_to_utc(zone, "2150-03-29T02:30", ETS_TZ_REJECT, nullptr);
+
+		// in place, sorted input: the cached regime must not leak into the transition
+		{
+			eternal_timestamp_t batch[4] = { iso("2020-10-25T01:30"), iso("2020-10-25T02:30"), iso("2020-10-25T03:30"), iso("2020-10") };
+			uint8_t validity = 0;
+			const size_t n = EternalTimestampZone::cvt_local_to_utc(batch, &validity, batch, 4, zone, ETS_TZ_LATER);
+			if (n != 1 || validity != 0x07 || text(batch[0]) != "2020-10-24T23:30" || text(batch[1]) != "2020-10-25T01:30" || text(batch[2]) != "2020-10-25T02:30" || text(batch[3]) != "2020-10") {
+				fprintf(stderr, "FAIL: batch conversion: %s %s %s %s\n", text(batch[0]).c_str(), text(batch[1]).c_str(), text(batch[2]).c_str(), text(batch[3]).c_str());
+				failures++;
+			}
+		}
+
+		EternalTimestampZone::release(zone);
+	}
+
+	// a zone without transitions, and an offset which is not a whole number of hours
+	{
+		const auto image = make_tzif({}, {}, { 20700 }, "<+0545>-5:45");
+		ets_tz_zone_t *zone = nullptr;
+		if (EternalTimestampZone::compile(zone, image.data(), image.size())) {
+			fprintf(stderr, "FAIL: cannot compile the fixed offset zone\n");
+			failures++;
+		}
+		else {
+			check_offset(zone, "2022-01-13T12:00", 20700);
+			check_utc_to_local(zone, "2022-01-13T12:00:00", "2022-01-13T17:45:00");
+			EternalTimestampZone::release(zone);
+		}
+
+		const auto bad_rule = make_tzif({}, {}, { 3600 }, "CET-1CEST,M3.5.8,M10.5.0/3");
+		const auto bad_type = make_tzif({ 0 }, { 1 }, { 3600 }, "");
+		for (const auto *bad : { &bad_rule, &bad_type }) {
+			if (EternalTimestampZone::compile(zone, bad->data(), bad->size()) != EINVAL) {
+				fprintf(stderr, "FAIL: an invalid TZif image was accepted\n");
+				failures++;
+			}
+		}
+		if (EternalTimestampZone::compile(zone, "TZif", 4) != EINVAL) {
+			fprintf(stderr, "FAIL: a truncated TZif image was accepted\n");
+			failures++;
+		}
+	}
+
+	// the system's zoneinfo database, when there is one
+	{
+		const ets_tz_zone_t *zone = nullptr;
+		const ets_tz_zone_t *again = nullptr;
+		if (EternalTimestampZone::load(zone, "../etc/passwd") != EINVAL) {
+			fprintf(stderr, "FAIL: zone names may not leave the zoneinfo directory\n");
+			failures++;
+		}
+		if (!EternalTimestampZone::load(zone, "Europe/Amsterdam")) {
+			if (EternalTimestampZone::load(again, "Europe/Amsterdam") || again != zone) {
+				fprintf(stderr, "FAIL: loaded zones should be shared\n");
+				failures++;
+			}
+			check_utc_to_local(zone, "2022-01-13T12:40:31", "2022-01-13T13:40:31");
+			check_utc_to_local(zone, "2022-07-01T12:00", "2022-07-01T14:00");
+			check_local_to_utc(zone, "2022-07-01T12:00", ETS_TZ_COMPATIBLE, "2022-07-01T10:00");
+		}
+		if (!EternalTimestampZone::load(zone, "America/New_York")) {
+			check_local_to_utc(zone, "2022-03-13T02:30", ETS_TZ_COMPATIBLE, "2022-03-13T07:30");
+			check_local_to_utc(zone, "2022-11-06T01:30", ETS_TZ_COMPATIBLE, "2022-11-06T05:30");
+			check_local_to_utc(zone, "2022-11-06T01:30", ETS_TZ_LATER, "2022-11-06T06:30");
+		}
+
+#if !defined(_WIN32)
+		check_against_libc("Europe/Amsterdam");
+		check_against_libc("America/New_York");
+		check_against_libc("Australia/Sydney");
+		check_against_libc("Asia/Kolkata");
+#endif
+	}
+
+	if (failures) {
+		fprintf(stderr, "\n%d test(s) FAILED\n", failures);
+		return EXIT_FAILURE;
+	}
+	fprintf(stderr, "All tests passed\n");
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,204 @@
+#include <eternal_timestamp/eternal_timestamp.h>
+#include <eternal_timestamp/eternal_timestamp_value.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <random>
+#include <set>
+#include <type_traits>
+#include <unordered_set>
+#include <vector>
+
+#include "monolithic_examples.h"
+
+
+using namespace eternal_timestamp;
+
+static_assert(std::is_trivially_copyable<EternalTimestampValue>::value, "a value type");
+static_assert(sizeof(EternalTimestampValue) == sizeof(uint64_t), "nothing but the timestamp");
+static_assert(EternalTimestampValue().value().t == EternalTimestamp::unknown().t, "default constructed is unknown");
+static_assert(std::is_same<eternal_clock::duration::period, std::micro>::value && !eternal_clock::is_steady, "Clock requirements");
+static_assert(std::is_same<eternal_clock::time_point::clock, eternal_clock>::value, "Clock requirements");
+#if defined(__cpp_lib_chrono) && __cpp_lib_chrono >= 201907L
+static_assert(std::chrono::is_clock_v<eternal_clock>, "Clock requirements");
+#endif
+
+static int failures = 0;
+
+static void check(bool ok, const char *what)
+{
+	if (!ok) {
+		fprintf(stderr, "FAIL: %s\n", what);
+		failures++;
+	}
+}
+
+static EternalTimestampValue parse(const char *iso8601)
+{
+	eternal_timestamp_t t;
+	t.t = 0;
+	EternalTimestamp::cvt_from_iso8601(t, iso8601, strlen(iso8601));
+	return t;
+}
+
+// Any timestamp in the library's format, with a fair share of prehistoric ones.
+static EternalTimestampValue random_timestamp(std::mt19937_64 &rng)
+{
+	eternal_timestamp_t t;
+	t.t = rng() & ~1ULL;
+	if (t.t & 2)
+		t.t &= ~(0xFULL << ETPHT_PRECISION_SHIFT);
+	return t;
+}
+
+static void test_getters()
+{
+	EternalTimestampValue t = parse("2020-09-13T12:30:15.250001");
+	check(t.is_modern_format() && t.year() == 2020 && t.month() == 9 && t.day() == 13, "date getters");
+	check(t.hour() == 12 && t.minute() == 30 && t.second() == 15, "time getters");
+	check(t.millisecond() == 250 && t.microsecond() == 1 && t.precision() == 0, "sub-second getters");
+
+	t = parse("2016-12-31T23:59:60");
+	check(t.second() == 60 && t.millisecond() == -1 && t.microsecond() == -1, "leap second, no sub-seconds");
+
+	t = parse("-0044-03");
+	check(t.year() == -44 && t.month() == 3 && t.day() == -1 && t.hour() == -1, "partial timestamp");
+
+	t = parse("-12000-01-02T06:30");
+	check(t.is_prehistoric_format() && t.year() == -12000 && t.month() == 1 && t.day() == 2, "prehistoric date getters");
+	check(t.hour() == 6 && t.minute() == 30 && t.second() == -1 && t.microsecond() == -1, "prehistoric time getters");
+
+	t = EternalTimestampValue();
+	check(t.year() == EternalTimestampValue::unspecified_year && t.month() == -1 && t.minute() == -1, "unknown");
+}
+
+// The operators order as the library's sort keys do.
+static void test_ordering()
+{
+	std::mt19937_64 rng(44);
+	for (int i = 0; i < 100000; i++) {
+		const EternalTimestampValue a = random_timestamp(rng);
+		const EternalTimestampValue b = (i % 4 ? random_timestamp(rng) : a);
+		const int64_t ka = EternalTimestamp::calc_sort_key(a.value());
+		const int64_t kb = EternalTimestamp::calc_sort_key(b.value());
+		check(a.sort_key() == ka, "sort_key()");
+		if (ka != kb)
+			check((a < b) == (ka < kb) && (a > b) == (ka > kb), "operator< / operator>");
+		check((a == b) == (a.value().t == b.value().t) && (a != b) == !(a == b), "operator== / operator!=");
+		check((a <= b) == !(b < a) && (a >= b) == !(a < b), "operator<= / operator>=");
+		check(!(a < b && b < a) && (a < b || b < a || a == b), "a strict total order");
+		const int c = EternalTimestampValue::compare(a, b);
+		check((c < 0) == (a < b) && (c == 0) == (a == b), "compare()");
+#if defined(ETS_HAVE_THREE_WAY_COMPARISON)
+		check(((a <=> b) < 0) == (a < b) && ((a <=> b) == 0) == (a == b), "operator<=>");
+#endif
+	}
+
+	// the same moment in both subformats: equivalent by time, yet distinct values.
+	const EternalTimestampValue modern = parse("-5000-06-01");
+	eternal_timestamp_t p{0};
+	p = ets_format_set_mode(p, 1);
+	p = ets_prehistoric_set_years(p, 5000);
+	p = ets_prehistoric_set_month(p, ets_modern_month(modern.value()));
+	p = ets_prehistoric_set_day(p, ets_modern_day(modern.value()));
+	p = ets_prehistoric_set_hour(p, ets_modern_hour(modern.value()));
+	p = ets_prehistoric_set_minute(p, ets_modern_minute(modern.value()));
+	const EternalTimestampValue prehistoric = p;
+	check(modern.sort_key() == prehistoric.sort_key(), "non-normalized prehistoric timestamp");
+	check(modern != prehistoric && (modern < prehistoric) != (prehistoric < modern), "ordered by their bits");
+}
+
+// Used as is with the standard containers and algorithms.
+static void test_containers()
+{
+	std::mt19937_64 rng(4444);
+	std::vector<EternalTimestampValue> v;
+	for (int i = 0; i < 10000; i++)
+		v.push_back(random_timestamp(rng));
+	for (int i = 0; i < 1000; i++)
+		v.push_back(v[i * 7]);
+
+	std::sort(v.begin(), v.end());
+	bool sorted = true;
+	for (size_t i = 1; i < v.size(); i++)
+		sorted = sorted && v[i - 1].sort_key() <= v[i].sort_key();
+	check(sorted, "std::sort");
+
+	const std::set<EternalTimestampValue> set(v.begin(), v.end());
+	const std::unordered_set<EternalTimestampValue> hashed(v.begin(), v.end());
+	check(set.size() == 10000 && hashed.size() == set.size(), "std::set / std::unordered_set deduplicate");
+	v.erase(std::unique(v.begin(), v.end()), v.end());
+	check(v.size() == set.size() && std::equal(set.begin(), set.end(), v.begin()), "std::set order");
+
+	std::map<EternalTimestampValue, int> map;
+	map[parse("2021")] = 1;
+	map[parse("-20000")] = 2;
+	map[parse("2020-12-31T23:59:59.999999")] = 3;
+	map[parse("-0001-12-31")] = 4;
+	std::vector<int> order;
+	for (const auto &kv : map)
+		order.push_back(kv.second);
+	check(order == std::vector<int>({2, 4, 3, 1}), "std::map order");
+}
+
+static void test_clock()
+{
+	const auto before = std::chrono::system_clock::now();
+	const eternal_clock::time_point now = eternal_clock::now();
+	const auto after = std::chrono::system_clock::now();
+	check(eternal_clock::to_sys(now) >= std::chrono::time_point_cast<eternal_clock::duration>(before), "now() vs system_clock");
+	check(eternal_clock::to_sys(now) <= std::chrono::time_point_cast<eternal_clock::duration>(after) + std::chrono::microseconds(1), "now() vs system_clock");
+	check(eternal_clock::from_sys(eternal_clock::to_sys(now)) == now, "to_sys() / from_sys()");
+#if defined(__cpp_lib_chrono) && __cpp_lib_chrono >= 201907L
+	check(std::chrono::clock_cast<eternal_clock>(std::chrono::clock_cast<std::chrono::system_clock>(now)) == now, "clock_cast");
+#endif
+
+	// round trips across the modern range.
+	std::mt19937_64 rng(444);
+	const int64_t span = 11000LL * 365 * 86400 * 1000000;   // 9000 BC .. 12900 AD
+	for (int i = 0; i < 10000; i++) {
+		const eternal_clock::time_point tp{eternal_clock::duration(static_cast<int64_t>(rng() % (2 * span)) - span)};
+		const EternalTimestampValue t = eternal_clock::to_timestamp(tp);
+		eternal_clock::time_point back;
+		check(eternal_clock::from_timestamp(back, t) == 0 && back == tp, "to_timestamp() / from_timestamp()");
+	}
+
+	EternalTimestampValue t = eternal_clock::to_timestamp(eternal_clock::time_point());
+	check(t == parse("1970-01-01T00:00:00.000000"), "the epoch");
+	t = eternal_clock::to_timestamp(eternal_clock::time_point() + std::chrono::hours(24 * 366) + std::chrono::milliseconds(1500));
+	check(t == parse("1971-01-02T00:00:01.500000"), "durations");
+
+	eternal_clock::time_point back;
+	check(eternal_clock::from_timestamp(back, parse("2020-09")) == 0 && eternal_clock::to_timestamp(back) == parse("2020-09-01T00:00:00.000000"), "partial timestamp");
+	check(eternal_clock::from_timestamp(back, parse("-20000")) == -1 && back == eternal_clock::time_point(), "prehistoric timestamp");
+	check(eternal_clock::from_timestamp(back, EternalTimestampValue()) == -1, "unknown");
+	check(eternal_clock::to_timestamp(eternal_clock::time_point::max()) == EternalTimestampValue(), "beyond the modern range");
+	check(eternal_clock::to_timestamp(eternal_clock::time_point::min()) == EternalTimestampValue(), "before the modern range");
+}
+
+
+#if defined(BUILD_MONOLITHIC)
+#define main(cnt, arr)      eternalty_test_value_main(cnt, arr)
+#endif
+
+int main(int argc, const char **argv)
+{
+	(void)argc;
+	(void)argv;
+
+	fprintf(stderr, "Eternal Timestamp Test (value type & clock)\n\n");
+
+	test_getters();
+	test_ordering();
+	test_containers();
+	test_clock();
+
+	if (failures) {
+		fprintf(stderr, "\n%d test(s) FAILED\n", failures);
+		return EXIT_FAILURE;
+	}
+	fprintf(stderr, "All tests passed\n");
+	return EXIT_SUCCESS;
+}